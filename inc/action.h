@@ -0,0 +1,80 @@
+/**
+ * @file       action.h
+ * @brief      Module for the table that maps IR codes to actions.
+ *
+ * @details    Every entry holds protocol, address and command of an IR code
+ *             and the ACTION_xxx bits carried out when the code is received.
+ *             Every entry is stored as a record (see store.h) like an
+ *             IRMP_DATA with the actions in place of the flags, followed by
+ *             the HID usage for ACTION_KEY and ACTION_CONSUMER (see
+ *             keyboard.h). A hash index in RAM, rebuilt
+ *             whenever the table changes, makes \c ACTION_Lookup() take the
+ *             same time for any number of entries.
+ *
+ * @par        Legacy codes
+ *             The power on, power off and reset codes of hidirt_data_t and
+ *             their reports are a view of the table: the first entry with
+ *             the action. Setting such a code moves the action to the entry
+ *             of the code. Codes stored by older firmware are moved into the
+ *             table once.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef ACTION_H
+#define ACTION_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+#include "irmp.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported define -----------------------------------------------------------*/
+/**
+ * @brief      Number of entries, stored as records (see store.h).
+ */
+#define ACTION_ENTRIES           64
+
+/**
+ * @brief      Size of the record of an entry: code and actions, HID usage.
+ */
+#define ACTION_ENTRY_SIZE        (sizeof(IRMP_DATA) + sizeof(uint16_t))
+
+/**
+ * @brief      Length of \c REP_ID_ACTION_ENTRY: index, protocol, address,
+ *             command, actions and usage (multi-byte values little endian).
+ */
+#define ACTION_REPORT_SIZE       9
+
+/* Index of REP_ID_ACTION_ENTRY that puts a code into the entry holding it
+   already or into the first free one */
+#define ACTION_INDEX_ANY         0xFF
+
+/* Protocol of REP_ID_ACTION_ENTRY that only selects the entry read back */
+#define ACTION_SELECT            0xFF
+
+/* Actions of an entry, 0 frees it */
+#define ACTION_POWER_ON          0x01  /* power button, if the PC is off */
+#define ACTION_POWER_OFF         0x02  /* power button, if the PC is on */
+#define ACTION_RESET             0x04  /* reset button, third press in a row */
+#define ACTION_WAKEUP            0x08  /* USB remote wakeup */
+#define ACTION_FORWARD           0x10  /* send via IRSND, like forward_ir_enable */
+#define ACTION_SUPPRESS          0x20  /* no IR code report to the host */
+#define ACTION_KEY               0x40  /* keyboard usage: modifiers << 8 | key */
+#define ACTION_CONSUMER          0x80  /* consumer control usage, not with
+                                          ACTION_KEY */
+#define ACTION_ALL               0xFF
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+void ACTION_Init(void);
+uint8_t ACTION_Lookup(const IRMP_DATA *irmp_data, uint16_t *usage);
+bool ACTION_Assign(const IRMP_DATA *irmp_data, uint8_t action_bit);
+void ACTION_GetCode(uint8_t action_bit, IRMP_DATA *irmp_data);
+void ACTION_SetEntry(const uint8_t *report);
+void ACTION_GetEntry(uint8_t *report);
+bool ACTION_Process(void);
+bool ACTION_Commit(void);
+
+#endif /* ACTION_H */
@@ -10,6 +10,9 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdbool.h>
 #include "irmp.h"
+#include "learn.h"
+#include "action.h"
+#include "repeat.h"
 
 /* Exported macro ------------------------------------------------------------*/
 #define BACKUP_REG_BOOTLOADER       RTC_BKP_DR1
@@ -17,16 +20,54 @@
 #define BACKUP_REG_SECOND           RTC_BKP_DR3
 #define BACKUP_REG_ALARM            RTC_BKP_DR4
 
+/* Events that let the main loop leave sleep mode, see SetEvent() */
+#define EVENT_IR_RECEIVED           0x01  /* IRMP has data for irmp_get_data() */
+#define EVENT_IRSND_QUEUED          0x02  /* IR code was written to irsnd_fifo */
+#define EVENT_IRSND_DONE            0x04  /* IRSND has finished sending */
+#define EVENT_RTC_WAKEUP            0x08  /* RTC wakeup, debounce and alarms */
+#define EVENT_CONFIG_UPDATE         0x10  /* configuration received via USB */
+#define EVENT_EEPROM_PENDING        0x20  /* write-back cache holds data */
+#define EVENT_CAPTURE               0x40  /* capture data or host request */
+#define EVENT_LEARN                 0x80  /* unknown IR frame or host request */
+#define EVENT_ACTION                0x100 /* action table entry received via USB */
+#define EVENT_REPEAT                0x200 /* key-up timeout of a held IR key */
+
+/* Configuration updates received via USB, see data_update_pending. They are
+   applied in ascending bit order, so the bootloader request comes last. */
+#define UPDATE_CONTROL_PC_ENABLE    0x0001
+#define UPDATE_FORWARD_IR_ENABLE    0x0002
+#define UPDATE_POWER_ON_IR_CODE     0x0004
+#define UPDATE_POWER_OFF_IR_CODE    0x0008
+#define UPDATE_RESET_IR_CODE        0x0010
+#define UPDATE_MINIMUM_REPEATS      0x0020
+#define UPDATE_CLOCK_CORRECTION     0x0040
+#define UPDATE_WAKEUP_TIME          0x0080
+#define UPDATE_WAKEUP_TIME_SPAN     0x0100
+#define UPDATE_PROTOCOL_MASK        0x0200
+#define UPDATE_WATCHDOG_ENABLE      0x0400
+#define UPDATE_WATCHDOG_RESET       0x0800
+#define UPDATE_POLLING_INTERVAL     0x1000
+#define UPDATE_REPEAT_SHAPING       0x2000
+#define UPDATE_REQUEST_BOOTLOADER   0x8000
+
 #if defined(STM32L151xB)
 #define DATA_EEPROM_START_ADDR      0x08080000
-#define DATA_EEPROM_END_ADDR        0x080803FF
+#define DATA_EEPROM_END_ADDR        0x08080FFF
 #define DATA_EEPROM_PAGE_SIZE       0x8
 #endif
 
+/* bytes stored per EEPROM address, the emulated EEPROM of the STM32F1xx
+   stores 16 bit variables */
+#if defined(STM32F103xB)
+#define EEPROM_ADDRESS_SIZE         2
+#else
+#define EEPROM_ADDRESS_SIZE         1
+#endif
+
 enum ADDRESSES
 {
-   ADDRESS_irmp_power_on      = 0,
-   ADDRESS_irmp_power_off     = 6,
+   ADDRESS_irmp_power_on      = 0,  /* codes of older firmware, moved into */
+   ADDRESS_irmp_power_off     = 6,  /* the action table by ACTION_Init() */
    ADDRESS_irmp_reset         = 12,
    ADDRESS_clock_correction   = 18,
    ADDRESS_wakeup_time        = 22,
@@ -34,20 +75,35 @@ enum ADDRESSES
    ADDRESS_min_ir_repeats     = 27,
    ADDRESS_control_pc_enable  = 28,
    ADDRESS_forward_ir_enable  = 29,
-   ADDRESS_LENGTH /* Used to adjust NUMBER_OF_VARIABLES in eeprom.h when
-                     adding variables/addresses and using STM32F1xx. Be
-                     careful to consider the length of the last element. */
+   ADDRESS_protocol_mask      = 30,
+   ADDRESS_polling_interval   = 38,
+   ADDRESS_repeat_shaping     = 39,
+   ADDRESS_records            = ADDRESS_repeat_shaping +
+                                REPEAT_REPORT_SIZE / EEPROM_ADDRESS_SIZE,
+                                /* Records of store.h from here on, they
+                                   are no variables of the emulated EEPROM.
+                                   Used as NUMBER_OF_VARIABLES in eeprom.h
+                                   when using STM32F1xx. Be careful to
+                                   consider the length of the last element. */
+   ADDRESS_learn_templates    = ADDRESS_records,
+   ADDRESS_action_table       = ADDRESS_learn_templates +
+                                LEARN_SLOTS * LEARN_TEMPLATE_SIZE / EEPROM_ADDRESS_SIZE,
+   ADDRESS_LENGTH             = ADDRESS_action_table +
+                                ACTION_ENTRIES * ACTION_ENTRY_SIZE / EEPROM_ADDRESS_SIZE
 };
 
 /* Exported types ------------------------------------------------------------*/
 typedef struct HIDIRT_DATA
 {
    int32_t     clock_correction;
-   uint8_t     data_update_pending;
+   uint64_t    protocol_mask;       /* bit n enables IRMP protocol n, 0 enables all */
+   uint16_t    data_update_pending; /* UPDATE_xxx bits */
    uint8_t     min_ir_repeats;
    uint8_t     wakeup_time_span;
-   IRMP_DATA   irmp_power_on;
-   IRMP_DATA   irmp_power_off;
+   uint8_t     polling_interval;    /* USB bInterval in ms, 0 selects the build default */
+   repeat_config_t repeat;          /* typematic delay, rate and key-up */
+   IRMP_DATA   irmp_power_on;       /* first codes of these actions in the */
+   IRMP_DATA   irmp_power_off;      /* action table */
    IRMP_DATA   irmp_reset;
    bool        control_pc_enable;
    bool        forward_ir_enable;
@@ -55,6 +111,12 @@ typedef struct HIDIRT_DATA
    bool        watchdog_reset;
 } hidirt_data_t;
 
+typedef struct CPU_LOAD
+{
+   uint32_t    idle_cycles;   /* cycles spent sleeping in the last interval */
+   uint32_t    total_cycles;  /* length of the last interval (RTC wakeup) */
+} cpu_load_t;
+
 typedef struct FLAGS
 {
    uint8_t     alarm_a_occurred:1;
@@ -62,11 +124,18 @@ typedef struct FLAGS
    uint8_t     press_power_button:1;
    uint8_t     press_reset_button:1;
    uint8_t     wakeup_occurred:1;
+   uint8_t     remote_wakeup:1;
 } flags_t;
 
 /* Exported functions --------------------------------------------------------*/
+HAL_StatusTypeDef EEPROM_ReadBytes(uint32_t address, void *data, uint8_t length);
 HAL_StatusTypeDef EEPROM_WriteBytes(uint32_t address, void *data, uint8_t length);
+HAL_StatusTypeDef EEPROM_WriteBytesDeferred(uint32_t address, void *data, uint8_t length);
+bool EEPROM_CommitNext(void);
+bool EEPROM_CommitAll(void);
 extern void GetHidirtConfig(hidirt_data_t* config);
+extern void GetCpuLoad(cpu_load_t* load);
+extern void SetEvent(uint32_t event);
 extern void hidirt_init(void);
 extern void hidirt(void);
 
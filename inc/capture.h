@@ -0,0 +1,61 @@
+/**
+ * @file       capture.h
+ * @brief      Module for streaming the raw IR input to the host.
+ *
+ * @details    While capturing, the IR interrupt passes every pulse and pause
+ *             of the input with \c CAPTURE_Put(). Runs are stored as varints
+ *             in a ring and the main loop packs them into
+ *             \c REP_ID_CAPTURE_DATA reports with \c CAPTURE_Process(). This
+ *             replaces the UART based \c IRMP_LOGGING for unknown remotes.
+ *
+ * @par        Stream format
+ @verbatim
+
+  report:  sequence (1 byte), length (1 byte), length bytes of runs
+  run:     varint of (ticks << 1 | level), 7 bits per byte, LSB first,
+           bit 7 set if another byte follows, level 0 is a pulse
+  0x00:    runs have been lost before the next run (ring overrun)
+
+ @endverbatim
+ *             Ticks are IRMP ticks (F_INTERRUPTS). A pause of
+ *             \c CAPTURE_IDLE_TICKS ends a burst, it is sent right away and
+ *             longer pauses are not reported.
+ *
+ * @par        Flow control
+ *             The host grants a number of reports with
+ *             \c REP_ID_CAPTURE_CONTROL, nothing is sent without credits and
+ *             never more than the host can buffer. Capture data only uses
+ *             the IN queue while at least \c CAPTURE_IN_RESERVE slots stay
+ *             free for IR codes. Runs that find the ring full are dropped
+ *             and leave a 0x00 in the stream.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported define -----------------------------------------------------------*/
+/**
+ * @brief      Length of \c REP_ID_CAPTURE_DATA without the report ID.
+ */
+#define CAPTURE_REPORT_SIZE      31
+
+/**
+ * @brief      Length of \c REP_ID_CAPTURE_CONTROL: enable and credits.
+ */
+#define CAPTURE_CONTROL_SIZE     2
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+void CAPTURE_Control(bool enable, uint8_t credits);
+void CAPTURE_GetControl(uint8_t *control);
+void CAPTURE_Put(uint8_t input, uint16_t ticks);
+void CAPTURE_Process(void);
+
+#endif /* CAPTURE_H */
@@ -136,4 +136,16 @@
 #define ATOMIC_BLOCK_PRIO(prio) for( uint32_t __cond = 1, __prio = __get_BASEPRI(); \
                                      __cond != 0 ? (__set_BASEPRI_MAX(prio), 0) : 0, __cond != 0; \
                                      __set_BASEPRI(__prio), __cond = 0 )
+
+/**
+ * @def        ATOMIC_BASEPRI(prio)
+ * @brief      Converts an NVIC preemption priority into a \c BASEPRI value.
+ * @details    Only the upper \c __NVIC_PRIO_BITS of \c BASEPRI are
+ *             implemented. Passing the result to \c ATOMIC_BLOCK_PRIO() masks
+ *             all interrupts with priority \c prio or lower, i.e. a numerically
+ *             equal or higher priority value.
+ *
+ * @attention  \c prio must not be 0, as \c BASEPRI 0 disables masking.
+*/
+#define ATOMIC_BASEPRI(prio)    ((uint32_t)(prio) << (8 - __NVIC_PRIO_BITS))
 #endif /* CM_ATOMIC_H */
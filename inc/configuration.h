@@ -13,13 +13,13 @@
 
 #define POWER_PORT_LETTER        B     /* port of power switch output */
 #define POWER_BIT_NUMBER         14    /* bit where OK1 will be connected */
-#define POWER_PRESSED            SET
-#define POWER_RELEASED           RESET
+#define POWER_PRESSED            GPIO_PIN_SET
+#define POWER_RELEASED           GPIO_PIN_RESET
 
 #define RESET_PORT_LETTER        B     /* port of reset switch output */
 #define RESET_BIT_NUMBER         13    /* bit where optocoupler will be connected */
-#define RESET_PRESSED            SET
-#define RESET_RELEASED           RESET
+#define RESET_PRESSED            GPIO_PIN_SET
+#define RESET_RELEASED           GPIO_PIN_RESET
 
 #define PSU_SENSE_PORT_LETTER    A     /* port of PSU sense input */
 #define PSU_SENSE_BIT_NUMBER     8     /* bit where optocoupler will be connected */
@@ -29,11 +29,37 @@
 
 #define IR_ENABLE_PORT_LETTER    A     /* register for enabling IR receiver output */
 #define IR_ENABLE_BIT_NUMBER     1     /* bit where enable MOSFET will be connected */
-#define IR_ENABLED               RESET
-#define IR_DISABLED              SET
+#define IR_ENABLED               GPIO_PIN_RESET
+#define IR_DISABLED              GPIO_PIN_SET
 
 #define IRMP_IRSND_TIMER_NUMBER  3
 
+/* IR edge capture (IRMP_USE_EDGE_CAPTURE in irmpconfig.h): the EXTI line has to
+ * match IRMP_BIT_NUMBER, a pending pause is passed to IRMP after the timeout */
+#define IRMP_EXTI_IRQ            EXTI15_10_IRQn
+#define IRMP_EXTI_IRQ_HANDLER    EXTI15_10_IRQHandler
+#define IRMP_EDGE_TIMEOUT        (F_INTERRUPTS/40)   /* 25ms, > IRMP_TIMEOUT_LEN */
+
+/* interrupt preemption priorities, lower values are more urgent. Critical
+ * sections of the application only raise BASEPRI to IRQ_PRIO_CRITICAL, so the
+ * IR timer and the IR input are never delayed by them. Data shared with the IR
+ * interrupts must be accessed without critical sections (e.g. LDREX/STREX). */
+#define IRQ_PRIO_IR              0     /* IR timer and IR input EXTI */
+#define IRQ_PRIO_RTC             2     /* RTC wakeup: SWRTC and debouncing */
+#define IRQ_PRIO_USB             3     /* USB: reports and configuration */
+#define IRQ_PRIO_CRITICAL        IRQ_PRIO_RTC /* most urgent IRQ sharing data
+                                                 with main, must not be 0 */
+/* 1 masks all interrupts in critical sections like older firmware did, only to
+ * compare the REP_ID_IR_ISR_LATENCY of both on the same board */
+#ifndef ATOMIC_CRITICAL_PRIMASK
+#define ATOMIC_CRITICAL_PRIMASK  0
+#endif
+#if ATOMIC_CRITICAL_PRIMASK == 1
+#define ATOMIC_BLOCK_CRITICAL    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#else
+#define ATOMIC_BLOCK_CRITICAL    ATOMIC_BLOCK_PRIO(ATOMIC_BASEPRI(IRQ_PRIO_CRITICAL))
+#endif
+
 /* independent watchdog configuration */
 #define IWDG_TIMEOUT_IN_SECONDS  2
 
@@ -89,5 +115,9 @@ extern void GPIO_Configuration(void);
 extern void SystemClockConfig_STOP(void);
 extern void PrepareStopMode(void);
 extern void LeaveStopMode(void);
+extern void IRMP_EdgeCaptureInit(void);
+extern void IRSND_StartTimer(void);
+extern void IRSND_DMAInit(void);
+extern uint32_t IRMP_GetIsrLatency(void);
 
 #endif /* CONFIGURATION_H */
@@ -10,6 +10,17 @@
  *             relevant only if this modules' files are included by fifos.c and
  *             fifos.h to use it with multiple different fifos.
  *
+ * @remark     Writing is safe for multiple producers, e.g. main and several
+ *             ISRs: a slot is reserved by an atomic update of the write index
+ *             and marked ready after it has been filled. There must be only
+ *             one consumer.
+ *
+ * @remark     The read and write indices are free-running and only masked when
+ *             an entry is accessed, so all FIFO_SIZE entries can be used.
+ *             Entries can be accessed in place with FIFO_Reserve()/
+ *             FIFO_Commit() and FIFO_Peek()/FIFO_Release(), or several at once
+ *             with FIFO_WriteBulk()/ FIFO_ReadBulk().
+ *
  * @author     Michael Kipp (2015)
  * @see        http://www.mikrocontroller.net/articles/FIFO#2n-Ringpuffer_-_die_schnellste_L.C3.B6sung
  * @see        http://arnold.uthar.net/index.php?n=Work.TemplatesC
@@ -32,7 +43,8 @@
 /* Exported macro ------------------------------------------------------------*/
 /* Exported define -----------------------------------------------------------*/
 /**
-* @brief       The number of elements the FIFO can hold. MUST be 2^n.
+* @brief       The number of elements the FIFO can hold. MUST be 2^n and not
+*              more than 32768.
 */
 #define FIFO_SIZE       16
 
@@ -54,18 +66,27 @@ typedef struct FIFO_ENTRY {
 * @brief       The whole FIFO (entries and indices).
 */
 typedef struct FIFO {
-   fifo_idx_t           read;             /**< Read index.*/
-   fifo_idx_t           write;            /**< Write index.*/
+   volatile fifo_idx_t  read;             /**< Free-running read index.*/
+   volatile fifo_idx_t  write;            /**< Free-running write (reservation) index.*/
+   volatile fifo_idx_t  high_watermark;   /**< Maximum number of stored entries.*/
+   volatile uint8_t     ready[FIFO_SIZE]; /**< Entry was written completely.*/
    fifo_entry_t         entry[FIFO_SIZE]; /**< The data/ entries itself.*/
 } fifo_t;
 
 /* Exported functions ------------------------------------------------------- */
 bool FIFO_Read (fifo_t* fifo, fifo_entry_t* entry);
 bool FIFO_Write (fifo_t* fifo, fifo_entry_t* entry);
+fifo_idx_t FIFO_ReadBulk (fifo_t* fifo, fifo_entry_t* entries, fifo_idx_t n);
+fifo_idx_t FIFO_WriteBulk (fifo_t* fifo, fifo_entry_t* entries, fifo_idx_t n);
+fifo_entry_t* FIFO_Reserve (fifo_t* fifo);
+void FIFO_Commit (fifo_t* fifo, fifo_entry_t* entry);
+fifo_entry_t* FIFO_Peek (fifo_t* fifo);
+void FIFO_Release (fifo_t* fifo);
 bool FIFO_IsEmpty (fifo_t* fifo);
 bool FIFO_IsFull (fifo_t* fifo);
 void FIFO_Clear (fifo_t* fifo);
 fifo_idx_t FIFO_Count (fifo_t* fifo);
+fifo_idx_t FIFO_HighWatermark (fifo_t* fifo);
 
 #endif /* #ifndef FIFO_H */
 
@@ -91,18 +112,27 @@ typedef uint16_t        FIFOS(FIFO_PREFIX,fifo_idx_t);
 * @brief       The whole FIFO (entries and indices).
 */
 typedef struct FIFOS(FIFO_PREFIX,FIFO) {
-   FIFOS(FIFO_PREFIX,fifo_idx_t)   read;  /**< Read index.*/
-   FIFOS(FIFO_PREFIX,fifo_idx_t)   write; /**< Write index.*/
+   volatile FIFOS(FIFO_PREFIX,fifo_idx_t) read;  /**< Free-running read index.*/
+   volatile FIFOS(FIFO_PREFIX,fifo_idx_t) write; /**< Free-running write (reservation) index.*/
+   volatile FIFOS(FIFO_PREFIX,fifo_idx_t) high_watermark; /**< Maximum number of stored entries.*/
+   volatile uint8_t                ready[FIFOS(FIFO_PREFIX,FIFO_ELEMENTS)];/**< Entry was written completely.*/
    FIFOS(FIFO_PREFIX,fifo_entry_t) entry[FIFOS(FIFO_PREFIX,FIFO_ELEMENTS)];/**< The data/ entries itself.*/
 } FIFOS(FIFO_PREFIX,fifo_t);
 
 /* Exported functions ------------------------------------------------------- */
 bool FIFOS(FIFO_PREFIX,FIFO_Read)(FIFOS(FIFO_PREFIX,fifo_t)* fifo, FIFOS(FIFO_PREFIX,fifo_entry_t)* entry);
 bool FIFOS(FIFO_PREFIX,FIFO_Write)(FIFOS(FIFO_PREFIX,fifo_t)* fifo, FIFOS(FIFO_PREFIX,fifo_entry_t)* entry);
+FIFOS(FIFO_PREFIX,fifo_idx_t) FIFOS(FIFO_PREFIX,FIFO_ReadBulk)(FIFOS(FIFO_PREFIX,fifo_t)* fifo, FIFOS(FIFO_PREFIX,fifo_entry_t)* entries, FIFOS(FIFO_PREFIX,fifo_idx_t) n);
+FIFOS(FIFO_PREFIX,fifo_idx_t) FIFOS(FIFO_PREFIX,FIFO_WriteBulk)(FIFOS(FIFO_PREFIX,fifo_t)* fifo, FIFOS(FIFO_PREFIX,fifo_entry_t)* entries, FIFOS(FIFO_PREFIX,fifo_idx_t) n);
+FIFOS(FIFO_PREFIX,fifo_entry_t)* FIFOS(FIFO_PREFIX,FIFO_Reserve)(FIFOS(FIFO_PREFIX,fifo_t)* fifo);
+void FIFOS(FIFO_PREFIX,FIFO_Commit)(FIFOS(FIFO_PREFIX,fifo_t)* fifo, FIFOS(FIFO_PREFIX,fifo_entry_t)* entry);
+FIFOS(FIFO_PREFIX,fifo_entry_t)* FIFOS(FIFO_PREFIX,FIFO_Peek)(FIFOS(FIFO_PREFIX,fifo_t)* fifo);
+void FIFOS(FIFO_PREFIX,FIFO_Release)(FIFOS(FIFO_PREFIX,fifo_t)* fifo);
 bool FIFOS(FIFO_PREFIX,FIFO_IsEmpty)(FIFOS(FIFO_PREFIX,fifo_t)* fifo);
 bool FIFOS(FIFO_PREFIX,FIFO_IsFull)(FIFOS(FIFO_PREFIX,fifo_t)* fifo);
 void FIFOS(FIFO_PREFIX,FIFO_Clear)(FIFOS(FIFO_PREFIX,fifo_t)* fifo);
 FIFOS(FIFO_PREFIX,fifo_idx_t) FIFOS(FIFO_PREFIX,FIFO_Count)(FIFOS(FIFO_PREFIX,fifo_t)* fifo);
+FIFOS(FIFO_PREFIX,fifo_idx_t) FIFOS(FIFO_PREFIX,FIFO_HighWatermark)(FIFOS(FIFO_PREFIX,fifo_t)* fifo);
 
 #endif /* #ifndef FIFO_PREFIX */
 
@@ -111,6 +141,6 @@ FIFOS(FIFO_PREFIX,fifo_idx_t) FIFOS(FIFO_PREFIX,FIFO_Count)(FIFOS(FIFO_PREFIX,fi
  && (FIFO_SIZE != 64) && (FIFO_SIZE != 128) && (FIFO_SIZE != 256) \
  && (FIFO_SIZE != 512) && (FIFO_SIZE != 1024) && (FIFO_SIZE != 2048) \
  && (FIFO_SIZE != 4096) && (FIFO_SIZE != 8192) && (FIFO_SIZE != 16384) \
- && (FIFO_SIZE != 32768) && (FIFO_SIZE != 65536)
-#error FIFO_SIZE is invalid! It MUST be 2^n! Fix this in fifos.h or fifo.h.
+ && (FIFO_SIZE != 32768)
+#error FIFO_SIZE is invalid! It MUST be 2^n <= 32768! Fix this in fifos.h or fifo.h.
 #endif
@@ -27,8 +27,8 @@ extern RTC_HandleTypeDef    RtcHandle;
 extern TIM_HandleTypeDef    TimHandle;
 extern USBD_HandleTypeDef   USBD_Device;// in main.c
 
-extern volatile uint8_t     PrevXferComplete; // todo check if necessary!
 extern flags_t              flags;
+extern volatile uint32_t    events;
 extern fifo_t               irsnd_fifo;
 
 #endif
@@ -233,10 +233,107 @@
 #error F_INTERRUPTS too high (should be not greater than 20000)
 #endif
 
+#if IRMP_USE_EDGE_CAPTURE == 1 && IRMP_LOGGING == 1
+#error IRMP_LOGGING needs the input value of every tick and cannot be used with IRMP_USE_EDGE_CAPTURE
+#endif
+
+#if IRMP_USE_FRAME_QUEUE == 1 && (IRMP_FRAME_QUEUE_SIZE > 128 || (IRMP_FRAME_QUEUE_SIZE & (IRMP_FRAME_QUEUE_SIZE - 1)) != 0)
+#error IRMP_FRAME_QUEUE_SIZE must be a power of 2 and not greater than 128
+#endif
+
 #include "irmpprotocols.h"
 
 #define IRMP_FLAG_REPETITION            0x01
 
+typedef struct
+{
+    uint_fast8_t    protocol;                                                // ir protocol
+    uint_fast8_t    pulse_1_len_min;                                         // minimum length of pulse with bit value 1
+    uint_fast8_t    pulse_1_len_max;                                         // maximum length of pulse with bit value 1
+    uint_fast8_t    pause_1_len_min;                                         // minimum length of pause with bit value 1
+    uint_fast8_t    pause_1_len_max;                                         // maximum length of pause with bit value 1
+    uint_fast8_t    pulse_0_len_min;                                         // minimum length of pulse with bit value 0
+    uint_fast8_t    pulse_0_len_max;                                         // maximum length of pulse with bit value 0
+    uint_fast8_t    pause_0_len_min;                                         // minimum length of pause with bit value 0
+    uint_fast8_t    pause_0_len_max;                                         // maximum length of pause with bit value 0
+    uint_fast8_t    address_offset;                                          // address offset
+    uint_fast8_t    address_end;                                             // end of address
+    uint_fast8_t    command_offset;                                          // command offset
+    uint_fast8_t    command_end;                                             // end of command
+    uint_fast8_t    complete_len;                                            // complete length of frame
+    uint_fast8_t    stop_bit;                                                // flag: frame has stop bit
+    uint_fast8_t    lsb_first;                                               // flag: LSB first
+    uint_fast8_t    flags;                                                   // some flags
+} IRMP_PARAMETER;
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * decoder state, one instance per IR input
+ * fields of protocols which are not enabled are unused
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+    uint_fast8_t            irmp_bit;                                       // current bit position
+    IRMP_PARAMETER          irmp_param;
+    IRMP_PARAMETER          irmp_param2;
+
+    volatile uint_fast8_t   irmp_ir_detected;
+    volatile uint_fast8_t   irmp_protocol;
+    volatile uint_fast16_t  irmp_address;
+    volatile uint_fast16_t  irmp_command;
+    volatile uint_fast16_t  irmp_id;                                        // only used for SAMSUNG protocol
+    volatile uint_fast8_t   irmp_flags;
+
+    uint_fast16_t           irmp_tmp_address;                               // ir address
+    uint_fast16_t           irmp_tmp_command;                               // ir command
+    uint_fast16_t           irmp_tmp_address2;                              // ir address
+    uint_fast16_t           irmp_tmp_command2;                              // ir command
+    uint_fast16_t           irmp_lgair_address;                             // ir address
+    uint_fast16_t           irmp_lgair_command;                             // ir command
+    uint_fast16_t           irmp_tmp_id;                                    // ir id (only SAMSUNG)
+    uint8_t                 xor_check[6];                                   // check kaseikyo "parity" bits
+    uint_fast8_t            genre2;                                         // save genre2 bits here, later copied to MSB in flags
+    uint_fast8_t            parity;                                         // number of '1' of the first 14 bits, check if even.
+    uint_fast8_t            first_bit;                                      // first bit of GRUNDIG/NOKIA/IR60 frame
+
+    uint_fast8_t            irmp_start_bit_detected;                        // flag: start bit detected
+    uint_fast8_t            wait_for_space;                                 // flag: wait for data bit space
+    uint_fast8_t            wait_for_start_space;                           // flag: wait for start bit space
+    uint_fast8_t            irmp_pulse_time;                                // count bit time for pulse
+    PAUSE_LEN               irmp_pause_time;                                // count bit time for pause
+    uint_fast16_t           last_irmp_address;                              // save last irmp address to recognize key repetition
+    uint_fast16_t           last_irmp_command;                              // save last irmp command to recognize key repetition
+    uint_fast16_t           key_repetition_len;                             // SIRCS repeats frame 2-5 times with 45 ms pause
+    uint_fast8_t            repetition_frame_number;
+    uint_fast16_t           last_irmp_denon_command;                        // save last irmp command to recognize DENON frame repetition
+    uint_fast16_t           denon_repetition_len;                           // denon repetition len of 2nd auto generated frame
+    uint_fast8_t            rc5_cmd_bit6;                                   // bit 6 of RC5 command is the inverted 2nd start bit
+    PAUSE_LEN               last_pause;                                     // last pause value
+    uint_fast8_t            last_value;                                     // last bit value
+    uint_fast8_t            last_inverted_input;                            // last input value passed to callback
+#ifdef ANALYZE
+    int                     time_counter;
+#endif
+} irmp_state_t;
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * frame queue statistics, see irmp_get_queue_stats()
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+    uint_fast8_t            count;                                          // number of frames in queue
+    uint_fast8_t            high_water;                                     // maximum number of frames in queue
+    uint_fast16_t           overflows;                                      // number of dropped frames
+} IRMP_QUEUE_STATS;
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * protocol mask, see irmp_set_protocol_mask()
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#define IRMP_PROTOCOL_BIT(p)                    ((uint64_t) 1 << (p))
+#define IRMP_ALL_PROTOCOLS                      (~(uint64_t) 0)
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -245,6 +342,30 @@ extern "C"
 extern void                             irmp_init (void);
 extern uint_fast8_t                     irmp_get_data (IRMP_DATA *);
 extern uint_fast8_t                     irmp_ISR (void);
+extern uint_fast8_t                     irmp_ISR_input (uint_fast8_t);
+
+extern void                             irmp_init_state (irmp_state_t *);
+extern uint_fast8_t                     irmp_get_data_ex (irmp_state_t *, IRMP_DATA *);
+extern uint_fast8_t                     irmp_ISR_ex (irmp_state_t *, uint_fast8_t);
+
+#if IRMP_USE_EDGE_CAPTURE == 1 || defined(ANALYZE)
+extern uint_fast16_t                    irmp_ISR_duration (uint_fast8_t, uint_fast16_t);
+extern uint_fast16_t                    irmp_ISR_duration_ex (irmp_state_t *, uint_fast8_t, uint_fast16_t);
+#endif
+
+#if IRMP_USE_EDGE_CAPTURE == 1
+extern void                             irmp_edge_put (uint_fast8_t, uint_fast16_t);
+#endif
+
+#if IRMP_USE_FRAME_QUEUE == 1
+extern uint_fast8_t                     irmp_drain_data (IRMP_DATA *, uint_fast8_t);
+extern void                             irmp_get_queue_stats (IRMP_QUEUE_STATS *);
+#endif
+
+#if IRMP_USE_PROTOCOL_MASK == 1
+extern void                             irmp_set_protocol_mask (uint64_t);
+extern uint64_t                         irmp_get_protocol_mask (void);
+#endif
 
 #if IRMP_PROTOCOL_NAMES == 1
 extern const char * const               irmp_protocol_names[IRMP_N_PROTOCOLS + 1] PROGMEM;
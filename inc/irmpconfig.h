@@ -212,4 +212,42 @@
 #  define IRMP_USE_CALLBACK                     0       // 1: use callbacks. 0: do not. default is 0
 #endif
 
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * Use edge capture instead of polling the input pin every tick
+ * The capture ISR passes the length of every pulse and pause to irmp_edge_put(), decoding is done in irmp_get_data().
+ * IRMP_EDGE_BUFFER_SIZE is the number of pulses/pauses which can be stored until irmp_get_data() is called.
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef IRMP_USE_EDGE_CAPTURE
+#  define IRMP_USE_EDGE_CAPTURE                 0       // 1: use edge capture, 0: poll input pin in irmp_ISR(). default is 0
+#endif
+
+#ifndef IRMP_EDGE_BUFFER_SIZE
+#  define IRMP_EDGE_BUFFER_SIZE                 128     // number of stored pulses/pauses, 2 bytes each
+#endif
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * Queue decoded frames
+ * irmp_ISR() stores every decoded frame in a queue and goes on decoding at once, irmp_get_data() reads from the queue.
+ * Without the queue, decoding stops until irmp_get_data() has fetched the frame.
+ * IRMP_FRAME_QUEUE_SIZE is the number of frames which can be stored, must be a power of 2 and not greater than 128.
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef IRMP_USE_FRAME_QUEUE
+#  define IRMP_USE_FRAME_QUEUE                  1       // 1: queue decoded frames, 0: store only one frame. default is 1
+#endif
+
+#ifndef IRMP_FRAME_QUEUE_SIZE
+#  define IRMP_FRAME_QUEUE_SIZE                 8       // number of stored frames, 6 bytes each
+#endif
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * Enable and disable protocols at runtime with irmp_set_protocol_mask()
+ * Start bit checks of disabled protocols are skipped in irmp_ISR(), frames of disabled protocols are dropped in irmp_get_data().
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef IRMP_USE_PROTOCOL_MASK
+#  define IRMP_USE_PROTOCOL_MASK                1       // 1: use runtime protocol mask, 0: do not. default is 1
+#endif
+
 #endif // _IRMPCONFIG_H_
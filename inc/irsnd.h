@@ -55,6 +55,14 @@
 #    define _CONCAT4(a,b,c,d)                   a##b##c##d
 #    define CONCAT4(a,b,c,d)                    _CONCAT4(a,b,c,d)
 #    define IRSND_PORT_ALTERNATE_FUNCTION       CONCAT4(GPIO_AF, IRSND_PORT_TIMER_ALT_FUNC_NUMBER, _TIM, IRSND_TIMER_NUMBER)
+#    if IRSND_USE_DMA == 1
+#      define IRSND_DMA_TIMER                   CONCAT(TIM, IRSND_DMA_TIMER_NUMBER)
+#      define IRSND_DMA_TIMER_CLK_ENABLE        CONCAT3(__HAL_RCC_TIM, IRSND_DMA_TIMER_NUMBER, _CLK_ENABLE)
+#      define IRSND_DMA_TICKS_CHANNEL           CONCAT(DMA1_Channel, IRSND_DMA_TICKS_CHANNEL_NUMBER)
+#      define IRSND_DMA_LEVEL_CHANNEL           CONCAT(DMA1_Channel, IRSND_DMA_LEVEL_CHANNEL_NUMBER)
+#      define IRSND_DMA_IRQ                     CONCAT3(DMA1_Channel, IRSND_DMA_TICKS_CHANNEL_NUMBER, _IRQn)
+#      define IRSND_DMA_IRQ_HANDLER             CONCAT3(DMA1_Channel, IRSND_DMA_TICKS_CHANNEL_NUMBER, _IRQHandler)
+#    endif
 #  else
 #    warning The STM32 port of IRMP uses either the ST standard peripheral drivers or the ST HAL drivers which are both not enabled in your build configuration.
 #  endif
@@ -145,10 +153,16 @@ extern "C"
 
 extern void                                     irsnd_init (void);
 extern uint8_t                                  irsnd_is_busy (void);
+extern uint8_t                                  irsnd_is_carrier_on (void);
 extern uint8_t                                  irsnd_send_data (IRMP_DATA *, uint8_t);
 extern void                                     irsnd_stop (void);
 extern uint8_t                                  irsnd_ISR (void);
 
+#if IRSND_USE_DMA == 1
+extern uint8_t                                  irsnd_is_dma_busy (void);
+extern uint8_t                                  irsnd_DMA_ISR (void);
+#endif // IRSND_USE_DMA == 1
+
 #if IRSND_USE_CALLBACK == 1
 extern void                                     irsnd_set_callback_ptr (void (*cb)(uint8_t));
 #endif // IRSND_USE_CALLBACK == 1
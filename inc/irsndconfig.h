@@ -151,6 +151,12 @@
 #  define IRSND_TIMER_NUMBER                    4                       // timer to use, e.g. TIM4
 #  define IRSND_TIMER_PRESCALER                 1                       // timer prescaler x: HCLK/x
 #  define IRSND_TIMER_CHANNEL_NUMBER            1                       // with SPL only channel 1 can be used at the moment, others won't work
+#  ifndef IRSND_USE_DMA
+#    define IRSND_USE_DMA                       0                       // 1: gate timer and DMA play the waveform (HAL only, not yet tested on hardware), 0: irsnd_ISR() every tick
+#  endif
+#  define IRSND_DMA_TIMER_NUMBER                2                       // gate timer counting IRSND ticks, e.g. TIM2
+#  define IRSND_DMA_TICKS_CHANNEL_NUMBER        2                       // DMA1 channel of the gate timer update request, TIM2_UP: 2
+#  define IRSND_DMA_LEVEL_CHANNEL_NUMBER        5                       // DMA1 channel of the gate timer CC1 request, TIM2_CH1: 5
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
  * Teensy 3.x with teensyduino gcc compiler
@@ -167,6 +173,35 @@
 #  error target system not defined.
 #endif
 
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * Size of the precompiled waveform of one transmission, see irsnd_compile()
+ * Transmissions which don't fit are generated tick by tick in irsnd_ISR() as before
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef IRSND_MAX_RUNS
+#  define IRSND_MAX_RUNS                        512                     // number of (carrier, duration) runs, 2 bytes each
+#endif
+
+#ifndef IRSND_MAX_BLOCKS
+#  define IRSND_MAX_BLOCKS                      8                       // number of repeated blocks of runs, 6 bytes each
+#endif
+
+#ifndef IRSND_MAX_FRAMES
+#  define IRSND_MAX_FRAMES                      16                      // number of frames generated in advance, limits the time needed
+#endif
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * Play the precompiled waveform by timer and DMA instead of irsnd_ISR(), see irsnd_dma_start()
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef IRSND_USE_DMA
+#  define IRSND_USE_DMA                         0                       // flag: 0 = irsnd_ISR() plays the waveform, 1 = DMA, default is 0
+#endif
+
+#ifndef IRSND_DMA_RUNS
+#  define IRSND_DMA_RUNS                        32                      // ring buffer of the DMA in runs, 4 bytes each, must be even
+#endif
+
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
  * Use Callbacks to indicate output signal or something else
  *---------------------------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,61 @@
+/**
+ * @file       keyboard.h
+ * @brief      Module for the HID keyboard and consumer control interface.
+ *
+ * @details    Codes of the action table with ACTION_KEY or ACTION_CONSUMER
+ *             are sent as key presses via a second HID interface, which the
+ *             operating system handles like any keyboard, without a daemon
+ *             reading the vendor reports.
+ *
+ *             The usage of an entry is a key of the keyboard page with the
+ *             modifier bits (left Ctrl, Shift, Alt, GUI, then the right ones)
+ *             in the upper byte, see \c KEYBOARD_USAGE(), or a usage of the
+ *             consumer page up to \c KEYBOARD_CONSUMER_MAX.
+ *
+ *             The report descriptor and \c KEYBOARD_PackReport() don't
+ *             depend on the HAL, they can be tested on a host.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef KEYBOARD_H
+#define KEYBOARD_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/**
+ * @brief      Usage of ACTION_KEY from modifier bits and a key.
+ */
+#define KEYBOARD_USAGE(modifiers, key)  ((uint16_t)(modifiers) << 8 | (key))
+
+/* Exported define -----------------------------------------------------------*/
+/* Report IDs of the keyboard interface */
+#define KEYBOARD_REP_ID_KEYS        1  /* modifiers, reserved, 6 keys */
+#define KEYBOARD_REP_ID_CONSUMER    2  /* one usage, 16 bit */
+
+#define KEYBOARD_KEYS_SIZE          8  /* without report ID */
+#define KEYBOARD_CONSUMER_SIZE      2
+#define KEYBOARD_CONSUMER_MAX       0x3FF
+
+/**
+ * @brief      Length of the longest report including the report ID, the size
+ *             of the IN endpoint.
+ */
+#define KEYBOARD_REPORT_SIZE_MAX    (1+KEYBOARD_KEYS_SIZE)
+
+#define KEYBOARD_REPORT_DESC_SIZE   68
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+extern const uint8_t KEYBOARD_ReportDesc[KEYBOARD_REPORT_DESC_SIZE];
+
+/* Exported functions ------------------------------------------------------- */
+uint8_t KEYBOARD_PackReport(uint8_t report_id, uint16_t usage, uint8_t *report);
+uint8_t KEYBOARD_GetReport(uint8_t report_id, uint8_t *report);
+void KEYBOARD_Press(uint8_t actions, uint16_t usage);
+void KEYBOARD_Release(void);
+
+#endif /* KEYBOARD_H */
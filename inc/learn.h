@@ -0,0 +1,78 @@
+/**
+ * @file       learn.h
+ * @brief      Module for learning frames of remotes IRMP does not decode.
+ *
+ * @details    \c LEARN_Put() records the frames of the IR input in the IR
+ *             interrupt. Frames IRMP has not decoded are either stored as a
+ *             template (learning mode, see \c REP_ID_LEARN_CONTROL) or matched
+ *             against the stored templates by \c LEARN_Process(). A match is
+ *             passed on like a decoded frame with protocol
+ *             \c LEARN_PROTOCOL, the slot of the template as command and
+ *             address 0.
+ *
+ * @par        Template
+ *             A frame is reduced to at most 4 pulse and 4 pause lengths, each
+ *             run of the frame is stored as the 2 bit index of its length.
+ *             Frames that need more lengths can't be learned. A frame matches
+ *             if it has the same number of runs and every run is within 25 %
+ *             of the stored length and closer to it than to the other lengths,
+ *             the closest template wins. Remotes that alternate frames (toggle
+ *             bits, repetition frames) need a slot per frame.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef LEARN_H
+#define LEARN_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+#include "irmp.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported define -----------------------------------------------------------*/
+/**
+ * @brief      Protocol of learned frames, above the IRMP protocols.
+ */
+#define LEARN_PROTOCOL           0xF0
+
+/**
+ * @brief      Number of templates, stored as records (see store.h).
+ */
+#define LEARN_SLOTS              48
+
+/**
+ * @brief      Size of a template in the store.
+ */
+#define LEARN_TEMPLATE_SIZE      32
+
+/**
+ * @brief      Length of \c REP_ID_LEARN_CONTROL: command and slot, read back
+ *             as state, slot, number of used slots and \c LEARN_SLOTS.
+ */
+#define LEARN_CONTROL_SIZE       4
+
+/* Commands of REP_ID_LEARN_CONTROL, slot 0xFF selects the first free slot to
+   learn or all slots to delete */
+#define LEARN_CMD_STOP           0
+#define LEARN_CMD_LEARN          1  /* store the next unknown frame in slot */
+#define LEARN_CMD_DELETE         2
+
+/* States of REP_ID_LEARN_CONTROL */
+#define LEARN_STATE_IDLE         0
+#define LEARN_STATE_WAITING      1  /* for an unknown frame */
+#define LEARN_STATE_DONE         2
+#define LEARN_STATE_FAILED       3  /* too many lengths or no free slot */
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+void LEARN_Init(void);
+void LEARN_Control(uint8_t command, uint8_t slot);
+void LEARN_GetControl(uint8_t *control);
+void LEARN_Put(uint8_t input, uint16_t ticks);
+void LEARN_Decoded(void);
+bool LEARN_Process(IRMP_DATA *irmp_data);
+bool LEARN_Commit(void);
+
+#endif /* LEARN_H */
@@ -0,0 +1,73 @@
+/**
+ * @file       repeat.h
+ * @brief      Module that shapes the repetitions of a held key.
+ *
+ * @details    A remote repeats the frame of a held key at its own rate, about
+ *             every 110 ms for most protocols and every 45 ms for SIRCS.
+ *             \c REPEAT_Frame() turns the received frames into key events
+ *             like a keyboard with typematic delay and rate:
+ *             - \c REPEAT_DOWN for the first frame of a key,
+ *             - \c REPEAT_REPEAT for a repetition frame received at least
+ *               \c delay ms after the key went down and \c period ms after
+ *               the last one forwarded, the other repetition frames are
+ *               dropped,
+ *             - \c REPEAT_UP when no frame of the key was received for
+ *               \c timeout ms, or another key went down.
+ *
+ *             A delay and period of 0 forward every repetition frame once
+ *             \c min_ir_repeats of them have been received, as before. A
+ *             timeout of 0 disables key-up events. The timeout must exceed
+ *             the repetition gap of the remote, IRMP clears the repetition
+ *             flag after 150 ms anyway, so a longer one only delays key-up.
+ *
+ *             \c REPEAT_Tick() raises \c EVENT_REPEAT when the timeout of
+ *             the held key expires, then \c REPEAT_Poll() returns the key-up
+ *             event. Both take the time as argument, so the module can be
+ *             driven by recorded frames on a host.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef REPEAT_H
+#define REPEAT_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+#include "irmp.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported define -----------------------------------------------------------*/
+/**
+ * @brief      Length of \c REP_ID_REPEAT_SHAPING: delay, period and timeout in
+ *             ms, 16 bit little endian each.
+ */
+#define REPEAT_REPORT_SIZE       6
+
+/* Flag of the IR code report of a released key, IRMP_FLAG_RELEASE of newer
+   IRMP versions */
+#define REPEAT_FLAG_RELEASE      0x02
+
+/* Events returned by REPEAT_Frame() and REPEAT_Poll(), REPEAT_UP refers to
+   the key released, which is not the received one */
+#define REPEAT_NONE              0x00  /* repetition frame dropped */
+#define REPEAT_DOWN              0x01
+#define REPEAT_REPEAT            0x02
+#define REPEAT_UP                0x04
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct REPEAT_CONFIG
+{
+   uint16_t    delay;         /* ms from key-down to the first repeat */
+   uint16_t    period;        /* ms from one repeat to the next */
+   uint16_t    timeout;       /* ms without a frame until key-up, 0: off */
+} repeat_config_t;
+
+/* Exported functions ------------------------------------------------------- */
+void REPEAT_SetConfig(uint8_t min_repeats, const repeat_config_t *config);
+bool REPEAT_HasKeyUp(void);
+uint8_t REPEAT_Frame(const IRMP_DATA *irmp_data, uint32_t now, IRMP_DATA *released);
+uint8_t REPEAT_Poll(uint32_t now, IRMP_DATA *released);
+void REPEAT_Tick(uint32_t now);
+
+#endif /* REPEAT_H */
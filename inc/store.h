@@ -0,0 +1,70 @@
+/**
+ * @file       store.h
+ * @brief      Module that stores records too large for the emulated EEPROM.
+ *
+ * @details    The learned templates and the entries of the action table are
+ *             written and read as records, a record is identified by its
+ *             EEPROM address (\c ADDRESS_records and above) and always
+ *             written as a whole. On the STM32L1xx a record is stored in the
+ *             data EEPROM at its address. On the STM32F1xx the emulated
+ *             EEPROM holds at most 255 variables of 2 bytes and moves all of
+ *             them to its other page whenever a page is full, so records go
+ *             into dedicated flash pages instead.
+ *
+ * @par        Flash layout (STM32F1xx)
+ @verbatim
+
+  0x0801E000   bank 0, 4 pages of 1 KB
+  0x0801F000   bank 1, 4 pages of 1 KB
+
+  bank:    state (2 bytes), reserved (2 bytes), records, erased space
+  record:  address (2 bytes), length (2 bytes), data (padded to 2 bytes),
+           0x0000 once the record is complete (2 bytes)
+
+ @endverbatim
+ *             A write appends the record to the valid bank, the last
+ *             complete record of an address is valid. When the bank is full
+ *             the valid records are copied into the other bank, which is
+ *             erased first, and the first page of the old bank is erased.
+ *             Bank states like those of the emulated EEPROM pages tell after
+ *             a reset which bank is valid, records interrupted by a reset
+ *             are skipped.
+ *
+ * @par        Wear and stalls (STM32F1xx)
+ *             All templates and action entries use 2720 bytes of a bank of
+ *             4092, so at least 1372 bytes, 36 template writes or 98 entry
+ *             writes, are written between two copies. Banks take turns, so a
+ *             page is erased at most once per 72 template writes or 196 entry
+ *             writes, 10000 erase cycles last for about 720000 template writes
+ *             or 1.9 million entry writes. A record takes at most about 1 ms
+ *             to program (19 halfwords of 52-70 us for a template), interrupts
+ *             keep running in between. A copy programs up to 2720 bytes (about
+ *             90 ms) and erases 4 pages of 20-40 ms each. The CPU stalls
+ *             during an erase, the IR interrupt included, so frames received
+ *             meanwhile are lost.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef STORE_H
+#define STORE_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#if defined(STM32F103xB)
+  #include "stm32f1xx_hal.h"
+#elif defined(STM32L151xB)
+  #include "stm32l1xx_hal.h"
+#else
+  #error Device not specified.
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macro ------------------------------------------------------------*/
+/* Exported define -----------------------------------------------------------*/
+/* Exported types ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+void STORE_Init(void);
+HAL_StatusTypeDef STORE_Read(uint16_t address, void *data, uint8_t length);
+HAL_StatusTypeDef STORE_Write(uint16_t address, const void *data, uint8_t length);
+
+#endif /* STORE_H */
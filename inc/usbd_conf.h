@@ -44,17 +44,25 @@
 /* Exported types ------------------------------------------------------------*/
 /* Exported constants --------------------------------------------------------*/
 /* Common Config */
-#define USBD_MAX_NUM_INTERFACES               1
+#define USBD_MAX_NUM_INTERFACES               2  /* vendor, keyboard */
 #define USBD_MAX_NUM_CONFIGURATION            1
 #define USBD_MAX_STR_DESC_SIZ                 0x100
 #define USBD_SUPPORT_USER_STRING              0
 #define USBD_SELF_POWERED                     0
 #define USBD_DEBUG_LEVEL                      0
 
-#define USBD_CUSTOMHID_INREPORT_BUF_SIZE      (1+6)
+#define USBD_CUSTOMHID_INREPORT_BUF_SIZE      (1+31) /* REP_ID_CAPTURE_DATA */
 #define USBD_CUSTOMHID_OUTREPORT_BUF_SIZE     (1+6)
-//#define USBD_CUSTOMHID_FEATREPORT_BUF_SIZE    (1+16) // not supported by the stack atm
-#define USBD_CUSTOM_HID_REPORT_DESC_SIZE      117
+#define USBD_CUSTOMHID_FEATREPORT_BUF_SIZE    (1+42) /* REP_ID_CONFIG_BLOB */
+#define USBD_CUSTOMHID_INREPORT_QUEUE_SIZE    8
+#ifndef USBD_CUSTOMHID_POLLING_INTERVAL
+#define USBD_CUSTOMHID_POLLING_INTERVAL       25  /* bInterval in ms (1..255) */
+#endif
+#define USBD_CUSTOM_HID_REPORT_DESC_SIZE      195
+
+#define USBD_KEYBOARD_INREPORT_BUF_SIZE       (1+8)  /* KEYBOARD_REPORT_SIZE_MAX */
+#define USBD_KEYBOARD_INREPORT_QUEUE_SIZE     4      /* press and release */
+#define USBD_KEYBOARD_POLLING_INTERVAL        10     /* bInterval in ms */
 
 /* Exported macro ------------------------------------------------------------*/
 /* Memory management macros */
@@ -65,7 +73,7 @@
 void *USBD_static_malloc(uint32_t size);
 void USBD_static_free(void *p);
 
-#define MAX_STATIC_ALLOC_SIZE     10 /* Custom HID Class Driver Structure size */
+#define MAX_STATIC_ALLOC_SIZE     ((sizeof(USBD_CUSTOM_HID_HandleTypeDef)+3)/4) /* Custom HID Class Driver Structure size */
 
 #define USBD_malloc               (uint32_t *)USBD_static_malloc
 #define USBD_free                 USBD_static_free
@@ -55,7 +55,15 @@
 #define CUSTOM_HID_EPOUT_ADDR                0x01
 #define CUSTOM_HID_EPOUT_SIZE                USBD_CUSTOMHID_OUTREPORT_BUF_SIZE //0x02
 
-#define USB_CUSTOM_HID_CONFIG_DESC_SIZ       41
+#define KEYBOARD_INTERFACE                   0x01
+#define KEYBOARD_EPIN_ADDR                   0x82
+#define KEYBOARD_EPIN_SIZE                   USBD_KEYBOARD_INREPORT_BUF_SIZE
+
+#if USBD_CUSTOMHID_FEATREPORT_BUF_SIZE < USBD_CUSTOMHID_OUTREPORT_BUF_SIZE
+#error USBD_CUSTOMHID_FEATREPORT_BUF_SIZE must not be smaller than USBD_CUSTOMHID_OUTREPORT_BUF_SIZE
+#endif
+
+#define USB_CUSTOM_HID_CONFIG_DESC_SIZ       66
 #define USB_CUSTOM_HID_DESC_SIZ              9
 
 #define CUSTOM_HID_DESCRIPTOR_TYPE           0x21
@@ -96,14 +104,23 @@ typedef struct _USBD_CUSTOM_HID_Itf
 
 typedef struct
 {
-  uint8_t              Report_buf[USBD_CUSTOMHID_OUTREPORT_BUF_SIZE];
+  uint8_t              Report_buf[USBD_CUSTOMHID_FEATREPORT_BUF_SIZE];
   uint32_t             Protocol;
   uint32_t             IdleState;
   uint32_t             AltSetting;
   uint32_t             IsReportAvailable;
   CUSTOM_HID_StateTypeDef     state;
+  uint32_t             KbdProtocol;  /* keyboard interface */
+  uint32_t             KbdIdleState;
+  CUSTOM_HID_StateTypeDef     KbdState;
 } USBD_CUSTOM_HID_HandleTypeDef;
 
+typedef struct
+{
+  uint32_t             Overflows;   /* report discarded, queue was full */
+  uint32_t             Drops;       /* report discarded, not configured */
+} USBD_CUSTOM_HID_InStatsTypeDef;
+
 /**
   * @}
   */
@@ -135,6 +152,20 @@ uint8_t USBD_CUSTOM_HID_SendReport (USBD_HandleTypeDef *pdev,
                                     uint8_t *report,
                                     uint16_t len);
 
+void USBD_CUSTOM_HID_GetInStats (USBD_CUSTOM_HID_InStatsTypeDef *stats);
+
+uint8_t USBD_CUSTOM_HID_GetInQueueSpace (void);
+
+void USBD_CUSTOM_HID_InSentCallback (void);
+
+void USBD_CUSTOM_HID_SetPollingInterval (uint8_t interval);
+
+uint8_t USBD_KEYBOARD_SendReport (USBD_HandleTypeDef *pdev,
+                                  uint8_t *report,
+                                  uint16_t len);
+
+void USBD_KEYBOARD_InSentCallback (void);
+
 uint8_t  USBD_CUSTOM_HID_RegisterInterface (USBD_HandleTypeDef   *pdev,
                                             USBD_CUSTOM_HID_ItfTypeDef *fops);
 
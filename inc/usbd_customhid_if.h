@@ -37,6 +37,7 @@
 typedef enum _CUSTOMHID_REPORT_ID
 {
   REP_ID_IR_CODE_INTERRUPT       = 1,
+  REP_ID_CAPTURE_DATA            = 2,
   REP_ID_GET_FIRMWARE_VERSION    = 0x10,
   REP_ID_CONTROL_PC_ENABLE       = 0x11,
   REP_ID_FORWARD_IR_ENABLE       = 0x12,
@@ -48,12 +49,24 @@ typedef enum _CUSTOMHID_REPORT_ID
   REP_ID_CLOCK_CORRECTION        = 0x18,
   REP_ID_WAKEUP_TIME             = 0x19,
   REP_ID_WAKEUP_TIME_SPAN        = 0x1A,
+  REP_ID_PROTOCOL_MASK           = 0x1B,
+  REP_ID_CPU_LOAD                = 0x1C,
+  REP_ID_IN_REPORT_STATS         = 0x1D,
+  REP_ID_POLLING_INTERVAL        = 0x1E,
+  REP_ID_CONFIG_BLOB             = 0x1F,
+  REP_ID_IR_ISR_LATENCY          = 0x20,
+  REP_ID_CAPTURE_CONTROL         = 0x21,
+  REP_ID_LEARN_CONTROL           = 0x22,
+  REP_ID_ACTION_ENTRY            = 0x23,
+  REP_ID_REPEAT_SHAPING          = 0x24,
   REP_ID_REQUEST_BOOTLOADER      = 0x50,
   REP_ID_WATCHDOG_ENABLE         = 0x51,
   REP_ID_WATCHDOG_RESET          = 0x52
 } CUSTOMHID_REPORT_ID;
 
 /* Exported constants --------------------------------------------------------*/
+#define CONFIG_BLOB_VERSION            2   /* first byte of REP_ID_CONFIG_BLOB */
+#define CONFIG_BLOB_SIZE               42  /* version 1: 36, same layout */
 /* Exported macro ------------------------------------------------------------*/
 /* Exported functions ------------------------------------------------------- */
 extern USBD_CUSTOM_HID_ItfTypeDef USBD_CustomHID_fops;
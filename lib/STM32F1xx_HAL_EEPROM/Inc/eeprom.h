@@ -74,7 +74,7 @@
 #define PAGE_FULL               ((uint8_t)0x80)
 
 /* Variables' number */
-#define NUMBER_OF_VARIABLES     ((uint8_t)ADDRESS_LENGTH)
+#define NUMBER_OF_VARIABLES     ((uint8_t)ADDRESS_records)
 
 /* Exported types ------------------------------------------------------------*/
 /* Exported macro ------------------------------------------------------------*/
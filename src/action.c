@@ -0,0 +1,478 @@
+/**
+ * @file       action.c
+ * @brief      Module for the table that maps IR codes to actions.
+ * @see        action.h for the table and the legacy codes.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "action.h"
+#include "irmp.h"
+#include "application.h"
+#include "configuration.h"
+#include "cm_atomic.h"
+#include "global_variables.h"
+#include "store.h"
+
+/* Private define ------------------------------------------------------------*/
+#define ACTION_HASH_BITS      7     /* twice ACTION_ENTRIES, so probing ends */
+#define ACTION_HASH_SIZE      (1 << ACTION_HASH_BITS)
+#define ACTION_HASH_MUL       2654435769u  /* 2^32 / golden ratio */
+#define ACTION_REQUESTS       16    /* REP_ID_ACTION_ENTRY reports queued for
+                                       main, power of 2 */
+#define ACTION_LEGACY_CODES   3
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct ACTION
+{
+   /* shared */
+   volatile uint8_t  head;             /* next request, written by USB */
+   volatile uint8_t  tail;             /* next request, written by main */
+   volatile uint8_t  select;           /* entry read by REP_ID_ACTION_ENTRY */
+   /* main */
+   uint8_t           used;             /* number of used entries */
+} action_t;
+
+typedef char action_hash_size_check[(ACTION_HASH_SIZE >= 2 * ACTION_ENTRIES) ? 1 : -1];
+#if defined(STM32F103xB)
+typedef char action_eeprom_size_check[(ADDRESS_records <= 255) ? 1 : -1];
+#endif
+
+/* Private macro -------------------------------------------------------------*/
+#define ACTION_ADDRESS(idx)   (ADDRESS_action_table + \
+                               (idx) * (ACTION_ENTRY_SIZE / EEPROM_ADDRESS_SIZE))
+
+/* Private variables ---------------------------------------------------------*/
+static action_t   action;
+static IRMP_DATA  action_table[ACTION_ENTRIES];    /* flags hold the actions */
+static uint16_t   action_usages[ACTION_ENTRIES];   /* of ACTION_KEY or
+                                                      ACTION_CONSUMER */
+static uint8_t    action_hash[ACTION_HASH_SIZE];   /* index+1 of an entry, 0
+                                                      ends probing */
+static uint8_t    action_requests[ACTION_REQUESTS][ACTION_REPORT_SIZE];
+static uint8_t    action_dirty[(ACTION_ENTRIES + 7) / 8];  /* entries not yet
+                                                      written into the store */
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Checks whether an entry holds a code, erased or freed entries
+  *         hold 0x00 or 0xFF.
+  */
+static bool ACTION_IsUsed(uint8_t idx)
+{
+   return action_table[idx].protocol != 0 &&
+          action_table[idx].flags != 0 && action_table[idx].flags != 0xFF;
+}
+
+/**
+  * @brief  Maps protocol, address and command to a bucket of action_hash.
+  *         The multiplication spreads every bit of the code into the top
+  *         bits that are used.
+  */
+static uint8_t ACTION_Hash(const IRMP_DATA *irmp_data)
+{
+   uint32_t key = ((uint32_t)irmp_data->command << 16 | irmp_data->address) ^
+                  ((uint32_t)irmp_data->protocol << 8);
+
+   return (key * ACTION_HASH_MUL) >> (32 - ACTION_HASH_BITS);
+}
+
+/**
+  * @brief  Finds the entry of a code, the flags are ignored.
+  * @return Index of the entry or ACTION_ENTRIES.
+  */
+static uint8_t ACTION_Find(const IRMP_DATA *irmp_data)
+{
+   uint8_t bucket = ACTION_Hash(irmp_data);
+   uint8_t idx;
+
+   while((idx = action_hash[bucket]) != 0)
+   {
+      idx--;
+      if( (action_table[idx].command == irmp_data->command) &&
+          (action_table[idx].address == irmp_data->address) &&
+          (action_table[idx].protocol == irmp_data->protocol) )
+      {
+         return idx;
+      }
+      bucket = (bucket + 1) & (ACTION_HASH_SIZE - 1);
+   }
+
+   return ACTION_ENTRIES;
+}
+
+/**
+  * @brief  Rebuilds action_hash after the table has changed. Entries are
+  *         inserted in ascending order, so the first entry of a code that is
+  *         stored twice is found.
+  */
+static void ACTION_Rebuild(void)
+{
+   uint8_t bucket;
+   uint8_t idx;
+
+   memset(action_hash, 0, sizeof(action_hash));
+   action.used = 0;
+
+   for(idx = 0; idx < ACTION_ENTRIES; idx++)
+   {
+      if(ACTION_IsUsed(idx))
+      {
+         bucket = ACTION_Hash(&action_table[idx]);
+         while(action_hash[bucket] != 0)
+         {
+            bucket = (bucket + 1) & (ACTION_HASH_SIZE - 1);
+         }
+         action_hash[bucket] = idx + 1;
+         action.used++;
+      }
+   }
+}
+
+/**
+  * @brief  Finds a free entry.
+  * @return Index of the entry or ACTION_ENTRIES if the table is full.
+  */
+static uint8_t ACTION_FindFree(void)
+{
+   uint8_t idx;
+
+   for(idx = 0; idx < ACTION_ENTRIES && ACTION_IsUsed(idx); idx++);
+
+   return idx;
+}
+
+/**
+  * @brief  Marks an entry to be written into the store by ACTION_Commit().
+  */
+static void ACTION_SetDirty(uint8_t idx)
+{
+   action_dirty[idx / 8] |= 1 << (idx % 8);
+   SetEvent(EVENT_EEPROM_PENDING);
+}
+
+/**
+  * @brief  Updates an entry, it is written into the store later if it has
+  *         changed. ACTION_Rebuild() must be called afterwards.
+  * @param  *irmp_data: code, the flags are ignored
+  * @param  actions: ACTION_xxx bits, 0 frees the entry
+  * @param  usage: HID usage of ACTION_KEY or ACTION_CONSUMER
+  */
+static void ACTION_Store(uint8_t idx, const IRMP_DATA *irmp_data, uint8_t actions, uint16_t usage)
+{
+   IRMP_DATA entry = {0};
+
+   if(actions & ACTION_KEY)
+   {
+      actions &= ~ACTION_CONSUMER;
+   }
+   if(irmp_data->protocol == 0 || actions == 0)
+   {
+      actions = 0;
+   }
+   else
+   {
+      entry.protocol = irmp_data->protocol;
+      entry.address = irmp_data->address;
+      entry.command = irmp_data->command;
+      entry.flags = actions;
+   }
+   if(!(actions & (ACTION_KEY | ACTION_CONSUMER)))
+   {
+      usage = 0;
+   }
+
+   // REP_ID_ACTION_ENTRY reads the table in the USB interrupt
+   if(memcmp(&entry, &action_table[idx], sizeof(entry)) != 0)
+   {
+      ATOMIC_BLOCK_CRITICAL
+      {
+         memcpy(&action_table[idx], &entry, sizeof(entry));
+      }
+      ACTION_SetDirty(idx);
+   }
+
+   if(usage != action_usages[idx])
+   {
+      ATOMIC_BLOCK_CRITICAL
+      {
+         action_usages[idx] = usage;
+      }
+      ACTION_SetDirty(idx);
+   }
+}
+
+/* Public functions ----------------------------------------------------------*/
+/**
+  * @brief  Reads the table from the store and moves the power on, power off
+  *         and reset codes of older firmware into it if it is empty.
+  */
+void ACTION_Init(void)
+{
+   static const uint8_t  legacy_actions[ACTION_LEGACY_CODES] =
+      { ACTION_POWER_ON, ACTION_POWER_OFF, ACTION_RESET };
+   static const uint16_t legacy_addresses[ACTION_LEGACY_CODES] =
+      { ADDRESS_irmp_power_on, ADDRESS_irmp_power_off, ADDRESS_irmp_reset };
+   uint8_t   record[ACTION_ENTRY_SIZE];
+   IRMP_DATA legacy;
+   uint8_t   idx;
+
+   for(idx = 0; idx < ACTION_ENTRIES; idx++)
+   {
+      // a record never written reads as a free entry
+      memset(record, 0, sizeof(record));
+      STORE_Read(ACTION_ADDRESS(idx), record, sizeof(record));
+      memcpy(&action_table[idx], record, sizeof(IRMP_DATA));
+      memcpy(&action_usages[idx], &record[sizeof(IRMP_DATA)], sizeof(uint16_t));
+   }
+   ACTION_Rebuild();
+
+   if(action.used == 0)
+   {
+      for(idx = 0; idx < ACTION_LEGACY_CODES; idx++)
+      {
+         memset(&legacy, 0, sizeof(legacy));
+         EEPROM_ReadBytes(legacy_addresses[idx], &legacy, sizeof(legacy));
+         if(legacy.protocol != 0x00 && legacy.protocol != 0xFF)
+         {
+            ACTION_Assign(&legacy, legacy_actions[idx]);
+
+            // moved, so a table emptied later is not filled again
+            memset(&legacy, 0xFF, sizeof(legacy));
+            EEPROM_WriteBytesDeferred(legacy_addresses[idx], &legacy, sizeof(legacy));
+         }
+      }
+   }
+}
+
+/**
+  * @brief  Looks up the actions of a received code. Called by main for
+  *         every frame, it takes the same time for any number of entries.
+  * @param  *irmp_data: received code, the flags are ignored
+  * @param  *usage holds the HID usage of the entry afterwards.
+  * @return ACTION_xxx bits, 0 if the code is not in the table.
+  */
+uint8_t ACTION_Lookup(const IRMP_DATA *irmp_data, uint16_t *usage)
+{
+   uint8_t idx = ACTION_Find(irmp_data);
+
+   if(idx < ACTION_ENTRIES)
+   {
+      *usage = action_usages[idx];
+      return action_table[idx].flags;
+   }
+
+   *usage = 0;
+   return 0;
+}
+
+/**
+  * @brief  Gives an action to one code only, like the power on, power off
+  *         and reset codes of older firmware. Must only be called from main.
+  * @param  *irmp_data: code, protocol 0x00 or 0xFF only removes the action
+  *         from all entries
+  * @param  action_bit: one ACTION_xxx bit
+  * @return false if the table is full.
+  */
+bool ACTION_Assign(const IRMP_DATA *irmp_data, uint8_t action_bit)
+{
+   bool    valid = (irmp_data->protocol != 0x00) && (irmp_data->protocol != 0xFF);
+   uint8_t target = valid ? ACTION_Find(irmp_data) : ACTION_ENTRIES;
+   uint8_t idx;
+
+   for(idx = 0; idx < ACTION_ENTRIES; idx++)
+   {
+      if(idx != target && ACTION_IsUsed(idx) && (action_table[idx].flags & action_bit))
+      {
+         ACTION_Store(idx, &action_table[idx], action_table[idx].flags & ~action_bit,
+                      action_usages[idx]);
+      }
+   }
+
+   if(valid)
+   {
+      if(target < ACTION_ENTRIES)
+      {
+         ACTION_Store(target, irmp_data, action_table[target].flags | action_bit,
+                      action_usages[target]);
+      }
+      else if((target = ACTION_FindFree()) < ACTION_ENTRIES)
+      {
+         ACTION_Store(target, irmp_data, action_bit, 0);
+      }
+   }
+   ACTION_Rebuild();
+
+   return !valid || target < ACTION_ENTRIES;
+}
+
+/**
+  * @brief  Finds the code of an action, like the power on, power off and
+  *         reset codes of older firmware.
+  * @param  action_bit: one ACTION_xxx bit
+  * @param  *irmp_data holds the code of the first entry with the action
+  *         afterwards, flags 0, or zeros if there is none.
+  */
+void ACTION_GetCode(uint8_t action_bit, IRMP_DATA *irmp_data)
+{
+   uint8_t idx;
+
+   memset(irmp_data, 0, sizeof(*irmp_data));
+
+   for(idx = 0; idx < ACTION_ENTRIES; idx++)
+   {
+      if(ACTION_IsUsed(idx) && (action_table[idx].flags & action_bit))
+      {
+         irmp_data->protocol = action_table[idx].protocol;
+         irmp_data->address = action_table[idx].address;
+         irmp_data->command = action_table[idx].command;
+         break;
+      }
+   }
+}
+
+/**
+  * @brief  Handles REP_ID_ACTION_ENTRY, called from the USB interrupt. The
+  *         report is queued for ACTION_Process(), it is dropped if
+  *         ACTION_REQUESTS reports are waiting.
+  * @param  *report: index, protocol, address, command, actions and usage
+  *         (multi-byte values little endian). Index ACTION_INDEX_ANY selects the entry holding the
+  *         code or the first free one, protocol ACTION_SELECT only selects
+  *         the entry that is read back.
+  */
+void ACTION_SetEntry(const uint8_t *report)
+{
+   uint8_t head = action.head;
+
+   if((uint8_t)(head - action.tail) < ACTION_REQUESTS)
+   {
+      memcpy(action_requests[head & (ACTION_REQUESTS - 1)], report, ACTION_REPORT_SIZE);
+      __DMB();
+      action.head = head + 1;
+   }
+   SetEvent(EVENT_ACTION);
+}
+
+/**
+  * @brief  Fills REP_ID_ACTION_ENTRY with the selected entry, called from the
+  *         USB interrupt.
+  * @param  *report holds index, protocol, address, command, actions and
+  *         usage afterwards, all zero if the entry is free. An index beyond the
+  *         table reads as ACTION_INDEX_ANY.
+  */
+void ACTION_GetEntry(uint8_t *report)
+{
+   uint8_t idx = action.select;
+
+   memset(report, 0, ACTION_REPORT_SIZE);
+   if(idx >= ACTION_ENTRIES)
+   {
+      report[0] = ACTION_INDEX_ANY;
+   }
+   else
+   {
+      report[0] = idx;
+      if(ACTION_IsUsed(idx))
+      {
+         report[1] = action_table[idx].protocol;
+         report[2] = action_table[idx].address;
+         report[3] = action_table[idx].address >> 8;
+         report[4] = action_table[idx].command;
+         report[5] = action_table[idx].command >> 8;
+         report[6] = action_table[idx].flags;
+         report[7] = action_usages[idx];
+         report[8] = action_usages[idx] >> 8;
+      }
+   }
+}
+
+/**
+  * @brief  Applies the REP_ID_ACTION_ENTRY reports received via USB. The
+  *         entry written last is selected to be read back.
+  * @return true if the table has changed.
+  */
+bool ACTION_Process(void)
+{
+   const uint8_t *report;
+   IRMP_DATA      code;
+   uint16_t       usage;
+   uint8_t        idx;
+   bool           changed = false;
+
+   while(action.tail != action.head)
+   {
+      __DMB();
+      report = action_requests[action.tail & (ACTION_REQUESTS - 1)];
+      idx = report[0];
+      code.protocol = report[1];
+      code.address = report[2] | (uint16_t)report[3] << 8;
+      code.command = report[4] | (uint16_t)report[5] << 8;
+      code.flags = report[6];
+      usage = report[7] | (uint16_t)report[8] << 8;
+
+      if(code.protocol != ACTION_SELECT)
+      {
+         if(idx == ACTION_INDEX_ANY)
+         {
+            idx = ACTION_Find(&code);
+            if(idx >= ACTION_ENTRIES)
+            {
+               idx = ACTION_FindFree();
+            }
+         }
+         if(idx < ACTION_ENTRIES)
+         {
+            ACTION_Store(idx, &code, code.flags, usage);
+            changed = true;
+         }
+      }
+      action.select = idx;
+
+      __DMB();
+      action.tail++;
+   }
+
+   if(changed)
+   {
+      ACTION_Rebuild();
+   }
+
+   return changed;
+}
+
+/**
+  * @brief  Writes one changed entry into the store, called from the main
+  *         loop on EVENT_EEPROM_PENDING with interrupts enabled. An entry
+  *         stays marked if the write fails and is tried again.
+  * @return true if more entries are pending.
+  */
+bool ACTION_Commit(void)
+{
+   uint8_t record[ACTION_ENTRY_SIZE];
+   uint8_t idx;
+
+   for(idx = 0; idx < ACTION_ENTRIES; idx++)
+   {
+      if(action_dirty[idx / 8] & (1 << (idx % 8)))
+      {
+         memcpy(record, &action_table[idx], sizeof(IRMP_DATA));
+         memcpy(&record[sizeof(IRMP_DATA)], &action_usages[idx], sizeof(uint16_t));
+         if(STORE_Write(ACTION_ADDRESS(idx), record, sizeof(record)) == HAL_OK)
+         {
+            action_dirty[idx / 8] &= ~(1 << (idx % 8));
+         }
+         break;
+      }
+   }
+
+   for(; idx < ACTION_ENTRIES; idx++)
+   {
+      if(action_dirty[idx / 8] & (1 << (idx % 8)))
+      {
+         return true;
+      }
+   }
+
+   return false;
+}
@@ -25,14 +25,59 @@
 #include "configuration.h"
 #include "main.h"
 #include "global_variables.h"
+#include "cm_atomic.h"
+#include "capture.h"
+#include "learn.h"
+#include "action.h"
+#include "keyboard.h"
+#include "repeat.h"
+#include "store.h"
 
 /* Private typedef -----------------------------------------------------------*/
+typedef struct EEPROM_CACHE_ENTRY
+{
+   uint16_t    address;
+   uint8_t     length;        /* 0: entry is free */
+   uint8_t     data[8];       /* large enough for every config field */
+} eeprom_cache_entry_t;
+
+typedef struct IRSND_ECHO
+{
+   IRMP_DATA   data;          /* frame sent by IRSND */
+   uint32_t    end;           /* HAL_GetTick() when the window closes */
+   bool        open;
+   bool        sending;       /* end is not known yet */
+} irsnd_echo_t;
+
 /* Private define ------------------------------------------------------------*/
+#define EEPROM_CACHE_ENTRIES  12  /* one per config field and legacy code
+                                     moved by ACTION_Init(), as writes to the
+                                     same address are merged */
+#define EEPROM_COMMIT_PASSES  (2 * (EEPROM_CACHE_ENTRIES + ACTION_ENTRIES + LEARN_SLOTS))
+                                  /* every pending value and a retry of each */
+#define IRSND_ECHO_WINDOWS    2   /* frame being sent and the one before */
+#define IRSND_ECHO_TAIL       40  /* ms a window stays open after sending, covers
+                                     IRMP's end of frame detection and the
+                                     delay until frames are read */
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 static hidirt_data_t hidirt_data;
+/* Snapshots of hidirt_data for readers in interrupt context, readers use
+   the copy selected by the lowest bit of the sequence counter while
+   PublishHidirtConfig() updates the other one */
+static hidirt_data_t hidirt_data_snapshot[2];
+static volatile uint32_t hidirt_data_seq;
+static cpu_load_t    cpu_load;
+static uint32_t      idle_cycles;
+static uint32_t      interval_start;
+static eeprom_cache_entry_t eeprom_cache[EEPROM_CACHE_ENTRIES];
+static irsnd_echo_t  irsnd_echo[IRSND_ECHO_WINDOWS];
+static uint8_t       irsnd_echo_idx;
 
 /* Private function prototypes -----------------------------------------------*/
+static void PublishHidirtConfig(void);
+static void GetActionCodes(void);
+static bool CommitNextValue(void);
 /* Private functions ---------------------------------------------------------*/
 
 /**
@@ -72,7 +117,7 @@ HAL_StatusTypeDef EEPROM_ReadBytes(uint32_t address, void *data, uint8_t length)
 #elif defined(STM32L151xB)
    // add EEPROM address offset
    address += DATA_EEPROM_START_ADDR;
-   memcpy(data, (void *) address, length);
+   memcpy(data, (void *)(uintptr_t) address, length);
 #else
 #error Device not specified.
 #endif
@@ -139,6 +184,110 @@ HAL_StatusTypeDef EEPROM_WriteBytes(uint32_t address, void *data, uint8_t length
    return status;
 }
 
+/**
+  * @brief  Stores bytes in the write-back cache, they are written into the
+  *         EEPROM later by EEPROM_CommitNext() in the main loop. Only copies
+  *         to RAM, so it may be called with interrupts disabled. A pending
+  *         write to the same address is replaced.
+  * @param  Address:
+  * @param  *Data:
+  * @param  Length:
+  * @return HAL_OK, HAL_ERROR if length is too big or HAL_BUSY if the cache is
+  *         full.
+  */
+HAL_StatusTypeDef EEPROM_WriteBytesDeferred(uint32_t address, void *data, uint8_t length)
+{
+   eeprom_cache_entry_t *entry = NULL;
+   uint8_t idx;
+
+   if(length == 0 || length > sizeof(entry->data))
+   {
+      return HAL_ERROR;
+   }
+
+   for(idx = 0; idx < EEPROM_CACHE_ENTRIES; idx++)
+   {
+      if(eeprom_cache[idx].length != 0 && eeprom_cache[idx].address == address)
+      {
+         entry = &eeprom_cache[idx];
+         break;
+      }
+      if(eeprom_cache[idx].length == 0 && entry == NULL)
+      {
+         entry = &eeprom_cache[idx];
+      }
+   }
+
+   if(entry == NULL)
+   {
+      return HAL_BUSY;
+   }
+
+   memcpy(entry->data, data, length);
+   entry->address = address;
+   entry->length = length;
+   SetEvent(EVENT_EEPROM_PENDING);
+
+   return HAL_OK;
+}
+
+/**
+  * @brief  Writes one entry of the write-back cache into the EEPROM. Must be
+  *         called from the main loop with interrupts enabled, as the write may
+  *         take some ms (or a page transfer on STM32F1xx).
+  * @return true if more entries are pending.
+  */
+bool EEPROM_CommitNext(void)
+{
+   bool    written = false;
+   uint8_t idx;
+
+   for(idx = 0; idx < EEPROM_CACHE_ENTRIES; idx++)
+   {
+      if(eeprom_cache[idx].length != 0)
+      {
+         if(written)
+         {
+            return true;
+         }
+
+         if(EEPROM_WriteBytes(eeprom_cache[idx].address,
+                              eeprom_cache[idx].data,
+                              eeprom_cache[idx].length) != HAL_OK)
+         {
+            // entry stays, try again
+            return true;
+         }
+         eeprom_cache[idx].length = 0;
+         written = true;
+      }
+   }
+
+   return false;
+}
+
+/**
+  * @brief  Writes every pending value into the EEPROM before a reset. Must be
+  *         called from main with interrupts enabled. Gives up after
+  *         EEPROM_COMMIT_PASSES writes, so a failing write can't hang it.
+  * @return true if all values have been written.
+  */
+bool EEPROM_CommitAll(void)
+{
+   uint16_t passes;
+
+   for(passes = 0; passes < EEPROM_COMMIT_PASSES; passes++)
+   {
+      HAL_IWDG_Refresh(&IwdgHandle);
+      if(!CommitNextValue())
+      {
+         return true;
+      }
+   }
+
+   return false;
+}
+
 /**
   * @brief  Toggles a pin (power or reset) if the corresponding flag is set. The
   *         pin will be active between the first and second call of this
@@ -146,7 +295,7 @@ HAL_StatusTypeDef EEPROM_WriteBytes(uint32_t address, void *data, uint8_t length
   */
 void ProcessButtons(void)
 {
-   static flags_t last_flags = {0, 0};
+   static flags_t last_flags = {0};
 
    // if supply voltage is present
    if(DEB_GetKeyState(DEB_USB_SENSE))
@@ -189,6 +338,15 @@ void ProcessButtons(void)
          flags.press_reset_button = 0;
       }
       last_flags.press_reset_button = flags.press_reset_button;
+
+      // wake the host via USB, independent of control_pc_enable
+      if(flags.remote_wakeup)
+      {
+         HAL_PCD_ActivateRemoteWakeup(&hpcd);
+         HAL_Delay(2); // must be active between 1ms and 15ms, so wait 2ms
+         HAL_PCD_DeActivateRemoteWakeup(&hpcd);
+         flags.remote_wakeup = 0;
+      }
    }
 }
 
@@ -213,98 +371,214 @@ bool IRMP_DataIsEqual(IRMP_DATA* irmp_data_1, IRMP_DATA* irmp_data_2)
    }
 }
 
-  /**
-  * @brief  Forwards received IR data over USB (and IR diode if enabled).
+/**
+  * @brief  Closes the echo windows of frames sent IRSND_ECHO_TAIL ms ago and
+  *         starts the tail of the window of a frame that has been sent.
+  */
+static void IRSND_UpdateEchoWindows(void)
+{
+   uint32_t now = HAL_GetTick();
+   uint8_t  i;
+
+   for(i = 0; i < IRSND_ECHO_WINDOWS; i++)
+   {
+      if(!irsnd_echo[i].open)
+      {
+         continue;
+      }
+
+      if(irsnd_echo[i].sending)
+      {
+         if(!irsnd_is_busy())
+         {
+            irsnd_echo[i].sending = false;
+            irsnd_echo[i].end = now + IRSND_ECHO_TAIL;
+         }
+      }
+      else if((int32_t)(now - irsnd_echo[i].end) >= 0)
+      {
+         irsnd_echo[i].open = false;
+      }
+   }
+}
+
+/**
+  * @brief  Opens the echo window of a frame IRSND starts to send, the window
+  *         of the frame before stays open until its tail has passed.
+  * @param  *irmp_data is the IR data to be sent.
+  */
+static void IRSND_OpenEchoWindow(IRMP_DATA* irmp_data)
+{
+   IRSND_UpdateEchoWindows();
+
+   irsnd_echo_idx = (irsnd_echo_idx + 1) % IRSND_ECHO_WINDOWS;
+   memcpy(&irsnd_echo[irsnd_echo_idx].data, irmp_data, sizeof(*irmp_data));
+   irsnd_echo[irsnd_echo_idx].sending = true;
+   irsnd_echo[irsnd_echo_idx].open = true;
+}
+
+/**
+  * @brief  Checks whether received IR data is the echo of a frame sent by
+  *         IRSND, as IRMP keeps receiving while IRSND sends. This also drops
+  *         the rest of a frame repeated by the remote that is forwarded.
   * @param  *irmp_data is the received IR data.
+  * @return true if it equals a frame that is being sent or was sent less
+  *         than IRSND_ECHO_TAIL ms ago.
+  */
+static bool IRMP_IsEcho(IRMP_DATA* irmp_data)
+{
+   uint8_t i;
+
+   IRSND_UpdateEchoWindows();
+
+   for(i = 0; i < IRSND_ECHO_WINDOWS; i++)
+   {
+      if(irsnd_echo[i].open && IRMP_DataIsEqual(irmp_data, &irsnd_echo[i].data))
+      {
+         return true;
+      }
+   }
+
+   return false;
+}
+
+/**
+  * @brief  Sends an IR code report to the host.
+  * @param  *irmp_data is the IR data, flags included.
   */
-void IRMP_ForwardData(IRMP_DATA* irmp_data)
+static void IRMP_SendReport(IRMP_DATA* irmp_data)
 {
-   static uint8_t    repeat_ctr = 0;
    uint8_t tx_buffer[USBD_CUSTOMHID_INREPORT_BUF_SIZE];
 
-   if( !(irmp_data->flags & IRMP_FLAG_REPETITION) )
+   // copy data and ID to buffer
+   memcpy((void*)&tx_buffer[1], irmp_data, sizeof(*irmp_data));
+   tx_buffer[0] = 1;
+
+   // queue the report, it is copied so tx_buffer may go out of scope
+   USBD_CUSTOM_HID_SendReport(&USBD_Device, tx_buffer, sizeof(*irmp_data)+1);
+}
+
+/**
+  * @brief  Reports the key-up of a held IR code, with REPEAT_FLAG_RELEASE
+  *         to the host and as release of the keyboard interface.
+  * @param  *released is the IR data of the key.
+  */
+static void IRMP_ReleaseKey(IRMP_DATA* released)
+{
+   uint16_t usage;
+   uint8_t  actions = ACTION_Lookup(released, &usage);
+
+   KEYBOARD_Release();
+
+   if( !(actions & ACTION_SUPPRESS) )
    {
-      // new command received, reset counter
-      repeat_ctr = 0;
+      released->flags = REPEAT_FLAG_RELEASE;
+      IRMP_SendReport(released);
    }
-   else
+}
+
+/**
+  * @brief  Forwards received IR data over USB (and IR diode if enabled).
+  *         Repetition frames are shaped by the REPEAT module, see
+  *         repeat.h.
+  * @param  *irmp_data is the received IR data.
+  * @param  actions: ACTION_xxx bits of the code, ACTION_SUPPRESS drops the
+  *         report, ACTION_FORWARD sends it via IRSND and ACTION_KEY or
+  *         ACTION_CONSUMER presses the key of the usage.
+  * @param  usage: HID usage of the code for the keyboard interface.
+  */
+void IRMP_ForwardData(IRMP_DATA* irmp_data, uint8_t actions, uint16_t usage)
+{
+   IRMP_DATA released;
+   uint8_t   events = REPEAT_Frame(irmp_data, HAL_GetTick(), &released);
+
+   // another key was held until now
+   if(events & REPEAT_UP)
    {
-      // still the same command, increase counter
-      repeat_ctr++;
+      IRMP_ReleaseKey(&released);
    }
 
-   // only send interrupt if first command, or counter >= MinRepeats
-   if( (repeat_ctr == 0) || (repeat_ctr >= hidirt_data.min_ir_repeats) )
+   // key-down or a repeat that is due, the other repetitions are dropped
+   if(events & (REPEAT_DOWN | REPEAT_REPEAT))
    {
-      // check if last transfer was completed
-//      if(PrevXferComplete) // todo check if necessary!
+      if( !(actions & ACTION_SUPPRESS) )
       {
-         // copy data and ID to buffer
-         memcpy((void*)&tx_buffer[1], irmp_data, sizeof(*irmp_data));
-         tx_buffer[0] = 1;
-
-         // write the descriptor through the endpoint
-         USBD_CUSTOM_HID_SendReport(&USBD_Device, tx_buffer, sizeof(*irmp_data)+1);
-         PrevXferComplete = 0;
+         IRMP_SendReport(irmp_data);
       }
 
-      if(repeat_ctr >= hidirt_data.min_ir_repeats)
+      if(actions & (ACTION_KEY | ACTION_CONSUMER))
       {
-         // fix overflow for very long key push
-         repeat_ctr = hidirt_data.min_ir_repeats;
+         if(!REPEAT_HasKeyUp())
+         {
+            // press and release, the keyboard endpoint queues both reports
+            KEYBOARD_Press(actions, usage);
+            KEYBOARD_Release();
+         }
+         else if(events & REPEAT_DOWN)
+         {
+            // held until key-up, the host repeats the key itself
+            KEYBOARD_Press(actions, usage);
+         }
       }
    }
 
-   // if usage of IRSND is enabled to forward IR codes
-   if(hidirt_data.forward_ir_enable)
+   // if usage of IRSND is enabled to forward IR codes, IRSND can't send
+   // learned ones, every frame is sent so the receiver sees the remote's
+   // own repetitions
+   if( (hidirt_data.forward_ir_enable || (actions & ACTION_FORWARD)) &&
+       irmp_data->protocol != LEARN_PROTOCOL )
    {
       // write command to FIFO from where it will be sent later
-      FIFO_Write(&irsnd_fifo, (fifo_entry_t*)&irmp_data);
+      FIFO_Write(&irsnd_fifo, (fifo_entry_t*)irmp_data);
    }
 }
 
 /**
   * @brief  Processes received IR data.
-  *         Initiates pin toggling (power/ reset) and stores
-  *         power-on- and power-off IR codes when necessary.
+  *         Carries out the actions of the code in the action table, like
+  *         pin toggling (power/ reset), and stores the first code received
+  *         as power-on- and power-off IR code when necessary.
   * @param  *irmp_data is the received IR data to process.
   */
 void IRMP_ProcessData(IRMP_DATA* irmp_data)
 {
    static uint8_t reset_ctr = 0;
+   uint16_t usage;
+   uint8_t actions = ACTION_Lookup(irmp_data, &usage);
 
-   // if code is not yet trained
-   if( (hidirt_data.irmp_power_on.protocol == 0x00) || (hidirt_data.irmp_power_on.protocol == 0xFF) )
+   // if code is not yet trained (and the table has room for it)
+   if( ( (hidirt_data.irmp_power_on.protocol == 0x00) || (hidirt_data.irmp_power_on.protocol == 0xFF) ) &&
+       ACTION_Assign(irmp_data, ACTION_POWER_ON) )
    {
-      // update trained code
-      memcpy(&hidirt_data.irmp_power_on, irmp_data, sizeof(hidirt_data.irmp_power_on));
-      EEPROM_WriteBytes(ADDRESS_irmp_power_on, irmp_data, sizeof(*irmp_data));
-
       if( (hidirt_data.irmp_power_off.protocol == 0x00) || (hidirt_data.irmp_power_off.protocol == 0xFF) )
       {
          // update trained code
-         memcpy(&hidirt_data.irmp_power_off, irmp_data, sizeof(hidirt_data.irmp_power_off));
-         EEPROM_WriteBytes(ADDRESS_irmp_power_off, irmp_data, sizeof(*irmp_data));
+         ACTION_Assign(irmp_data, ACTION_POWER_OFF);
       }
+      GetActionCodes();
+      PublishHidirtConfig();
    }
    else // code is already trained
    {
-      IRMP_ForwardData(irmp_data);
+      IRMP_ForwardData(irmp_data, actions, usage);
 
-      // compare trained codes with last received code
-      // if PC is not running and irmp_data is equal to irmp_power_on
-      // or PC is running and irmp_data is equal to irmp_power_off
-      if( ( IRMP_DataIsEqual(irmp_data, &hidirt_data.irmp_power_on) &&
-            !DEB_GetKeyState(DEB_PSU_SENSE) ) ||
-          ( IRMP_DataIsEqual(irmp_data, &hidirt_data.irmp_power_off) &&
-            DEB_GetKeyState(DEB_PSU_SENSE) ) )
+      // if PC is not running and the code powers it on
+      // or PC is running and the code powers it off
+      if( ( (actions & ACTION_POWER_ON) && !DEB_GetKeyState(DEB_PSU_SENSE) ) ||
+          ( (actions & ACTION_POWER_OFF) && DEB_GetKeyState(DEB_PSU_SENSE) ) )
       {
          flags.press_power_button = 1;
       }
+
+      // wake the host once per key press
+      if( (actions & ACTION_WAKEUP) && !(irmp_data->flags & IRMP_FLAG_REPETITION) )
+      {
+         flags.remote_wakeup = 1;
+      }
    }
 
    // if reset key was pressed
-   if( IRMP_DataIsEqual(irmp_data, &hidirt_data.irmp_reset) )
+   if(actions & ACTION_RESET)
    {
       // don't count repeated codes
       if( !(irmp_data->flags & IRMP_FLAG_REPETITION) )
@@ -332,15 +606,24 @@ void IRMP_ProcessData(IRMP_DATA* irmp_data)
   */
 void IRSND_ProcessData(void)
 {
-   IRMP_DATA irmp_data;
+   fifo_entry_t* entry;
+
+   // called on EVENT_IRSND_DONE, so the tail of the echo window starts when
+   // the frame has been sent, not at the next frame received
+   IRSND_UpdateEchoWindows();
 
    // if IRSND is ready to transmit a command
    if( !irsnd_is_busy() )
    {
-      // if there's a command to be sent
-      if( FIFO_Read(&irsnd_fifo, (fifo_entry_t*)&irmp_data) )
+      // if there's a command to be sent, IRSND copies it so it can be released
+      if( (entry = FIFO_Peek(&irsnd_fifo)) != NULL )
       {
-         irsnd_send_data(&irmp_data, false);
+         IRSND_OpenEchoWindow(&entry->data);
+         irsnd_send_data(&entry->data, false);
+         FIFO_Release(&irsnd_fifo);
+#if IRMP_USE_EDGE_CAPTURE == 1
+         IRSND_StartTimer();
+#endif
       }
    }
 }
@@ -359,6 +642,7 @@ void FullSecond(void)
   */
 void Alarm1(uint8_t idx)
 {
+   UNUSED(idx);
    flags.alarm_a_occurred = SET;
 }
 
@@ -367,6 +651,7 @@ void Alarm1(uint8_t idx)
   */
 void Alarm2(uint8_t idx)
 {
+   UNUSED(idx);
    flags.alarm_b_occurred = SET;
 }
 
@@ -408,6 +693,79 @@ void RTC_HandleInterruptFlags(void)
    }
 }
 
+/**
+  * @brief  Signals events to the main loop. May be called from any ISR.
+  * @param  event: one or more EVENT_* flags.
+  */
+void SetEvent(uint32_t event)
+{
+   // exclusive access instead of masking, the IR interrupts call this too
+   do
+   {
+      event |= __LDREXW(&events);
+   } while(__STREXW(event, &events));
+}
+
+/**
+  * @brief  Puts the core to sleep until at least one event is pending. The
+  *         time spent sleeping is added to idle_cycles.
+  * @return Pending events, which are cleared.
+  */
+static uint32_t WaitForEvents(void)
+{
+   uint32_t pending;
+   uint32_t start;
+
+   __disable_irq();
+   while(events == 0)
+   {
+      start = DWT->CYCCNT;
+      /* a pending interrupt ends WFI even though PRIMASK is set, so an event
+         set after the check above cannot be missed */
+      __DSB();
+      __WFI();
+      idle_cycles += DWT->CYCCNT - start;
+      /* let the interrupt that woke us up run */
+      __enable_irq();
+      __disable_irq();
+   }
+   pending = events;
+   events = 0;
+   __enable_irq();
+
+   return pending;
+}
+
+/**
+  * @brief  Finishes the current measuring interval of the CPU load. Called on
+  *         every RTC wakeup.
+  */
+static void UpdateCpuLoad(void)
+{
+   uint32_t now = DWT->CYCCNT;
+
+   ATOMIC_BLOCK_CRITICAL
+   {
+      cpu_load.idle_cycles = idle_cycles;
+      cpu_load.total_cycles = now - interval_start;
+   }
+   idle_cycles = 0;
+   interval_start = now;
+}
+
+/**
+  * @brief  Allows other modules to read the CPU load of the last RTC wakeup
+  *         interval.
+  * @param  *load holds idle and total cycles afterwards.
+  */
+void GetCpuLoad(cpu_load_t* load)
+{
+   ATOMIC_BLOCK_CRITICAL
+   {
+      memcpy(load, &cpu_load, sizeof(*load));
+   }
+}
+
 /**
   * @brief  Recovers settings after startup (power-up or reset).
   */
@@ -432,26 +790,36 @@ void InitHidirtConfig(void)
                     &hidirt_data.forward_ir_enable,
                     sizeof(hidirt_data.forward_ir_enable));
 
-   EEPROM_ReadBytes(ADDRESS_irmp_power_on,
-                    &hidirt_data.irmp_power_on,
-                    sizeof(hidirt_data.irmp_power_on));
-
-   EEPROM_ReadBytes(ADDRESS_irmp_power_off,
-                    &hidirt_data.irmp_power_off,
-                    sizeof(hidirt_data.irmp_power_off));
-
-   EEPROM_ReadBytes(ADDRESS_irmp_reset,
-                    &hidirt_data.irmp_reset,
-                    sizeof(hidirt_data.irmp_reset));
+   // the action table has been loaded before
+   GetActionCodes();
 
    EEPROM_ReadBytes(ADDRESS_min_ir_repeats,
                     &hidirt_data.min_ir_repeats,
                     sizeof(hidirt_data.min_ir_repeats));
 
+   // an erased EEPROM reads as 0, which forwards repetitions as before and
+   // disables key-up events
+   EEPROM_ReadBytes(ADDRESS_repeat_shaping,
+                    &hidirt_data.repeat,
+                    sizeof(hidirt_data.repeat));
+   REPEAT_SetConfig(hidirt_data.min_ir_repeats, &hidirt_data.repeat);
+
    EEPROM_ReadBytes(ADDRESS_wakeup_time_span,
                     &hidirt_data.wakeup_time_span,
                     sizeof(hidirt_data.wakeup_time_span));
 
+   // an erased EEPROM reads as 0, which enables all protocols
+   EEPROM_ReadBytes(ADDRESS_protocol_mask,
+                    &hidirt_data.protocol_mask,
+                    sizeof(hidirt_data.protocol_mask));
+   irmp_set_protocol_mask(hidirt_data.protocol_mask ? hidirt_data.protocol_mask : IRMP_ALL_PROTOCOLS);
+
+   // patched into the configuration descriptor before the host reads it
+   EEPROM_ReadBytes(ADDRESS_polling_interval,
+                    &hidirt_data.polling_interval,
+                    sizeof(hidirt_data.polling_interval));
+   USBD_CUSTOM_HID_SetPollingInterval(hidirt_data.polling_interval);
+
    // either restore the old wakeup time or wake the PC (in 3 seconds) to
    // retrieve a new one
    if(HAL_RTCEx_BKUPRead(&RtcHandle, BACKUP_REG_RESET) == BACKUP_INIT_PATTERN)
@@ -464,18 +832,65 @@ void InitHidirtConfig(void)
    }
    // set the time-span accordingly
    SWRTC_SetAlarmTime(1, SWRTC_GetAlarmTime(0) + hidirt_data.wakeup_time_span*60);
+
+   PublishHidirtConfig();
+}
+
+/**
+  * @brief  Makes changes of hidirt_data visible to GetHidirtConfig(). Must
+  *         only be called from main, which is the only writer.
+  */
+static void PublishHidirtConfig(void)
+{
+   hidirt_data_seq++;   // odd: readers use snapshot 1
+   __DMB();
+   memcpy(&hidirt_data_snapshot[0], &hidirt_data, sizeof(hidirt_data));
+   __DMB();
+   hidirt_data_seq++;   // even: readers use snapshot 0
+   __DMB();
+   memcpy(&hidirt_data_snapshot[1], &hidirt_data, sizeof(hidirt_data));
+}
+
+/**
+  * @brief  Updates the power on, power off and reset codes of hidirt_data
+  *         from the action table. PublishHidirtConfig() must be called
+  *         afterwards.
+  */
+static void GetActionCodes(void)
+{
+   ACTION_GetCode(ACTION_POWER_ON, &hidirt_data.irmp_power_on);
+   ACTION_GetCode(ACTION_POWER_OFF, &hidirt_data.irmp_power_off);
+   ACTION_GetCode(ACTION_RESET, &hidirt_data.irmp_reset);
+}
+
+/**
+  * @brief  Writes one changed config field, action table entry or template
+  *         into the EEPROM, config fields first.
+  * @return true if more values are pending.
+  */
+static bool CommitNextValue(void)
+{
+   return EEPROM_CommitNext() || ACTION_Commit() || LEARN_Commit();
 }
 
 /**
   * @brief  Allows other modules to read the main data struct holding the
-  *         configuration.
+  *         configuration. Interrupts stay enabled, an interrupt preempting
+  *         PublishHidirtConfig() reads the snapshot that is not being
+  *         written, so it never has to wait for main.
   * @param  *config holds the configuration afterwards.
   */
 void GetHidirtConfig(hidirt_data_t* config)
 {
-   __disable_irq();
-   memcpy(config, &hidirt_data, sizeof(*config));
-   __enable_irq();
+   uint32_t seq;
+
+   do
+   {
+      seq = hidirt_data_seq;
+      __DMB();
+      memcpy(config, &hidirt_data_snapshot[seq & 1], sizeof(*config));
+      __DMB();
+   } while(seq != hidirt_data_seq);
 }
 
 void hidirt_init(void)
@@ -494,9 +909,18 @@ void hidirt_init(void)
    HAL_FLASH_Lock();
 #endif
 
+   /* Find the records of learned templates */
+   STORE_Init();
+
+   /* Load the action table, moves the codes of older firmware into it */
+   ACTION_Init();
+
    /* Initialize config data */
    InitHidirtConfig();
 
+   /* Load templates of learned remotes */
+   LEARN_Init();
+
    /* Configure the unused and used GPIOs */
    GPIO_ConfigAsAnalog();
    GPIO_Configuration();
@@ -512,6 +936,19 @@ void hidirt_init(void)
    /* Initialize infrared interface */
    irmp_init();
    irsnd_init();
+#if IRSND_USE_DMA == 1
+   IRSND_DMAInit();
+#endif
+#if IRMP_USE_EDGE_CAPTURE == 1
+   IRMP_EdgeCaptureInit();
+#endif
+
+   /* Enable cycle counter for the CPU load measurement, it keeps running
+      while the core sleeps */
+   CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+   DWT->CYCCNT = 0;
+   DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+   interval_start = DWT->CYCCNT;
 
    /* Enable interrupts */
    __enable_irq();
@@ -536,6 +973,28 @@ void hidirt_init(void)
 void hidirt(void)
 {
    IRMP_DATA irmp_data;
+   uint32_t  pending;
+
+   /* Sleep until an ISR or USB callback signals an event */
+   pending = WaitForEvents();
+
+   /* Update values retrieved via USB to work with it */
+   if(pending & EVENT_CONFIG_UPDATE)
+   {
+      GetHidirtShadowConfig(&hidirt_data);
+      PublishHidirtConfig();
+      REPEAT_SetConfig(hidirt_data.min_ir_repeats, &hidirt_data.repeat);
+   }
+
+   /* Update the action table */
+   if(pending & EVENT_ACTION)
+   {
+      if(ACTION_Process())
+      {
+         GetActionCodes();
+         PublishHidirtConfig();
+      }
+   }
 
    /* Determine whether host is running and watchdog is enabled */
    if(DEB_GetKeyState(DEB_PSU_SENSE) && hidirt_data.watchdog_enable == TRUE)
@@ -547,6 +1006,7 @@ void hidirt(void)
          HAL_IWDG_Refresh(&IwdgHandle);
          /* Reset flag */
          hidirt_data.watchdog_reset = FALSE;
+         PublishHidirtConfig();
       }
    }
    /* Host is NOT running or watchdog (keepalive) is disabled */
@@ -556,21 +1016,66 @@ void hidirt(void)
       HAL_IWDG_Refresh(&IwdgHandle);
    }
 
-   /* Check if new IR code was received */
-   if(irmp_get_data(&irmp_data))
+   /* Process all IR codes received since the last call */
+   if(pending & EVENT_IR_RECEIVED)
+   {
+      while(irmp_get_data(&irmp_data))
+      {
+         LEARN_Decoded();
+
+         /* IR signal decoded, process it unless it is an echo of IRSND */
+         if(!IRMP_IsEcho(&irmp_data))
+         {
+            IRMP_ProcessData(&irmp_data);
+         }
+      }
+   }
+
+   /* Release a held IR key whose repetitions have stopped */
+   if(pending & EVENT_REPEAT)
+   {
+      if(REPEAT_Poll(HAL_GetTick(), &irmp_data) & REPEAT_UP)
+      {
+         IRMP_ReleaseKey(&irmp_data);
+      }
+   }
+
+   /* Learn or match frames IRMP could not decode */
+   if(pending & EVENT_LEARN)
    {
-      /* IR signal decoded, process it */
-      IRMP_ProcessData(&irmp_data);
+      while(LEARN_Process(&irmp_data))
+      {
+         IRMP_ProcessData(&irmp_data);
+      }
    }
 
-   /* Process IRSND data */
-   IRSND_ProcessData();
+   /* Process IRSND data (received IR codes may have been forwarded) */
+   if(pending & (EVENT_IR_RECEIVED | EVENT_IRSND_QUEUED | EVENT_IRSND_DONE))
+   {
+      IRSND_ProcessData();
+   }
+
+   /* Stream captured IR input to the host */
+   if(pending & EVENT_CAPTURE)
+   {
+      CAPTURE_Process();
+   }
 
    /* Handle periodic tasks (when a RTC wakeup interrupt or alarm occurs) */
-   RTC_HandleInterruptFlags();
+   if(pending & EVENT_RTC_WAKEUP)
+   {
+      RTC_HandleInterruptFlags();
+      UpdateCpuLoad();
+   }
 
-   /* Update values retrieved via USB to work with it */
-   GetHidirtShadowConfig(&hidirt_data);
+   /* Write one changed value into the EEPROM, come back for the next one */
+   if(pending & EVENT_EEPROM_PENDING)
+   {
+      if(CommitNextValue())
+      {
+         SetEvent(EVENT_EEPROM_PENDING);
+      }
+   }
 
 #if defined(USE_BACKUP_SUPPLY)
    /* Enter and stay in standby mode as long as USB voltage is not present */
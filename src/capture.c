@@ -0,0 +1,276 @@
+/**
+ * @file       capture.c
+ * @brief      Module for streaming the raw IR input to the host.
+ * @see        capture.h for the stream format and the flow control.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "capture.h"
+#include "irmp.h"
+#include "application.h"
+#include "configuration.h"
+#include "cm_atomic.h"
+#include "usbd_customhid_if.h"
+#include "global_variables.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct CAPTURE
+{
+   volatile uint16_t write;         /* free-running, written by the IR ISR */
+   volatile uint16_t read;          /* free-running, written by main */
+   volatile uint16_t flush;         /* write index of the last burst end */
+   volatile uint16_t credits;       /* reports granted by the host */
+   volatile bool     enabled;       /* IR ISR stores runs */
+   volatile bool     request;       /* enable requested by the host */
+   volatile bool     waiting;       /* data left, IN queue was full */
+   bool              overrun;       /* runs dropped, 0x00 is due */
+   bool              idle;          /* burst ended, pause not counted */
+   uint8_t           level;         /* level of the current run */
+   uint16_t          ticks;         /* length of the current run */
+   uint8_t           sequence;      /* of the next report */
+} capture_t;
+
+/* Private define ------------------------------------------------------------*/
+#define CAPTURE_BUF_SIZE      256   /* 2^n, about 150 ms of dense input */
+#define CAPTURE_DATA_SIZE     (CAPTURE_REPORT_SIZE-2)
+#define CAPTURE_IDLE_TICKS    ((uint16_t)(F_INTERRUPTS * 150.0e-3 + 0.5))  /* like
+                                     IRMP_KEY_REPETITION_LEN, frames further
+                                     apart are no repetitions */
+#define CAPTURE_IN_RESERVE    2     /* IN queue slots kept free for IR codes */
+#define CAPTURE_MAX_CREDITS   255
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static capture_t capture;
+static uint8_t   capture_buf[CAPTURE_BUF_SIZE];   /* varints of the runs */
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Appends one run to the ring, or drops it if it doesn't fit. Only
+  *         called from the IR ISR.
+  * @param  level: 0 for a pulse, 1 for a pause
+  * @param  ticks: length of the run
+  */
+static void CAPTURE_Store(uint8_t level, uint16_t ticks)
+{
+   uint32_t value = ((uint32_t)ticks << 1) | level;
+   uint16_t write = capture.write;
+   uint16_t used = write - capture.read;
+   uint8_t  varint[3];
+   uint8_t  len = 0;
+   uint8_t  i;
+
+   do
+   {
+      varint[len] = value & 0x7F;
+      value >>= 7;
+      if(value)
+      {
+         varint[len] |= 0x80;
+      }
+      len++;
+   } while(value);
+
+   if(CAPTURE_BUF_SIZE - used < len + capture.overrun)
+   {
+      capture.overrun = true;
+      return;
+   }
+
+   if(capture.overrun)
+   {
+      capture_buf[write++ % CAPTURE_BUF_SIZE] = 0x00;
+      capture.overrun = false;
+   }
+
+   for(i = 0; i < len; i++)
+   {
+      capture_buf[write++ % CAPTURE_BUF_SIZE] = varint[i];
+   }
+
+   __DMB();
+   capture.write = write;
+
+   // wake main when a report can be filled
+   if(used < CAPTURE_DATA_SIZE && (uint16_t)(write - capture.read) >= CAPTURE_DATA_SIZE)
+   {
+      SetEvent(EVENT_CAPTURE);
+   }
+}
+
+/**
+  * @brief  Starts or stops capturing as requested by the host. The ring is
+  *         only reset while the IR ISR doesn't store runs.
+  */
+static void CAPTURE_Apply(void)
+{
+   bool request = capture.request;
+
+   if(request == capture.enabled)
+   {
+      return;
+   }
+
+   if(request)
+   {
+      capture.read = 0;
+      capture.write = 0;
+      capture.flush = 0;
+      capture.overrun = false;
+      capture.idle = true;       // start with the first pulse
+      capture.level = 1;
+      capture.ticks = 0;
+      __DMB();
+      capture.enabled = true;
+   }
+   else
+   {
+      capture.enabled = false;
+      __DMB();
+      capture.flush = capture.write;   // send the rest
+   }
+}
+
+/* Public functions ----------------------------------------------------------*/
+/**
+  * @brief  Handles REP_ID_CAPTURE_CONTROL, called from the USB interrupt.
+  * @param  enable: capture on or off
+  * @param  credits: number of reports the host can take in addition
+  */
+void CAPTURE_Control(bool enable, uint8_t credits)
+{
+   uint16_t sum = capture.credits + credits;
+
+   capture.credits = (sum < CAPTURE_MAX_CREDITS) ? sum : CAPTURE_MAX_CREDITS;
+   capture.request = enable;
+   SetEvent(EVENT_CAPTURE);
+}
+
+/**
+  * @brief  Fills REP_ID_CAPTURE_CONTROL, called from the USB interrupt.
+  * @param  *control holds enable and the credits left afterwards.
+  */
+void CAPTURE_GetControl(uint8_t *control)
+{
+   control[0] = capture.enabled;
+   control[1] = capture.credits;
+}
+
+/**
+  * @brief  Passes a pulse or pause of the IR input, called from the IR ISR
+  *         once per tick or per edge. Consecutive calls with the same level
+  *         are merged into one run.
+  * @param  input: IR input level, 0 for a pulse
+  * @param  ticks: length of the level
+  */
+void CAPTURE_Put(uint8_t input, uint16_t ticks)
+{
+   if(!capture.enabled)
+   {
+      return;
+   }
+
+   input = (input != 0);
+   if(input != capture.level)
+   {
+      if(!capture.idle)
+      {
+         CAPTURE_Store(capture.level, capture.ticks);
+      }
+      capture.level = input;
+      capture.ticks = 0;
+      capture.idle = false;
+   }
+   else if(capture.idle)
+   {
+      return;
+   }
+
+   capture.ticks = (ticks < 0xFFFF - capture.ticks) ? capture.ticks + ticks : 0xFFFF;
+
+   // end of a burst: send the pause now instead of at the next pulse
+   if(capture.level && capture.ticks >= CAPTURE_IDLE_TICKS)
+   {
+      CAPTURE_Store(1, CAPTURE_IDLE_TICKS);
+      capture.idle = true;
+      capture.flush = capture.write;
+      SetEvent(EVENT_CAPTURE);
+   }
+}
+
+/**
+  * @brief  Applies requests of the host and sends the stored runs, as long as
+  *         the host has granted reports and the IN queue has room. Full
+  *         reports are sent first, the rest at the end of a burst.
+  */
+void CAPTURE_Process(void)
+{
+   uint8_t  report[1+CAPTURE_REPORT_SIZE];
+   uint16_t read;
+   uint16_t count;
+   uint16_t i;
+
+   // may reset the ring, so the read index is loaded afterwards
+   CAPTURE_Apply();
+   read = capture.read;
+
+   while(capture.credits > 0)
+   {
+      count = capture.write - read;
+      if(count >= CAPTURE_DATA_SIZE)
+      {
+         count = CAPTURE_DATA_SIZE;
+      }
+      else if(count == 0 || (int16_t)(capture.flush - read) <= 0)
+      {
+         break;   // nothing, or part of a report before the burst has ended
+      }
+
+      // set before the check, so a report sent meanwhile wakes main
+      capture.waiting = true;
+      __DMB();
+      if(USBD_CUSTOM_HID_GetInQueueSpace() <= CAPTURE_IN_RESERVE)
+      {
+         break;
+      }
+      capture.waiting = false;
+
+      __DMB();
+      memset(report, 0, sizeof(report));
+      report[0] = REP_ID_CAPTURE_DATA;
+      report[1] = capture.sequence;
+      report[2] = count;
+      for(i = 0; i < count; i++)
+      {
+         report[3+i] = capture_buf[read++ % CAPTURE_BUF_SIZE];
+      }
+
+      if(USBD_CUSTOM_HID_SendReport(&USBD_Device, report, sizeof(report)) != USBD_OK)
+      {
+         break;   // not configured, keep the data
+      }
+
+      __DMB();
+      capture.read = read;
+      capture.sequence++;
+      ATOMIC_BLOCK_CRITICAL
+      {
+         capture.credits--;
+      }
+   }
+}
+
+/**
+  * @brief  Called from the USB interrupt when an IN report has been sent,
+  *         lets main continue sending stored runs.
+  */
+void USBD_CUSTOM_HID_InSentCallback(void)
+{
+   if(capture.waiting)
+   {
+      capture.waiting = false;
+      SetEvent(EVENT_CAPTURE);
+   }
+}
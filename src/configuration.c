@@ -20,14 +20,79 @@
 #include "application.h"
 #include "main.h"
 #include "global_variables.h"
+#include "capture.h"
+#include "learn.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+#if IRMP_USE_EDGE_CAPTURE == 1
+static uint16_t IrmpLastEdge;   /* timer count at the last IR edge */
+static uint8_t  IrmpLastInput;  /* IR input level since the last IR edge */
+#else
+static volatile uint16_t IrmpIsrLatencyMax; /* worst IR timer ISR entry latency */
+#endif
+
 /* Extern variables ----------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Hides the own IR diode from IRMP, which keeps receiving while
+  *         IRSND sends: the input reads dark while the carrier is on and
+  *         until it has been dark for IRMP_TIMEOUT_LEN ticks afterwards, so
+  *         frames overlapped by a pulse of IRSND are not decoded. Whole
+  *         echoes of a frame are dropped by the application.
+  * @param  input: IR input level
+  * @param  ticks: length of the level
+  * @retval IR input level to pass to IRMP
+  */
+static uint8_t IRMP_HideEcho(uint8_t input, uint16_t ticks)
+{
+   static uint16_t dark = IRMP_TIMEOUT_LEN;   /* ticks dark since the carrier was on */
+
+   if(irsnd_is_carrier_on())
+   {
+      dark = 0;
+      return 1;
+   }
+
+   if(dark < IRMP_TIMEOUT_LEN)
+   {
+      if(!input)
+      {
+         dark = 0;
+      }
+      else
+      {
+         dark = (ticks < IRMP_TIMEOUT_LEN - dark) ? dark + ticks : IRMP_TIMEOUT_LEN;
+      }
+      return 1;
+   }
+
+   return input;
+}
+
+#if IRMP_USE_EDGE_CAPTURE == 1
+/**
+  * @brief  Passes the length of the current pulse or pause up to the given
+  *         timer count to IRMP.
+  * @param  now: timer count
+  */
+static void IRMP_StoreDuration(uint16_t now)
+{
+   uint16_t ticks = now - IrmpLastEdge;
+   uint8_t  input = IRMP_HideEcho(IrmpLastInput, ticks);
+
+   CAPTURE_Put(IrmpLastInput, ticks);
+   irmp_edge_put(input, ticks);
+   LEARN_Put(input, ticks);
+   SetEvent(EVENT_IR_RECEIVED);   // decoded in irmp_get_data()
+
+   IrmpLastEdge = now;
+}
+#endif
+
 /* Public functions ---------------------------------------------------------*/
 /*******************************************************************************
 * Function Name  : GPIO_ConfigAsAnalog
@@ -232,18 +297,204 @@ void LeaveStopMode(void)
 }
 #endif
 
+#if IRMP_USE_EDGE_CAPTURE == 1
+/**
+  * @brief  Switches IRMP to edge capture. The timer counts IRMP ticks, each
+  *         edge of the IR input stores the length of the previous pulse or
+  *         pause and compare channel 1 flushes a pending pause after
+  *         IRMP_EDGE_TIMEOUT ticks.
+  */
+void IRMP_EdgeCaptureInit(void)
+{
+   GPIO_InitTypeDef GPIO_InitStructure;
+
+   GPIO_InitStructure.Pin = IRMP_BIT;
+   GPIO_InitStructure.Mode = GPIO_MODE_IT_RISING_FALLING;
+   GPIO_InitStructure.Speed = GPIO_SPEED;
+   GPIO_InitStructure.Pull = GPIO_NOPULL;
+   HAL_GPIO_Init(IRMP_PORT, &GPIO_InitStructure);
+
+   IrmpLastInput = HAL_GPIO_ReadPin(IRMP_PORT, IRMP_BIT);
+   IrmpLastEdge = __HAL_TIM_GET_COUNTER(&TimHandle);
+
+   __HAL_TIM_SET_COMPARE(&TimHandle, TIM_CHANNEL_1, IrmpLastEdge + IRMP_EDGE_TIMEOUT);
+   __HAL_TIM_CLEAR_FLAG(&TimHandle, TIM_FLAG_CC1);
+   __HAL_TIM_ENABLE_IT(&TimHandle, TIM_IT_CC1);
+
+   /* same priority as the timer, so that both never interrupt each other */
+   HAL_NVIC_SetPriority(IRMP_EXTI_IRQ, IRQ_PRIO_IR, 1);
+   HAL_NVIC_EnableIRQ(IRMP_EXTI_IRQ);
+}
+
+/**
+  * @brief  Lets compare channel 2 call irsnd_ISR() once per tick until the
+  *         frame has been sent, unless the DMA sends it. Has to be called
+  *         after irsnd_send_data().
+  */
+void IRSND_StartTimer(void)
+{
+#if IRSND_USE_DMA == 1
+   if(irsnd_is_dma_busy())   // IRSND_DMA_IRQ_HANDLER signals the end
+   {
+      return;
+   }
+#endif
+   __HAL_TIM_SET_COMPARE(&TimHandle, TIM_CHANNEL_2, __HAL_TIM_GET_COUNTER(&TimHandle) + 1);
+   __HAL_TIM_CLEAR_FLAG(&TimHandle, TIM_FLAG_CC2);
+   __HAL_TIM_ENABLE_IT(&TimHandle, TIM_IT_CC2);
+}
+
+/**
+  * @brief  This function handles EXTI interrupt request of the IR input.
+  */
+void IRMP_EXTI_IRQ_HANDLER(void)
+{
+   HAL_GPIO_EXTI_IRQHandler(IRMP_BIT);
+}
+
+/**
+  * @brief  EXTI callback: stores the length of the pulse or pause that ended.
+  * @param  GPIO_Pin: pin that caused the interrupt
+  */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+   uint16_t now = __HAL_TIM_GET_COUNTER(&TimHandle);
+   uint8_t input = HAL_GPIO_ReadPin(IRMP_PORT, IRMP_BIT);
+
+   if(input != IrmpLastInput)   // ignore glitches shorter than the IRQ latency
+   {
+      IRMP_StoreDuration(now);
+      IrmpLastInput = input;
+      __HAL_TIM_SET_COMPARE(&TimHandle, TIM_CHANNEL_1, now + IRMP_EDGE_TIMEOUT);
+   }
+}
+
+/**
+  * @brief  This function handles TIMx global interrupt request.
+  */
+void IRMP_IRSND_TIMER_IRQ_HANDLER(void)
+{
+   uint16_t compare;
+
+   if(__HAL_TIM_GET_FLAG(&TimHandle, TIM_FLAG_CC1) != RESET)
+   {
+      __HAL_TIM_CLEAR_FLAG(&TimHandle, TIM_FLAG_CC1);
+
+      /* no edge since the compare value: pass the pause (or pulse) so far and
+       * check again later, skip if an edge has moved the compare value */
+      compare = __HAL_TIM_GET_COMPARE(&TimHandle, TIM_CHANNEL_1);
+      if((uint16_t)(__HAL_TIM_GET_COUNTER(&TimHandle) - IrmpLastEdge) >=
+         (uint16_t)(compare - IrmpLastEdge))
+      {
+         IRMP_StoreDuration(compare);
+         __HAL_TIM_SET_COMPARE(&TimHandle, TIM_CHANNEL_1, compare + 0x7FFF);
+      }
+   }
+
+   if(__HAL_TIM_GET_FLAG(&TimHandle, TIM_FLAG_CC2) != RESET &&
+      __HAL_TIM_GET_IT_SOURCE(&TimHandle, TIM_IT_CC2) != RESET)
+   {
+      __HAL_TIM_CLEAR_FLAG(&TimHandle, TIM_FLAG_CC2);
+      compare = __HAL_TIM_GET_COMPARE(&TimHandle, TIM_CHANNEL_2);
+      __HAL_TIM_SET_COMPARE(&TimHandle, TIM_CHANNEL_2, compare + 1);
+
+      if( !irsnd_ISR() )   // call irsnd ISR
+      {                    // if not busy anymore, stop ticking
+         __HAL_TIM_DISABLE_IT(&TimHandle, TIM_IT_CC2);
+         SetEvent(EVENT_IRSND_DONE);
+      }
+   }
+}
+#else
 /**
   * @brief  This function handles TIMx global interrupt request.
   */
 void IRMP_IRSND_TIMER_IRQ_HANDLER(void)
 {
-   if( !irsnd_ISR() )   // call irsnd ISR
-   {                    // if not busy...
-      irmp_ISR();       // call irmp ISR
+   static uint8_t irsnd_busy = 0;
+   uint8_t input;
+   /* the counter restarted at the update event, so it holds the entry latency */
+   uint16_t latency = __HAL_TIM_GET_COUNTER(&TimHandle);
+
+   if(latency > IrmpIsrLatencyMax)
+   {
+      IrmpIsrLatencyMax = latency;
+   }
+
+   if( irsnd_ISR() )    // call irsnd ISR
+   {
+      irsnd_busy = 1;
+   }
+   else if(irsnd_busy)  // not busy anymore
+   {
+      irsnd_busy = 0;
+      SetEvent(EVENT_IRSND_DONE);
+   }
+
+   input = HAL_GPIO_ReadPin(IRMP_PORT, IRMP_BIT);
+   CAPTURE_Put(input, 1);
+   input = IRMP_HideEcho(input, 1);
+
+   /* call irmp ISR, also while sending */
+   if(irmp_ISR_input(input))
+   {
+      SetEvent(EVENT_IR_RECEIVED);
    }
+   LEARN_Put(input, 1);
 
    __HAL_TIM_CLEAR_FLAG(&TimHandle, TIM_IT_UPDATE);
 }
+#endif
+
+#if IRSND_USE_DMA == 1
+/**
+  * @brief  Enables the interrupt of the IRSND transmit DMA, which refills its
+  *         ring buffer twice per pass.
+  */
+void IRSND_DMAInit(void)
+{
+   /* same priority as the timer, so that both never interrupt each other */
+   HAL_NVIC_SetPriority(IRSND_DMA_IRQ, IRQ_PRIO_IR, 1);
+   HAL_NVIC_EnableIRQ(IRSND_DMA_IRQ);
+}
+
+/**
+  * @brief  This function handles the interrupt of the IRSND transmit DMA.
+  */
+void IRSND_DMA_IRQ_HANDLER(void)
+{
+   if( !irsnd_DMA_ISR() )   // call irsnd DMA ISR
+   {
+#if IRMP_USE_EDGE_CAPTURE == 1
+      /* otherwise the timer interrupt notices the end */
+      SetEvent(EVENT_IRSND_DONE);
+#endif
+   }
+}
+#endif
+
+/**
+  * @brief  Returns the worst entry latency of the IR timer interrupt since the
+  *         last call and restarts the measurement.
+  * @return Latency in timer clock cycles, always 0 with IRMP_USE_EDGE_CAPTURE
+  *         as there is no periodic sampling interrupt then.
+  */
+uint32_t IRMP_GetIsrLatency(void)
+{
+#if IRMP_USE_EDGE_CAPTURE == 1
+   return 0;
+#else
+   uint16_t latency;
+
+   // read and clear without masking the IR timer interrupt
+   do
+   {
+      latency = __LDREXH(&IrmpIsrLatencyMax);
+   } while(__STREXH(0, &IrmpIsrLatencyMax));
+
+   return latency;
+#endif
+}
 
 /**
   * @brief  This function handles RTC Wakeup global interrupt request.
@@ -267,6 +518,7 @@ void RTC_WKUP_IRQHandler(void)
       SWRTC_Service();  // service software RTC
       DEB_Service();    // debounce signals (MUST happen inside ISR)
       flags.wakeup_occurred = 1;
+      SetEvent(EVENT_RTC_WAKEUP);
    }
 
 #if defined(STM32F103xB)
@@ -33,6 +33,12 @@
     #include <avr/interrupt.h>   // for cli() and sei()
     #include <util/atomic.h>     // for ATOMIC_BLOCK(x)
   #endif
+
+  /* only the interrupts sharing data with this module have to be blocked, the
+   * application may define a BASEPRI based block for that */
+  #ifndef ATOMIC_BLOCK_CRITICAL
+    #define ATOMIC_BLOCK_CRITICAL  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  #endif
 #endif
 
 /* Private define ------------------------------------------------------------*/
@@ -165,7 +171,7 @@ void DEB_Service(void)
  */
 debounce_t DEB_GetKeyState(debounce_t key_mask)
 {
-   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   ATOMIC_BLOCK_CRITICAL
    {
       key_mask &= key_state;  // read state
    }
@@ -182,7 +188,7 @@ debounce_t DEB_GetKeyState(debounce_t key_mask)
  */
 debounce_t DEB_GetKeyPress(debounce_t key_mask)
 {
-   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   ATOMIC_BLOCK_CRITICAL
    {
       key_mask &= key_press;  // read state
       key_press ^= key_mask;  // delete read state
@@ -201,7 +207,7 @@ debounce_t DEB_GetKeyPress(debounce_t key_mask)
  */
 debounce_t DEB_GetKeyRelease(debounce_t key_mask)
 {
-   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   ATOMIC_BLOCK_CRITICAL
    {
       key_mask &= key_release;// read state
       key_release ^= key_mask;// delete read state
@@ -222,7 +228,7 @@ debounce_t DEB_GetKeyRelease(debounce_t key_mask)
  */
 debounce_t DEB_GetKeyRepeat(debounce_t key_mask)
 {
-   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   ATOMIC_BLOCK_CRITICAL
    {
       key_mask &= key_rpt;    // read state
       key_rpt ^= key_mask;    // delete read state
@@ -243,7 +249,7 @@ debounce_t DEB_GetKeyRepeat(debounce_t key_mask)
  */
 debounce_t DEB_GetKeyShort(debounce_t key_mask)
 {
-   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   ATOMIC_BLOCK_CRITICAL
    {
       key_mask = DEB_GetKeyPress( ~key_state & key_mask );
    }
@@ -7,59 +7,192 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
 #include <string.h>
 #ifndef FIFO_PREFIX
 #include "fifo.h"
 #else
 #include "fifos.h"
 #endif
+#if defined(USE_HAL_DRIVER)
+  #if defined(STM32F103xB)
+    #include "stm32f1xx_hal.h"
+  #elif defined(STM32L151xB)
+    #include "stm32l1xx_hal.h"
+  #else
+    #error Device not specified.
+  #endif
+#endif
 
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
+#ifndef FIFO_PRIVATE_FUNCTIONS
+#define FIFO_PRIVATE_FUNCTIONS
+/**
+* @brief       Orders the accesses to an entry and its ready flag.
+*/
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+#define FIFO_BARRIER()  __DMB()
+#else
+#define FIFO_BARRIER()  __atomic_thread_fence(__ATOMIC_ACQ_REL)
+#endif
+
+/* Private functions ---------------------------------------------------------*/
+/**
+* @brief       Atomically raises a value to a new maximum.
+* @param[in]   max value to be raised.
+* @param[in]   value that may be the new maximum.
+*/
+static inline void FIFO_AtomicMax(volatile uint16_t* max, uint16_t value)
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+   do
+   {
+      if(__LDREXH(max) >= value)
+      {
+         __CLREX();
+         return;
+      }
+   } while(__STREXH(value, max));
+#else
+   uint16_t old = __atomic_load_n(max, __ATOMIC_RELAXED);
+
+   while(old < value
+         && !__atomic_compare_exchange_n(max, &old, value, true,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+#endif
+}
+
+/**
+* @brief       Atomically reserves up to n consecutive slots starting at the
+*              write index and advances the index by the number of reserved
+*              slots.
+* @param[in]   write index of the FIFO.
+* @param[in]   read index of the FIFO.
+* @param[in]   watermark of the FIFO, raised to the new number of entries.
+* @param[in]   size of the FIFO.
+* @param[in]   n number of slots wanted.
+* @param[out]  slot first reserved slot (free-running).
+* @return      The number of reserved slots, 0 if the FIFO was full.
+*/
+static inline uint16_t FIFO_ReserveSlots(volatile uint16_t* write, volatile uint16_t* read,
+                                         volatile uint16_t* watermark, uint16_t size,
+                                         uint16_t n, uint16_t* slot)
+{
+   uint16_t idx;
+   uint16_t used;
+   uint16_t granted;
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+   // an ISR writing in between clears the exclusive monitor, so STREX fails
+   for(;;)
+   {
+      idx = __LDREXH(write);
+      used = idx - *read;
+      granted = size - used;
+      if(used > size)
+      {
+         // the reader overtook an outdated write index, try again
+         __CLREX();
+         continue;
+      }
+      if(granted == 0)
+      {
+         __CLREX();
+         return 0;
+      }
+      if(granted > n)
+      {
+         granted = n;
+      }
+      if(!__STREXH(idx + granted, write))
+      {
+         break;
+      }
+   }
+#else
+   idx = __atomic_load_n(write, __ATOMIC_RELAXED);
+   for(;;)
+   {
+      used = idx - __atomic_load_n(read, __ATOMIC_ACQUIRE);
+      granted = size - used;
+      if(used > size)
+      {
+         // the reader overtook an outdated write index, try again
+         idx = __atomic_load_n(write, __ATOMIC_RELAXED);
+         continue;
+      }
+      if(granted == 0)
+      {
+         return 0;
+      }
+      if(granted > n)
+      {
+         granted = n;
+      }
+      if(__atomic_compare_exchange_n(write, &idx, (uint16_t)(idx + granted), true,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+      {
+         break;
+      }
+   }
+#endif
+   FIFO_AtomicMax(watermark, used + granted);
+   *slot = idx;
+   return granted;
+}
+#endif /* FIFO_PRIVATE_FUNCTIONS */
+
 /* Private types -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 /**
-* @brief       A variable that holds the mask: that is the FIFO size minus 1.
+* @brief       Variables that hold the size and the mask: that is the FIFO size
+*              minus 1.
 */
 #ifndef FIFO_PREFIX
+static const uint16_t fifo_size = FIFO_SIZE;
 static const uint16_t fifo_mask = FIFO_SIZE-1;
 #else
+static const uint16_t FIFOS(FIFO_PREFIX,fifo_size) = FIFOS(FIFO_PREFIX,FIFO_ELEMENTS);
 static const uint16_t FIFOS(FIFO_PREFIX,fifo_mask) = FIFOS(FIFO_PREFIX,FIFO_ELEMENTS)-1;
 #endif
 
 /* Extern variables ----------------------------------------------------------*/
-/* Private functions ---------------------------------------------------------*/
 /* Extern functions ----------------------------------------------------------*/
 /**
-* @brief       Reads an entry from the FIFO.
+* @brief       Reads an entry from the FIFO. There must be only one reader.
 * @param[in]   fifo from which the data shall be read.
 * @param[out]  entry that was read.
 * @return      Execution state
 *              - \c true if an entry was read successfully
-*              - \c false if the FIFO was empty
+*              - \c false if the FIFO was empty or the oldest entry is still
+*                being written
 */
 #ifndef FIFO_PREFIX
 bool FIFO_Read(fifo_t* fifo, fifo_entry_t* entry)
+{
+   uint16_t idx = fifo->read & fifo_mask;
 #else
 bool FIFOS(FIFO_PREFIX,FIFO_Read)(FIFOS(FIFO_PREFIX,fifo_t)* fifo, FIFOS(FIFO_PREFIX,fifo_entry_t)* entry)
-#endif
 {
-   if(fifo->read == fifo->write)
+   uint16_t idx = fifo->read & FIFOS(FIFO_PREFIX,fifo_mask);
+#endif
+
+   if(!fifo->ready[idx])
    {
       return false;
    }
-#ifndef FIFO_PREFIX
-   memcpy(entry, &fifo->entry[fifo->read], sizeof(fifo_entry_t));
-   fifo->read = (fifo->read + 1) & fifo_mask;
-#else
-   memcpy(entry, &fifo->entry[fifo->read], sizeof(FIFOS(FIFO_PREFIX,fifo_entry_t)));
-   fifo->read = (fifo->read + 1) & FIFOS(FIFO_PREFIX,fifo_mask);
-#endif
+   FIFO_BARRIER();
+   memcpy(entry, &fifo->entry[idx], sizeof(*entry));
+   fifo->ready[idx] = false;
+   FIFO_BARRIER();
+   fifo->read++;
    return true;
 }
 
 /**
-* @brief       Writes an entry into the FIFO.
+* @brief       Writes an entry into the FIFO. May be called by several writers
+*              concurrently, e.g. from main and from ISRs.
 * @param[in]   fifo into which the data shall be written.
 * @param[in]   entry that shall be written.
 * @return      Execution state
@@ -69,40 +202,249 @@ bool FIFOS(FIFO_PREFIX,FIFO_Read)(FIFOS(FIFO_PREFIX,fifo_t)* fifo, FIFOS(FIFO_PR
 #ifndef FIFO_PREFIX
 bool FIFO_Write(fifo_t* fifo, fifo_entry_t* entry)
 {
-   fifo_idx_t next;
-   next = (fifo->write + 1) & fifo_mask;
+   uint16_t idx;
+
+   if(!FIFO_ReserveSlots(&fifo->write, &fifo->read, &fifo->high_watermark,
+                         fifo_size, 1, &idx))
+   {
+      return false;
+   }
+   idx &= fifo_mask;
 #else
 bool FIFOS(FIFO_PREFIX,FIFO_Write)(FIFOS(FIFO_PREFIX,fifo_t)* fifo, FIFOS(FIFO_PREFIX,fifo_entry_t)* entry)
 {
-   FIFOS(FIFO_PREFIX,fifo_idx_t) next;
-   next = (fifo->write + 1) & FIFOS(FIFO_PREFIX,fifo_mask);
-#endif
-   if(fifo->read == next)
+   uint16_t idx;
+
+   if(!FIFO_ReserveSlots(&fifo->write, &fifo->read, &fifo->high_watermark,
+                         FIFOS(FIFO_PREFIX,fifo_size), 1, &idx))
    {
       return false;
    }
-//   memcpy(&fifo->entry[fifo->write], entry, sizeof(entry));
+   idx &= FIFOS(FIFO_PREFIX,fifo_mask);
+#endif
+   memcpy(&fifo->entry[idx], entry, sizeof(*entry));
+   FIFO_BARRIER();
+   fifo->ready[idx] = true;
+   return true;
+}
+
+/**
+* @brief       Reads up to n entries from the FIFO. There must be only one
+*              reader.
+* @param[in]   fifo from which the data shall be read.
+* @param[out]  entries that were read.
+* @param[in]   n maximum number of entries to read.
+* @return      The number of entries read. Reading stops at the first entry
+*              that is still being written.
+*/
 #ifndef FIFO_PREFIX
-   memcpy(&fifo->entry[fifo->write & fifo_mask], entry, sizeof(fifo_entry_t));
+fifo_idx_t FIFO_ReadBulk(fifo_t* fifo, fifo_entry_t* entries, fifo_idx_t n)
+{
+   const uint16_t mask = fifo_mask;
 #else
-   memcpy(&fifo->entry[fifo->write & FIFOS(FIFO_PREFIX,fifo_mask)], entry, sizeof(FIFOS(FIFO_PREFIX,fifo_entry_t)));
+FIFOS(FIFO_PREFIX,fifo_idx_t) FIFOS(FIFO_PREFIX,FIFO_ReadBulk)(FIFOS(FIFO_PREFIX,fifo_t)* fifo, FIFOS(FIFO_PREFIX,fifo_entry_t)* entries, FIFOS(FIFO_PREFIX,fifo_idx_t) n)
+{
+   const uint16_t mask = FIFOS(FIFO_PREFIX,fifo_mask);
 #endif
-   fifo->write = next;
-   return true;
+   uint16_t read = fifo->read;
+   uint16_t idx = read & mask;
+   uint16_t first = mask + 1 - idx;
+   uint16_t count = 0;
+   uint16_t i;
+
+   // a full FIFO has all flags set, don't scan past its size
+   if(n > mask + 1)
+   {
+      n = mask + 1;
+   }
+   while(count < n && fifo->ready[(read + count) & mask])
+   {
+      count++;
+   }
+   if(count == 0)
+   {
+      return 0;
+   }
+   FIFO_BARRIER();
+
+   // copy in at most two parts if the entries wrap around the end
+   if(count <= first)
+   {
+      memcpy(entries, &fifo->entry[idx], count * sizeof(*entries));
+   }
+   else
+   {
+      memcpy(entries, &fifo->entry[idx], first * sizeof(*entries));
+      memcpy(&entries[first], &fifo->entry[0], (count - first) * sizeof(*entries));
+   }
+   for(i = 0; i < count; i++)
+   {
+      fifo->ready[(read + i) & mask] = false;
+   }
+   FIFO_BARRIER();
+   fifo->read = read + count;
+   return count;
+}
+
+/**
+* @brief       Writes up to n entries into the FIFO as one consecutive block.
+*              May be called by several writers concurrently.
+* @param[in]   fifo into which the data shall be written.
+* @param[in]   entries that shall be written.
+* @param[in]   n number of entries to write.
+* @return      The number of entries stored, less than n if the FIFO became
+*              full.
+*/
+#ifndef FIFO_PREFIX
+fifo_idx_t FIFO_WriteBulk(fifo_t* fifo, fifo_entry_t* entries, fifo_idx_t n)
+{
+   const uint16_t mask = fifo_mask;
+#else
+FIFOS(FIFO_PREFIX,fifo_idx_t) FIFOS(FIFO_PREFIX,FIFO_WriteBulk)(FIFOS(FIFO_PREFIX,fifo_t)* fifo, FIFOS(FIFO_PREFIX,fifo_entry_t)* entries, FIFOS(FIFO_PREFIX,fifo_idx_t) n)
+{
+   const uint16_t mask = FIFOS(FIFO_PREFIX,fifo_mask);
+#endif
+   uint16_t slot;
+   uint16_t idx;
+   uint16_t first;
+   uint16_t count;
+   uint16_t i;
+
+   count = FIFO_ReserveSlots(&fifo->write, &fifo->read, &fifo->high_watermark,
+                             mask + 1, n, &slot);
+   if(count == 0)
+   {
+      return 0;
+   }
+   idx = slot & mask;
+   first = mask + 1 - idx;
+
+   // copy in at most two parts if the slots wrap around the end
+   if(count <= first)
+   {
+      memcpy(&fifo->entry[idx], entries, count * sizeof(*entries));
+   }
+   else
+   {
+      memcpy(&fifo->entry[idx], entries, first * sizeof(*entries));
+      memcpy(&fifo->entry[0], &entries[first], (count - first) * sizeof(*entries));
+   }
+   FIFO_BARRIER();
+   for(i = 0; i < count; i++)
+   {
+      fifo->ready[(slot + i) & mask] = true;
+   }
+   return count;
+}
+
+/**
+* @brief       Reserves the next free entry so that it can be filled in place.
+*              May be called by several writers concurrently. The entry must be
+*              handed over with FIFO_Commit() soon, because the reader waits at
+*              entries that were not committed yet.
+* @param[in]   fifo in which an entry shall be reserved.
+* @return      The reserved entry or \c NULL if the FIFO was full.
+*/
+#ifndef FIFO_PREFIX
+fifo_entry_t* FIFO_Reserve(fifo_t* fifo)
+{
+   uint16_t idx;
+
+   if(!FIFO_ReserveSlots(&fifo->write, &fifo->read, &fifo->high_watermark,
+                         fifo_size, 1, &idx))
+   {
+      return NULL;
+   }
+   return &fifo->entry[idx & fifo_mask];
+}
+#else
+FIFOS(FIFO_PREFIX,fifo_entry_t)* FIFOS(FIFO_PREFIX,FIFO_Reserve)(FIFOS(FIFO_PREFIX,fifo_t)* fifo)
+{
+   uint16_t idx;
+
+   if(!FIFO_ReserveSlots(&fifo->write, &fifo->read, &fifo->high_watermark,
+                         FIFOS(FIFO_PREFIX,fifo_size), 1, &idx))
+   {
+      return NULL;
+   }
+   return &fifo->entry[idx & FIFOS(FIFO_PREFIX,fifo_mask)];
+}
+#endif
+
+/**
+* @brief       Hands an entry that was filled after FIFO_Reserve() over to the
+*              reader.
+* @param[in]   fifo that contains the entry.
+* @param[in]   entry returned by FIFO_Reserve().
+*/
+#ifndef FIFO_PREFIX
+void FIFO_Commit(fifo_t* fifo, fifo_entry_t* entry)
+#else
+void FIFOS(FIFO_PREFIX,FIFO_Commit)(FIFOS(FIFO_PREFIX,fifo_t)* fifo, FIFOS(FIFO_PREFIX,fifo_entry_t)* entry)
+#endif
+{
+   FIFO_BARRIER();
+   fifo->ready[entry - fifo->entry] = true;
+}
+
+/**
+* @brief       Returns the oldest entry without removing it, so that it can be
+*              used in place. There must be only one reader.
+* @param[in]   fifo from which the entry shall be taken.
+* @return      The oldest entry or \c NULL if the FIFO was empty or the oldest
+*              entry is still being written.
+*/
+#ifndef FIFO_PREFIX
+fifo_entry_t* FIFO_Peek(fifo_t* fifo)
+{
+   uint16_t idx = fifo->read & fifo_mask;
+#else
+FIFOS(FIFO_PREFIX,fifo_entry_t)* FIFOS(FIFO_PREFIX,FIFO_Peek)(FIFOS(FIFO_PREFIX,fifo_t)* fifo)
+{
+   uint16_t idx = fifo->read & FIFOS(FIFO_PREFIX,fifo_mask);
+#endif
+
+   if(!fifo->ready[idx])
+   {
+      return NULL;
+   }
+   FIFO_BARRIER();
+   return &fifo->entry[idx];
+}
+
+/**
+* @brief       Removes the entry returned by FIFO_Peek() and frees its slot for
+*              the writers.
+* @param[in]   fifo from which the entry shall be removed.
+*/
+#ifndef FIFO_PREFIX
+void FIFO_Release(fifo_t* fifo)
+{
+   fifo->ready[fifo->read & fifo_mask] = false;
+#else
+void FIFOS(FIFO_PREFIX,FIFO_Release)(FIFOS(FIFO_PREFIX,fifo_t)* fifo)
+{
+   fifo->ready[fifo->read & FIFOS(FIFO_PREFIX,fifo_mask)] = false;
+#endif
+   FIFO_BARRIER();
+   fifo->read++;
 }
 
 /**
 * @brief       Checks if the FIFO is empty.
 * @param[in]   fifo which shall be checked.
-* @return      \c true if the FIFO is empty, \c false if it is not.
+* @return      \c true if there is no entry that can be read, \c false if
+*              there is.
 */
 #ifndef FIFO_PREFIX
 bool FIFO_IsEmpty(fifo_t* fifo)
+{
+   if(!fifo->ready[fifo->read & fifo_mask])
 #else
 bool FIFOS(FIFO_PREFIX,FIFO_IsEmpty)(FIFOS(FIFO_PREFIX,fifo_t)* fifo)
-#endif
 {
-   if(fifo->read == fifo->write)
+   if(!fifo->ready[fifo->read & FIFOS(FIFO_PREFIX,fifo_mask)])
+#endif
    {
       return true;
    }
@@ -117,11 +459,11 @@ bool FIFOS(FIFO_PREFIX,FIFO_IsEmpty)(FIFOS(FIFO_PREFIX,fifo_t)* fifo)
 #ifndef FIFO_PREFIX
 bool FIFO_IsFull(fifo_t* fifo)
 {
-   if(fifo->read == ((fifo->write + 1) & fifo_mask))
+   if((uint16_t)(fifo->write - fifo->read) == fifo_size)
 #else
 bool FIFOS(FIFO_PREFIX,FIFO_IsFull)(FIFOS(FIFO_PREFIX,fifo_t)* fifo)
 {
-   if(fifo->read == ((fifo->write + 1) & FIFOS(FIFO_PREFIX,fifo_mask)))
+   if((uint16_t)(fifo->write - fifo->read) == FIFOS(FIFO_PREFIX,fifo_size))
 #endif
    {
       return true;
@@ -130,7 +472,8 @@ bool FIFOS(FIFO_PREFIX,FIFO_IsFull)(FIFOS(FIFO_PREFIX,fifo_t)* fifo)
 }
 
 /**
-* @brief       Clears the FIFO (sets both indices to 0).
+* @brief       Clears the FIFO (sets both indices and the high watermark to 0).
+*              Must not be called while the FIFO is written.
 * @param[in]   fifo to be cleared.
 */
 #ifndef FIFO_PREFIX
@@ -141,20 +484,36 @@ void FIFOS(FIFO_PREFIX,FIFO_Clear)(FIFOS(FIFO_PREFIX,fifo_t)* fifo)
 {
    fifo->read = 0;
    fifo->write = 0;
+   fifo->high_watermark = 0;
+   memset((void*)fifo->ready, false, sizeof(fifo->ready));
 }
 
 /**
 * @brief       Counts the number of elements that are stored in the FIFO.
 * @param[in]   fifo whose elements shall be counted.
-* @return      The number of stored elements.
+* @return      The number of stored elements, including the ones that are
+*              still being written.
 */
 #ifndef FIFO_PREFIX
 fifo_idx_t FIFO_Count(fifo_t* fifo)
-{
-   return (fifo->write - fifo->read) & fifo_mask;
 #else
 FIFOS(FIFO_PREFIX,fifo_idx_t) FIFOS(FIFO_PREFIX,FIFO_Count)(FIFOS(FIFO_PREFIX,fifo_t)* fifo)
+#endif
 {
-   return (fifo->write - fifo->read) & FIFOS(FIFO_PREFIX,fifo_mask);
+   return (uint16_t)(fifo->write - fifo->read);
+}
+
+/**
+* @brief       Returns the maximum number of elements that were stored in the
+*              FIFO at the same time since it was cleared.
+* @param[in]   fifo whose high watermark shall be returned.
+* @return      The high watermark, FIFO_SIZE if the FIFO was full.
+*/
+#ifndef FIFO_PREFIX
+fifo_idx_t FIFO_HighWatermark(fifo_t* fifo)
+#else
+FIFOS(FIFO_PREFIX,fifo_idx_t) FIFOS(FIFO_PREFIX,FIFO_HighWatermark)(FIFOS(FIFO_PREFIX,fifo_t)* fifo)
 #endif
+{
+   return fifo->high_watermark;
 }
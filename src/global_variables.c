@@ -23,6 +23,6 @@ RTC_HandleTypeDef    RtcHandle;
 TIM_HandleTypeDef    TimHandle;
 //USBD_HandleTypeDef   USBD_Device;// in main.c
 
-volatile uint8_t     PrevXferComplete = 1; // todo check if necessary!
 flags_t              flags;
+volatile uint32_t    events;     // see EVENT_* in application.h
 fifo_t               irsnd_fifo;
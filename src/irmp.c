@@ -548,7 +548,6 @@
 #  define ANALYZE_ONLY_NORMAL_PRINTF(...)       { if (! silent && !verbose) { printf (__VA_ARGS__); } }
 #  define ANALYZE_NEWLINE()                     { if (verbose)              { putchar ('\n');       } }
 static int                                      silent;
-static int                                      time_counter;
 static int                                      verbose;
 
 /*******************************                not every PIC compiler knows variadic macros :-(
@@ -1031,27 +1030,6 @@ irmp_log (uint_fast8_t val)
 #define irmp_log(val)
 #endif //IRMP_LOGGING
 
-typedef struct
-{
-    uint_fast8_t    protocol;                                                // ir protocol
-    uint_fast8_t    pulse_1_len_min;                                         // minimum length of pulse with bit value 1
-    uint_fast8_t    pulse_1_len_max;                                         // maximum length of pulse with bit value 1
-    uint_fast8_t    pause_1_len_min;                                         // minimum length of pause with bit value 1
-    uint_fast8_t    pause_1_len_max;                                         // maximum length of pause with bit value 1
-    uint_fast8_t    pulse_0_len_min;                                         // minimum length of pulse with bit value 0
-    uint_fast8_t    pulse_0_len_max;                                         // maximum length of pulse with bit value 0
-    uint_fast8_t    pause_0_len_min;                                         // minimum length of pause with bit value 0
-    uint_fast8_t    pause_0_len_max;                                         // maximum length of pause with bit value 0
-    uint_fast8_t    address_offset;                                          // address offset
-    uint_fast8_t    address_end;                                             // end of address
-    uint_fast8_t    command_offset;                                          // command offset
-    uint_fast8_t    command_end;                                             // end of command
-    uint_fast8_t    complete_len;                                            // complete length of frame
-    uint_fast8_t    stop_bit;                                                // flag: frame has stop bit
-    uint_fast8_t    lsb_first;                                               // flag: LSB first
-    uint_fast8_t    flags;                                                   // some flags
-} IRMP_PARAMETER;
-
 #if IRMP_SUPPORT_SIRCS_PROTOCOL == 1
 
 static const PROGMEM IRMP_PARAMETER sircs_param =
@@ -1551,8 +1529,6 @@ static const PROGMEM IRMP_PARAMETER bang_olufsen_param =
 
 #if IRMP_SUPPORT_GRUNDIG_NOKIA_IR60_PROTOCOL == 1
 
-static uint_fast8_t first_bit;
-
 static const PROGMEM IRMP_PARAMETER grundig_param =
 {
     IRMP_GRUNDIG_PROTOCOL,                                              // protocol:        ir protocol
@@ -2007,20 +1983,12 @@ static const PROGMEM IRMP_PARAMETER radio1_param =
 
 #endif
 
-static uint_fast8_t                             irmp_bit;                   // current bit position
-static IRMP_PARAMETER                           irmp_param;
-
-#if IRMP_SUPPORT_RC5_PROTOCOL == 1 && (IRMP_SUPPORT_FDC_PROTOCOL == 1 || IRMP_SUPPORT_RCCAR_PROTOCOL == 1)
-static IRMP_PARAMETER                           irmp_param2;
-#endif
-
-static volatile uint_fast8_t                    irmp_ir_detected = FALSE;
-static volatile uint_fast8_t                    irmp_protocol;
-static volatile uint_fast16_t                   irmp_address;
-static volatile uint_fast16_t                   irmp_command;
-static volatile uint_fast16_t                   irmp_id;                // only used for SAMSUNG protocol
-static volatile uint_fast8_t                    irmp_flags;
-// static volatile uint_fast8_t                 irmp_busy_flag;
+static irmp_state_t                             irmp_default_state =    // instance used by irmp_ISR() and irmp_get_data()
+{
+    .last_irmp_address      = 0xFFFF,
+    .last_irmp_command      = 0xFFFF,
+    .denon_repetition_len   = 0xFFFF,
+};
 
 #if defined(__MBED__)
 // DigitalIn inputPin(IRMP_PIN, PullUp);                                // this requires mbed.h and source to be compiled as cpp
@@ -2034,9 +2002,41 @@ static uint_fast8_t                             IRMP_PIN;
 static uint_fast8_t                             radio;
 #endif
 
+static void                                     irmp_init_start_bits (void);
+
+#if IRMP_USE_PROTOCOL_MASK == 1
+static volatile uint64_t                        irmp_protocol_mask = IRMP_ALL_PROTOCOLS;   // bit n: protocol n enabled
+#endif
+
+#if IRMP_USE_EDGE_CAPTURE == 1
+static void                                     irmp_edge_process (void);
+#endif
+
+#if IRMP_USE_FRAME_QUEUE == 1
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Frame queue
+ *  @details  decoded frames of the default instance, written by irmp_ISR() only, read by irmp_get_data() only.
+ *            Both indices are free running, so all IRMP_FRAME_QUEUE_SIZE entries can be used.
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#if defined(__GNUC__)
+#define IRMP_QUEUE_BARRIER()                    __asm__ __volatile__ ("" ::: "memory")  // keep entry access and index update in order
+#else
+#define IRMP_QUEUE_BARRIER()
+#endif
+
+static IRMP_DATA                                irmp_queue_buf[IRMP_FRAME_QUEUE_SIZE];
+static volatile uint_fast8_t                    irmp_queue_head;            // written by ISR only
+static volatile uint_fast8_t                    irmp_queue_tail;            // written by irmp_get_data() only
+static volatile uint_fast8_t                    irmp_queue_high_water;      // written by ISR only
+static volatile uint_fast16_t                   irmp_queue_overflows;       // written by ISR only
+
+static void                                     irmp_queue_put (irmp_state_t *);
+#endif
+
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
  *  Initialize IRMP decoder
- *  @details  Configures IRMP input pin
+ *  @details  Configures IRMP input pin and start bit tables
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
 #ifndef ANALYZE
@@ -2119,37 +2119,158 @@ irmp_init (void)
 #if IRMP_LOGGING == 1
     irmp_uart_init ();
 #endif
+
+    irmp_init_start_bits ();
 }
 #endif
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Initialize IRMP decoder state
+ *  @details  resets a decoder instance, must be called once before an instance is passed to irmp_ISR_ex().
+ *            irmp_init() must have been called before.
+ *  @param    pointer to decoder state
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+irmp_init_state (irmp_state_t * st)
+{
+    memset (st, 0, sizeof (irmp_state_t));
+    st->last_irmp_address       = 0xFFFF;
+    st->last_irmp_command       = 0xFFFF;
+    st->denon_repetition_len    = 0xFFFF;
+}
+
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
  *  Get IRMP data
- *  @details  gets decoded IRMP data
+ *  @details  gets decoded IRMP data of the default instance
  *  @param    pointer in order to store IRMP data
  *  @return    TRUE: successful, FALSE: failed
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
 uint_fast8_t
 irmp_get_data (IRMP_DATA * irmp_data_p)
+{
+#if IRMP_USE_EDGE_CAPTURE == 1
+    irmp_edge_process ();
+#endif
+
+#if IRMP_USE_FRAME_QUEUE == 1
+    uint_fast8_t    tail = irmp_queue_tail;
+
+    if (tail == irmp_queue_head)
+    {
+        return FALSE;
+    }
+
+    IRMP_QUEUE_BARRIER ();
+    *irmp_data_p = irmp_queue_buf[tail % IRMP_FRAME_QUEUE_SIZE];
+    IRMP_QUEUE_BARRIER ();                                                      // entry must be copied before the slot is released
+    irmp_queue_tail = tail + 1;
+    return TRUE;
+#else
+    return irmp_get_data_ex (&irmp_default_state, irmp_data_p);
+#endif
+}
+
+#if IRMP_USE_FRAME_QUEUE == 1
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Drain frame queue
+ *  @details  gets all queued frames of the default instance at once
+ *  @param    array in order to store IRMP data, size of array
+ *  @return   number of frames stored
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+irmp_drain_data (IRMP_DATA * irmp_data_p, uint_fast8_t max)
+{
+    uint_fast8_t    n = 0;
+
+    while (n < max && irmp_get_data (irmp_data_p + n))
+    {
+        n++;
+    }
+
+    return n;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Get frame queue statistics
+ *  @details  overflows counts frames which were dropped because the queue was full, it saturates at 0xFFFF
+ *  @param    pointer in order to store statistics
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+irmp_get_queue_stats (IRMP_QUEUE_STATS * stats_p)
+{
+    stats_p->count      = (uint_fast8_t) (irmp_queue_head - irmp_queue_tail);
+    stats_p->high_water = irmp_queue_high_water;
+    stats_p->overflows  = irmp_queue_overflows;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Queue detected frame
+ *  @details  called in interrupt context as soon as the default instance has detected a frame. The frame is converted and
+ *            stored, so the decoder can go on at once. If the queue is full, the frame is dropped.
+ *  @param    pointer to decoder state
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+irmp_queue_put (irmp_state_t * st)
+{
+    uint_fast8_t    head    = irmp_queue_head;
+    uint_fast8_t    count   = (uint_fast8_t) (head - irmp_queue_tail);
+
+    if (count >= IRMP_FRAME_QUEUE_SIZE)
+    {
+        st->irmp_ir_detected = FALSE;
+
+        if (irmp_queue_overflows < 0xFFFF)
+        {
+            irmp_queue_overflows++;
+        }
+    }
+    else if (irmp_get_data_ex (st, &irmp_queue_buf[head % IRMP_FRAME_QUEUE_SIZE]))
+    {
+        IRMP_QUEUE_BARRIER ();                                                  // entry must be written before it is published
+        irmp_queue_head = head + 1;
+        count++;
+
+        if (count > irmp_queue_high_water)
+        {
+            irmp_queue_high_water = count;
+        }
+    }
+}
+#endif // IRMP_USE_FRAME_QUEUE == 1
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Get IRMP data
+ *  @details  gets decoded IRMP data of a decoder instance
+ *  @param    pointer to decoder state, pointer in order to store IRMP data
+ *  @return    TRUE: successful, FALSE: failed
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+irmp_get_data_ex (irmp_state_t * st, IRMP_DATA * irmp_data_p)
 {
     uint_fast8_t   rtc = FALSE;
 
-    if (irmp_ir_detected)
+    if (st->irmp_ir_detected)
     {
-        switch (irmp_protocol)
+        switch (st->irmp_protocol)
         {
 #if IRMP_SUPPORT_SAMSUNG_PROTOCOL == 1
             case IRMP_SAMSUNG_PROTOCOL:
-                if ((irmp_command >> 8) == (~irmp_command & 0x00FF))
+                if ((st->irmp_command >> 8) == (~st->irmp_command & 0x00FF))
                 {
-                    irmp_command &= 0xff;
-                    irmp_command |= irmp_id << 8;
+                    st->irmp_command &= 0xff;
+                    st->irmp_command |= st->irmp_id << 8;
                     rtc = TRUE;
                 }
                 break;
 
 #if IRMP_SUPPORT_SAMSUNG48_PROTOCOL == 1
             case IRMP_SAMSUNG48_PROTOCOL:
-                irmp_command = (irmp_command & 0x00FF) | ((irmp_id & 0x00FF) << 8);
+                st->irmp_command = (st->irmp_command & 0x00FF) | ((st->irmp_id & 0x00FF) << 8);
                 rtc = TRUE;
                 break;
 #endif
@@ -2157,28 +2278,28 @@ irmp_get_data (IRMP_DATA * irmp_data_p)
 
 #if IRMP_SUPPORT_NEC_PROTOCOL == 1
             case IRMP_NEC_PROTOCOL:
-                if ((irmp_command >> 8) == (~irmp_command & 0x00FF))
+                if ((st->irmp_command >> 8) == (~st->irmp_command & 0x00FF))
                 {
-                    irmp_command &= 0xff;
+                    st->irmp_command &= 0xff;
                     rtc = TRUE;
                 }
-                else if (irmp_address == 0x87EE)
+                else if (st->irmp_address == 0x87EE)
                 {
 #ifdef ANALYZE
                     ANALYZE_PRINTF ("Switching to APPLE protocol\n");
 #endif // ANALYZE
-                    irmp_protocol = IRMP_APPLE_PROTOCOL;
-                    irmp_address = (irmp_command & 0xFF00) >> 8;
-                    irmp_command &= 0x00FF;
+                    st->irmp_protocol = IRMP_APPLE_PROTOCOL;
+                    st->irmp_address = (st->irmp_command & 0xFF00) >> 8;
+                    st->irmp_command &= 0x00FF;
                     rtc = TRUE;
                 }
                 break;
 #endif
 #if IRMP_SUPPORT_BOSE_PROTOCOL == 1
             case IRMP_BOSE_PROTOCOL:
-                if ((irmp_command >> 8) == (~irmp_command & 0x00FF))
+                if ((st->irmp_command >> 8) == (~st->irmp_command & 0x00FF))
                 {
-                    irmp_command &= 0xff;
+                    st->irmp_command &= 0xff;
                     rtc = TRUE;
                 }
                 break;
@@ -2186,16 +2307,16 @@ irmp_get_data (IRMP_DATA * irmp_data_p)
 #if IRMP_SUPPORT_SIEMENS_OR_RUWIDO_PROTOCOL == 1
             case IRMP_SIEMENS_PROTOCOL:
             case IRMP_RUWIDO_PROTOCOL:
-                if (((irmp_command >> 1) & 0x0001) == (~irmp_command & 0x0001))
+                if (((st->irmp_command >> 1) & 0x0001) == (~st->irmp_command & 0x0001))
                 {
-                    irmp_command >>= 1;
+                    st->irmp_command >>= 1;
                     rtc = TRUE;
                 }
                 break;
 #endif
 #if IRMP_SUPPORT_KATHREIN_PROTOCOL == 1
             case IRMP_KATHREIN_PROTOCOL:
-                if (irmp_command != 0x0000)
+                if (st->irmp_command != 0x0000)
                 {
                     rtc = TRUE;
                 }
@@ -2203,19 +2324,19 @@ irmp_get_data (IRMP_DATA * irmp_data_p)
 #endif
 #if IRMP_SUPPORT_RC5_PROTOCOL == 1
             case IRMP_RC5_PROTOCOL:
-                irmp_address &= ~0x20;                              // clear toggle bit
+                st->irmp_address &= ~0x20;                              // clear toggle bit
                 rtc = TRUE;
                 break;
 #endif
 #if IRMP_SUPPORT_S100_PROTOCOL == 1
             case IRMP_S100_PROTOCOL:
-                irmp_address &= ~0x20;                              // clear toggle bit
+                st->irmp_address &= ~0x20;                              // clear toggle bit
                 rtc = TRUE;
                 break;
 #endif
 #if IRMP_SUPPORT_IR60_PROTOCOL == 1
             case IRMP_IR60_PROTOCOL:
-                if (irmp_command != 0x007d)                         // 0x007d (== 62<<1 + 1) is start instruction frame
+                if (st->irmp_command != 0x007d)                         // 0x007d (== 62<<1 + 1) is start instruction frame
                 {
                     rtc = TRUE;
                 }
@@ -2232,28 +2353,28 @@ irmp_get_data (IRMP_DATA * irmp_data_p)
                 // frame in irmp_data:
                 // Bit 12 11 10 9  8  7  6  5  4  3  2  1  0
                 //     V  D7 D6 D5 D4 D3 D2 D1 D0 A1 A0 C1 C0   //         10 9  8  7  6  5  4  3  2  1  0
-                irmp_address = (irmp_command & 0x000C) >> 2;    // addr:   0  0  0  0  0  0  0  0  0  A1 A0
-                irmp_command = ((irmp_command & 0x1000) >> 2) | // V-Bit:  V  0  0  0  0  0  0  0  0  0  0
-                               ((irmp_command & 0x0003) << 8) | // C-Bits: 0  C1 C0 0  0  0  0  0  0  0  0
-                               ((irmp_command & 0x0FF0) >> 4);  // D-Bits:          D7 D6 D5 D4 D3 D2 D1 D0
+                st->irmp_address = (st->irmp_command & 0x000C) >> 2;    // addr:   0  0  0  0  0  0  0  0  0  A1 A0
+                st->irmp_command = ((st->irmp_command & 0x1000) >> 2) | // V-Bit:  V  0  0  0  0  0  0  0  0  0  0
+                               ((st->irmp_command & 0x0003) << 8) | // C-Bits: 0  C1 C0 0  0  0  0  0  0  0  0
+                               ((st->irmp_command & 0x0FF0) >> 4);  // D-Bits:          D7 D6 D5 D4 D3 D2 D1 D0
                 rtc = TRUE;                                     // Summe:  V  C1 C0 D7 D6 D5 D4 D3 D2 D1 D0
                 break;
 #endif
 
 #if IRMP_SUPPORT_NETBOX_PROTOCOL == 1                           // squeeze code to 8 bit, upper bit indicates release-key
             case IRMP_NETBOX_PROTOCOL:
-                if (irmp_command & 0x1000)                      // last bit set?
+                if (st->irmp_command & 0x1000)                      // last bit set?
                 {
-                    if ((irmp_command & 0x1f) == 0x15)          // key pressed: 101 01 (LSB)
+                    if ((st->irmp_command & 0x1f) == 0x15)          // key pressed: 101 01 (LSB)
                     {
-                        irmp_command >>= 5;
-                        irmp_command &= 0x7F;
+                        st->irmp_command >>= 5;
+                        st->irmp_command &= 0x7F;
                         rtc = TRUE;
                     }
-                    else if ((irmp_command & 0x1f) == 0x10)     // key released: 000 01 (LSB)
+                    else if ((st->irmp_command & 0x1f) == 0x10)     // key released: 000 01 (LSB)
                     {
-                        irmp_command >>= 5;
-                        irmp_command |= 0x80;
+                        st->irmp_command >>= 5;
+                        st->irmp_command |= 0x80;
                         rtc = TRUE;
                     }
                     else
@@ -2274,11 +2395,11 @@ irmp_get_data (IRMP_DATA * irmp_data_p)
 #if IRMP_SUPPORT_LEGO_PROTOCOL == 1
             case IRMP_LEGO_PROTOCOL:
             {
-                uint_fast8_t crc = 0x0F ^ ((irmp_command & 0xF000) >> 12) ^ ((irmp_command & 0x0F00) >> 8) ^ ((irmp_command & 0x00F0) >> 4);
+                uint_fast8_t crc = 0x0F ^ ((st->irmp_command & 0xF000) >> 12) ^ ((st->irmp_command & 0x0F00) >> 8) ^ ((st->irmp_command & 0x00F0) >> 4);
 
-                if ((irmp_command & 0x000F) == crc)
+                if ((st->irmp_command & 0x000F) == crc)
                 {
-                    irmp_command >>= 4;
+                    st->irmp_command >>= 4;
                     rtc = TRUE;
                 }
                 else
@@ -2299,18 +2420,25 @@ irmp_get_data (IRMP_DATA * irmp_data_p)
             }
         }
 
+#if IRMP_USE_PROTOCOL_MASK == 1
+        if (! (irmp_protocol_mask & IRMP_PROTOCOL_BIT (st->irmp_protocol)))
+        {                                                                       // protocol disabled at runtime, drop frame
+            rtc = FALSE;
+        }
+#endif
+
         if (rtc)
         {
-            irmp_data_p->protocol = irmp_protocol;
-            irmp_data_p->address = irmp_address;
-            irmp_data_p->command = irmp_command;
-            irmp_data_p->flags   = irmp_flags;
-            irmp_command = 0;
-            irmp_address = 0;
-            irmp_flags   = 0;
+            irmp_data_p->protocol = st->irmp_protocol;
+            irmp_data_p->address = st->irmp_address;
+            irmp_data_p->command = st->irmp_command;
+            irmp_data_p->flags   = st->irmp_flags;
+            st->irmp_command = 0;
+            st->irmp_address = 0;
+            st->irmp_flags   = 0;
         }
 
-        irmp_ir_detected = FALSE;
+        st->irmp_ir_detected = FALSE;
     }
 
     return rtc;
@@ -2324,46 +2452,20 @@ irmp_set_callback_ptr (void (*cb)(uint_fast8_t))
 }
 #endif // IRMP_USE_CALLBACK == 1
 
-// these statics must not be volatile, because they are only used by irmp_store_bit(), which is called by irmp_ISR()
-static uint_fast16_t irmp_tmp_address;                                      // ir address
-static uint_fast16_t irmp_tmp_command;                                      // ir command
-
-#if (IRMP_SUPPORT_RC5_PROTOCOL == 1 && (IRMP_SUPPORT_FDC_PROTOCOL == 1 || IRMP_SUPPORT_RCCAR_PROTOCOL == 1)) || IRMP_SUPPORT_NEC42_PROTOCOL == 1
-static uint_fast16_t irmp_tmp_address2;                                     // ir address
-static uint_fast16_t irmp_tmp_command2;                                     // ir command
-#endif
-
-#if IRMP_SUPPORT_LGAIR_PROTOCOL == 1
-static uint_fast16_t irmp_lgair_address;                                    // ir address
-static uint_fast16_t irmp_lgair_command;                                    // ir command
-#endif
-
-#if IRMP_SUPPORT_SAMSUNG_PROTOCOL == 1
-static uint_fast16_t irmp_tmp_id;                                           // ir id (only SAMSUNG)
-#endif
-#if IRMP_SUPPORT_KASEIKYO_PROTOCOL == 1
-static uint8_t      xor_check[6];                                           // check kaseikyo "parity" bits
-static uint_fast8_t genre2;                                                 // save genre2 bits here, later copied to MSB in flags
-#endif
-
-#if IRMP_SUPPORT_ORTEK_PROTOCOL == 1
-static uint_fast8_t  parity;                                                // number of '1' of the first 14 bits, check if even.
-#endif
-
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
  *  store bit
  *  @details  store bit in temp address or temp command
- *  @param    value to store: 0 or 1
+ *  @param    pointer to decoder state, value to store: 0 or 1
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
 // verhindert, dass irmp_store_bit() inline compiliert wird:
 // static void irmp_store_bit (uint_fast8_t) __attribute__ ((noinline));
 
 static void
-irmp_store_bit (uint_fast8_t value)
+irmp_store_bit (irmp_state_t * st, uint_fast8_t value)
 {
 #if IRMP_SUPPORT_ACP24_PROTOCOL == 1
-    if (irmp_param.protocol == IRMP_ACP24_PROTOCOL)                                                 // squeeze 64 bits into 16 bits:
+    if (st->irmp_param.protocol == IRMP_ACP24_PROTOCOL)                                                 // squeeze 64 bits into 16 bits:
     {
         if (value)
         {
@@ -2377,24 +2479,24 @@ irmp_store_bit (uint_fast8_t value)
             //         5432109876543210
             //         NAVVvMMMmtxyTTTT
 
-            switch (irmp_bit)
+            switch (st->irmp_bit)
             {
-                case  0: irmp_tmp_command |= (1<<15); break;                                        // N
-                case  2: irmp_tmp_command |= (1<<13); break;                                        // V
-                case  3: irmp_tmp_command |= (1<<12); break;                                        // V
-                case  4: irmp_tmp_command |= (1<<10); break;                                        // M
-                case  5: irmp_tmp_command |= (1<< 9); break;                                        // M
-                case  6: irmp_tmp_command |= (1<< 8); break;                                        // M
-                case 20: irmp_tmp_command |= (1<< 6); break;                                        // t
-                case 22: irmp_tmp_command |= (1<<11); break;                                        // v
-                case 23: irmp_tmp_command |= (1<< 7); break;                                        // m
-                case 24: irmp_tmp_command |= (1<<14); break;                                        // A
-                case 26: irmp_tmp_command |= (1<< 5); break;                                        // x
-                case 44: irmp_tmp_command |= (1<< 4); break;                                        // y
-                case 66: irmp_tmp_command |= (1<< 3); break;                                        // T
-                case 67: irmp_tmp_command |= (1<< 2); break;                                        // T
-                case 68: irmp_tmp_command |= (1<< 1); break;                                        // T
-                case 69: irmp_tmp_command |= (1<< 0); break;                                        // T
+                case  0: st->irmp_tmp_command |= (1<<15); break;                                        // N
+                case  2: st->irmp_tmp_command |= (1<<13); break;                                        // V
+                case  3: st->irmp_tmp_command |= (1<<12); break;                                        // V
+                case  4: st->irmp_tmp_command |= (1<<10); break;                                        // M
+                case  5: st->irmp_tmp_command |= (1<< 9); break;                                        // M
+                case  6: st->irmp_tmp_command |= (1<< 8); break;                                        // M
+                case 20: st->irmp_tmp_command |= (1<< 6); break;                                        // t
+                case 22: st->irmp_tmp_command |= (1<<11); break;                                        // v
+                case 23: st->irmp_tmp_command |= (1<< 7); break;                                        // m
+                case 24: st->irmp_tmp_command |= (1<<14); break;                                        // A
+                case 26: st->irmp_tmp_command |= (1<< 5); break;                                        // x
+                case 44: st->irmp_tmp_command |= (1<< 4); break;                                        // y
+                case 66: st->irmp_tmp_command |= (1<< 3); break;                                        // T
+                case 67: st->irmp_tmp_command |= (1<< 2); break;                                        // T
+                case 68: st->irmp_tmp_command |= (1<< 1); break;                                        // T
+                case 69: st->irmp_tmp_command |= (1<< 0); break;                                        // T
             }
         }
     }
@@ -2402,37 +2504,37 @@ irmp_store_bit (uint_fast8_t value)
 #endif // IRMP_SUPPORT_ACP24_PROTOCOL
 
 #if IRMP_SUPPORT_ORTEK_PROTOCOL == 1
-    if (irmp_param.protocol == IRMP_ORTEK_PROTOCOL)
+    if (st->irmp_param.protocol == IRMP_ORTEK_PROTOCOL)
     {
-        if (irmp_bit < 14)
+        if (st->irmp_bit < 14)
         {
             if (value)
             {
-                parity++;
+                st->parity++;
             }
         }
-        else if (irmp_bit == 14)
+        else if (st->irmp_bit == 14)
         {
             if (value)                                                                                      // value == 1: even parity
             {
-                if (parity & 0x01)
+                if (st->parity & 0x01)
                 {
-                    parity = PARITY_CHECK_FAILED;
+                    st->parity = PARITY_CHECK_FAILED;
                 }
                 else
                 {
-                    parity = PARITY_CHECK_OK;
+                    st->parity = PARITY_CHECK_OK;
                 }
             }
             else
             {
-                if (parity & 0x01)                                                                          // value == 0: odd parity
+                if (st->parity & 0x01)                                                                          // value == 0: odd parity
                 {
-                    parity = PARITY_CHECK_OK;
+                    st->parity = PARITY_CHECK_OK;
                 }
                 else
                 {
-                    parity = PARITY_CHECK_FAILED;
+                    st->parity = PARITY_CHECK_FAILED;
                 }
             }
         }
@@ -2444,101 +2546,101 @@ irmp_store_bit (uint_fast8_t value)
     }
 
 #if IRMP_SUPPORT_GRUNDIG_NOKIA_IR60_PROTOCOL == 1
-    if (irmp_bit == 0 && irmp_param.protocol == IRMP_GRUNDIG_PROTOCOL)
+    if (st->irmp_bit == 0 && st->irmp_param.protocol == IRMP_GRUNDIG_PROTOCOL)
     {
-        first_bit = value;
+        st->first_bit = value;
     }
     else
 #endif
 
-    if (irmp_bit >= irmp_param.address_offset && irmp_bit < irmp_param.address_end)
+    if (st->irmp_bit >= st->irmp_param.address_offset && st->irmp_bit < st->irmp_param.address_end)
     {
-        if (irmp_param.lsb_first)
+        if (st->irmp_param.lsb_first)
         {
-            irmp_tmp_address |= (((uint_fast16_t) (value)) << (irmp_bit - irmp_param.address_offset));   // CV wants cast
+            st->irmp_tmp_address |= (((uint_fast16_t) (value)) << (st->irmp_bit - st->irmp_param.address_offset));   // CV wants cast
         }
         else
         {
-            irmp_tmp_address <<= 1;
-            irmp_tmp_address |= value;
+            st->irmp_tmp_address <<= 1;
+            st->irmp_tmp_address |= value;
         }
     }
-    else if (irmp_bit >= irmp_param.command_offset && irmp_bit < irmp_param.command_end)
+    else if (st->irmp_bit >= st->irmp_param.command_offset && st->irmp_bit < st->irmp_param.command_end)
     {
-        if (irmp_param.lsb_first)
+        if (st->irmp_param.lsb_first)
         {
 #if IRMP_SUPPORT_SAMSUNG48_PROTOCOL == 1
-            if (irmp_param.protocol == IRMP_SAMSUNG48_PROTOCOL && irmp_bit >= 32)
+            if (st->irmp_param.protocol == IRMP_SAMSUNG48_PROTOCOL && st->irmp_bit >= 32)
             {
-                irmp_tmp_id |= (((uint_fast16_t) (value)) << (irmp_bit - 32));   // CV wants cast
+                st->irmp_tmp_id |= (((uint_fast16_t) (value)) << (st->irmp_bit - 32));   // CV wants cast
             }
             else
 #endif
             {
-                irmp_tmp_command |= (((uint_fast16_t) (value)) << (irmp_bit - irmp_param.command_offset));   // CV wants cast
+                st->irmp_tmp_command |= (((uint_fast16_t) (value)) << (st->irmp_bit - st->irmp_param.command_offset));   // CV wants cast
             }
         }
         else
         {
-            irmp_tmp_command <<= 1;
-            irmp_tmp_command |= value;
+            st->irmp_tmp_command <<= 1;
+            st->irmp_tmp_command |= value;
         }
     }
 
 #if IRMP_SUPPORT_LGAIR_PROTOCOL == 1
-    if (irmp_param.protocol == IRMP_NEC_PROTOCOL || irmp_param.protocol == IRMP_NEC42_PROTOCOL)
+    if (st->irmp_param.protocol == IRMP_NEC_PROTOCOL || st->irmp_param.protocol == IRMP_NEC42_PROTOCOL)
     {
-        if (irmp_bit < 8)
+        if (st->irmp_bit < 8)
         {
-            irmp_lgair_address <<= 1;                                                               // LGAIR uses MSB
-            irmp_lgair_address |= value;
+            st->irmp_lgair_address <<= 1;                                                               // LGAIR uses MSB
+            st->irmp_lgair_address |= value;
         }
-        else if (irmp_bit < 24)
+        else if (st->irmp_bit < 24)
         {
-            irmp_lgair_command <<= 1;                                                               // LGAIR uses MSB
-            irmp_lgair_command |= value;
+            st->irmp_lgair_command <<= 1;                                                               // LGAIR uses MSB
+            st->irmp_lgair_command |= value;
         }
     }
     // NO else!
 #endif
 
 #if IRMP_SUPPORT_NEC42_PROTOCOL == 1
-    if (irmp_param.protocol == IRMP_NEC42_PROTOCOL && irmp_bit >= 13 && irmp_bit < 26)
+    if (st->irmp_param.protocol == IRMP_NEC42_PROTOCOL && st->irmp_bit >= 13 && st->irmp_bit < 26)
     {
-        irmp_tmp_address2 |= (((uint_fast16_t) (value)) << (irmp_bit - 13));                             // CV wants cast
+        st->irmp_tmp_address2 |= (((uint_fast16_t) (value)) << (st->irmp_bit - 13));                             // CV wants cast
     }
     else
 #endif
 
 #if IRMP_SUPPORT_SAMSUNG_PROTOCOL == 1
-    if (irmp_param.protocol == IRMP_SAMSUNG_PROTOCOL && irmp_bit >= SAMSUNG_ID_OFFSET && irmp_bit < SAMSUNG_ID_OFFSET + SAMSUNG_ID_LEN)
+    if (st->irmp_param.protocol == IRMP_SAMSUNG_PROTOCOL && st->irmp_bit >= SAMSUNG_ID_OFFSET && st->irmp_bit < SAMSUNG_ID_OFFSET + SAMSUNG_ID_LEN)
     {
-        irmp_tmp_id |= (((uint_fast16_t) (value)) << (irmp_bit - SAMSUNG_ID_OFFSET));                    // store with LSB first
+        st->irmp_tmp_id |= (((uint_fast16_t) (value)) << (st->irmp_bit - SAMSUNG_ID_OFFSET));                    // store with LSB first
     }
     else
 #endif
 
 #if IRMP_SUPPORT_KASEIKYO_PROTOCOL == 1
-    if (irmp_param.protocol == IRMP_KASEIKYO_PROTOCOL)
+    if (st->irmp_param.protocol == IRMP_KASEIKYO_PROTOCOL)
     {
-        if (irmp_bit >= 20 && irmp_bit < 24)
+        if (st->irmp_bit >= 20 && st->irmp_bit < 24)
         {
-            irmp_tmp_command |= (((uint_fast16_t) (value)) << (irmp_bit - 8));       // store 4 system bits (genre 1) in upper nibble with LSB first
+            st->irmp_tmp_command |= (((uint_fast16_t) (value)) << (st->irmp_bit - 8));       // store 4 system bits (genre 1) in upper nibble with LSB first
         }
-        else if (irmp_bit >= 24 && irmp_bit < 28)
+        else if (st->irmp_bit >= 24 && st->irmp_bit < 28)
         {
-            genre2 |= (((uint_fast8_t) (value)) << (irmp_bit - 20));                 // store 4 system bits (genre 2) in upper nibble with LSB first
+            st->genre2 |= (((uint_fast8_t) (value)) << (st->irmp_bit - 20));                 // store 4 system bits (genre 2) in upper nibble with LSB first
         }
 
-        if (irmp_bit < KASEIKYO_COMPLETE_DATA_LEN)
+        if (st->irmp_bit < KASEIKYO_COMPLETE_DATA_LEN)
         {
             if (value)
             {
-                xor_check[irmp_bit / 8] |= 1 << (irmp_bit % 8);
+                st->xor_check[st->irmp_bit / 8] |= 1 << (st->irmp_bit % 8);
             }
             else
             {
-                xor_check[irmp_bit / 8] &= ~(1 << (irmp_bit % 8));
+                st->xor_check[st->irmp_bit / 8] &= ~(1 << (st->irmp_bit % 8));
             }
         }
     }
@@ -2548,990 +2650,1552 @@ irmp_store_bit (uint_fast8_t value)
         ;
     }
 
-    irmp_bit++;
+    st->irmp_bit++;
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
  *  store bit
  *  @details  store bit in temp address or temp command
- *  @param    value to store: 0 or 1
+ *  @param    pointer to decoder state, value to store: 0 or 1
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
 #if IRMP_SUPPORT_RC5_PROTOCOL == 1 && (IRMP_SUPPORT_FDC_PROTOCOL == 1 || IRMP_SUPPORT_RCCAR_PROTOCOL == 1)
 static void
-irmp_store_bit2 (uint_fast8_t value)
+irmp_store_bit2 (irmp_state_t * st, uint_fast8_t value)
 {
     uint_fast8_t irmp_bit2;
 
-    if (irmp_param.protocol)
+    if (st->irmp_param.protocol)
     {
-        irmp_bit2 = irmp_bit - 2;
+        irmp_bit2 = st->irmp_bit - 2;
     }
     else
     {
-        irmp_bit2 = irmp_bit - 1;
+        irmp_bit2 = st->irmp_bit - 1;
     }
 
-    if (irmp_bit2 >= irmp_param2.address_offset && irmp_bit2 < irmp_param2.address_end)
+    if (irmp_bit2 >= st->irmp_param2.address_offset && irmp_bit2 < st->irmp_param2.address_end)
     {
-        irmp_tmp_address2 |= (((uint_fast16_t) (value)) << (irmp_bit2 - irmp_param2.address_offset));   // CV wants cast
+        st->irmp_tmp_address2 |= (((uint_fast16_t) (value)) << (irmp_bit2 - st->irmp_param2.address_offset));   // CV wants cast
     }
-    else if (irmp_bit2 >= irmp_param2.command_offset && irmp_bit2 < irmp_param2.command_end)
+    else if (irmp_bit2 >= st->irmp_param2.command_offset && irmp_bit2 < st->irmp_param2.command_end)
     {
-        irmp_tmp_command2 |= (((uint_fast16_t) (value)) << (irmp_bit2 - irmp_param2.command_offset));   // CV wants cast
+        st->irmp_tmp_command2 |= (((uint_fast16_t) (value)) << (irmp_bit2 - st->irmp_param2.command_offset));   // CV wants cast
     }
 }
 #endif // IRMP_SUPPORT_RC5_PROTOCOL == 1 && (IRMP_SUPPORT_FDC_PROTOCOL == 1 || IRMP_SUPPORT_RCCAR_PROTOCOL == 1)
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
- *  ISR routine
- *  @details  ISR routine, called 10000 times per second
+ *  Start bit windows
+ *  @details  one entry per start bit check of irmp_classify_start_bit(), in the same order. A check can only succeed if the pulse
+ *            is in one of both pulse windows and the pause is in one of both pause windows. protocols holds all protocols the
+ *            frame may be switched to later on.
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
-uint_fast8_t
-irmp_ISR (void)
+enum
 {
-    static uint_fast8_t     irmp_start_bit_detected;                                // flag: start bit detected
-    static uint_fast8_t     wait_for_space;                                         // flag: wait for data bit space
-    static uint_fast8_t     wait_for_start_space;                                   // flag: wait for start bit space
-    static uint_fast8_t     irmp_pulse_time;                                        // count bit time for pulse
-    static PAUSE_LEN        irmp_pause_time;                                        // count bit time for pause
-    static uint_fast16_t    last_irmp_address = 0xFFFF;                             // save last irmp address to recognize key repetition
-    static uint_fast16_t    last_irmp_command = 0xFFFF;                             // save last irmp command to recognize key repetition
-    static uint_fast16_t    key_repetition_len;                                     // SIRCS repeats frame 2-5 times with 45 ms pause
-    static uint_fast8_t     repetition_frame_number;
-#if IRMP_SUPPORT_DENON_PROTOCOL == 1
-    static uint_fast16_t    last_irmp_denon_command;                                // save last irmp command to recognize DENON frame repetition
-    static uint_fast16_t    denon_repetition_len = 0xFFFF;                          // denon repetition len of 2nd auto generated frame
+#if IRMP_SUPPORT_SIRCS_PROTOCOL == 1
+    IRMP_START_BIT_SIRCS,
 #endif
-#if IRMP_SUPPORT_RC5_PROTOCOL == 1 || IRMP_SUPPORT_S100_PROTOCOL == 1
-    static uint_fast8_t     rc5_cmd_bit6;                                           // bit 6 of RC5 command is the inverted 2nd start bit
+#if IRMP_SUPPORT_JVC_PROTOCOL == 1
+    IRMP_START_BIT_JVC_REPETITION_1,
 #endif
-#if IRMP_SUPPORT_MANCHESTER == 1
-    static PAUSE_LEN        last_pause;                                             // last pause value
+#if IRMP_SUPPORT_NEC_PROTOCOL == 1
+    IRMP_START_BIT_NEC,
 #endif
-#if IRMP_SUPPORT_MANCHESTER == 1 || IRMP_SUPPORT_BANG_OLUFSEN_PROTOCOL == 1
-    static uint_fast8_t     last_value;                                             // last bit value
+#if IRMP_SUPPORT_NEC_PROTOCOL == 1
+    IRMP_START_BIT_NEC_REPETITION,
 #endif
-    uint_fast8_t            irmp_input;                                             // input value
-
-#ifdef ANALYZE
-    time_counter++;
-#endif // ANALYZE
-
-#if defined(__SDCC_stm8)
-    irmp_input = input(IRMP_GPIO_STRUCT->IDR)
-#elif defined(__MBED__)
-    //irmp_input = inputPin;
-    irmp_input = gpio_read (&gpioIRin);
-#else
-    irmp_input = input(IRMP_PIN);
+#if IRMP_SUPPORT_NEC_PROTOCOL == 1 && IRMP_SUPPORT_JVC_PROTOCOL == 1
+    IRMP_START_BIT_JVC_REPETITION_3,
 #endif
-
-#if IRMP_USE_CALLBACK == 1
-    if (irmp_callback_ptr)
-    {
-        static uint_fast8_t last_inverted_input;
-
-        if (last_inverted_input != !irmp_input)
-        {
-            (*irmp_callback_ptr) (! irmp_input);
-            last_inverted_input = !irmp_input;
-        }
-    }
-#endif // IRMP_USE_CALLBACK == 1
-
-    irmp_log(irmp_input);                                                       // log ir signal, if IRMP_LOGGING defined
-
-    if (! irmp_ir_detected)                                                     // ir code already detected?
-    {                                                                           // no...
-        if (! irmp_start_bit_detected)                                          // start bit detected?
-        {                                                                       // no...
-            if (! irmp_input)                                                   // receiving burst?
-            {                                                                   // yes...
-//              irmp_busy_flag = TRUE;
-#ifdef ANALYZE
-                if (! irmp_pulse_time)
-                {
-                    ANALYZE_PRINTF("%8.3fms [starting pulse]\n", (double) (time_counter * 1000) / F_INTERRUPTS);
-                }
-#endif // ANALYZE
-                irmp_pulse_time++;                                              // increment counter
-            }
-            else
-            {                                                                   // no...
-                if (irmp_pulse_time)                                            // it's dark....
-                {                                                               // set flags for counting the time of darkness...
-                    irmp_start_bit_detected = 1;
-                    wait_for_start_space    = 1;
-                    wait_for_space          = 0;
-                    irmp_tmp_command        = 0;
-                    irmp_tmp_address        = 0;
-#if IRMP_SUPPORT_KASEIKYO_PROTOCOL == 1
-                    genre2                  = 0;
+#if IRMP_SUPPORT_TELEFUNKEN_PROTOCOL == 1
+    IRMP_START_BIT_TELEFUNKEN,
+#endif
+#if IRMP_SUPPORT_ROOMBA_PROTOCOL == 1
+    IRMP_START_BIT_ROOMBA,
+#endif
+#if IRMP_SUPPORT_ACP24_PROTOCOL == 1
+    IRMP_START_BIT_ACP24,
+#endif
+#if IRMP_SUPPORT_PENTAX_PROTOCOL == 1
+    IRMP_START_BIT_PENTAX,
+#endif
+#if IRMP_SUPPORT_NIKON_PROTOCOL == 1
+    IRMP_START_BIT_NIKON,
 #endif
 #if IRMP_SUPPORT_SAMSUNG_PROTOCOL == 1
-                    irmp_tmp_id = 0;
+    IRMP_START_BIT_SAMSUNG,
 #endif
-
-#if IRMP_SUPPORT_RC5_PROTOCOL == 1 && (IRMP_SUPPORT_FDC_PROTOCOL == 1 || IRMP_SUPPORT_RCCAR_PROTOCOL == 1) || IRMP_SUPPORT_NEC42_PROTOCOL == 1
-                    irmp_tmp_command2       = 0;
-                    irmp_tmp_address2       = 0;
+#if IRMP_SUPPORT_MATSUSHITA_PROTOCOL == 1
+    IRMP_START_BIT_MATSUSHITA,
 #endif
-#if IRMP_SUPPORT_LGAIR_PROTOCOL == 1
-                    irmp_lgair_command      = 0;
-                    irmp_lgair_address      = 0;
+#if IRMP_SUPPORT_KASEIKYO_PROTOCOL == 1
+    IRMP_START_BIT_KASEIKYO,
 #endif
-                    irmp_bit                = 0xff;
-                    irmp_pause_time         = 1;                                // 1st pause: set to 1, not to 0!
-#if IRMP_SUPPORT_RC5_PROTOCOL == 1 || IRMP_SUPPORT_S100_PROTOCOL == 1
-                    rc5_cmd_bit6            = 0;                                // fm 2010-03-07: bugfix: reset it after incomplete RC5 frame!
+#if IRMP_SUPPORT_PANASONIC_PROTOCOL == 1
+    IRMP_START_BIT_PANASONIC,
+#endif
+#if IRMP_SUPPORT_RADIO1_PROTOCOL == 1
+    IRMP_START_BIT_RADIO1,
+#endif
+#if IRMP_SUPPORT_RECS80_PROTOCOL == 1
+    IRMP_START_BIT_RECS80,
+#endif
+#if IRMP_SUPPORT_S100_PROTOCOL == 1
+    IRMP_START_BIT_S100,
+#endif
+#if IRMP_SUPPORT_RC5_PROTOCOL == 1
+    IRMP_START_BIT_RC5,
 #endif
-                }
-                else
-                {
-                    if (key_repetition_len < 0xFFFF)                            // avoid overflow of counter
-                    {
-                        key_repetition_len++;
-
 #if IRMP_SUPPORT_DENON_PROTOCOL == 1
-                        if (denon_repetition_len < 0xFFFF)                      // avoid overflow of counter
-                        {
-                            denon_repetition_len++;
-
-                            if (denon_repetition_len >= DENON_AUTO_REPETITION_PAUSE_LEN && last_irmp_denon_command != 0)
-                            {
-#ifdef ANALYZE
-                                ANALYZE_PRINTF ("%8.3fms warning: did not receive inverted command repetition\n",
-                                                (double) (time_counter * 1000) / F_INTERRUPTS);
-#endif // ANALYZE
-                                last_irmp_denon_command = 0;
-                                denon_repetition_len = 0xFFFF;
-                            }
-                        }
-#endif // IRMP_SUPPORT_DENON_PROTOCOL == 1
-                    }
-                }
-            }
-        }
-        else
-        {
-            if (wait_for_start_space)                                           // we have received start bit...
-            {                                                                   // ...and are counting the time of darkness
-                if (irmp_input)                                                 // still dark?
-                {                                                               // yes
-                    irmp_pause_time++;                                          // increment counter
-
-#if IRMP_SUPPORT_NIKON_PROTOCOL == 1
-                    if (((irmp_pulse_time < NIKON_START_BIT_PULSE_LEN_MIN || irmp_pulse_time > NIKON_START_BIT_PULSE_LEN_MAX) && irmp_pause_time > IRMP_TIMEOUT_LEN) ||
-                         irmp_pause_time > IRMP_TIMEOUT_NIKON_LEN)
-#else
-                    if (irmp_pause_time > IRMP_TIMEOUT_LEN)                     // timeout?
+    IRMP_START_BIT_DENON,
 #endif
-                    {                                                           // yes...
-#if IRMP_SUPPORT_JVC_PROTOCOL == 1
-                        if (irmp_protocol == IRMP_JVC_PROTOCOL)                 // don't show eror if JVC protocol, irmp_pulse_time has been set below!
-                        {
-                            ;
-                        }
-                        else
-#endif // IRMP_SUPPORT_JVC_PROTOCOL == 1
-                        {
-#ifdef ANALYZE
-                            ANALYZE_PRINTF ("%8.3fms error 1: pause after start bit pulse %d too long: %d\n", (double) (time_counter * 1000) / F_INTERRUPTS, irmp_pulse_time, irmp_pause_time);
-                            ANALYZE_ONLY_NORMAL_PUTCHAR ('\n');
-#endif // ANALYZE
-                        }
-
-                        irmp_start_bit_detected = 0;                            // reset flags, let's wait for another start bit
-                        irmp_pulse_time         = 0;
-                        irmp_pause_time         = 0;
-                    }
-                }
-                else
-                {                                                               // receiving first data pulse!
-                    IRMP_PARAMETER * irmp_param_p;
-                    irmp_param_p = (IRMP_PARAMETER *) 0;
-
-#if IRMP_SUPPORT_RC5_PROTOCOL == 1 && (IRMP_SUPPORT_FDC_PROTOCOL == 1 || IRMP_SUPPORT_RCCAR_PROTOCOL == 1)
-                    irmp_param2.protocol = 0;
+#if IRMP_SUPPORT_THOMSON_PROTOCOL == 1
+    IRMP_START_BIT_THOMSON,
 #endif
-
-#ifdef ANALYZE
-                    ANALYZE_PRINTF ("%8.3fms [start-bit: pulse = %2d, pause = %2d]\n", (double) (time_counter * 1000) / F_INTERRUPTS, irmp_pulse_time, irmp_pause_time);
-#endif // ANALYZE
-
-#if IRMP_SUPPORT_SIRCS_PROTOCOL == 1
-                    if (irmp_pulse_time >= SIRCS_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= SIRCS_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= SIRCS_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= SIRCS_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's SIRCS
-#ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = SIRCS, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        SIRCS_START_BIT_PULSE_LEN_MIN, SIRCS_START_BIT_PULSE_LEN_MAX,
-                                        SIRCS_START_BIT_PAUSE_LEN_MIN, SIRCS_START_BIT_PAUSE_LEN_MAX);
-#endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &sircs_param;
-                    }
-                    else
-#endif // IRMP_SUPPORT_SIRCS_PROTOCOL == 1
-
-#if IRMP_SUPPORT_JVC_PROTOCOL == 1
-                    if (irmp_protocol == IRMP_JVC_PROTOCOL &&                                                       // last protocol was JVC, awaiting repeat frame
-                        irmp_pulse_time >= JVC_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= JVC_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= JVC_REPEAT_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= JVC_REPEAT_START_BIT_PAUSE_LEN_MAX)
-                    {
-#ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = NEC or JVC (type 1) repeat frame, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        JVC_START_BIT_PULSE_LEN_MIN, JVC_START_BIT_PULSE_LEN_MAX,
-                                        JVC_REPEAT_START_BIT_PAUSE_LEN_MIN, JVC_REPEAT_START_BIT_PAUSE_LEN_MAX);
-#endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &nec_param;
-                    }
-                    else
-#endif // IRMP_SUPPORT_JVC_PROTOCOL == 1
-
-#if IRMP_SUPPORT_NEC_PROTOCOL == 1
-                    if (irmp_pulse_time >= NEC_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= NEC_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= NEC_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= NEC_START_BIT_PAUSE_LEN_MAX)
-                    {
-#if IRMP_SUPPORT_NEC42_PROTOCOL == 1
-#ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = NEC42, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        NEC_START_BIT_PULSE_LEN_MIN, NEC_START_BIT_PULSE_LEN_MAX,
-                                        NEC_START_BIT_PAUSE_LEN_MIN, NEC_START_BIT_PAUSE_LEN_MAX);
-#endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &nec42_param;
-#else
-#ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = NEC, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        NEC_START_BIT_PULSE_LEN_MIN, NEC_START_BIT_PULSE_LEN_MAX,
-                                        NEC_START_BIT_PAUSE_LEN_MIN, NEC_START_BIT_PAUSE_LEN_MAX);
-#endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &nec_param;
+#if IRMP_SUPPORT_BOSE_PROTOCOL == 1
+    IRMP_START_BIT_BOSE,
 #endif
-                    }
-                    else if (irmp_pulse_time >= NEC_START_BIT_PULSE_LEN_MIN        && irmp_pulse_time <= NEC_START_BIT_PULSE_LEN_MAX &&
-                             irmp_pause_time >= NEC_REPEAT_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= NEC_REPEAT_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's NEC
-#if IRMP_SUPPORT_JVC_PROTOCOL == 1
-                        if (irmp_protocol == IRMP_JVC_PROTOCOL)                 // last protocol was JVC, awaiting repeat frame
-                        {                                                       // some jvc remote controls use nec repetition frame for jvc repetition frame
+#if IRMP_SUPPORT_RC6_PROTOCOL == 1
+    IRMP_START_BIT_RC6,
+#endif
+#if IRMP_SUPPORT_RECS80EXT_PROTOCOL == 1
+    IRMP_START_BIT_RECS80EXT,
+#endif
+#if IRMP_SUPPORT_NUBERT_PROTOCOL == 1
+    IRMP_START_BIT_NUBERT,
+#endif
+#if IRMP_SUPPORT_FAN_PROTOCOL == 1
+    IRMP_START_BIT_FAN,
+#endif
+#if IRMP_SUPPORT_SPEAKER_PROTOCOL == 1
+    IRMP_START_BIT_SPEAKER,
+#endif
+#if IRMP_SUPPORT_BANG_OLUFSEN_PROTOCOL == 1
+    IRMP_START_BIT_BANG_OLUFSEN,
+#endif
+#if IRMP_SUPPORT_GRUNDIG_NOKIA_IR60_PROTOCOL == 1
+    IRMP_START_BIT_GRUNDIG_NOKIA_IR60,
+#endif
+#if IRMP_SUPPORT_MERLIN_PROTOCOL == 1
+    IRMP_START_BIT_MERLIN,
+#endif
+#if IRMP_SUPPORT_SIEMENS_OR_RUWIDO_PROTOCOL == 1
+    IRMP_START_BIT_SIEMENS_OR_RUWIDO,
+#endif
+#if IRMP_SUPPORT_FDC_PROTOCOL == 1
+    IRMP_START_BIT_FDC,
+#endif
+#if IRMP_SUPPORT_RCCAR_PROTOCOL == 1
+    IRMP_START_BIT_RCCAR,
+#endif
+#if IRMP_SUPPORT_KATHREIN_PROTOCOL == 1
+    IRMP_START_BIT_KATHREIN,
+#endif
+#if IRMP_SUPPORT_NETBOX_PROTOCOL == 1
+    IRMP_START_BIT_NETBOX,
+#endif
+#if IRMP_SUPPORT_LEGO_PROTOCOL == 1
+    IRMP_START_BIT_LEGO,
+#endif
+#if IRMP_SUPPORT_A1TVBOX_PROTOCOL == 1
+    IRMP_START_BIT_A1TVBOX,
+#endif
+#if IRMP_SUPPORT_ORTEK_PROTOCOL == 1
+    IRMP_START_BIT_ORTEK,
+#endif
+#if IRMP_SUPPORT_RCMM_PROTOCOL == 1
+    IRMP_START_BIT_RCMM,
+#endif
+    IRMP_N_START_BITS
+};
+
+typedef struct
+{
+    uint16_t    pulse_min;                                                  // 1st pulse window
+    uint16_t    pulse_max;
+    uint16_t    pulse2_min;                                                 // 2nd pulse window
+    uint16_t    pulse2_max;
+    uint16_t    pause_min;                                                  // 1st pause window
+    uint16_t    pause_max;
+    uint16_t    pause2_min;                                                 // 2nd pause window
+    uint16_t    pause2_max;
+    uint64_t    protocols;                                                  // protocols which can be detected by this check
+} IRMP_START_BIT;
+
+#define IRMP_START_BIT_NONE                     1, 0                        // empty window
+#define IRMP_NEC_PROTOCOLS                      (IRMP_PROTOCOL_BIT (IRMP_NEC_PROTOCOL) | IRMP_PROTOCOL_BIT (IRMP_NEC16_PROTOCOL) | \
+                                                 IRMP_PROTOCOL_BIT (IRMP_NEC42_PROTOCOL) | IRMP_PROTOCOL_BIT (IRMP_JVC_PROTOCOL) | \
+                                                 IRMP_PROTOCOL_BIT (IRMP_LGAIR_PROTOCOL) | IRMP_PROTOCOL_BIT (IRMP_APPLE_PROTOCOL))
+
+static const PROGMEM IRMP_START_BIT irmp_start_bits[] =
+{
+#if IRMP_SUPPORT_SIRCS_PROTOCOL == 1
+    { SIRCS_START_BIT_PULSE_LEN_MIN, SIRCS_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      SIRCS_START_BIT_PAUSE_LEN_MIN, SIRCS_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_SIRCS_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_JVC_PROTOCOL == 1
+    { JVC_START_BIT_PULSE_LEN_MIN, JVC_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      JVC_REPEAT_START_BIT_PAUSE_LEN_MIN, JVC_REPEAT_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_NEC_PROTOCOLS },
+#endif
+#if IRMP_SUPPORT_NEC_PROTOCOL == 1
+    { NEC_START_BIT_PULSE_LEN_MIN, NEC_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      NEC_START_BIT_PAUSE_LEN_MIN, NEC_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_NEC_PROTOCOLS },
+#endif
+#if IRMP_SUPPORT_NEC_PROTOCOL == 1
+    { NEC_START_BIT_PULSE_LEN_MIN, NEC_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      NEC_REPEAT_START_BIT_PAUSE_LEN_MIN, NEC_REPEAT_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_NEC_PROTOCOLS },
+#endif
+#if IRMP_SUPPORT_NEC_PROTOCOL == 1 && IRMP_SUPPORT_JVC_PROTOCOL == 1
+    { NEC_START_BIT_PULSE_LEN_MIN, NEC_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      NEC_0_PAUSE_LEN_MIN, NEC_0_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_NEC_PROTOCOLS },
+#endif
+#if IRMP_SUPPORT_TELEFUNKEN_PROTOCOL == 1
+    { TELEFUNKEN_START_BIT_PULSE_LEN_MIN, TELEFUNKEN_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      TELEFUNKEN_START_BIT_PAUSE_LEN_MIN, TELEFUNKEN_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_TELEFUNKEN_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_ROOMBA_PROTOCOL == 1
+    { ROOMBA_START_BIT_PULSE_LEN_MIN, ROOMBA_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      ROOMBA_START_BIT_PAUSE_LEN_MIN, ROOMBA_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_ROOMBA_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_ACP24_PROTOCOL == 1
+    { ACP24_START_BIT_PULSE_LEN_MIN, ACP24_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      ACP24_START_BIT_PAUSE_LEN_MIN, ACP24_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_ACP24_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_PENTAX_PROTOCOL == 1
+    { PENTAX_START_BIT_PULSE_LEN_MIN, PENTAX_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      PENTAX_START_BIT_PAUSE_LEN_MIN, PENTAX_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_PENTAX_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_NIKON_PROTOCOL == 1
+    { NIKON_START_BIT_PULSE_LEN_MIN, NIKON_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      NIKON_START_BIT_PAUSE_LEN_MIN, NIKON_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_NIKON_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_SAMSUNG_PROTOCOL == 1
+    { SAMSUNG_START_BIT_PULSE_LEN_MIN, SAMSUNG_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      SAMSUNG_START_BIT_PAUSE_LEN_MIN, SAMSUNG_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_SAMSUNG_PROTOCOL) | IRMP_PROTOCOL_BIT (IRMP_SAMSUNG32_PROTOCOL) | IRMP_PROTOCOL_BIT (IRMP_SAMSUNG48_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_MATSUSHITA_PROTOCOL == 1
+    { MATSUSHITA_START_BIT_PULSE_LEN_MIN, MATSUSHITA_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      MATSUSHITA_START_BIT_PAUSE_LEN_MIN, MATSUSHITA_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_MATSUSHITA_PROTOCOL) | IRMP_PROTOCOL_BIT (IRMP_TECHNICS_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_KASEIKYO_PROTOCOL == 1
+    { KASEIKYO_START_BIT_PULSE_LEN_MIN, KASEIKYO_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      KASEIKYO_START_BIT_PAUSE_LEN_MIN, KASEIKYO_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_KASEIKYO_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_PANASONIC_PROTOCOL == 1
+    { PANASONIC_START_BIT_PULSE_LEN_MIN, PANASONIC_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      PANASONIC_START_BIT_PAUSE_LEN_MIN, PANASONIC_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_PANASONIC_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_RADIO1_PROTOCOL == 1
+    { RADIO1_START_BIT_PULSE_LEN_MIN, RADIO1_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      RADIO1_START_BIT_PAUSE_LEN_MIN, RADIO1_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_RADIO1_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_RECS80_PROTOCOL == 1
+    { RECS80_START_BIT_PULSE_LEN_MIN, RECS80_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      RECS80_START_BIT_PAUSE_LEN_MIN, RECS80_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_RECS80_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_S100_PROTOCOL == 1
+    { S100_START_BIT_LEN_MIN, S100_START_BIT_LEN_MAX, 2 * S100_START_BIT_LEN_MIN, 2 * S100_START_BIT_LEN_MAX,
+      S100_START_BIT_LEN_MIN, S100_START_BIT_LEN_MAX, 2 * S100_START_BIT_LEN_MIN, 2 * S100_START_BIT_LEN_MAX,
+      IRMP_PROTOCOL_BIT (IRMP_S100_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_RC5_PROTOCOL == 1
+    { RC5_START_BIT_LEN_MIN, RC5_START_BIT_LEN_MAX, 2 * RC5_START_BIT_LEN_MIN, 2 * RC5_START_BIT_LEN_MAX,
+      RC5_START_BIT_LEN_MIN, RC5_START_BIT_LEN_MAX, 2 * RC5_START_BIT_LEN_MIN, 2 * RC5_START_BIT_LEN_MAX,
+      IRMP_PROTOCOL_BIT (IRMP_RC5_PROTOCOL) | IRMP_PROTOCOL_BIT (IRMP_FDC_PROTOCOL) | IRMP_PROTOCOL_BIT (IRMP_RCCAR_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_DENON_PROTOCOL == 1
+    { DENON_PULSE_LEN_MIN, DENON_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      DENON_1_PAUSE_LEN_MIN, DENON_1_PAUSE_LEN_MAX, DENON_0_PAUSE_LEN_MIN, DENON_0_PAUSE_LEN_MAX,
+      IRMP_PROTOCOL_BIT (IRMP_DENON_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_THOMSON_PROTOCOL == 1
+    { THOMSON_PULSE_LEN_MIN, THOMSON_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      THOMSON_1_PAUSE_LEN_MIN, THOMSON_1_PAUSE_LEN_MAX, THOMSON_0_PAUSE_LEN_MIN, THOMSON_0_PAUSE_LEN_MAX,
+      IRMP_PROTOCOL_BIT (IRMP_THOMSON_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_BOSE_PROTOCOL == 1
+    { BOSE_START_BIT_PULSE_LEN_MIN, BOSE_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      BOSE_START_BIT_PAUSE_LEN_MIN, BOSE_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_BOSE_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_RC6_PROTOCOL == 1
+    { RC6_START_BIT_PULSE_LEN_MIN, RC6_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      RC6_START_BIT_PAUSE_LEN_MIN, RC6_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_RC6_PROTOCOL) | IRMP_PROTOCOL_BIT (IRMP_RC6A_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_RECS80EXT_PROTOCOL == 1
+    { RECS80EXT_START_BIT_PULSE_LEN_MIN, RECS80EXT_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      RECS80EXT_START_BIT_PAUSE_LEN_MIN, RECS80EXT_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_RECS80EXT_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_NUBERT_PROTOCOL == 1
+    { NUBERT_START_BIT_PULSE_LEN_MIN, NUBERT_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      NUBERT_START_BIT_PAUSE_LEN_MIN, NUBERT_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_NUBERT_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_FAN_PROTOCOL == 1
+    { FAN_START_BIT_PULSE_LEN_MIN, FAN_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      FAN_START_BIT_PAUSE_LEN_MIN, FAN_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_FAN_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_SPEAKER_PROTOCOL == 1
+    { SPEAKER_START_BIT_PULSE_LEN_MIN, SPEAKER_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      SPEAKER_START_BIT_PAUSE_LEN_MIN, SPEAKER_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_SPEAKER_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_BANG_OLUFSEN_PROTOCOL == 1
+    { BANG_OLUFSEN_START_BIT1_PULSE_LEN_MIN, BANG_OLUFSEN_START_BIT1_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      BANG_OLUFSEN_START_BIT1_PAUSE_LEN_MIN, BANG_OLUFSEN_START_BIT1_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_BANG_OLUFSEN_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_GRUNDIG_NOKIA_IR60_PROTOCOL == 1
+    { GRUNDIG_NOKIA_IR60_START_BIT_LEN_MIN, GRUNDIG_NOKIA_IR60_START_BIT_LEN_MAX, IRMP_START_BIT_NONE,
+      GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN_MIN, GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_GRUNDIG_PROTOCOL) | IRMP_PROTOCOL_BIT (IRMP_NOKIA_PROTOCOL) | IRMP_PROTOCOL_BIT (IRMP_IR60_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_MERLIN_PROTOCOL == 1
+    { MERLIN_START_BIT_PULSE_LEN_MIN, MERLIN_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      MERLIN_START_BIT_PAUSE_LEN_MIN, MERLIN_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_MERLIN_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_SIEMENS_OR_RUWIDO_PROTOCOL == 1
+    { SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MIN, SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MAX, 2 * SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MIN, 2 * SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MAX,
+      SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MIN, SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MAX, 2 * SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MIN, 2 * SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MAX,
+      IRMP_PROTOCOL_BIT (IRMP_SIEMENS_PROTOCOL) | IRMP_PROTOCOL_BIT (IRMP_RUWIDO_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_FDC_PROTOCOL == 1
+    { FDC_START_BIT_PULSE_LEN_MIN, FDC_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      FDC_START_BIT_PAUSE_LEN_MIN, FDC_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_FDC_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_RCCAR_PROTOCOL == 1
+    { RCCAR_START_BIT_PULSE_LEN_MIN, RCCAR_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      RCCAR_START_BIT_PAUSE_LEN_MIN, RCCAR_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_RCCAR_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_KATHREIN_PROTOCOL == 1
+    { KATHREIN_START_BIT_PULSE_LEN_MIN, KATHREIN_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      KATHREIN_START_BIT_PAUSE_LEN_MIN, KATHREIN_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_KATHREIN_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_NETBOX_PROTOCOL == 1
+    { NETBOX_START_BIT_PULSE_LEN_MIN, NETBOX_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      NETBOX_START_BIT_PAUSE_LEN_MIN, NETBOX_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_NETBOX_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_LEGO_PROTOCOL == 1
+    { LEGO_START_BIT_PULSE_LEN_MIN, LEGO_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      LEGO_START_BIT_PAUSE_LEN_MIN, LEGO_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_LEGO_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_A1TVBOX_PROTOCOL == 1
+    { A1TVBOX_START_BIT_PULSE_LEN_MIN, A1TVBOX_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      A1TVBOX_START_BIT_PAUSE_LEN_MIN, A1TVBOX_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_A1TVBOX_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_ORTEK_PROTOCOL == 1
+    { ORTEK_START_BIT_PULSE_LEN_MIN, ORTEK_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      ORTEK_START_BIT_PAUSE_LEN_MIN, ORTEK_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_ORTEK_PROTOCOL) },
+#endif
+#if IRMP_SUPPORT_RCMM_PROTOCOL == 1
+    { RCMM32_START_BIT_PULSE_LEN_MIN, RCMM32_START_BIT_PULSE_LEN_MAX, IRMP_START_BIT_NONE,
+      RCMM32_START_BIT_PAUSE_LEN_MIN, RCMM32_START_BIT_PAUSE_LEN_MAX, IRMP_START_BIT_NONE,
+      IRMP_PROTOCOL_BIT (IRMP_RCMM32_PROTOCOL) | IRMP_PROTOCOL_BIT (IRMP_RCMM24_PROTOCOL) | IRMP_PROTOCOL_BIT (IRMP_RCMM12_PROTOCOL) },
+#endif
+    { IRMP_START_BIT_NONE, IRMP_START_BIT_NONE, IRMP_START_BIT_NONE, IRMP_START_BIT_NONE, 0 }  // dummy, avoids empty array
+};
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Start bit candidates
+ *  @details  bit n of irmp_start_bit_pulse_mask[t >> IRMP_START_BIT_SHIFT] is set if the pulse window of check n overlaps with the
+ *            ticks t ... t + (1 << IRMP_START_BIT_SHIFT) - 1, the last entry covers all longer pulses. Same for the pause.
+ *            Both tables are filled by irmp_init_start_bits().
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#define IRMP_START_BIT_SHIFT                    2
+#define IRMP_START_BIT_BUCKETS                  ((256 >> IRMP_START_BIT_SHIFT) + 1)
+#define IRMP_START_BIT_BUCKET(t)                (((t) >> IRMP_START_BIT_SHIFT) < IRMP_START_BIT_BUCKETS - 1 ? ((t) >> IRMP_START_BIT_SHIFT) : IRMP_START_BIT_BUCKETS - 1)
+
+#define IRMP_START_BIT_COUNT                   (IRMP_SUPPORT_SIRCS_PROTOCOL + \
+                                                 IRMP_SUPPORT_JVC_PROTOCOL + \
+                                                 IRMP_SUPPORT_NEC_PROTOCOL + \
+                                                 IRMP_SUPPORT_NEC_PROTOCOL + \
+                                                 (IRMP_SUPPORT_NEC_PROTOCOL && IRMP_SUPPORT_JVC_PROTOCOL) + \
+                                                 IRMP_SUPPORT_TELEFUNKEN_PROTOCOL + \
+                                                 IRMP_SUPPORT_ROOMBA_PROTOCOL + \
+                                                 IRMP_SUPPORT_ACP24_PROTOCOL + \
+                                                 IRMP_SUPPORT_PENTAX_PROTOCOL + \
+                                                 IRMP_SUPPORT_NIKON_PROTOCOL + \
+                                                 IRMP_SUPPORT_SAMSUNG_PROTOCOL + \
+                                                 IRMP_SUPPORT_MATSUSHITA_PROTOCOL + \
+                                                 IRMP_SUPPORT_KASEIKYO_PROTOCOL + \
+                                                 IRMP_SUPPORT_PANASONIC_PROTOCOL + \
+                                                 IRMP_SUPPORT_RADIO1_PROTOCOL + \
+                                                 IRMP_SUPPORT_RECS80_PROTOCOL + \
+                                                 IRMP_SUPPORT_S100_PROTOCOL + \
+                                                 IRMP_SUPPORT_RC5_PROTOCOL + \
+                                                 IRMP_SUPPORT_DENON_PROTOCOL + \
+                                                 IRMP_SUPPORT_THOMSON_PROTOCOL + \
+                                                 IRMP_SUPPORT_BOSE_PROTOCOL + \
+                                                 IRMP_SUPPORT_RC6_PROTOCOL + \
+                                                 IRMP_SUPPORT_RECS80EXT_PROTOCOL + \
+                                                 IRMP_SUPPORT_NUBERT_PROTOCOL + \
+                                                 IRMP_SUPPORT_FAN_PROTOCOL + \
+                                                 IRMP_SUPPORT_SPEAKER_PROTOCOL + \
+                                                 IRMP_SUPPORT_BANG_OLUFSEN_PROTOCOL + \
+                                                 IRMP_SUPPORT_GRUNDIG_NOKIA_IR60_PROTOCOL + \
+                                                 IRMP_SUPPORT_MERLIN_PROTOCOL + \
+                                                 IRMP_SUPPORT_SIEMENS_OR_RUWIDO_PROTOCOL + \
+                                                 IRMP_SUPPORT_FDC_PROTOCOL + \
+                                                 IRMP_SUPPORT_RCCAR_PROTOCOL + \
+                                                 IRMP_SUPPORT_KATHREIN_PROTOCOL + \
+                                                 IRMP_SUPPORT_NETBOX_PROTOCOL + \
+                                                 IRMP_SUPPORT_LEGO_PROTOCOL + \
+                                                 IRMP_SUPPORT_A1TVBOX_PROTOCOL + \
+                                                 IRMP_SUPPORT_ORTEK_PROTOCOL + \
+                                                 IRMP_SUPPORT_RCMM_PROTOCOL)
+
+#if IRMP_START_BIT_COUNT > 32
+typedef uint64_t                                IRMP_START_BIT_MASK;
+#else
+typedef uint32_t                                IRMP_START_BIT_MASK;
+#endif
+
+static IRMP_START_BIT_MASK                      irmp_start_bit_pulse_mask[IRMP_START_BIT_BUCKETS];
+static IRMP_START_BIT_MASK                      irmp_start_bit_pause_mask[IRMP_START_BIT_BUCKETS];
+
+#if IRMP_USE_PROTOCOL_MASK == 1
+static volatile IRMP_START_BIT_MASK             irmp_start_bit_enable_mask = (IRMP_START_BIT_MASK) ~0;  // bit n: check n may run
+#endif
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Check window against bucket
+ *  @details  checks if a start bit window overlaps with the ticks of a bucket of the candidate tables
+ *  @param    bucket, window min, window max
+ *  @return   TRUE: overlap, FALSE: no overlap or empty window
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static uint_fast8_t
+irmp_start_bit_overlap (uint_fast16_t bucket, uint_fast16_t len_min, uint_fast16_t len_max)
+{
+    uint_fast16_t   first = bucket << IRMP_START_BIT_SHIFT;
+    uint_fast16_t   last  = first + (1 << IRMP_START_BIT_SHIFT) - 1;
+
+    if (bucket == IRMP_START_BIT_BUCKETS - 1)
+    {
+        last = 0xFFFF;
+    }
+
+    return (len_min <= len_max && len_min <= last && len_max >= first);
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Initialize start bit candidates
+ *  @details  fills irmp_start_bit_pulse_mask[] and irmp_start_bit_pause_mask[] from irmp_start_bits[]
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+irmp_init_start_bits (void)
+{
+    IRMP_START_BIT          sb;
+    IRMP_START_BIT_MASK     bit;
+    uint_fast8_t            i;
+    uint_fast16_t           bucket;
+
+    for (bucket = 0; bucket < IRMP_START_BIT_BUCKETS; bucket++)
+    {
+        irmp_start_bit_pulse_mask[bucket] = 0;
+        irmp_start_bit_pause_mask[bucket] = 0;
+    }
+
+    for (i = 0; i < IRMP_N_START_BITS; i++)
+    {
+        memcpy_P (&sb, irmp_start_bits + i, sizeof (IRMP_START_BIT));
+        bit = (IRMP_START_BIT_MASK) 1 << i;
+
+        for (bucket = 0; bucket < IRMP_START_BIT_BUCKETS; bucket++)
+        {
+            if (irmp_start_bit_overlap (bucket, sb.pulse_min, sb.pulse_max) || irmp_start_bit_overlap (bucket, sb.pulse2_min, sb.pulse2_max))
+            {
+                irmp_start_bit_pulse_mask[bucket] |= bit;
+            }
+
+            if (irmp_start_bit_overlap (bucket, sb.pause_min, sb.pause_max) || irmp_start_bit_overlap (bucket, sb.pause2_min, sb.pause2_max))
+            {
+                irmp_start_bit_pause_mask[bucket] |= bit;
+            }
+        }
+    }
+}
+
+#if IRMP_USE_PROTOCOL_MASK == 1
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Set protocol mask
+ *  @details  enables or disables protocols at runtime, bit n enables protocol n (see irmpprotocols.h). Start bit checks which
+ *            cannot detect any enabled protocol are skipped, frames of disabled protocols are dropped by irmp_get_data().
+ *            Protocols not enabled in irmpconfig.h are never detected. May be called at any time, a frame decoded while the
+ *            mask is changed may be dropped or passed.
+ *  @param    protocol mask, IRMP_ALL_PROTOCOLS enables all protocols
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+irmp_set_protocol_mask (uint64_t mask)
+{
+    IRMP_START_BIT          sb;
+    IRMP_START_BIT_MASK     enable = 0;
+    uint_fast8_t            i;
+
+    for (i = 0; i < IRMP_N_START_BITS; i++)
+    {
+        memcpy_P (&sb, irmp_start_bits + i, sizeof (IRMP_START_BIT));
+
+        if (sb.protocols & mask)
+        {
+            enable |= (IRMP_START_BIT_MASK) 1 << i;
+        }
+    }
+
+    irmp_protocol_mask = mask;
+    irmp_start_bit_enable_mask = enable;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Get protocol mask
+ *  @return   protocol mask set by irmp_set_protocol_mask()
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint64_t
+irmp_get_protocol_mask (void)
+{
+    return irmp_protocol_mask;
+}
+#endif // IRMP_USE_PROTOCOL_MASK == 1
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Classify start bit
+ *  @details  looks up the checks whose windows fit the start bit pulse and pause and runs only these checks, in the order of
+ *            irmp_start_bits[]. The first successful check wins. Some checks also depend on the last received protocol.
+ *            Checks of protocols disabled by irmp_set_protocol_mask() are skipped.
+ *  @param    pointer to decoder state
+ *  @return   parameters of detected protocol, 0 if no protocol matches
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static IRMP_PARAMETER *
+irmp_classify_start_bit (irmp_state_t * st)
+{
+    IRMP_PARAMETER *        irmp_param_p = (IRMP_PARAMETER *) 0;
+    IRMP_START_BIT_MASK     candidates;
+    uint_fast8_t            idx;
+
+    candidates = irmp_start_bit_pulse_mask[IRMP_START_BIT_BUCKET (st->irmp_pulse_time)] &
+                 irmp_start_bit_pause_mask[IRMP_START_BIT_BUCKET (st->irmp_pause_time)];
+#if IRMP_USE_PROTOCOL_MASK == 1
+    candidates &= irmp_start_bit_enable_mask;
+#endif
+
+    while (candidates && ! irmp_param_p)
+    {
+#if defined(__GNUC__)
+        if (sizeof (IRMP_START_BIT_MASK) > sizeof (unsigned long))
+        {
+            idx = __builtin_ctzll (candidates);
+        }
+        else
+        {
+            idx = __builtin_ctzl (candidates);
+        }
+#else
+        for (idx = 0; ! (candidates & ((IRMP_START_BIT_MASK) 1 << idx)); idx++)
+        {
+            ;
+        }
+#endif
+        candidates &= candidates - 1;                                           // remove lowest bit
+
+        switch (idx)
+        {
+#if IRMP_SUPPORT_SIRCS_PROTOCOL == 1
+            case IRMP_START_BIT_SIRCS:
+                if (st->irmp_pulse_time >= SIRCS_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= SIRCS_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= SIRCS_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= SIRCS_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's SIRCS
 #ifdef ANALYZE
-                            ANALYZE_PRINTF ("protocol = JVC repeat frame type 2, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                            NEC_START_BIT_PULSE_LEN_MIN, NEC_START_BIT_PULSE_LEN_MAX,
-                                            NEC_REPEAT_START_BIT_PAUSE_LEN_MIN, NEC_REPEAT_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = SIRCS, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    SIRCS_START_BIT_PULSE_LEN_MIN, SIRCS_START_BIT_PULSE_LEN_MAX,
+                                    SIRCS_START_BIT_PAUSE_LEN_MIN, SIRCS_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                            irmp_param_p = (IRMP_PARAMETER *) &nec_param;
-                        }
-                        else
-#endif // IRMP_SUPPORT_JVC_PROTOCOL == 1
-                        {
+                    irmp_param_p = (IRMP_PARAMETER *) &sircs_param;
+                }
+                break;
+#endif // IRMP_SUPPORT_SIRCS_PROTOCOL == 1
+
+#if IRMP_SUPPORT_JVC_PROTOCOL == 1
+            case IRMP_START_BIT_JVC_REPETITION_1:
+                if (st->irmp_protocol == IRMP_JVC_PROTOCOL &&                                                       // last protocol was JVC, awaiting repeat frame
+                    st->irmp_pulse_time >= JVC_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= JVC_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= JVC_REPEAT_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= JVC_REPEAT_START_BIT_PAUSE_LEN_MAX)
+                {
 #ifdef ANALYZE
-                            ANALYZE_PRINTF ("protocol = NEC (repetition frame), start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                            NEC_START_BIT_PULSE_LEN_MIN, NEC_START_BIT_PULSE_LEN_MAX,
-                                            NEC_REPEAT_START_BIT_PAUSE_LEN_MIN, NEC_REPEAT_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = NEC or JVC (type 1) repeat frame, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    JVC_START_BIT_PULSE_LEN_MIN, JVC_START_BIT_PULSE_LEN_MAX,
+                                    JVC_REPEAT_START_BIT_PAUSE_LEN_MIN, JVC_REPEAT_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
+                    irmp_param_p = (IRMP_PARAMETER *) &nec_param;
+                }
+                break;
+#endif // IRMP_SUPPORT_JVC_PROTOCOL == 1
 
-                            irmp_param_p = (IRMP_PARAMETER *) &nec_rep_param;
-                        }
-                    }
-                    else
+#if IRMP_SUPPORT_NEC_PROTOCOL == 1
+            case IRMP_START_BIT_NEC:
+                if (st->irmp_pulse_time >= NEC_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= NEC_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= NEC_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= NEC_START_BIT_PAUSE_LEN_MAX)
+                {
+#if IRMP_SUPPORT_NEC42_PROTOCOL == 1
+#ifdef ANALYZE
+                    ANALYZE_PRINTF ("protocol = NEC42, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    NEC_START_BIT_PULSE_LEN_MIN, NEC_START_BIT_PULSE_LEN_MAX,
+                                    NEC_START_BIT_PAUSE_LEN_MIN, NEC_START_BIT_PAUSE_LEN_MAX);
+#endif // ANALYZE
+                    irmp_param_p = (IRMP_PARAMETER *) &nec42_param;
+#else
+#ifdef ANALYZE
+                    ANALYZE_PRINTF ("protocol = NEC, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    NEC_START_BIT_PULSE_LEN_MIN, NEC_START_BIT_PULSE_LEN_MAX,
+                                    NEC_START_BIT_PAUSE_LEN_MIN, NEC_START_BIT_PAUSE_LEN_MAX);
+#endif // ANALYZE
+                    irmp_param_p = (IRMP_PARAMETER *) &nec_param;
+#endif
+                }
+                break;
 
+            case IRMP_START_BIT_NEC_REPETITION:
+                if (st->irmp_pulse_time >= NEC_START_BIT_PULSE_LEN_MIN        && st->irmp_pulse_time <= NEC_START_BIT_PULSE_LEN_MAX &&
+                         st->irmp_pause_time >= NEC_REPEAT_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= NEC_REPEAT_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's NEC
 #if IRMP_SUPPORT_JVC_PROTOCOL == 1
-                    if (irmp_protocol == IRMP_JVC_PROTOCOL &&                   // last protocol was JVC, awaiting repeat frame
-                        irmp_pulse_time >= NEC_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= NEC_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= NEC_0_PAUSE_LEN_MIN         && irmp_pause_time <= NEC_0_PAUSE_LEN_MAX)
-                    {                                                           // it's JVC repetition type 3
+                    if (st->irmp_protocol == IRMP_JVC_PROTOCOL)                 // last protocol was JVC, awaiting repeat frame
+                    {                                                       // some jvc remote controls use nec repetition frame for jvc repetition frame
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = JVC repeat frame type 3, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                        ANALYZE_PRINTF ("protocol = JVC repeat frame type 2, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
                                         NEC_START_BIT_PULSE_LEN_MIN, NEC_START_BIT_PULSE_LEN_MAX,
-                                        NEC_0_PAUSE_LEN_MIN, NEC_0_PAUSE_LEN_MAX);
+                                        NEC_REPEAT_START_BIT_PAUSE_LEN_MIN, NEC_REPEAT_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
                         irmp_param_p = (IRMP_PARAMETER *) &nec_param;
                     }
                     else
 #endif // IRMP_SUPPORT_JVC_PROTOCOL == 1
+                    {
+#ifdef ANALYZE
+                        ANALYZE_PRINTF ("protocol = NEC (repetition frame), start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                        NEC_START_BIT_PULSE_LEN_MIN, NEC_START_BIT_PULSE_LEN_MAX,
+                                        NEC_REPEAT_START_BIT_PAUSE_LEN_MIN, NEC_REPEAT_START_BIT_PAUSE_LEN_MAX);
+#endif // ANALYZE
+
+                        irmp_param_p = (IRMP_PARAMETER *) &nec_rep_param;
+                    }
+                }
+                break;
 
+#if IRMP_SUPPORT_JVC_PROTOCOL == 1
+            case IRMP_START_BIT_JVC_REPETITION_3:
+                if (st->irmp_protocol == IRMP_JVC_PROTOCOL &&                   // last protocol was JVC, awaiting repeat frame
+                    st->irmp_pulse_time >= NEC_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= NEC_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= NEC_0_PAUSE_LEN_MIN         && st->irmp_pause_time <= NEC_0_PAUSE_LEN_MAX)
+                {                                                           // it's JVC repetition type 3
+#ifdef ANALYZE
+                    ANALYZE_PRINTF ("protocol = JVC repeat frame type 3, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    NEC_START_BIT_PULSE_LEN_MIN, NEC_START_BIT_PULSE_LEN_MAX,
+                                    NEC_0_PAUSE_LEN_MIN, NEC_0_PAUSE_LEN_MAX);
+#endif // ANALYZE
+                    irmp_param_p = (IRMP_PARAMETER *) &nec_param;
+                }
+                break;
+#endif // IRMP_SUPPORT_JVC_PROTOCOL == 1
 #endif // IRMP_SUPPORT_NEC_PROTOCOL == 1
 
 #if IRMP_SUPPORT_TELEFUNKEN_PROTOCOL == 1
-                    if (irmp_pulse_time >= TELEFUNKEN_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= TELEFUNKEN_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= TELEFUNKEN_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= TELEFUNKEN_START_BIT_PAUSE_LEN_MAX)
-                    {
+            case IRMP_START_BIT_TELEFUNKEN:
+                if (st->irmp_pulse_time >= TELEFUNKEN_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= TELEFUNKEN_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= TELEFUNKEN_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= TELEFUNKEN_START_BIT_PAUSE_LEN_MAX)
+                {
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = TELEFUNKEN, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        TELEFUNKEN_START_BIT_PULSE_LEN_MIN, TELEFUNKEN_START_BIT_PULSE_LEN_MAX,
-                                        TELEFUNKEN_START_BIT_PAUSE_LEN_MIN, TELEFUNKEN_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = TELEFUNKEN, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    TELEFUNKEN_START_BIT_PULSE_LEN_MIN, TELEFUNKEN_START_BIT_PULSE_LEN_MAX,
+                                    TELEFUNKEN_START_BIT_PAUSE_LEN_MIN, TELEFUNKEN_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &telefunken_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &telefunken_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_TELEFUNKEN_PROTOCOL == 1
 
 #if IRMP_SUPPORT_ROOMBA_PROTOCOL == 1
-                    if (irmp_pulse_time >= ROOMBA_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= ROOMBA_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= ROOMBA_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= ROOMBA_START_BIT_PAUSE_LEN_MAX)
-                    {
+            case IRMP_START_BIT_ROOMBA:
+                if (st->irmp_pulse_time >= ROOMBA_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= ROOMBA_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= ROOMBA_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= ROOMBA_START_BIT_PAUSE_LEN_MAX)
+                {
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = ROOMBA, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        ROOMBA_START_BIT_PULSE_LEN_MIN, ROOMBA_START_BIT_PULSE_LEN_MAX,
-                                        ROOMBA_START_BIT_PAUSE_LEN_MIN, ROOMBA_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = ROOMBA, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    ROOMBA_START_BIT_PULSE_LEN_MIN, ROOMBA_START_BIT_PULSE_LEN_MAX,
+                                    ROOMBA_START_BIT_PAUSE_LEN_MIN, ROOMBA_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &roomba_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &roomba_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_ROOMBA_PROTOCOL == 1
 
 #if IRMP_SUPPORT_ACP24_PROTOCOL == 1
-                    if (irmp_pulse_time >= ACP24_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= ACP24_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= ACP24_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= ACP24_START_BIT_PAUSE_LEN_MAX)
-                    {
+            case IRMP_START_BIT_ACP24:
+                if (st->irmp_pulse_time >= ACP24_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= ACP24_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= ACP24_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= ACP24_START_BIT_PAUSE_LEN_MAX)
+                {
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = ACP24, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        ACP24_START_BIT_PULSE_LEN_MIN, ACP24_START_BIT_PULSE_LEN_MAX,
-                                        ACP24_START_BIT_PAUSE_LEN_MIN, ACP24_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = ACP24, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    ACP24_START_BIT_PULSE_LEN_MIN, ACP24_START_BIT_PULSE_LEN_MAX,
+                                    ACP24_START_BIT_PAUSE_LEN_MIN, ACP24_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &acp24_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &acp24_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_ROOMBA_PROTOCOL == 1
 
 #if IRMP_SUPPORT_PENTAX_PROTOCOL == 1
-                    if (irmp_pulse_time >= PENTAX_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= PENTAX_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= PENTAX_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= PENTAX_START_BIT_PAUSE_LEN_MAX)
-                    {
+            case IRMP_START_BIT_PENTAX:
+                if (st->irmp_pulse_time >= PENTAX_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= PENTAX_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= PENTAX_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= PENTAX_START_BIT_PAUSE_LEN_MAX)
+                {
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = PENTAX, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        PENTAX_START_BIT_PULSE_LEN_MIN, PENTAX_START_BIT_PULSE_LEN_MAX,
-                                        PENTAX_START_BIT_PAUSE_LEN_MIN, PENTAX_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = PENTAX, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    PENTAX_START_BIT_PULSE_LEN_MIN, PENTAX_START_BIT_PULSE_LEN_MAX,
+                                    PENTAX_START_BIT_PAUSE_LEN_MIN, PENTAX_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &pentax_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &pentax_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_PENTAX_PROTOCOL == 1
 
 #if IRMP_SUPPORT_NIKON_PROTOCOL == 1
-                    if (irmp_pulse_time >= NIKON_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= NIKON_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= NIKON_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= NIKON_START_BIT_PAUSE_LEN_MAX)
-                    {
+            case IRMP_START_BIT_NIKON:
+                if (st->irmp_pulse_time >= NIKON_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= NIKON_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= NIKON_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= NIKON_START_BIT_PAUSE_LEN_MAX)
+                {
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = NIKON, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        NIKON_START_BIT_PULSE_LEN_MIN, NIKON_START_BIT_PULSE_LEN_MAX,
-                                        NIKON_START_BIT_PAUSE_LEN_MIN, NIKON_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = NIKON, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    NIKON_START_BIT_PULSE_LEN_MIN, NIKON_START_BIT_PULSE_LEN_MAX,
+                                    NIKON_START_BIT_PAUSE_LEN_MIN, NIKON_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &nikon_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &nikon_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_NIKON_PROTOCOL == 1
 
 #if IRMP_SUPPORT_SAMSUNG_PROTOCOL == 1
-                    if (irmp_pulse_time >= SAMSUNG_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= SAMSUNG_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= SAMSUNG_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= SAMSUNG_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's SAMSUNG
+            case IRMP_START_BIT_SAMSUNG:
+                if (st->irmp_pulse_time >= SAMSUNG_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= SAMSUNG_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= SAMSUNG_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= SAMSUNG_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's SAMSUNG
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = SAMSUNG, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        SAMSUNG_START_BIT_PULSE_LEN_MIN, SAMSUNG_START_BIT_PULSE_LEN_MAX,
-                                        SAMSUNG_START_BIT_PAUSE_LEN_MIN, SAMSUNG_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = SAMSUNG, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    SAMSUNG_START_BIT_PULSE_LEN_MIN, SAMSUNG_START_BIT_PULSE_LEN_MAX,
+                                    SAMSUNG_START_BIT_PAUSE_LEN_MIN, SAMSUNG_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &samsung_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &samsung_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_SAMSUNG_PROTOCOL == 1
 
 #if IRMP_SUPPORT_MATSUSHITA_PROTOCOL == 1
-                    if (irmp_pulse_time >= MATSUSHITA_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= MATSUSHITA_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= MATSUSHITA_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= MATSUSHITA_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's MATSUSHITA
+            case IRMP_START_BIT_MATSUSHITA:
+                if (st->irmp_pulse_time >= MATSUSHITA_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= MATSUSHITA_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= MATSUSHITA_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= MATSUSHITA_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's MATSUSHITA
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = MATSUSHITA, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        MATSUSHITA_START_BIT_PULSE_LEN_MIN, MATSUSHITA_START_BIT_PULSE_LEN_MAX,
-                                        MATSUSHITA_START_BIT_PAUSE_LEN_MIN, MATSUSHITA_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = MATSUSHITA, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    MATSUSHITA_START_BIT_PULSE_LEN_MIN, MATSUSHITA_START_BIT_PULSE_LEN_MAX,
+                                    MATSUSHITA_START_BIT_PAUSE_LEN_MIN, MATSUSHITA_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &matsushita_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &matsushita_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_MATSUSHITA_PROTOCOL == 1
 
 #if IRMP_SUPPORT_KASEIKYO_PROTOCOL == 1
-                    if (irmp_pulse_time >= KASEIKYO_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= KASEIKYO_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= KASEIKYO_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= KASEIKYO_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's KASEIKYO
+            case IRMP_START_BIT_KASEIKYO:
+                if (st->irmp_pulse_time >= KASEIKYO_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= KASEIKYO_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= KASEIKYO_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= KASEIKYO_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's KASEIKYO
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = KASEIKYO, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        KASEIKYO_START_BIT_PULSE_LEN_MIN, KASEIKYO_START_BIT_PULSE_LEN_MAX,
-                                        KASEIKYO_START_BIT_PAUSE_LEN_MIN, KASEIKYO_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = KASEIKYO, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    KASEIKYO_START_BIT_PULSE_LEN_MIN, KASEIKYO_START_BIT_PULSE_LEN_MAX,
+                                    KASEIKYO_START_BIT_PAUSE_LEN_MIN, KASEIKYO_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &kaseikyo_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &kaseikyo_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_KASEIKYO_PROTOCOL == 1
 
 #if IRMP_SUPPORT_PANASONIC_PROTOCOL == 1
-                    if (irmp_pulse_time >= PANASONIC_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= PANASONIC_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= PANASONIC_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= PANASONIC_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's PANASONIC
+            case IRMP_START_BIT_PANASONIC:
+                if (st->irmp_pulse_time >= PANASONIC_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= PANASONIC_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= PANASONIC_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= PANASONIC_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's PANASONIC
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = PANASONIC, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        PANASONIC_START_BIT_PULSE_LEN_MIN, PANASONIC_START_BIT_PULSE_LEN_MAX,
-                                        PANASONIC_START_BIT_PAUSE_LEN_MIN, PANASONIC_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = PANASONIC, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    PANASONIC_START_BIT_PULSE_LEN_MIN, PANASONIC_START_BIT_PULSE_LEN_MAX,
+                                    PANASONIC_START_BIT_PAUSE_LEN_MIN, PANASONIC_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &panasonic_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &panasonic_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_PANASONIC_PROTOCOL == 1
 
 #if IRMP_SUPPORT_RADIO1_PROTOCOL == 1
-                    if (irmp_pulse_time >= RADIO1_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= RADIO1_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= RADIO1_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= RADIO1_START_BIT_PAUSE_LEN_MAX)
-                    {
+            case IRMP_START_BIT_RADIO1:
+                if (st->irmp_pulse_time >= RADIO1_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= RADIO1_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= RADIO1_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= RADIO1_START_BIT_PAUSE_LEN_MAX)
+                {
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = RADIO1, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        RADIO1_START_BIT_PULSE_LEN_MIN, RADIO1_START_BIT_PULSE_LEN_MAX,
-                                        RADIO1_START_BIT_PAUSE_LEN_MIN, RADIO1_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = RADIO1, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    RADIO1_START_BIT_PULSE_LEN_MIN, RADIO1_START_BIT_PULSE_LEN_MAX,
+                                    RADIO1_START_BIT_PAUSE_LEN_MIN, RADIO1_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &radio1_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &radio1_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_RRADIO1_PROTOCOL == 1
 
 #if IRMP_SUPPORT_RECS80_PROTOCOL == 1
-                    if (irmp_pulse_time >= RECS80_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= RECS80_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= RECS80_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= RECS80_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's RECS80
+            case IRMP_START_BIT_RECS80:
+                if (st->irmp_pulse_time >= RECS80_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= RECS80_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= RECS80_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= RECS80_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's RECS80
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = RECS80, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        RECS80_START_BIT_PULSE_LEN_MIN, RECS80_START_BIT_PULSE_LEN_MAX,
-                                        RECS80_START_BIT_PAUSE_LEN_MIN, RECS80_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = RECS80, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    RECS80_START_BIT_PULSE_LEN_MIN, RECS80_START_BIT_PULSE_LEN_MAX,
+                                    RECS80_START_BIT_PAUSE_LEN_MIN, RECS80_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &recs80_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &recs80_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_RECS80_PROTOCOL == 1
 
 #if IRMP_SUPPORT_S100_PROTOCOL == 1
-                    if (((irmp_pulse_time >= S100_START_BIT_LEN_MIN     && irmp_pulse_time <= S100_START_BIT_LEN_MAX) ||
-                         (irmp_pulse_time >= 2 * S100_START_BIT_LEN_MIN && irmp_pulse_time <= 2 * S100_START_BIT_LEN_MAX)) &&
-                        ((irmp_pause_time >= S100_START_BIT_LEN_MIN     && irmp_pause_time <= S100_START_BIT_LEN_MAX) ||
-                         (irmp_pause_time >= 2 * S100_START_BIT_LEN_MIN && irmp_pause_time <= 2 * S100_START_BIT_LEN_MAX)))
-                    {                                                           // it's S100
+            case IRMP_START_BIT_S100:
+                if (((st->irmp_pulse_time >= S100_START_BIT_LEN_MIN     && st->irmp_pulse_time <= S100_START_BIT_LEN_MAX) ||
+                     (st->irmp_pulse_time >= 2 * S100_START_BIT_LEN_MIN && st->irmp_pulse_time <= 2 * S100_START_BIT_LEN_MAX)) &&
+                    ((st->irmp_pause_time >= S100_START_BIT_LEN_MIN     && st->irmp_pause_time <= S100_START_BIT_LEN_MAX) ||
+                     (st->irmp_pause_time >= 2 * S100_START_BIT_LEN_MIN && st->irmp_pause_time <= 2 * S100_START_BIT_LEN_MAX)))
+                {                                                           // it's S100
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = S100, start bit timings: pulse: %3d - %3d, pause: %3d - %3d or pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        S100_START_BIT_LEN_MIN, S100_START_BIT_LEN_MAX,
-                                        2 * S100_START_BIT_LEN_MIN, 2 * S100_START_BIT_LEN_MAX,
-                                        S100_START_BIT_LEN_MIN, S100_START_BIT_LEN_MAX,
-                                        2 * S100_START_BIT_LEN_MIN, 2 * S100_START_BIT_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = S100, start bit timings: pulse: %3d - %3d, pause: %3d - %3d or pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    S100_START_BIT_LEN_MIN, S100_START_BIT_LEN_MAX,
+                                    2 * S100_START_BIT_LEN_MIN, 2 * S100_START_BIT_LEN_MAX,
+                                    S100_START_BIT_LEN_MIN, S100_START_BIT_LEN_MAX,
+                                    2 * S100_START_BIT_LEN_MIN, 2 * S100_START_BIT_LEN_MAX);
 #endif // ANALYZE
 
-                        irmp_param_p = (IRMP_PARAMETER *) &s100_param;
-                        last_pause = irmp_pause_time;
+                    irmp_param_p = (IRMP_PARAMETER *) &s100_param;
+                    st->last_pause = st->irmp_pause_time;
 
-                        if ((irmp_pulse_time > S100_START_BIT_LEN_MAX && irmp_pulse_time <= 2 * S100_START_BIT_LEN_MAX) ||
-                            (irmp_pause_time > S100_START_BIT_LEN_MAX && irmp_pause_time <= 2 * S100_START_BIT_LEN_MAX))
-                        {
-                          last_value  = 0;
-                          rc5_cmd_bit6 = 1<<6;
-                        }
-                        else
-                        {
-                          last_value  = 1;
-                        }
+                    if ((st->irmp_pulse_time > S100_START_BIT_LEN_MAX && st->irmp_pulse_time <= 2 * S100_START_BIT_LEN_MAX) ||
+                        (st->irmp_pause_time > S100_START_BIT_LEN_MAX && st->irmp_pause_time <= 2 * S100_START_BIT_LEN_MAX))
+                    {
+                      st->last_value  = 0;
+                      st->rc5_cmd_bit6 = 1<<6;
                     }
                     else
+                    {
+                      st->last_value  = 1;
+                    }
+                }
+                break;
 #endif // IRMP_SUPPORT_S100_PROTOCOL == 1
 
 #if IRMP_SUPPORT_RC5_PROTOCOL == 1
-                    if (((irmp_pulse_time >= RC5_START_BIT_LEN_MIN     && irmp_pulse_time <= RC5_START_BIT_LEN_MAX) ||
-                         (irmp_pulse_time >= 2 * RC5_START_BIT_LEN_MIN && irmp_pulse_time <= 2 * RC5_START_BIT_LEN_MAX)) &&
-                        ((irmp_pause_time >= RC5_START_BIT_LEN_MIN     && irmp_pause_time <= RC5_START_BIT_LEN_MAX) ||
-                         (irmp_pause_time >= 2 * RC5_START_BIT_LEN_MIN && irmp_pause_time <= 2 * RC5_START_BIT_LEN_MAX)))
-                    {                                                           // it's RC5
+            case IRMP_START_BIT_RC5:
+                if (((st->irmp_pulse_time >= RC5_START_BIT_LEN_MIN     && st->irmp_pulse_time <= RC5_START_BIT_LEN_MAX) ||
+                     (st->irmp_pulse_time >= 2 * RC5_START_BIT_LEN_MIN && st->irmp_pulse_time <= 2 * RC5_START_BIT_LEN_MAX)) &&
+                    ((st->irmp_pause_time >= RC5_START_BIT_LEN_MIN     && st->irmp_pause_time <= RC5_START_BIT_LEN_MAX) ||
+                     (st->irmp_pause_time >= 2 * RC5_START_BIT_LEN_MIN && st->irmp_pause_time <= 2 * RC5_START_BIT_LEN_MAX)))
+                {                                                           // it's RC5
 #if IRMP_SUPPORT_FDC_PROTOCOL == 1
-                        if (irmp_pulse_time >= FDC_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= FDC_START_BIT_PULSE_LEN_MAX &&
-                            irmp_pause_time >= FDC_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= FDC_START_BIT_PAUSE_LEN_MAX)
-                        {
+                    if (st->irmp_pulse_time >= FDC_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= FDC_START_BIT_PULSE_LEN_MAX &&
+                        st->irmp_pause_time >= FDC_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= FDC_START_BIT_PAUSE_LEN_MAX)
+                    {
 #ifdef ANALYZE
-                            ANALYZE_PRINTF ("protocol = RC5 or FDC\n");
-                            ANALYZE_PRINTF ("FDC start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                            FDC_START_BIT_PULSE_LEN_MIN, FDC_START_BIT_PULSE_LEN_MAX,
-                                            FDC_START_BIT_PAUSE_LEN_MIN, FDC_START_BIT_PAUSE_LEN_MAX);
-                            ANALYZE_PRINTF ("RC5 start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                            RC5_START_BIT_LEN_MIN, RC5_START_BIT_LEN_MAX,
-                                            RC5_START_BIT_LEN_MIN, RC5_START_BIT_LEN_MAX);
+                        ANALYZE_PRINTF ("protocol = RC5 or FDC\n");
+                        ANALYZE_PRINTF ("FDC start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                        FDC_START_BIT_PULSE_LEN_MIN, FDC_START_BIT_PULSE_LEN_MAX,
+                                        FDC_START_BIT_PAUSE_LEN_MIN, FDC_START_BIT_PAUSE_LEN_MAX);
+                        ANALYZE_PRINTF ("RC5 start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                        RC5_START_BIT_LEN_MIN, RC5_START_BIT_LEN_MAX,
+                                        RC5_START_BIT_LEN_MIN, RC5_START_BIT_LEN_MAX);
 #endif // ANALYZE
-                            memcpy_P (&irmp_param2, &fdc_param, sizeof (IRMP_PARAMETER));
-                        }
-                        else
+                        memcpy_P (&st->irmp_param2, &fdc_param, sizeof (IRMP_PARAMETER));
+                    }
+                    else
 #endif // IRMP_SUPPORT_FDC_PROTOCOL == 1
 
 #if IRMP_SUPPORT_RCCAR_PROTOCOL == 1
-                        if (irmp_pulse_time >= RCCAR_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= RCCAR_START_BIT_PULSE_LEN_MAX &&
-                            irmp_pause_time >= RCCAR_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= RCCAR_START_BIT_PAUSE_LEN_MAX)
-                        {
+                    if (st->irmp_pulse_time >= RCCAR_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= RCCAR_START_BIT_PULSE_LEN_MAX &&
+                        st->irmp_pause_time >= RCCAR_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= RCCAR_START_BIT_PAUSE_LEN_MAX)
+                    {
 #ifdef ANALYZE
-                            ANALYZE_PRINTF ("protocol = RC5 or RCCAR\n");
-                            ANALYZE_PRINTF ("RCCAR start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                            RCCAR_START_BIT_PULSE_LEN_MIN, RCCAR_START_BIT_PULSE_LEN_MAX,
-                                            RCCAR_START_BIT_PAUSE_LEN_MIN, RCCAR_START_BIT_PAUSE_LEN_MAX);
-                            ANALYZE_PRINTF ("RC5 start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                            RC5_START_BIT_LEN_MIN, RC5_START_BIT_LEN_MAX,
-                                            RC5_START_BIT_LEN_MIN, RC5_START_BIT_LEN_MAX);
+                        ANALYZE_PRINTF ("protocol = RC5 or RCCAR\n");
+                        ANALYZE_PRINTF ("RCCAR start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                        RCCAR_START_BIT_PULSE_LEN_MIN, RCCAR_START_BIT_PULSE_LEN_MAX,
+                                        RCCAR_START_BIT_PAUSE_LEN_MIN, RCCAR_START_BIT_PAUSE_LEN_MAX);
+                        ANALYZE_PRINTF ("RC5 start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                        RC5_START_BIT_LEN_MIN, RC5_START_BIT_LEN_MAX,
+                                        RC5_START_BIT_LEN_MIN, RC5_START_BIT_LEN_MAX);
 #endif // ANALYZE
-                            memcpy_P (&irmp_param2, &rccar_param, sizeof (IRMP_PARAMETER));
-                        }
-                        else
+                        memcpy_P (&st->irmp_param2, &rccar_param, sizeof (IRMP_PARAMETER));
+                    }
+                    else
 #endif // IRMP_SUPPORT_RCCAR_PROTOCOL == 1
-                        {
+                    {
 #ifdef ANALYZE
-                            ANALYZE_PRINTF ("protocol = RC5, start bit timings: pulse: %3d - %3d, pause: %3d - %3d or pulse: %3d - %3d, pause: %3d - %3d\n",
-                                            RC5_START_BIT_LEN_MIN, RC5_START_BIT_LEN_MAX,
-                                            2 * RC5_START_BIT_LEN_MIN, 2 * RC5_START_BIT_LEN_MAX,
-                                            RC5_START_BIT_LEN_MIN, RC5_START_BIT_LEN_MAX,
-                                            2 * RC5_START_BIT_LEN_MIN, 2 * RC5_START_BIT_LEN_MAX);
+                        ANALYZE_PRINTF ("protocol = RC5, start bit timings: pulse: %3d - %3d, pause: %3d - %3d or pulse: %3d - %3d, pause: %3d - %3d\n",
+                                        RC5_START_BIT_LEN_MIN, RC5_START_BIT_LEN_MAX,
+                                        2 * RC5_START_BIT_LEN_MIN, 2 * RC5_START_BIT_LEN_MAX,
+                                        RC5_START_BIT_LEN_MIN, RC5_START_BIT_LEN_MAX,
+                                        2 * RC5_START_BIT_LEN_MIN, 2 * RC5_START_BIT_LEN_MAX);
 #endif // ANALYZE
-                        }
+                    }
 
-                        irmp_param_p = (IRMP_PARAMETER *) &rc5_param;
-                        last_pause = irmp_pause_time;
+                    irmp_param_p = (IRMP_PARAMETER *) &rc5_param;
+                    st->last_pause = st->irmp_pause_time;
 
-                        if ((irmp_pulse_time > RC5_START_BIT_LEN_MAX && irmp_pulse_time <= 2 * RC5_START_BIT_LEN_MAX) ||
-                            (irmp_pause_time > RC5_START_BIT_LEN_MAX && irmp_pause_time <= 2 * RC5_START_BIT_LEN_MAX))
-                        {
-                          last_value  = 0;
-                          rc5_cmd_bit6 = 1<<6;
-                        }
-                        else
-                        {
-                          last_value  = 1;
-                        }
+                    if ((st->irmp_pulse_time > RC5_START_BIT_LEN_MAX && st->irmp_pulse_time <= 2 * RC5_START_BIT_LEN_MAX) ||
+                        (st->irmp_pause_time > RC5_START_BIT_LEN_MAX && st->irmp_pause_time <= 2 * RC5_START_BIT_LEN_MAX))
+                    {
+                      st->last_value  = 0;
+                      st->rc5_cmd_bit6 = 1<<6;
                     }
                     else
+                    {
+                      st->last_value  = 1;
+                    }
+                }
+                break;
 #endif // IRMP_SUPPORT_RC5_PROTOCOL == 1
 
 #if IRMP_SUPPORT_DENON_PROTOCOL == 1
-                    if ( (irmp_pulse_time >= DENON_PULSE_LEN_MIN && irmp_pulse_time <= DENON_PULSE_LEN_MAX) &&
-                        ((irmp_pause_time >= DENON_1_PAUSE_LEN_MIN && irmp_pause_time <= DENON_1_PAUSE_LEN_MAX) ||
-                         (irmp_pause_time >= DENON_0_PAUSE_LEN_MIN && irmp_pause_time <= DENON_0_PAUSE_LEN_MAX)))
-                    {                                                           // it's DENON
-#ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = DENON, start bit timings: pulse: %3d - %3d, pause: %3d - %3d or %3d - %3d\n",
-                                        DENON_PULSE_LEN_MIN, DENON_PULSE_LEN_MAX,
-                                        DENON_1_PAUSE_LEN_MIN, DENON_1_PAUSE_LEN_MAX,
-                                        DENON_0_PAUSE_LEN_MIN, DENON_0_PAUSE_LEN_MAX);
-#endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &denon_param;
-                    }
-                    else
+            case IRMP_START_BIT_DENON:
+                if ( (st->irmp_pulse_time >= DENON_PULSE_LEN_MIN && st->irmp_pulse_time <= DENON_PULSE_LEN_MAX) &&
+                    ((st->irmp_pause_time >= DENON_1_PAUSE_LEN_MIN && st->irmp_pause_time <= DENON_1_PAUSE_LEN_MAX) ||
+                     (st->irmp_pause_time >= DENON_0_PAUSE_LEN_MIN && st->irmp_pause_time <= DENON_0_PAUSE_LEN_MAX)))
+                {                                                           // it's DENON
+#ifdef ANALYZE
+                    ANALYZE_PRINTF ("protocol = DENON, start bit timings: pulse: %3d - %3d, pause: %3d - %3d or %3d - %3d\n",
+                                    DENON_PULSE_LEN_MIN, DENON_PULSE_LEN_MAX,
+                                    DENON_1_PAUSE_LEN_MIN, DENON_1_PAUSE_LEN_MAX,
+                                    DENON_0_PAUSE_LEN_MIN, DENON_0_PAUSE_LEN_MAX);
+#endif // ANALYZE
+                    irmp_param_p = (IRMP_PARAMETER *) &denon_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_DENON_PROTOCOL == 1
 
 #if IRMP_SUPPORT_THOMSON_PROTOCOL == 1
-                    if ( (irmp_pulse_time >= THOMSON_PULSE_LEN_MIN && irmp_pulse_time <= THOMSON_PULSE_LEN_MAX) &&
-                        ((irmp_pause_time >= THOMSON_1_PAUSE_LEN_MIN && irmp_pause_time <= THOMSON_1_PAUSE_LEN_MAX) ||
-                         (irmp_pause_time >= THOMSON_0_PAUSE_LEN_MIN && irmp_pause_time <= THOMSON_0_PAUSE_LEN_MAX)))
-                    {                                                           // it's THOMSON
-#ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = THOMSON, start bit timings: pulse: %3d - %3d, pause: %3d - %3d or %3d - %3d\n",
-                                        THOMSON_PULSE_LEN_MIN, THOMSON_PULSE_LEN_MAX,
-                                        THOMSON_1_PAUSE_LEN_MIN, THOMSON_1_PAUSE_LEN_MAX,
-                                        THOMSON_0_PAUSE_LEN_MIN, THOMSON_0_PAUSE_LEN_MAX);
-#endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &thomson_param;
-                    }
-                    else
+            case IRMP_START_BIT_THOMSON:
+                if ( (st->irmp_pulse_time >= THOMSON_PULSE_LEN_MIN && st->irmp_pulse_time <= THOMSON_PULSE_LEN_MAX) &&
+                    ((st->irmp_pause_time >= THOMSON_1_PAUSE_LEN_MIN && st->irmp_pause_time <= THOMSON_1_PAUSE_LEN_MAX) ||
+                     (st->irmp_pause_time >= THOMSON_0_PAUSE_LEN_MIN && st->irmp_pause_time <= THOMSON_0_PAUSE_LEN_MAX)))
+                {                                                           // it's THOMSON
+#ifdef ANALYZE
+                    ANALYZE_PRINTF ("protocol = THOMSON, start bit timings: pulse: %3d - %3d, pause: %3d - %3d or %3d - %3d\n",
+                                    THOMSON_PULSE_LEN_MIN, THOMSON_PULSE_LEN_MAX,
+                                    THOMSON_1_PAUSE_LEN_MIN, THOMSON_1_PAUSE_LEN_MAX,
+                                    THOMSON_0_PAUSE_LEN_MIN, THOMSON_0_PAUSE_LEN_MAX);
+#endif // ANALYZE
+                    irmp_param_p = (IRMP_PARAMETER *) &thomson_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_THOMSON_PROTOCOL == 1
 
 #if IRMP_SUPPORT_BOSE_PROTOCOL == 1
-                    if (irmp_pulse_time >= BOSE_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= BOSE_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= BOSE_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= BOSE_START_BIT_PAUSE_LEN_MAX)
-                    {
+            case IRMP_START_BIT_BOSE:
+                if (st->irmp_pulse_time >= BOSE_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= BOSE_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= BOSE_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= BOSE_START_BIT_PAUSE_LEN_MAX)
+                {
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = BOSE, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        BOSE_START_BIT_PULSE_LEN_MIN, BOSE_START_BIT_PULSE_LEN_MAX,
-                                        BOSE_START_BIT_PAUSE_LEN_MIN, BOSE_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = BOSE, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    BOSE_START_BIT_PULSE_LEN_MIN, BOSE_START_BIT_PULSE_LEN_MAX,
+                                    BOSE_START_BIT_PAUSE_LEN_MIN, BOSE_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &bose_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &bose_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_BOSE_PROTOCOL == 1
 
 #if IRMP_SUPPORT_RC6_PROTOCOL == 1
-                    if (irmp_pulse_time >= RC6_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= RC6_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= RC6_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= RC6_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's RC6
-#ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = RC6, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        RC6_START_BIT_PULSE_LEN_MIN, RC6_START_BIT_PULSE_LEN_MAX,
-                                        RC6_START_BIT_PAUSE_LEN_MIN, RC6_START_BIT_PAUSE_LEN_MAX);
-#endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &rc6_param;
-                        last_pause = 0;
-                        last_value = 1;
-                    }
-                    else
+            case IRMP_START_BIT_RC6:
+                if (st->irmp_pulse_time >= RC6_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= RC6_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= RC6_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= RC6_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's RC6
+#ifdef ANALYZE
+                    ANALYZE_PRINTF ("protocol = RC6, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    RC6_START_BIT_PULSE_LEN_MIN, RC6_START_BIT_PULSE_LEN_MAX,
+                                    RC6_START_BIT_PAUSE_LEN_MIN, RC6_START_BIT_PAUSE_LEN_MAX);
+#endif // ANALYZE
+                    irmp_param_p = (IRMP_PARAMETER *) &rc6_param;
+                    st->last_pause = 0;
+                    st->last_value = 1;
+                }
+                break;
 #endif // IRMP_SUPPORT_RC6_PROTOCOL == 1
 
 #if IRMP_SUPPORT_RECS80EXT_PROTOCOL == 1
-                    if (irmp_pulse_time >= RECS80EXT_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= RECS80EXT_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= RECS80EXT_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= RECS80EXT_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's RECS80EXT
+            case IRMP_START_BIT_RECS80EXT:
+                if (st->irmp_pulse_time >= RECS80EXT_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= RECS80EXT_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= RECS80EXT_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= RECS80EXT_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's RECS80EXT
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = RECS80EXT, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        RECS80EXT_START_BIT_PULSE_LEN_MIN, RECS80EXT_START_BIT_PULSE_LEN_MAX,
-                                        RECS80EXT_START_BIT_PAUSE_LEN_MIN, RECS80EXT_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = RECS80EXT, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    RECS80EXT_START_BIT_PULSE_LEN_MIN, RECS80EXT_START_BIT_PULSE_LEN_MAX,
+                                    RECS80EXT_START_BIT_PAUSE_LEN_MIN, RECS80EXT_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &recs80ext_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &recs80ext_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_RECS80EXT_PROTOCOL == 1
 
 #if IRMP_SUPPORT_NUBERT_PROTOCOL == 1
-                    if (irmp_pulse_time >= NUBERT_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= NUBERT_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= NUBERT_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= NUBERT_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's NUBERT
+            case IRMP_START_BIT_NUBERT:
+                if (st->irmp_pulse_time >= NUBERT_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= NUBERT_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= NUBERT_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= NUBERT_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's NUBERT
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = NUBERT, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        NUBERT_START_BIT_PULSE_LEN_MIN, NUBERT_START_BIT_PULSE_LEN_MAX,
-                                        NUBERT_START_BIT_PAUSE_LEN_MIN, NUBERT_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = NUBERT, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    NUBERT_START_BIT_PULSE_LEN_MIN, NUBERT_START_BIT_PULSE_LEN_MAX,
+                                    NUBERT_START_BIT_PAUSE_LEN_MIN, NUBERT_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &nubert_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &nubert_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_NUBERT_PROTOCOL == 1
 
 #if IRMP_SUPPORT_FAN_PROTOCOL == 1
-                    if (irmp_pulse_time >= FAN_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= FAN_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= FAN_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= FAN_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's FAN
+            case IRMP_START_BIT_FAN:
+                if (st->irmp_pulse_time >= FAN_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= FAN_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= FAN_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= FAN_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's FAN
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = FAN, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        FAN_START_BIT_PULSE_LEN_MIN, FAN_START_BIT_PULSE_LEN_MAX,
-                                        FAN_START_BIT_PAUSE_LEN_MIN, FAN_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = FAN, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    FAN_START_BIT_PULSE_LEN_MIN, FAN_START_BIT_PULSE_LEN_MAX,
+                                    FAN_START_BIT_PAUSE_LEN_MIN, FAN_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &fan_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &fan_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_FAN_PROTOCOL == 1
 
 #if IRMP_SUPPORT_SPEAKER_PROTOCOL == 1
-                    if (irmp_pulse_time >= SPEAKER_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= SPEAKER_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= SPEAKER_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= SPEAKER_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's SPEAKER
+            case IRMP_START_BIT_SPEAKER:
+                if (st->irmp_pulse_time >= SPEAKER_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= SPEAKER_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= SPEAKER_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= SPEAKER_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's SPEAKER
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = SPEAKER, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        SPEAKER_START_BIT_PULSE_LEN_MIN, SPEAKER_START_BIT_PULSE_LEN_MAX,
-                                        SPEAKER_START_BIT_PAUSE_LEN_MIN, SPEAKER_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = SPEAKER, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    SPEAKER_START_BIT_PULSE_LEN_MIN, SPEAKER_START_BIT_PULSE_LEN_MAX,
+                                    SPEAKER_START_BIT_PAUSE_LEN_MIN, SPEAKER_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &speaker_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &speaker_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_SPEAKER_PROTOCOL == 1
 
 #if IRMP_SUPPORT_BANG_OLUFSEN_PROTOCOL == 1
-                    if (irmp_pulse_time >= BANG_OLUFSEN_START_BIT1_PULSE_LEN_MIN && irmp_pulse_time <= BANG_OLUFSEN_START_BIT1_PULSE_LEN_MAX &&
-                        irmp_pause_time >= BANG_OLUFSEN_START_BIT1_PAUSE_LEN_MIN && irmp_pause_time <= BANG_OLUFSEN_START_BIT1_PAUSE_LEN_MAX)
-                    {                                                           // it's BANG_OLUFSEN
-#ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = BANG_OLUFSEN\n");
-                        ANALYZE_PRINTF ("start bit 1 timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        BANG_OLUFSEN_START_BIT1_PULSE_LEN_MIN, BANG_OLUFSEN_START_BIT1_PULSE_LEN_MAX,
-                                        BANG_OLUFSEN_START_BIT1_PAUSE_LEN_MIN, BANG_OLUFSEN_START_BIT1_PAUSE_LEN_MAX);
-                        ANALYZE_PRINTF ("start bit 2 timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        BANG_OLUFSEN_START_BIT2_PULSE_LEN_MIN, BANG_OLUFSEN_START_BIT2_PULSE_LEN_MAX,
-                                        BANG_OLUFSEN_START_BIT2_PAUSE_LEN_MIN, BANG_OLUFSEN_START_BIT2_PAUSE_LEN_MAX);
-                        ANALYZE_PRINTF ("start bit 3 timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        BANG_OLUFSEN_START_BIT3_PULSE_LEN_MIN, BANG_OLUFSEN_START_BIT3_PULSE_LEN_MAX,
-                                        BANG_OLUFSEN_START_BIT3_PAUSE_LEN_MIN, BANG_OLUFSEN_START_BIT3_PAUSE_LEN_MAX);
-                        ANALYZE_PRINTF ("start bit 4 timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        BANG_OLUFSEN_START_BIT4_PULSE_LEN_MIN, BANG_OLUFSEN_START_BIT4_PULSE_LEN_MAX,
-                                        BANG_OLUFSEN_START_BIT4_PAUSE_LEN_MIN, BANG_OLUFSEN_START_BIT4_PAUSE_LEN_MAX);
-#endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &bang_olufsen_param;
-                        last_value = 0;
-                    }
-                    else
+            case IRMP_START_BIT_BANG_OLUFSEN:
+                if (st->irmp_pulse_time >= BANG_OLUFSEN_START_BIT1_PULSE_LEN_MIN && st->irmp_pulse_time <= BANG_OLUFSEN_START_BIT1_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= BANG_OLUFSEN_START_BIT1_PAUSE_LEN_MIN && st->irmp_pause_time <= BANG_OLUFSEN_START_BIT1_PAUSE_LEN_MAX)
+                {                                                           // it's BANG_OLUFSEN
+#ifdef ANALYZE
+                    ANALYZE_PRINTF ("protocol = BANG_OLUFSEN\n");
+                    ANALYZE_PRINTF ("start bit 1 timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    BANG_OLUFSEN_START_BIT1_PULSE_LEN_MIN, BANG_OLUFSEN_START_BIT1_PULSE_LEN_MAX,
+                                    BANG_OLUFSEN_START_BIT1_PAUSE_LEN_MIN, BANG_OLUFSEN_START_BIT1_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("start bit 2 timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    BANG_OLUFSEN_START_BIT2_PULSE_LEN_MIN, BANG_OLUFSEN_START_BIT2_PULSE_LEN_MAX,
+                                    BANG_OLUFSEN_START_BIT2_PAUSE_LEN_MIN, BANG_OLUFSEN_START_BIT2_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("start bit 3 timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    BANG_OLUFSEN_START_BIT3_PULSE_LEN_MIN, BANG_OLUFSEN_START_BIT3_PULSE_LEN_MAX,
+                                    BANG_OLUFSEN_START_BIT3_PAUSE_LEN_MIN, BANG_OLUFSEN_START_BIT3_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("start bit 4 timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    BANG_OLUFSEN_START_BIT4_PULSE_LEN_MIN, BANG_OLUFSEN_START_BIT4_PULSE_LEN_MAX,
+                                    BANG_OLUFSEN_START_BIT4_PAUSE_LEN_MIN, BANG_OLUFSEN_START_BIT4_PAUSE_LEN_MAX);
+#endif // ANALYZE
+                    irmp_param_p = (IRMP_PARAMETER *) &bang_olufsen_param;
+                    st->last_value = 0;
+                }
+                break;
 #endif // IRMP_SUPPORT_BANG_OLUFSEN_PROTOCOL == 1
 
 #if IRMP_SUPPORT_GRUNDIG_NOKIA_IR60_PROTOCOL == 1
-                    if (irmp_pulse_time >= GRUNDIG_NOKIA_IR60_START_BIT_LEN_MIN && irmp_pulse_time <= GRUNDIG_NOKIA_IR60_START_BIT_LEN_MAX &&
-                        irmp_pause_time >= GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN_MIN && irmp_pause_time <= GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN_MAX)
-                    {                                                           // it's GRUNDIG
-#ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = GRUNDIG, pre bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        GRUNDIG_NOKIA_IR60_START_BIT_LEN_MIN, GRUNDIG_NOKIA_IR60_START_BIT_LEN_MAX,
-                                        GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN_MIN, GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN_MAX);
-#endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &grundig_param;
-                        last_pause = irmp_pause_time;
-                        last_value  = 1;
-                    }
-                    else
+            case IRMP_START_BIT_GRUNDIG_NOKIA_IR60:
+                if (st->irmp_pulse_time >= GRUNDIG_NOKIA_IR60_START_BIT_LEN_MIN && st->irmp_pulse_time <= GRUNDIG_NOKIA_IR60_START_BIT_LEN_MAX &&
+                    st->irmp_pause_time >= GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN_MIN && st->irmp_pause_time <= GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN_MAX)
+                {                                                           // it's GRUNDIG
+#ifdef ANALYZE
+                    ANALYZE_PRINTF ("protocol = GRUNDIG, pre bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    GRUNDIG_NOKIA_IR60_START_BIT_LEN_MIN, GRUNDIG_NOKIA_IR60_START_BIT_LEN_MAX,
+                                    GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN_MIN, GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN_MAX);
+#endif // ANALYZE
+                    irmp_param_p = (IRMP_PARAMETER *) &grundig_param;
+                    st->last_pause = st->irmp_pause_time;
+                    st->last_value  = 1;
+                }
+                break;
 #endif // IRMP_SUPPORT_GRUNDIG_NOKIA_IR60_PROTOCOL == 1
 
 #if IRMP_SUPPORT_MERLIN_PROTOCOL == 1 // check MERLIN before RUWIDO!
-                    if (irmp_pulse_time >= MERLIN_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= MERLIN_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= MERLIN_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= MERLIN_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's MERLIN
-#ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = MERLIN, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        MERLIN_START_BIT_PULSE_LEN_MIN, MERLIN_START_BIT_PULSE_LEN_MAX,
-                                        MERLIN_START_BIT_PAUSE_LEN_MIN, MERLIN_START_BIT_PAUSE_LEN_MAX);
-#endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &merlin_param;
-                        last_pause = 0;
-                        last_value = 1;
-                    }
-                    else
+            case IRMP_START_BIT_MERLIN:
+                if (st->irmp_pulse_time >= MERLIN_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= MERLIN_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= MERLIN_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= MERLIN_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's MERLIN
+#ifdef ANALYZE
+                    ANALYZE_PRINTF ("protocol = MERLIN, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    MERLIN_START_BIT_PULSE_LEN_MIN, MERLIN_START_BIT_PULSE_LEN_MAX,
+                                    MERLIN_START_BIT_PAUSE_LEN_MIN, MERLIN_START_BIT_PAUSE_LEN_MAX);
+#endif // ANALYZE
+                    irmp_param_p = (IRMP_PARAMETER *) &merlin_param;
+                    st->last_pause = 0;
+                    st->last_value = 1;
+                }
+                break;
 #endif // IRMP_SUPPORT_MERLIN_PROTOCOL == 1
 
 #if IRMP_SUPPORT_SIEMENS_OR_RUWIDO_PROTOCOL == 1
-                    if (((irmp_pulse_time >= SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MAX) ||
-                         (irmp_pulse_time >= 2 * SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= 2 * SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MAX)) &&
-                        ((irmp_pause_time >= SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MAX) ||
-                         (irmp_pause_time >= 2 * SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= 2 * SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MAX)))
-                    {                                                           // it's RUWIDO or SIEMENS
-#ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = RUWIDO, start bit timings: pulse: %3d - %3d or %3d - %3d, pause: %3d - %3d or %3d - %3d\n",
-                                        SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MIN,   SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MAX,
-                                        2 * SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MIN, 2 * SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MAX,
-                                        SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MIN,   SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MAX,
-                                        2 * SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MIN, 2 * SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MAX);
-#endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &ruwido_param;
-                        last_pause = irmp_pause_time;
-                        last_value  = 1;
-                    }
-                    else
+            case IRMP_START_BIT_SIEMENS_OR_RUWIDO:
+                if (((st->irmp_pulse_time >= SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MAX) ||
+                     (st->irmp_pulse_time >= 2 * SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= 2 * SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MAX)) &&
+                    ((st->irmp_pause_time >= SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MAX) ||
+                     (st->irmp_pause_time >= 2 * SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= 2 * SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MAX)))
+                {                                                           // it's RUWIDO or SIEMENS
+#ifdef ANALYZE
+                    ANALYZE_PRINTF ("protocol = RUWIDO, start bit timings: pulse: %3d - %3d or %3d - %3d, pause: %3d - %3d or %3d - %3d\n",
+                                    SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MIN,   SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MAX,
+                                    2 * SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MIN, 2 * SIEMENS_OR_RUWIDO_START_BIT_PULSE_LEN_MAX,
+                                    SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MIN,   SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MAX,
+                                    2 * SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MIN, 2 * SIEMENS_OR_RUWIDO_START_BIT_PAUSE_LEN_MAX);
+#endif // ANALYZE
+                    irmp_param_p = (IRMP_PARAMETER *) &ruwido_param;
+                    st->last_pause = st->irmp_pause_time;
+                    st->last_value  = 1;
+                }
+                break;
 #endif // IRMP_SUPPORT_SIEMENS_OR_RUWIDO_PROTOCOL == 1
 
 #if IRMP_SUPPORT_FDC_PROTOCOL == 1
-                    if (irmp_pulse_time >= FDC_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= FDC_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= FDC_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= FDC_START_BIT_PAUSE_LEN_MAX)
-                    {
+            case IRMP_START_BIT_FDC:
+                if (st->irmp_pulse_time >= FDC_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= FDC_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= FDC_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= FDC_START_BIT_PAUSE_LEN_MAX)
+                {
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = FDC, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        FDC_START_BIT_PULSE_LEN_MIN, FDC_START_BIT_PULSE_LEN_MAX,
-                                        FDC_START_BIT_PAUSE_LEN_MIN, FDC_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = FDC, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    FDC_START_BIT_PULSE_LEN_MIN, FDC_START_BIT_PULSE_LEN_MAX,
+                                    FDC_START_BIT_PAUSE_LEN_MIN, FDC_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &fdc_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &fdc_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_FDC_PROTOCOL == 1
 
 #if IRMP_SUPPORT_RCCAR_PROTOCOL == 1
-                    if (irmp_pulse_time >= RCCAR_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= RCCAR_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= RCCAR_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= RCCAR_START_BIT_PAUSE_LEN_MAX)
-                    {
+            case IRMP_START_BIT_RCCAR:
+                if (st->irmp_pulse_time >= RCCAR_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= RCCAR_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= RCCAR_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= RCCAR_START_BIT_PAUSE_LEN_MAX)
+                {
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = RCCAR, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        RCCAR_START_BIT_PULSE_LEN_MIN, RCCAR_START_BIT_PULSE_LEN_MAX,
-                                        RCCAR_START_BIT_PAUSE_LEN_MIN, RCCAR_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = RCCAR, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    RCCAR_START_BIT_PULSE_LEN_MIN, RCCAR_START_BIT_PULSE_LEN_MAX,
+                                    RCCAR_START_BIT_PAUSE_LEN_MIN, RCCAR_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &rccar_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &rccar_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_RCCAR_PROTOCOL == 1
 
 #if IRMP_SUPPORT_KATHREIN_PROTOCOL == 1
-                    if (irmp_pulse_time >= KATHREIN_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= KATHREIN_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= KATHREIN_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= KATHREIN_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's KATHREIN
+            case IRMP_START_BIT_KATHREIN:
+                if (st->irmp_pulse_time >= KATHREIN_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= KATHREIN_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= KATHREIN_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= KATHREIN_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's KATHREIN
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = KATHREIN, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        KATHREIN_START_BIT_PULSE_LEN_MIN, KATHREIN_START_BIT_PULSE_LEN_MAX,
-                                        KATHREIN_START_BIT_PAUSE_LEN_MIN, KATHREIN_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = KATHREIN, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    KATHREIN_START_BIT_PULSE_LEN_MIN, KATHREIN_START_BIT_PULSE_LEN_MAX,
+                                    KATHREIN_START_BIT_PAUSE_LEN_MIN, KATHREIN_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &kathrein_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &kathrein_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_KATHREIN_PROTOCOL == 1
 
 #if IRMP_SUPPORT_NETBOX_PROTOCOL == 1
-                    if (irmp_pulse_time >= NETBOX_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= NETBOX_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= NETBOX_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= NETBOX_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's NETBOX
+            case IRMP_START_BIT_NETBOX:
+                if (st->irmp_pulse_time >= NETBOX_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= NETBOX_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= NETBOX_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= NETBOX_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's NETBOX
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = NETBOX, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        NETBOX_START_BIT_PULSE_LEN_MIN, NETBOX_START_BIT_PULSE_LEN_MAX,
-                                        NETBOX_START_BIT_PAUSE_LEN_MIN, NETBOX_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = NETBOX, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    NETBOX_START_BIT_PULSE_LEN_MIN, NETBOX_START_BIT_PULSE_LEN_MAX,
+                                    NETBOX_START_BIT_PAUSE_LEN_MIN, NETBOX_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &netbox_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &netbox_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_NETBOX_PROTOCOL == 1
 
 #if IRMP_SUPPORT_LEGO_PROTOCOL == 1
-                    if (irmp_pulse_time >= LEGO_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= LEGO_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= LEGO_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= LEGO_START_BIT_PAUSE_LEN_MAX)
-                    {
+            case IRMP_START_BIT_LEGO:
+                if (st->irmp_pulse_time >= LEGO_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= LEGO_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= LEGO_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= LEGO_START_BIT_PAUSE_LEN_MAX)
+                {
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = LEGO, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        LEGO_START_BIT_PULSE_LEN_MIN, LEGO_START_BIT_PULSE_LEN_MAX,
-                                        LEGO_START_BIT_PAUSE_LEN_MIN, LEGO_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = LEGO, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    LEGO_START_BIT_PULSE_LEN_MIN, LEGO_START_BIT_PULSE_LEN_MAX,
+                                    LEGO_START_BIT_PAUSE_LEN_MIN, LEGO_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &lego_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &lego_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_LEGO_PROTOCOL == 1
 
 #if IRMP_SUPPORT_A1TVBOX_PROTOCOL == 1
-                    if (irmp_pulse_time >= A1TVBOX_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= A1TVBOX_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= A1TVBOX_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= A1TVBOX_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's A1TVBOX
-#ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = A1TVBOX, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        A1TVBOX_START_BIT_PULSE_LEN_MIN, A1TVBOX_START_BIT_PULSE_LEN_MAX,
-                                        A1TVBOX_START_BIT_PAUSE_LEN_MIN, A1TVBOX_START_BIT_PAUSE_LEN_MAX);
-#endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &a1tvbox_param;
-                        last_pause = 0;
-                        last_value = 1;
-                    }
-                    else
+            case IRMP_START_BIT_A1TVBOX:
+                if (st->irmp_pulse_time >= A1TVBOX_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= A1TVBOX_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= A1TVBOX_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= A1TVBOX_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's A1TVBOX
+#ifdef ANALYZE
+                    ANALYZE_PRINTF ("protocol = A1TVBOX, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    A1TVBOX_START_BIT_PULSE_LEN_MIN, A1TVBOX_START_BIT_PULSE_LEN_MAX,
+                                    A1TVBOX_START_BIT_PAUSE_LEN_MIN, A1TVBOX_START_BIT_PAUSE_LEN_MAX);
+#endif // ANALYZE
+                    irmp_param_p = (IRMP_PARAMETER *) &a1tvbox_param;
+                    st->last_pause = 0;
+                    st->last_value = 1;
+                }
+                break;
 #endif // IRMP_SUPPORT_A1TVBOX_PROTOCOL == 1
 
 #if IRMP_SUPPORT_ORTEK_PROTOCOL == 1
-                    if (irmp_pulse_time >= ORTEK_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= ORTEK_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= ORTEK_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= ORTEK_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's ORTEK (Hama)
-#ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = ORTEK, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        ORTEK_START_BIT_PULSE_LEN_MIN, ORTEK_START_BIT_PULSE_LEN_MAX,
-                                        ORTEK_START_BIT_PAUSE_LEN_MIN, ORTEK_START_BIT_PAUSE_LEN_MAX);
-#endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &ortek_param;
-                        last_pause  = 0;
-                        last_value  = 1;
-                        parity      = 0;
-                    }
-                    else
+            case IRMP_START_BIT_ORTEK:
+                if (st->irmp_pulse_time >= ORTEK_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= ORTEK_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= ORTEK_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= ORTEK_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's ORTEK (Hama)
+#ifdef ANALYZE
+                    ANALYZE_PRINTF ("protocol = ORTEK, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    ORTEK_START_BIT_PULSE_LEN_MIN, ORTEK_START_BIT_PULSE_LEN_MAX,
+                                    ORTEK_START_BIT_PAUSE_LEN_MIN, ORTEK_START_BIT_PAUSE_LEN_MAX);
+#endif // ANALYZE
+                    irmp_param_p = (IRMP_PARAMETER *) &ortek_param;
+                    st->last_pause  = 0;
+                    st->last_value  = 1;
+                    st->parity      = 0;
+                }
+                break;
 #endif // IRMP_SUPPORT_ORTEK_PROTOCOL == 1
 
 #if IRMP_SUPPORT_RCMM_PROTOCOL == 1
-                    if (irmp_pulse_time >= RCMM32_START_BIT_PULSE_LEN_MIN && irmp_pulse_time <= RCMM32_START_BIT_PULSE_LEN_MAX &&
-                        irmp_pause_time >= RCMM32_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= RCMM32_START_BIT_PAUSE_LEN_MAX)
-                    {                                                           // it's RCMM
+            case IRMP_START_BIT_RCMM:
+                if (st->irmp_pulse_time >= RCMM32_START_BIT_PULSE_LEN_MIN && st->irmp_pulse_time <= RCMM32_START_BIT_PULSE_LEN_MAX &&
+                    st->irmp_pause_time >= RCMM32_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= RCMM32_START_BIT_PAUSE_LEN_MAX)
+                {                                                           // it's RCMM
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = RCMM, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
-                                        RCMM32_START_BIT_PULSE_LEN_MIN, RCMM32_START_BIT_PULSE_LEN_MAX,
-                                        RCMM32_START_BIT_PAUSE_LEN_MIN, RCMM32_START_BIT_PAUSE_LEN_MAX);
+                    ANALYZE_PRINTF ("protocol = RCMM, start bit timings: pulse: %3d - %3d, pause: %3d - %3d\n",
+                                    RCMM32_START_BIT_PULSE_LEN_MIN, RCMM32_START_BIT_PULSE_LEN_MAX,
+                                    RCMM32_START_BIT_PAUSE_LEN_MIN, RCMM32_START_BIT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                        irmp_param_p = (IRMP_PARAMETER *) &rcmm_param;
-                    }
-                    else
+                    irmp_param_p = (IRMP_PARAMETER *) &rcmm_param;
+                }
+                break;
 #endif // IRMP_SUPPORT_RCMM_PROTOCOL == 1
-                    {
-#ifdef ANALYZE
-                        ANALYZE_PRINTF ("protocol = UNKNOWN\n");
-#endif // ANALYZE
-                        irmp_start_bit_detected = 0;                            // wait for another start bit...
-                    }
+        }
+    }
 
-                    if (irmp_start_bit_detected)
-                    {
-                        memcpy_P (&irmp_param, irmp_param_p, sizeof (IRMP_PARAMETER));
+    return irmp_param_p;
+}
 
-                        if (! (irmp_param.flags & IRMP_PARAM_FLAG_IS_MANCHESTER))
-                        {
-#ifdef ANALYZE
-                            ANALYZE_PRINTF ("pulse_1: %3d - %3d\n", irmp_param.pulse_1_len_min, irmp_param.pulse_1_len_max);
-                            ANALYZE_PRINTF ("pause_1: %3d - %3d\n", irmp_param.pause_1_len_min, irmp_param.pause_1_len_max);
-#endif // ANALYZE
-                        }
-                        else
-                        {
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  ISR routine of a decoder instance
+ *  @details  runs the decoder for one interrupt period with the given input value, reentrant for different instances
+ *  @param    pointer to decoder state, input value (0: pulse, else pause)
+ *  @return   TRUE: frame detected, call irmp_get_data_ex()
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+irmp_ISR_ex (irmp_state_t * st, uint_fast8_t irmp_input)
+{
 #ifdef ANALYZE
-                            ANALYZE_PRINTF ("pulse: %3d - %3d or %3d - %3d\n", irmp_param.pulse_1_len_min, irmp_param.pulse_1_len_max,
-                                            2 * irmp_param.pulse_1_len_min, 2 * irmp_param.pulse_1_len_max);
-                            ANALYZE_PRINTF ("pause: %3d - %3d or %3d - %3d\n", irmp_param.pause_1_len_min, irmp_param.pause_1_len_max,
-                                            2 * irmp_param.pause_1_len_min, 2 * irmp_param.pause_1_len_max);
+    st->time_counter++;
 #endif // ANALYZE
-                        }
 
-#if IRMP_SUPPORT_RC5_PROTOCOL == 1 && (IRMP_SUPPORT_FDC_PROTOCOL == 1 || IRMP_SUPPORT_RCCAR_PROTOCOL == 1)
-                        if (irmp_param2.protocol)
-                        {
-#ifdef ANALYZE
-                            ANALYZE_PRINTF ("pulse_0: %3d - %3d\n", irmp_param2.pulse_0_len_min, irmp_param2.pulse_0_len_max);
-                            ANALYZE_PRINTF ("pause_0: %3d - %3d\n", irmp_param2.pause_0_len_min, irmp_param2.pause_0_len_max);
-                            ANALYZE_PRINTF ("pulse_1: %3d - %3d\n", irmp_param2.pulse_1_len_min, irmp_param2.pulse_1_len_max);
-                            ANALYZE_PRINTF ("pause_1: %3d - %3d\n", irmp_param2.pause_1_len_min, irmp_param2.pause_1_len_max);
-#endif // ANALYZE
-                        }
-#endif
+#if IRMP_USE_CALLBACK == 1
+    if (irmp_callback_ptr)
+    {
+        if (st->last_inverted_input != !irmp_input)
+        {
+            (*irmp_callback_ptr) (! irmp_input);
+            st->last_inverted_input = !irmp_input;
+        }
+    }
+#endif // IRMP_USE_CALLBACK == 1
 
+    irmp_log(irmp_input);                                                       // log ir signal, if IRMP_LOGGING defined
 
-#if IRMP_SUPPORT_RC6_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_RC6_PROTOCOL)
-                        {
+    if (! st->irmp_ir_detected)                                                     // ir code already detected?
+    {                                                                           // no...
+        if (! st->irmp_start_bit_detected)                                          // start bit detected?
+        {                                                                       // no...
+            if (! irmp_input)                                                   // receiving burst?
+            {                                                                   // yes...
+//              irmp_busy_flag = TRUE;
 #ifdef ANALYZE
-                            ANALYZE_PRINTF ("pulse_toggle: %3d - %3d\n", RC6_TOGGLE_BIT_LEN_MIN, RC6_TOGGLE_BIT_LEN_MAX);
+                if (! st->irmp_pulse_time)
+                {
+                    ANALYZE_PRINTF("%8.3fms [starting pulse]\n", (double) (st->time_counter * 1000) / F_INTERRUPTS);
+                }
 #endif // ANALYZE
-                        }
+                st->irmp_pulse_time++;                                              // increment counter
+            }
+            else
+            {                                                                   // no...
+                if (st->irmp_pulse_time)                                            // it's dark....
+                {                                                               // set flags for counting the time of darkness...
+                    st->irmp_start_bit_detected = 1;
+                    st->wait_for_start_space    = 1;
+                    st->wait_for_space          = 0;
+                    st->irmp_tmp_command        = 0;
+                    st->irmp_tmp_address        = 0;
+#if IRMP_SUPPORT_KASEIKYO_PROTOCOL == 1
+                    st->genre2                  = 0;
+#endif
+#if IRMP_SUPPORT_SAMSUNG_PROTOCOL == 1
+                    st->irmp_tmp_id = 0;
 #endif
 
-                        if (! (irmp_param.flags & IRMP_PARAM_FLAG_IS_MANCHESTER))
-                        {
-#ifdef ANALYZE
-                            ANALYZE_PRINTF ("pulse_0: %3d - %3d\n", irmp_param.pulse_0_len_min, irmp_param.pulse_0_len_max);
-                            ANALYZE_PRINTF ("pause_0: %3d - %3d\n", irmp_param.pause_0_len_min, irmp_param.pause_0_len_max);
-#endif // ANALYZE
-                        }
-                        else
+#if IRMP_SUPPORT_RC5_PROTOCOL == 1 && (IRMP_SUPPORT_FDC_PROTOCOL == 1 || IRMP_SUPPORT_RCCAR_PROTOCOL == 1) || IRMP_SUPPORT_NEC42_PROTOCOL == 1
+                    st->irmp_tmp_command2       = 0;
+                    st->irmp_tmp_address2       = 0;
+#endif
+#if IRMP_SUPPORT_LGAIR_PROTOCOL == 1
+                    st->irmp_lgair_command      = 0;
+                    st->irmp_lgair_address      = 0;
+#endif
+                    st->irmp_bit                = 0xff;
+                    st->irmp_pause_time         = 1;                                // 1st pause: set to 1, not to 0!
+#if IRMP_SUPPORT_RC5_PROTOCOL == 1 || IRMP_SUPPORT_S100_PROTOCOL == 1
+                    st->rc5_cmd_bit6            = 0;                                // fm 2010-03-07: bugfix: reset it after incomplete RC5 frame!
+#endif
+                }
+                else
+                {
+                    if (st->key_repetition_len < 0xFFFF)                            // avoid overflow of counter
+                    {
+                        st->key_repetition_len++;
+
+#if IRMP_SUPPORT_DENON_PROTOCOL == 1
+                        if (st->denon_repetition_len < 0xFFFF)                      // avoid overflow of counter
                         {
+                            st->denon_repetition_len++;
+
+                            if (st->denon_repetition_len >= DENON_AUTO_REPETITION_PAUSE_LEN && st->last_irmp_denon_command != 0)
+                            {
 #ifdef ANALYZE
-                            ANALYZE_PRINTF ("pulse: %3d - %3d or %3d - %3d\n", irmp_param.pulse_0_len_min, irmp_param.pulse_0_len_max,
-                                            2 * irmp_param.pulse_0_len_min, 2 * irmp_param.pulse_0_len_max);
-                            ANALYZE_PRINTF ("pause: %3d - %3d or %3d - %3d\n", irmp_param.pause_0_len_min, irmp_param.pause_0_len_max,
-                                            2 * irmp_param.pause_0_len_min, 2 * irmp_param.pause_0_len_max);
+                                ANALYZE_PRINTF ("%8.3fms warning: did not receive inverted command repetition\n",
+                                                (double) (st->time_counter * 1000) / F_INTERRUPTS);
+#endif // ANALYZE
+                                st->last_irmp_denon_command = 0;
+                                st->denon_repetition_len = 0xFFFF;
+                            }
+                        }
+#endif // IRMP_SUPPORT_DENON_PROTOCOL == 1
+                    }
+                }
+            }
+        }
+        else
+        {
+            if (st->wait_for_start_space)                                           // we have received start bit...
+            {                                                                   // ...and are counting the time of darkness
+                if (irmp_input)                                                 // still dark?
+                {                                                               // yes
+                    st->irmp_pause_time++;                                          // increment counter
+
+#if IRMP_SUPPORT_NIKON_PROTOCOL == 1
+                    if (((st->irmp_pulse_time < NIKON_START_BIT_PULSE_LEN_MIN || st->irmp_pulse_time > NIKON_START_BIT_PULSE_LEN_MAX) && st->irmp_pause_time > IRMP_TIMEOUT_LEN) ||
+                         st->irmp_pause_time > IRMP_TIMEOUT_NIKON_LEN)
+#else
+                    if (st->irmp_pause_time > IRMP_TIMEOUT_LEN)                     // timeout?
+#endif
+                    {                                                           // yes...
+#if IRMP_SUPPORT_JVC_PROTOCOL == 1
+                        if (st->irmp_protocol == IRMP_JVC_PROTOCOL)                 // don't show eror if JVC protocol, irmp_pulse_time has been set below!
+                        {
+                            ;
+                        }
+                        else
+#endif // IRMP_SUPPORT_JVC_PROTOCOL == 1
+                        {
+#ifdef ANALYZE
+                            ANALYZE_PRINTF ("%8.3fms error 1: pause after start bit pulse %d too long: %d\n", (double) (st->time_counter * 1000) / F_INTERRUPTS, st->irmp_pulse_time, st->irmp_pause_time);
+                            ANALYZE_ONLY_NORMAL_PUTCHAR ('\n');
+#endif // ANALYZE
+                        }
+
+                        st->irmp_start_bit_detected = 0;                            // reset flags, let's wait for another start bit
+                        st->irmp_pulse_time         = 0;
+                        st->irmp_pause_time         = 0;
+                    }
+                }
+                else
+                {                                                               // receiving first data pulse!
+                    IRMP_PARAMETER * irmp_param_p;
+
+#if IRMP_SUPPORT_RC5_PROTOCOL == 1 && (IRMP_SUPPORT_FDC_PROTOCOL == 1 || IRMP_SUPPORT_RCCAR_PROTOCOL == 1)
+                    st->irmp_param2.protocol = 0;
+#endif
+
+#ifdef ANALYZE
+                    ANALYZE_PRINTF ("%8.3fms [start-bit: pulse = %2d, pause = %2d]\n", (double) (st->time_counter * 1000) / F_INTERRUPTS, st->irmp_pulse_time, st->irmp_pause_time);
+#endif // ANALYZE
+
+                    irmp_param_p = irmp_classify_start_bit (st);
+
+                    if (! irmp_param_p)
+                    {
+#ifdef ANALYZE
+                        ANALYZE_PRINTF ("protocol = UNKNOWN\n");
+#endif // ANALYZE
+                        st->irmp_start_bit_detected = 0;                            // wait for another start bit...
+                    }
+
+                    if (st->irmp_start_bit_detected)
+                    {
+                        memcpy_P (&st->irmp_param, irmp_param_p, sizeof (IRMP_PARAMETER));
+
+                        if (! (st->irmp_param.flags & IRMP_PARAM_FLAG_IS_MANCHESTER))
+                        {
+#ifdef ANALYZE
+                            ANALYZE_PRINTF ("pulse_1: %3d - %3d\n", st->irmp_param.pulse_1_len_min, st->irmp_param.pulse_1_len_max);
+                            ANALYZE_PRINTF ("pause_1: %3d - %3d\n", st->irmp_param.pause_1_len_min, st->irmp_param.pause_1_len_max);
+#endif // ANALYZE
+                        }
+                        else
+                        {
+#ifdef ANALYZE
+                            ANALYZE_PRINTF ("pulse: %3d - %3d or %3d - %3d\n", st->irmp_param.pulse_1_len_min, st->irmp_param.pulse_1_len_max,
+                                            2 * st->irmp_param.pulse_1_len_min, 2 * st->irmp_param.pulse_1_len_max);
+                            ANALYZE_PRINTF ("pause: %3d - %3d or %3d - %3d\n", st->irmp_param.pause_1_len_min, st->irmp_param.pause_1_len_max,
+                                            2 * st->irmp_param.pause_1_len_min, 2 * st->irmp_param.pause_1_len_max);
+#endif // ANALYZE
+                        }
+
+#if IRMP_SUPPORT_RC5_PROTOCOL == 1 && (IRMP_SUPPORT_FDC_PROTOCOL == 1 || IRMP_SUPPORT_RCCAR_PROTOCOL == 1)
+                        if (st->irmp_param2.protocol)
+                        {
+#ifdef ANALYZE
+                            ANALYZE_PRINTF ("pulse_0: %3d - %3d\n", st->irmp_param2.pulse_0_len_min, st->irmp_param2.pulse_0_len_max);
+                            ANALYZE_PRINTF ("pause_0: %3d - %3d\n", st->irmp_param2.pause_0_len_min, st->irmp_param2.pause_0_len_max);
+                            ANALYZE_PRINTF ("pulse_1: %3d - %3d\n", st->irmp_param2.pulse_1_len_min, st->irmp_param2.pulse_1_len_max);
+                            ANALYZE_PRINTF ("pause_1: %3d - %3d\n", st->irmp_param2.pause_1_len_min, st->irmp_param2.pause_1_len_max);
+#endif // ANALYZE
+                        }
+#endif
+
+
+#if IRMP_SUPPORT_RC6_PROTOCOL == 1
+                        if (st->irmp_param.protocol == IRMP_RC6_PROTOCOL)
+                        {
+#ifdef ANALYZE
+                            ANALYZE_PRINTF ("pulse_toggle: %3d - %3d\n", RC6_TOGGLE_BIT_LEN_MIN, RC6_TOGGLE_BIT_LEN_MAX);
+#endif // ANALYZE
+                        }
+#endif
+
+                        if (! (st->irmp_param.flags & IRMP_PARAM_FLAG_IS_MANCHESTER))
+                        {
+#ifdef ANALYZE
+                            ANALYZE_PRINTF ("pulse_0: %3d - %3d\n", st->irmp_param.pulse_0_len_min, st->irmp_param.pulse_0_len_max);
+                            ANALYZE_PRINTF ("pause_0: %3d - %3d\n", st->irmp_param.pause_0_len_min, st->irmp_param.pause_0_len_max);
+#endif // ANALYZE
+                        }
+                        else
+                        {
+#ifdef ANALYZE
+                            ANALYZE_PRINTF ("pulse: %3d - %3d or %3d - %3d\n", st->irmp_param.pulse_0_len_min, st->irmp_param.pulse_0_len_max,
+                                            2 * st->irmp_param.pulse_0_len_min, 2 * st->irmp_param.pulse_0_len_max);
+                            ANALYZE_PRINTF ("pause: %3d - %3d or %3d - %3d\n", st->irmp_param.pause_0_len_min, st->irmp_param.pause_0_len_max,
+                                            2 * st->irmp_param.pause_0_len_min, 2 * st->irmp_param.pause_0_len_max);
 #endif // ANALYZE
                         }
 
 #ifdef ANALYZE
 #if IRMP_SUPPORT_BANG_OLUFSEN_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_BANG_OLUFSEN_PROTOCOL)
+                        if (st->irmp_param.protocol == IRMP_BANG_OLUFSEN_PROTOCOL)
                         {
-                            ANALYZE_PRINTF ("pulse_r: %3d - %3d\n", irmp_param.pulse_0_len_min, irmp_param.pulse_0_len_max);
+                            ANALYZE_PRINTF ("pulse_r: %3d - %3d\n", st->irmp_param.pulse_0_len_min, st->irmp_param.pulse_0_len_max);
                             ANALYZE_PRINTF ("pause_r: %3d - %3d\n", BANG_OLUFSEN_R_PAUSE_LEN_MIN, BANG_OLUFSEN_R_PAUSE_LEN_MAX);
                         }
 #endif
 
-                        ANALYZE_PRINTF ("command_offset: %2d\n", irmp_param.command_offset);
-                        ANALYZE_PRINTF ("command_len:    %3d\n", irmp_param.command_end - irmp_param.command_offset);
-                        ANALYZE_PRINTF ("complete_len:   %3d\n", irmp_param.complete_len);
-                        ANALYZE_PRINTF ("stop_bit:       %3d\n", irmp_param.stop_bit);
+                        ANALYZE_PRINTF ("command_offset: %2d\n", st->irmp_param.command_offset);
+                        ANALYZE_PRINTF ("command_len:    %3d\n", st->irmp_param.command_end - st->irmp_param.command_offset);
+                        ANALYZE_PRINTF ("complete_len:   %3d\n", st->irmp_param.complete_len);
+                        ANALYZE_PRINTF ("stop_bit:       %3d\n", st->irmp_param.stop_bit);
 #endif // ANALYZE
                     }
 
-                    irmp_bit = 0;
+                    st->irmp_bit = 0;
 
 #if IRMP_SUPPORT_MANCHESTER == 1
-                    if ((irmp_param.flags & IRMP_PARAM_FLAG_IS_MANCHESTER) &&
-                         irmp_param.protocol != IRMP_RUWIDO_PROTOCOL && // Manchester, but not RUWIDO
-                         irmp_param.protocol != IRMP_RC6_PROTOCOL)      // Manchester, but not RC6
+                    if ((st->irmp_param.flags & IRMP_PARAM_FLAG_IS_MANCHESTER) &&
+                         st->irmp_param.protocol != IRMP_RUWIDO_PROTOCOL && // Manchester, but not RUWIDO
+                         st->irmp_param.protocol != IRMP_RC6_PROTOCOL)      // Manchester, but not RC6
                     {
-                        if (irmp_pause_time > irmp_param.pulse_1_len_max && irmp_pause_time <= 2 * irmp_param.pulse_1_len_max)
+                        if (st->irmp_pause_time > st->irmp_param.pulse_1_len_max && st->irmp_pause_time <= 2 * st->irmp_param.pulse_1_len_max)
                         {
 #ifdef ANALYZE
-                            ANALYZE_PRINTF ("%8.3fms [bit %2d: pulse = %3d, pause = %3d] ", (double) (time_counter * 1000) / F_INTERRUPTS, irmp_bit, irmp_pulse_time, irmp_pause_time);
-                            ANALYZE_PUTCHAR ((irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? '0' : '1');
+                            ANALYZE_PRINTF ("%8.3fms [bit %2d: pulse = %3d, pause = %3d] ", (double) (st->time_counter * 1000) / F_INTERRUPTS, st->irmp_bit, st->irmp_pulse_time, st->irmp_pause_time);
+                            ANALYZE_PUTCHAR ((st->irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? '0' : '1');
                             ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                            irmp_store_bit ((irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? 0 : 1);
+                            irmp_store_bit (st, (st->irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? 0 : 1);
                         }
-                        else if (! last_value)  // && irmp_pause_time >= irmp_param.pause_1_len_min && irmp_pause_time <= irmp_param.pause_1_len_max)
+                        else if (! st->last_value)  // && irmp_pause_time >= irmp_param.pause_1_len_min && irmp_pause_time <= irmp_param.pause_1_len_max)
                         {
 #ifdef ANALYZE
-                            ANALYZE_PRINTF ("%8.3fms [bit %2d: pulse = %3d, pause = %3d] ", (double) (time_counter * 1000) / F_INTERRUPTS, irmp_bit, irmp_pulse_time, irmp_pause_time);
-                            ANALYZE_PUTCHAR ((irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? '1' : '0');
+                            ANALYZE_PRINTF ("%8.3fms [bit %2d: pulse = %3d, pause = %3d] ", (double) (st->time_counter * 1000) / F_INTERRUPTS, st->irmp_bit, st->irmp_pulse_time, st->irmp_pause_time);
+                            ANALYZE_PUTCHAR ((st->irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? '1' : '0');
                             ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                            irmp_store_bit ((irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? 1 : 0);
+                            irmp_store_bit (st, (st->irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? 1 : 0);
                         }
                     }
                     else
 #endif // IRMP_SUPPORT_MANCHESTER == 1
 
 #if IRMP_SUPPORT_SERIAL == 1
-                    if (irmp_param.flags & IRMP_PARAM_FLAG_IS_SERIAL)
+                    if (st->irmp_param.flags & IRMP_PARAM_FLAG_IS_SERIAL)
                     {
                         ; // do nothing
                     }
@@ -3540,19 +4204,19 @@ irmp_ISR (void)
 
 
 #if IRMP_SUPPORT_DENON_PROTOCOL == 1
-                    if (irmp_param.protocol == IRMP_DENON_PROTOCOL)
+                    if (st->irmp_param.protocol == IRMP_DENON_PROTOCOL)
                     {
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("%8.3fms [bit %2d: pulse = %3d, pause = %3d] ", (double) (time_counter * 1000) / F_INTERRUPTS, irmp_bit, irmp_pulse_time, irmp_pause_time);
+                        ANALYZE_PRINTF ("%8.3fms [bit %2d: pulse = %3d, pause = %3d] ", (double) (st->time_counter * 1000) / F_INTERRUPTS, st->irmp_bit, st->irmp_pulse_time, st->irmp_pause_time);
 #endif // ANALYZE
 
-                        if (irmp_pause_time >= DENON_1_PAUSE_LEN_MIN && irmp_pause_time <= DENON_1_PAUSE_LEN_MAX)
+                        if (st->irmp_pause_time >= DENON_1_PAUSE_LEN_MIN && st->irmp_pause_time <= DENON_1_PAUSE_LEN_MAX)
                         {                                                       // pause timings correct for "1"?
 #ifdef ANALYZE
                             ANALYZE_PUTCHAR ('1');                                  // yes, store 1
                             ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                            irmp_store_bit (1);
+                            irmp_store_bit (st, 1);
                         }
                         else // if (irmp_pause_time >= DENON_0_PAUSE_LEN_MIN && irmp_pause_time <= DENON_0_PAUSE_LEN_MAX)
                         {                                                       // pause timings correct for "0"?
@@ -3560,25 +4224,25 @@ irmp_ISR (void)
                             ANALYZE_PUTCHAR ('0');                                  // yes, store 0
                             ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                            irmp_store_bit (0);
+                            irmp_store_bit (st, 0);
                         }
                     }
                     else
 #endif // IRMP_SUPPORT_DENON_PROTOCOL == 1
 #if IRMP_SUPPORT_THOMSON_PROTOCOL == 1
-                    if (irmp_param.protocol == IRMP_THOMSON_PROTOCOL)
+                    if (st->irmp_param.protocol == IRMP_THOMSON_PROTOCOL)
                     {
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("%8.3fms [bit %2d: pulse = %3d, pause = %3d] ", (double) (time_counter * 1000) / F_INTERRUPTS, irmp_bit, irmp_pulse_time, irmp_pause_time);
+                        ANALYZE_PRINTF ("%8.3fms [bit %2d: pulse = %3d, pause = %3d] ", (double) (st->time_counter * 1000) / F_INTERRUPTS, st->irmp_bit, st->irmp_pulse_time, st->irmp_pause_time);
 #endif // ANALYZE
 
-                        if (irmp_pause_time >= THOMSON_1_PAUSE_LEN_MIN && irmp_pause_time <= THOMSON_1_PAUSE_LEN_MAX)
+                        if (st->irmp_pause_time >= THOMSON_1_PAUSE_LEN_MIN && st->irmp_pause_time <= THOMSON_1_PAUSE_LEN_MAX)
                         {                                                       // pause timings correct for "1"?
 #ifdef ANALYZE
                           ANALYZE_PUTCHAR ('1');                                  // yes, store 1
                           ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                          irmp_store_bit (1);
+                          irmp_store_bit (st, 1);
                         }
                         else // if (irmp_pause_time >= THOMSON_0_PAUSE_LEN_MIN && irmp_pause_time <= THOMSON_0_PAUSE_LEN_MAX)
                         {                                                       // pause timings correct for "0"?
@@ -3586,7 +4250,7 @@ irmp_ISR (void)
                           ANALYZE_PUTCHAR ('0');                                  // yes, store 0
                           ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                          irmp_store_bit (0);
+                          irmp_store_bit (st, 0);
                         }
                     }
                     else
@@ -3595,76 +4259,76 @@ irmp_ISR (void)
                         ;                                                       // else do nothing
                     }
 
-                    irmp_pulse_time = 1;                                        // set counter to 1, not 0
-                    irmp_pause_time = 0;
-                    wait_for_start_space = 0;
+                    st->irmp_pulse_time = 1;                                        // set counter to 1, not 0
+                    st->irmp_pause_time = 0;
+                    st->wait_for_start_space = 0;
                 }
             }
-            else if (wait_for_space)                                            // the data section....
+            else if (st->wait_for_space)                                            // the data section....
             {                                                                   // counting the time of darkness....
                 uint_fast8_t got_light = FALSE;
 
                 if (irmp_input)                                                 // still dark?
                 {                                                               // yes...
-                    if (irmp_bit == irmp_param.complete_len && irmp_param.stop_bit == 1)
+                    if (st->irmp_bit == st->irmp_param.complete_len && st->irmp_param.stop_bit == 1)
                     {
                         if (
 #if IRMP_SUPPORT_MANCHESTER == 1
-                            (irmp_param.flags & IRMP_PARAM_FLAG_IS_MANCHESTER) ||
+                            (st->irmp_param.flags & IRMP_PARAM_FLAG_IS_MANCHESTER) ||
 #endif
 #if IRMP_SUPPORT_SERIAL == 1
-                            (irmp_param.flags & IRMP_PARAM_FLAG_IS_SERIAL) ||
+                            (st->irmp_param.flags & IRMP_PARAM_FLAG_IS_SERIAL) ||
 #endif
-                            (irmp_pulse_time >= irmp_param.pulse_0_len_min && irmp_pulse_time <= irmp_param.pulse_0_len_max))
+                            (st->irmp_pulse_time >= st->irmp_param.pulse_0_len_min && st->irmp_pulse_time <= st->irmp_param.pulse_0_len_max))
                         {
 #ifdef ANALYZE
-                            if (! (irmp_param.flags & IRMP_PARAM_FLAG_IS_MANCHESTER))
+                            if (! (st->irmp_param.flags & IRMP_PARAM_FLAG_IS_MANCHESTER))
                             {
                                 ANALYZE_PRINTF ("stop bit detected\n");
                             }
 #endif // ANALYZE
-                            irmp_param.stop_bit = 0;
+                            st->irmp_param.stop_bit = 0;
                         }
                         else
                         {
 #ifdef ANALYZE
                             ANALYZE_PRINTF ("error: stop bit timing wrong, irmp_bit = %d, irmp_pulse_time = %d, pulse_0_len_min = %d, pulse_0_len_max = %d\n",
-                                            irmp_bit, irmp_pulse_time, irmp_param.pulse_0_len_min, irmp_param.pulse_0_len_max);
+                                            st->irmp_bit, st->irmp_pulse_time, st->irmp_param.pulse_0_len_min, st->irmp_param.pulse_0_len_max);
 #endif // ANALYZE
-                            irmp_start_bit_detected = 0;                        // wait for another start bit...
-                            irmp_pulse_time         = 0;
-                            irmp_pause_time         = 0;
+                            st->irmp_start_bit_detected = 0;                        // wait for another start bit...
+                            st->irmp_pulse_time         = 0;
+                            st->irmp_pause_time         = 0;
                         }
                     }
                     else
                     {
-                        irmp_pause_time++;                                                          // increment counter
+                        st->irmp_pause_time++;                                                          // increment counter
 
 #if IRMP_SUPPORT_SIRCS_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_SIRCS_PROTOCOL &&                           // Sony has a variable number of bits:
-                            irmp_pause_time > SIRCS_PAUSE_LEN_MAX &&                                // minimum is 12
-                            irmp_bit >= 12 - 1)                                                     // pause too long?
+                        if (st->irmp_param.protocol == IRMP_SIRCS_PROTOCOL &&                           // Sony has a variable number of bits:
+                            st->irmp_pause_time > SIRCS_PAUSE_LEN_MAX &&                                // minimum is 12
+                            st->irmp_bit >= 12 - 1)                                                     // pause too long?
                         {                                                                           // yes, break and close this frame
-                            irmp_param.complete_len = irmp_bit + 1;                                 // set new complete length
+                            st->irmp_param.complete_len = st->irmp_bit + 1;                                 // set new complete length
                             got_light = TRUE;                                                       // this is a lie, but helps (generates stop bit)
-                            irmp_tmp_address |= (irmp_bit - SIRCS_MINIMUM_DATA_LEN + 1) << 8;       // new: store number of additional bits in upper byte of address!
-                            irmp_param.command_end = irmp_param.command_offset + irmp_bit + 1;      // correct command length
-                            irmp_pause_time = SIRCS_PAUSE_LEN_MAX - 1;                              // correct pause length
+                            st->irmp_tmp_address |= (st->irmp_bit - SIRCS_MINIMUM_DATA_LEN + 1) << 8;       // new: store number of additional bits in upper byte of address!
+                            st->irmp_param.command_end = st->irmp_param.command_offset + st->irmp_bit + 1;      // correct command length
+                            st->irmp_pause_time = SIRCS_PAUSE_LEN_MAX - 1;                              // correct pause length
                         }
                         else
 #endif
 #if IRMP_SUPPORT_FAN_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_FAN_PROTOCOL &&                             // FAN has no stop bit.
-                            irmp_bit >= FAN_COMPLETE_DATA_LEN - 1)                                  // last bit in frame
+                        if (st->irmp_param.protocol == IRMP_FAN_PROTOCOL &&                             // FAN has no stop bit.
+                            st->irmp_bit >= FAN_COMPLETE_DATA_LEN - 1)                                  // last bit in frame
                         {                                                                           // yes, break and close this frame
-                            if (irmp_pulse_time <= FAN_0_PULSE_LEN_MAX && irmp_pause_time >= FAN_0_PAUSE_LEN_MIN)
+                            if (st->irmp_pulse_time <= FAN_0_PULSE_LEN_MAX && st->irmp_pause_time >= FAN_0_PAUSE_LEN_MIN)
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("Generating virtual stop bit\n");
 #endif // ANALYZE
                                 got_light = TRUE;                                                   // this is a lie, but helps (generates stop bit)
                             }
-                            else if (irmp_pulse_time >= FAN_1_PULSE_LEN_MIN && irmp_pause_time >= FAN_1_PAUSE_LEN_MIN)
+                            else if (st->irmp_pulse_time >= FAN_1_PULSE_LEN_MIN && st->irmp_pause_time >= FAN_1_PAUSE_LEN_MIN)
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("Generating virtual stop bit\n");
@@ -3676,103 +4340,103 @@ irmp_ISR (void)
 #endif
 #if IRMP_SUPPORT_SERIAL == 1
                         // NETBOX generates no stop bit, here is the timeout condition:
-                        if ((irmp_param.flags & IRMP_PARAM_FLAG_IS_SERIAL) && irmp_param.protocol == IRMP_NETBOX_PROTOCOL &&
-                            irmp_pause_time >= NETBOX_PULSE_LEN * (NETBOX_COMPLETE_DATA_LEN - irmp_bit))
+                        if ((st->irmp_param.flags & IRMP_PARAM_FLAG_IS_SERIAL) && st->irmp_param.protocol == IRMP_NETBOX_PROTOCOL &&
+                            st->irmp_pause_time >= NETBOX_PULSE_LEN * (NETBOX_COMPLETE_DATA_LEN - st->irmp_bit))
                         {
                             got_light = TRUE;                                                       // this is a lie, but helps (generates stop bit)
                         }
                         else
 #endif
 #if IRMP_SUPPORT_GRUNDIG_NOKIA_IR60_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_GRUNDIG_PROTOCOL && !irmp_param.stop_bit)
+                        if (st->irmp_param.protocol == IRMP_GRUNDIG_PROTOCOL && !st->irmp_param.stop_bit)
                         {
-                            if (irmp_pause_time > IR60_TIMEOUT_LEN && (irmp_bit == 5 || irmp_bit == 6))
+                            if (st->irmp_pause_time > IR60_TIMEOUT_LEN && (st->irmp_bit == 5 || st->irmp_bit == 6))
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("Switching to IR60 protocol\n");
 #endif // ANALYZE
                                 got_light = TRUE;                                       // this is a lie, but generates a stop bit ;-)
-                                irmp_param.stop_bit = TRUE;                             // set flag
+                                st->irmp_param.stop_bit = TRUE;                             // set flag
 
-                                irmp_param.protocol         = IRMP_IR60_PROTOCOL;       // change protocol
-                                irmp_param.complete_len     = IR60_COMPLETE_DATA_LEN;   // correct complete len
-                                irmp_param.address_offset   = IR60_ADDRESS_OFFSET;
-                                irmp_param.address_end      = IR60_ADDRESS_OFFSET + IR60_ADDRESS_LEN;
-                                irmp_param.command_offset   = IR60_COMMAND_OFFSET;
-                                irmp_param.command_end      = IR60_COMMAND_OFFSET + IR60_COMMAND_LEN;
+                                st->irmp_param.protocol         = IRMP_IR60_PROTOCOL;       // change protocol
+                                st->irmp_param.complete_len     = IR60_COMPLETE_DATA_LEN;   // correct complete len
+                                st->irmp_param.address_offset   = IR60_ADDRESS_OFFSET;
+                                st->irmp_param.address_end      = IR60_ADDRESS_OFFSET + IR60_ADDRESS_LEN;
+                                st->irmp_param.command_offset   = IR60_COMMAND_OFFSET;
+                                st->irmp_param.command_end      = IR60_COMMAND_OFFSET + IR60_COMMAND_LEN;
 
-                                irmp_tmp_command <<= 1;
-                                irmp_tmp_command |= first_bit;
+                                st->irmp_tmp_command <<= 1;
+                                st->irmp_tmp_command |= st->first_bit;
                             }
-                            else if (irmp_pause_time >= 2 * irmp_param.pause_1_len_max && irmp_bit >= GRUNDIG_COMPLETE_DATA_LEN - 2)
+                            else if (st->irmp_pause_time >= 2 * st->irmp_param.pause_1_len_max && st->irmp_bit >= GRUNDIG_COMPLETE_DATA_LEN - 2)
                             {                                                           // special manchester decoder
-                                irmp_param.complete_len = GRUNDIG_COMPLETE_DATA_LEN;    // correct complete len
+                                st->irmp_param.complete_len = GRUNDIG_COMPLETE_DATA_LEN;    // correct complete len
                                 got_light = TRUE;                                       // this is a lie, but generates a stop bit ;-)
-                                irmp_param.stop_bit = TRUE;                             // set flag
+                                st->irmp_param.stop_bit = TRUE;                             // set flag
                             }
-                            else if (irmp_bit >= GRUNDIG_COMPLETE_DATA_LEN)
+                            else if (st->irmp_bit >= GRUNDIG_COMPLETE_DATA_LEN)
                             {
 #ifdef ANALYZE
-                                ANALYZE_PRINTF ("Switching to NOKIA protocol, irmp_bit = %d\n", irmp_bit);
+                                ANALYZE_PRINTF ("Switching to NOKIA protocol, irmp_bit = %d\n", st->irmp_bit);
 #endif // ANALYZE
-                                irmp_param.protocol         = IRMP_NOKIA_PROTOCOL;      // change protocol
-                                irmp_param.address_offset   = NOKIA_ADDRESS_OFFSET;
-                                irmp_param.address_end      = NOKIA_ADDRESS_OFFSET + NOKIA_ADDRESS_LEN;
-                                irmp_param.command_offset   = NOKIA_COMMAND_OFFSET;
-                                irmp_param.command_end      = NOKIA_COMMAND_OFFSET + NOKIA_COMMAND_LEN;
+                                st->irmp_param.protocol         = IRMP_NOKIA_PROTOCOL;      // change protocol
+                                st->irmp_param.address_offset   = NOKIA_ADDRESS_OFFSET;
+                                st->irmp_param.address_end      = NOKIA_ADDRESS_OFFSET + NOKIA_ADDRESS_LEN;
+                                st->irmp_param.command_offset   = NOKIA_COMMAND_OFFSET;
+                                st->irmp_param.command_end      = NOKIA_COMMAND_OFFSET + NOKIA_COMMAND_LEN;
 
-                                if (irmp_tmp_command & 0x300)
+                                if (st->irmp_tmp_command & 0x300)
                                 {
-                                    irmp_tmp_address = (irmp_tmp_command >> 8);
-                                    irmp_tmp_command &= 0xFF;
+                                    st->irmp_tmp_address = (st->irmp_tmp_command >> 8);
+                                    st->irmp_tmp_command &= 0xFF;
                                 }
                             }
                         }
                         else
 #endif
 #if IRMP_SUPPORT_SIEMENS_OR_RUWIDO_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_RUWIDO_PROTOCOL && !irmp_param.stop_bit)
+                        if (st->irmp_param.protocol == IRMP_RUWIDO_PROTOCOL && !st->irmp_param.stop_bit)
                         {
-                            if (irmp_pause_time >= 2 * irmp_param.pause_1_len_max && irmp_bit >= RUWIDO_COMPLETE_DATA_LEN - 2)
+                            if (st->irmp_pause_time >= 2 * st->irmp_param.pause_1_len_max && st->irmp_bit >= RUWIDO_COMPLETE_DATA_LEN - 2)
                             {                                                           // special manchester decoder
-                                irmp_param.complete_len = RUWIDO_COMPLETE_DATA_LEN;     // correct complete len
+                                st->irmp_param.complete_len = RUWIDO_COMPLETE_DATA_LEN;     // correct complete len
                                 got_light = TRUE;                                       // this is a lie, but generates a stop bit ;-)
-                                irmp_param.stop_bit = TRUE;                             // set flag
+                                st->irmp_param.stop_bit = TRUE;                             // set flag
                             }
-                            else if (irmp_bit >= RUWIDO_COMPLETE_DATA_LEN)
+                            else if (st->irmp_bit >= RUWIDO_COMPLETE_DATA_LEN)
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("Switching to SIEMENS protocol\n");
 #endif // ANALYZE
-                                irmp_param.protocol         = IRMP_SIEMENS_PROTOCOL;    // change protocol
-                                irmp_param.address_offset   = SIEMENS_ADDRESS_OFFSET;
-                                irmp_param.address_end      = SIEMENS_ADDRESS_OFFSET + SIEMENS_ADDRESS_LEN;
-                                irmp_param.command_offset   = SIEMENS_COMMAND_OFFSET;
-                                irmp_param.command_end      = SIEMENS_COMMAND_OFFSET + SIEMENS_COMMAND_LEN;
+                                st->irmp_param.protocol         = IRMP_SIEMENS_PROTOCOL;    // change protocol
+                                st->irmp_param.address_offset   = SIEMENS_ADDRESS_OFFSET;
+                                st->irmp_param.address_end      = SIEMENS_ADDRESS_OFFSET + SIEMENS_ADDRESS_LEN;
+                                st->irmp_param.command_offset   = SIEMENS_COMMAND_OFFSET;
+                                st->irmp_param.command_end      = SIEMENS_COMMAND_OFFSET + SIEMENS_COMMAND_LEN;
 
                                 //                   76543210
                                 // RUWIDO:  AAAAAAAAACCCCCCCp
                                 // SIEMENS: AAAAAAAAAAACCCCCCCCCCp
-                                irmp_tmp_address <<= 2;
-                                irmp_tmp_address |= (irmp_tmp_command >> 6);
-                                irmp_tmp_command &= 0x003F;
+                                st->irmp_tmp_address <<= 2;
+                                st->irmp_tmp_address |= (st->irmp_tmp_command >> 6);
+                                st->irmp_tmp_command &= 0x003F;
 //                              irmp_tmp_command <<= 4;
-                                irmp_tmp_command |= last_value;
+                                st->irmp_tmp_command |= st->last_value;
                             }
                         }
                         else
 #endif
 #if IRMP_SUPPORT_ROOMBA_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_ROOMBA_PROTOCOL &&                          // Roomba has no stop bit
-                            irmp_bit >= ROOMBA_COMPLETE_DATA_LEN - 1)                               // it's the last data bit...
+                        if (st->irmp_param.protocol == IRMP_ROOMBA_PROTOCOL &&                          // Roomba has no stop bit
+                            st->irmp_bit >= ROOMBA_COMPLETE_DATA_LEN - 1)                               // it's the last data bit...
                         {                                                                           // break and close this frame
-                            if (irmp_pulse_time >= ROOMBA_1_PULSE_LEN_MIN && irmp_pulse_time <= ROOMBA_1_PULSE_LEN_MAX)
+                            if (st->irmp_pulse_time >= ROOMBA_1_PULSE_LEN_MIN && st->irmp_pulse_time <= ROOMBA_1_PULSE_LEN_MAX)
                             {
-                                irmp_pause_time = ROOMBA_1_PAUSE_LEN_EXACT;
+                                st->irmp_pause_time = ROOMBA_1_PAUSE_LEN_EXACT;
                             }
-                            else if (irmp_pulse_time >= ROOMBA_0_PULSE_LEN_MIN && irmp_pulse_time <= ROOMBA_0_PULSE_LEN_MAX)
+                            else if (st->irmp_pulse_time >= ROOMBA_0_PULSE_LEN_MIN && st->irmp_pulse_time <= ROOMBA_0_PULSE_LEN_MAX)
                             {
-                                irmp_pause_time = ROOMBA_0_PAUSE_LEN;
+                                st->irmp_pause_time = ROOMBA_0_PAUSE_LEN;
                             }
 
                             got_light = TRUE;                                                       // this is a lie, but helps (generates stop bit)
@@ -3780,142 +4444,142 @@ irmp_ISR (void)
                         else
 #endif
 #if IRMP_SUPPORT_MANCHESTER == 1
-                        if ((irmp_param.flags & IRMP_PARAM_FLAG_IS_MANCHESTER) &&
-                            irmp_pause_time >= 2 * irmp_param.pause_1_len_max && irmp_bit >= irmp_param.complete_len - 2 && !irmp_param.stop_bit)
+                        if ((st->irmp_param.flags & IRMP_PARAM_FLAG_IS_MANCHESTER) &&
+                            st->irmp_pause_time >= 2 * st->irmp_param.pause_1_len_max && st->irmp_bit >= st->irmp_param.complete_len - 2 && !st->irmp_param.stop_bit)
                         {                                                       // special manchester decoder
                             got_light = TRUE;                                   // this is a lie, but generates a stop bit ;-)
-                            irmp_param.stop_bit = TRUE;                         // set flag
+                            st->irmp_param.stop_bit = TRUE;                         // set flag
                         }
                         else
 #endif // IRMP_SUPPORT_MANCHESTER == 1
-                        if (irmp_pause_time > IRMP_TIMEOUT_LEN)                 // timeout?
+                        if (st->irmp_pause_time > IRMP_TIMEOUT_LEN)                 // timeout?
                         {                                                       // yes...
-                            if (irmp_bit == irmp_param.complete_len - 1 && irmp_param.stop_bit == 0)
+                            if (st->irmp_bit == st->irmp_param.complete_len - 1 && st->irmp_param.stop_bit == 0)
                             {
-                                irmp_bit++;
+                                st->irmp_bit++;
                             }
 #if IRMP_SUPPORT_JVC_PROTOCOL == 1
-                            else if (irmp_param.protocol == IRMP_NEC_PROTOCOL && (irmp_bit == 16 || irmp_bit == 17))      // it was a JVC stop bit
+                            else if (st->irmp_param.protocol == IRMP_NEC_PROTOCOL && (st->irmp_bit == 16 || st->irmp_bit == 17))      // it was a JVC stop bit
                             {
 #ifdef ANALYZE
-                                ANALYZE_PRINTF ("Switching to JVC protocol, irmp_bit = %d\n", irmp_bit);
+                                ANALYZE_PRINTF ("Switching to JVC protocol, irmp_bit = %d\n", st->irmp_bit);
 #endif // ANALYZE
-                                irmp_param.stop_bit     = TRUE;                                     // set flag
-                                irmp_param.protocol     = IRMP_JVC_PROTOCOL;                        // switch protocol
-                                irmp_param.complete_len = irmp_bit;                                 // patch length: 16 or 17
-                                irmp_tmp_command        = (irmp_tmp_address >> 4);                  // set command: upper 12 bits are command bits
-                                irmp_tmp_address        = irmp_tmp_address & 0x000F;                // lower 4 bits are address bits
-                                irmp_start_bit_detected = 1;                                        // tricky: don't wait for another start bit...
+                                st->irmp_param.stop_bit     = TRUE;                                     // set flag
+                                st->irmp_param.protocol     = IRMP_JVC_PROTOCOL;                        // switch protocol
+                                st->irmp_param.complete_len = st->irmp_bit;                                 // patch length: 16 or 17
+                                st->irmp_tmp_command        = (st->irmp_tmp_address >> 4);                  // set command: upper 12 bits are command bits
+                                st->irmp_tmp_address        = st->irmp_tmp_address & 0x000F;                // lower 4 bits are address bits
+                                st->irmp_start_bit_detected = 1;                                        // tricky: don't wait for another start bit...
                             }
 #endif // IRMP_SUPPORT_JVC_PROTOCOL == 1
 #if IRMP_SUPPORT_LGAIR_PROTOCOL == 1
-                            else if (irmp_param.protocol == IRMP_NEC_PROTOCOL && (irmp_bit == 28 || irmp_bit == 29))      // it was a LGAIR stop bit
+                            else if (st->irmp_param.protocol == IRMP_NEC_PROTOCOL && (st->irmp_bit == 28 || st->irmp_bit == 29))      // it was a LGAIR stop bit
                             {
 #ifdef ANALYZE
-                                ANALYZE_PRINTF ("Switching to LGAIR protocol, irmp_bit = %d\n", irmp_bit);
+                                ANALYZE_PRINTF ("Switching to LGAIR protocol, irmp_bit = %d\n", st->irmp_bit);
 #endif // ANALYZE
-                                irmp_param.stop_bit     = TRUE;                                     // set flag
-                                irmp_param.protocol     = IRMP_LGAIR_PROTOCOL;                      // switch protocol
-                                irmp_param.complete_len = irmp_bit;                                 // patch length: 16 or 17
-                                irmp_tmp_command        = irmp_lgair_command;                       // set command: upper 8 bits are command bits
-                                irmp_tmp_address        = irmp_lgair_address;                       // lower 4 bits are address bits
-                                irmp_start_bit_detected = 1;                                        // tricky: don't wait for another start bit...
+                                st->irmp_param.stop_bit     = TRUE;                                     // set flag
+                                st->irmp_param.protocol     = IRMP_LGAIR_PROTOCOL;                      // switch protocol
+                                st->irmp_param.complete_len = st->irmp_bit;                                 // patch length: 16 or 17
+                                st->irmp_tmp_command        = st->irmp_lgair_command;                       // set command: upper 8 bits are command bits
+                                st->irmp_tmp_address        = st->irmp_lgair_address;                       // lower 4 bits are address bits
+                                st->irmp_start_bit_detected = 1;                                        // tricky: don't wait for another start bit...
                             }
 #endif // IRMP_SUPPORT_LGAIR_PROTOCOL == 1
 
 #if IRMP_SUPPORT_NEC42_PROTOCOL == 1
 #if IRMP_SUPPORT_NEC_PROTOCOL == 1
-                            else if (irmp_param.protocol == IRMP_NEC42_PROTOCOL && irmp_bit == 32)      // it was a NEC stop bit
+                            else if (st->irmp_param.protocol == IRMP_NEC42_PROTOCOL && st->irmp_bit == 32)      // it was a NEC stop bit
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("Switching to NEC protocol\n");
 #endif // ANALYZE
-                                irmp_param.stop_bit     = TRUE;                                     // set flag
-                                irmp_param.protocol     = IRMP_NEC_PROTOCOL;                        // switch protocol
-                                irmp_param.complete_len = irmp_bit;                                 // patch length: 16 or 17
+                                st->irmp_param.stop_bit     = TRUE;                                     // set flag
+                                st->irmp_param.protocol     = IRMP_NEC_PROTOCOL;                        // switch protocol
+                                st->irmp_param.complete_len = st->irmp_bit;                                 // patch length: 16 or 17
 
                                 //        0123456789ABC0123456789ABC0123456701234567
                                 // NEC42: AAAAAAAAAAAAAaaaaaaaaaaaaaCCCCCCCCcccccccc
                                 // NEC:   AAAAAAAAaaaaaaaaCCCCCCCCcccccccc
-                                irmp_tmp_address        |= (irmp_tmp_address2 & 0x0007) << 13;      // fm 2012-02-13: 12 -> 13
-                                irmp_tmp_command        = (irmp_tmp_address2 >> 3) | (irmp_tmp_command << 10);
+                                st->irmp_tmp_address        |= (st->irmp_tmp_address2 & 0x0007) << 13;      // fm 2012-02-13: 12 -> 13
+                                st->irmp_tmp_command        = (st->irmp_tmp_address2 >> 3) | (st->irmp_tmp_command << 10);
                             }
 #endif // IRMP_SUPPORT_NEC_PROTOCOL == 1
 #if IRMP_SUPPORT_LGAIR_PROTOCOL == 1
-                            else if (irmp_param.protocol == IRMP_NEC42_PROTOCOL && irmp_bit == 28)      // it was a NEC stop bit
+                            else if (st->irmp_param.protocol == IRMP_NEC42_PROTOCOL && st->irmp_bit == 28)      // it was a NEC stop bit
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("Switching to LGAIR protocol\n");
 #endif // ANALYZE
-                                irmp_param.stop_bit     = TRUE;                                     // set flag
-                                irmp_param.protocol     = IRMP_LGAIR_PROTOCOL;                      // switch protocol
-                                irmp_param.complete_len = irmp_bit;                                 // patch length: 16 or 17
-                                irmp_tmp_address        = irmp_lgair_address;
-                                irmp_tmp_command        = irmp_lgair_command;
+                                st->irmp_param.stop_bit     = TRUE;                                     // set flag
+                                st->irmp_param.protocol     = IRMP_LGAIR_PROTOCOL;                      // switch protocol
+                                st->irmp_param.complete_len = st->irmp_bit;                                 // patch length: 16 or 17
+                                st->irmp_tmp_address        = st->irmp_lgair_address;
+                                st->irmp_tmp_command        = st->irmp_lgair_command;
                             }
 #endif // IRMP_SUPPORT_LGAIR_PROTOCOL == 1
 #if IRMP_SUPPORT_JVC_PROTOCOL == 1
-                            else if (irmp_param.protocol == IRMP_NEC42_PROTOCOL && (irmp_bit == 16 || irmp_bit == 17))  // it was a JVC stop bit
+                            else if (st->irmp_param.protocol == IRMP_NEC42_PROTOCOL && (st->irmp_bit == 16 || st->irmp_bit == 17))  // it was a JVC stop bit
                             {
 #ifdef ANALYZE
-                                ANALYZE_PRINTF ("Switching to JVC protocol, irmp_bit = %d\n", irmp_bit);
+                                ANALYZE_PRINTF ("Switching to JVC protocol, irmp_bit = %d\n", st->irmp_bit);
 #endif // ANALYZE
-                                irmp_param.stop_bit     = TRUE;                                     // set flag
-                                irmp_param.protocol     = IRMP_JVC_PROTOCOL;                        // switch protocol
-                                irmp_param.complete_len = irmp_bit;                                 // patch length: 16 or 17
+                                st->irmp_param.stop_bit     = TRUE;                                     // set flag
+                                st->irmp_param.protocol     = IRMP_JVC_PROTOCOL;                        // switch protocol
+                                st->irmp_param.complete_len = st->irmp_bit;                                 // patch length: 16 or 17
 
                                 //        0123456789ABC0123456789ABC0123456701234567
                                 // NEC42: AAAAAAAAAAAAAaaaaaaaaaaaaaCCCCCCCCcccccccc
                                 // JVC:   AAAACCCCCCCCCCCC
-                                irmp_tmp_command        = (irmp_tmp_address >> 4) | (irmp_tmp_address2 << 9);   // set command: upper 12 bits are command bits
-                                irmp_tmp_address        = irmp_tmp_address & 0x000F;                            // lower 4 bits are address bits
+                                st->irmp_tmp_command        = (st->irmp_tmp_address >> 4) | (st->irmp_tmp_address2 << 9);   // set command: upper 12 bits are command bits
+                                st->irmp_tmp_address        = st->irmp_tmp_address & 0x000F;                            // lower 4 bits are address bits
                             }
 #endif // IRMP_SUPPORT_JVC_PROTOCOL == 1
 #endif // IRMP_SUPPORT_NEC42_PROTOCOL == 1
 
 #if IRMP_SUPPORT_SAMSUNG48_PROTOCOL == 1
-                            else if (irmp_param.protocol == IRMP_SAMSUNG48_PROTOCOL && irmp_bit == 32)          // it was a SAMSUNG32 stop bit
+                            else if (st->irmp_param.protocol == IRMP_SAMSUNG48_PROTOCOL && st->irmp_bit == 32)          // it was a SAMSUNG32 stop bit
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("Switching to SAMSUNG32 protocol\n");
 #endif // ANALYZE
-                                irmp_param.protocol         = IRMP_SAMSUNG32_PROTOCOL;
-                                irmp_param.command_offset   = SAMSUNG32_COMMAND_OFFSET;
-                                irmp_param.command_end      = SAMSUNG32_COMMAND_OFFSET + SAMSUNG32_COMMAND_LEN;
-                                irmp_param.complete_len     = SAMSUNG32_COMPLETE_DATA_LEN;
+                                st->irmp_param.protocol         = IRMP_SAMSUNG32_PROTOCOL;
+                                st->irmp_param.command_offset   = SAMSUNG32_COMMAND_OFFSET;
+                                st->irmp_param.command_end      = SAMSUNG32_COMMAND_OFFSET + SAMSUNG32_COMMAND_LEN;
+                                st->irmp_param.complete_len     = SAMSUNG32_COMPLETE_DATA_LEN;
                             }
 #endif // IRMP_SUPPORT_SAMSUNG_PROTOCOL == 1
 
 #if IRMP_SUPPORT_RCMM_PROTOCOL == 1
-                            else if (irmp_param.protocol == IRMP_RCMM32_PROTOCOL && (irmp_bit == 12 || irmp_bit == 24))  // it was a RCMM stop bit
+                            else if (st->irmp_param.protocol == IRMP_RCMM32_PROTOCOL && (st->irmp_bit == 12 || st->irmp_bit == 24))  // it was a RCMM stop bit
                             {
-                                if (irmp_bit == 12)
+                                if (st->irmp_bit == 12)
                                 {
-                                    irmp_tmp_command = (irmp_tmp_address & 0xFF);                   // set command: lower 8 bits are command bits
-                                    irmp_tmp_address >>= 8;                                         // upper 4 bits are address bits
+                                    st->irmp_tmp_command = (st->irmp_tmp_address & 0xFF);                   // set command: lower 8 bits are command bits
+                                    st->irmp_tmp_address >>= 8;                                         // upper 4 bits are address bits
 
 #ifdef ANALYZE
-                                    ANALYZE_PRINTF ("Switching to RCMM12 protocol, irmp_bit = %d\n", irmp_bit);
+                                    ANALYZE_PRINTF ("Switching to RCMM12 protocol, irmp_bit = %d\n", st->irmp_bit);
 #endif // ANALYZE
-                                    irmp_param.protocol     = IRMP_RCMM12_PROTOCOL;                 // switch protocol
+                                    st->irmp_param.protocol     = IRMP_RCMM12_PROTOCOL;                 // switch protocol
                                 }
                                 else // if ((irmp_bit == 24)
                                 {
 #ifdef ANALYZE
-                                    ANALYZE_PRINTF ("Switching to RCMM24 protocol, irmp_bit = %d\n", irmp_bit);
+                                    ANALYZE_PRINTF ("Switching to RCMM24 protocol, irmp_bit = %d\n", st->irmp_bit);
 #endif // ANALYZE
-                                    irmp_param.protocol     = IRMP_RCMM24_PROTOCOL;                 // switch protocol
+                                    st->irmp_param.protocol     = IRMP_RCMM24_PROTOCOL;                 // switch protocol
                                 }
-                                irmp_param.stop_bit     = TRUE;                                     // set flag
-                                irmp_param.complete_len = irmp_bit;                                 // patch length
+                                st->irmp_param.stop_bit     = TRUE;                                     // set flag
+                                st->irmp_param.complete_len = st->irmp_bit;                                 // patch length
                             }
 #endif // IRMP_SUPPORT_RCMM_PROTOCOL == 1
 
 #if IRMP_SUPPORT_TECHNICS_PROTOCOL == 1
-                            else if (irmp_param.protocol == IRMP_MATSUSHITA_PROTOCOL && irmp_bit == 22)  // it was a TECHNICS stop bit
+                            else if (st->irmp_param.protocol == IRMP_MATSUSHITA_PROTOCOL && st->irmp_bit == 22)  // it was a TECHNICS stop bit
                             {
 #ifdef ANALYZE
-                                ANALYZE_PRINTF ("Switching to TECHNICS protocol, irmp_bit = %d\n", irmp_bit);
+                                ANALYZE_PRINTF ("Switching to TECHNICS protocol, irmp_bit = %d\n", st->irmp_bit);
 #endif // ANALYZE
                                 // Situation:
                                 // The first 12 bits have been stored in irmp_tmp_command (LSB first)
@@ -3925,19 +4589,19 @@ irmp_ISR (void)
                                 //   ccccccccccccaaaaaaaaaa
                                 // where C is inverted value of c
 
-                                irmp_tmp_address <<= 1;
-                                if (irmp_tmp_command & (1<<11))
+                                st->irmp_tmp_address <<= 1;
+                                if (st->irmp_tmp_command & (1<<11))
                                 {
-                                    irmp_tmp_address |= 1;
-                                    irmp_tmp_command &= ~(1<<11);
+                                    st->irmp_tmp_address |= 1;
+                                    st->irmp_tmp_command &= ~(1<<11);
                                 }
 
-                                if (irmp_tmp_command == ((~irmp_tmp_address) & 0x07FF))
+                                if (st->irmp_tmp_command == ((~st->irmp_tmp_address) & 0x07FF))
                                 {
-                                    irmp_tmp_address = 0;
+                                    st->irmp_tmp_address = 0;
 
-                                    irmp_param.protocol     = IRMP_TECHNICS_PROTOCOL;                   // switch protocol
-                                    irmp_param.complete_len = irmp_bit;                                 // patch length
+                                    st->irmp_param.protocol     = IRMP_TECHNICS_PROTOCOL;                   // switch protocol
+                                    st->irmp_param.complete_len = st->irmp_bit;                                 // patch length
                                 }
                                 else
                                 {
@@ -3945,21 +4609,21 @@ irmp_ISR (void)
                                     ANALYZE_PRINTF ("error 8: TECHNICS frame error\n");
                                     ANALYZE_ONLY_NORMAL_PUTCHAR ('\n');
 #endif // ANALYZE
-                                    irmp_start_bit_detected = 0;                    // wait for another start bit...
-                                    irmp_pulse_time         = 0;
-                                    irmp_pause_time         = 0;
+                                    st->irmp_start_bit_detected = 0;                    // wait for another start bit...
+                                    st->irmp_pulse_time         = 0;
+                                    st->irmp_pause_time         = 0;
                                 }
                             }
 #endif // IRMP_SUPPORT_TECHNICS_PROTOCOL == 1
                             else
                             {
 #ifdef ANALYZE
-                                ANALYZE_PRINTF ("error 2: pause %d after data bit %d too long\n", irmp_pause_time, irmp_bit);
+                                ANALYZE_PRINTF ("error 2: pause %d after data bit %d too long\n", st->irmp_pause_time, st->irmp_bit);
                                 ANALYZE_ONLY_NORMAL_PUTCHAR ('\n');
 #endif // ANALYZE
-                                irmp_start_bit_detected = 0;                    // wait for another start bit...
-                                irmp_pulse_time         = 0;
-                                irmp_pause_time         = 0;
+                                st->irmp_start_bit_detected = 0;                    // wait for another start bit...
+                                st->irmp_pulse_time         = 0;
+                                st->irmp_pause_time         = 0;
                             }
                         }
                     }
@@ -3972,34 +4636,34 @@ irmp_ISR (void)
                 if (got_light)
                 {
 #ifdef ANALYZE
-                    ANALYZE_PRINTF ("%8.3fms [bit %2d: pulse = %3d, pause = %3d] ", (double) (time_counter * 1000) / F_INTERRUPTS, irmp_bit, irmp_pulse_time, irmp_pause_time);
+                    ANALYZE_PRINTF ("%8.3fms [bit %2d: pulse = %3d, pause = %3d] ", (double) (st->time_counter * 1000) / F_INTERRUPTS, st->irmp_bit, st->irmp_pulse_time, st->irmp_pause_time);
 #endif // ANALYZE
 
 #if IRMP_SUPPORT_MANCHESTER == 1
-                    if ((irmp_param.flags & IRMP_PARAM_FLAG_IS_MANCHESTER))                                     // Manchester
+                    if ((st->irmp_param.flags & IRMP_PARAM_FLAG_IS_MANCHESTER))                                     // Manchester
                     {
 #if 1
-                        if (irmp_pulse_time > irmp_param.pulse_1_len_max /* && irmp_pulse_time <= 2 * irmp_param.pulse_1_len_max */)
+                        if (st->irmp_pulse_time > st->irmp_param.pulse_1_len_max /* && irmp_pulse_time <= 2 * irmp_param.pulse_1_len_max */)
 #else // better, but some IR-RCs use asymmetric timings :-/
-                        if (irmp_pulse_time > irmp_param.pulse_1_len_max && irmp_pulse_time <= 2 * irmp_param.pulse_1_len_max &&
-                            irmp_pause_time <= 2 * irmp_param.pause_1_len_max)
+                        if (st->irmp_pulse_time > st->irmp_param.pulse_1_len_max && st->irmp_pulse_time <= 2 * st->irmp_param.pulse_1_len_max &&
+                            st->irmp_pause_time <= 2 * st->irmp_param.pause_1_len_max)
 #endif
                         {
 #if IRMP_SUPPORT_RC6_PROTOCOL == 1
-                            if (irmp_param.protocol == IRMP_RC6_PROTOCOL && irmp_bit == 4 && irmp_pulse_time > RC6_TOGGLE_BIT_LEN_MIN)         // RC6 toggle bit
+                            if (st->irmp_param.protocol == IRMP_RC6_PROTOCOL && st->irmp_bit == 4 && st->irmp_pulse_time > RC6_TOGGLE_BIT_LEN_MIN)         // RC6 toggle bit
                             {
 #ifdef ANALYZE
                                 ANALYZE_PUTCHAR ('T');
 #endif // ANALYZE
-                                if (irmp_param.complete_len == RC6_COMPLETE_DATA_LEN_LONG)                      // RC6 mode 6A
+                                if (st->irmp_param.complete_len == RC6_COMPLETE_DATA_LEN_LONG)                      // RC6 mode 6A
                                 {
-                                    irmp_store_bit (1);
-                                    last_value = 1;
+                                    irmp_store_bit (st, 1);
+                                    st->last_value = 1;
                                 }
                                 else                                                                            // RC6 mode 0
                                 {
-                                    irmp_store_bit (0);
-                                    last_value = 0;
+                                    irmp_store_bit (st, 0);
+                                    st->last_value = 0;
                                 }
 #ifdef ANALYZE
                                 ANALYZE_NEWLINE ();
@@ -4009,25 +4673,25 @@ irmp_ISR (void)
 #endif // IRMP_SUPPORT_RC6_PROTOCOL == 1
                             {
 #ifdef ANALYZE
-                                ANALYZE_PUTCHAR ((irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? '0' : '1');
+                                ANALYZE_PUTCHAR ((st->irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? '0' : '1');
 #endif // ANALYZE
-                                irmp_store_bit ((irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? 0  :  1 );
+                                irmp_store_bit (st, (st->irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? 0  :  1 );
 
 #if IRMP_SUPPORT_RC6_PROTOCOL == 1
-                                if (irmp_param.protocol == IRMP_RC6_PROTOCOL && irmp_bit == 4 && irmp_pulse_time > RC6_TOGGLE_BIT_LEN_MIN)      // RC6 toggle bit
+                                if (st->irmp_param.protocol == IRMP_RC6_PROTOCOL && st->irmp_bit == 4 && st->irmp_pulse_time > RC6_TOGGLE_BIT_LEN_MIN)      // RC6 toggle bit
                                 {
 #ifdef ANALYZE
                                     ANALYZE_PUTCHAR ('T');
 #endif // ANALYZE
-                                    irmp_store_bit (1);
+                                    irmp_store_bit (st, 1);
 
-                                    if (irmp_pause_time > 2 * irmp_param.pause_1_len_max)
+                                    if (st->irmp_pause_time > 2 * st->irmp_param.pause_1_len_max)
                                     {
-                                        last_value = 0;
+                                        st->last_value = 0;
                                     }
                                     else
                                     {
-                                        last_value = 1;
+                                        st->last_value = 1;
                                     }
 #ifdef ANALYZE
                                     ANALYZE_NEWLINE ();
@@ -4037,34 +4701,34 @@ irmp_ISR (void)
 #endif // IRMP_SUPPORT_RC6_PROTOCOL == 1
                                 {
 #ifdef ANALYZE
-                                    ANALYZE_PUTCHAR ((irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? '1' : '0');
+                                    ANALYZE_PUTCHAR ((st->irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? '1' : '0');
 #endif // ANALYZE
-                                    irmp_store_bit ((irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? 1 :   0 );
+                                    irmp_store_bit (st, (st->irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? 1 :   0 );
 #if IRMP_SUPPORT_RC5_PROTOCOL == 1 && (IRMP_SUPPORT_FDC_PROTOCOL == 1 || IRMP_SUPPORT_RCCAR_PROTOCOL == 1)
-                                    if (! irmp_param2.protocol)
+                                    if (! st->irmp_param2.protocol)
 #endif
                                     {
 #ifdef ANALYZE
                                         ANALYZE_NEWLINE ();
 #endif // ANALYZE
                                     }
-                                    last_value = (irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? 1 : 0;
+                                    st->last_value = (st->irmp_param.flags & IRMP_PARAM_FLAG_1ST_PULSE_IS_1) ? 1 : 0;
                                 }
                             }
                         }
-                        else if (irmp_pulse_time >= irmp_param.pulse_1_len_min && irmp_pulse_time <= irmp_param.pulse_1_len_max
+                        else if (st->irmp_pulse_time >= st->irmp_param.pulse_1_len_min && st->irmp_pulse_time <= st->irmp_param.pulse_1_len_max
                                  /* && irmp_pause_time <= 2 * irmp_param.pause_1_len_max */)
                         {
                             uint_fast8_t manchester_value;
 
-                            if (last_pause > irmp_param.pause_1_len_max && last_pause <= 2 * irmp_param.pause_1_len_max)
+                            if (st->last_pause > st->irmp_param.pause_1_len_max && st->last_pause <= 2 * st->irmp_param.pause_1_len_max)
                             {
-                                manchester_value = last_value ? 0 : 1;
-                                last_value  = manchester_value;
+                                manchester_value = st->last_value ? 0 : 1;
+                                st->last_value  = manchester_value;
                             }
                             else
                             {
-                                manchester_value = last_value;
+                                manchester_value = st->last_value;
                             }
 
 #ifdef ANALYZE
@@ -4072,7 +4736,7 @@ irmp_ISR (void)
 #endif // ANALYZE
 
 #if IRMP_SUPPORT_RC5_PROTOCOL == 1 && (IRMP_SUPPORT_FDC_PROTOCOL == 1 || IRMP_SUPPORT_RCCAR_PROTOCOL == 1)
-                            if (! irmp_param2.protocol)
+                            if (! st->irmp_param2.protocol)
 #endif
                             {
 #ifdef ANALYZE
@@ -4081,47 +4745,47 @@ irmp_ISR (void)
                             }
 
 #if IRMP_SUPPORT_RC6_PROTOCOL == 1
-                            if (irmp_param.protocol == IRMP_RC6_PROTOCOL && irmp_bit == 1 && manchester_value == 1)     // RC6 mode != 0 ???
+                            if (st->irmp_param.protocol == IRMP_RC6_PROTOCOL && st->irmp_bit == 1 && manchester_value == 1)     // RC6 mode != 0 ???
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("Switching to RC6A protocol\n");
 #endif // ANALYZE
-                                irmp_param.complete_len = RC6_COMPLETE_DATA_LEN_LONG;
-                                irmp_param.address_offset = 5;
-                                irmp_param.address_end = irmp_param.address_offset + 15;
-                                irmp_param.command_offset = irmp_param.address_end + 1;                                 // skip 1 system bit, changes like a toggle bit
-                                irmp_param.command_end = irmp_param.command_offset + 16 - 1;
-                                irmp_tmp_address = 0;
+                                st->irmp_param.complete_len = RC6_COMPLETE_DATA_LEN_LONG;
+                                st->irmp_param.address_offset = 5;
+                                st->irmp_param.address_end = st->irmp_param.address_offset + 15;
+                                st->irmp_param.command_offset = st->irmp_param.address_end + 1;                                 // skip 1 system bit, changes like a toggle bit
+                                st->irmp_param.command_end = st->irmp_param.command_offset + 16 - 1;
+                                st->irmp_tmp_address = 0;
                             }
 #endif // IRMP_SUPPORT_RC6_PROTOCOL == 1
 
-                            irmp_store_bit (manchester_value);
+                            irmp_store_bit (st, manchester_value);
                         }
                         else
                         {
 #if IRMP_SUPPORT_RC5_PROTOCOL == 1 && IRMP_SUPPORT_FDC_PROTOCOL == 1
-                            if (irmp_param2.protocol == IRMP_FDC_PROTOCOL &&
-                                irmp_pulse_time >= FDC_PULSE_LEN_MIN && irmp_pulse_time <= FDC_PULSE_LEN_MAX &&
-                                ((irmp_pause_time >= FDC_1_PAUSE_LEN_MIN && irmp_pause_time <= FDC_1_PAUSE_LEN_MAX) ||
-                                 (irmp_pause_time >= FDC_0_PAUSE_LEN_MIN && irmp_pause_time <= FDC_0_PAUSE_LEN_MAX)))
+                            if (st->irmp_param2.protocol == IRMP_FDC_PROTOCOL &&
+                                st->irmp_pulse_time >= FDC_PULSE_LEN_MIN && st->irmp_pulse_time <= FDC_PULSE_LEN_MAX &&
+                                ((st->irmp_pause_time >= FDC_1_PAUSE_LEN_MIN && st->irmp_pause_time <= FDC_1_PAUSE_LEN_MAX) ||
+                                 (st->irmp_pause_time >= FDC_0_PAUSE_LEN_MIN && st->irmp_pause_time <= FDC_0_PAUSE_LEN_MAX)))
                             {
 #ifdef ANALYZE
                                 ANALYZE_PUTCHAR ('?');
 #endif // ANALYZE
-                                irmp_param.protocol = 0;                // switch to FDC, see below
+                                st->irmp_param.protocol = 0;                // switch to FDC, see below
                             }
                             else
 #endif // IRMP_SUPPORT_FDC_PROTOCOL == 1
 #if IRMP_SUPPORT_RC5_PROTOCOL == 1 && IRMP_SUPPORT_RCCAR_PROTOCOL == 1
-                            if (irmp_param2.protocol == IRMP_RCCAR_PROTOCOL &&
-                                irmp_pulse_time >= RCCAR_PULSE_LEN_MIN && irmp_pulse_time <= RCCAR_PULSE_LEN_MAX &&
-                                ((irmp_pause_time >= RCCAR_1_PAUSE_LEN_MIN && irmp_pause_time <= RCCAR_1_PAUSE_LEN_MAX) ||
-                                 (irmp_pause_time >= RCCAR_0_PAUSE_LEN_MIN && irmp_pause_time <= RCCAR_0_PAUSE_LEN_MAX)))
+                            if (st->irmp_param2.protocol == IRMP_RCCAR_PROTOCOL &&
+                                st->irmp_pulse_time >= RCCAR_PULSE_LEN_MIN && st->irmp_pulse_time <= RCCAR_PULSE_LEN_MAX &&
+                                ((st->irmp_pause_time >= RCCAR_1_PAUSE_LEN_MIN && st->irmp_pause_time <= RCCAR_1_PAUSE_LEN_MAX) ||
+                                 (st->irmp_pause_time >= RCCAR_0_PAUSE_LEN_MIN && st->irmp_pause_time <= RCCAR_0_PAUSE_LEN_MAX)))
                             {
 #ifdef ANALYZE
                                 ANALYZE_PUTCHAR ('?');
 #endif // ANALYZE
-                                irmp_param.protocol = 0;                // switch to RCCAR, see below
+                                st->irmp_param.protocol = 0;                // switch to RCCAR, see below
                             }
                             else
 #endif // IRMP_SUPPORT_RCCAR_PROTOCOL == 1
@@ -4129,164 +4793,164 @@ irmp_ISR (void)
 #ifdef ANALYZE
                                 ANALYZE_PUTCHAR ('?');
                                 ANALYZE_NEWLINE ();
-                                ANALYZE_PRINTF ("error 3 manchester: timing not correct: data bit %d,  pulse: %d, pause: %d\n", irmp_bit, irmp_pulse_time, irmp_pause_time);
+                                ANALYZE_PRINTF ("error 3 manchester: timing not correct: data bit %d,  pulse: %d, pause: %d\n", st->irmp_bit, st->irmp_pulse_time, st->irmp_pause_time);
                                 ANALYZE_ONLY_NORMAL_PUTCHAR ('\n');
 #endif // ANALYZE
-                                irmp_start_bit_detected = 0;                            // reset flags and wait for next start bit
-                                irmp_pause_time         = 0;
+                                st->irmp_start_bit_detected = 0;                            // reset flags and wait for next start bit
+                                st->irmp_pause_time         = 0;
                             }
                         }
 
 #if IRMP_SUPPORT_RC5_PROTOCOL == 1 && IRMP_SUPPORT_FDC_PROTOCOL == 1
-                        if (irmp_param2.protocol == IRMP_FDC_PROTOCOL && irmp_pulse_time >= FDC_PULSE_LEN_MIN && irmp_pulse_time <= FDC_PULSE_LEN_MAX)
+                        if (st->irmp_param2.protocol == IRMP_FDC_PROTOCOL && st->irmp_pulse_time >= FDC_PULSE_LEN_MIN && st->irmp_pulse_time <= FDC_PULSE_LEN_MAX)
                         {
-                            if (irmp_pause_time >= FDC_1_PAUSE_LEN_MIN && irmp_pause_time <= FDC_1_PAUSE_LEN_MAX)
+                            if (st->irmp_pause_time >= FDC_1_PAUSE_LEN_MIN && st->irmp_pause_time <= FDC_1_PAUSE_LEN_MAX)
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("   1 (FDC)\n");
 #endif // ANALYZE
-                                irmp_store_bit2 (1);
+                                irmp_store_bit2 (st, 1);
                             }
-                            else if (irmp_pause_time >= FDC_0_PAUSE_LEN_MIN && irmp_pause_time <= FDC_0_PAUSE_LEN_MAX)
+                            else if (st->irmp_pause_time >= FDC_0_PAUSE_LEN_MIN && st->irmp_pause_time <= FDC_0_PAUSE_LEN_MAX)
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("   0 (FDC)\n");
 #endif // ANALYZE
-                                irmp_store_bit2 (0);
+                                irmp_store_bit2 (st, 0);
                             }
 
-                            if (! irmp_param.protocol)
+                            if (! st->irmp_param.protocol)
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("Switching to FDC protocol\n");
 #endif // ANALYZE
-                                memcpy (&irmp_param, &irmp_param2, sizeof (IRMP_PARAMETER));
-                                irmp_param2.protocol = 0;
-                                irmp_tmp_address = irmp_tmp_address2;
-                                irmp_tmp_command = irmp_tmp_command2;
+                                memcpy (&st->irmp_param, &st->irmp_param2, sizeof (IRMP_PARAMETER));
+                                st->irmp_param2.protocol = 0;
+                                st->irmp_tmp_address = st->irmp_tmp_address2;
+                                st->irmp_tmp_command = st->irmp_tmp_command2;
                             }
                         }
 #endif // IRMP_SUPPORT_FDC_PROTOCOL == 1
 #if IRMP_SUPPORT_RC5_PROTOCOL == 1 && IRMP_SUPPORT_RCCAR_PROTOCOL == 1
-                        if (irmp_param2.protocol == IRMP_RCCAR_PROTOCOL && irmp_pulse_time >= RCCAR_PULSE_LEN_MIN && irmp_pulse_time <= RCCAR_PULSE_LEN_MAX)
+                        if (st->irmp_param2.protocol == IRMP_RCCAR_PROTOCOL && st->irmp_pulse_time >= RCCAR_PULSE_LEN_MIN && st->irmp_pulse_time <= RCCAR_PULSE_LEN_MAX)
                         {
-                            if (irmp_pause_time >= RCCAR_1_PAUSE_LEN_MIN && irmp_pause_time <= RCCAR_1_PAUSE_LEN_MAX)
+                            if (st->irmp_pause_time >= RCCAR_1_PAUSE_LEN_MIN && st->irmp_pause_time <= RCCAR_1_PAUSE_LEN_MAX)
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("   1 (RCCAR)\n");
 #endif // ANALYZE
-                                irmp_store_bit2 (1);
+                                irmp_store_bit2 (st, 1);
                             }
-                            else if (irmp_pause_time >= RCCAR_0_PAUSE_LEN_MIN && irmp_pause_time <= RCCAR_0_PAUSE_LEN_MAX)
+                            else if (st->irmp_pause_time >= RCCAR_0_PAUSE_LEN_MIN && st->irmp_pause_time <= RCCAR_0_PAUSE_LEN_MAX)
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("   0 (RCCAR)\n");
 #endif // ANALYZE
-                                irmp_store_bit2 (0);
+                                irmp_store_bit2 (st, 0);
                             }
 
-                            if (! irmp_param.protocol)
+                            if (! st->irmp_param.protocol)
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("Switching to RCCAR protocol\n");
 #endif // ANALYZE
-                                memcpy (&irmp_param, &irmp_param2, sizeof (IRMP_PARAMETER));
-                                irmp_param2.protocol = 0;
-                                irmp_tmp_address = irmp_tmp_address2;
-                                irmp_tmp_command = irmp_tmp_command2;
+                                memcpy (&st->irmp_param, &st->irmp_param2, sizeof (IRMP_PARAMETER));
+                                st->irmp_param2.protocol = 0;
+                                st->irmp_tmp_address = st->irmp_tmp_address2;
+                                st->irmp_tmp_command = st->irmp_tmp_command2;
                             }
                         }
 #endif // IRMP_SUPPORT_RCCAR_PROTOCOL == 1
 
-                        last_pause      = irmp_pause_time;
-                        wait_for_space  = 0;
+                        st->last_pause      = st->irmp_pause_time;
+                        st->wait_for_space  = 0;
                     }
                     else
 #endif // IRMP_SUPPORT_MANCHESTER == 1
 
 #if IRMP_SUPPORT_SERIAL == 1
-                    if (irmp_param.flags & IRMP_PARAM_FLAG_IS_SERIAL)
+                    if (st->irmp_param.flags & IRMP_PARAM_FLAG_IS_SERIAL)
                     {
-                        while (irmp_bit < irmp_param.complete_len && irmp_pulse_time > irmp_param.pulse_1_len_max)
+                        while (st->irmp_bit < st->irmp_param.complete_len && st->irmp_pulse_time > st->irmp_param.pulse_1_len_max)
                         {
 #ifdef ANALYZE
                             ANALYZE_PUTCHAR ('1');
 #endif // ANALYZE
-                            irmp_store_bit (1);
+                            irmp_store_bit (st, 1);
 
-                            if (irmp_pulse_time >= irmp_param.pulse_1_len_min)
+                            if (st->irmp_pulse_time >= st->irmp_param.pulse_1_len_min)
                             {
-                                irmp_pulse_time -= irmp_param.pulse_1_len_min;
+                                st->irmp_pulse_time -= st->irmp_param.pulse_1_len_min;
                             }
                             else
                             {
-                                irmp_pulse_time = 0;
+                                st->irmp_pulse_time = 0;
                             }
                         }
 
-                        while (irmp_bit < irmp_param.complete_len && irmp_pause_time > irmp_param.pause_1_len_max)
+                        while (st->irmp_bit < st->irmp_param.complete_len && st->irmp_pause_time > st->irmp_param.pause_1_len_max)
                         {
 #ifdef ANALYZE
                             ANALYZE_PUTCHAR ('0');
 #endif // ANALYZE
-                            irmp_store_bit (0);
+                            irmp_store_bit (st, 0);
 
-                            if (irmp_pause_time >= irmp_param.pause_1_len_min)
+                            if (st->irmp_pause_time >= st->irmp_param.pause_1_len_min)
                             {
-                                irmp_pause_time -= irmp_param.pause_1_len_min;
+                                st->irmp_pause_time -= st->irmp_param.pause_1_len_min;
                             }
                             else
                             {
-                                irmp_pause_time = 0;
+                                st->irmp_pause_time = 0;
                             }
                         }
 #ifdef ANALYZE
                         ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                        wait_for_space = 0;
+                        st->wait_for_space = 0;
                     }
                     else
 #endif // IRMP_SUPPORT_SERIAL == 1
 
 #if IRMP_SUPPORT_SAMSUNG_PROTOCOL == 1
-                    if (irmp_param.protocol == IRMP_SAMSUNG_PROTOCOL && irmp_bit == 16)       // Samsung: 16th bit
+                    if (st->irmp_param.protocol == IRMP_SAMSUNG_PROTOCOL && st->irmp_bit == 16)       // Samsung: 16th bit
                     {
-                        if (irmp_pulse_time >= SAMSUNG_PULSE_LEN_MIN && irmp_pulse_time <= SAMSUNG_PULSE_LEN_MAX &&
-                            irmp_pause_time >= SAMSUNG_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= SAMSUNG_START_BIT_PAUSE_LEN_MAX)
+                        if (st->irmp_pulse_time >= SAMSUNG_PULSE_LEN_MIN && st->irmp_pulse_time <= SAMSUNG_PULSE_LEN_MAX &&
+                            st->irmp_pause_time >= SAMSUNG_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= SAMSUNG_START_BIT_PAUSE_LEN_MAX)
                         {
 #ifdef ANALYZE
                             ANALYZE_PRINTF ("SYNC\n");
 #endif // ANALYZE
-                            wait_for_space = 0;
-                            irmp_bit++;
+                            st->wait_for_space = 0;
+                            st->irmp_bit++;
                         }
-                        else  if (irmp_pulse_time >= SAMSUNG_PULSE_LEN_MIN && irmp_pulse_time <= SAMSUNG_PULSE_LEN_MAX)
+                        else  if (st->irmp_pulse_time >= SAMSUNG_PULSE_LEN_MIN && st->irmp_pulse_time <= SAMSUNG_PULSE_LEN_MAX)
                         {
 #if IRMP_SUPPORT_SAMSUNG48_PROTOCOL == 1
 #ifdef ANALYZE
                             ANALYZE_PRINTF ("Switching to SAMSUNG48 protocol ");
 #endif // ANALYZE
-                            irmp_param.protocol         = IRMP_SAMSUNG48_PROTOCOL;
-                            irmp_param.command_offset   = SAMSUNG48_COMMAND_OFFSET;
-                            irmp_param.command_end      = SAMSUNG48_COMMAND_OFFSET + SAMSUNG48_COMMAND_LEN;
-                            irmp_param.complete_len     = SAMSUNG48_COMPLETE_DATA_LEN;
+                            st->irmp_param.protocol         = IRMP_SAMSUNG48_PROTOCOL;
+                            st->irmp_param.command_offset   = SAMSUNG48_COMMAND_OFFSET;
+                            st->irmp_param.command_end      = SAMSUNG48_COMMAND_OFFSET + SAMSUNG48_COMMAND_LEN;
+                            st->irmp_param.complete_len     = SAMSUNG48_COMPLETE_DATA_LEN;
 #else
 #ifdef ANALYZE
                             ANALYZE_PRINTF ("Switching to SAMSUNG32 protocol ");
 #endif // ANALYZE
-                            irmp_param.protocol         = IRMP_SAMSUNG32_PROTOCOL;
-                            irmp_param.command_offset   = SAMSUNG32_COMMAND_OFFSET;
-                            irmp_param.command_end      = SAMSUNG32_COMMAND_OFFSET + SAMSUNG32_COMMAND_LEN;
-                            irmp_param.complete_len     = SAMSUNG32_COMPLETE_DATA_LEN;
+                            st->irmp_param.protocol         = IRMP_SAMSUNG32_PROTOCOL;
+                            st->irmp_param.command_offset   = SAMSUNG32_COMMAND_OFFSET;
+                            st->irmp_param.command_end      = SAMSUNG32_COMMAND_OFFSET + SAMSUNG32_COMMAND_LEN;
+                            st->irmp_param.complete_len     = SAMSUNG32_COMPLETE_DATA_LEN;
 #endif
-                            if (irmp_pause_time >= SAMSUNG_1_PAUSE_LEN_MIN && irmp_pause_time <= SAMSUNG_1_PAUSE_LEN_MAX)
+                            if (st->irmp_pause_time >= SAMSUNG_1_PAUSE_LEN_MIN && st->irmp_pause_time <= SAMSUNG_1_PAUSE_LEN_MAX)
                             {
 #ifdef ANALYZE
                                 ANALYZE_PUTCHAR ('1');
                                 ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                                irmp_store_bit (1);
-                                wait_for_space = 0;
+                                irmp_store_bit (st, 1);
+                                st->wait_for_space = 0;
                             }
                             else
                             {
@@ -4294,18 +4958,18 @@ irmp_ISR (void)
                                 ANALYZE_PUTCHAR ('0');
                                 ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                                irmp_store_bit (0);
-                                wait_for_space = 0;
+                                irmp_store_bit (st, 0);
+                                st->wait_for_space = 0;
                             }
                         }
                         else
                         {                                                           // timing incorrect!
 #ifdef ANALYZE
-                            ANALYZE_PRINTF ("error 3 Samsung: timing not correct: data bit %d,  pulse: %d, pause: %d\n", irmp_bit, irmp_pulse_time, irmp_pause_time);
+                            ANALYZE_PRINTF ("error 3 Samsung: timing not correct: data bit %d,  pulse: %d, pause: %d\n", st->irmp_bit, st->irmp_pulse_time, st->irmp_pause_time);
                             ANALYZE_ONLY_NORMAL_PUTCHAR ('\n');
 #endif // ANALYZE
-                            irmp_start_bit_detected = 0;                            // reset flags and wait for next start bit
-                            irmp_pause_time         = 0;
+                            st->irmp_start_bit_detected = 0;                            // reset flags and wait for next start bit
+                            st->irmp_pause_time         = 0;
                         }
                     }
                     else
@@ -4313,212 +4977,212 @@ irmp_ISR (void)
 
 #if IRMP_SUPPORT_NEC16_PROTOCOL
 #if IRMP_SUPPORT_NEC42_PROTOCOL == 1
-                    if (irmp_param.protocol == IRMP_NEC42_PROTOCOL &&
+                    if (st->irmp_param.protocol == IRMP_NEC42_PROTOCOL &&
 #else // IRMP_SUPPORT_NEC_PROTOCOL instead
-                    if (irmp_param.protocol == IRMP_NEC_PROTOCOL &&
+                    if (st->irmp_param.protocol == IRMP_NEC_PROTOCOL &&
 #endif // IRMP_SUPPORT_NEC42_PROTOCOL == 1
-                        irmp_bit == 8 && irmp_pause_time >= NEC_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= NEC_START_BIT_PAUSE_LEN_MAX)
+                        st->irmp_bit == 8 && st->irmp_pause_time >= NEC_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= NEC_START_BIT_PAUSE_LEN_MAX)
                     {
 #ifdef ANALYZE
                         ANALYZE_PRINTF ("Switching to NEC16 protocol\n");
 #endif // ANALYZE
-                        irmp_param.protocol         = IRMP_NEC16_PROTOCOL;
-                        irmp_param.address_offset   = NEC16_ADDRESS_OFFSET;
-                        irmp_param.address_end      = NEC16_ADDRESS_OFFSET + NEC16_ADDRESS_LEN;
-                        irmp_param.command_offset   = NEC16_COMMAND_OFFSET;
-                        irmp_param.command_end      = NEC16_COMMAND_OFFSET + NEC16_COMMAND_LEN;
-                        irmp_param.complete_len     = NEC16_COMPLETE_DATA_LEN;
-                        wait_for_space = 0;
+                        st->irmp_param.protocol         = IRMP_NEC16_PROTOCOL;
+                        st->irmp_param.address_offset   = NEC16_ADDRESS_OFFSET;
+                        st->irmp_param.address_end      = NEC16_ADDRESS_OFFSET + NEC16_ADDRESS_LEN;
+                        st->irmp_param.command_offset   = NEC16_COMMAND_OFFSET;
+                        st->irmp_param.command_end      = NEC16_COMMAND_OFFSET + NEC16_COMMAND_LEN;
+                        st->irmp_param.complete_len     = NEC16_COMPLETE_DATA_LEN;
+                        st->wait_for_space = 0;
                     }
                     else
 #endif // IRMP_SUPPORT_NEC16_PROTOCOL
 
 #if IRMP_SUPPORT_BANG_OLUFSEN_PROTOCOL == 1
-                    if (irmp_param.protocol == IRMP_BANG_OLUFSEN_PROTOCOL)
+                    if (st->irmp_param.protocol == IRMP_BANG_OLUFSEN_PROTOCOL)
                     {
-                        if (irmp_pulse_time >= BANG_OLUFSEN_PULSE_LEN_MIN && irmp_pulse_time <= BANG_OLUFSEN_PULSE_LEN_MAX)
+                        if (st->irmp_pulse_time >= BANG_OLUFSEN_PULSE_LEN_MIN && st->irmp_pulse_time <= BANG_OLUFSEN_PULSE_LEN_MAX)
                         {
-                            if (irmp_bit == 1)                                      // Bang & Olufsen: 3rd bit
+                            if (st->irmp_bit == 1)                                      // Bang & Olufsen: 3rd bit
                             {
-                                if (irmp_pause_time >= BANG_OLUFSEN_START_BIT3_PAUSE_LEN_MIN && irmp_pause_time <= BANG_OLUFSEN_START_BIT3_PAUSE_LEN_MAX)
+                                if (st->irmp_pause_time >= BANG_OLUFSEN_START_BIT3_PAUSE_LEN_MIN && st->irmp_pause_time <= BANG_OLUFSEN_START_BIT3_PAUSE_LEN_MAX)
                                 {
 #ifdef ANALYZE
                                     ANALYZE_PRINTF ("3rd start bit\n");
 #endif // ANALYZE
-                                    wait_for_space = 0;
-                                    irmp_bit++;
+                                    st->wait_for_space = 0;
+                                    st->irmp_bit++;
                                 }
                                 else
                                 {                                                   // timing incorrect!
 #ifdef ANALYZE
-                                    ANALYZE_PRINTF ("error 3a B&O: timing not correct: data bit %d,  pulse: %d, pause: %d\n", irmp_bit, irmp_pulse_time, irmp_pause_time);
+                                    ANALYZE_PRINTF ("error 3a B&O: timing not correct: data bit %d,  pulse: %d, pause: %d\n", st->irmp_bit, st->irmp_pulse_time, st->irmp_pause_time);
                                     ANALYZE_ONLY_NORMAL_PUTCHAR ('\n');
 #endif // ANALYZE
-                                    irmp_start_bit_detected = 0;                    // reset flags and wait for next start bit
-                                    irmp_pause_time         = 0;
+                                    st->irmp_start_bit_detected = 0;                    // reset flags and wait for next start bit
+                                    st->irmp_pause_time         = 0;
                                 }
                             }
-                            else if (irmp_bit == 19)                                // Bang & Olufsen: trailer bit
+                            else if (st->irmp_bit == 19)                                // Bang & Olufsen: trailer bit
                             {
-                                if (irmp_pause_time >= BANG_OLUFSEN_TRAILER_BIT_PAUSE_LEN_MIN && irmp_pause_time <= BANG_OLUFSEN_TRAILER_BIT_PAUSE_LEN_MAX)
+                                if (st->irmp_pause_time >= BANG_OLUFSEN_TRAILER_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= BANG_OLUFSEN_TRAILER_BIT_PAUSE_LEN_MAX)
                                 {
 #ifdef ANALYZE
                                     ANALYZE_PRINTF ("trailer bit\n");
 #endif // ANALYZE
-                                    wait_for_space = 0;
-                                    irmp_bit++;
+                                    st->wait_for_space = 0;
+                                    st->irmp_bit++;
                                 }
                                 else
                                 {                                                   // timing incorrect!
 #ifdef ANALYZE
-                                    ANALYZE_PRINTF ("error 3b B&O: timing not correct: data bit %d,  pulse: %d, pause: %d\n", irmp_bit, irmp_pulse_time, irmp_pause_time);
+                                    ANALYZE_PRINTF ("error 3b B&O: timing not correct: data bit %d,  pulse: %d, pause: %d\n", st->irmp_bit, st->irmp_pulse_time, st->irmp_pause_time);
                                     ANALYZE_ONLY_NORMAL_PUTCHAR ('\n');
 #endif // ANALYZE
-                                    irmp_start_bit_detected = 0;                    // reset flags and wait for next start bit
-                                    irmp_pause_time         = 0;
+                                    st->irmp_start_bit_detected = 0;                    // reset flags and wait for next start bit
+                                    st->irmp_pause_time         = 0;
                                 }
                             }
                             else
                             {
-                                if (irmp_pause_time >= BANG_OLUFSEN_1_PAUSE_LEN_MIN && irmp_pause_time <= BANG_OLUFSEN_1_PAUSE_LEN_MAX)
+                                if (st->irmp_pause_time >= BANG_OLUFSEN_1_PAUSE_LEN_MIN && st->irmp_pause_time <= BANG_OLUFSEN_1_PAUSE_LEN_MAX)
                                 {                                                   // pulse & pause timings correct for "1"?
 #ifdef ANALYZE
                                     ANALYZE_PUTCHAR ('1');
                                     ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                                    irmp_store_bit (1);
-                                    last_value = 1;
-                                    wait_for_space = 0;
+                                    irmp_store_bit (st, 1);
+                                    st->last_value = 1;
+                                    st->wait_for_space = 0;
                                 }
-                                else if (irmp_pause_time >= BANG_OLUFSEN_0_PAUSE_LEN_MIN && irmp_pause_time <= BANG_OLUFSEN_0_PAUSE_LEN_MAX)
+                                else if (st->irmp_pause_time >= BANG_OLUFSEN_0_PAUSE_LEN_MIN && st->irmp_pause_time <= BANG_OLUFSEN_0_PAUSE_LEN_MAX)
                                 {                                                   // pulse & pause timings correct for "0"?
 #ifdef ANALYZE
                                     ANALYZE_PUTCHAR ('0');
                                     ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                                    irmp_store_bit (0);
-                                    last_value = 0;
-                                    wait_for_space = 0;
+                                    irmp_store_bit (st, 0);
+                                    st->last_value = 0;
+                                    st->wait_for_space = 0;
                                 }
-                                else if (irmp_pause_time >= BANG_OLUFSEN_R_PAUSE_LEN_MIN && irmp_pause_time <= BANG_OLUFSEN_R_PAUSE_LEN_MAX)
+                                else if (st->irmp_pause_time >= BANG_OLUFSEN_R_PAUSE_LEN_MIN && st->irmp_pause_time <= BANG_OLUFSEN_R_PAUSE_LEN_MAX)
                                 {
 #ifdef ANALYZE
-                                    ANALYZE_PUTCHAR (last_value + '0');
+                                    ANALYZE_PUTCHAR (st->last_value + '0');
                                     ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                                    irmp_store_bit (last_value);
-                                    wait_for_space = 0;
+                                    irmp_store_bit (st, st->last_value);
+                                    st->wait_for_space = 0;
                                 }
                                 else
                                 {                                                   // timing incorrect!
 #ifdef ANALYZE
-                                    ANALYZE_PRINTF ("error 3c B&O: timing not correct: data bit %d,  pulse: %d, pause: %d\n", irmp_bit, irmp_pulse_time, irmp_pause_time);
+                                    ANALYZE_PRINTF ("error 3c B&O: timing not correct: data bit %d,  pulse: %d, pause: %d\n", st->irmp_bit, st->irmp_pulse_time, st->irmp_pause_time);
                                     ANALYZE_ONLY_NORMAL_PUTCHAR ('\n');
 #endif // ANALYZE
-                                    irmp_start_bit_detected = 0;                    // reset flags and wait for next start bit
-                                    irmp_pause_time         = 0;
+                                    st->irmp_start_bit_detected = 0;                    // reset flags and wait for next start bit
+                                    st->irmp_pause_time         = 0;
                                 }
                             }
                         }
                         else
                         {                                                           // timing incorrect!
 #ifdef ANALYZE
-                            ANALYZE_PRINTF ("error 3d B&O: timing not correct: data bit %d,  pulse: %d, pause: %d\n", irmp_bit, irmp_pulse_time, irmp_pause_time);
+                            ANALYZE_PRINTF ("error 3d B&O: timing not correct: data bit %d,  pulse: %d, pause: %d\n", st->irmp_bit, st->irmp_pulse_time, st->irmp_pause_time);
                             ANALYZE_ONLY_NORMAL_PUTCHAR ('\n');
 #endif // ANALYZE
-                            irmp_start_bit_detected = 0;                            // reset flags and wait for next start bit
-                            irmp_pause_time         = 0;
+                            st->irmp_start_bit_detected = 0;                            // reset flags and wait for next start bit
+                            st->irmp_pause_time         = 0;
                         }
                     }
                     else
 #endif // IRMP_SUPPORT_BANG_OLUFSEN_PROTOCOL
 
 #if IRMP_SUPPORT_RCMM_PROTOCOL == 1
-                    if (irmp_param.protocol == IRMP_RCMM32_PROTOCOL)
+                    if (st->irmp_param.protocol == IRMP_RCMM32_PROTOCOL)
                     {
-                        if (irmp_pause_time >= RCMM32_BIT_00_PAUSE_LEN_MIN && irmp_pause_time <= RCMM32_BIT_00_PAUSE_LEN_MAX)
+                        if (st->irmp_pause_time >= RCMM32_BIT_00_PAUSE_LEN_MIN && st->irmp_pause_time <= RCMM32_BIT_00_PAUSE_LEN_MAX)
                         {
 #ifdef ANALYZE
                             ANALYZE_PUTCHAR ('0');
                             ANALYZE_PUTCHAR ('0');
 #endif // ANALYZE
-                            irmp_store_bit (0);
-                            irmp_store_bit (0);
+                            irmp_store_bit (st, 0);
+                            irmp_store_bit (st, 0);
                         }
-                        else if (irmp_pause_time >= RCMM32_BIT_01_PAUSE_LEN_MIN && irmp_pause_time <= RCMM32_BIT_01_PAUSE_LEN_MAX)
+                        else if (st->irmp_pause_time >= RCMM32_BIT_01_PAUSE_LEN_MIN && st->irmp_pause_time <= RCMM32_BIT_01_PAUSE_LEN_MAX)
                         {
 #ifdef ANALYZE
                             ANALYZE_PUTCHAR ('0');
                             ANALYZE_PUTCHAR ('1');
 #endif // ANALYZE
-                            irmp_store_bit (0);
-                            irmp_store_bit (1);
+                            irmp_store_bit (st, 0);
+                            irmp_store_bit (st, 1);
                         }
-                        else if (irmp_pause_time >= RCMM32_BIT_10_PAUSE_LEN_MIN && irmp_pause_time <= RCMM32_BIT_10_PAUSE_LEN_MAX)
+                        else if (st->irmp_pause_time >= RCMM32_BIT_10_PAUSE_LEN_MIN && st->irmp_pause_time <= RCMM32_BIT_10_PAUSE_LEN_MAX)
                         {
 #ifdef ANALYZE
                             ANALYZE_PUTCHAR ('1');
                             ANALYZE_PUTCHAR ('0');
 #endif // ANALYZE
-                            irmp_store_bit (1);
-                            irmp_store_bit (0);
+                            irmp_store_bit (st, 1);
+                            irmp_store_bit (st, 0);
                         }
-                        else if (irmp_pause_time >= RCMM32_BIT_11_PAUSE_LEN_MIN && irmp_pause_time <= RCMM32_BIT_11_PAUSE_LEN_MAX)
+                        else if (st->irmp_pause_time >= RCMM32_BIT_11_PAUSE_LEN_MIN && st->irmp_pause_time <= RCMM32_BIT_11_PAUSE_LEN_MAX)
                         {
 #ifdef ANALYZE
                             ANALYZE_PUTCHAR ('1');
                             ANALYZE_PUTCHAR ('1');
 #endif // ANALYZE
-                            irmp_store_bit (1);
-                            irmp_store_bit (1);
+                            irmp_store_bit (st, 1);
+                            irmp_store_bit (st, 1);
                         }
 #ifdef ANALYZE
                         ANALYZE_PRINTF ("\n");
 #endif // ANALYZE
-                        wait_for_space = 0;
+                        st->wait_for_space = 0;
                     }
                     else
 #endif
 
-                    if (irmp_pulse_time >= irmp_param.pulse_1_len_min && irmp_pulse_time <= irmp_param.pulse_1_len_max &&
-                        irmp_pause_time >= irmp_param.pause_1_len_min && irmp_pause_time <= irmp_param.pause_1_len_max)
+                    if (st->irmp_pulse_time >= st->irmp_param.pulse_1_len_min && st->irmp_pulse_time <= st->irmp_param.pulse_1_len_max &&
+                        st->irmp_pause_time >= st->irmp_param.pause_1_len_min && st->irmp_pause_time <= st->irmp_param.pause_1_len_max)
                     {                                                               // pulse & pause timings correct for "1"?
 #ifdef ANALYZE
                         ANALYZE_PUTCHAR ('1');
                         ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                        irmp_store_bit (1);
-                        wait_for_space = 0;
+                        irmp_store_bit (st, 1);
+                        st->wait_for_space = 0;
                     }
-                    else if (irmp_pulse_time >= irmp_param.pulse_0_len_min && irmp_pulse_time <= irmp_param.pulse_0_len_max &&
-                             irmp_pause_time >= irmp_param.pause_0_len_min && irmp_pause_time <= irmp_param.pause_0_len_max)
+                    else if (st->irmp_pulse_time >= st->irmp_param.pulse_0_len_min && st->irmp_pulse_time <= st->irmp_param.pulse_0_len_max &&
+                             st->irmp_pause_time >= st->irmp_param.pause_0_len_min && st->irmp_pause_time <= st->irmp_param.pause_0_len_max)
                     {                                                               // pulse & pause timings correct for "0"?
 #ifdef ANALYZE
                         ANALYZE_PUTCHAR ('0');
                         ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                        irmp_store_bit (0);
-                        wait_for_space = 0;
+                        irmp_store_bit (st, 0);
+                        st->wait_for_space = 0;
                     }
                     else
 #if IRMP_SUPPORT_KATHREIN_PROTOCOL
 
-                    if (irmp_param.protocol == IRMP_KATHREIN_PROTOCOL &&
-                        irmp_pulse_time >= KATHREIN_1_PULSE_LEN_MIN && irmp_pulse_time <= KATHREIN_1_PULSE_LEN_MAX &&
-                        (((irmp_bit == 8 || irmp_bit == 6) &&
-                                irmp_pause_time >= KATHREIN_SYNC_BIT_PAUSE_LEN_MIN && irmp_pause_time <= KATHREIN_SYNC_BIT_PAUSE_LEN_MAX) ||
-                         (irmp_bit == 12 &&
-                                irmp_pause_time >= KATHREIN_START_BIT_PAUSE_LEN_MIN && irmp_pause_time <= KATHREIN_START_BIT_PAUSE_LEN_MAX)))
+                    if (st->irmp_param.protocol == IRMP_KATHREIN_PROTOCOL &&
+                        st->irmp_pulse_time >= KATHREIN_1_PULSE_LEN_MIN && st->irmp_pulse_time <= KATHREIN_1_PULSE_LEN_MAX &&
+                        (((st->irmp_bit == 8 || st->irmp_bit == 6) &&
+                                st->irmp_pause_time >= KATHREIN_SYNC_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= KATHREIN_SYNC_BIT_PAUSE_LEN_MAX) ||
+                         (st->irmp_bit == 12 &&
+                                st->irmp_pause_time >= KATHREIN_START_BIT_PAUSE_LEN_MIN && st->irmp_pause_time <= KATHREIN_START_BIT_PAUSE_LEN_MAX)))
 
                     {
-                        if (irmp_bit == 8)
+                        if (st->irmp_bit == 8)
                         {
-                            irmp_bit++;
+                            st->irmp_bit++;
 #ifdef ANALYZE
                             ANALYZE_PUTCHAR ('S');
                             ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                            irmp_tmp_command <<= 1;
+                            st->irmp_tmp_command <<= 1;
                         }
                         else
                         {
@@ -4526,162 +5190,162 @@ irmp_ISR (void)
                             ANALYZE_PUTCHAR ('S');
                             ANALYZE_NEWLINE ();
 #endif // ANALYZE
-                            irmp_store_bit (1);
+                            irmp_store_bit (st, 1);
                         }
-                        wait_for_space = 0;
+                        st->wait_for_space = 0;
                     }
                     else
 #endif // IRMP_SUPPORT_KATHREIN_PROTOCOL
                     {                                                               // timing incorrect!
 #ifdef ANALYZE
-                        ANALYZE_PRINTF ("error 3: timing not correct: data bit %d,  pulse: %d, pause: %d\n", irmp_bit, irmp_pulse_time, irmp_pause_time);
+                        ANALYZE_PRINTF ("error 3: timing not correct: data bit %d,  pulse: %d, pause: %d\n", st->irmp_bit, st->irmp_pulse_time, st->irmp_pause_time);
                         ANALYZE_ONLY_NORMAL_PUTCHAR ('\n');
 #endif // ANALYZE
-                        irmp_start_bit_detected = 0;                                // reset flags and wait for next start bit
-                        irmp_pause_time         = 0;
+                        st->irmp_start_bit_detected = 0;                                // reset flags and wait for next start bit
+                        st->irmp_pause_time         = 0;
                     }
 
-                    irmp_pulse_time = 1;                                            // set counter to 1, not 0
+                    st->irmp_pulse_time = 1;                                            // set counter to 1, not 0
                 }
             }
             else
             {                                                                       // counting the pulse length ...
                 if (! irmp_input)                                                   // still light?
                 {                                                                   // yes...
-                    irmp_pulse_time++;                                              // increment counter
+                    st->irmp_pulse_time++;                                              // increment counter
                 }
                 else
                 {                                                                   // now it's dark!
-                    wait_for_space  = 1;                                            // let's count the time (see above)
-                    irmp_pause_time = 1;                                            // set pause counter to 1, not 0
+                    st->wait_for_space  = 1;                                            // let's count the time (see above)
+                    st->irmp_pause_time = 1;                                            // set pause counter to 1, not 0
                 }
             }
 
-            if (irmp_start_bit_detected && irmp_bit == irmp_param.complete_len && irmp_param.stop_bit == 0)    // enough bits received?
+            if (st->irmp_start_bit_detected && st->irmp_bit == st->irmp_param.complete_len && st->irmp_param.stop_bit == 0)    // enough bits received?
             {
-                if (last_irmp_command == irmp_tmp_command && key_repetition_len < AUTO_FRAME_REPETITION_LEN)
+                if (st->last_irmp_command == st->irmp_tmp_command && st->key_repetition_len < AUTO_FRAME_REPETITION_LEN)
                 {
-                    repetition_frame_number++;
+                    st->repetition_frame_number++;
                 }
                 else
                 {
-                    repetition_frame_number = 0;
+                    st->repetition_frame_number = 0;
                 }
 
 #if IRMP_SUPPORT_SIRCS_PROTOCOL == 1
                 // if SIRCS protocol and the code will be repeated within 50 ms, we will ignore 2nd and 3rd repetition frame
-                if (irmp_param.protocol == IRMP_SIRCS_PROTOCOL && (repetition_frame_number == 1 || repetition_frame_number == 2))
+                if (st->irmp_param.protocol == IRMP_SIRCS_PROTOCOL && (st->repetition_frame_number == 1 || st->repetition_frame_number == 2))
                 {
 #ifdef ANALYZE
                     ANALYZE_PRINTF ("code skipped: SIRCS auto repetition frame #%d, counter = %d, auto repetition len = %d\n",
-                                    repetition_frame_number + 1, key_repetition_len, AUTO_FRAME_REPETITION_LEN);
+                                    st->repetition_frame_number + 1, (int) st->key_repetition_len, (int) AUTO_FRAME_REPETITION_LEN);
 #endif // ANALYZE
-                    key_repetition_len = 0;
+                    st->key_repetition_len = 0;
                 }
                 else
 #endif
 
 #if IRMP_SUPPORT_ORTEK_PROTOCOL == 1
                 // if ORTEK protocol and the code will be repeated within 50 ms, we will ignore 2nd repetition frame
-                if (irmp_param.protocol == IRMP_ORTEK_PROTOCOL && repetition_frame_number == 1)
+                if (st->irmp_param.protocol == IRMP_ORTEK_PROTOCOL && st->repetition_frame_number == 1)
                 {
 #ifdef ANALYZE
                     ANALYZE_PRINTF ("code skipped: ORTEK auto repetition frame #%d, counter = %d, auto repetition len = %d\n",
-                                    repetition_frame_number + 1, key_repetition_len, AUTO_FRAME_REPETITION_LEN);
+                                    st->repetition_frame_number + 1, (int) st->key_repetition_len, (int) AUTO_FRAME_REPETITION_LEN);
 #endif // ANALYZE
-                    key_repetition_len = 0;
+                    st->key_repetition_len = 0;
                 }
                 else
 #endif
 
 #if 0 && IRMP_SUPPORT_KASEIKYO_PROTOCOL == 1    // fm 2015-12-02: don't ignore every 2nd frame
                 // if KASEIKYO protocol and the code will be repeated within 50 ms, we will ignore 2nd repetition frame
-                if (irmp_param.protocol == IRMP_KASEIKYO_PROTOCOL && repetition_frame_number == 1)
+                if (st->irmp_param.protocol == IRMP_KASEIKYO_PROTOCOL && st->repetition_frame_number == 1)
                 {
 #ifdef ANALYZE
                     ANALYZE_PRINTF ("code skipped: KASEIKYO auto repetition frame #%d, counter = %d, auto repetition len = %d\n",
-                                    repetition_frame_number + 1, key_repetition_len, AUTO_FRAME_REPETITION_LEN);
+                                    st->repetition_frame_number + 1, (int) st->key_repetition_len, (int) AUTO_FRAME_REPETITION_LEN);
 #endif // ANALYZE
-                    key_repetition_len = 0;
+                    st->key_repetition_len = 0;
                 }
                 else
 #endif
 
 #if 0 && IRMP_SUPPORT_SAMSUNG_PROTOCOL == 1     // fm 2015-12-02: don't ignore every 2nd frame
                 // if SAMSUNG32 or SAMSUNG48 protocol and the code will be repeated within 50 ms, we will ignore every 2nd frame
-                if ((irmp_param.protocol == IRMP_SAMSUNG32_PROTOCOL || irmp_param.protocol == IRMP_SAMSUNG48_PROTOCOL) && (repetition_frame_number & 0x01))
+                if ((st->irmp_param.protocol == IRMP_SAMSUNG32_PROTOCOL || st->irmp_param.protocol == IRMP_SAMSUNG48_PROTOCOL) && (st->repetition_frame_number & 0x01))
                 {
 #ifdef ANALYZE
                     ANALYZE_PRINTF ("code skipped: SAMSUNG32/SAMSUNG48 auto repetition frame #%d, counter = %d, auto repetition len = %d\n",
-                                    repetition_frame_number + 1, key_repetition_len, AUTO_FRAME_REPETITION_LEN);
+                                    st->repetition_frame_number + 1, (int) st->key_repetition_len, (int) AUTO_FRAME_REPETITION_LEN);
 #endif // ANALYZE
-                    key_repetition_len = 0;
+                    st->key_repetition_len = 0;
                 }
                 else
 #endif
 
 #if IRMP_SUPPORT_NUBERT_PROTOCOL == 1
                 // if NUBERT protocol and the code will be repeated within 50 ms, we will ignore every 2nd frame
-                if (irmp_param.protocol == IRMP_NUBERT_PROTOCOL && (repetition_frame_number & 0x01))
+                if (st->irmp_param.protocol == IRMP_NUBERT_PROTOCOL && (st->repetition_frame_number & 0x01))
                 {
 #ifdef ANALYZE
                     ANALYZE_PRINTF ("code skipped: NUBERT auto repetition frame #%d, counter = %d, auto repetition len = %d\n",
-                                    repetition_frame_number + 1, key_repetition_len, AUTO_FRAME_REPETITION_LEN);
+                                    st->repetition_frame_number + 1, (int) st->key_repetition_len, (int) AUTO_FRAME_REPETITION_LEN);
 #endif // ANALYZE
-                    key_repetition_len = 0;
+                    st->key_repetition_len = 0;
                 }
                 else
 #endif
 
 #if IRMP_SUPPORT_SPEAKER_PROTOCOL == 1
                 // if SPEAKER protocol and the code will be repeated within 50 ms, we will ignore every 2nd frame
-                if (irmp_param.protocol == IRMP_SPEAKER_PROTOCOL && (repetition_frame_number & 0x01))
+                if (st->irmp_param.protocol == IRMP_SPEAKER_PROTOCOL && (st->repetition_frame_number & 0x01))
                 {
 #ifdef ANALYZE
                     ANALYZE_PRINTF ("code skipped: SPEAKER auto repetition frame #%d, counter = %d, auto repetition len = %d\n",
-                                    repetition_frame_number + 1, key_repetition_len, AUTO_FRAME_REPETITION_LEN);
+                                    st->repetition_frame_number + 1, (int) st->key_repetition_len, (int) AUTO_FRAME_REPETITION_LEN);
 #endif // ANALYZE
-                    key_repetition_len = 0;
+                    st->key_repetition_len = 0;
                 }
                 else
 #endif
 
                 {
 #ifdef ANALYZE
-                    ANALYZE_PRINTF ("%8.3fms code detected, length = %d\n", (double) (time_counter * 1000) / F_INTERRUPTS, irmp_bit);
+                    ANALYZE_PRINTF ("%8.3fms code detected, length = %d\n", (double) (st->time_counter * 1000) / F_INTERRUPTS, st->irmp_bit);
 #endif // ANALYZE
-                    irmp_ir_detected = TRUE;
+                    st->irmp_ir_detected = TRUE;
 
 #if IRMP_SUPPORT_DENON_PROTOCOL == 1
-                    if (irmp_param.protocol == IRMP_DENON_PROTOCOL)
+                    if (st->irmp_param.protocol == IRMP_DENON_PROTOCOL)
                     {                                                               // check for repetition frame
-                        if ((~irmp_tmp_command & 0x3FF) == last_irmp_denon_command) // command bits must be inverted
+                        if ((~st->irmp_tmp_command & 0x3FF) == st->last_irmp_denon_command) // command bits must be inverted
                         {
-                            irmp_tmp_command = last_irmp_denon_command;             // use command received before!
-                            last_irmp_denon_command = 0;
+                            st->irmp_tmp_command = st->last_irmp_denon_command;             // use command received before!
+                            st->last_irmp_denon_command = 0;
 
-                            irmp_protocol = irmp_param.protocol;                    // store protocol
-                            irmp_address = irmp_tmp_address;                        // store address
-                            irmp_command = irmp_tmp_command;                        // store command
+                            st->irmp_protocol = st->irmp_param.protocol;                    // store protocol
+                            st->irmp_address = st->irmp_tmp_address;                        // store address
+                            st->irmp_command = st->irmp_tmp_command;                        // store command
                         }
                         else
                         {
-                            if ((irmp_tmp_command & 0x01) == 0x00)
+                            if ((st->irmp_tmp_command & 0x01) == 0x00)
                             {
 #ifdef ANALYZE
-                                ANALYZE_PRINTF ("%8.3fms info Denon: waiting for inverted command repetition\n", (double) (time_counter * 1000) / F_INTERRUPTS);
+                                ANALYZE_PRINTF ("%8.3fms info Denon: waiting for inverted command repetition\n", (double) (st->time_counter * 1000) / F_INTERRUPTS);
 #endif // ANALYZE
-                                last_irmp_denon_command = irmp_tmp_command;
-                                denon_repetition_len = 0;
-                                irmp_ir_detected = FALSE;
+                                st->last_irmp_denon_command = st->irmp_tmp_command;
+                                st->denon_repetition_len = 0;
+                                st->irmp_ir_detected = FALSE;
                             }
                             else
                             {
 #ifdef ANALYZE
-                                ANALYZE_PRINTF ("%8.3fms warning Denon: got unexpected inverted command, ignoring it\n", (double) (time_counter * 1000) / F_INTERRUPTS);
+                                ANALYZE_PRINTF ("%8.3fms warning Denon: got unexpected inverted command, ignoring it\n", (double) (st->time_counter * 1000) / F_INTERRUPTS);
 #endif // ANALYZE
-                                last_irmp_denon_command = 0;
-                                irmp_ir_detected = FALSE;
+                                st->last_irmp_denon_command = 0;
+                                st->irmp_ir_detected = FALSE;
                             }
                         }
                     }
@@ -4689,554 +5353,1244 @@ irmp_ISR (void)
 #endif // IRMP_SUPPORT_DENON_PROTOCOL
 
 #if IRMP_SUPPORT_GRUNDIG_PROTOCOL == 1
-                    if (irmp_param.protocol == IRMP_GRUNDIG_PROTOCOL && irmp_tmp_command == 0x01ff)
+                    if (st->irmp_param.protocol == IRMP_GRUNDIG_PROTOCOL && st->irmp_tmp_command == 0x01ff)
                     {                                                               // Grundig start frame?
 #ifdef ANALYZE
                         ANALYZE_PRINTF ("Detected GRUNDIG start frame, ignoring it\n");
 #endif // ANALYZE
-                        irmp_ir_detected = FALSE;
+                        st->irmp_ir_detected = FALSE;
                     }
                     else
 #endif // IRMP_SUPPORT_GRUNDIG_PROTOCOL
 
 #if IRMP_SUPPORT_NOKIA_PROTOCOL == 1
-                    if (irmp_param.protocol == IRMP_NOKIA_PROTOCOL && irmp_tmp_address == 0x00ff && irmp_tmp_command == 0x00fe)
+                    if (st->irmp_param.protocol == IRMP_NOKIA_PROTOCOL && st->irmp_tmp_address == 0x00ff && st->irmp_tmp_command == 0x00fe)
                     {                                                               // Nokia start frame?
 #ifdef ANALYZE
                         ANALYZE_PRINTF ("Detected NOKIA start frame, ignoring it\n");
 #endif // ANALYZE
-                        irmp_ir_detected = FALSE;
+                        st->irmp_ir_detected = FALSE;
                     }
                     else
 #endif // IRMP_SUPPORT_NOKIA_PROTOCOL
                     {
 #if IRMP_SUPPORT_NEC_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_NEC_PROTOCOL && irmp_bit == 0)  // repetition frame
+                        if (st->irmp_param.protocol == IRMP_NEC_PROTOCOL && st->irmp_bit == 0)  // repetition frame
                         {
-                            if (key_repetition_len < NEC_FRAME_REPEAT_PAUSE_LEN_MAX)
+                            if (st->key_repetition_len < NEC_FRAME_REPEAT_PAUSE_LEN_MAX)
                             {
 #ifdef ANALYZE
-                                ANALYZE_PRINTF ("Detected NEC repetition frame, key_repetition_len = %d\n", key_repetition_len);
+                                ANALYZE_PRINTF ("Detected NEC repetition frame, key_repetition_len = %d\n", (int) st->key_repetition_len);
                                 ANALYZE_ONLY_NORMAL_PRINTF("REPETETION FRAME                ");
 #endif // ANALYZE
-                                irmp_tmp_address = last_irmp_address;                   // address is last address
-                                irmp_tmp_command = last_irmp_command;                   // command is last command
-                                irmp_flags |= IRMP_FLAG_REPETITION;
-                                key_repetition_len = 0;
+                                st->irmp_tmp_address = st->last_irmp_address;                   // address is last address
+                                st->irmp_tmp_command = st->last_irmp_command;                   // command is last command
+                                st->irmp_flags |= IRMP_FLAG_REPETITION;
+                                st->key_repetition_len = 0;
                             }
                             else
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("Detected NEC repetition frame, ignoring it: timeout occured, key_repetition_len = %d > %d\n",
-                                                key_repetition_len, NEC_FRAME_REPEAT_PAUSE_LEN_MAX);
+                                                (int) st->key_repetition_len, (int) NEC_FRAME_REPEAT_PAUSE_LEN_MAX);
 #endif // ANALYZE
-                                irmp_ir_detected = FALSE;
+                                st->irmp_ir_detected = FALSE;
                             }
                         }
 #endif // IRMP_SUPPORT_NEC_PROTOCOL
 
 #if IRMP_SUPPORT_KASEIKYO_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_KASEIKYO_PROTOCOL)
+                        if (st->irmp_param.protocol == IRMP_KASEIKYO_PROTOCOL)
                         {
                             uint_fast8_t xor_value;
 
-                            xor_value = (xor_check[0] & 0x0F) ^ ((xor_check[0] & 0xF0) >> 4) ^ (xor_check[1] & 0x0F) ^ ((xor_check[1] & 0xF0) >> 4);
+                            xor_value = (st->xor_check[0] & 0x0F) ^ ((st->xor_check[0] & 0xF0) >> 4) ^ (st->xor_check[1] & 0x0F) ^ ((st->xor_check[1] & 0xF0) >> 4);
 
-                            if (xor_value != (xor_check[2] & 0x0F))
+                            if (xor_value != (st->xor_check[2] & 0x0F))
                             {
 #ifdef ANALYZE
-                                ANALYZE_PRINTF ("error 4: wrong XOR check for customer id: 0x%1x 0x%1x\n", xor_value, xor_check[2] & 0x0F);
+                                ANALYZE_PRINTF ("error 4: wrong XOR check for customer id: 0x%1x 0x%1x\n", xor_value, st->xor_check[2] & 0x0F);
 #endif // ANALYZE
-                                irmp_ir_detected = FALSE;
+                                st->irmp_ir_detected = FALSE;
                             }
 
-                            xor_value = xor_check[2] ^ xor_check[3] ^ xor_check[4];
+                            xor_value = st->xor_check[2] ^ st->xor_check[3] ^ st->xor_check[4];
 
-                            if (xor_value != xor_check[5])
+                            if (xor_value != st->xor_check[5])
                             {
 #ifdef ANALYZE
-                                ANALYZE_PRINTF ("error 5: wrong XOR check for data bits: 0x%02x 0x%02x\n", xor_value, xor_check[5]);
+                                ANALYZE_PRINTF ("error 5: wrong XOR check for data bits: 0x%02x 0x%02x\n", xor_value, st->xor_check[5]);
 #endif // ANALYZE
-                                irmp_ir_detected = FALSE;
+                                st->irmp_ir_detected = FALSE;
                             }
 
-                            irmp_flags |= genre2;       // write the genre2 bits into MSB of the flag byte
+                            st->irmp_flags |= st->genre2;       // write the genre2 bits into MSB of the flag byte
                         }
 #endif // IRMP_SUPPORT_KASEIKYO_PROTOCOL == 1
 
 #if IRMP_SUPPORT_ORTEK_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_ORTEK_PROTOCOL)
+                        if (st->irmp_param.protocol == IRMP_ORTEK_PROTOCOL)
                         {
-                            if (parity == PARITY_CHECK_FAILED)
+                            if (st->parity == PARITY_CHECK_FAILED)
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("error 6: parity check failed\n");
 #endif // ANALYZE
-                                irmp_ir_detected = FALSE;
+                                st->irmp_ir_detected = FALSE;
                             }
 
-                            if ((irmp_tmp_address & 0x03) == 0x02)
+                            if ((st->irmp_tmp_address & 0x03) == 0x02)
                             {
 #ifdef ANALYZE
                                 ANALYZE_PRINTF ("code skipped: ORTEK end of transmission frame (key release)\n");
 #endif // ANALYZE
-                                irmp_ir_detected = FALSE;
+                                st->irmp_ir_detected = FALSE;
+                            }
+                            st->irmp_tmp_address >>= 2;
+                        }
+#endif // IRMP_SUPPORT_ORTEK_PROTOCOL == 1
+
+#if IRMP_SUPPORT_RC6_PROTOCOL == 1
+                        if (st->irmp_param.protocol == IRMP_RC6_PROTOCOL && st->irmp_param.complete_len == RC6_COMPLETE_DATA_LEN_LONG)     // RC6 mode = 6?
+                        {
+                            st->irmp_protocol = IRMP_RC6A_PROTOCOL;
+                        }
+                        else
+#endif // IRMP_SUPPORT_RC6_PROTOCOL == 1
+                        {
+                            st->irmp_protocol = st->irmp_param.protocol;
+                        }
+
+#if IRMP_SUPPORT_FDC_PROTOCOL == 1
+                        if (st->irmp_param.protocol == IRMP_FDC_PROTOCOL)
+                        {
+                            if (st->irmp_tmp_command & 0x000F)                          // released key?
+                            {
+                                st->irmp_tmp_command = (st->irmp_tmp_command >> 4) | 0x80;  // yes, set bit 7
                             }
-                            irmp_tmp_address >>= 2;
+                            else
+                            {
+                                st->irmp_tmp_command >>= 4;                             // no, it's a pressed key
+                            }
+                            st->irmp_tmp_command |= (st->irmp_tmp_address << 2) & 0x0F00;   // 000000CCCCAAAAAA -> 0000CCCC00000000
+                            st->irmp_tmp_address &= 0x003F;
+                        }
+#endif
+
+                        st->irmp_address = st->irmp_tmp_address;                            // store address
+#if IRMP_SUPPORT_NEC_PROTOCOL == 1
+                        if (st->irmp_param.protocol == IRMP_NEC_PROTOCOL)
+                        {
+                            st->last_irmp_address = st->irmp_tmp_address;                   // store as last address, too
+                        }
+#endif
+
+#if IRMP_SUPPORT_RC5_PROTOCOL == 1
+                        if (st->irmp_param.protocol == IRMP_RC5_PROTOCOL)
+                        {
+                            st->irmp_tmp_command |= st->rc5_cmd_bit6;                       // store bit 6
+                        }
+#endif
+#if IRMP_SUPPORT_S100_PROTOCOL == 1
+                        if (st->irmp_param.protocol == IRMP_S100_PROTOCOL)
+                        {
+                            st->irmp_tmp_command |= st->rc5_cmd_bit6;                       // store bit 6
+                        }
+#endif
+                        st->irmp_command = st->irmp_tmp_command;                            // store command
+
+#if IRMP_SUPPORT_SAMSUNG_PROTOCOL == 1
+                        st->irmp_id = st->irmp_tmp_id;
+#endif
+                    }
+                }
+
+                if (st->irmp_ir_detected)
+                {
+                    if (st->last_irmp_command == st->irmp_tmp_command &&
+                        st->last_irmp_address == st->irmp_tmp_address &&
+                        st->key_repetition_len < IRMP_KEY_REPETITION_LEN)
+                    {
+                        st->irmp_flags |= IRMP_FLAG_REPETITION;
+                    }
+
+                    st->last_irmp_address = st->irmp_tmp_address;                           // store as last address, too
+                    st->last_irmp_command = st->irmp_tmp_command;                           // store as last command, too
+
+                    st->key_repetition_len = 0;
+                }
+                else
+                {
+#ifdef ANALYZE
+                    ANALYZE_ONLY_NORMAL_PUTCHAR ('\n');
+#endif // ANALYZE
+                }
+
+                st->irmp_start_bit_detected = 0;                                        // and wait for next start bit
+                st->irmp_tmp_command        = 0;
+                st->irmp_pulse_time         = 0;
+                st->irmp_pause_time         = 0;
+
+#if IRMP_SUPPORT_JVC_PROTOCOL == 1
+                if (st->irmp_protocol == IRMP_JVC_PROTOCOL)                             // the stop bit of JVC frame is also start bit of next frame
+                {                                                                   // set pulse time here!
+                    st->irmp_pulse_time = ((uint_fast8_t)(F_INTERRUPTS * JVC_START_BIT_PULSE_TIME));
+                }
+#endif // IRMP_SUPPORT_JVC_PROTOCOL == 1
+            }
+        }
+    }
+
+    return (st->irmp_ir_detected);
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  ISR routine
+ *  @details  ISR routine, called 10000 times per second, reads the input pin and runs the default instance
+ *  @return   TRUE: frame available for irmp_get_data(), FALSE: no frame available
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+irmp_ISR (void)
+{
+    uint_fast8_t            irmp_input;                                             // input value
+
+#if defined(__SDCC_stm8)
+    irmp_input = input(IRMP_GPIO_STRUCT->IDR)
+#elif defined(__MBED__)
+    //irmp_input = inputPin;
+    irmp_input = gpio_read (&gpioIRin);
+#else
+    irmp_input = input(IRMP_PIN);
+#endif
+
+#if defined(STELLARIS_ARM_CORTEX_M4)
+    // Clear the timer interrupt
+    TimerIntClear(TIMER1_BASE, TIMER_TIMA_TIMEOUT);
+#endif
+
+    return irmp_ISR_input (irmp_input);
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  ISR routine with given input
+ *  @details  like irmp_ISR(), but runs the default instance with an input value read (or masked) by the caller
+ *  @param    input value (0: pulse, else pause)
+ *  @return   TRUE: frame available for irmp_get_data(), FALSE: no frame available
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+irmp_ISR_input (uint_fast8_t irmp_input)
+{
+#if IRMP_USE_FRAME_QUEUE == 1
+    if (irmp_ISR_ex (&irmp_default_state, irmp_input))
+    {
+        irmp_queue_put (&irmp_default_state);
+    }
+#else
+    (void) irmp_ISR_ex (&irmp_default_state, irmp_input);
+#endif
+
+#if IRMP_USE_FRAME_QUEUE == 1
+    return (irmp_queue_head != irmp_queue_tail);
+#else
+    return (irmp_default_state.irmp_ir_detected);
+#endif
+}
+
+#if IRMP_USE_EDGE_CAPTURE == 1 || defined(ANALYZE)
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Skip idle ticks
+ *  @details  does the same as calling irmp_ISR_ex() n times while no start bit has been seen and the input is dark
+ *  @param    pointer to decoder state, number of ticks
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+irmp_skip_idle (irmp_state_t * st, uint_fast16_t ticks)
+{
+    uint_fast16_t   n;
+
+    if (st->key_repetition_len < 0xFFFF)                                                // avoid overflow of counter
+    {
+        n = 0xFFFF - st->key_repetition_len;
+
+        if (n > ticks)
+        {
+            n = ticks;
+        }
+
+        st->key_repetition_len += n;
+
+#if IRMP_SUPPORT_DENON_PROTOCOL == 1
+        if (st->denon_repetition_len < 0xFFFF)                                          // avoid overflow of counter
+        {
+            if (st->last_irmp_denon_command != 0 && st->denon_repetition_len + n >= DENON_AUTO_REPETITION_PAUSE_LEN)
+            {
+#ifdef ANALYZE
+                ANALYZE_PRINTF ("%8.3fms warning: did not receive inverted command repetition\n",
+                                (double) ((st->time_counter + DENON_AUTO_REPETITION_PAUSE_LEN - st->denon_repetition_len) * 1000) / F_INTERRUPTS);
+#endif // ANALYZE
+                st->last_irmp_denon_command = 0;
+                st->denon_repetition_len = 0xFFFF;
+            }
+            else if (st->denon_repetition_len + n < 0xFFFF)
+            {
+                st->denon_repetition_len += n;
+            }
+            else
+            {
+                st->denon_repetition_len = 0xFFFF;
+            }
+        }
+#endif // IRMP_SUPPORT_DENON_PROTOCOL == 1
+    }
+
+#ifdef ANALYZE
+    st->time_counter += ticks;
+#endif // ANALYZE
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Duration driven decoder
+ *  @details  feeds a pulse or pause of the given length into the decoder, gives the same results as calling irmp_ISR() once per tick.
+ *            Idle time is skipped at once, so the work depends on the number of edges and not on the length of the signal.
+ *            Stops as soon as a frame has been detected, call irmp_get_data_ex() and pass the remaining ticks again.
+ *  @param    pointer to decoder state, input value (0: pulse, else pause), number of ticks
+ *  @return   number of ticks consumed
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+irmp_ISR_duration_ex (irmp_state_t * st, uint_fast8_t irmp_input, uint_fast16_t ticks)
+{
+    uint_fast16_t   n = 0;
+
+    while (n < ticks && ! st->irmp_ir_detected)
+    {
+        (void) irmp_ISR_ex (st, irmp_input);                                        // first tick also reports the edge to the callback
+        n++;
+
+        if (irmp_input && ! st->irmp_start_bit_detected && ! st->irmp_pulse_time && ! st->irmp_ir_detected && n < ticks)
+        {
+            irmp_skip_idle (st, ticks - n);
+            n = ticks;
+        }
+    }
+
+    return n;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Duration driven decoder
+ *  @details  same as irmp_ISR_duration_ex() for the default instance. With IRMP_USE_FRAME_QUEUE, a detected frame is queued
+ *            at once, the remaining ticks can be passed again without calling irmp_get_data() first.
+ *  @param    input value (0: pulse, else pause), number of ticks
+ *  @return   number of ticks consumed
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+irmp_ISR_duration (uint_fast8_t irmp_input, uint_fast16_t ticks)
+{
+#if IRMP_USE_FRAME_QUEUE == 1
+    uint_fast16_t   n;
+
+    n = irmp_ISR_duration_ex (&irmp_default_state, irmp_input, ticks);
+
+    if (irmp_default_state.irmp_ir_detected)
+    {
+        irmp_queue_put (&irmp_default_state);
+    }
+
+    return n;
+#else
+    return irmp_ISR_duration_ex (&irmp_default_state, irmp_input, ticks);
+#endif
+}
+#endif // IRMP_USE_EDGE_CAPTURE == 1 || defined(ANALYZE)
+
+#if IRMP_USE_EDGE_CAPTURE == 1
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Edge buffer
+ *  @details  written by the capture ISR, read by irmp_get_data() for the default instance. Bit 15 of an entry holds the input value,
+ *            bits 0-14 the length in ticks.
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#define IRMP_EDGE_LEVEL                         0x8000
+#define IRMP_EDGE_TICKS_MAX                     0x7FFF
+
+static volatile uint16_t                        irmp_edge_buf[IRMP_EDGE_BUFFER_SIZE];
+static volatile uint_fast8_t                    irmp_edge_head;             // written by ISR only
+static volatile uint_fast8_t                    irmp_edge_tail;             // written by irmp_get_data() only
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Store duration of a pulse or pause
+ *  @details  called by the edge capture ISR with the length of the level that just ended. Durations are lost if the buffer is full.
+ *  @param    input value (0: pulse, else pause), number of ticks
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+irmp_edge_put (uint_fast8_t irmp_input, uint_fast16_t ticks)
+{
+    uint_fast16_t   n;
+    uint_fast8_t    next;
+
+    while (ticks)
+    {
+        n    = (ticks > IRMP_EDGE_TICKS_MAX) ? IRMP_EDGE_TICKS_MAX : ticks;
+        next = (irmp_edge_head + 1) % IRMP_EDGE_BUFFER_SIZE;
+
+        if (next == irmp_edge_tail)                                                 // buffer full?
+        {
+            break;
+        }
+
+        irmp_edge_buf[irmp_edge_head] = (irmp_input ? IRMP_EDGE_LEVEL : 0) | n;
+        irmp_edge_head = next;
+        ticks -= n;
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Decode stored durations
+ *  @details  runs the decoder over the edge buffer until it is empty or a frame has been detected
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+irmp_edge_process (void)
+{
+    irmp_state_t *  st = &irmp_default_state;
+    uint_fast16_t   entry;
+    uint_fast16_t   ticks;
+
+    while (! st->irmp_ir_detected && irmp_edge_tail != irmp_edge_head)
+    {
+        entry = irmp_edge_buf[irmp_edge_tail];
+        ticks = entry & IRMP_EDGE_TICKS_MAX;
+        ticks -= irmp_ISR_duration ((entry & IRMP_EDGE_LEVEL) ? 1 : 0, ticks);
+
+        if (ticks)                                                                  // frame detected, keep the rest for the next call
+        {
+            irmp_edge_buf[irmp_edge_tail] = (entry & IRMP_EDGE_LEVEL) | ticks;
+        }
+        else
+        {
+            irmp_edge_tail = (irmp_edge_tail + 1) % IRMP_EDGE_BUFFER_SIZE;
+        }
+    }
+}
+#endif // IRMP_USE_EDGE_CAPTURE == 1
+
+#ifdef ANALYZE
+
+#include <time.h>
+
+#ifdef unix
+#include <pthread.h>
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * main functions - for Unix/Linux + Windows only!
+ *
+ * AVR: see main.c!
+ *
+ * Compile it under linux with:
+ * cc irmp.c -o irmp -lpthread
+ *
+ * usage: ./irmp [-v|-s|-a|-l|-r] [-e] [-m mask] < file
+ *        ./irmp -d directory [-j threads] [-m mask]
+ *
+ * options:
+ *   -v verbose
+ *   -s silent
+ *   -a analyze
+ *   -l list pulse/pauses
+ *   -r radio
+ *   -e decode pulse/pause durations with irmp_ISR_duration() instead of calling irmp_ISR() per tick
+ *   -d decode all scan files of a directory, print a summary per file and the throughput (unix only)
+ *   -j number of decoder threads for -d, default is one per CPU
+ *   -c convert scan file to packed capture (1 bit per tick) on stdout, comments are dropped
+ *   -b decode packed capture
+ *   -t print decoding time and ticks/s to stderr
+ *   -m decode only the protocols of the mask (bit n: protocol n), e.g. -m 0x6 for NEC and SAMSUNG
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+
+void
+print_spectrum (char * text, int * buf, int is_pulse)
+{
+    int     i;
+    int     j;
+    int     min;
+    int     max;
+    int     max_value = 0;
+    int     value;
+    int     sum = 0;
+    int     counter = 0;
+    double  average = 0;
+    double  tolerance;
+
+    puts ("-----------------------------------------------------------------------------");
+    printf ("%s:\n", text);
+
+    for (i = 0; i < 256; i++)
+    {
+        if (buf[i] > max_value)
+        {
+            max_value = buf[i];
+        }
+    }
+
+    for (i = 1; i < 200; i++)
+    {
+        if (buf[i] > 0)
+        {
+            printf ("%3d ", i);
+            value = (buf[i] * 60) / max_value;
+
+            for (j = 0; j < value; j++)
+            {
+                putchar ('o');
+            }
+            printf (" %d\n", buf[i]);
+
+            sum += i * buf[i];
+            counter += buf[i];
+        }
+        else
+        {
+            max = i - 1;
+
+            if (counter > 0)
+            {
+                average = (float) sum / (float) counter;
+
+                if (is_pulse)
+                {
+                    printf ("pulse ");
+                }
+                else
+                {
+                    printf ("pause ");
+                }
+
+                printf ("avg: %4.1f=%6.1f us, ", average, (1000000. * average) / (float) F_INTERRUPTS);
+                printf ("min: %2d=%6.1f us, ", min, (1000000. * min) / (float) F_INTERRUPTS);
+                printf ("max: %2d=%6.1f us, ", max, (1000000. * max) / (float) F_INTERRUPTS);
+
+                tolerance = (max - average);
+
+                if (average - min > tolerance)
+                {
+                    tolerance = average - min;
+                }
+
+                tolerance = tolerance * 100 / average;
+                printf ("tol: %4.1f%%\n", tolerance);
+            }
+
+            counter = 0;
+            sum = 0;
+            min = i + 1;
+        }
+    }
+}
+
+#define STATE_LEFT_SHIFT    0x01
+#define STATE_RIGHT_SHIFT   0x02
+#define STATE_LEFT_CTRL     0x04
+#define STATE_LEFT_ALT      0x08
+#define STATE_RIGHT_ALT     0x10
+
+#define KEY_ESCAPE          0x1B            // keycode = 0x006e
+#define KEY_MENUE           0x80            // keycode = 0x0070
+#define KEY_BACK            0x81            // keycode = 0x0071
+#define KEY_FORWARD         0x82            // keycode = 0x0072
+#define KEY_ADDRESS         0x83            // keycode = 0x0073
+#define KEY_WINDOW          0x84            // keycode = 0x0074
+#define KEY_1ST_PAGE        0x85            // keycode = 0x0075
+#define KEY_STOP            0x86            // keycode = 0x0076
+#define KEY_MAIL            0x87            // keycode = 0x0077
+#define KEY_FAVORITES       0x88            // keycode = 0x0078
+#define KEY_NEW_PAGE        0x89            // keycode = 0x0079
+#define KEY_SETUP           0x8A            // keycode = 0x007a
+#define KEY_FONT            0x8B            // keycode = 0x007b
+#define KEY_PRINT           0x8C            // keycode = 0x007c
+#define KEY_ON_OFF          0x8E            // keycode = 0x007c
+
+#define KEY_INSERT          0x90            // keycode = 0x004b
+#define KEY_DELETE          0x91            // keycode = 0x004c
+#define KEY_LEFT            0x92            // keycode = 0x004f
+#define KEY_HOME            0x93            // keycode = 0x0050
+#define KEY_END             0x94            // keycode = 0x0051
+#define KEY_UP              0x95            // keycode = 0x0053
+#define KEY_DOWN            0x96            // keycode = 0x0054
+#define KEY_PAGE_UP         0x97            // keycode = 0x0055
+#define KEY_PAGE_DOWN       0x98            // keycode = 0x0056
+#define KEY_RIGHT           0x99            // keycode = 0x0059
+#define KEY_MOUSE_1         0x9E            // keycode = 0x0400
+#define KEY_MOUSE_2         0x9F            // keycode = 0x0800
+
+static uint_fast8_t
+get_fdc_key (uint_fast16_t cmd)
+{
+    static uint8_t key_table[128] =
+    {
+     // 0       1       2       3       4       5       6       7       8       9       A       B       C       D       E       F
+         0,     '^',    '1',    '2',    '3',    '4',    '5',    '6',    '7',    '8',    '9',    '0',    0xDF,   '',    0,      '\b',
+        '\t',   'q',    'w',    'e',    'r',    't',    'z',    'u',    'i',    'o',    'p',    0xFC,   '+',    0,      0,      'a',
+        's',    'd',    'f',    'g',    'h',    'j',    'k',    'l',    0xF6,   0xE4,   '#',    '\r',   0,      '<',    'y',    'x',
+        'c',    'v',    'b',    'n',    'm',    ',',    '.',    '-',    0,      0,      0,      0,      0,      ' ',    0,      0,
+
+         0,     '',    '!',    '"',    '',    '$',    '%',    '&',    '/',    '(',    ')',    '=',    '?',    '`',    0,      '\b',
+        '\t',   'Q',    'W',    'E',    'R',    'T',    'Z',    'U',    'I',    'O',    'P',    0xDC,   '*',    0,      0,      'A',
+        'S',    'D',    'F',    'G',    'H',    'J',    'K',    'L',    0xD6,   0xC4,   '\'',   '\r',   0,      '>',    'Y',    'X',
+        'C',    'V',    'B',    'N',    'M',    ';',    ':',    '_',    0,      0,      0,      0,      0,      ' ',    0,      0
+    };
+    static uint_fast8_t state;
+
+    uint_fast8_t key = 0;
+
+    switch (cmd)
+    {
+        case 0x002C: state |=  STATE_LEFT_SHIFT;    break;              // pressed left shift
+        case 0x00AC: state &= ~STATE_LEFT_SHIFT;    break;              // released left shift
+        case 0x0039: state |=  STATE_RIGHT_SHIFT;   break;              // pressed right shift
+        case 0x00B9: state &= ~STATE_RIGHT_SHIFT;   break;              // released right shift
+        case 0x003A: state |=  STATE_LEFT_CTRL;     break;              // pressed left ctrl
+        case 0x00BA: state &= ~STATE_LEFT_CTRL;     break;              // released left ctrl
+        case 0x003C: state |=  STATE_LEFT_ALT;      break;              // pressed left alt
+        case 0x00BC: state &= ~STATE_LEFT_ALT;      break;              // released left alt
+        case 0x003E: state |=  STATE_RIGHT_ALT;     break;              // pressed left alt
+        case 0x00BE: state &= ~STATE_RIGHT_ALT;     break;              // released left alt
+
+        case 0x006e: key = KEY_ESCAPE;              break;
+        case 0x004b: key = KEY_INSERT;              break;
+        case 0x004c: key = KEY_DELETE;              break;
+        case 0x004f: key = KEY_LEFT;                break;
+        case 0x0050: key = KEY_HOME;                break;
+        case 0x0051: key = KEY_END;                 break;
+        case 0x0053: key = KEY_UP;                  break;
+        case 0x0054: key = KEY_DOWN;                break;
+        case 0x0055: key = KEY_PAGE_UP;             break;
+        case 0x0056: key = KEY_PAGE_DOWN;           break;
+        case 0x0059: key = KEY_RIGHT;               break;
+        case 0x0400: key = KEY_MOUSE_1;             break;
+        case 0x0800: key = KEY_MOUSE_2;             break;
+
+        default:
+        {
+            if (!(cmd & 0x80))                      // pressed key
+            {
+                if (cmd >= 0x70 && cmd <= 0x7F)     // function keys
+                {
+                    key = cmd + 0x10;               // 7x -> 8x
+                }
+                else if (cmd < 64)                  // key listed in key_table
+                {
+                    if (state & (STATE_LEFT_ALT | STATE_RIGHT_ALT))
+                    {
+                        switch (cmd)
+                        {
+                            case 0x0003: key = '';     break;
+                            case 0x0008: key = '{';     break;
+                            case 0x0009: key = '[';     break;
+                            case 0x000A: key = ']';     break;
+                            case 0x000B: key = '}';     break;
+                            case 0x000C: key = '\\';    break;
+                            case 0x001C: key = '~';     break;
+                            case 0x002D: key = '|';     break;
+                            case 0x0034: key = 0xB5;    break; // Mu
                         }
-#endif // IRMP_SUPPORT_ORTEK_PROTOCOL == 1
-
-#if IRMP_SUPPORT_RC6_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_RC6_PROTOCOL && irmp_param.complete_len == RC6_COMPLETE_DATA_LEN_LONG)     // RC6 mode = 6?
+                    }
+                    else if (state & (STATE_LEFT_CTRL))
+                    {
+                        if (key_table[cmd] >= 'a' && key_table[cmd] <= 'z')
                         {
-                            irmp_protocol = IRMP_RC6A_PROTOCOL;
+                            key = key_table[cmd] - 'a' + 1;
                         }
                         else
-#endif // IRMP_SUPPORT_RC6_PROTOCOL == 1
                         {
-                            irmp_protocol = irmp_param.protocol;
+                            key = key_table[cmd];
                         }
+                    }
+                    else
+                    {
+                        int idx = cmd + ((state & (STATE_LEFT_SHIFT | STATE_RIGHT_SHIFT)) ? 64 : 0);
 
-#if IRMP_SUPPORT_FDC_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_FDC_PROTOCOL)
+                        if (key_table[idx])
                         {
-                            if (irmp_tmp_command & 0x000F)                          // released key?
-                            {
-                                irmp_tmp_command = (irmp_tmp_command >> 4) | 0x80;  // yes, set bit 7
-                            }
-                            else
-                            {
-                                irmp_tmp_command >>= 4;                             // no, it's a pressed key
-                            }
-                            irmp_tmp_command |= (irmp_tmp_address << 2) & 0x0F00;   // 000000CCCCAAAAAA -> 0000CCCC00000000
-                            irmp_tmp_address &= 0x003F;
+                            key = key_table[idx];
                         }
-#endif
+                    }
+                }
+            }
+            break;
+        }
+    }
 
-                        irmp_address = irmp_tmp_address;                            // store address
-#if IRMP_SUPPORT_NEC_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_NEC_PROTOCOL)
-                        {
-                            last_irmp_address = irmp_tmp_address;                   // store as last address, too
-                        }
-#endif
+    return (key);
+}
 
-#if IRMP_SUPPORT_RC5_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_RC5_PROTOCOL)
-                        {
-                            irmp_tmp_command |= rc5_cmd_bit6;                       // store bit 6
-                        }
-#endif
-#if IRMP_SUPPORT_S100_PROTOCOL == 1
-                        if (irmp_param.protocol == IRMP_S100_PROTOCOL)
-                        {
-                            irmp_tmp_command |= rc5_cmd_bit6;                       // store bit 6
-                        }
-#endif
-                        irmp_command = irmp_tmp_command;                            // store command
+static int         analyze = FALSE;
+static int         list = FALSE;
+static IRMP_DATA   irmp_data;
+static int         expected_protocol;
+static int         expected_address;
+static int         expected_command;
+static int         do_check_expected_values;
+static int         edge = FALSE;
+static uint_fast8_t edge_pin = 0xFF;
+static long        edge_ticks;
+static int         pack = FALSE;
+static int         timing = FALSE;
+static long long   n_ticks;
 
-#if IRMP_SUPPORT_SAMSUNG_PROTOCOL == 1
-                        irmp_id = irmp_tmp_id;
-#endif
-                    }
-                }
+static void
+print_data (void)
+{
+    while (irmp_get_data (&irmp_data))
+    {
+        uint_fast8_t key;
 
-                if (irmp_ir_detected)
-                {
-                    if (last_irmp_command == irmp_tmp_command &&
-                        last_irmp_address == irmp_tmp_address &&
-                        key_repetition_len < IRMP_KEY_REPETITION_LEN)
-                    {
-                        irmp_flags |= IRMP_FLAG_REPETITION;
-                    }
+        ANALYZE_ONLY_NORMAL_PUTCHAR (' ');
 
-                    last_irmp_address = irmp_tmp_address;                           // store as last address, too
-                    last_irmp_command = irmp_tmp_command;                           // store as last command, too
+        if (verbose)
+        {
+            printf ("%8.3fms ", (double) (irmp_default_state.time_counter * 1000) / F_INTERRUPTS);
+        }
 
-                    key_repetition_len = 0;
-                }
-                else
+        if (irmp_data.protocol == IRMP_ACP24_PROTOCOL)
+        {
+            uint16_t    temp = (irmp_data.command & 0x000F) + 15;
+
+            printf ("p=%2d (%s), a=0x%04x, c=0x%04x, f=0x%02x, temp=%d",
+                    irmp_data.protocol, irmp_protocol_names[irmp_data.protocol], irmp_data.address, irmp_data.command, irmp_data.flags, temp);
+        }
+        else if (irmp_data.protocol == IRMP_FDC_PROTOCOL && (key = get_fdc_key (irmp_data.command)) != 0)
+        {
+            if ((key >= 0x20 && key < 0x7F) || key >= 0xA0)
+            {
+                printf ("p=%2d (%s), a=0x%04x, c=0x%04x, f=0x%02x, asc=0x%02x, key='%c'",
+                        irmp_data.protocol,  irmp_protocol_names[irmp_data.protocol], irmp_data.address, irmp_data.command, irmp_data.flags, key, key);
+            }
+            else if (key == '\r' || key == '\t' || key == KEY_ESCAPE || (key >= 0x80 && key <= 0x9F))                 // function keys
+            {
+                char * p = (char *) NULL;
+
+                switch (key)
                 {
-#ifdef ANALYZE
-                    ANALYZE_ONLY_NORMAL_PUTCHAR ('\n');
-#endif // ANALYZE
+                    case '\t'                : p = "TAB";           break;
+                    case '\r'                : p = "CR";            break;
+                    case KEY_ESCAPE          : p = "ESCAPE";        break;
+                    case KEY_MENUE           : p = "MENUE";         break;
+                    case KEY_BACK            : p = "BACK";          break;
+                    case KEY_FORWARD         : p = "FORWARD";       break;
+                    case KEY_ADDRESS         : p = "ADDRESS";       break;
+                    case KEY_WINDOW          : p = "WINDOW";        break;
+                    case KEY_1ST_PAGE        : p = "1ST_PAGE";      break;
+                    case KEY_STOP            : p = "STOP";          break;
+                    case KEY_MAIL            : p = "MAIL";          break;
+                    case KEY_FAVORITES       : p = "FAVORITES";     break;
+                    case KEY_NEW_PAGE        : p = "NEW_PAGE";      break;
+                    case KEY_SETUP           : p = "SETUP";         break;
+                    case KEY_FONT            : p = "FONT";          break;
+                    case KEY_PRINT           : p = "PRINT";         break;
+                    case KEY_ON_OFF          : p = "ON_OFF";        break;
+
+                    case KEY_INSERT          : p = "INSERT";        break;
+                    case KEY_DELETE          : p = "DELETE";        break;
+                    case KEY_LEFT            : p = "LEFT";          break;
+                    case KEY_HOME            : p = "HOME";          break;
+                    case KEY_END             : p = "END";           break;
+                    case KEY_UP              : p = "UP";            break;
+                    case KEY_DOWN            : p = "DOWN";          break;
+                    case KEY_PAGE_UP         : p = "PAGE_UP";       break;
+                    case KEY_PAGE_DOWN       : p = "PAGE_DOWN";     break;
+                    case KEY_RIGHT           : p = "RIGHT";         break;
+                    case KEY_MOUSE_1         : p = "KEY_MOUSE_1";   break;
+                    case KEY_MOUSE_2         : p = "KEY_MOUSE_2";   break;
+                    default                  : p = "<UNKNWON>";     break;
                 }
 
-                irmp_start_bit_detected = 0;                                        // and wait for next start bit
-                irmp_tmp_command        = 0;
-                irmp_pulse_time         = 0;
-                irmp_pause_time         = 0;
+                printf ("p=%2d (%s), a=0x%04x, c=0x%04x, f=0x%02x, asc=0x%02x, key=%s",
+                        irmp_data.protocol, irmp_protocol_names[irmp_data.protocol], irmp_data.address, irmp_data.command, irmp_data.flags, key, p);
+            }
+            else
+            {
+                printf ("p=%2d (%s), a=0x%04x, c=0x%04x, f=0x%02x, asc=0x%02x",
+                        irmp_data.protocol,  irmp_protocol_names[irmp_data.protocol], irmp_data.address, irmp_data.command, irmp_data.flags, key);
+            }
+        }
+        else
+        {
+            printf ("p=%2d (%s), a=0x%04x, c=0x%04x, f=0x%02x",
+                    irmp_data.protocol, irmp_protocol_names[irmp_data.protocol], irmp_data.address, irmp_data.command, irmp_data.flags);
+        }
 
-#if IRMP_SUPPORT_JVC_PROTOCOL == 1
-                if (irmp_protocol == IRMP_JVC_PROTOCOL)                             // the stop bit of JVC frame is also start bit of next frame
-                {                                                                   // set pulse time here!
-                    irmp_pulse_time = ((uint_fast8_t)(F_INTERRUPTS * JVC_START_BIT_PULSE_TIME));
-                }
-#endif // IRMP_SUPPORT_JVC_PROTOCOL == 1
+        if (do_check_expected_values)
+        {
+            if (irmp_data.protocol != expected_protocol ||
+                irmp_data.address  != expected_address  ||
+                irmp_data.command  != expected_command)
+            {
+                printf ("\nerror 7: expected values differ: p=%2d (%s), a=0x%04x, c=0x%04x\n",
+                        expected_protocol, irmp_protocol_names[expected_protocol], expected_address, expected_command);
+            }
+            else
+            {
+                printf (" checked!\n");
             }
+            do_check_expected_values = FALSE;                           // only check 1st frame in a line!
+        }
+        else
+        {
+            putchar ('\n');
         }
     }
+}
 
-#if defined(STELLARIS_ARM_CORTEX_M4)
-    // Clear the timer interrupt
-    TimerIntClear(TIMER1_BASE, TIMER_TIMA_TIMEOUT);
+static void
+flush_edge (void)
+{
+    uint_fast16_t   n;
+
+    while (edge_ticks > 0)
+    {
+        n = (edge_ticks > 0xFFFF) ? 0xFFFF : edge_ticks;
+        edge_ticks -= irmp_ISR_duration (edge_pin, n);
+        print_data ();
+    }
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * packed capture: 1 bit per tick, MSB of 1st byte is 1st tick, 1 = pause, 0 = pulse. The 16 bytes header holds a magic and F_INTERRUPTS.
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#define PACK_MAGIC          "IRMPPACK"
+#define PACK_HEADER_LEN     16
+#define PACK_BUF_LEN        65536                                           // read buffer, multiple of 8
+
+#if defined(__GNUC__)
+#  define clz64(x)          __builtin_clzll (x)
+#else
+static int
+clz64 (unsigned long long x)
+{
+    int n = 0;
+
+    while (! (x & 0x8000000000000000ULL))
+    {
+        x <<= 1;
+        n++;
+    }
+    return n;
+}
 #endif
 
-    return (irmp_ir_detected);
+static unsigned char    pack_byte;
+static int              pack_bits;
+
+static void
+pack_tick (uint_fast8_t pin)
+{
+    pack_byte = (pack_byte << 1) | (pin ? 1 : 0);
+
+    if (++pack_bits == 8)
+    {
+        putchar (pack_byte);
+        pack_bits = 0;
+    }
 }
 
-#ifdef ANALYZE
+static void
+pack_header (void)
+{
+    unsigned long   f = F_INTERRUPTS;
+    int             i;
+
+    fwrite (PACK_MAGIC, 1, 8, stdout);
+
+    for (i = 0; i < 8; i++)                                                 // F_INTERRUPTS as 32 bit little endian, 4 bytes reserved
+    {
+        putchar (i < 4 ? (f >> (8 * i)) & 0xFF : 0);
+    }
+}
+
+static void
+pack_finish (void)
+{
+    while (pack_bits)                                                       // fill last byte with pause
+    {
+        pack_tick (0xFF);
+    }
+}
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
- * main functions - for Unix/Linux + Windows only!
- *
- * AVR: see main.c!
- *
- * Compile it under linux with:
- * cc irmp.c -o irmp
- *
- * usage: ./irmp [-v|-s|-a|-l] < file
- *
- * options:
- *   -v verbose
- *   -s silent
- *   -a analyze
- *   -l list pulse/pauses
+ * decode packed capture: runs are taken out of 64 bit words with count-leading-zeros and passed to irmp_ISR_duration() as a whole
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
-
-void
-print_spectrum (char * text, int * buf, int is_pulse)
+static int
+unpack_decode (FILE * fp)
 {
-    int     i;
-    int     j;
-    int     min;
-    int     max;
-    int     max_value = 0;
-    int     value;
-    int     sum = 0;
-    int     counter = 0;
-    double  average = 0;
-    double  tolerance;
+    static unsigned char    buf[PACK_BUF_LEN];
+    unsigned long long      w;
+    unsigned long long      x;
+    size_t                  len;
+    size_t                  i;
+    int                     j;
+    int                     bits;
+    int                     run;
+    unsigned long           f;
+
+    if (fread (buf, 1, PACK_HEADER_LEN, fp) != PACK_HEADER_LEN || memcmp (buf, PACK_MAGIC, 8) != 0)
+    {
+        fprintf (stderr, "no packed capture\n");
+        return 1;
+    }
 
-    puts ("-----------------------------------------------------------------------------");
-    printf ("%s:\n", text);
+    f = buf[8] | (buf[9] << 8) | ((unsigned long) buf[10] << 16) | ((unsigned long) buf[11] << 24);
 
-    for (i = 0; i < 256; i++)
+    if (f != F_INTERRUPTS)
     {
-        if (buf[i] > max_value)
-        {
-            max_value = buf[i];
-        }
+        fprintf (stderr, "capture has %lu ticks/s, decoder is compiled for %d\n", f, F_INTERRUPTS);
+        return 1;
     }
 
-    for (i = 1; i < 200; i++)
+    edge_pin = 0xFF;
+    edge_ticks = 0;
+
+    while ((len = fread (buf, 1, PACK_BUF_LEN, fp)) > 0)
     {
-        if (buf[i] > 0)
+        for (i = 0; i < len; i += 8)
         {
-            printf ("%3d ", i);
-            value = (buf[i] * 60) / max_value;
+            w = 0;
+            bits = 0;
 
-            for (j = 0; j < value; j++)
+            for (j = 0; j < 8 && i + j < len; j++)                          // big endian: 1st tick is MSB
             {
-                putchar ('o');
+                w |= (unsigned long long) buf[i + j] << (56 - 8 * j);
+                bits += 8;
             }
-            printf (" %d\n", buf[i]);
 
-            sum += i * buf[i];
-            counter += buf[i];
-        }
-        else
-        {
-            max = i - 1;
+            n_ticks += bits;
 
-            if (counter > 0)
+            while (bits > 0)
             {
-                average = (float) sum / (float) counter;
+                x = edge_pin ? ~w : w;                                      // leading zeros = ticks with unchanged input
+                run = x ? clz64 (x) : 64;
 
-                if (is_pulse)
-                {
-                    printf ("pulse ");
-                }
-                else
+                if (run >= bits)
                 {
-                    printf ("pause ");
+                    edge_ticks += bits;
+                    break;
                 }
 
-                printf ("avg: %4.1f=%6.1f us, ", average, (1000000. * average) / (float) F_INTERRUPTS);
-                printf ("min: %2d=%6.1f us, ", min, (1000000. * min) / (float) F_INTERRUPTS);
-                printf ("max: %2d=%6.1f us, ", max, (1000000. * max) / (float) F_INTERRUPTS);
+                edge_ticks += run;
+                flush_edge ();
+                edge_pin = ~edge_pin & 0xFF;
+                w <<= run;
+                bits -= run;
+            }
+        }
+    }
 
-                tolerance = (max - average);
+    flush_edge ();
+    return 0;
+}
 
-                if (average - min > tolerance)
-                {
-                    tolerance = average - min;
-                }
+static void
+next_tick (void)
+{
+    n_ticks++;
 
-                tolerance = tolerance * 100 / average;
-                printf ("tol: %4.1f%%\n", tolerance);
+    if (pack)
+    {
+        pack_tick (IRMP_PIN);
+    }
+    else if (! analyze && ! list)
+    {
+        if (edge)
+        {
+            if (edge_pin != IRMP_PIN)
+            {
+                flush_edge ();
+                edge_pin = IRMP_PIN;
             }
+            edge_ticks++;
+        }
+        else
+        {
+            (void) irmp_ISR ();
+            print_data ();
+        }
+    }
+}
 
-            counter = 0;
-            sum = 0;
-            min = i + 1;
+#ifdef unix
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ * batch decoder: decodes all files of a directory in parallel, each thread uses its own decoder instance
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#define BATCH_MAX_CODES     8                                               // different codes listed per file
+
+typedef struct
+{
+    char *          name;
+    int             n_frames;
+    long            n_samples;
+    int             n_codes;
+    IRMP_DATA       codes[BATCH_MAX_CODES];
+    int             counts[BATCH_MAX_CODES];
+} BATCH_FILE;
+
+typedef struct
+{
+    irmp_state_t    irmp_state;
+    BATCH_FILE *    file;
+    uint_fast8_t    pin;                                                    // input value of current run
+    long            run;                                                    // length of current run in ticks
+} BATCH_DECODER;
+
+static const char *     batch_dir;
+static BATCH_FILE *     batch_files;
+static int              batch_n_files;
+static int              batch_next_file;
+static pthread_mutex_t  batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void
+batch_store (BATCH_FILE * bf, IRMP_DATA * data)
+{
+    int     i;
+
+    bf->n_frames++;
+
+    for (i = 0; i < bf->n_codes; i++)
+    {
+        if (bf->codes[i].protocol == data->protocol && bf->codes[i].address == data->address && bf->codes[i].command == data->command)
+        {
+            bf->counts[i]++;
+            return;
+        }
+    }
+
+    if (bf->n_codes < BATCH_MAX_CODES)
+    {
+        bf->codes[bf->n_codes] = *data;
+        bf->counts[bf->n_codes] = 1;
+        bf->n_codes++;
+    }
+}
+
+static void
+batch_flush (BATCH_DECODER * dec)
+{
+    IRMP_DATA       data;
+    uint_fast16_t   n;
+
+    while (dec->run > 0)
+    {
+        n = (dec->run > 0xFFFF) ? 0xFFFF : dec->run;
+        dec->run -= irmp_ISR_duration_ex (&dec->irmp_state, dec->pin, n);
+
+        if (irmp_get_data_ex (&dec->irmp_state, &data))
+        {
+            batch_store (dec->file, &data);
         }
     }
 }
 
-#define STATE_LEFT_SHIFT    0x01
-#define STATE_RIGHT_SHIFT   0x02
-#define STATE_LEFT_CTRL     0x04
-#define STATE_LEFT_ALT      0x08
-#define STATE_RIGHT_ALT     0x10
-
-#define KEY_ESCAPE          0x1B            // keycode = 0x006e
-#define KEY_MENUE           0x80            // keycode = 0x0070
-#define KEY_BACK            0x81            // keycode = 0x0071
-#define KEY_FORWARD         0x82            // keycode = 0x0072
-#define KEY_ADDRESS         0x83            // keycode = 0x0073
-#define KEY_WINDOW          0x84            // keycode = 0x0074
-#define KEY_1ST_PAGE        0x85            // keycode = 0x0075
-#define KEY_STOP            0x86            // keycode = 0x0076
-#define KEY_MAIL            0x87            // keycode = 0x0077
-#define KEY_FAVORITES       0x88            // keycode = 0x0078
-#define KEY_NEW_PAGE        0x89            // keycode = 0x0079
-#define KEY_SETUP           0x8A            // keycode = 0x007a
-#define KEY_FONT            0x8B            // keycode = 0x007b
-#define KEY_PRINT           0x8C            // keycode = 0x007c
-#define KEY_ON_OFF          0x8E            // keycode = 0x007c
-
-#define KEY_INSERT          0x90            // keycode = 0x004b
-#define KEY_DELETE          0x91            // keycode = 0x004c
-#define KEY_LEFT            0x92            // keycode = 0x004f
-#define KEY_HOME            0x93            // keycode = 0x0050
-#define KEY_END             0x94            // keycode = 0x0051
-#define KEY_UP              0x95            // keycode = 0x0053
-#define KEY_DOWN            0x96            // keycode = 0x0054
-#define KEY_PAGE_UP         0x97            // keycode = 0x0055
-#define KEY_PAGE_DOWN       0x98            // keycode = 0x0056
-#define KEY_RIGHT           0x99            // keycode = 0x0059
-#define KEY_MOUSE_1         0x9E            // keycode = 0x0400
-#define KEY_MOUSE_2         0x9F            // keycode = 0x0800
-
-static uint_fast8_t
-get_fdc_key (uint_fast16_t cmd)
+static void
+batch_ticks (BATCH_DECODER * dec, uint_fast8_t pin, long ticks)
 {
-    static uint8_t key_table[128] =
+    if (dec->pin != pin)
     {
-     // 0       1       2       3       4       5       6       7       8       9       A       B       C       D       E       F
-         0,     '^',    '1',    '2',    '3',    '4',    '5',    '6',    '7',    '8',    '9',    '0',    0xDF,   '',    0,      '\b',
-        '\t',   'q',    'w',    'e',    'r',    't',    'z',    'u',    'i',    'o',    'p',    0xFC,   '+',    0,      0,      'a',
-        's',    'd',    'f',    'g',    'h',    'j',    'k',    'l',    0xF6,   0xE4,   '#',    '\r',   0,      '<',    'y',    'x',
-        'c',    'v',    'b',    'n',    'm',    ',',    '.',    '-',    0,      0,      0,      0,      0,      ' ',    0,      0,
+        batch_flush (dec);
+        dec->pin = pin;
+    }
+    dec->run += ticks;
+}
 
-         0,     '',    '!',    '"',    '',    '$',    '%',    '&',    '/',    '(',    ')',    '=',    '?',    '`',    0,      '\b',
-        '\t',   'Q',    'W',    'E',    'R',    'T',    'Z',    'U',    'I',    'O',    'P',    0xDC,   '*',    0,      0,      'A',
-        'S',    'D',    'F',    'G',    'H',    'J',    'K',    'L',    0xD6,   0xC4,   '\'',   '\r',   0,      '>',    'Y',    'X',
-        'C',    'V',    'B',    'N',    'M',    ';',    ':',    '_',    0,      0,      0,      0,      0,      ' ',    0,      0
-    };
-    static uint_fast8_t state;
+static void
+batch_decode (BATCH_FILE * bf)
+{
+    BATCH_DECODER   dec;
+    char            path[4096];
+    FILE *          fp;
+    int             ch;
+    uint_fast8_t    pin = 0xFF;
 
-    uint_fast8_t key = 0;
+    snprintf (path, sizeof (path), "%s/%s", batch_dir, bf->name);
 
-    switch (cmd)
+    if (! (fp = fopen (path, "r")))
     {
-        case 0x002C: state |=  STATE_LEFT_SHIFT;    break;              // pressed left shift
-        case 0x00AC: state &= ~STATE_LEFT_SHIFT;    break;              // released left shift
-        case 0x0039: state |=  STATE_RIGHT_SHIFT;   break;              // pressed right shift
-        case 0x00B9: state &= ~STATE_RIGHT_SHIFT;   break;              // released right shift
-        case 0x003A: state |=  STATE_LEFT_CTRL;     break;              // pressed left ctrl
-        case 0x00BA: state &= ~STATE_LEFT_CTRL;     break;              // released left ctrl
-        case 0x003C: state |=  STATE_LEFT_ALT;      break;              // pressed left alt
-        case 0x00BC: state &= ~STATE_LEFT_ALT;      break;              // released left alt
-        case 0x003E: state |=  STATE_RIGHT_ALT;     break;              // pressed left alt
-        case 0x00BE: state &= ~STATE_RIGHT_ALT;     break;              // released left alt
+        perror (path);
+        return;
+    }
 
-        case 0x006e: key = KEY_ESCAPE;              break;
-        case 0x004b: key = KEY_INSERT;              break;
-        case 0x004c: key = KEY_DELETE;              break;
-        case 0x004f: key = KEY_LEFT;                break;
-        case 0x0050: key = KEY_HOME;                break;
-        case 0x0051: key = KEY_END;                 break;
-        case 0x0053: key = KEY_UP;                  break;
-        case 0x0054: key = KEY_DOWN;                break;
-        case 0x0055: key = KEY_PAGE_UP;             break;
-        case 0x0056: key = KEY_PAGE_DOWN;           break;
-        case 0x0059: key = KEY_RIGHT;               break;
-        case 0x0400: key = KEY_MOUSE_1;             break;
-        case 0x0800: key = KEY_MOUSE_2;             break;
+    irmp_init_state (&dec.irmp_state);
+    dec.file    = bf;
+    dec.pin     = 0xFF;
+    dec.run     = 0;
 
-        default:
+    while ((ch = getc (fp)) != EOF)                                         // same input handling as main() below
+    {
+        if (ch == '_' || ch == '0')
         {
-            if (!(cmd & 0x80))                      // pressed key
+            pin = 0x00;
+            bf->n_samples++;
+        }
+        else if (ch == 0xaf || ch == '-' || ch == '1')
+        {
+            pin = 0xff;
+            bf->n_samples++;
+        }
+        else if (ch == '\n')
+        {
+            pin = 0xff;
+            batch_ticks (&dec, pin, (long) ((10000.0 * F_INTERRUPTS) / 10000));   // newline: long pause of 10000 msec
+        }
+        else if (ch == '#')
+        {
+            while ((ch = getc (fp)) != '\n' && ch != EOF)
             {
-                if (cmd >= 0x70 && cmd <= 0x7F)     // function keys
-                {
-                    key = cmd + 0x10;               // 7x -> 8x
-                }
-                else if (cmd < 64)                  // key listed in key_table
-                {
-                    if (state & (STATE_LEFT_ALT | STATE_RIGHT_ALT))
-                    {
-                        switch (cmd)
-                        {
-                            case 0x0003: key = '';     break;
-                            case 0x0008: key = '{';     break;
-                            case 0x0009: key = '[';     break;
-                            case 0x000A: key = ']';     break;
-                            case 0x000B: key = '}';     break;
-                            case 0x000C: key = '\\';    break;
-                            case 0x001C: key = '~';     break;
-                            case 0x002D: key = '|';     break;
-                            case 0x0034: key = 0xB5;    break; // Mu
-                        }
-                    }
-                    else if (state & (STATE_LEFT_CTRL))
-                    {
-                        if (key_table[cmd] >= 'a' && key_table[cmd] <= 'z')
-                        {
-                            key = key_table[cmd] - 'a' + 1;
-                        }
-                        else
-                        {
-                            key = key_table[cmd];
-                        }
-                    }
-                    else
-                    {
-                        int idx = cmd + ((state & (STATE_LEFT_SHIFT | STATE_RIGHT_SHIFT)) ? 64 : 0);
-
-                        if (key_table[idx])
-                        {
-                            key = key_table[idx];
-                        }
-                    }
-                }
+                ;
             }
-            break;
         }
+
+        batch_ticks (&dec, pin, 1);
     }
 
-    return (key);
+    batch_flush (&dec);
+    fclose (fp);
 }
 
-static int         analyze = FALSE;
-static int         list = FALSE;
-static IRMP_DATA   irmp_data;
-static int         expected_protocol;
-static int         expected_address;
-static int         expected_command;
-static int         do_check_expected_values;
+static void *
+batch_worker (void * arg)
+{
+    int     idx;
 
-static void
-next_tick (void)
+    (void) arg;
+
+    for (;;)
+    {
+        pthread_mutex_lock (&batch_mutex);
+        idx = batch_next_file++;
+        pthread_mutex_unlock (&batch_mutex);
+
+        if (idx >= batch_n_files)
+        {
+            break;
+        }
+
+        batch_decode (batch_files + idx);
+    }
+    return NULL;
+}
+
+static int
+batch_compare (const void * a, const void * b)
 {
-    if (! analyze && ! list)
+    return strcmp (((const BATCH_FILE *) a)->name, ((const BATCH_FILE *) b)->name);
+}
+
+static int
+batch_main (const char * dir, int n_threads)
+{
+    DIR *               dp;
+    struct dirent *     de;
+    pthread_t *         threads;
+    struct timespec     t0;
+    struct timespec     t1;
+    double              seconds;
+    long                n_frames = 0;
+    long                n_samples = 0;
+    int                 size = 0;
+    int                 i;
+    int                 j;
+
+    if (! (dp = opendir (dir)))
     {
-        (void) irmp_ISR ();
+        perror (dir);
+        return 1;
+    }
 
-        if (irmp_get_data (&irmp_data))
+    while ((de = readdir (dp)) != NULL)
+    {
+        if (de->d_name[0] == '.')
         {
-            uint_fast8_t key;
+            continue;
+        }
 
-            ANALYZE_ONLY_NORMAL_PUTCHAR (' ');
+        if (batch_n_files == size)
+        {
+            size = size ? 2 * size : 256;
+            batch_files = realloc (batch_files, size * sizeof (BATCH_FILE));
+        }
 
-            if (verbose)
-            {
-                printf ("%8.3fms ", (double) (time_counter * 1000) / F_INTERRUPTS);
-            }
+        memset (batch_files + batch_n_files, 0, sizeof (BATCH_FILE));
+        batch_files[batch_n_files].name = strdup (de->d_name);
+        batch_n_files++;
+    }
+    closedir (dp);
 
-            if (irmp_data.protocol == IRMP_ACP24_PROTOCOL)
-            {
-                uint16_t    temp = (irmp_data.command & 0x000F) + 15;
+    qsort (batch_files, batch_n_files, sizeof (BATCH_FILE), batch_compare);
 
-                printf ("p=%2d (%s), a=0x%04x, c=0x%04x, f=0x%02x, temp=%d",
-                        irmp_data.protocol, irmp_protocol_names[irmp_data.protocol], irmp_data.address, irmp_data.command, irmp_data.flags, temp);
-            }
-            else if (irmp_data.protocol == IRMP_FDC_PROTOCOL && (key = get_fdc_key (irmp_data.command)) != 0)
-            {
-                if ((key >= 0x20 && key < 0x7F) || key >= 0xA0)
-                {
-                    printf ("p=%2d (%s), a=0x%04x, c=0x%04x, f=0x%02x, asc=0x%02x, key='%c'",
-                            irmp_data.protocol,  irmp_protocol_names[irmp_data.protocol], irmp_data.address, irmp_data.command, irmp_data.flags, key, key);
-                }
-                else if (key == '\r' || key == '\t' || key == KEY_ESCAPE || (key >= 0x80 && key <= 0x9F))                 // function keys
-                {
-                    char * p = (char *) NULL;
+    if (n_threads <= 0)
+    {
+        n_threads = (int) sysconf (_SC_NPROCESSORS_ONLN);
 
-                    switch (key)
-                    {
-                        case '\t'                : p = "TAB";           break;
-                        case '\r'                : p = "CR";            break;
-                        case KEY_ESCAPE          : p = "ESCAPE";        break;
-                        case KEY_MENUE           : p = "MENUE";         break;
-                        case KEY_BACK            : p = "BACK";          break;
-                        case KEY_FORWARD         : p = "FORWARD";       break;
-                        case KEY_ADDRESS         : p = "ADDRESS";       break;
-                        case KEY_WINDOW          : p = "WINDOW";        break;
-                        case KEY_1ST_PAGE        : p = "1ST_PAGE";      break;
-                        case KEY_STOP            : p = "STOP";          break;
-                        case KEY_MAIL            : p = "MAIL";          break;
-                        case KEY_FAVORITES       : p = "FAVORITES";     break;
-                        case KEY_NEW_PAGE        : p = "NEW_PAGE";      break;
-                        case KEY_SETUP           : p = "SETUP";         break;
-                        case KEY_FONT            : p = "FONT";          break;
-                        case KEY_PRINT           : p = "PRINT";         break;
-                        case KEY_ON_OFF          : p = "ON_OFF";        break;
-
-                        case KEY_INSERT          : p = "INSERT";        break;
-                        case KEY_DELETE          : p = "DELETE";        break;
-                        case KEY_LEFT            : p = "LEFT";          break;
-                        case KEY_HOME            : p = "HOME";          break;
-                        case KEY_END             : p = "END";           break;
-                        case KEY_UP              : p = "UP";            break;
-                        case KEY_DOWN            : p = "DOWN";          break;
-                        case KEY_PAGE_UP         : p = "PAGE_UP";       break;
-                        case KEY_PAGE_DOWN       : p = "PAGE_DOWN";     break;
-                        case KEY_RIGHT           : p = "RIGHT";         break;
-                        case KEY_MOUSE_1         : p = "KEY_MOUSE_1";   break;
-                        case KEY_MOUSE_2         : p = "KEY_MOUSE_2";   break;
-                        default                  : p = "<UNKNWON>";     break;
-                    }
+        if (n_threads <= 0)
+        {
+            n_threads = 1;
+        }
+    }
 
-                    printf ("p=%2d (%s), a=0x%04x, c=0x%04x, f=0x%02x, asc=0x%02x, key=%s",
-                            irmp_data.protocol, irmp_protocol_names[irmp_data.protocol], irmp_data.address, irmp_data.command, irmp_data.flags, key, p);
-                }
-                else
-                {
-                    printf ("p=%2d (%s), a=0x%04x, c=0x%04x, f=0x%02x, asc=0x%02x",
-                            irmp_data.protocol,  irmp_protocol_names[irmp_data.protocol], irmp_data.address, irmp_data.command, irmp_data.flags, key);
-                }
-            }
-            else
-            {
-                printf ("p=%2d (%s), a=0x%04x, c=0x%04x, f=0x%02x",
-                        irmp_data.protocol, irmp_protocol_names[irmp_data.protocol], irmp_data.address, irmp_data.command, irmp_data.flags);
-            }
+    batch_dir = dir;
+    silent = TRUE;                                                          // decoder must not print anything
+    verbose = FALSE;
+    threads = malloc (n_threads * sizeof (pthread_t));
 
-            if (do_check_expected_values)
-            {
-                if (irmp_data.protocol != expected_protocol ||
-                    irmp_data.address  != expected_address  ||
-                    irmp_data.command  != expected_command)
-                {
-                    printf ("\nerror 7: expected values differ: p=%2d (%s), a=0x%04x, c=0x%04x\n",
-                            expected_protocol, irmp_protocol_names[expected_protocol], expected_address, expected_command);
-                }
-                else
-                {
-                    printf (" checked!\n");
-                }
-                do_check_expected_values = FALSE;                           // only check 1st frame in a line!
-            }
-            else
-            {
-                putchar ('\n');
-            }
+    clock_gettime (CLOCK_MONOTONIC, &t0);
+
+    for (i = 0; i < n_threads; i++)
+    {
+        pthread_create (threads + i, NULL, batch_worker, NULL);
+    }
+
+    for (i = 0; i < n_threads; i++)
+    {
+        pthread_join (threads[i], NULL);
+    }
+
+    clock_gettime (CLOCK_MONOTONIC, &t1);
+    seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    for (i = 0; i < batch_n_files; i++)
+    {
+        BATCH_FILE * bf = batch_files + i;
+
+        printf ("%s: %d frame(s)", bf->name, bf->n_frames);
+
+        for (j = 0; j < bf->n_codes; j++)
+        {
+            printf ("%s p=%2d (%s), a=0x%04x, c=0x%04x x%d", j ? "," : "",
+                    bf->codes[j].protocol, irmp_protocol_names[bf->codes[j].protocol], bf->codes[j].address, bf->codes[j].command, bf->counts[j]);
         }
+        putchar ('\n');
+
+        n_frames += bf->n_frames;
+        n_samples += bf->n_samples;
     }
+
+    printf ("%d files, %ld frames, %ld samples, %d threads, %.3f s: %.0f frames/s, %.0f samples/s\n",
+            batch_n_files, n_frames, n_samples, n_threads, seconds,
+            seconds > 0 ? n_frames / seconds : 0, seconds > 0 ? n_samples / seconds : 0);
+
+    free (threads);
+    return 0;
 }
+#endif // unix
 
 int
 main (int argc, char ** argv)
@@ -5255,28 +6609,87 @@ main (int argc, char ** argv)
     int         first_pulse = TRUE;
     int         first_pause = TRUE;
 
-    if (argc == 2)
+    const char * dir = NULL;
+    int         n_threads = 0;
+    int         packed = FALSE;
+    int         rtc = 0;
+    clock_t     t0;
+
+    irmp_init_start_bits ();
+
+    for (i = 1; i < argc; i++)
     {
-        if (! strcmp (argv[1], "-v"))
+        if (! strcmp (argv[i], "-v"))
         {
             verbose = TRUE;
         }
-        else if (! strcmp (argv[1], "-l"))
+        else if (! strcmp (argv[i], "-l"))
         {
             list = TRUE;
         }
-        else if (! strcmp (argv[1], "-a"))
+        else if (! strcmp (argv[i], "-a"))
         {
             analyze = TRUE;
         }
-        else if (! strcmp (argv[1], "-s"))
+        else if (! strcmp (argv[i], "-s"))
         {
             silent = TRUE;
         }
-        else if (! strcmp (argv[1], "-r"))
+        else if (! strcmp (argv[i], "-r"))
         {
             radio = TRUE;
         }
+        else if (! strcmp (argv[i], "-e"))
+        {
+            edge = TRUE;
+        }
+        else if (! strcmp (argv[i], "-c"))
+        {
+            pack = TRUE;
+        }
+        else if (! strcmp (argv[i], "-b"))
+        {
+            packed = TRUE;
+        }
+        else if (! strcmp (argv[i], "-t"))
+        {
+            timing = TRUE;
+        }
+        else if (! strcmp (argv[i], "-d") && i + 1 < argc)
+        {
+            dir = argv[++i];
+        }
+        else if (! strcmp (argv[i], "-j") && i + 1 < argc)
+        {
+            n_threads = atoi (argv[++i]);
+        }
+#if IRMP_USE_PROTOCOL_MASK == 1
+        else if (! strcmp (argv[i], "-m") && i + 1 < argc)
+        {
+            irmp_set_protocol_mask (strtoull (argv[++i], (char **) 0, 0));
+        }
+#endif
+    }
+
+    if (dir)
+    {
+#ifdef unix
+        return batch_main (dir, n_threads);
+#else
+        fprintf (stderr, "option -d is only available on unix\n");
+        return 1;
+#endif
+    }
+
+    t0 = clock ();
+
+    if (packed)
+    {
+        rtc = unpack_decode (stdin);
+    }
+    else if (pack)
+    {
+        pack_header ();
     }
 
     for (i = 0; i < 256; i++)
@@ -5289,7 +6702,7 @@ main (int argc, char ** argv)
 
     IRMP_PIN = 0xFF;
 
-    while ((ch = getchar ()) != EOF)
+    while (! packed && (ch = getchar ()) != EOF)
     {
         if (ch == '_' || ch == '0')
         {
@@ -5361,8 +6774,9 @@ main (int argc, char ** argv)
         }
         else if (ch == '\n')
         {
+            flush_edge ();
             IRMP_PIN = 0xff;
-            time_counter = 0;
+            irmp_default_state.time_counter = 0;
 
             if (list && pause > 0)
             {
@@ -5382,9 +6796,10 @@ main (int argc, char ** argv)
         }
         else if (ch == '#')
         {
-            time_counter = 0;
+            flush_edge ();
+            irmp_default_state.time_counter = 0;
 
-            if (analyze)
+            if (analyze || pack)
             {
                 while ((ch = getchar()) != '\n' && ch != EOF)
                 {
@@ -5481,6 +6896,20 @@ main (int argc, char ** argv)
         next_tick ();
     }
 
+    flush_edge ();
+
+    if (pack)
+    {
+        pack_finish ();
+    }
+
+    if (timing)
+    {
+        double seconds = (double) (clock () - t0) / CLOCKS_PER_SEC;
+
+        fprintf (stderr, "%lld ticks in %.3f s: %.0f ticks/s\n", n_ticks, seconds, seconds > 0 ? n_ticks / seconds : 0);
+    }
+
     if (analyze)
     {
         print_spectrum ("START PULSES", start_pulses, TRUE);
@@ -5489,7 +6918,7 @@ main (int argc, char ** argv)
         print_spectrum ("PAUSES", pauses, FALSE);
         puts ("-----------------------------------------------------------------------------");
     }
-    return 0;
+    return rtc;
 }
 
 #endif // ANALYZE
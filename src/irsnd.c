@@ -183,9 +183,17 @@
 #elif defined(ARM_STM32)  //STM32
 #  if defined(USE_STDPERIPH_DRIVER)
     //Nothing here to do here -> See irsndconfig.h
+#    if IRSND_USE_DMA == 1
+#      error IRSND_USE_DMA is only implemented for the ST HAL drivers
+#    endif
 #  elif defined(USE_HAL_DRIVER)
     TIM_HandleTypeDef IrsndTimer;
     TIM_OC_InitTypeDef TIM_OC_InitStructure;
+#    if IRSND_USE_DMA == 1
+    TIM_HandleTypeDef IrsndGateTimer;
+    DMA_HandleTypeDef IrsndTicksDma;
+    DMA_HandleTypeDef IrsndLevelDma;
+#    endif
 #  endif
 
 #elif defined (TEENSY_ARM_CORTEX_M4)                                // Teensy3
@@ -504,6 +512,112 @@ static volatile uint8_t                         irsnd_buffer[9] = {0};
 static volatile uint8_t                         irsnd_repeat = 0;
 static volatile uint8_t                         irsnd_is_on = FALSE;
 
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Precompiled waveform
+ *  @details  irsnd_send_data() runs the frame generator irsnd_step() once for the whole transmission and stores its output as runs of
+ *            (carrier on/off, number of ticks). Consecutive repetition frames that are generated from the same state are stored once in
+ *            a block with a repeat count. irsnd_ISR() only plays the runs back. If a transmission does not fit, e.g. endless repetition
+ *            of GRUNDIG, NOKIA or IR60 frames, irsnd_ISR() runs irsnd_step() itself.
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+typedef uint16_t    IRSND_RUN;
+
+#define IRSND_RUN_ON                            0x8000                  // carrier on during this run
+#define IRSND_RUN_TICKS                         0x7FFF                  // number of ticks of this run
+
+typedef struct
+{
+    uint16_t                                    first;                  // index of first run
+    uint16_t                                    end;                    // index behind last run
+    uint8_t                                     count;                  // number of times the runs are sent
+} IRSND_BLOCK;
+
+static IRSND_RUN                                irsnd_runs[IRSND_MAX_RUNS];
+static IRSND_BLOCK                              irsnd_blocks[IRSND_MAX_BLOCKS];
+static uint8_t                                  irsnd_n_blocks;
+static uint8_t                                  irsnd_block_idx;        // block being sent
+static uint8_t                                  irsnd_block_counter;    // remaining passes of the block, including this one
+static uint16_t                                 irsnd_run_idx;          // next run to send
+static uint16_t                                 irsnd_run_counter;      // remaining ticks of the current run
+static volatile uint8_t                         irsnd_stop_request;
+static uint8_t                                  irsnd_live;             // waveform not compiled, irsnd_ISR() calls irsnd_step()
+
+#if IRSND_USE_DMA == 1
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  DMA transmit engine
+ *  @details  The gate timer counts two per tick. Its update event starts a run: the update DMA request loads the length of the run
+ *            into the auto-reload register and the CC1 DMA request (compare value 0) switches the output of the carrier timer on or
+ *            off by writing its CCER. Both requests read the same slot of a ring of IRSND_DMA_RUNS runs. Whenever half of the ring
+ *            has been played, irsnd_DMA_ISR() refills it from the compiled waveform. Transmissions generated by irsnd_step() in
+ *            irsnd_ISR() don't use the DMA.
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#  if IRSND_USE_CALLBACK == 1
+#    error IRSND_USE_DMA does not support IRSND_USE_CALLBACK
+#  endif
+
+#  if IRSND_DMA_RUNS < 4 || IRSND_DMA_RUNS % 2 != 0
+#    error IRSND_DMA_RUNS has to be even and at least 4
+#  endif
+
+#  ifdef ANALYZE
+#    define IRSND_DMA_CARRIER_ON                1
+#  elif defined(ARM_STM32) && defined(USE_HAL_DRIVER)
+#    define IRSND_DMA_CARRIER_ON                (TIM_CCER_CC1E << (4 * (IRSND_TIMER_CHANNEL_NUMBER - 1)))
+#  else
+#    error IRSND_USE_DMA is only implemented for STM32 with the ST HAL drivers
+#  endif
+
+static uint16_t                                 irsnd_dma_ticks[IRSND_DMA_RUNS];    // auto-reload value of the gate timer: 2 * ticks - 1
+static uint16_t                                 irsnd_dma_level[IRSND_DMA_RUNS];    // CCER of the carrier timer: carrier on or off
+static volatile uint8_t                         irsnd_dma;                          // waveform is played by the DMA
+static uint8_t                                  irsnd_dma_end;                      // halves of the ring to play until the end, 0: not filled
+
+#  ifndef ANALYZE
+static void                                     irsnd_dma_half_cplt (DMA_HandleTypeDef *);
+static void                                     irsnd_dma_cplt (DMA_HandleTypeDef *);
+#  endif
+#endif // IRSND_USE_DMA == 1
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  State of the frame generator irsnd_step()
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+    uint8_t                                     busy;
+    uint8_t                                     is_on;                              // carrier on after the current tick
+    IRSND_FREQ_TYPE                             freq;
+    uint8_t                                     send_trailer;
+    uint8_t                                     current_bit;
+    uint8_t                                     pulse_counter;
+    IRSND_PAUSE_LEN                             pause_counter;
+    uint8_t                                     startbit_pulse_len;
+    IRSND_PAUSE_LEN                             startbit_pause_len;
+    uint8_t                                     pulse_1_len;
+    uint8_t                                     pause_1_len;
+    uint8_t                                     pulse_0_len;
+    uint8_t                                     pause_0_len;
+    uint8_t                                     has_stop_bit;
+    uint8_t                                     new_frame;
+    uint8_t                                     complete_data_len;
+    uint8_t                                     n_repeat_frames;                    // number of repetition frames
+    uint8_t                                     n_auto_repetitions;                 // number of auto_repetitions
+    uint8_t                                     auto_repetition_counter;            // auto_repetition counter
+    uint16_t                                    auto_repetition_pause_len;          // pause before auto_repetition, uint16_t!
+    uint16_t                                    auto_repetition_pause_counter;      // pause before auto_repetition, uint16_t!
+    uint8_t                                     repeat_counter;                     // repeat counter
+    uint16_t                                    repeat_frame_pause_len;             // pause before repeat, uint16_t!
+    uint16_t                                    packet_repeat_pause_counter;        // pause before repeat, uint16_t!
+#if IRSND_SUPPORT_BANG_OLUFSEN_PROTOCOL == 1
+    uint8_t                                     last_bit_value;
+#endif
+    uint8_t                                     pulse_len;
+    IRSND_PAUSE_LEN                             pause_len;
+} IRSND_STATE;
+
+static IRSND_STATE                              irsnd_state;
+
 #if IRSND_USE_CALLBACK == 1
 static void                                     (*irsnd_callback_ptr) (uint8_t);
 #endif // IRSND_USE_CALLBACK == 1
@@ -791,6 +905,8 @@ irsnd_set_freq (IRSND_FREQ_TYPE freq)
 #      error wrong value of IRSND_OCx
 #    endif
 #  endif //PIC_C18
+#else
+    (void) freq;
 #endif // ANALYZE
 }
 
@@ -802,6 +918,11 @@ irsnd_set_freq (IRSND_FREQ_TYPE freq)
 void
 irsnd_init (void)
 {
+    irsnd_state.current_bit = 0xFF;
+    irsnd_state.new_frame   = TRUE;
+    irsnd_state.pulse_len   = 0xFF;
+    irsnd_state.pause_len   = 0xFF;
+
 #ifndef ANALYZE
 #  if defined(PIC_C18)                                                      // PIC C18 or XC8 compiler
 #    if ! defined(__12F1840)                                                // only C18:
@@ -898,6 +1019,36 @@ irsnd_init (void)
         TIM_OC_InitStructure.OCFastMode  = TIM_OCFAST_DISABLE;
         TIM_OC_InitStructure.OCIdleState = TIM_OCIDLESTATE_RESET;
         // HAL_TIM_PWM_ConfigChannel() is called inside irsnd_set_freq()
+
+#      if IRSND_USE_DMA == 1
+        /* Gate timer: two counts per tick, see irsnd_dma_start() */
+        IRSND_DMA_TIMER_CLK_ENABLE();
+        IrsndGateTimer.Instance = IRSND_DMA_TIMER;
+#        if ((IRSND_DMA_TIMER_NUMBER >= 2) && (IRSND_DMA_TIMER_NUMBER <= 5)) || ((IRSND_DMA_TIMER_NUMBER >= 12) && (IRSND_DMA_TIMER_NUMBER <= 14))
+        __HAL_TIM_SET_PRESCALER(&IrsndGateTimer, HAL_RCC_GetPCLK1Freq() / F_INTERRUPTS / 2 - 1);
+#        else
+        __HAL_TIM_SET_PRESCALER(&IrsndGateTimer, HAL_RCC_GetPCLK2Freq() / F_INTERRUPTS / 2 - 1);
+#        endif
+        HAL_TIM_GenerateEvent(&IrsndGateTimer, TIM_EVENTSOURCE_UPDATE);             // load prescaler, compare value stays 0
+
+        /* DMA: update request -> auto-reload value of the gate timer, CC1 request -> CCER of the carrier timer */
+        __HAL_RCC_DMA1_CLK_ENABLE();
+        IrsndTicksDma.Instance                  = IRSND_DMA_TICKS_CHANNEL;
+        IrsndTicksDma.Init.Direction            = DMA_MEMORY_TO_PERIPH;
+        IrsndTicksDma.Init.PeriphInc            = DMA_PINC_DISABLE;
+        IrsndTicksDma.Init.MemInc               = DMA_MINC_ENABLE;
+        IrsndTicksDma.Init.PeriphDataAlignment  = DMA_PDATAALIGN_HALFWORD;
+        IrsndTicksDma.Init.MemDataAlignment     = DMA_MDATAALIGN_HALFWORD;
+        IrsndTicksDma.Init.Mode                 = DMA_CIRCULAR;
+        IrsndTicksDma.Init.Priority             = DMA_PRIORITY_HIGH;
+        IrsndLevelDma.Instance                  = IRSND_DMA_LEVEL_CHANNEL;
+        IrsndLevelDma.Init                      = IrsndTicksDma.Init;
+        HAL_DMA_Init(&IrsndTicksDma);
+        HAL_DMA_Init(&IrsndLevelDma);
+        IrsndTicksDma.XferHalfCpltCallback      = irsnd_dma_half_cplt;
+        IrsndTicksDma.XferCpltCallback          = irsnd_dma_cplt;
+        // the interrupt of IRSND_DMA_TICKS_CHANNEL has to call irsnd_DMA_ISR()
+#      endif
 #    endif
         irsnd_set_freq (IRSND_FREQ_36_KHZ);                                         // set default frequency
 
@@ -974,6 +1125,36 @@ irsnd_is_busy (void)
     return irsnd_busy;
 }
 
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Check carrier
+ *  @return   TRUE while the carrier is on, also if the DMA plays the transmission
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint8_t
+irsnd_is_carrier_on (void)
+{
+#if IRSND_USE_DMA == 1 && !defined(ANALYZE)
+    if (irsnd_dma)
+    {
+        return (IRSND_TIMER->CCER & IRSND_DMA_CARRIER_ON) != 0;
+    }
+#endif
+    return irsnd_is_on;
+}
+
+#if IRSND_USE_DMA == 1
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Check DMA transmission
+ *  @return   TRUE if the DMA plays the current transmission, irsnd_ISR() has nothing to do then
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint8_t
+irsnd_is_dma_busy (void)
+{
+    return irsnd_dma;
+}
+#endif // IRSND_USE_DMA == 1
+
 static uint16_t
 bitsrevervse (uint16_t x, uint8_t len)
 {
@@ -997,6 +1178,11 @@ bitsrevervse (uint16_t x, uint8_t len)
 static uint8_t  sircs_additional_bitlen;
 #endif // IRSND_SUPPORT_SIRCS_PROTOCOL == 1
 
+static uint8_t irsnd_compile (void);
+#if IRSND_USE_DMA == 1
+static void irsnd_dma_start (void);
+#endif
+
 uint8_t
 irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
 {
@@ -1065,7 +1251,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
                 irsnd_buffer[1] |= (address & 0x0010) >> 4;
                 irsnd_buffer[2] =  (address & 0x000F) << 4;
             }
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1084,7 +1270,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[1] = (address & 0x00FF);                                                               // AAAAAAAA
             irsnd_buffer[2] = (command & 0xFF00) >> 8;                                                          // CCCCCCCC
             irsnd_buffer[3] = 0x8B;                                                                             // 10001011 (id)
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
         case IRMP_NEC_PROTOCOL:
@@ -1096,7 +1282,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[1] = (address & 0x00FF);                                                               // AAAAAAAA
             irsnd_buffer[2] = (command & 0xFF00) >> 8;                                                          // CCCCCCCC
             irsnd_buffer[3] = ~((command & 0xFF00) >> 8);                                                       // cccccccc
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1108,7 +1294,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
 
             irsnd_buffer[0] = (address & 0x00FF);                                                               // AAAAAAAA
             irsnd_buffer[1] = (command & 0x00FF);                                                               // CCCCCCCC
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1124,7 +1310,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[3] = ((~address & 0x0003) << 6) | ( (command & 0x00FC) >> 2);                          // aaCCCCCC
             irsnd_buffer[4] = ( (command & 0x0003) << 6) | ((~command & 0x00FC) >> 2);                          // CCcccccc
             irsnd_buffer[5] = ((~command & 0x0003) << 6);                                                       // cc
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1141,7 +1327,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
                                  ((command & 0x0F00) >> 8) +
                                  ((command & 0x00F0) >>4 ) +
                                  ((command & 0x000F))) & 0x000F) << 4;
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1156,7 +1342,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[2] =  (command & 0x00F0) | ((command & 0xF000) >> 12);                                 // IIIICCCC
             irsnd_buffer[3] = ((command & 0x0F00) >> 4) | ((~(command & 0xF000) >> 12) & 0x0F);                 // CCCCcccc
             irsnd_buffer[4] = (~(command & 0x0F00) >> 4) & 0xF0;                                                // cccc0000
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
         case IRMP_SAMSUNG32_PROTOCOL:
@@ -1168,7 +1354,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[1] = (address & 0x00FF);                                                               // AAAAAAAA
             irsnd_buffer[2] = (command & 0xFF00) >> 8;                                                          // CCCCCCCC
             irsnd_buffer[3] = (command & 0x00FF);                                                               // CCCCCCCC
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1184,7 +1370,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[3] = ~((command & 0xFF00) >> 8);                                                       // cccccccc
             irsnd_buffer[4] = (command & 0x00FF);                                                               // CCCCCCCC
             irsnd_buffer[5] = ~(command & 0x00FF);                                                              // cccccccc
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1197,7 +1383,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[0] = (command & 0x0FF0) >> 4;                                                          // CCCCCCCC
             irsnd_buffer[1] = ((command & 0x000F) << 4) | ((address & 0x0F00) >> 8);                            // CCCCAAAA
             irsnd_buffer[2] = (address & 0x00FF);                                                               // AAAAAAAA
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1209,7 +1395,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[0] = (command & 0x07FC) >> 3;                                                          // CCCCCCCC
             irsnd_buffer[1] = ((command & 0x0007) << 5) | ((~command & 0x07C0) >> 6);                           // CCCccccc
             irsnd_buffer[2] = (~command & 0x003F) << 2;                                                         // cccccc
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1234,7 +1420,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             xor_value = irsnd_buffer[2] ^ irsnd_buffer[3] ^ irsnd_buffer[4];
 
             irsnd_buffer[5] = xor_value;
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1252,7 +1438,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[5] = (command & 0xFF00) >> 8;                                                          // CCCCCCCC
             irsnd_buffer[6] = (command & 0x00FF);                                                               // CCCCCCCC
 
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1264,7 +1450,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[0] = 0x80 | toggle_bit_recs80 | ((irmp_data_p->address & 0x0007) << 3) |
                               ((irmp_data_p->command & 0x0038) >> 3);                                           // STAAACCC
             irsnd_buffer[1] = (irmp_data_p->command & 0x07) << 5;                                               // CCC00000
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1276,7 +1462,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[0] = 0x80 | toggle_bit_recs80ext | ((irmp_data_p->address & 0x000F) << 2) |
                                 ((irmp_data_p->command & 0x0030) >> 4);                                         // STAAAACC
             irsnd_buffer[1] = (irmp_data_p->command & 0x0F) << 4;                                               // CCCC0000
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1288,7 +1474,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[0] = ((irmp_data_p->command & 0x40) ? 0x00 : 0x80) | toggle_bit_rc5 |
                                 ((irmp_data_p->address & 0x001F) << 1) | ((irmp_data_p->command & 0x20) >> 5);  // CTAAAAAC
             irsnd_buffer[1] = (irmp_data_p->command & 0x1F) << 3;                                               // CCCCC000
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1300,7 +1486,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[0] = 0x80 | toggle_bit_rc6 | ((irmp_data_p->address & 0x00E0) >> 5);                   // 1MMMTAAA, MMM = 000
             irsnd_buffer[1] = ((irmp_data_p->address & 0x001F) << 3) | ((irmp_data_p->command & 0xE0) >> 5);    // AAAAACCC
             irsnd_buffer[2] = (irmp_data_p->command & 0x1F) << 3;                                               // CCCCC
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1314,7 +1500,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[2] = ((irmp_data_p->address & 0x000F) << 4) | ((irmp_data_p->command & 0xF000) >> 12) | toggle_bit_rc6;    // AAAACCCC
             irsnd_buffer[3] = (irmp_data_p->command & 0x0FF0) >> 4;                                                                 // CCCCCCCC
             irsnd_buffer[4] = (irmp_data_p->command & 0x000F) << 4;                                                                 // CCCC
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1325,7 +1511,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[1] = (irmp_data_p->command & 0x7F) << 1;                                               // CCCCCCC
             irsnd_buffer[2] = ((irmp_data_p->address & 0x1F) << 3) | (((~irmp_data_p->command) & 0x0380) >> 7); // AAAAAccc (2nd frame)
             irsnd_buffer[3] = (~(irmp_data_p->command) & 0x7F) << 1;                                            // ccccccc
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1336,7 +1522,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
 
             irsnd_buffer[0] = ((irmp_data_p->address & 0x0F) << 4) | toggle_bit_thomson | ((irmp_data_p->command & 0x0070) >> 4);   // AAAATCCC (1st frame)
             irsnd_buffer[1] = (irmp_data_p->command & 0x0F) << 4;                                                                   // CCCC
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1347,7 +1533,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
 
             irsnd_buffer[0] = (command & 0xFF00) >> 8;                                                                      // CCCCCCCC
             irsnd_buffer[1] = ~((command & 0xFF00) >> 8);                                                                   // cccccccc
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1356,7 +1542,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
         {
             irsnd_buffer[0] = irmp_data_p->command >> 2;                                                        // CCCCCCCC
             irsnd_buffer[1] = (irmp_data_p->command & 0x0003) << 6;                                             // CC000000
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1365,7 +1551,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
         {
             irsnd_buffer[0] = irmp_data_p->command >> 3;                                                        // CCCCCCCC
             irsnd_buffer[1] = (irmp_data_p->command & 0x0007) << 5;                                             // CCC00000
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1374,7 +1560,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
         {
             irsnd_buffer[0] = irmp_data_p->command >> 2;                                                        // CCCCCCCC
             irsnd_buffer[1] = (irmp_data_p->command & 0x0003) << 6;                                             // CC000000
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1384,7 +1570,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[0] = irmp_data_p->command >> 11;                                                       // SXSCCCCC
             irsnd_buffer[1] = irmp_data_p->command >> 3;                                                        // CCCCCCCC
             irsnd_buffer[2] = (irmp_data_p->command & 0x0007) << 5;                                             // CCC00000
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1398,7 +1584,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[2] = 0x80 | (command >> 2);                                                            // SCCCCCCC (2nd frame)
             irsnd_buffer[3] = (command << 6) & 0xC0;                                                            // CC
 
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1408,7 +1594,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[0] = irmp_data_p->command >> 7;                                                        // CCCCCCCC
             irsnd_buffer[1] = (irmp_data_p->command << 1) & 0xff;                                               // CCCCCCC
 
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1424,7 +1610,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[1] = command >> 6;                                                                     // 1011111_ (start instruction frame)
 #endif
 
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1441,7 +1627,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[4] = (command << 7) | (address >> 1);                                                  // CAAAAAAA
             irsnd_buffer[5] = (address << 7);                                                                   // A
 
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1452,7 +1638,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[1] = ((irmp_data_p->address & 0x0007) << 5) | ((irmp_data_p->command >> 5) & 0x1F);    // AAACCCCC
             irsnd_buffer[2] = ((irmp_data_p->command & 0x001F) << 3) | ((~irmp_data_p->command & 0x01) << 2);   // CCCCCc
 
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1462,7 +1648,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[0] = ((irmp_data_p->address & 0x01FF) >> 1);                                           // AAAAAAAA
             irsnd_buffer[1] = ((irmp_data_p->address & 0x0001) << 7) | ((irmp_data_p->command & 0x7F));         // ACCCCCCC
             irsnd_buffer[2] = ((~irmp_data_p->command & 0x01) << 7);                                            // c
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1477,7 +1663,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[2] = 0;                                                                                // 0000RRRR
             irsnd_buffer[3] = (command & 0xFF);                                                                 // CCCCCCCC
             irsnd_buffer[4] = ~(command & 0xFF);                                                                // cccccccc
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1490,7 +1676,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[0] = ((command & 0x06) << 5) | ((address & 0x0003) << 4) | ((command & 0x0780) >> 7);  //          C0 C1 A0 A1 D0 D1 D2 D3
             irsnd_buffer[1] = ((command & 0x78) << 1) | ((command & 0x0001) << 3);                              //          D4 D5 D6 D7 V  0  0  0
                                                                                                                 
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1503,7 +1689,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[0] = ((address & 0x000F) << 4) | (command & 0x0F00) >> 8;                              // AAAACCCC
             irsnd_buffer[1] = (command & 0x00FF);                                                               // CCCCCCCC
 
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1511,7 +1697,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
         case IRMP_NIKON_PROTOCOL:
         {
             irsnd_buffer[0] = (irmp_data_p->command & 0x0003) << 6;                                             // CC
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1522,7 +1708,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
 
             irsnd_buffer[0] = (irmp_data_p->command & 0x0FF0) >> 4;                                             // CCCCCCCC
             irsnd_buffer[1] = ((irmp_data_p->command & 0x000F) << 4) | crc;                                     // CCCCcccc
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1533,7 +1719,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             irsnd_buffer[1] = (irmp_data_p->address << 6) | (irmp_data_p->command >> 2);                        // AACCCCCC
             irsnd_buffer[2] = (irmp_data_p->command << 6);                                                      // CC
 
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1541,7 +1727,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
         case IRMP_ROOMBA_PROTOCOL:
         {
             irsnd_buffer[0] = (irmp_data_p->command & 0x7F) << 1;                                               // CCCCCCC.
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1549,7 +1735,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
         case IRMP_PENTAX_PROTOCOL:
         {
             irsnd_buffer[0] = (irmp_data_p->command & 0x3F) << 2;                                               // CCCCCC..
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1602,7 +1788,7 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
             ACP_SET_BIT(68, cmd,  1);
             ACP_SET_BIT(69, cmd,  0);
 
-            irsnd_busy      = TRUE;
+            irsnd_state.busy = TRUE;
             break;
         }
 #endif
@@ -1613,98 +1799,101 @@ irsnd_send_data (IRMP_DATA * irmp_data_p, uint8_t do_wait)
         }
     }
 
+    if (! irsnd_state.busy)
+    {
+        return (FALSE);
+    }
+
+    irsnd_live          = ! irsnd_compile ();
+    irsnd_set_freq (irsnd_state.freq);
+    irsnd_block_idx     = 0;
+    irsnd_block_counter = irsnd_blocks[0].count;
+    irsnd_run_idx       = 0;
+    irsnd_run_counter   = 0;
+    irsnd_stop_request  = FALSE;
+#if IRSND_USE_DMA == 1
+    irsnd_dma           = ! irsnd_live;                                         // before irsnd_busy, irsnd_ISR() must not play the runs
+#endif
+    irsnd_busy          = TRUE;
+
+#if IRSND_USE_DMA == 1
+    if (irsnd_dma)
+    {
+        irsnd_dma_start ();
+    }
+#endif
     return irsnd_busy;
 }
 
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Stop repetitions
+ *  @details  Stops the repetition of the frame currently being sent, the rest of the transmission (e.g. a stop frame) is still sent
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
 void
 irsnd_stop (void)
 {
-    irsnd_repeat = 0;
+    irsnd_repeat        = 0;
+    irsnd_stop_request  = TRUE;
 }
 
 /*---------------------------------------------------------------------------------------------------------------------------------------------------
- *  ISR routine
- *  @details  ISR routine, called 10000 times per second
+ *  Frame generator
+ *  @details  Computes one tick of the frame in irsnd_state, called by irsnd_compile()
+ *  @return   FALSE if the transmission is complete, this call does not belong to the waveform
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
-uint8_t
-irsnd_ISR (void)
+static uint8_t
+irsnd_step (void)
 {
-    static uint8_t              send_trailer                    = FALSE;
-    static uint8_t              current_bit                     = 0xFF;
-    static uint8_t              pulse_counter                   = 0;
-    static IRSND_PAUSE_LEN      pause_counter                   = 0;
-    static uint8_t              startbit_pulse_len              = 0;
-    static IRSND_PAUSE_LEN      startbit_pause_len              = 0;
-    static uint8_t              pulse_1_len                     = 0;
-    static uint8_t              pause_1_len                     = 0;
-    static uint8_t              pulse_0_len                     = 0;
-    static uint8_t              pause_0_len                     = 0;
-    static uint8_t              has_stop_bit                    = 0;
-    static uint8_t              new_frame                       = TRUE;
-    static uint8_t              complete_data_len               = 0;
-    static uint8_t              n_repeat_frames                 = 0;                                // number of repetition frames
-    static uint8_t              n_auto_repetitions              = 0;                                // number of auto_repetitions
-    static uint8_t              auto_repetition_counter         = 0;                                // auto_repetition counter
-    static uint16_t             auto_repetition_pause_len       = 0;                                // pause before auto_repetition, uint16_t!
-    static uint16_t             auto_repetition_pause_counter   = 0;                                // pause before auto_repetition, uint16_t!
-    static uint8_t              repeat_counter                  = 0;                                // repeat counter
-    static uint16_t             repeat_frame_pause_len          = 0;                                // pause before repeat, uint16_t!
-    static uint16_t             packet_repeat_pause_counter     = 0;                                // pause before repeat, uint16_t!
-#if IRSND_SUPPORT_BANG_OLUFSEN_PROTOCOL == 1
-    static uint8_t              last_bit_value;
-#endif
-    static uint8_t              pulse_len = 0xFF;
-    static IRSND_PAUSE_LEN      pause_len = 0xFF;
-
-    if (irsnd_busy)
+    if (irsnd_state.busy)
     {
-        if (current_bit == 0xFF && new_frame)                                       // start of transmission...
+        if (irsnd_state.current_bit == 0xFF && irsnd_state.new_frame)                                       // start of transmission...
         {
-            if (auto_repetition_counter > 0)
+            if (irsnd_state.auto_repetition_counter > 0)
             {
-                auto_repetition_pause_counter++;
+                irsnd_state.auto_repetition_pause_counter++;
 
-                if (auto_repetition_pause_counter >= auto_repetition_pause_len)
+                if (irsnd_state.auto_repetition_pause_counter >= irsnd_state.auto_repetition_pause_len)
                 {
-                    auto_repetition_pause_counter = 0;
+                    irsnd_state.auto_repetition_pause_counter = 0;
 
 #if IRSND_SUPPORT_DENON_PROTOCOL == 1
                     if (irsnd_protocol == IRMP_DENON_PROTOCOL)                              // n'th denon frame
                     {
-                        current_bit = 16;
-                        complete_data_len   = 2 * DENON_COMPLETE_DATA_LEN + 1;
+                        irsnd_state.current_bit = 16;
+                        irsnd_state.complete_data_len   = 2 * DENON_COMPLETE_DATA_LEN + 1;
                     }
                     else
 #endif
 #if IRSND_SUPPORT_GRUNDIG_PROTOCOL == 1
                     if (irsnd_protocol == IRMP_GRUNDIG_PROTOCOL)                            // n'th grundig frame
                     {
-                        current_bit = 15;
-                        complete_data_len   = 16 + GRUNDIG_COMPLETE_DATA_LEN;
+                        irsnd_state.current_bit = 15;
+                        irsnd_state.complete_data_len   = 16 + GRUNDIG_COMPLETE_DATA_LEN;
                     }
                     else
 #endif
 #if IRSND_SUPPORT_IR60_PROTOCOL == 1
                     if (irsnd_protocol == IRMP_IR60_PROTOCOL)                               // n'th IR60 frame
                     {
-                        current_bit = 7;
-                        complete_data_len   = 2 * IR60_COMPLETE_DATA_LEN + 1;
+                        irsnd_state.current_bit = 7;
+                        irsnd_state.complete_data_len   = 2 * IR60_COMPLETE_DATA_LEN + 1;
                     }
                     else
 #endif
 #if IRSND_SUPPORT_NOKIA_PROTOCOL == 1
                     if (irsnd_protocol == IRMP_NOKIA_PROTOCOL)                              // n'th nokia frame
                     {
-                        if (auto_repetition_counter + 1 < n_auto_repetitions)
+                        if (irsnd_state.auto_repetition_counter + 1 < irsnd_state.n_auto_repetitions)
                         {
-                            current_bit = 23;
-                            complete_data_len   = 24 + NOKIA_COMPLETE_DATA_LEN;
+                            irsnd_state.current_bit = 23;
+                            irsnd_state.complete_data_len   = 24 + NOKIA_COMPLETE_DATA_LEN;
                         }
                         else                                                                // nokia stop frame
                         {
-                            current_bit = 0xFF;
-                            complete_data_len   = NOKIA_COMPLETE_DATA_LEN;
+                            irsnd_state.current_bit = 0xFF;
+                            irsnd_state.complete_data_len   = NOKIA_COMPLETE_DATA_LEN;
                         }
                     }
                     else
@@ -1715,767 +1904,747 @@ irsnd_ISR (void)
                 }
                 else
                 {
-#ifdef ANALYZE
-                    if (irsnd_is_on)
-                    {
-                        putchar ('0');
-                    }
-                    else
-                    {
-                        putchar ('1');
-                    }
-#endif
-                    return irsnd_busy;
+                    return TRUE;
                 }
             }
-            else if (packet_repeat_pause_counter < repeat_frame_pause_len)
+            else if (irsnd_state.packet_repeat_pause_counter < irsnd_state.repeat_frame_pause_len)
             {
-                packet_repeat_pause_counter++;
-#ifdef ANALYZE
-                if (irsnd_is_on)
-                {
-                    putchar ('0');
-                }
-                else
-                {
-                    putchar ('1');
-                }
-#endif
-                return irsnd_busy;
+                irsnd_state.packet_repeat_pause_counter++;
+                return TRUE;
             }
             else
             {
-                if (send_trailer)
+                if (irsnd_state.send_trailer)
                 {
-                    irsnd_busy = FALSE;
-                    send_trailer = FALSE;
-                    return irsnd_busy;
+                    irsnd_state.busy = FALSE;
+                    irsnd_state.send_trailer = FALSE;
+                    return FALSE;
                 }
                 
-                n_repeat_frames             = irsnd_repeat;
+                irsnd_state.n_repeat_frames             = irsnd_repeat;
 
-                if (n_repeat_frames == IRSND_ENDLESS_REPETITION)
+                if (irsnd_state.n_repeat_frames == IRSND_ENDLESS_REPETITION)
                 {
-                    n_repeat_frames = 255;
+                    irsnd_state.n_repeat_frames = 255;
                 }
 
-                packet_repeat_pause_counter = 0;
-                pulse_counter               = 0;
-                pause_counter               = 0;
+                irsnd_state.packet_repeat_pause_counter = 0;
+                irsnd_state.pulse_counter               = 0;
+                irsnd_state.pause_counter               = 0;
 
                 switch (irsnd_protocol)
                 {
 #if IRSND_SUPPORT_SIRCS_PROTOCOL == 1
                     case IRMP_SIRCS_PROTOCOL:
                     {
-                        startbit_pulse_len          = SIRCS_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = SIRCS_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = SIRCS_1_PULSE_LEN;
-                        pause_1_len                 = SIRCS_PAUSE_LEN - 1;
-                        pulse_0_len                 = SIRCS_0_PULSE_LEN;
-                        pause_0_len                 = SIRCS_PAUSE_LEN - 1;
-                        has_stop_bit                = SIRCS_STOP_BIT;
-                        complete_data_len           = SIRCS_MINIMUM_DATA_LEN + sircs_additional_bitlen;
-                        n_auto_repetitions          = (repeat_counter == 0) ? SIRCS_FRAMES : 1;     // 3 frames auto repetition if first frame
-                        auto_repetition_pause_len   = SIRCS_AUTO_REPETITION_PAUSE_LEN;              // 25ms pause
-                        repeat_frame_pause_len      = SIRCS_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_40_KHZ);
+                        irsnd_state.startbit_pulse_len          = SIRCS_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = SIRCS_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = SIRCS_1_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = SIRCS_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = SIRCS_0_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = SIRCS_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = SIRCS_STOP_BIT;
+                        irsnd_state.complete_data_len           = SIRCS_MINIMUM_DATA_LEN + sircs_additional_bitlen;
+                        irsnd_state.n_auto_repetitions          = (irsnd_state.repeat_counter == 0) ? SIRCS_FRAMES : 1;     // 3 frames auto repetition if first frame
+                        irsnd_state.auto_repetition_pause_len   = SIRCS_AUTO_REPETITION_PAUSE_LEN;              // 25ms pause
+                        irsnd_state.repeat_frame_pause_len      = SIRCS_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_40_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_NEC_PROTOCOL == 1
                     case IRMP_NEC_PROTOCOL:
                     {
-                        startbit_pulse_len          = NEC_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pulse_len          = NEC_START_BIT_PULSE_LEN;
 
-                        if (repeat_counter > 0)
+                        if (irsnd_state.repeat_counter > 0)
                         {
-                            startbit_pause_len      = NEC_REPEAT_START_BIT_PAUSE_LEN - 1;
-                            complete_data_len       = 0;
+                            irsnd_state.startbit_pause_len      = NEC_REPEAT_START_BIT_PAUSE_LEN - 1;
+                            irsnd_state.complete_data_len       = 0;
                         }
                         else
                         {
-                            startbit_pause_len      = NEC_START_BIT_PAUSE_LEN - 1;
-                            complete_data_len       = NEC_COMPLETE_DATA_LEN;
+                            irsnd_state.startbit_pause_len      = NEC_START_BIT_PAUSE_LEN - 1;
+                            irsnd_state.complete_data_len       = NEC_COMPLETE_DATA_LEN;
                         }
 
-                        pulse_1_len                 = NEC_PULSE_LEN;
-                        pause_1_len                 = NEC_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = NEC_PULSE_LEN;
-                        pause_0_len                 = NEC_0_PAUSE_LEN - 1;
-                        has_stop_bit                = NEC_STOP_BIT;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = NEC_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.pulse_1_len                 = NEC_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = NEC_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = NEC_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = NEC_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = NEC_STOP_BIT;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = NEC_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_NEC16_PROTOCOL == 1
                     case IRMP_NEC16_PROTOCOL:
                     {
-                        startbit_pulse_len          = NEC_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = NEC_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = NEC_PULSE_LEN;
-                        pause_1_len                 = NEC_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = NEC_PULSE_LEN;
-                        pause_0_len                 = NEC_0_PAUSE_LEN - 1;
-                        has_stop_bit                = NEC_STOP_BIT;
-                        complete_data_len           = NEC16_COMPLETE_DATA_LEN + 1;                  // 1 more: sync bit
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = NEC_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = NEC_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = NEC_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = NEC_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = NEC_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = NEC_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = NEC_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = NEC_STOP_BIT;
+                        irsnd_state.complete_data_len           = NEC16_COMPLETE_DATA_LEN + 1;                  // 1 more: sync bit
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = NEC_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_NEC42_PROTOCOL == 1
                     case IRMP_NEC42_PROTOCOL:
                     {
-                        startbit_pulse_len          = NEC_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = NEC_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = NEC_PULSE_LEN;
-                        pause_1_len                 = NEC_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = NEC_PULSE_LEN;
-                        pause_0_len                 = NEC_0_PAUSE_LEN - 1;
-                        has_stop_bit                = NEC_STOP_BIT;
-                        complete_data_len           = NEC42_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = NEC_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = NEC_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = NEC_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = NEC_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = NEC_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = NEC_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = NEC_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = NEC_STOP_BIT;
+                        irsnd_state.complete_data_len           = NEC42_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = NEC_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_LGAIR_PROTOCOL == 1
                     case IRMP_LGAIR_PROTOCOL:
                     {
-                        startbit_pulse_len          = NEC_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = NEC_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = NEC_PULSE_LEN;
-                        pause_1_len                 = NEC_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = NEC_PULSE_LEN;
-                        pause_0_len                 = NEC_0_PAUSE_LEN - 1;
-                        has_stop_bit                = NEC_STOP_BIT;
-                        complete_data_len           = LGAIR_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = NEC_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = NEC_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = NEC_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = NEC_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = NEC_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = NEC_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = NEC_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = NEC_STOP_BIT;
+                        irsnd_state.complete_data_len           = LGAIR_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = NEC_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_SAMSUNG_PROTOCOL == 1
                     case IRMP_SAMSUNG_PROTOCOL:
                     {
-                        startbit_pulse_len          = SAMSUNG_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = SAMSUNG_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = SAMSUNG_PULSE_LEN;
-                        pause_1_len                 = SAMSUNG_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = SAMSUNG_PULSE_LEN;
-                        pause_0_len                 = SAMSUNG_0_PAUSE_LEN - 1;
-                        has_stop_bit                = SAMSUNG_STOP_BIT;
-                        complete_data_len           = SAMSUNG_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = SAMSUNG_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = SAMSUNG_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = SAMSUNG_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = SAMSUNG_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = SAMSUNG_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = SAMSUNG_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = SAMSUNG_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = SAMSUNG_STOP_BIT;
+                        irsnd_state.complete_data_len           = SAMSUNG_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = SAMSUNG_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 
                     case IRMP_SAMSUNG32_PROTOCOL:
                     {
-                        startbit_pulse_len          = SAMSUNG_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = SAMSUNG_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = SAMSUNG_PULSE_LEN;
-                        pause_1_len                 = SAMSUNG_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = SAMSUNG_PULSE_LEN;
-                        pause_0_len                 = SAMSUNG_0_PAUSE_LEN - 1;
-                        has_stop_bit                = SAMSUNG_STOP_BIT;
-                        complete_data_len           = SAMSUNG32_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = SAMSUNG32_FRAMES;                             // 1 frame
-                        auto_repetition_pause_len   = SAMSUNG32_AUTO_REPETITION_PAUSE_LEN;          // 47 ms pause
-                        repeat_frame_pause_len      = SAMSUNG32_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = SAMSUNG_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = SAMSUNG_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = SAMSUNG_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = SAMSUNG_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = SAMSUNG_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = SAMSUNG_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = SAMSUNG_STOP_BIT;
+                        irsnd_state.complete_data_len           = SAMSUNG32_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = SAMSUNG32_FRAMES;                             // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = SAMSUNG32_AUTO_REPETITION_PAUSE_LEN;          // 47 ms pause
+                        irsnd_state.repeat_frame_pause_len      = SAMSUNG32_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_SAMSUNG48_PROTOCOL == 1
                     case IRMP_SAMSUNG48_PROTOCOL:
                     {
-                        startbit_pulse_len          = SAMSUNG_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = SAMSUNG_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = SAMSUNG_PULSE_LEN;
-                        pause_1_len                 = SAMSUNG_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = SAMSUNG_PULSE_LEN;
-                        pause_0_len                 = SAMSUNG_0_PAUSE_LEN - 1;
-                        has_stop_bit                = SAMSUNG_STOP_BIT;
-                        complete_data_len           = SAMSUNG48_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = SAMSUNG48_FRAMES;                             // 1 frame
-                        auto_repetition_pause_len   = SAMSUNG48_AUTO_REPETITION_PAUSE_LEN;          // 47 ms pause
-                        repeat_frame_pause_len      = SAMSUNG48_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = SAMSUNG_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = SAMSUNG_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = SAMSUNG_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = SAMSUNG_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = SAMSUNG_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = SAMSUNG_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = SAMSUNG_STOP_BIT;
+                        irsnd_state.complete_data_len           = SAMSUNG48_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = SAMSUNG48_FRAMES;                             // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = SAMSUNG48_AUTO_REPETITION_PAUSE_LEN;          // 47 ms pause
+                        irsnd_state.repeat_frame_pause_len      = SAMSUNG48_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_MATSUSHITA_PROTOCOL == 1
                     case IRMP_MATSUSHITA_PROTOCOL:
                     {
-                        startbit_pulse_len          = MATSUSHITA_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = MATSUSHITA_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = MATSUSHITA_PULSE_LEN;
-                        pause_1_len                 = MATSUSHITA_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = MATSUSHITA_PULSE_LEN;
-                        pause_0_len                 = MATSUSHITA_0_PAUSE_LEN - 1;
-                        has_stop_bit                = MATSUSHITA_STOP_BIT;
-                        complete_data_len           = MATSUSHITA_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = MATSUSHITA_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_36_KHZ);
+                        irsnd_state.startbit_pulse_len          = MATSUSHITA_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = MATSUSHITA_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = MATSUSHITA_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = MATSUSHITA_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = MATSUSHITA_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = MATSUSHITA_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = MATSUSHITA_STOP_BIT;
+                        irsnd_state.complete_data_len           = MATSUSHITA_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = MATSUSHITA_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_36_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_TECHNICS_PROTOCOL == 1
                     case IRMP_TECHNICS_PROTOCOL:
                     {
-                        startbit_pulse_len          = MATSUSHITA_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = MATSUSHITA_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = MATSUSHITA_PULSE_LEN;
-                        pause_1_len                 = MATSUSHITA_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = MATSUSHITA_PULSE_LEN;
-                        pause_0_len                 = MATSUSHITA_0_PAUSE_LEN - 1;
-                        has_stop_bit                = MATSUSHITA_STOP_BIT;
-                        complete_data_len           = TECHNICS_COMPLETE_DATA_LEN;                   // here TECHNICS
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = MATSUSHITA_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_36_KHZ);
+                        irsnd_state.startbit_pulse_len          = MATSUSHITA_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = MATSUSHITA_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = MATSUSHITA_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = MATSUSHITA_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = MATSUSHITA_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = MATSUSHITA_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = MATSUSHITA_STOP_BIT;
+                        irsnd_state.complete_data_len           = TECHNICS_COMPLETE_DATA_LEN;                   // here TECHNICS
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = MATSUSHITA_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_36_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_KASEIKYO_PROTOCOL == 1
                     case IRMP_KASEIKYO_PROTOCOL:
                     {
-                        startbit_pulse_len          = KASEIKYO_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = KASEIKYO_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = KASEIKYO_PULSE_LEN;
-                        pause_1_len                 = KASEIKYO_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = KASEIKYO_PULSE_LEN;
-                        pause_0_len                 = KASEIKYO_0_PAUSE_LEN - 1;
-                        has_stop_bit                = KASEIKYO_STOP_BIT;
-                        complete_data_len           = KASEIKYO_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = (repeat_counter == 0) ? KASEIKYO_FRAMES : 1;  // 2 frames auto repetition if first frame
-                        auto_repetition_pause_len   = KASEIKYO_AUTO_REPETITION_PAUSE_LEN;           // 75 ms pause
-                        repeat_frame_pause_len      = KASEIKYO_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = KASEIKYO_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = KASEIKYO_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = KASEIKYO_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = KASEIKYO_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = KASEIKYO_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = KASEIKYO_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = KASEIKYO_STOP_BIT;
+                        irsnd_state.complete_data_len           = KASEIKYO_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = (irsnd_state.repeat_counter == 0) ? KASEIKYO_FRAMES : 1;  // 2 frames auto repetition if first frame
+                        irsnd_state.auto_repetition_pause_len   = KASEIKYO_AUTO_REPETITION_PAUSE_LEN;           // 75 ms pause
+                        irsnd_state.repeat_frame_pause_len      = KASEIKYO_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_PANASONIC_PROTOCOL == 1
                     case IRMP_PANASONIC_PROTOCOL:
                     {
-                        startbit_pulse_len          = PANASONIC_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = PANASONIC_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = PANASONIC_PULSE_LEN;
-                        pause_1_len                 = PANASONIC_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = PANASONIC_PULSE_LEN;
-                        pause_0_len                 = PANASONIC_0_PAUSE_LEN - 1;
-                        has_stop_bit                = PANASONIC_STOP_BIT;
-                        complete_data_len           = PANASONIC_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = PANASONIC_FRAMES;                             // 1 frame
-                        auto_repetition_pause_len   = PANASONIC_AUTO_REPETITION_PAUSE_LEN;          // 40 ms pause
-                        repeat_frame_pause_len      = PANASONIC_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = PANASONIC_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = PANASONIC_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = PANASONIC_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = PANASONIC_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = PANASONIC_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = PANASONIC_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = PANASONIC_STOP_BIT;
+                        irsnd_state.complete_data_len           = PANASONIC_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = PANASONIC_FRAMES;                             // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = PANASONIC_AUTO_REPETITION_PAUSE_LEN;          // 40 ms pause
+                        irsnd_state.repeat_frame_pause_len      = PANASONIC_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_RECS80_PROTOCOL == 1
                     case IRMP_RECS80_PROTOCOL:
                     {
-                        startbit_pulse_len          = RECS80_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = RECS80_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = RECS80_PULSE_LEN;
-                        pause_1_len                 = RECS80_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = RECS80_PULSE_LEN;
-                        pause_0_len                 = RECS80_0_PAUSE_LEN - 1;
-                        has_stop_bit                = RECS80_STOP_BIT;
-                        complete_data_len           = RECS80_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = RECS80_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = RECS80_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = RECS80_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = RECS80_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = RECS80_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = RECS80_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = RECS80_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = RECS80_STOP_BIT;
+                        irsnd_state.complete_data_len           = RECS80_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = RECS80_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_RECS80EXT_PROTOCOL == 1
                     case IRMP_RECS80EXT_PROTOCOL:
                     {
-                        startbit_pulse_len          = RECS80EXT_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = RECS80EXT_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = RECS80EXT_PULSE_LEN;
-                        pause_1_len                 = RECS80EXT_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = RECS80EXT_PULSE_LEN;
-                        pause_0_len                 = RECS80EXT_0_PAUSE_LEN - 1;
-                        has_stop_bit                = RECS80EXT_STOP_BIT;
-                        complete_data_len           = RECS80EXT_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = RECS80EXT_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = RECS80EXT_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = RECS80EXT_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = RECS80EXT_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = RECS80EXT_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = RECS80EXT_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = RECS80EXT_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = RECS80EXT_STOP_BIT;
+                        irsnd_state.complete_data_len           = RECS80EXT_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = RECS80EXT_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_TELEFUNKEN_PROTOCOL == 1
                     case IRMP_TELEFUNKEN_PROTOCOL:
                     {
-                        startbit_pulse_len          = TELEFUNKEN_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = TELEFUNKEN_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = TELEFUNKEN_PULSE_LEN;
-                        pause_1_len                 = TELEFUNKEN_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = TELEFUNKEN_PULSE_LEN;
-                        pause_0_len                 = TELEFUNKEN_0_PAUSE_LEN - 1;
-                        has_stop_bit                = TELEFUNKEN_STOP_BIT;
-                        complete_data_len           = TELEFUNKEN_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = 1;                                            // 1 frames
-                        auto_repetition_pause_len   = 0;                                            // TELEFUNKEN_AUTO_REPETITION_PAUSE_LEN;         // xx ms pause
-                        repeat_frame_pause_len      = TELEFUNKEN_FRAME_REPEAT_PAUSE_LEN;            // 117 msec pause
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = TELEFUNKEN_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = TELEFUNKEN_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = TELEFUNKEN_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = TELEFUNKEN_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = TELEFUNKEN_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = TELEFUNKEN_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = TELEFUNKEN_STOP_BIT;
+                        irsnd_state.complete_data_len           = TELEFUNKEN_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frames
+                        irsnd_state.auto_repetition_pause_len   = 0;                                            // TELEFUNKEN_AUTO_REPETITION_PAUSE_LEN;         // xx ms pause
+                        irsnd_state.repeat_frame_pause_len      = TELEFUNKEN_FRAME_REPEAT_PAUSE_LEN;            // 117 msec pause
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_RC5_PROTOCOL == 1
                     case IRMP_RC5_PROTOCOL:
                     {
-                        startbit_pulse_len          = RC5_BIT_LEN;
-                        startbit_pause_len          = RC5_BIT_LEN;
-                        pulse_len                   = RC5_BIT_LEN;
-                        pause_len                   = RC5_BIT_LEN;
-                        has_stop_bit                = RC5_STOP_BIT;
-                        complete_data_len           = RC5_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = RC5_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_36_KHZ);
+                        irsnd_state.startbit_pulse_len          = RC5_BIT_LEN;
+                        irsnd_state.startbit_pause_len          = RC5_BIT_LEN;
+                        irsnd_state.pulse_len                   = RC5_BIT_LEN;
+                        irsnd_state.pause_len                   = RC5_BIT_LEN;
+                        irsnd_state.has_stop_bit                = RC5_STOP_BIT;
+                        irsnd_state.complete_data_len           = RC5_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = RC5_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_36_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_RC6_PROTOCOL == 1
                     case IRMP_RC6_PROTOCOL:
                     {
-                        startbit_pulse_len          = RC6_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = RC6_START_BIT_PAUSE_LEN - 1;
-                        pulse_len                   = RC6_BIT_LEN;
-                        pause_len                   = RC6_BIT_LEN;
-                        has_stop_bit                = RC6_STOP_BIT;
-                        complete_data_len           = RC6_COMPLETE_DATA_LEN_SHORT;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = RC6_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_36_KHZ);
+                        irsnd_state.startbit_pulse_len          = RC6_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = RC6_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_len                   = RC6_BIT_LEN;
+                        irsnd_state.pause_len                   = RC6_BIT_LEN;
+                        irsnd_state.has_stop_bit                = RC6_STOP_BIT;
+                        irsnd_state.complete_data_len           = RC6_COMPLETE_DATA_LEN_SHORT;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = RC6_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_36_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_RC6A_PROTOCOL == 1
                     case IRMP_RC6A_PROTOCOL:
                     {
-                        startbit_pulse_len          = RC6_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = RC6_START_BIT_PAUSE_LEN - 1;
-                        pulse_len                   = RC6_BIT_LEN;
-                        pause_len                   = RC6_BIT_LEN;
-                        has_stop_bit                = RC6_STOP_BIT;
-                        complete_data_len           = RC6_COMPLETE_DATA_LEN_LONG;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = RC6_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_36_KHZ);
+                        irsnd_state.startbit_pulse_len          = RC6_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = RC6_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_len                   = RC6_BIT_LEN;
+                        irsnd_state.pause_len                   = RC6_BIT_LEN;
+                        irsnd_state.has_stop_bit                = RC6_STOP_BIT;
+                        irsnd_state.complete_data_len           = RC6_COMPLETE_DATA_LEN_LONG;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = RC6_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_36_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_DENON_PROTOCOL == 1
                     case IRMP_DENON_PROTOCOL:
                     {
-                        startbit_pulse_len          = 0x00;
-                        startbit_pause_len          = 0x00;
-                        pulse_1_len                 = DENON_PULSE_LEN;
-                        pause_1_len                 = DENON_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = DENON_PULSE_LEN;
-                        pause_0_len                 = DENON_0_PAUSE_LEN - 1;
-                        has_stop_bit                = DENON_STOP_BIT;
-                        complete_data_len           = DENON_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = DENON_FRAMES;                                 // 2 frames, 2nd with inverted command
-                        auto_repetition_pause_len   = DENON_AUTO_REPETITION_PAUSE_LEN;              // 65 ms pause after 1st frame
-                        repeat_frame_pause_len      = DENON_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_36_KHZ);                                         // in theory 32kHz, in practice 36kHz is better
+                        irsnd_state.startbit_pulse_len          = 0x00;
+                        irsnd_state.startbit_pause_len          = 0x00;
+                        irsnd_state.pulse_1_len                 = DENON_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = DENON_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = DENON_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = DENON_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = DENON_STOP_BIT;
+                        irsnd_state.complete_data_len           = DENON_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = DENON_FRAMES;                                 // 2 frames, 2nd with inverted command
+                        irsnd_state.auto_repetition_pause_len   = DENON_AUTO_REPETITION_PAUSE_LEN;              // 65 ms pause after 1st frame
+                        irsnd_state.repeat_frame_pause_len      = DENON_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_36_KHZ;                                         // in theory 32kHz, in practice 36kHz is better
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_THOMSON_PROTOCOL == 1
                     case IRMP_THOMSON_PROTOCOL:
                     {
-                        startbit_pulse_len          = 0x00;
-                        startbit_pause_len          = 0x00;
-                        pulse_1_len                 = THOMSON_PULSE_LEN;
-                        pause_1_len                 = THOMSON_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = THOMSON_PULSE_LEN;
-                        pause_0_len                 = THOMSON_0_PAUSE_LEN - 1;
-                        has_stop_bit                = THOMSON_STOP_BIT;
-                        complete_data_len           = THOMSON_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = THOMSON_FRAMES;                               // only 1 frame
-                        auto_repetition_pause_len   = THOMSON_AUTO_REPETITION_PAUSE_LEN;
-                        repeat_frame_pause_len      = THOMSON_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = 0x00;
+                        irsnd_state.startbit_pause_len          = 0x00;
+                        irsnd_state.pulse_1_len                 = THOMSON_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = THOMSON_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = THOMSON_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = THOMSON_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = THOMSON_STOP_BIT;
+                        irsnd_state.complete_data_len           = THOMSON_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = THOMSON_FRAMES;                               // only 1 frame
+                        irsnd_state.auto_repetition_pause_len   = THOMSON_AUTO_REPETITION_PAUSE_LEN;
+                        irsnd_state.repeat_frame_pause_len      = THOMSON_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_BOSE_PROTOCOL == 1
                     case IRMP_BOSE_PROTOCOL:
                     {
-                        startbit_pulse_len          = BOSE_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = BOSE_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = BOSE_PULSE_LEN;
-                        pause_1_len                 = BOSE_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = BOSE_PULSE_LEN;
-                        pause_0_len                 = BOSE_0_PAUSE_LEN - 1;
-                        has_stop_bit                = BOSE_STOP_BIT;
-                        complete_data_len           = BOSE_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = BOSE_FRAMES;                                // 1 frame
-                        auto_repetition_pause_len   = BOSE_AUTO_REPETITION_PAUSE_LEN;             // 40 ms pause
-                        repeat_frame_pause_len      = BOSE_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_36_KHZ);
+                        irsnd_state.startbit_pulse_len          = BOSE_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = BOSE_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = BOSE_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = BOSE_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = BOSE_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = BOSE_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = BOSE_STOP_BIT;
+                        irsnd_state.complete_data_len           = BOSE_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = BOSE_FRAMES;                                // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = BOSE_AUTO_REPETITION_PAUSE_LEN;             // 40 ms pause
+                        irsnd_state.repeat_frame_pause_len      = BOSE_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_36_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_NUBERT_PROTOCOL == 1
                     case IRMP_NUBERT_PROTOCOL:
                     {
-                        startbit_pulse_len          = NUBERT_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = NUBERT_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = NUBERT_1_PULSE_LEN;
-                        pause_1_len                 = NUBERT_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = NUBERT_0_PULSE_LEN;
-                        pause_0_len                 = NUBERT_0_PAUSE_LEN - 1;
-                        has_stop_bit                = NUBERT_STOP_BIT;
-                        complete_data_len           = NUBERT_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = NUBERT_FRAMES;                                // 2 frames
-                        auto_repetition_pause_len   = NUBERT_AUTO_REPETITION_PAUSE_LEN;             // 35 ms pause
-                        repeat_frame_pause_len      = NUBERT_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_36_KHZ);
+                        irsnd_state.startbit_pulse_len          = NUBERT_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = NUBERT_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = NUBERT_1_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = NUBERT_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = NUBERT_0_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = NUBERT_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = NUBERT_STOP_BIT;
+                        irsnd_state.complete_data_len           = NUBERT_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = NUBERT_FRAMES;                                // 2 frames
+                        irsnd_state.auto_repetition_pause_len   = NUBERT_AUTO_REPETITION_PAUSE_LEN;             // 35 ms pause
+                        irsnd_state.repeat_frame_pause_len      = NUBERT_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_36_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_FAN_PROTOCOL == 1
                     case IRMP_FAN_PROTOCOL:
                     {
-                        startbit_pulse_len          = FAN_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = FAN_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = FAN_1_PULSE_LEN;
-                        pause_1_len                 = FAN_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = FAN_0_PULSE_LEN;
-                        pause_0_len                 = FAN_0_PAUSE_LEN - 1;
-                        has_stop_bit                = FAN_STOP_BIT;
-                        complete_data_len           = FAN_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = FAN_FRAMES;                                   // only 1 frame
-                        auto_repetition_pause_len   = FAN_AUTO_REPETITION_PAUSE_LEN;                // 35 ms pause
-                        repeat_frame_pause_len      = FAN_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_36_KHZ);
+                        irsnd_state.startbit_pulse_len          = FAN_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = FAN_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = FAN_1_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = FAN_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = FAN_0_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = FAN_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = FAN_STOP_BIT;
+                        irsnd_state.complete_data_len           = FAN_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = FAN_FRAMES;                                   // only 1 frame
+                        irsnd_state.auto_repetition_pause_len   = FAN_AUTO_REPETITION_PAUSE_LEN;                // 35 ms pause
+                        irsnd_state.repeat_frame_pause_len      = FAN_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_36_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_SPEAKER_PROTOCOL == 1
                     case IRMP_SPEAKER_PROTOCOL:
                     {
-                        startbit_pulse_len          = SPEAKER_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = SPEAKER_START_BIT_PAUSE_LEN - 1;
-                        pulse_1_len                 = SPEAKER_1_PULSE_LEN;
-                        pause_1_len                 = SPEAKER_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = SPEAKER_0_PULSE_LEN;
-                        pause_0_len                 = SPEAKER_0_PAUSE_LEN - 1;
-                        has_stop_bit                = SPEAKER_STOP_BIT;
-                        complete_data_len           = SPEAKER_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = SPEAKER_FRAMES;                                // 2 frames
-                        auto_repetition_pause_len   = SPEAKER_AUTO_REPETITION_PAUSE_LEN;             // 35 ms pause
-                        repeat_frame_pause_len      = SPEAKER_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = SPEAKER_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = SPEAKER_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = SPEAKER_1_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = SPEAKER_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = SPEAKER_0_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = SPEAKER_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = SPEAKER_STOP_BIT;
+                        irsnd_state.complete_data_len           = SPEAKER_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = SPEAKER_FRAMES;                                // 2 frames
+                        irsnd_state.auto_repetition_pause_len   = SPEAKER_AUTO_REPETITION_PAUSE_LEN;             // 35 ms pause
+                        irsnd_state.repeat_frame_pause_len      = SPEAKER_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_BANG_OLUFSEN_PROTOCOL == 1
                     case IRMP_BANG_OLUFSEN_PROTOCOL:
                     {
-                        startbit_pulse_len          = BANG_OLUFSEN_START_BIT1_PULSE_LEN;
-                        startbit_pause_len          = BANG_OLUFSEN_START_BIT1_PAUSE_LEN - 1;
-                        pulse_1_len                 = BANG_OLUFSEN_PULSE_LEN;
-                        pause_1_len                 = BANG_OLUFSEN_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = BANG_OLUFSEN_PULSE_LEN;
-                        pause_0_len                 = BANG_OLUFSEN_0_PAUSE_LEN - 1;
-                        has_stop_bit                = BANG_OLUFSEN_STOP_BIT;
-                        complete_data_len           = BANG_OLUFSEN_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = BANG_OLUFSEN_FRAME_REPEAT_PAUSE_LEN;
-                        last_bit_value              = 0;
-                        irsnd_set_freq (IRSND_FREQ_455_KHZ);
+                        irsnd_state.startbit_pulse_len          = BANG_OLUFSEN_START_BIT1_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = BANG_OLUFSEN_START_BIT1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_1_len                 = BANG_OLUFSEN_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = BANG_OLUFSEN_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = BANG_OLUFSEN_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = BANG_OLUFSEN_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = BANG_OLUFSEN_STOP_BIT;
+                        irsnd_state.complete_data_len           = BANG_OLUFSEN_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = BANG_OLUFSEN_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.last_bit_value              = 0;
+                        irsnd_state.freq                        = IRSND_FREQ_455_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_GRUNDIG_PROTOCOL == 1
                     case IRMP_GRUNDIG_PROTOCOL:
                     {
-                        startbit_pulse_len          = GRUNDIG_NOKIA_IR60_BIT_LEN;
-                        startbit_pause_len          = GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN - 1;
-                        pulse_len                   = GRUNDIG_NOKIA_IR60_BIT_LEN;
-                        pause_len                   = GRUNDIG_NOKIA_IR60_BIT_LEN;
-                        has_stop_bit                = GRUNDIG_NOKIA_IR60_STOP_BIT;
-                        complete_data_len           = GRUNDIG_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = GRUNDIG_FRAMES;                               // 2 frames
-                        auto_repetition_pause_len   = GRUNDIG_AUTO_REPETITION_PAUSE_LEN;            // 20m sec pause
-                        repeat_frame_pause_len      = GRUNDIG_NOKIA_IR60_FRAME_REPEAT_PAUSE_LEN;    // 117 msec pause
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = GRUNDIG_NOKIA_IR60_BIT_LEN;
+                        irsnd_state.startbit_pause_len          = GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN - 1;
+                        irsnd_state.pulse_len                   = GRUNDIG_NOKIA_IR60_BIT_LEN;
+                        irsnd_state.pause_len                   = GRUNDIG_NOKIA_IR60_BIT_LEN;
+                        irsnd_state.has_stop_bit                = GRUNDIG_NOKIA_IR60_STOP_BIT;
+                        irsnd_state.complete_data_len           = GRUNDIG_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = GRUNDIG_FRAMES;                               // 2 frames
+                        irsnd_state.auto_repetition_pause_len   = GRUNDIG_AUTO_REPETITION_PAUSE_LEN;            // 20m sec pause
+                        irsnd_state.repeat_frame_pause_len      = GRUNDIG_NOKIA_IR60_FRAME_REPEAT_PAUSE_LEN;    // 117 msec pause
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_IR60_PROTOCOL == 1
                     case IRMP_IR60_PROTOCOL:
                     {
-                        startbit_pulse_len          = GRUNDIG_NOKIA_IR60_BIT_LEN;
-                        startbit_pause_len          = GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN - 1;
-                        pulse_len                   = GRUNDIG_NOKIA_IR60_BIT_LEN;
-                        pause_len                   = GRUNDIG_NOKIA_IR60_BIT_LEN;
-                        has_stop_bit                = GRUNDIG_NOKIA_IR60_STOP_BIT;
-                        complete_data_len           = IR60_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = IR60_FRAMES;                                  // 2 frames
-                        auto_repetition_pause_len   = IR60_AUTO_REPETITION_PAUSE_LEN;               // 20m sec pause
-                        repeat_frame_pause_len      = GRUNDIG_NOKIA_IR60_FRAME_REPEAT_PAUSE_LEN;    // 117 msec pause
-                        irsnd_set_freq (IRSND_FREQ_30_KHZ);
+                        irsnd_state.startbit_pulse_len          = GRUNDIG_NOKIA_IR60_BIT_LEN;
+                        irsnd_state.startbit_pause_len          = GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN - 1;
+                        irsnd_state.pulse_len                   = GRUNDIG_NOKIA_IR60_BIT_LEN;
+                        irsnd_state.pause_len                   = GRUNDIG_NOKIA_IR60_BIT_LEN;
+                        irsnd_state.has_stop_bit                = GRUNDIG_NOKIA_IR60_STOP_BIT;
+                        irsnd_state.complete_data_len           = IR60_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = IR60_FRAMES;                                  // 2 frames
+                        irsnd_state.auto_repetition_pause_len   = IR60_AUTO_REPETITION_PAUSE_LEN;               // 20m sec pause
+                        irsnd_state.repeat_frame_pause_len      = GRUNDIG_NOKIA_IR60_FRAME_REPEAT_PAUSE_LEN;    // 117 msec pause
+                        irsnd_state.freq                        = IRSND_FREQ_30_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_NOKIA_PROTOCOL == 1
                     case IRMP_NOKIA_PROTOCOL:
                     {
-                        startbit_pulse_len          = GRUNDIG_NOKIA_IR60_BIT_LEN;
-                        startbit_pause_len          = GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN - 1;
-                        pulse_len                   = GRUNDIG_NOKIA_IR60_BIT_LEN;
-                        pause_len                   = GRUNDIG_NOKIA_IR60_BIT_LEN;
-                        has_stop_bit                = GRUNDIG_NOKIA_IR60_STOP_BIT;
-                        complete_data_len           = NOKIA_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = NOKIA_FRAMES;                                 // 2 frames
-                        auto_repetition_pause_len   = NOKIA_AUTO_REPETITION_PAUSE_LEN;              // 20 msec pause
-                        repeat_frame_pause_len      = GRUNDIG_NOKIA_IR60_FRAME_REPEAT_PAUSE_LEN;    // 117 msec pause
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = GRUNDIG_NOKIA_IR60_BIT_LEN;
+                        irsnd_state.startbit_pause_len          = GRUNDIG_NOKIA_IR60_PRE_PAUSE_LEN - 1;
+                        irsnd_state.pulse_len                   = GRUNDIG_NOKIA_IR60_BIT_LEN;
+                        irsnd_state.pause_len                   = GRUNDIG_NOKIA_IR60_BIT_LEN;
+                        irsnd_state.has_stop_bit                = GRUNDIG_NOKIA_IR60_STOP_BIT;
+                        irsnd_state.complete_data_len           = NOKIA_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = NOKIA_FRAMES;                                 // 2 frames
+                        irsnd_state.auto_repetition_pause_len   = NOKIA_AUTO_REPETITION_PAUSE_LEN;              // 20 msec pause
+                        irsnd_state.repeat_frame_pause_len      = GRUNDIG_NOKIA_IR60_FRAME_REPEAT_PAUSE_LEN;    // 117 msec pause
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_SIEMENS_PROTOCOL == 1
                     case IRMP_SIEMENS_PROTOCOL:
                     {
-                        startbit_pulse_len          = SIEMENS_BIT_LEN;
-                        startbit_pause_len          = SIEMENS_BIT_LEN;
-                        pulse_len                   = SIEMENS_BIT_LEN;
-                        pause_len                   = SIEMENS_BIT_LEN;
-                        has_stop_bit                = SIEMENS_OR_RUWIDO_STOP_BIT;
-                        complete_data_len           = SIEMENS_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = SIEMENS_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_36_KHZ);
+                        irsnd_state.startbit_pulse_len          = SIEMENS_BIT_LEN;
+                        irsnd_state.startbit_pause_len          = SIEMENS_BIT_LEN;
+                        irsnd_state.pulse_len                   = SIEMENS_BIT_LEN;
+                        irsnd_state.pause_len                   = SIEMENS_BIT_LEN;
+                        irsnd_state.has_stop_bit                = SIEMENS_OR_RUWIDO_STOP_BIT;
+                        irsnd_state.complete_data_len           = SIEMENS_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = SIEMENS_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_36_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_RUWIDO_PROTOCOL == 1
                     case IRMP_RUWIDO_PROTOCOL:
                     {
-                        startbit_pulse_len          = RUWIDO_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = RUWIDO_START_BIT_PAUSE_LEN;
-                        pulse_len                   = RUWIDO_BIT_PULSE_LEN;
-                        pause_len                   = RUWIDO_BIT_PAUSE_LEN;
-                        has_stop_bit                = SIEMENS_OR_RUWIDO_STOP_BIT;
-                        complete_data_len           = RUWIDO_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = RUWIDO_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_36_KHZ);
+                        irsnd_state.startbit_pulse_len          = RUWIDO_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = RUWIDO_START_BIT_PAUSE_LEN;
+                        irsnd_state.pulse_len                   = RUWIDO_BIT_PULSE_LEN;
+                        irsnd_state.pause_len                   = RUWIDO_BIT_PAUSE_LEN;
+                        irsnd_state.has_stop_bit                = SIEMENS_OR_RUWIDO_STOP_BIT;
+                        irsnd_state.complete_data_len           = RUWIDO_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = RUWIDO_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_36_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_FDC_PROTOCOL == 1
                     case IRMP_FDC_PROTOCOL:
                     {
-                        startbit_pulse_len          = FDC_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = FDC_START_BIT_PAUSE_LEN - 1;
-                        complete_data_len           = FDC_COMPLETE_DATA_LEN;
-                        pulse_1_len                 = FDC_PULSE_LEN;
-                        pause_1_len                 = FDC_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = FDC_PULSE_LEN;
-                        pause_0_len                 = FDC_0_PAUSE_LEN - 1;
-                        has_stop_bit                = FDC_STOP_BIT;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = FDC_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = FDC_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = FDC_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.complete_data_len           = FDC_COMPLETE_DATA_LEN;
+                        irsnd_state.pulse_1_len                 = FDC_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = FDC_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = FDC_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = FDC_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = FDC_STOP_BIT;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = FDC_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_RCCAR_PROTOCOL == 1
                     case IRMP_RCCAR_PROTOCOL:
                     {
-                        startbit_pulse_len          = RCCAR_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = RCCAR_START_BIT_PAUSE_LEN - 1;
-                        complete_data_len           = RCCAR_COMPLETE_DATA_LEN;
-                        pulse_1_len                 = RCCAR_PULSE_LEN;
-                        pause_1_len                 = RCCAR_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = RCCAR_PULSE_LEN;
-                        pause_0_len                 = RCCAR_0_PAUSE_LEN - 1;
-                        has_stop_bit                = RCCAR_STOP_BIT;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = RCCAR_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = RCCAR_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = RCCAR_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.complete_data_len           = RCCAR_COMPLETE_DATA_LEN;
+                        irsnd_state.pulse_1_len                 = RCCAR_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = RCCAR_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = RCCAR_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = RCCAR_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = RCCAR_STOP_BIT;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = RCCAR_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_JVC_PROTOCOL == 1
                     case IRMP_JVC_PROTOCOL:
                     {
-                        if (repeat_counter != 0)                                                    // skip start bit if repetition frame
+                        if (irsnd_state.repeat_counter != 0)                                                    // skip start bit if repetition frame
                         {
-                            current_bit = 0;
+                            irsnd_state.current_bit = 0;
                         }
 
-                        startbit_pulse_len          = JVC_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = JVC_START_BIT_PAUSE_LEN - 1;
-                        complete_data_len           = JVC_COMPLETE_DATA_LEN;
-                        pulse_1_len                 = JVC_PULSE_LEN;
-                        pause_1_len                 = JVC_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = JVC_PULSE_LEN;
-                        pause_0_len                 = JVC_0_PAUSE_LEN - 1;
-                        has_stop_bit                = JVC_STOP_BIT;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = JVC_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = JVC_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = JVC_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.complete_data_len           = JVC_COMPLETE_DATA_LEN;
+                        irsnd_state.pulse_1_len                 = JVC_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = JVC_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = JVC_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = JVC_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = JVC_STOP_BIT;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = JVC_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_NIKON_PROTOCOL == 1
                     case IRMP_NIKON_PROTOCOL:
                     {
-                        startbit_pulse_len          = NIKON_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = NIKON_START_BIT_PAUSE_LEN;
-                        complete_data_len           = NIKON_COMPLETE_DATA_LEN;
-                        pulse_1_len                 = NIKON_PULSE_LEN;
-                        pause_1_len                 = NIKON_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = NIKON_PULSE_LEN;
-                        pause_0_len                 = NIKON_0_PAUSE_LEN - 1;
-                        has_stop_bit                = NIKON_STOP_BIT;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = NIKON_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = NIKON_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = NIKON_START_BIT_PAUSE_LEN;
+                        irsnd_state.complete_data_len           = NIKON_COMPLETE_DATA_LEN;
+                        irsnd_state.pulse_1_len                 = NIKON_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = NIKON_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = NIKON_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = NIKON_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = NIKON_STOP_BIT;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = NIKON_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_LEGO_PROTOCOL == 1
                     case IRMP_LEGO_PROTOCOL:
                     {
-                        startbit_pulse_len          = LEGO_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = LEGO_START_BIT_PAUSE_LEN - 1;
-                        complete_data_len           = LEGO_COMPLETE_DATA_LEN;
-                        pulse_1_len                 = LEGO_PULSE_LEN;
-                        pause_1_len                 = LEGO_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = LEGO_PULSE_LEN;
-                        pause_0_len                 = LEGO_0_PAUSE_LEN - 1;
-                        has_stop_bit                = LEGO_STOP_BIT;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = LEGO_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = LEGO_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = LEGO_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.complete_data_len           = LEGO_COMPLETE_DATA_LEN;
+                        irsnd_state.pulse_1_len                 = LEGO_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = LEGO_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = LEGO_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = LEGO_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = LEGO_STOP_BIT;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = LEGO_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_A1TVBOX_PROTOCOL == 1
                     case IRMP_A1TVBOX_PROTOCOL:
                     {
-                        startbit_pulse_len          = A1TVBOX_BIT_PULSE_LEN;                        // don't use A1TVBOX_START_BIT_PULSE_LEN
-                        startbit_pause_len          = A1TVBOX_BIT_PAUSE_LEN;                        // don't use A1TVBOX_START_BIT_PAUSE_LEN
-                        pulse_len                   = A1TVBOX_BIT_PULSE_LEN;
-                        pause_len                   = A1TVBOX_BIT_PAUSE_LEN;
-                        has_stop_bit                = A1TVBOX_STOP_BIT;
-                        complete_data_len           = A1TVBOX_COMPLETE_DATA_LEN + 1;                // we send stop bit as data
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = A1TVBOX_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = A1TVBOX_BIT_PULSE_LEN;                        // don't use A1TVBOX_START_BIT_PULSE_LEN
+                        irsnd_state.startbit_pause_len          = A1TVBOX_BIT_PAUSE_LEN;                        // don't use A1TVBOX_START_BIT_PAUSE_LEN
+                        irsnd_state.pulse_len                   = A1TVBOX_BIT_PULSE_LEN;
+                        irsnd_state.pause_len                   = A1TVBOX_BIT_PAUSE_LEN;
+                        irsnd_state.has_stop_bit                = A1TVBOX_STOP_BIT;
+                        irsnd_state.complete_data_len           = A1TVBOX_COMPLETE_DATA_LEN + 1;                // we send stop bit as data
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = A1TVBOX_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_ROOMBA_PROTOCOL == 1
                     case IRMP_ROOMBA_PROTOCOL:
                     {
-                        startbit_pulse_len          = ROOMBA_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = ROOMBA_START_BIT_PAUSE_LEN;
-                        pulse_1_len                 = ROOMBA_1_PULSE_LEN;
-                        pause_1_len                 = ROOMBA_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = ROOMBA_0_PULSE_LEN;
-                        pause_0_len                 = ROOMBA_0_PAUSE_LEN - 1;
-                        has_stop_bit                = ROOMBA_STOP_BIT;
-                        complete_data_len           = ROOMBA_COMPLETE_DATA_LEN;
-                        n_auto_repetitions          = ROOMBA_FRAMES;                                // 8 frames
-                        auto_repetition_pause_len   = ROOMBA_FRAME_REPEAT_PAUSE_LEN;
-                        repeat_frame_pause_len      = ROOMBA_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = ROOMBA_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = ROOMBA_START_BIT_PAUSE_LEN;
+                        irsnd_state.pulse_1_len                 = ROOMBA_1_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = ROOMBA_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = ROOMBA_0_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = ROOMBA_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = ROOMBA_STOP_BIT;
+                        irsnd_state.complete_data_len           = ROOMBA_COMPLETE_DATA_LEN;
+                        irsnd_state.n_auto_repetitions          = ROOMBA_FRAMES;                                // 8 frames
+                        irsnd_state.auto_repetition_pause_len   = ROOMBA_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.repeat_frame_pause_len      = ROOMBA_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_PENTAX_PROTOCOL == 1
                     case IRMP_PENTAX_PROTOCOL:
                     {
-                        startbit_pulse_len          = PENTAX_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = PENTAX_START_BIT_PAUSE_LEN;
-                        complete_data_len           = PENTAX_COMPLETE_DATA_LEN;
-                        pulse_1_len                 = PENTAX_PULSE_LEN;
-                        pause_1_len                 = PENTAX_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = PENTAX_PULSE_LEN;
-                        pause_0_len                 = PENTAX_0_PAUSE_LEN - 1;
-                        has_stop_bit                = PENTAX_STOP_BIT;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = PENTAX_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = PENTAX_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = PENTAX_START_BIT_PAUSE_LEN;
+                        irsnd_state.complete_data_len           = PENTAX_COMPLETE_DATA_LEN;
+                        irsnd_state.pulse_1_len                 = PENTAX_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = PENTAX_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = PENTAX_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = PENTAX_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = PENTAX_STOP_BIT;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = PENTAX_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
 #if IRSND_SUPPORT_ACP24_PROTOCOL == 1
                     case IRMP_ACP24_PROTOCOL:
                     {
-                        startbit_pulse_len          = ACP24_START_BIT_PULSE_LEN;
-                        startbit_pause_len          = ACP24_START_BIT_PAUSE_LEN - 1;
-                        complete_data_len           = ACP24_COMPLETE_DATA_LEN;
-                        pulse_1_len                 = ACP24_PULSE_LEN;
-                        pause_1_len                 = ACP24_1_PAUSE_LEN - 1;
-                        pulse_0_len                 = ACP24_PULSE_LEN;
-                        pause_0_len                 = ACP24_0_PAUSE_LEN - 1;
-                        has_stop_bit                = ACP24_STOP_BIT;
-                        n_auto_repetitions          = 1;                                            // 1 frame
-                        auto_repetition_pause_len   = 0;
-                        repeat_frame_pause_len      = ACP24_FRAME_REPEAT_PAUSE_LEN;
-                        irsnd_set_freq (IRSND_FREQ_38_KHZ);
+                        irsnd_state.startbit_pulse_len          = ACP24_START_BIT_PULSE_LEN;
+                        irsnd_state.startbit_pause_len          = ACP24_START_BIT_PAUSE_LEN - 1;
+                        irsnd_state.complete_data_len           = ACP24_COMPLETE_DATA_LEN;
+                        irsnd_state.pulse_1_len                 = ACP24_PULSE_LEN;
+                        irsnd_state.pause_1_len                 = ACP24_1_PAUSE_LEN - 1;
+                        irsnd_state.pulse_0_len                 = ACP24_PULSE_LEN;
+                        irsnd_state.pause_0_len                 = ACP24_0_PAUSE_LEN - 1;
+                        irsnd_state.has_stop_bit                = ACP24_STOP_BIT;
+                        irsnd_state.n_auto_repetitions          = 1;                                            // 1 frame
+                        irsnd_state.auto_repetition_pause_len   = 0;
+                        irsnd_state.repeat_frame_pause_len      = ACP24_FRAME_REPEAT_PAUSE_LEN;
+                        irsnd_state.freq                        = IRSND_FREQ_38_KHZ;
                         break;
                     }
 #endif
                     default:
                     {
-                        irsnd_busy = FALSE;
+                        irsnd_state.busy = FALSE;
                         break;
                     }
                 }
             }
         }
 
-        if (irsnd_busy)
+        if (irsnd_state.busy)
         {
-            new_frame = FALSE;
+            irsnd_state.new_frame = FALSE;
 
             switch (irsnd_protocol)
             {
@@ -2576,35 +2745,35 @@ irsnd_ISR (void)
     IRSND_SUPPORT_LEGO_PROTOCOL == 1 || IRSND_SUPPORT_THOMSON_PROTOCOL == 1 || IRSND_SUPPORT_ROOMBA_PROTOCOL == 1 || IRSND_SUPPORT_TELEFUNKEN_PROTOCOL == 1 || \
     IRSND_SUPPORT_PENTAX_PROTOCOL == 1 || IRSND_SUPPORT_ACP24_PROTOCOL == 1 || IRSND_SUPPORT_PANASONIC_PROTOCOL == 1 || IRSND_SUPPORT_BOSE_PROTOCOL == 1
                 {
-                    if (pulse_counter == 0)
+                    if (irsnd_state.pulse_counter == 0)
                     {
-                        if (current_bit == 0xFF)                                                    // send start bit
+                        if (irsnd_state.current_bit == 0xFF)                                                    // send start bit
                         {
-                            pulse_len = startbit_pulse_len;
-                            pause_len = startbit_pause_len;
+                            irsnd_state.pulse_len = irsnd_state.startbit_pulse_len;
+                            irsnd_state.pause_len = irsnd_state.startbit_pause_len;
                         }
-                        else if (current_bit < complete_data_len)                                   // send n'th bit
+                        else if (irsnd_state.current_bit < irsnd_state.complete_data_len)                                   // send n'th bit
                         {
 #if IRSND_SUPPORT_SAMSUNG_PROTOCOL == 1
                             if (irsnd_protocol == IRMP_SAMSUNG_PROTOCOL)
                             {
-                                if (current_bit < SAMSUNG_ADDRESS_LEN)                              // send address bits
+                                if (irsnd_state.current_bit < SAMSUNG_ADDRESS_LEN)                              // send address bits
                                 {
-                                    pulse_len = SAMSUNG_PULSE_LEN;
-                                    pause_len = (irsnd_buffer[current_bit >> 3] & (1<<(7-(current_bit & 7)))) ?
+                                    irsnd_state.pulse_len = SAMSUNG_PULSE_LEN;
+                                    irsnd_state.pause_len = (irsnd_buffer[irsnd_state.current_bit >> 3] & (1<<(7-(irsnd_state.current_bit & 7)))) ?
                                                     (SAMSUNG_1_PAUSE_LEN - 1) : (SAMSUNG_0_PAUSE_LEN - 1);
                                 }
-                                else if (current_bit == SAMSUNG_ADDRESS_LEN)                        // send SYNC bit (16th bit)
+                                else if (irsnd_state.current_bit == SAMSUNG_ADDRESS_LEN)                        // send SYNC bit (16th bit)
                                 {
-                                    pulse_len = SAMSUNG_PULSE_LEN;
-                                    pause_len = SAMSUNG_START_BIT_PAUSE_LEN - 1;
+                                    irsnd_state.pulse_len = SAMSUNG_PULSE_LEN;
+                                    irsnd_state.pause_len = SAMSUNG_START_BIT_PAUSE_LEN - 1;
                                 }
-                                else if (current_bit < SAMSUNG_COMPLETE_DATA_LEN)                   // send n'th bit
+                                else if (irsnd_state.current_bit < SAMSUNG_COMPLETE_DATA_LEN)                   // send n'th bit
                                 {
-                                    uint8_t cur_bit = current_bit - 1;                              // sync skipped, offset = -1 !
+                                    uint8_t cur_bit = irsnd_state.current_bit - 1;                              // sync skipped, offset = -1 !
 
-                                    pulse_len = SAMSUNG_PULSE_LEN;
-                                    pause_len = (irsnd_buffer[cur_bit >> 3] & (1<<(7-(cur_bit & 7)))) ?
+                                    irsnd_state.pulse_len = SAMSUNG_PULSE_LEN;
+                                    irsnd_state.pause_len = (irsnd_buffer[cur_bit >> 3] & (1<<(7-(cur_bit & 7)))) ?
                                                     (SAMSUNG_1_PAUSE_LEN - 1) : (SAMSUNG_0_PAUSE_LEN - 1);
                                 }
                             }
@@ -2614,23 +2783,23 @@ irsnd_ISR (void)
 #if IRSND_SUPPORT_NEC16_PROTOCOL == 1
                             if (irsnd_protocol == IRMP_NEC16_PROTOCOL)
                             {
-                                if (current_bit < NEC16_ADDRESS_LEN)                                // send address bits
+                                if (irsnd_state.current_bit < NEC16_ADDRESS_LEN)                                // send address bits
                                 {
-                                    pulse_len = NEC_PULSE_LEN;
-                                    pause_len = (irsnd_buffer[current_bit >> 3] & (1<<(7-(current_bit & 7)))) ?
+                                    irsnd_state.pulse_len = NEC_PULSE_LEN;
+                                    irsnd_state.pause_len = (irsnd_buffer[irsnd_state.current_bit >> 3] & (1<<(7-(irsnd_state.current_bit & 7)))) ?
                                                     (NEC_1_PAUSE_LEN - 1) : (NEC_0_PAUSE_LEN - 1);
                                 }
-                                else if (current_bit == NEC16_ADDRESS_LEN)                          // send SYNC bit (8th bit)
+                                else if (irsnd_state.current_bit == NEC16_ADDRESS_LEN)                          // send SYNC bit (8th bit)
                                 {
-                                    pulse_len = NEC_PULSE_LEN;
-                                    pause_len = NEC_START_BIT_PAUSE_LEN - 1;
+                                    irsnd_state.pulse_len = NEC_PULSE_LEN;
+                                    irsnd_state.pause_len = NEC_START_BIT_PAUSE_LEN - 1;
                                 }
-                                else if (current_bit < NEC16_COMPLETE_DATA_LEN + 1)                 // send n'th bit
+                                else if (irsnd_state.current_bit < NEC16_COMPLETE_DATA_LEN + 1)                 // send n'th bit
                                 {
-                                    uint8_t cur_bit = current_bit - 1;                              // sync skipped, offset = -1 !
+                                    uint8_t cur_bit = irsnd_state.current_bit - 1;                              // sync skipped, offset = -1 !
 
-                                    pulse_len = NEC_PULSE_LEN;
-                                    pause_len = (irsnd_buffer[cur_bit >> 3] & (1<<(7-(cur_bit & 7)))) ?
+                                    irsnd_state.pulse_len = NEC_PULSE_LEN;
+                                    irsnd_state.pause_len = (irsnd_buffer[cur_bit >> 3] & (1<<(7-(cur_bit & 7)))) ?
                                                     (NEC_1_PAUSE_LEN - 1) : (NEC_0_PAUSE_LEN - 1);
                                 }
                             }
@@ -2640,105 +2809,105 @@ irsnd_ISR (void)
 #if IRSND_SUPPORT_BANG_OLUFSEN_PROTOCOL == 1
                             if (irsnd_protocol == IRMP_BANG_OLUFSEN_PROTOCOL)
                             {
-                                if (current_bit == 0)                                               // send 2nd start bit
+                                if (irsnd_state.current_bit == 0)                                               // send 2nd start bit
                                 {
-                                    pulse_len = BANG_OLUFSEN_START_BIT2_PULSE_LEN;
-                                    pause_len = BANG_OLUFSEN_START_BIT2_PAUSE_LEN - 1;
+                                    irsnd_state.pulse_len = BANG_OLUFSEN_START_BIT2_PULSE_LEN;
+                                    irsnd_state.pause_len = BANG_OLUFSEN_START_BIT2_PAUSE_LEN - 1;
                                 }
-                                else if (current_bit == 1)                                          // send 3rd start bit
+                                else if (irsnd_state.current_bit == 1)                                          // send 3rd start bit
                                 {
-                                    pulse_len = BANG_OLUFSEN_START_BIT3_PULSE_LEN;
-                                    pause_len = BANG_OLUFSEN_START_BIT3_PAUSE_LEN - 1;
+                                    irsnd_state.pulse_len = BANG_OLUFSEN_START_BIT3_PULSE_LEN;
+                                    irsnd_state.pause_len = BANG_OLUFSEN_START_BIT3_PAUSE_LEN - 1;
                                 }
-                                else if (current_bit == 2)                                          // send 4th start bit
+                                else if (irsnd_state.current_bit == 2)                                          // send 4th start bit
                                 {
-                                    pulse_len = BANG_OLUFSEN_START_BIT2_PULSE_LEN;
-                                    pause_len = BANG_OLUFSEN_START_BIT2_PAUSE_LEN - 1;
+                                    irsnd_state.pulse_len = BANG_OLUFSEN_START_BIT2_PULSE_LEN;
+                                    irsnd_state.pause_len = BANG_OLUFSEN_START_BIT2_PAUSE_LEN - 1;
                                 }
-                                else if (current_bit == 19)                                          // send trailer bit
+                                else if (irsnd_state.current_bit == 19)                                          // send trailer bit
                                 {
-                                    pulse_len = BANG_OLUFSEN_PULSE_LEN;
-                                    pause_len = BANG_OLUFSEN_TRAILER_BIT_PAUSE_LEN - 1;
+                                    irsnd_state.pulse_len = BANG_OLUFSEN_PULSE_LEN;
+                                    irsnd_state.pause_len = BANG_OLUFSEN_TRAILER_BIT_PAUSE_LEN - 1;
                                 }
-                                else if (current_bit < BANG_OLUFSEN_COMPLETE_DATA_LEN)              // send n'th bit
+                                else if (irsnd_state.current_bit < BANG_OLUFSEN_COMPLETE_DATA_LEN)              // send n'th bit
                                 {
-                                    uint8_t cur_bit_value = (irsnd_buffer[current_bit >> 3] & (1<<(7-(current_bit & 7)))) ? 1 : 0;
-                                    pulse_len = BANG_OLUFSEN_PULSE_LEN;
+                                    uint8_t cur_bit_value = (irsnd_buffer[irsnd_state.current_bit >> 3] & (1<<(7-(irsnd_state.current_bit & 7)))) ? 1 : 0;
+                                    irsnd_state.pulse_len = BANG_OLUFSEN_PULSE_LEN;
 
-                                    if (cur_bit_value == last_bit_value)
+                                    if (cur_bit_value == irsnd_state.last_bit_value)
                                     {
-                                        pause_len = BANG_OLUFSEN_R_PAUSE_LEN - 1;
+                                        irsnd_state.pause_len = BANG_OLUFSEN_R_PAUSE_LEN - 1;
                                     }
                                     else
                                     {
-                                        pause_len = cur_bit_value ? (BANG_OLUFSEN_1_PAUSE_LEN - 1) : (BANG_OLUFSEN_0_PAUSE_LEN - 1);
-                                        last_bit_value = cur_bit_value;
+                                        irsnd_state.pause_len = cur_bit_value ? (BANG_OLUFSEN_1_PAUSE_LEN - 1) : (BANG_OLUFSEN_0_PAUSE_LEN - 1);
+                                        irsnd_state.last_bit_value = cur_bit_value;
                                     }
                                 }
                             }
                             else
 #endif
-                            if (irsnd_buffer[current_bit >> 3] & (1<<(7-(current_bit & 7))))
+                            if (irsnd_buffer[irsnd_state.current_bit >> 3] & (1<<(7-(irsnd_state.current_bit & 7))))
                             {
-                                pulse_len = pulse_1_len;
-                                pause_len = pause_1_len;
+                                irsnd_state.pulse_len = irsnd_state.pulse_1_len;
+                                irsnd_state.pause_len = irsnd_state.pause_1_len;
                             }
                             else
                             {
-                                pulse_len = pulse_0_len;
-                                pause_len = pause_0_len;
+                                irsnd_state.pulse_len = irsnd_state.pulse_0_len;
+                                irsnd_state.pause_len = irsnd_state.pause_0_len;
                             }
                         }
-                        else if (has_stop_bit)                                                                      // send stop bit
+                        else if (irsnd_state.has_stop_bit)                                                                      // send stop bit
                         {
-                            pulse_len = pulse_0_len;
+                            irsnd_state.pulse_len = irsnd_state.pulse_0_len;
 
-                            if (auto_repetition_counter < n_auto_repetitions)
+                            if (irsnd_state.auto_repetition_counter < irsnd_state.n_auto_repetitions)
                             {
-                                pause_len = pause_0_len;
+                                irsnd_state.pause_len = irsnd_state.pause_0_len;
                             }
                             else
                             {
-                                pause_len = 255;                                        // last frame: pause of 255
+                                irsnd_state.pause_len = 255;                                        // last frame: pause of 255
                             }
                         }
                     }
 
-                    if (pulse_counter < pulse_len)
+                    if (irsnd_state.pulse_counter < irsnd_state.pulse_len)
                     {
-                        if (pulse_counter == 0)
+                        if (irsnd_state.pulse_counter == 0)
                         {
-                            irsnd_on ();
+                            irsnd_state.is_on = TRUE;
                         }
-                        pulse_counter++;
+                        irsnd_state.pulse_counter++;
                     }
-                    else if (pause_counter < pause_len)
+                    else if (irsnd_state.pause_counter < irsnd_state.pause_len)
                     {
-                        if (pause_counter == 0)
+                        if (irsnd_state.pause_counter == 0)
                         {
-                            irsnd_off ();
+                            irsnd_state.is_on = FALSE;
                         }
-                        pause_counter++;
+                        irsnd_state.pause_counter++;
                     }
                     else
                     {
-                        current_bit++;
+                        irsnd_state.current_bit++;
 
-                        if (current_bit >= complete_data_len + has_stop_bit)
+                        if (irsnd_state.current_bit >= irsnd_state.complete_data_len + irsnd_state.has_stop_bit)
                         {
-                            current_bit = 0xFF;
-                            auto_repetition_counter++;
+                            irsnd_state.current_bit = 0xFF;
+                            irsnd_state.auto_repetition_counter++;
 
-                            if (auto_repetition_counter == n_auto_repetitions)
+                            if (irsnd_state.auto_repetition_counter == irsnd_state.n_auto_repetitions)
                             {
-                                irsnd_busy = FALSE;
-                                auto_repetition_counter = 0;
+                                irsnd_state.busy = FALSE;
+                                irsnd_state.auto_repetition_counter = 0;
                             }
-                            new_frame = TRUE;
+                            irsnd_state.new_frame = TRUE;
                         }
 
-                        pulse_counter = 0;
-                        pause_counter = 0;
+                        irsnd_state.pulse_counter = 0;
+                        irsnd_state.pause_counter = 0;
                     }
                     break;
                 }
@@ -2782,90 +2951,90 @@ irsnd_ISR (void)
     IRSND_SUPPORT_NOKIA_PROTOCOL    == 1 || \
     IRSND_SUPPORT_A1TVBOX_PROTOCOL  == 1
                 {
-                    if (pulse_counter == pulse_len && pause_counter == pause_len)
+                    if (irsnd_state.pulse_counter == irsnd_state.pulse_len && irsnd_state.pause_counter == irsnd_state.pause_len)
                     {
-                        current_bit++;
+                        irsnd_state.current_bit++;
 
-                        if (current_bit >= complete_data_len)
+                        if (irsnd_state.current_bit >= irsnd_state.complete_data_len)
                         {
-                            current_bit = 0xFF;
+                            irsnd_state.current_bit = 0xFF;
 
 #if IRSND_SUPPORT_GRUNDIG_PROTOCOL == 1 || IRSND_SUPPORT_IR60_PROTOCOL == 1 || IRSND_SUPPORT_NOKIA_PROTOCOL == 1
                             if (irsnd_protocol == IRMP_GRUNDIG_PROTOCOL || irsnd_protocol == IRMP_IR60_PROTOCOL || irsnd_protocol == IRMP_NOKIA_PROTOCOL)
                             {
-                                auto_repetition_counter++;
+                                irsnd_state.auto_repetition_counter++;
 
-                                if (repeat_counter > 0)
+                                if (irsnd_state.repeat_counter > 0)
                                 {                                       // set 117 msec pause time
-                                    auto_repetition_pause_len = GRUNDIG_NOKIA_IR60_FRAME_REPEAT_PAUSE_LEN;
+                                    irsnd_state.auto_repetition_pause_len = GRUNDIG_NOKIA_IR60_FRAME_REPEAT_PAUSE_LEN;
                                 }
 
-                                if (repeat_counter < n_repeat_frames)       // tricky: repeat n info frames per auto repetition before sending last stop frame
+                                if (irsnd_state.repeat_counter < irsnd_state.n_repeat_frames)       // tricky: repeat n info frames per auto repetition before sending last stop frame
                                 {
-                                    n_auto_repetitions++;                   // increment number of auto repetitions
-                                    repeat_counter++;
+                                    irsnd_state.n_auto_repetitions++;                   // increment number of auto repetitions
+                                    irsnd_state.repeat_counter++;
                                 }
-                                else if (auto_repetition_counter == n_auto_repetitions)
+                                else if (irsnd_state.auto_repetition_counter == irsnd_state.n_auto_repetitions)
                                 {
-                                    irsnd_busy = FALSE;
-                                    auto_repetition_counter = 0;
+                                    irsnd_state.busy = FALSE;
+                                    irsnd_state.auto_repetition_counter = 0;
                                 }
                             }
                             else
 #endif
                             {
-                                irsnd_busy  = FALSE;
+                                irsnd_state.busy  = FALSE;
                             }
 
-                            new_frame = TRUE;
-                            irsnd_off ();
+                            irsnd_state.new_frame = TRUE;
+                            irsnd_state.is_on = FALSE;
                         }
 
-                        pulse_counter = 0;
-                        pause_counter = 0;
+                        irsnd_state.pulse_counter = 0;
+                        irsnd_state.pause_counter = 0;
                     }
 
-                    if (! new_frame)
+                    if (! irsnd_state.new_frame)
                     {
                         uint8_t first_pulse;
 
 #if IRSND_SUPPORT_GRUNDIG_PROTOCOL == 1 || IRSND_SUPPORT_IR60_PROTOCOL == 1 || IRSND_SUPPORT_NOKIA_PROTOCOL == 1
                         if (irsnd_protocol == IRMP_GRUNDIG_PROTOCOL || irsnd_protocol == IRMP_IR60_PROTOCOL || irsnd_protocol == IRMP_NOKIA_PROTOCOL)
                         {
-                            if (current_bit == 0xFF ||                                                                  // start bit of start-frame
-                                (irsnd_protocol == IRMP_GRUNDIG_PROTOCOL && current_bit == 15) ||                       // start bit of info-frame (Grundig)
-                                (irsnd_protocol == IRMP_IR60_PROTOCOL && current_bit == 7) ||                           // start bit of data frame (IR60)
-                                (irsnd_protocol == IRMP_NOKIA_PROTOCOL && (current_bit == 23 || current_bit == 47)))    // start bit of info- or stop-frame (Nokia)
+                            if (irsnd_state.current_bit == 0xFF ||                                                                  // start bit of start-frame
+                                (irsnd_protocol == IRMP_GRUNDIG_PROTOCOL && irsnd_state.current_bit == 15) ||                       // start bit of info-frame (Grundig)
+                                (irsnd_protocol == IRMP_IR60_PROTOCOL && irsnd_state.current_bit == 7) ||                           // start bit of data frame (IR60)
+                                (irsnd_protocol == IRMP_NOKIA_PROTOCOL && (irsnd_state.current_bit == 23 || irsnd_state.current_bit == 47)))    // start bit of info- or stop-frame (Nokia)
                             {
-                                pulse_len = startbit_pulse_len;
-                                pause_len = startbit_pause_len;
+                                irsnd_state.pulse_len = irsnd_state.startbit_pulse_len;
+                                irsnd_state.pause_len = irsnd_state.startbit_pause_len;
                                 first_pulse = TRUE;
                             }
                             else                                                                        // send n'th bit
                             {
-                                pulse_len = GRUNDIG_NOKIA_IR60_BIT_LEN;
-                                pause_len = GRUNDIG_NOKIA_IR60_BIT_LEN;
-                                first_pulse = (irsnd_buffer[current_bit >> 3] & (1<<(7-(current_bit & 7)))) ? TRUE : FALSE;
+                                irsnd_state.pulse_len = GRUNDIG_NOKIA_IR60_BIT_LEN;
+                                irsnd_state.pause_len = GRUNDIG_NOKIA_IR60_BIT_LEN;
+                                first_pulse = (irsnd_buffer[irsnd_state.current_bit >> 3] & (1<<(7-(irsnd_state.current_bit & 7)))) ? TRUE : FALSE;
                             }
                         }
                         else // if (irsnd_protocol == IRMP_RC5_PROTOCOL || irsnd_protocol == IRMP_RC6_PROTOCOL || irsnd_protocol == IRMP_RC6A_PROTOCOL ||
                              //     irsnd_protocol == IRMP_SIEMENS_PROTOCOL || irsnd_protocol == IRMP_RUWIDO_PROTOCOL)
 #endif
                         {
-                            if (current_bit == 0xFF)                                                    // 1 start bit
+                            if (irsnd_state.current_bit == 0xFF)                                                    // 1 start bit
                             {
 #if IRSND_SUPPORT_RC6_PROTOCOL == 1 || IRSND_SUPPORT_RC6A_PROTOCOL == 1
                                 if (irsnd_protocol == IRMP_RC6_PROTOCOL || irsnd_protocol == IRMP_RC6A_PROTOCOL)
                                 {
-                                    pulse_len = startbit_pulse_len;
-                                    pause_len = startbit_pause_len;
+                                    irsnd_state.pulse_len = irsnd_state.startbit_pulse_len;
+                                    irsnd_state.pause_len = irsnd_state.startbit_pause_len;
                                 }
                                 else
 #endif
 #if IRSND_SUPPORT_A1TVBOX_PROTOCOL == 1
                                 if (irsnd_protocol == IRMP_A1TVBOX_PROTOCOL)
                                 {
-                                    current_bit = 0;
+                                    irsnd_state.current_bit = 0;
                                 }
                                 else
 #endif
@@ -2880,32 +3049,32 @@ irsnd_ISR (void)
 #if IRSND_SUPPORT_RC6_PROTOCOL == 1 || IRSND_SUPPORT_RC6A_PROTOCOL == 1
                                 if (irsnd_protocol == IRMP_RC6_PROTOCOL || irsnd_protocol == IRMP_RC6A_PROTOCOL)
                                 {
-                                    pulse_len = RC6_BIT_LEN;
-                                    pause_len = RC6_BIT_LEN;
+                                    irsnd_state.pulse_len = RC6_BIT_LEN;
+                                    irsnd_state.pause_len = RC6_BIT_LEN;
 
                                     if (irsnd_protocol == IRMP_RC6_PROTOCOL)
                                     {
-                                        if (current_bit == 4)                                           // toggle bit (double len)
+                                        if (irsnd_state.current_bit == 4)                                           // toggle bit (double len)
                                         {
-                                            pulse_len = RC6_BIT_2_LEN;                                  // = 2 * RC_BIT_LEN
-                                            pause_len = RC6_BIT_2_LEN;                                  // = 2 * RC_BIT_LEN
+                                            irsnd_state.pulse_len = RC6_BIT_2_LEN;                                  // = 2 * RC_BIT_LEN
+                                            irsnd_state.pause_len = RC6_BIT_2_LEN;                                  // = 2 * RC_BIT_LEN
                                         }
                                     }
                                     else // if (irsnd_protocol == IRMP_RC6A_PROTOCOL)
                                     {
-                                        if (current_bit == 4)                                           // toggle bit (double len)
+                                        if (irsnd_state.current_bit == 4)                                           // toggle bit (double len)
                                         {
-                                            pulse_len = RC6_BIT_3_LEN;                                  // = 3 * RC6_BIT_LEN
-                                            pause_len = RC6_BIT_2_LEN;                                  // = 2 * RC6_BIT_LEN
+                                            irsnd_state.pulse_len = RC6_BIT_3_LEN;                                  // = 3 * RC6_BIT_LEN
+                                            irsnd_state.pause_len = RC6_BIT_2_LEN;                                  // = 2 * RC6_BIT_LEN
                                         }
-                                        else if (current_bit == 5)                                      // toggle bit (double len)
+                                        else if (irsnd_state.current_bit == 5)                                      // toggle bit (double len)
                                         {
-                                            pause_len = RC6_BIT_2_LEN;                                  // = 2 * RC6_BIT_LEN
+                                            irsnd_state.pause_len = RC6_BIT_2_LEN;                                  // = 2 * RC6_BIT_LEN
                                         }
                                     }
                                 }
 #endif
-                                first_pulse = (irsnd_buffer[current_bit >> 3] & (1<<(7-(current_bit & 7)))) ? TRUE : FALSE;
+                                first_pulse = (irsnd_buffer[irsnd_state.current_bit >> 3] & (1<<(7-(irsnd_state.current_bit & 7)))) ? TRUE : FALSE;
                             }
 
                             if (irsnd_protocol == IRMP_RC5_PROTOCOL)
@@ -2916,44 +3085,44 @@ irsnd_ISR (void)
 
                         if (first_pulse)
                         {
-                            // printf ("first_pulse: current_bit: %d  %d < %d  %d < %d\n", current_bit, pause_counter, pause_len, pulse_counter, pulse_len);
+                            // printf ("first_pulse: irsnd_state.current_bit: %d  %d < %d  %d < %d\n", irsnd_state.current_bit, irsnd_state.pause_counter, irsnd_state.pause_len, irsnd_state.pulse_counter, irsnd_state.pulse_len);
 
-                            if (pulse_counter < pulse_len)
+                            if (irsnd_state.pulse_counter < irsnd_state.pulse_len)
                             {
-                                if (pulse_counter == 0)
+                                if (irsnd_state.pulse_counter == 0)
                                 {
-                                    irsnd_on ();
+                                    irsnd_state.is_on = TRUE;
                                 }
-                                pulse_counter++;
+                                irsnd_state.pulse_counter++;
                             }
-                            else // if (pause_counter < pause_len)
+                            else // if (irsnd_state.pause_counter < irsnd_state.pause_len)
                             {
-                                if (pause_counter == 0)
+                                if (irsnd_state.pause_counter == 0)
                                 {
-                                    irsnd_off ();
+                                    irsnd_state.is_on = FALSE;
                                 }
-                                pause_counter++;
+                                irsnd_state.pause_counter++;
                             }
                         }
                         else
                         {
-                            // printf ("first_pause: current_bit: %d  %d < %d  %d < %d\n", current_bit, pause_counter, pause_len, pulse_counter, pulse_len);
+                            // printf ("first_pause: irsnd_state.current_bit: %d  %d < %d  %d < %d\n", irsnd_state.current_bit, irsnd_state.pause_counter, irsnd_state.pause_len, irsnd_state.pulse_counter, irsnd_state.pulse_len);
 
-                            if (pause_counter < pause_len)
+                            if (irsnd_state.pause_counter < irsnd_state.pause_len)
                             {
-                                if (pause_counter == 0)
+                                if (irsnd_state.pause_counter == 0)
                                 {
-                                    irsnd_off ();
+                                    irsnd_state.is_on = FALSE;
                                 }
-                                pause_counter++;
+                                irsnd_state.pause_counter++;
                             }
-                            else // if (pulse_counter < pulse_len)
+                            else // if (irsnd_state.pulse_counter < irsnd_state.pulse_len)
                             {
-                                if (pulse_counter == 0)
+                                if (irsnd_state.pulse_counter == 0)
                                 {
-                                    irsnd_on ();
+                                    irsnd_state.is_on = TRUE;
                                 }
-                                pulse_counter++;
+                                irsnd_state.pulse_counter++;
                             }
                         }
                     }
@@ -2964,15 +3133,15 @@ irsnd_ISR (void)
 
                 default:
                 {
-                    irsnd_busy = FALSE;
+                    irsnd_state.busy = FALSE;
                     break;
                 }
             }
         }
 
-        if (! irsnd_busy)
+        if (! irsnd_state.busy)
         {
-            if (repeat_counter < n_repeat_frames)
+            if (irsnd_state.repeat_counter < irsnd_state.n_repeat_frames)
             {
 #if IRSND_SUPPORT_FDC_PROTOCOL == 1
                 if (irsnd_protocol == IRMP_FDC_PROTOCOL)
@@ -2980,19 +3149,442 @@ irsnd_ISR (void)
                     irsnd_buffer[2] |= 0x0F;
                 }
 #endif
-                repeat_counter++;
-                irsnd_busy = TRUE;
+                irsnd_state.repeat_counter++;
+                irsnd_state.busy = TRUE;
             }
             else
             {
-                irsnd_busy = TRUE; //Rainer
-                send_trailer = TRUE;
-                n_repeat_frames = 0;
-                repeat_counter = 0;
+                irsnd_state.busy = TRUE; //Rainer
+                irsnd_state.send_trailer = TRUE;
+                irsnd_state.n_repeat_frames = 0;
+                irsnd_state.repeat_counter = 0;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Append one tick to the waveform
+ *  @details  Extends the last run of the current block or starts a new run
+ *  @return   FALSE if there is no space for a new run
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static uint8_t
+irsnd_add_tick (uint16_t * n_runs_p, uint16_t block_first, uint8_t is_on)
+{
+    uint16_t    n_runs = *n_runs_p;
+    IRSND_RUN   level  = is_on ? IRSND_RUN_ON : 0;
+
+    if (n_runs > block_first &&
+        (irsnd_runs[n_runs - 1] & IRSND_RUN_ON) == level &&
+        (irsnd_runs[n_runs - 1] & IRSND_RUN_TICKS) < IRSND_RUN_TICKS)
+    {
+        irsnd_runs[n_runs - 1]++;
+        return TRUE;
+    }
+
+    if (n_runs >= IRSND_MAX_RUNS)
+    {
+        return FALSE;
+    }
+
+    irsnd_runs[n_runs] = level | 1;
+    *n_runs_p = n_runs + 1;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Close the current block of the waveform
+ *  @details  A block with the same runs as the block before is not stored, the block before is sent once more instead
+ *  @return   FALSE if there is no space for a new block
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static uint8_t
+irsnd_close_block (uint16_t * n_runs_p, uint16_t * block_first_p, uint8_t * n_blocks_p)
+{
+    uint16_t        n_runs      = *n_runs_p;
+    uint16_t        block_first = *block_first_p;
+    uint8_t         n_blocks    = *n_blocks_p;
+    IRSND_BLOCK *   last;
+
+    if (n_runs == block_first)
+    {
+        return TRUE;
+    }
+
+    last = &irsnd_blocks[n_blocks > 0 ? n_blocks - 1 : 0];
+
+    if (n_blocks > 0 && last->count < 255 &&
+        last->end - last->first == n_runs - block_first &&
+        memcmp (&irsnd_runs[last->first], &irsnd_runs[block_first], (n_runs - block_first) * sizeof (IRSND_RUN)) == 0)
+    {
+        last->count++;
+        *n_runs_p = block_first;
+        return TRUE;
+    }
+
+    if (n_blocks >= IRSND_MAX_BLOCKS)
+    {
+        return FALSE;
+    }
+
+    irsnd_blocks[n_blocks].first = block_first;
+    irsnd_blocks[n_blocks].end   = n_runs;
+    irsnd_blocks[n_blocks].count = 1;
+    *n_blocks_p     = n_blocks + 1;
+    *block_first_p  = n_runs;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Compile the waveform
+ *  @details  Runs irsnd_step() for the whole transmission and stores its output in irsnd_runs[] and irsnd_blocks[]. A new block is
+ *            started whenever the repeat counter changes. If the generator arrives at the next repetition in the same state as at the
+ *            previous one (apart from the repeat counter), all remaining repetition frames are equal to the last block: its count is
+ *            raised and the generator skips them.
+ *  @return   FALSE if the waveform does not fit into irsnd_runs[] and irsnd_blocks[], the generator is reset to the start then
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static uint8_t
+irsnd_compile (void)
+{
+    IRSND_STATE     start_state;
+    uint8_t         start_buffer[sizeof (irsnd_buffer)];
+    IRSND_STATE     last_state;                                                 // state at the last change of the repeat counter
+    uint8_t         last_buffer[sizeof (irsnd_buffer)];
+    uint8_t         last_valid  = FALSE;
+    uint8_t         repeat_counter;
+    uint16_t        n_runs      = 0;
+    uint16_t        block_first = 0;
+    uint8_t         n_blocks    = 0;
+    uint8_t         n_frames    = 0;
+    uint8_t         fits        = TRUE;
+
+    memcpy (&start_state, &irsnd_state, sizeof (IRSND_STATE));
+    memcpy (start_buffer, (void *) irsnd_buffer, sizeof (irsnd_buffer));
+    repeat_counter = irsnd_state.repeat_counter;
+
+    while (fits && irsnd_step ())
+    {
+        fits = irsnd_add_tick (&n_runs, block_first, irsnd_state.is_on);
+
+        if (fits && irsnd_state.repeat_counter != repeat_counter)
+        {
+            fits = irsnd_close_block (&n_runs, &block_first, &n_blocks) && ++n_frames < IRSND_MAX_FRAMES;
+
+            // same state as one repetition before: the frames up to the last repetition are the same as the last block
+            if (fits && last_valid &&
+                last_state.repeat_counter > 0 &&
+                (uint8_t) (last_state.repeat_counter + 1) == irsnd_state.repeat_counter &&
+                irsnd_state.repeat_counter < irsnd_state.n_repeat_frames)
+            {
+                last_state.repeat_counter = irsnd_state.repeat_counter;
+
+                if (memcmp (&last_state, &irsnd_state, sizeof (IRSND_STATE)) == 0 &&
+                    memcmp (last_buffer, (void *) irsnd_buffer, sizeof (irsnd_buffer)) == 0)
+                {
+                    irsnd_blocks[n_blocks - 1].count += irsnd_state.n_repeat_frames - irsnd_state.repeat_counter;
+                    irsnd_state.repeat_counter        = irsnd_state.n_repeat_frames;
+                }
             }
+
+            memcpy (&last_state, &irsnd_state, sizeof (IRSND_STATE));
+            memcpy (last_buffer, (void *) irsnd_buffer, sizeof (irsnd_buffer));
+            last_valid      = TRUE;
+            repeat_counter  = irsnd_state.repeat_counter;
         }
     }
 
+    if (fits)
+    {
+        fits = irsnd_close_block (&n_runs, &block_first, &n_blocks);
+    }
+
+    if (! fits || n_blocks == 0)
+    {                                                                           // generate it again while sending
+        IRSND_FREQ_TYPE freq = irsnd_state.freq;
+
+        memcpy (&irsnd_state, &start_state, sizeof (IRSND_STATE));
+        memcpy ((void *) irsnd_buffer, start_buffer, sizeof (irsnd_buffer));
+        irsnd_state.freq = freq;
+        return FALSE;
+    }
+
+    irsnd_n_blocks = n_blocks;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Next run of the waveform
+ *  @details  Steps through the blocks of the compiled waveform, a block is repeated until its count is reached or irsnd_stop() is called
+ *  @return   next run, 0 if the transmission is complete
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static IRSND_RUN
+irsnd_next_run (void)
+{
+    if (irsnd_run_idx == irsnd_blocks[irsnd_block_idx].end)
+    {
+        if (irsnd_block_counter > 1 && ! irsnd_stop_request)
+        {
+            irsnd_block_counter--;
+        }
+        else if (irsnd_block_idx + 1 < irsnd_n_blocks)
+        {
+            irsnd_block_idx++;
+            irsnd_block_counter = irsnd_blocks[irsnd_block_idx].count;
+        }
+        else
+        {
+            return 0;
+        }
+        irsnd_run_idx = irsnd_blocks[irsnd_block_idx].first;
+    }
+
+    return irsnd_runs[irsnd_run_idx++];
+}
+
+#if IRSND_USE_DMA == 1
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Fill half of the DMA ring
+ *  @details  After the last run the ring is filled with carrier off runs of one tick until both halves have been played once more,
+ *            so the end of the transmission is noticed up to IRSND_DMA_RUNS / 2 ticks late
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+irsnd_dma_fill (uint8_t half)
+{
+    uint16_t    idx;
+    uint16_t    end = (half + 1) * (IRSND_DMA_RUNS / 2);
+    IRSND_RUN   run;
+
+    for (idx = half * (IRSND_DMA_RUNS / 2); idx < end; idx++)
+    {
+        run = irsnd_dma_end ? 0 : irsnd_next_run ();
+
+        if (run)
+        {
+            irsnd_dma_ticks[idx] = 2 * (run & IRSND_RUN_TICKS) - 1;
+            irsnd_dma_level[idx] = (run & IRSND_RUN_ON) ? IRSND_DMA_CARRIER_ON : 0;
+        }
+        else
+        {
+            if (! irsnd_dma_end)
+            {
+                irsnd_dma_end = 2;                                                      // this half and the other one
+            }
+            irsnd_dma_ticks[idx] = 1;
+            irsnd_dma_level[idx] = 0;
+        }
+    }
+}
+
+#  ifdef ANALYZE
+static uint8_t                                  irsnd_dma_model_idx;                // transfer counter of both DMA channels
+static uint16_t                                 irsnd_dma_model_cnt;                // counter of the gate timer
+static uint16_t                                 irsnd_dma_model_arr;                // auto-reload register of the gate timer
+#  endif
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Start the DMA
+ *  @details  Fills the ring and starts the gate timer with one count left to the update event which starts the first run. The carrier
+ *            timer keeps running until the end of the transmission, the DMA only switches its output.
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+irsnd_dma_start (void)
+{
+    irsnd_dma_end   = 0;
+    irsnd_dma_fill (0);
+    irsnd_dma_fill (1);
+
+#  ifdef ANALYZE
+    irsnd_dma_model_idx = 0;
+    irsnd_dma_model_cnt = 1;
+    irsnd_dma_model_arr = 1;
+#  else
+    HAL_TIM_PWM_Start (&IrsndTimer, IRSND_TIMER_CHANNEL);
+    HAL_TIM_Base_Start (&IrsndTimer);
+    IRSND_TIMER->CCER = 0;                                                              // carrier off until the first run
+
+    HAL_DMA_Start_IT (&IrsndTicksDma, (uint32_t) irsnd_dma_ticks, (uint32_t) &IRSND_DMA_TIMER->ARR, IRSND_DMA_RUNS);
+    HAL_DMA_Start (&IrsndLevelDma, (uint32_t) irsnd_dma_level, (uint32_t) &IRSND_TIMER->CCER, IRSND_DMA_RUNS);
+
+    __HAL_TIM_SET_AUTORELOAD (&IrsndGateTimer, 1);
+    __HAL_TIM_SET_COUNTER (&IrsndGateTimer, 1);
+    __HAL_TIM_CLEAR_FLAG (&IrsndGateTimer, TIM_FLAG_UPDATE | TIM_FLAG_CC1);
+    __HAL_TIM_ENABLE_DMA (&IrsndGateTimer, TIM_DMA_UPDATE | TIM_DMA_CC1);
+    __HAL_TIM_ENABLE (&IrsndGateTimer);
+#  endif
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Stop the DMA
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+irsnd_dma_stop (void)
+{
+#  ifndef ANALYZE
+    __HAL_TIM_DISABLE (&IrsndGateTimer);
+    __HAL_TIM_DISABLE_DMA (&IrsndGateTimer, TIM_DMA_UPDATE | TIM_DMA_CC1);
+    HAL_DMA_Abort (&IrsndTicksDma);
+    HAL_DMA_Abort (&IrsndLevelDma);
+
+    HAL_TIM_Base_Stop (&IrsndTimer);
+    HAL_TIM_PWM_Stop (&IrsndTimer, IRSND_TIMER_CHANNEL);
+#  endif
+    irsnd_dma = FALSE;
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Half of the DMA ring has been played
+ *  @details  Refills it or stops the DMA when the last run has been played
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+irsnd_dma_refill (uint8_t half)
+{
+    if (irsnd_dma_end > 0 && --irsnd_dma_end == 0)
+    {
+        irsnd_dma_stop ();
+        irsnd_busy = FALSE;
+    }
+    else
+    {
+        irsnd_dma_fill (half);
+    }
+}
+
+#  ifdef ANALYZE
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  Model of the DMA transmit engine
+ *  @details  Plays the two counts of the gate timer in one tick: an update event reads the next slot of the ring into the auto-reload
+ *            register and the carrier output, the transfer counter at half and end of the ring calls the refill as the DMA interrupt
+ *            does. irsnd_ISR() prints the carrier output, which has to be the same as without DMA.
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+irsnd_dma_model (void)
+{
+    uint8_t     count;
+
+    for (count = 0; count < 2 && irsnd_dma; count++)
+    {
+        if (irsnd_dma_model_cnt < irsnd_dma_model_arr)
+        {
+            irsnd_dma_model_cnt++;
+            continue;
+        }
+
+        irsnd_dma_model_cnt = 0;
+        irsnd_dma_model_arr = irsnd_dma_ticks[irsnd_dma_model_idx];
+        irsnd_is_on         = irsnd_dma_level[irsnd_dma_model_idx] != 0;
+
+        if (++irsnd_dma_model_idx == IRSND_DMA_RUNS / 2)
+        {
+            irsnd_dma_refill (0);
+        }
+        else if (irsnd_dma_model_idx == IRSND_DMA_RUNS)
+        {
+            irsnd_dma_model_idx = 0;
+            irsnd_dma_refill (1);
+        }
+    }
+}
+#  else
+static void
+irsnd_dma_half_cplt (DMA_HandleTypeDef * hdma)
+{
+    (void) hdma;
+    irsnd_dma_refill (0);
+}
+
+static void
+irsnd_dma_cplt (DMA_HandleTypeDef * hdma)
+{
+    (void) hdma;
+    irsnd_dma_refill (1);
+}
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  DMA ISR routine
+ *  @details  Has to be called by the interrupt of IRSND_DMA_TICKS_CHANNEL, refills the ring
+ *  @return   FALSE if the transmission is complete
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint8_t
+irsnd_DMA_ISR (void)
+{
+    HAL_DMA_IRQHandler (&IrsndTicksDma);
+    return irsnd_busy;
+}
+#  endif // ANALYZE
+#endif // IRSND_USE_DMA == 1
+
+/*---------------------------------------------------------------------------------------------------------------------------------------------------
+ *  ISR routine
+ *  @details  ISR routine, called 10000 times per second, plays the waveform compiled by irsnd_send_data()
+ *---------------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint8_t
+irsnd_ISR (void)
+{
+    if (irsnd_busy && irsnd_live)
+    {
+        if (! irsnd_step ())
+        {
+            irsnd_busy = FALSE;
+            return irsnd_busy;
+        }
+
+        if (irsnd_state.is_on)
+        {
+            irsnd_on ();
+        }
+        else
+        {
+            irsnd_off ();
+        }
+    }
+#if IRSND_USE_DMA == 1
+    else if (irsnd_dma)
+    {
+#  ifdef ANALYZE
+        irsnd_dma_model ();
+#  else
+        return irsnd_busy;                                                              // played by the DMA
+#  endif
+    }
+#endif
+    else if (irsnd_busy)
+    {
+        if (irsnd_run_counter == 0)
+        {
+            IRSND_RUN   run = irsnd_next_run ();
+
+            if (run == 0)
+            {
+                irsnd_busy = FALSE;
+                return irsnd_busy;
+            }
+
+            irsnd_run_counter   = run & IRSND_RUN_TICKS;
+
+            if (run & IRSND_RUN_ON)
+            {
+                irsnd_on ();
+            }
+            else
+            {
+                irsnd_off ();
+            }
+        }
+        irsnd_run_counter--;
+    }
+
 #ifdef ANALYZE
     if (irsnd_is_on)
     {
@@ -3015,6 +3607,9 @@ irsnd_ISR (void)
 // cc irsnd.c -o irsnd
 //
 // usage: ./irsnd protocol hex-address hex-command >filename
+//
+// With cc -DIRSND_USE_DMA=1 the waveform is played by a model of the DMA transmit engine, see irsnd_dma_model().
+// Apart from carrier off ticks at the end of each transmission the output has to be the same as without DMA.
 
 int
 main (int argc, char ** argv)
@@ -0,0 +1,225 @@
+/**
+ * @file       keyboard.c
+ * @brief      Module for the HID keyboard and consumer control interface.
+ * @see        keyboard.h for the usages.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "keyboard.h"
+#include "action.h"
+#include "usbd_customhid.h"
+#include "configuration.h"
+#include "cm_atomic.h"
+#include "global_variables.h"
+
+/* Private define ------------------------------------------------------------*/
+#define KEYBOARD_REPORTS      2     /* report IDs 1 and 2 */
+
+/* Private typedef -----------------------------------------------------------*/
+typedef char keyboard_report_size_check[(KEYBOARD_REPORT_SIZE_MAX <= USBD_KEYBOARD_INREPORT_BUF_SIZE) ? 1 : -1];
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Report descriptor of the keyboard interface, an IR remote presses one key at
+   a time, but 6 keys keep the report in the usual layout */
+const uint8_t KEYBOARD_ReportDesc[KEYBOARD_REPORT_DESC_SIZE] =
+{
+   0x05, 0x01,                         // USAGE_PAGE (Generic Desktop)
+   0x09, 0x06,                         // USAGE (Keyboard)
+   0xa1, 0x01,                         // COLLECTION (Application)
+   0x85, KEYBOARD_REP_ID_KEYS,         //   REPORT_ID (1)
+   0x05, 0x07,                         //   USAGE_PAGE (Keyboard)
+   0x19, 0xe0,                         //   USAGE_MINIMUM (Keyboard LeftControl)
+   0x29, 0xe7,                         //   USAGE_MAXIMUM (Keyboard Right GUI)
+   0x15, 0x00,                         //   LOGICAL_MINIMUM (0)
+   0x25, 0x01,                         //   LOGICAL_MAXIMUM (1)
+   0x75, 0x01,                         //   REPORT_SIZE (1)
+   0x95, 0x08,                         //   REPORT_COUNT (8)
+   0x81, 0x02,                         //   INPUT (Data,Var,Abs)
+   0x75, 0x08,                         //   REPORT_SIZE (8)
+   0x95, 0x01,                         //   REPORT_COUNT (1)
+   0x81, 0x03,                         //   INPUT (Cnst,Var,Abs)
+   0x26, 0xff, 0x00,                   //   LOGICAL_MAXIMUM (255)
+   0x19, 0x00,                         //   USAGE_MINIMUM (Reserved (no event indicated))
+   0x2a, 0xff, 0x00,                   //   USAGE_MAXIMUM (255)
+   0x95, 0x06,                         //   REPORT_COUNT (6)
+   0x81, 0x00,                         //   INPUT (Data,Ary,Abs)
+   0xc0,                               // END_COLLECTION
+
+   0x05, 0x0c,                         // USAGE_PAGE (Consumer Devices)
+   0x09, 0x01,                         // USAGE (Consumer Control)
+   0xa1, 0x01,                         // COLLECTION (Application)
+   0x85, KEYBOARD_REP_ID_CONSUMER,     //   REPORT_ID (2)
+   0x15, 0x00,                         //   LOGICAL_MINIMUM (0)
+   0x26, 0xff, 0x03,                   //   LOGICAL_MAXIMUM (1023)
+   0x19, 0x00,                         //   USAGE_MINIMUM (Unassigned)
+   0x2a, 0xff, 0x03,                   //   USAGE_MAXIMUM (1023)
+   0x75, 0x10,                         //   REPORT_SIZE (16)
+   0x95, 0x01,                         //   REPORT_COUNT (1)
+   0x81, 0x00,                         //   INPUT (Data,Ary,Abs)
+   0xc0                                // END_COLLECTION
+};
+
+/* pressed usage per report ID, 0 if released */
+static uint16_t keyboard_usages[KEYBOARD_REPORTS];
+/* report IDs whose current state could not be queued yet, bit 0 for ID 1,
+   written by main and the USB interrupt */
+static volatile uint8_t keyboard_unsent;
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Queues the current report of every ID marked unsent. An ID stays
+  *         marked while the IN queue is full, only its latest state is sent
+  *         once a report has left, so the host never misses a release.
+  */
+static void KEYBOARD_Flush(void)
+{
+   uint8_t report[KEYBOARD_REPORT_SIZE_MAX];
+   uint8_t length;
+   uint8_t report_id;
+
+   for(report_id = 1; report_id <= KEYBOARD_REPORTS; report_id++)
+   {
+      ATOMIC_BLOCK_CRITICAL
+      {
+         if(keyboard_unsent & (1 << (report_id-1)))
+         {
+            length = KEYBOARD_PackReport(report_id, keyboard_usages[report_id-1], report);
+
+            // copied into the IN queue of the keyboard endpoint, dropped if
+            // the device is not configured, GET_REPORT tells the state then
+            if(USBD_KEYBOARD_SendReport(&USBD_Device, report, length) != USBD_BUSY)
+            {
+               keyboard_unsent &= ~(1 << (report_id-1));
+            }
+         }
+      }
+   }
+}
+
+/**
+  * @brief  Sends the report of an ID with the pressed usage.
+  */
+static void KEYBOARD_Send(uint8_t report_id)
+{
+   ATOMIC_BLOCK_CRITICAL
+   {
+      keyboard_unsent |= 1 << (report_id-1);
+   }
+   KEYBOARD_Flush();
+}
+
+/* Public functions ----------------------------------------------------------*/
+/**
+  * @brief  Packs an input report of the keyboard interface.
+  * @param  report_id: KEYBOARD_REP_ID_xxx
+  * @param  usage: pressed usage, 0 for none
+  * @param  *report: KEYBOARD_REPORT_SIZE_MAX bytes, receives the report
+  *         including the ID
+  * @return Length of the report, 0 if the ID is unknown.
+  */
+uint8_t KEYBOARD_PackReport(uint8_t report_id, uint16_t usage, uint8_t *report)
+{
+   switch(report_id)
+   {
+   case KEYBOARD_REP_ID_KEYS:
+      memset(report, 0, 1+KEYBOARD_KEYS_SIZE);
+      report[0] = report_id;
+      report[1] = usage >> 8;       // modifiers
+      report[3] = usage;            // first key
+      return 1+KEYBOARD_KEYS_SIZE;
+
+   case KEYBOARD_REP_ID_CONSUMER:
+      if(usage > KEYBOARD_CONSUMER_MAX)
+      {
+         usage = 0;
+      }
+      report[0] = report_id;
+      report[1] = usage;
+      report[2] = usage >> 8;
+      return 1+KEYBOARD_CONSUMER_SIZE;
+
+   default:
+      return 0;
+   }
+}
+
+/**
+  * @brief  Packs the current input report of an ID for GET_REPORT, called
+  *         from the USB interrupt.
+  * @param  report_id: KEYBOARD_REP_ID_xxx
+  * @param  *report: KEYBOARD_REPORT_SIZE_MAX bytes
+  * @return Length of the report, 0 if the ID is unknown.
+  */
+uint8_t KEYBOARD_GetReport(uint8_t report_id, uint8_t *report)
+{
+   if(report_id == 0 || report_id > KEYBOARD_REPORTS)
+   {
+      return 0;
+   }
+
+   return KEYBOARD_PackReport(report_id, keyboard_usages[report_id-1], report);
+}
+
+/**
+  * @brief  Sends the reports left over when the IN queue was full, called
+  *         from the USB interrupt when a keyboard report has been sent.
+  */
+void USBD_KEYBOARD_InSentCallback(void)
+{
+   KEYBOARD_Flush();
+}
+
+/**
+  * @brief  Presses the usage of an action table entry, a key pressed before
+  *         is released. Must only be called from main.
+  * @param  actions: ACTION_KEY or ACTION_CONSUMER selects the report,
+  *         nothing is pressed without them
+  * @param  usage: of the entry
+  */
+void KEYBOARD_Press(uint8_t actions, uint16_t usage)
+{
+   uint8_t report_id;
+
+   if(actions & ACTION_KEY)
+   {
+      report_id = KEYBOARD_REP_ID_KEYS;
+   }
+   else if(actions & ACTION_CONSUMER)
+   {
+      report_id = KEYBOARD_REP_ID_CONSUMER;
+   }
+   else
+   {
+      return;
+   }
+
+   KEYBOARD_Release();
+   ATOMIC_BLOCK_CRITICAL
+   {
+      keyboard_usages[report_id-1] = usage;
+   }
+   KEYBOARD_Send(report_id);
+}
+
+/**
+  * @brief  Releases the pressed key, if any. Must only be called from main.
+  */
+void KEYBOARD_Release(void)
+{
+   uint8_t report_id;
+
+   for(report_id = 1; report_id <= KEYBOARD_REPORTS; report_id++)
+   {
+      if(keyboard_usages[report_id-1] != 0)
+      {
+         ATOMIC_BLOCK_CRITICAL
+         {
+            keyboard_usages[report_id-1] = 0;
+         }
+         KEYBOARD_Send(report_id);
+      }
+   }
+}
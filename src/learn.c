@@ -0,0 +1,633 @@
+/**
+ * @file       learn.c
+ * @brief      Module for learning frames of remotes IRMP does not decode.
+ * @see        learn.h for the template and the matching.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdlib.h>   // for abs
+#include <string.h>
+#include "learn.h"
+#include "irmp.h"
+#include "application.h"
+#include "configuration.h"
+#include "cm_atomic.h"
+#include "global_variables.h"
+#include "store.h"
+
+/* Private define ------------------------------------------------------------*/
+#define LEARN_LEVELS          4     /* pulse and pause lengths of a template */
+#define LEARN_RUNS_MAX        ((LEARN_TEMPLATE_SIZE-1-2*LEARN_LEVELS)*4)  /* 92,
+                                       runs behind are only counted */
+#define LEARN_RUNS_MIN        6     /* shorter frames are noise */
+#define LEARN_GAP_TICKS       (IRMP_TIMEOUT_LEN+1)  /* ends a frame, after IRMP
+                                       has detected a frame of its own */
+#define LEARN_TOLERANCE_TICKS ((uint8_t)(F_INTERRUPTS * 150.0e-6 + 0.5))
+#define LEARN_TOLERANCE(len)  ((len)/4 + LEARN_TOLERANCE_TICKS)  /* 25 % and
+                                       the jitter of the receiver */
+#define LEARN_GROUPING(len)   ((len)/8 + LEARN_TOLERANCE_TICKS)  /* lengths of
+                                       a protocol may differ by 33 % only */
+#define LEARN_REPETITION_MS   150   /* like IRMP_KEY_REPETITION_LEN */
+#define LEARN_NO_MATCH        0xFFFF
+#define LEARN_ALL_SLOTS       0xFF
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct LEARN_TEMPLATE
+{
+   uint8_t     runs;                   /* runs of the frame, slot is free if
+                                          it is below LEARN_RUNS_MIN */
+   uint8_t     pulse[LEARN_LEVELS];    /* lengths in ticks */
+   uint8_t     pause[LEARN_LEVELS];
+   uint8_t     symbols[LEARN_RUNS_MAX/4]; /* 2 bit length index per run, run
+                                          i in bits 2*(i%4) of byte i/4 */
+} learn_template_t;
+
+typedef struct LEARN_FRAME
+{
+   uint8_t     runs;                   /* up to 254, the first LEARN_RUNS_MAX
+                                          are stored */
+   uint8_t     ticks[LEARN_RUNS_MAX];  /* up to 255 */
+} learn_frame_t;
+
+typedef struct LEARN
+{
+   /* recorder, only used by the IR ISR while active is set */
+   learn_frame_t     *frame;           /* being recorded, NULL if dropped */
+   uint16_t          ticks;            /* length of the current run */
+   uint8_t           level;            /* level of the current run */
+   bool              idle;             /* between frames */
+   uint8_t           write;            /* frame buffer being recorded */
+   /* shared */
+   volatile bool     active;           /* IR ISR records frames */
+   volatile bool     full[2];          /* frame buffer is ready for main */
+   volatile bool     request;          /* command from the host */
+   volatile uint8_t  command;
+   volatile uint8_t  command_slot;
+   volatile uint8_t  state;            /* LEARN_STATE_xxx */
+   volatile uint8_t  slot;             /* being learned or learned last */
+   volatile uint8_t  used;             /* number of used slots */
+   /* main */
+   uint8_t           read;             /* frame buffer to be processed */
+   bool              decoded;          /* IRMP decoded a frame meanwhile */
+   uint8_t           last_slot;        /* of the last match */
+   uint32_t          last_tick;
+} learn_t;
+
+typedef char learn_template_size_check[(sizeof(learn_template_t) == LEARN_TEMPLATE_SIZE) ? 1 : -1];
+
+/* Private macro -------------------------------------------------------------*/
+#define LEARN_ADDRESS(slot)   (ADDRESS_learn_templates + \
+                               (slot) * (LEARN_TEMPLATE_SIZE / EEPROM_ADDRESS_SIZE))
+
+/* Private variables ---------------------------------------------------------*/
+static learn_t          learn;
+static learn_frame_t    learn_frames[2];
+static learn_template_t learn_templates[LEARN_SLOTS];
+static uint8_t          learn_dirty[(LEARN_SLOTS + 7) / 8];  /* templates not
+                                                   yet written into the store */
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Checks whether a slot holds a template, erased or deleted slots
+  *         hold 0x00 or 0xFF.
+  */
+static bool LEARN_IsUsed(uint8_t slot)
+{
+   return learn_templates[slot].runs >= LEARN_RUNS_MIN && learn_templates[slot].runs < 0xFF;
+}
+
+/**
+  * @brief  Checks whether a run is within the tolerance of a length.
+  */
+static bool LEARN_InTolerance(uint8_t ticks, uint8_t len, uint8_t tolerance)
+{
+   uint8_t diff = (ticks > len) ? ticks - len : len - ticks;
+
+   return diff <= tolerance;
+}
+
+/**
+  * @brief  Finds the length closest to a run.
+  */
+static uint8_t LEARN_Closest(uint8_t ticks, const uint8_t *level, uint8_t levels)
+{
+   uint8_t best = 0;
+   uint8_t k;
+
+   for(k = 1; k < levels; k++)
+   {
+      if(abs(ticks - level[k]) < abs(ticks - level[best]))
+      {
+         best = k;
+      }
+   }
+
+   return best;
+}
+
+/**
+  * @brief  Reduces the pulses or the pauses of a frame to at most
+  *         LEARN_LEVELS lengths: runs are grouped around the mean of the
+  *         closest group first, within a tighter tolerance than matching, then the means are sorted and each run gets
+  *         the index of the closest mean.
+  * @param  *frame: recorded frame
+  * @param  odd: 0 for the pulses, 1 for the pauses
+  * @param  *level: LEARN_LEVELS lengths afterwards, ascending and unused
+  *         ones 0
+  * @param  *symbols: the indexes are ORed in
+  * @return false if more lengths are needed.
+  */
+static bool LEARN_Cluster(const learn_frame_t *frame, uint8_t odd, uint8_t *level, uint8_t *symbols)
+{
+   uint16_t sum[LEARN_LEVELS];
+   uint8_t  count[LEARN_LEVELS];
+   uint8_t  levels = 0;
+   uint8_t  runs = (frame->runs < LEARN_RUNS_MAX) ? frame->runs : LEARN_RUNS_MAX;
+   uint8_t  i, k, len;
+
+   for(i = odd; i < runs; i += 2)
+   {
+      k = LEARN_Closest(frame->ticks[i], level, levels);
+
+      if(levels == 0 || !LEARN_InTolerance(frame->ticks[i], level[k], LEARN_GROUPING(level[k])))
+      {
+         if(levels == LEARN_LEVELS)
+         {
+            return false;
+         }
+         k = levels++;
+         sum[k] = 0;
+         count[k] = 0;
+      }
+
+      sum[k] += frame->ticks[i];
+      count[k]++;
+      level[k] = (sum[k] + count[k]/2) / count[k];
+   }
+
+   // insertion sort, LEARN_Distance() relies on ascending lengths
+   for(i = 1; i < levels; i++)
+   {
+      len = level[i];
+      for(k = i; k > 0 && level[k-1] > len; k--)
+      {
+         level[k] = level[k-1];
+      }
+      level[k] = len;
+   }
+
+   for(i = odd; i < runs; i += 2)
+   {
+      k = LEARN_Closest(frame->ticks[i], level, levels);
+
+      // the mean may have moved away from the first runs of its group
+      if(!LEARN_InTolerance(frame->ticks[i], level[k], LEARN_TOLERANCE(level[k])))
+      {
+         return false;
+      }
+      symbols[i/4] |= k << (2*(i%4));
+   }
+
+   return true;
+}
+
+/**
+  * @brief  Builds a template of a frame.
+  * @return false if the frame needs too many lengths.
+  */
+static bool LEARN_Quantize(const learn_frame_t *frame, learn_template_t *tmpl)
+{
+   memset(tmpl, 0, sizeof(*tmpl));
+   tmpl->runs = frame->runs;
+
+   return LEARN_Cluster(frame, 0, tmpl->pulse, tmpl->symbols) &&
+          LEARN_Cluster(frame, 1, tmpl->pause, tmpl->symbols);
+}
+
+/**
+  * @brief  Sums up the differences of the runs of a frame to a template.
+  *         Gives up as soon as a run is outside its band or the sum reaches
+  *         the limit. The band is the tolerance of the length, cut at the
+  *         middle to the next shorter and longer length, so the runs of two
+  *         different frames can't match the same template. Runs are compared
+  *         from the end, as keys of a remote usually differ in the command
+  *         sent after the address.
+  * @param  limit: distance of the best template so far
+  * @return Distance, LEARN_NO_MATCH if the frame doesn't match.
+  */
+static uint16_t LEARN_Distance(const learn_template_t *tmpl, const learn_frame_t *frame, uint16_t limit)
+{
+   const uint8_t *level;
+   uint16_t sum = 0;
+   uint8_t  runs;
+   uint8_t  i, k, len, ticks, diff;
+
+   if(tmpl->runs != frame->runs)
+   {
+      return LEARN_NO_MATCH;
+   }
+
+   runs = (frame->runs < LEARN_RUNS_MAX) ? frame->runs : LEARN_RUNS_MAX;
+   for(i = runs; i-- > 0; )
+   {
+      level = (i & 1) ? tmpl->pause : tmpl->pulse;
+      k = (tmpl->symbols[i/4] >> (2*(i%4))) & 3;
+      len = level[k];
+      ticks = frame->ticks[i];
+
+      if(ticks >= len)
+      {
+         diff = ticks - len;
+         if(k < LEARN_LEVELS-1 && level[k+1] > len && diff > level[k+1] - ticks)
+         {
+            return LEARN_NO_MATCH;   // closer to the next longer length
+         }
+      }
+      else
+      {
+         diff = len - ticks;
+         if(k > 0 && ticks - level[k-1] < diff)
+         {
+            return LEARN_NO_MATCH;   // closer to the next shorter length
+         }
+      }
+
+      sum += diff;
+      if(diff > LEARN_TOLERANCE(len) || sum >= limit)
+      {
+         return LEARN_NO_MATCH;
+      }
+   }
+
+   return sum;
+}
+
+/**
+  * @brief  Finds the template closest to a frame. Free slots are not
+  *         skipped, they never have the same number of runs.
+  * @return Slot, or LEARN_SLOTS if no template matches.
+  */
+static uint8_t LEARN_Match(const learn_frame_t *frame)
+{
+   uint16_t best = LEARN_NO_MATCH;
+   uint16_t distance;
+   uint8_t  match = LEARN_SLOTS;
+   uint8_t  slot;
+
+   for(slot = 0; slot < LEARN_SLOTS; slot++)
+   {
+      distance = LEARN_Distance(&learn_templates[slot], frame, best);
+      if(distance < best)
+      {
+         best = distance;
+         match = slot;
+      }
+   }
+
+   return match;
+}
+
+/**
+  * @brief  Marks a template to be written into the store by LEARN_Commit().
+  */
+static void LEARN_SetDirty(uint8_t slot)
+{
+   learn_dirty[slot / 8] |= 1 << (slot % 8);
+   SetEvent(EVENT_EEPROM_PENDING);
+}
+
+/**
+  * @brief  Frees a slot.
+  */
+static void LEARN_Delete(uint8_t slot)
+{
+   if(LEARN_IsUsed(slot))
+   {
+      learn.used--;
+   }
+   learn_templates[slot].runs = 0;
+   LEARN_SetDirty(slot);
+}
+
+/**
+  * @brief  Lets the IR ISR record frames while there is something to learn
+  *         or to match. The recorder is only reset while it is stopped.
+  */
+static void LEARN_UpdateActive(void)
+{
+   bool active = (learn.state == LEARN_STATE_WAITING) || learn.used;
+
+   if(active == learn.active)
+   {
+      return;
+   }
+
+   if(active)
+   {
+      learn.frame = NULL;
+      learn.level = 1;
+      learn.idle = true;
+      learn.decoded = false;
+      __DMB();
+   }
+   learn.active = active;
+}
+
+/**
+  * @brief  Carries out a command of the host.
+  */
+static void LEARN_Apply(void)
+{
+   bool    request;
+   uint8_t command;
+   uint8_t slot;
+
+   ATOMIC_BLOCK_CRITICAL
+   {
+      request = learn.request;
+      command = learn.command;
+      slot = learn.command_slot;
+      learn.request = false;
+   }
+
+   if(!request)
+   {
+      return;
+   }
+
+   switch(command)
+   {
+   case LEARN_CMD_LEARN:
+      if(slot == LEARN_ALL_SLOTS)
+      {
+         for(slot = 0; slot < LEARN_SLOTS && LEARN_IsUsed(slot); slot++)
+         {
+         }
+      }
+      learn.slot = slot;
+      learn.state = (slot < LEARN_SLOTS) ? LEARN_STATE_WAITING : LEARN_STATE_FAILED;
+      break;
+
+   case LEARN_CMD_DELETE:
+      if(slot < LEARN_SLOTS)
+      {
+         LEARN_Delete(slot);
+      }
+      else if(slot == LEARN_ALL_SLOTS)
+      {
+         for(slot = 0; slot < LEARN_SLOTS; slot++)
+         {
+            if(LEARN_IsUsed(slot))
+            {
+               LEARN_Delete(slot);
+            }
+         }
+      }
+      learn.state = LEARN_STATE_IDLE;
+      break;
+
+   default:
+      learn.state = LEARN_STATE_IDLE;
+      break;
+   }
+
+   LEARN_UpdateActive();
+}
+
+/**
+  * @brief  Stores the template of a frame in the slot being learned.
+  */
+static void LEARN_Store(const learn_frame_t *frame)
+{
+   learn_template_t tmpl;
+
+   if(!LEARN_Quantize(frame, &tmpl))
+   {
+      learn.state = LEARN_STATE_FAILED;
+      LEARN_UpdateActive();
+      return;
+   }
+
+   if(!LEARN_IsUsed(learn.slot))
+   {
+      learn.used++;
+   }
+   memcpy(&learn_templates[learn.slot], &tmpl, sizeof(tmpl));
+   LEARN_SetDirty(learn.slot);
+   learn.state = LEARN_STATE_DONE;
+   LEARN_UpdateActive();
+}
+
+/**
+  * @brief  Ends a run of the frame being recorded.
+  */
+static void LEARN_StoreRun(uint16_t ticks)
+{
+   learn_frame_t *frame = learn.frame;
+
+   if(frame != NULL && frame->runs < 254)
+   {
+      if(frame->runs < LEARN_RUNS_MAX)
+      {
+         frame->ticks[frame->runs] = (ticks < 0xFF) ? ticks : 0xFF;
+      }
+      frame->runs++;
+   }
+}
+
+/* Public functions ----------------------------------------------------------*/
+/**
+  * @brief  Reads the templates from the store.
+  */
+void LEARN_Init(void)
+{
+   uint8_t slot;
+
+   for(slot = 0; slot < LEARN_SLOTS; slot++)
+   {
+      STORE_Read(LEARN_ADDRESS(slot), &learn_templates[slot], LEARN_TEMPLATE_SIZE);
+      if(LEARN_IsUsed(slot))
+      {
+         learn.used++;
+      }
+   }
+
+   LEARN_UpdateActive();
+}
+
+/**
+  * @brief  Handles REP_ID_LEARN_CONTROL, called from the USB interrupt.
+  * @param  command: LEARN_CMD_xxx
+  * @param  slot: template slot, 0xFF selects the first free one to learn
+  *         or all to delete
+  */
+void LEARN_Control(uint8_t command, uint8_t slot)
+{
+   learn.command = command;
+   learn.command_slot = slot;
+   learn.request = true;
+   SetEvent(EVENT_LEARN);
+}
+
+/**
+  * @brief  Fills REP_ID_LEARN_CONTROL, called from the USB interrupt.
+  * @param  *control holds the state, the slot, the number of used slots and
+  *         LEARN_SLOTS afterwards.
+  */
+void LEARN_GetControl(uint8_t *control)
+{
+   control[0] = learn.state;
+   control[1] = learn.slot;
+   control[2] = learn.used;
+   control[3] = LEARN_SLOTS;
+}
+
+/**
+  * @brief  Records the frames of the IR input, called from the IR ISR once
+  *         per tick or per edge with the input IRMP gets. A pause of
+  *         LEARN_GAP_TICKS ends a frame, which is passed to main if one of
+  *         the two frame buffers is free.
+  * @param  input: IR input level, 0 for a pulse
+  * @param  ticks: length of the level
+  */
+void LEARN_Put(uint8_t input, uint16_t ticks)
+{
+   if(!learn.active)
+   {
+      return;
+   }
+
+   input = (input != 0);
+   if(input != learn.level)
+   {
+      if(!learn.idle)
+      {
+         LEARN_StoreRun(learn.ticks);
+      }
+      else if(!learn.full[learn.write])   // first pulse of a frame
+      {
+         learn.frame = &learn_frames[learn.write];
+         learn.frame->runs = 0;
+      }
+      learn.level = input;
+      learn.ticks = 0;
+      learn.idle = false;
+   }
+   else if(learn.idle)
+   {
+      return;
+   }
+
+   learn.ticks = (ticks < 0xFFFF - learn.ticks) ? learn.ticks + ticks : 0xFFFF;
+
+   if(learn.level && learn.ticks >= LEARN_GAP_TICKS)
+   {
+      if(learn.frame != NULL)
+      {
+         __DMB();
+         learn.full[learn.write] = true;
+         learn.write ^= 1;
+         learn.frame = NULL;
+         SetEvent(EVENT_LEARN);
+      }
+      learn.idle = true;
+   }
+}
+
+/**
+  * @brief  Tells that IRMP has decoded a frame, so the frame recorded at the
+  *         same time is not unknown. Called by main for every frame of IRMP.
+  */
+void LEARN_Decoded(void)
+{
+   learn.decoded = true;
+}
+
+/**
+  * @brief  Carries out commands of the host and learns or matches the
+  *         recorded frames IRMP has not decoded. Call again while it returns
+  *         true.
+  * @param  *irmp_data holds the matched template afterwards: LEARN_PROTOCOL,
+  *         address 0 and the slot as command.
+  * @return true if a frame matched a template.
+  */
+bool LEARN_Process(IRMP_DATA *irmp_data)
+{
+   learn_frame_t *frame;
+   uint8_t        slot = LEARN_SLOTS;
+   uint32_t       now;
+
+   LEARN_Apply();
+
+   while(learn.full[learn.read])
+   {
+      frame = &learn_frames[learn.read];
+
+      if(!learn.decoded && frame->runs >= LEARN_RUNS_MIN)
+      {
+         if(learn.state == LEARN_STATE_WAITING)
+         {
+            LEARN_Store(frame);
+         }
+         else
+         {
+            slot = LEARN_Match(frame);
+         }
+      }
+      learn.decoded = false;
+
+      __DMB();
+      learn.full[learn.read] = false;
+      learn.read ^= 1;
+
+      if(slot < LEARN_SLOTS)
+      {
+         now = HAL_GetTick();
+         irmp_data->protocol = LEARN_PROTOCOL;
+         irmp_data->address = 0;
+         irmp_data->command = slot;
+         irmp_data->flags = (slot == learn.last_slot &&
+                             now - learn.last_tick < LEARN_REPETITION_MS) ? IRMP_FLAG_REPETITION : 0;
+         learn.last_slot = slot;
+         learn.last_tick = now;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+/**
+  * @brief  Writes one changed template into the store, called from the main
+  *         loop on EVENT_EEPROM_PENDING with interrupts enabled. A template
+  *         stays marked if the write fails and is tried again.
+  * @return true if more templates are pending.
+  */
+bool LEARN_Commit(void)
+{
+   uint8_t slot;
+
+   for(slot = 0; slot < LEARN_SLOTS; slot++)
+   {
+      if(learn_dirty[slot / 8] & (1 << (slot % 8)))
+      {
+         if(STORE_Write(LEARN_ADDRESS(slot), &learn_templates[slot],
+                        LEARN_TEMPLATE_SIZE) == HAL_OK)
+         {
+            learn_dirty[slot / 8] &= ~(1 << (slot % 8));
+         }
+         break;
+      }
+   }
+
+   for(; slot < LEARN_SLOTS; slot++)
+   {
+      if(learn_dirty[slot / 8] & (1 << (slot % 8)))
+      {
+         return true;
+      }
+   }
+
+   return false;
+}
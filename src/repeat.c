@@ -0,0 +1,207 @@
+/**
+ * @file       repeat.c
+ * @brief      Module that shapes the repetitions of a held key.
+ * @see        repeat.h for the events.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "repeat.h"
+#include "irmp.h"
+#include "application.h"
+#include "configuration.h"
+#include "cm_atomic.h"
+
+/* Private define ------------------------------------------------------------*/
+/* Private typedef -----------------------------------------------------------*/
+typedef struct REPEAT
+{
+   repeat_config_t   config;
+   uint8_t           min_repeats;      /* repetition frames before the first
+                                          repeat */
+   IRMP_DATA         key;              /* held key, flags are 0 */
+   bool              held;
+   uint8_t           repeats;          /* repetition frames since key-down,
+                                          saturated */
+   uint32_t          next;             /* time the next repeat is due */
+   uint32_t          last;             /* time of the last frame of the key */
+} repeat_t;
+
+typedef char repeat_report_size_check[(sizeof(repeat_config_t) == REPEAT_REPORT_SIZE) ? 1 : -1];
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static repeat_t   repeat;
+/* key-up timeout for REPEAT_Tick(), main writes them in an atomic block */
+static uint32_t   repeat_deadline;
+static bool       repeat_armed;
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Starts the key-up timeout of the held key, or stops it.
+  */
+static void REPEAT_Arm(bool armed, uint32_t deadline)
+{
+   ATOMIC_BLOCK_CRITICAL
+   {
+      repeat_deadline = deadline;
+      repeat_armed = armed;
+   }
+}
+
+/**
+  * @brief  Releases the held key.
+  * @param  *released receives the key.
+  * @return REPEAT_UP, or REPEAT_NONE if key-up events are disabled.
+  */
+static uint8_t REPEAT_Release(IRMP_DATA *released)
+{
+   repeat.held = false;
+   REPEAT_Arm(false, 0);
+
+   if(repeat.config.timeout == 0)
+   {
+      return REPEAT_NONE;
+   }
+
+   memcpy(released, &repeat.key, sizeof(*released));
+   return REPEAT_UP;
+}
+
+/**
+  * @brief  Checks whether a frame is of the held key, the flags don't count.
+  */
+static bool REPEAT_IsHeldKey(const IRMP_DATA *irmp_data)
+{
+   return repeat.held &&
+          irmp_data->protocol == repeat.key.protocol &&
+          irmp_data->address == repeat.key.address &&
+          irmp_data->command == repeat.key.command;
+}
+
+/**
+  * @brief  Checks whether the timeout of the held key has expired.
+  */
+static bool REPEAT_IsTimedOut(uint32_t now)
+{
+   return repeat.held && repeat.config.timeout != 0 &&
+          (int32_t)(now - repeat.last) >= repeat.config.timeout;
+}
+
+/* Public functions ----------------------------------------------------------*/
+/**
+  * @brief  Sets the shaping of repetitions, called from main at startup and
+  *         whenever the configuration changes. A held key keeps its state.
+  * @param  min_repeats: repetition frames before the first repeat.
+  * @param  *config: delay, period and timeout.
+  */
+void REPEAT_SetConfig(uint8_t min_repeats, const repeat_config_t *config)
+{
+   repeat.min_repeats = min_repeats;
+   memcpy(&repeat.config, config, sizeof(repeat.config));
+
+   if(repeat.held && repeat.config.timeout != 0)
+   {
+      REPEAT_Arm(true, repeat.last + repeat.config.timeout);
+   }
+}
+
+/**
+  * @brief  Tells whether key-up events are enabled, a key stays pressed
+  *         until then.
+  */
+bool REPEAT_HasKeyUp(void)
+{
+   return repeat.config.timeout != 0;
+}
+
+/**
+  * @brief  Turns a received frame into key events. Must only be called from
+  *         main.
+  * @param  *irmp_data: received frame.
+  * @param  now: HAL_GetTick() when it was received.
+  * @param  *released: receives the key of REPEAT_UP.
+  * @return REPEAT_xxx bits, REPEAT_UP comes before REPEAT_DOWN.
+  */
+uint8_t REPEAT_Frame(const IRMP_DATA *irmp_data, uint32_t now, IRMP_DATA *released)
+{
+   uint8_t events = REPEAT_NONE;
+
+   // a late repetition frame starts a new key press, the key-up has been
+   // reported or is overdue
+   if( !(irmp_data->flags & IRMP_FLAG_REPETITION) ||
+       !REPEAT_IsHeldKey(irmp_data) || REPEAT_IsTimedOut(now) )
+   {
+      if(repeat.held)
+      {
+         events |= REPEAT_Release(released);
+      }
+
+      memcpy(&repeat.key, irmp_data, sizeof(repeat.key));
+      repeat.key.flags = 0;
+      repeat.held = true;
+      repeat.repeats = 0;
+      repeat.next = now + repeat.config.delay;
+      events |= REPEAT_DOWN;
+   }
+   else
+   {
+      if(repeat.repeats < UINT8_MAX)
+      {
+         repeat.repeats++;
+      }
+
+      if( repeat.repeats >= repeat.min_repeats &&
+          (int32_t)(now - repeat.next) >= 0 )
+      {
+         // keep the rate when frames don't arrive on time, but don't catch
+         // up after a gap
+         repeat.next += repeat.config.period;
+         if((int32_t)(now - repeat.next) >= 0)
+         {
+            repeat.next = now + repeat.config.period;
+         }
+         events |= REPEAT_REPEAT;
+      }
+   }
+
+   repeat.last = now;
+   if(repeat.config.timeout != 0)
+   {
+      REPEAT_Arm(true, now + repeat.config.timeout);
+   }
+
+   return events;
+}
+
+/**
+  * @brief  Releases the held key when its timeout has expired, called from
+  *         main on EVENT_REPEAT.
+  * @param  now: HAL_GetTick()
+  * @param  *released: receives the key of REPEAT_UP.
+  * @return REPEAT_UP or REPEAT_NONE.
+  */
+uint8_t REPEAT_Poll(uint32_t now, IRMP_DATA *released)
+{
+   if(!REPEAT_IsTimedOut(now))
+   {
+      return REPEAT_NONE;
+   }
+
+   return REPEAT_Release(released);
+}
+
+/**
+  * @brief  Raises EVENT_REPEAT when the timeout of the held key expires,
+  *         called from the SysTick interrupt.
+  * @param  now: HAL_GetTick()
+  */
+void REPEAT_Tick(uint32_t now)
+{
+   if(repeat_armed && (int32_t)(now - repeat_deadline) >= 0)
+   {
+      repeat_armed = false;
+      SetEvent(EVENT_REPEAT);
+   }
+}
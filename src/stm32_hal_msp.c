@@ -205,7 +205,7 @@ void HAL_RTC_MspInit(RTC_HandleTypeDef *hrtc)
    __HAL_RTC_SECOND_CLEAR_FLAG(hrtc, RTC_FLAG_SEC);
 
    /* Set the RTC NVIC priority */
-   HAL_NVIC_SetPriority(RTC_IRQn, 2, 0);
+   HAL_NVIC_SetPriority(RTC_IRQn, IRQ_PRIO_RTC, 0);
 
    /* Enable the RTC global interrupt */
    HAL_NVIC_EnableIRQ(RTC_IRQn);
@@ -215,7 +215,7 @@ void HAL_RTC_MspInit(RTC_HandleTypeDef *hrtc)
    __HAL_RTC_WAKEUPTIMER_EXTI_CLEAR_FLAG();
 
    /* Set the RTC wakeup NVIC priority */
-   HAL_NVIC_SetPriority(RTC_WKUP_IRQn, 2, 0);
+   HAL_NVIC_SetPriority(RTC_WKUP_IRQn, IRQ_PRIO_RTC, 0);
 
    /* Enable the RTC wakeup global interrupt */
    HAL_NVIC_EnableIRQ(RTC_WKUP_IRQn);
@@ -255,20 +255,30 @@ void HAL_TIM_Base_MspInit(TIM_HandleTypeDef *htim)
       IRMP_IRSND_TIMER_CLK_EN();
 
       /* Configure TIMx */
+#if IRMP_USE_EDGE_CAPTURE == 1
+      /* free running, one count per IRMP tick */
+      htim->Init.Period         = 0xFFFF;
+      htim->Init.Prescaler      = (HAL_RCC_GetPCLK1Freq()/F_INTERRUPTS)-1;
+#else
       htim->Init.Period         = (HAL_RCC_GetPCLK1Freq()/F_INTERRUPTS)-1;
       htim->Init.Prescaler      = 0;
+#endif
       htim->Init.ClockDivision  = 0;
       htim->Init.CounterMode    = TIM_COUNTERMODE_UP;
 
       /* TIMx interrupt enable and start */
+#if IRMP_USE_EDGE_CAPTURE == 1
+      if(HAL_TIM_Base_Start(htim) != HAL_OK)
+#else
       if(HAL_TIM_Base_Start_IT(htim) != HAL_OK)
+#endif
       {
         /* Starting Error */
         Error_Handler();
       }
 
       /* Set the TIMx NVIC priority */
-      HAL_NVIC_SetPriority(IRMP_IRSND_TIMER_IRQ, 0, 1);
+      HAL_NVIC_SetPriority(IRMP_IRSND_TIMER_IRQ, IRQ_PRIO_IR, 1);
 
       /* Enable the TIMx global interrupt */
       HAL_NVIC_EnableIRQ(IRMP_IRSND_TIMER_IRQ);
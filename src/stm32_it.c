@@ -36,6 +36,7 @@
 #else
   #error Device not specified.
 #endif
+#include "repeat.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
@@ -146,6 +147,8 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   HAL_IncTick();
+  /* key-up timeout of a held IR key */
+  REPEAT_Tick(HAL_GetTick());
 }
 
 /******************************************************************************/
@@ -0,0 +1,423 @@
+/**
+ * @file       store.c
+ * @brief      Module that stores records too large for the emulated EEPROM.
+ * @see        store.h for the flash layout.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "store.h"
+#include "application.h"
+#include "learn.h"
+#include "action.h"
+
+#if defined(STM32F103xB)
+/* Private define ------------------------------------------------------------*/
+#define STORE_START_ADDRESS   ((uint32_t)0x0801E000)  /* last 8 KB of the
+                                             flash, not part of the FLASH
+                                             region of the linker script */
+#define STORE_PAGE_SIZE       0x400
+#define STORE_BANK_PAGES      4
+#define STORE_BANK_SIZE       (STORE_BANK_PAGES * STORE_PAGE_SIZE)
+#define STORE_BANK_HEADER     4     /* state, reserved */
+#define STORE_RECORD_HEADER   4     /* address, length */
+#define STORE_RECORDS         (LEARN_SLOTS + ACTION_ENTRIES)
+#define STORE_LIVE_MAX        (LEARN_SLOTS * STORE_RECORD_SIZE(LEARN_TEMPLATE_SIZE) + \
+                               ACTION_ENTRIES * STORE_RECORD_SIZE(ACTION_ENTRY_SIZE))
+
+/* Bank states, like the pages of the emulated EEPROM */
+#define STORE_ERASED          0xFFFF
+#define STORE_RECEIVING       0xEEEE   /* valid records are being copied in */
+#define STORE_VALID           0x0000
+
+#define STORE_COMPLETE        0x0000   /* mark behind the data of a record */
+#define STORE_FREE            0xFFFF   /* address of erased space */
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct STORE_INDEX
+{
+   uint16_t    address;
+   uint16_t    offset;                 /* of the record in the valid bank */
+} store_index_t;
+
+typedef struct STORE
+{
+   uint8_t        bank;                /* valid bank */
+   uint16_t       free;                /* offset of the erased space, the
+                                          bank size if it can't be used */
+   uint8_t        used;                /* entries of index */
+   store_index_t  index[STORE_RECORDS];
+} store_t;
+
+/* Private macro -------------------------------------------------------------*/
+#define STORE_RECORD_SIZE(length)  (STORE_RECORD_HEADER + (((length) + 1) & ~1) + 2)
+#define STORE_BANK_ADDRESS(bank)   (STORE_START_ADDRESS + (bank) * STORE_BANK_SIZE)
+#define STORE_HALFWORD(bank, offset) \
+                              (*(volatile uint16_t*)(uintptr_t)(STORE_BANK_ADDRESS(bank) + (offset)))
+
+/* a copy must always find room for the record being written */
+typedef char store_bank_size_check[(STORE_BANK_HEADER + STORE_LIVE_MAX <= STORE_BANK_SIZE) ? 1 : -1];
+
+/* Private variables ---------------------------------------------------------*/
+static store_t store;
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Programs halfwords, an odd length is padded with 0xFF.
+  */
+static HAL_StatusTypeDef STORE_Program(uint32_t address, const uint8_t *data, uint16_t length)
+{
+   HAL_StatusTypeDef status = HAL_OK;
+   uint16_t halfword;
+   uint16_t idx;
+
+   for(idx = 0; idx < length && status == HAL_OK; idx += 2)
+   {
+      halfword = data[idx];
+      halfword |= (idx + 1 < length) ? (uint16_t)data[idx + 1] << 8 : 0xFF00;
+      status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address + idx, halfword);
+   }
+
+   return status;
+}
+
+/**
+  * @brief  Programs the state of a bank.
+  */
+static HAL_StatusTypeDef STORE_SetState(uint8_t bank, uint16_t state)
+{
+   return HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, STORE_BANK_ADDRESS(bank), state);
+}
+
+/**
+  * @brief  Erases the pages of a bank that are not erased yet.
+  * @param  pages: number of pages from the start of the bank
+  */
+static HAL_StatusTypeDef STORE_Erase(uint8_t bank, uint8_t pages)
+{
+   FLASH_EraseInitTypeDef erase;
+   HAL_StatusTypeDef      status = HAL_OK;
+   uint32_t               page_error;
+   uint32_t               address;
+   uint16_t               offset;
+
+   erase.TypeErase = FLASH_TYPEERASE_PAGES;
+   erase.NbPages = 1;
+
+   for(address = STORE_BANK_ADDRESS(bank);
+       address < STORE_BANK_ADDRESS(bank) + pages * STORE_PAGE_SIZE && status == HAL_OK;
+       address += STORE_PAGE_SIZE)
+   {
+      for(offset = 0; offset < STORE_PAGE_SIZE; offset += 4)
+      {
+         if(*(volatile uint32_t*)(uintptr_t)(address + offset) != 0xFFFFFFFF)
+         {
+            erase.PageAddress = address;
+            status = HAL_FLASHEx_Erase(&erase, &page_error);
+            break;
+         }
+      }
+   }
+
+   return status;
+}
+
+/**
+  * @brief  Finds the index entry of a record.
+  * @return Index entry, store.used if there is none.
+  */
+static uint8_t STORE_Find(uint16_t address)
+{
+   uint8_t idx;
+
+   for(idx = 0; idx < store.used && store.index[idx].address != address; idx++);
+
+   return idx;
+}
+
+/**
+  * @brief  Reads the index of the valid bank, records interrupted by a reset
+  *         are skipped.
+  */
+static void STORE_Scan(void)
+{
+   uint16_t offset = STORE_BANK_HEADER;
+   uint16_t address;
+   uint16_t length;
+   uint8_t  idx;
+
+   store.used = 0;
+
+   while(offset + STORE_RECORD_HEADER <= STORE_BANK_SIZE)
+   {
+      address = STORE_HALFWORD(store.bank, offset);
+      length = STORE_HALFWORD(store.bank, offset + 2);
+
+      if(address == STORE_FREE && length == 0xFFFF)
+      {
+         store.free = offset;
+         return;
+      }
+      if(length > UINT8_MAX || offset + STORE_RECORD_SIZE(length) > STORE_BANK_SIZE)
+      {
+         // broken header, the space behind it can't be used
+         break;
+      }
+
+      if(STORE_HALFWORD(store.bank, offset + STORE_RECORD_SIZE(length) - 2) == STORE_COMPLETE)
+      {
+         idx = STORE_Find(address);
+         if(idx < STORE_RECORDS)
+         {
+            store.index[idx].address = address;
+            store.index[idx].offset = offset;
+            if(idx == store.used)
+            {
+               store.used++;
+            }
+         }
+      }
+      offset += STORE_RECORD_SIZE(length);
+   }
+
+   store.free = STORE_BANK_SIZE;
+}
+
+/**
+  * @brief  Appends a record to a bank. The erased space can't be used
+  *         anymore if it fails.
+  * @param  *free: offset of the erased space, behind the record afterwards
+  */
+static HAL_StatusTypeDef STORE_Append(uint8_t bank, uint16_t *free, uint16_t address,
+                                      const void *data, uint8_t length)
+{
+   uint32_t          start = STORE_BANK_ADDRESS(bank) + *free;
+   uint16_t          header[2] = { address, length };
+   HAL_StatusTypeDef status;
+
+   if(*free + STORE_RECORD_SIZE(length) > STORE_BANK_SIZE)
+   {
+      return HAL_ERROR;
+   }
+
+   status = STORE_Program(start, (const uint8_t*)header, sizeof(header));
+   if(status == HAL_OK)
+   {
+      status = STORE_Program(start + STORE_RECORD_HEADER, data, length);
+   }
+   if(status == HAL_OK)
+   {
+      status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD,
+                                 start + STORE_RECORD_SIZE(length) - 2, STORE_COMPLETE);
+   }
+
+   *free = (status == HAL_OK) ? *free + STORE_RECORD_SIZE(length) : STORE_BANK_SIZE;
+   return status;
+}
+
+/**
+  * @brief  Copies the valid records into the other bank, but the one being
+  *         written, appends that one and makes the other bank valid.
+  */
+static HAL_StatusTypeDef STORE_Copy(uint16_t address, const void *data, uint8_t length)
+{
+   uint8_t           bank = store.bank ^ 1;
+   uint16_t          free = STORE_BANK_HEADER;
+   uint16_t          offset;
+   HAL_StatusTypeDef status;
+   uint8_t           idx;
+
+   status = STORE_Erase(bank, STORE_BANK_PAGES);
+   if(status == HAL_OK)
+   {
+      status = STORE_SetState(bank, STORE_RECEIVING);
+   }
+
+   for(idx = 0; idx < store.used && status == HAL_OK; idx++)
+   {
+      if(store.index[idx].address != address)
+      {
+         offset = store.index[idx].offset;
+         status = STORE_Append(bank, &free, store.index[idx].address,
+                               (const void*)(uintptr_t)(STORE_BANK_ADDRESS(store.bank) + offset + STORE_RECORD_HEADER),
+                               STORE_HALFWORD(store.bank, offset + 2));
+      }
+   }
+
+   if(status == HAL_OK)
+   {
+      status = STORE_Append(bank, &free, address, data, length);
+   }
+
+   // the old bank is invalid once its state is erased, the new one is
+   // complete then
+   if(status == HAL_OK)
+   {
+      status = STORE_Erase(store.bank, 1);
+   }
+   if(status == HAL_OK)
+   {
+      store.bank = bank;
+      status = STORE_SetState(bank, STORE_VALID);
+   }
+
+   STORE_Scan();
+   return status;
+}
+
+/* Public functions ----------------------------------------------------------*/
+/**
+  * @brief  Finds the valid bank and reads its index, completes a copy
+  *         interrupted by a reset. Formats the banks if none is valid.
+  */
+void STORE_Init(void)
+{
+   uint16_t state0 = STORE_HALFWORD(0, 0);
+   uint16_t state1 = STORE_HALFWORD(1, 0);
+
+   HAL_FLASH_Unlock();
+
+   if(state0 == STORE_VALID || state1 == STORE_VALID)
+   {
+      // a bank still receiving is erased by the next copy
+      store.bank = (state0 == STORE_VALID) ? 0 : 1;
+   }
+   else if(state0 == STORE_RECEIVING || state1 == STORE_RECEIVING)
+   {
+      // the old bank has been erased already
+      store.bank = (state0 == STORE_RECEIVING) ? 0 : 1;
+      STORE_SetState(store.bank, STORE_VALID);
+   }
+   else
+   {
+      store.bank = 0;
+      if(STORE_Erase(0, STORE_BANK_PAGES) == HAL_OK)
+      {
+         STORE_SetState(0, STORE_VALID);
+      }
+   }
+
+   HAL_FLASH_Lock();
+
+   STORE_Scan();
+}
+
+/**
+  * @brief  Reads a record.
+  * @param  address: EEPROM address of the record
+  * @param  *data holds the record afterwards, it is left unchanged if the
+  *         record has never been written.
+  * @param  length: of the record, a shorter record is filled up with 0xFF
+  * @return HAL_OK or HAL_ERROR if the record has never been written.
+  */
+HAL_StatusTypeDef STORE_Read(uint16_t address, void *data, uint8_t length)
+{
+   uint8_t  idx = STORE_Find(address);
+   uint16_t offset;
+   uint8_t  stored;
+
+   if(idx >= store.used)
+   {
+      return HAL_ERROR;
+   }
+
+   offset = store.index[idx].offset;
+   stored = STORE_HALFWORD(store.bank, offset + 2);
+   memset(data, 0xFF, length);
+   memcpy(data, (const void*)(uintptr_t)(STORE_BANK_ADDRESS(store.bank) + offset + STORE_RECORD_HEADER),
+          (stored < length) ? stored : length);
+
+   return HAL_OK;
+}
+
+/**
+  * @brief  Writes a record, unless it is unchanged. Must be called from main
+  *         with interrupts enabled, a copy into the other bank takes about
+  *         200 ms.
+  * @param  address: EEPROM address of the record
+  * @param  *data: record
+  * @param  length: of the record
+  * @return HAL_OK, or the error of the flash, the record keeps its value
+  *         then.
+  */
+HAL_StatusTypeDef STORE_Write(uint16_t address, const void *data, uint8_t length)
+{
+   uint8_t           idx = STORE_Find(address);
+   uint16_t          offset = store.free;
+   HAL_StatusTypeDef status;
+
+   if( idx < store.used &&
+       STORE_HALFWORD(store.bank, store.index[idx].offset + 2) == length &&
+       memcmp((const void*)(uintptr_t)(STORE_BANK_ADDRESS(store.bank) + store.index[idx].offset + STORE_RECORD_HEADER),
+              data, length) == 0 )
+   {
+      return HAL_OK;
+   }
+   if(idx >= STORE_RECORDS)
+   {
+      return HAL_ERROR;
+   }
+
+   HAL_FLASH_Unlock();
+
+   if(store.free + STORE_RECORD_SIZE(length) <= STORE_BANK_SIZE)
+   {
+      status = STORE_Append(store.bank, &store.free, address, data, length);
+      if(status == HAL_OK)
+      {
+         store.index[idx].address = address;
+         store.index[idx].offset = offset;
+         if(idx == store.used)
+         {
+            store.used++;
+         }
+      }
+   }
+   else
+   {
+      status = STORE_Copy(address, data, length);
+   }
+
+   HAL_FLASH_Lock();
+
+   return status;
+}
+
+#else
+/* Public functions ----------------------------------------------------------*/
+/**
+  * @brief  Records are stored in the data EEPROM at their address.
+  */
+void STORE_Init(void)
+{
+}
+
+/**
+  * @brief  Reads a record.
+  * @param  address: EEPROM address of the record
+  * @param  *data holds the record afterwards.
+  * @param  length: of the record
+  */
+HAL_StatusTypeDef STORE_Read(uint16_t address, void *data, uint8_t length)
+{
+   return EEPROM_ReadBytes(address, data, length);
+}
+
+/**
+  * @brief  Writes a record, unless it is unchanged. Must be called from main
+  *         with interrupts enabled, each byte takes about 3.3 ms.
+  * @param  address: EEPROM address of the record
+  * @param  *data: record
+  * @param  length: of the record
+  */
+HAL_StatusTypeDef STORE_Write(uint16_t address, const void *data, uint8_t length)
+{
+   if(memcmp((const void*)(uintptr_t)(DATA_EEPROM_START_ADDR + address), data, length) == 0)
+   {
+      return HAL_OK;
+   }
+
+   return EEPROM_WriteBytes(address, (void*)data, length);
+}
+#endif
@@ -12,6 +12,7 @@
 #ifndef DOXYGEN
   #if defined(USE_STDPERIPH_DRIVER) || defined(USE_HAL_DRIVER)
     #include "cm_atomic.h"
+    #include "configuration.h"    // for ATOMIC_BLOCK_CRITICAL
   #endif
   #if defined(USE_STDPERIPH_DRIVER)
     #if defined(STM32L1XX_MD) || defined(STM32L1XX_MDP) || defined(STM32L1XX_HD)
@@ -32,6 +33,12 @@
     #include <avr/interrupt.h>   // for cli() and sei()
     #include <util/atomic.h>     // for ATOMIC_BLOCK(x)
   #endif
+
+  /* only the interrupts sharing data with this module have to be blocked, the
+   * application may define a BASEPRI based block for that */
+  #ifndef ATOMIC_BLOCK_CRITICAL
+    #define ATOMIC_BLOCK_CRITICAL  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  #endif
 #endif
 
 /* Private define ------------------------------------------------------------*/
@@ -235,7 +242,7 @@ int32_t SWRTC_GetDeviation(void)
 {
    int32_t        deviation;
 
-   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   ATOMIC_BLOCK_CRITICAL
    {
       deviation = clk_deviation;
    }
@@ -257,7 +264,7 @@ bool SWRTC_SetDeviation(int32_t deviation)
    if( deviation < (int32_t)SWRTC_TICKS_PER_SECOND
     && deviation > (int32_t)-SWRTC_TICKS_PER_SECOND )
    {
-      ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+      ATOMIC_BLOCK_CRITICAL
       {
          clk_deviation = deviation;
       }
@@ -274,7 +281,7 @@ uint32_t SWRTC_GetSeconds(void)
 {
    uint32_t       seconds;
 
-   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   ATOMIC_BLOCK_CRITICAL
    {
       seconds = clk_secs;
    }
@@ -287,7 +294,7 @@ uint32_t SWRTC_GetSeconds(void)
  */
 void SWRTC_SetSeconds(uint32_t seconds)
 {
-   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   ATOMIC_BLOCK_CRITICAL
    {
       clk_secs = seconds;
    }
@@ -306,7 +313,7 @@ int16_t SWRTC_GetTicks(void)
 {
    int32_t        ticks;
 
-   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   ATOMIC_BLOCK_CRITICAL
    {
       ticks = clk_ticks;
    }
@@ -329,7 +336,7 @@ void SWRTC_SetTicks(uint16_t ticks)
 #else
    ticks /= (10000 / (SWRTC_TICKS_PER_SECOND + clk_deviation));
 #endif
-   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   ATOMIC_BLOCK_CRITICAL
    {
       clk_ticks = ticks;
    }
@@ -343,7 +350,7 @@ swrtc_time_t SWRTC_GetTime(void)
 {
    swrtc_time_t   time;
 
-   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   ATOMIC_BLOCK_CRITICAL
    {
       time.seconds = clk_secs;
       time.ticks = SWRTC_GetTicks();
@@ -369,7 +376,7 @@ swrtc_time_t SWRTC_GetTime(void)
  */
 void SWRTC_SetTime(swrtc_time_t time)
 {
-   ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   ATOMIC_BLOCK_CRITICAL
    {
       clk_secs = time.seconds;
       SWRTC_SetTicks(time.ticks);
@@ -29,6 +29,7 @@
 #include "main.h"
 #include "usbd_core.h"
 #include "usbd_customhid.h"
+#include "configuration.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
@@ -90,7 +91,7 @@ void HAL_PCD_MspInit(PCD_HandleTypeDef *hpcd)
 #endif
 
   /* Set USB Interrupt priority */
-  HAL_NVIC_SetPriority(USB_LP_IRQn, 3, 0);
+  HAL_NVIC_SetPriority(USB_LP_IRQn, IRQ_PRIO_USB, 0);
 
   /* Enable USB Interrupt */
   HAL_NVIC_EnableIRQ(USB_LP_IRQn);
@@ -262,6 +263,7 @@ USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
   HAL_PCDEx_PMAConfig(pdev->pData , 0x80 , PCD_SNG_BUF, 0x58);
   HAL_PCDEx_PMAConfig(pdev->pData , CUSTOM_HID_EPIN_ADDR , PCD_SNG_BUF, 0x98);
   HAL_PCDEx_PMAConfig(pdev->pData , CUSTOM_HID_EPOUT_ADDR , PCD_SNG_BUF, 0xD8);
+  HAL_PCDEx_PMAConfig(pdev->pData , KEYBOARD_EPIN_ADDR , PCD_SNG_BUF, 0x118);
 
   return USBD_OK;
 }
@@ -49,6 +49,9 @@
 #include "usbd_customhid.h"
 #include "usbd_desc.h"
 #include "usbd_ctlreq.h"
+#include "cm_atomic.h"
+#include "configuration.h"
+#include "keyboard.h"
 
 /** @addtogroup STM32_USB_DEVICE_LIBRARY
   * @{
@@ -102,6 +105,11 @@ static uint8_t  USBD_CUSTOM_HID_DataIn (USBD_HandleTypeDef *pdev, uint8_t epnum)
 static uint8_t  USBD_CUSTOM_HID_DataOut (USBD_HandleTypeDef *pdev, uint8_t epnum);
 static uint8_t  USBD_CUSTOM_HID_EP0_RxReady (USBD_HandleTypeDef  *pdev);
 
+static uint8_t  USBD_KEYBOARD_Setup (USBD_HandleTypeDef *pdev,
+                                     USBD_SetupReqTypedef *req);
+
+static void     USBD_KEYBOARD_DataIn (USBD_HandleTypeDef *pdev);
+
 /**
   * @}
   */
@@ -128,6 +136,20 @@ USBD_ClassTypeDef  USBD_CUSTOM_HID =
   USBD_CUSTOM_HID_GetDeviceQualifierDesc,
 };
 
+/* IN reports waiting for transmission, the one at InQueueHead is on the bus
+   while the endpoint is busy and stays untouched until DataIn */
+static uint8_t  USBD_CUSTOM_HID_InQueue[USBD_CUSTOMHID_INREPORT_QUEUE_SIZE][USBD_CUSTOMHID_INREPORT_BUF_SIZE];
+static uint8_t  USBD_CUSTOM_HID_InQueueLen[USBD_CUSTOMHID_INREPORT_QUEUE_SIZE];
+static uint8_t  USBD_CUSTOM_HID_InQueueHead;
+static uint8_t  USBD_CUSTOM_HID_InQueueCount;
+static USBD_CUSTOM_HID_InStatsTypeDef USBD_CUSTOM_HID_InStats;
+
+/* IN reports of the keyboard interface, same scheme as above */
+static uint8_t  USBD_KEYBOARD_InQueue[USBD_KEYBOARD_INREPORT_QUEUE_SIZE][USBD_KEYBOARD_INREPORT_BUF_SIZE];
+static uint8_t  USBD_KEYBOARD_InQueueLen[USBD_KEYBOARD_INREPORT_QUEUE_SIZE];
+static uint8_t  USBD_KEYBOARD_InQueueHead;
+static uint8_t  USBD_KEYBOARD_InQueueCount;
+
 /* USB CUSTOM_HID device Configuration Descriptor */
 __ALIGN_BEGIN static uint8_t USBD_CUSTOM_HID_CfgDesc[USB_CUSTOM_HID_CONFIG_DESC_SIZ] __ALIGN_END =
 {
@@ -136,7 +158,7 @@ __ALIGN_BEGIN static uint8_t USBD_CUSTOM_HID_CfgDesc[USB_CUSTOM_HID_CONFIG_DESC_
   USB_CUSTOM_HID_CONFIG_DESC_SIZ,
   /* wTotalLength: Bytes returned */
   0x00,
-  0x01,         /*bNumInterfaces: 1 interface*/
+  0x02,         /*bNumInterfaces: 2 interfaces (vendor, keyboard)*/
   0x01,         /*bConfigurationValue: Configuration value*/
   0x00,         /*iConfiguration: Index of string descriptor describing
   the configuration*/
@@ -174,7 +196,7 @@ __ALIGN_BEGIN static uint8_t USBD_CUSTOM_HID_CfgDesc[USB_CUSTOM_HID_CONFIG_DESC_
   0x03,          /*bmAttributes: Interrupt endpoint*/
   CUSTOM_HID_EPIN_SIZE, /*wMaxPacketSize: x Bytes max */
   0x00,
-  0x19,          /*bInterval: Polling Interval (25 ms)*/
+  USBD_CUSTOMHID_POLLING_INTERVAL, /*bInterval: Polling Interval (ms)*/
   /* 34 */
 
   0x07,	         /* bLength: Endpoint Descriptor size */
@@ -183,8 +205,38 @@ __ALIGN_BEGIN static uint8_t USBD_CUSTOM_HID_CfgDesc[USB_CUSTOM_HID_CONFIG_DESC_
   0x03,	/* bmAttributes: Interrupt endpoint */
   CUSTOM_HID_EPOUT_SIZE,	/* wMaxPacketSize: x Bytes max  */
   0x00,
-  0x19,	/* bInterval: Polling Interval (25 ms) */
+  USBD_CUSTOMHID_POLLING_INTERVAL, /* bInterval: Polling Interval (ms) */
   /* 41 */
+
+  /************** Descriptor of keyboard interface ****************/
+  0x09,         /*bLength: Interface Descriptor size*/
+  USB_DESC_TYPE_INTERFACE,/*bDescriptorType: Interface descriptor type*/
+  KEYBOARD_INTERFACE, /*bInterfaceNumber: Number of Interface*/
+  0x00,         /*bAlternateSetting: Alternate setting*/
+  0x01,         /*bNumEndpoints*/
+  0x03,         /*bInterfaceClass: HID*/
+  0x00,         /*bInterfaceSubClass : 1=BOOT, 0=no boot (report IDs)*/
+  0x00,         /*nInterfaceProtocol : 0=none, 1=keyboard, 2=mouse*/
+  0,            /*iInterface: Index of string descriptor*/
+  /* 50 */
+  0x09,         /*bLength: HID Descriptor size*/
+  CUSTOM_HID_DESCRIPTOR_TYPE, /*bDescriptorType: HID*/
+  0x11,         /*bcdHID: HID Class Spec release number*/
+  0x01,
+  0x00,         /*bCountryCode: Hardware target country*/
+  0x01,         /*bNumDescriptors: Number of HID class descriptors to follow*/
+  0x22,         /*bDescriptorType*/
+  KEYBOARD_REPORT_DESC_SIZE,/*wItemLength: Total length of Report descriptor*/
+  0x00,
+  /* 59 */
+  0x07,          /*bLength: Endpoint Descriptor size*/
+  USB_DESC_TYPE_ENDPOINT, /*bDescriptorType:*/
+  KEYBOARD_EPIN_ADDR,     /*bEndpointAddress: Endpoint Address (IN)*/
+  0x03,          /*bmAttributes: Interrupt endpoint*/
+  KEYBOARD_EPIN_SIZE, /*wMaxPacketSize: x Bytes max */
+  0x00,
+  USBD_KEYBOARD_POLLING_INTERVAL, /*bInterval: Polling Interval (ms)*/
+  /* 66 */
 };
 
 /* USB CUSTOM_HID device Configuration Descriptor */
@@ -202,6 +254,20 @@ __ALIGN_BEGIN static uint8_t USBD_CUSTOM_HID_Desc[USB_CUSTOM_HID_DESC_SIZ] __ALI
   0x00,
 };
 
+/* HID descriptor of the keyboard interface */
+__ALIGN_BEGIN static uint8_t USBD_KEYBOARD_Desc[USB_CUSTOM_HID_DESC_SIZ] __ALIGN_END =
+{
+  0x09,         /*bLength: HID Descriptor size*/
+  CUSTOM_HID_DESCRIPTOR_TYPE, /*bDescriptorType: HID*/
+  0x11,         /*bcdHID: HID Class Spec release number*/
+  0x01,
+  0x00,         /*bCountryCode: Hardware target country*/
+  0x01,         /*bNumDescriptors: Number of HID class descriptors to follow*/
+  0x22,         /*bDescriptorType*/
+  KEYBOARD_REPORT_DESC_SIZE,/*wItemLength: Total length of Report descriptor*/
+  0x00,
+};
+
 /* USB Standard Device Descriptor */
 __ALIGN_BEGIN static uint8_t USBD_CUSTOM_HID_DeviceQualifierDesc[USB_LEN_DEV_QUALIFIER_DESC] __ALIGN_END =
 {
@@ -237,6 +303,8 @@ static uint8_t  USBD_CUSTOM_HID_Init (USBD_HandleTypeDef *pdev,
 {
   uint8_t ret = 0;
   USBD_CUSTOM_HID_HandleTypeDef     *hhid;
+
+  UNUSED(cfgidx);
   /* Open EP IN */
   USBD_LL_OpenEP(pdev,
                  CUSTOM_HID_EPIN_ADDR,
@@ -249,6 +317,12 @@ static uint8_t  USBD_CUSTOM_HID_Init (USBD_HandleTypeDef *pdev,
                  USBD_EP_TYPE_INTR,
                  CUSTOM_HID_EPOUT_SIZE);
 
+  /* Open keyboard EP IN */
+  USBD_LL_OpenEP(pdev,
+                 KEYBOARD_EPIN_ADDR,
+                 USBD_EP_TYPE_INTR,
+                 KEYBOARD_EPIN_SIZE);
+
   pdev->pClassData = USBD_malloc(sizeof (USBD_CUSTOM_HID_HandleTypeDef));
 
   if(pdev->pClassData == NULL)
@@ -260,6 +334,11 @@ static uint8_t  USBD_CUSTOM_HID_Init (USBD_HandleTypeDef *pdev,
     hhid = (USBD_CUSTOM_HID_HandleTypeDef*) pdev->pClassData;
 
     hhid->state = CUSTOM_HID_IDLE;
+    hhid->KbdState = CUSTOM_HID_IDLE;
+    USBD_CUSTOM_HID_InQueueHead = 0;
+    USBD_CUSTOM_HID_InQueueCount = 0;
+    USBD_KEYBOARD_InQueueHead = 0;
+    USBD_KEYBOARD_InQueueCount = 0;
     ((USBD_CUSTOM_HID_ItfTypeDef *)pdev->pUserData)->Init();
           /* Prepare Out endpoint to receive 1st packet */
     USBD_LL_PrepareReceive(pdev, CUSTOM_HID_EPOUT_ADDR, hhid->Report_buf,
@@ -279,6 +358,7 @@ static uint8_t  USBD_CUSTOM_HID_Init (USBD_HandleTypeDef *pdev,
 static uint8_t  USBD_CUSTOM_HID_DeInit (USBD_HandleTypeDef *pdev,
                                  uint8_t cfgidx)
 {
+  UNUSED(cfgidx);
   /* Close CUSTOM_HID EP IN */
   USBD_LL_CloseEP(pdev,
                   CUSTOM_HID_EPIN_ADDR);
@@ -287,6 +367,10 @@ static uint8_t  USBD_CUSTOM_HID_DeInit (USBD_HandleTypeDef *pdev,
   USBD_LL_CloseEP(pdev,
                   CUSTOM_HID_EPOUT_ADDR);
 
+  /* Close keyboard EP IN */
+  USBD_LL_CloseEP(pdev,
+                  KEYBOARD_EPIN_ADDR);
+
   /* FRee allocated memory */
   if(pdev->pClassData != NULL)
   {
@@ -310,9 +394,15 @@ static uint8_t  USBD_CUSTOM_HID_Setup (USBD_HandleTypeDef *pdev,
   uint16_t len = 0;
   uint8_t  *pbuf = NULL;
   USBD_CUSTOM_HID_HandleTypeDef     *hhid = (USBD_CUSTOM_HID_HandleTypeDef*)pdev->pClassData;
-  uint8_t buffer[USBD_CUSTOMHID_INREPORT_BUF_SIZE];
+  static uint8_t buffer[USBD_CUSTOMHID_FEATREPORT_BUF_SIZE]; /* sent after return */
   int8_t state;
 
+  if((req->bmRequest & USB_REQ_RECIPIENT_MASK) == USB_REQ_RECIPIENT_INTERFACE &&
+     LOBYTE(req->wIndex) == KEYBOARD_INTERFACE)
+  {
+    return USBD_KEYBOARD_Setup(pdev, req);
+  }
+
   switch (req->bmRequest & USB_REQ_TYPE_MASK)
   {
   case USB_REQ_TYPE_CLASS :
@@ -340,7 +430,7 @@ static uint8_t  USBD_CUSTOM_HID_Setup (USBD_HandleTypeDef *pdev,
 
     case CUSTOM_HID_REQ_SET_REPORT:
       hhid->IsReportAvailable = 1;
-      USBD_CtlPrepareRx (pdev, hhid->Report_buf, (uint8_t)(req->wLength));
+      USBD_CtlPrepareRx (pdev, hhid->Report_buf, (uint8_t)MIN(req->wLength, sizeof(hhid->Report_buf)));
       break;
 
     case CUSTOM_HID_REQ_GET_REPORT:
@@ -354,11 +444,12 @@ static uint8_t  USBD_CUSTOM_HID_Setup (USBD_HandleTypeDef *pdev,
          buffer[0] = req->wValue & 0xff;
          len++;
 
-         // Length MUST NOT be bigger than USBD_CUSTOMHID_INREPORT_BUF_SIZE
-         if(len > USBD_CUSTOMHID_INREPORT_BUF_SIZE)
+         // Length MUST NOT be bigger than USBD_CUSTOMHID_FEATREPORT_BUF_SIZE
+         if(len > USBD_CUSTOMHID_FEATREPORT_BUF_SIZE)
          {
-            len = USBD_CUSTOMHID_INREPORT_BUF_SIZE;
+            len = USBD_CUSTOMHID_FEATREPORT_BUF_SIZE;
          }
+         len = MIN(len, req->wLength);
          USBD_CtlSendData (pdev,
                            buffer,
                            len);
@@ -411,31 +502,272 @@ static uint8_t  USBD_CUSTOM_HID_Setup (USBD_HandleTypeDef *pdev,
   return USBD_OK;
 }
 
+/**
+  * @brief  USBD_KEYBOARD_Setup
+  *         Handle the requests of the keyboard interface
+  * @param  pdev: instance
+  * @param  req: usb requests
+  * @retval status
+  */
+static uint8_t  USBD_KEYBOARD_Setup (USBD_HandleTypeDef *pdev,
+                                     USBD_SetupReqTypedef *req)
+{
+  uint16_t len = 0;
+  uint8_t  *pbuf = NULL;
+  USBD_CUSTOM_HID_HandleTypeDef     *hhid = (USBD_CUSTOM_HID_HandleTypeDef*)pdev->pClassData;
+  static uint8_t buffer[USBD_KEYBOARD_INREPORT_BUF_SIZE]; /* sent after return */
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+  case USB_REQ_TYPE_CLASS :
+    switch (req->bRequest)
+    {
+    case CUSTOM_HID_REQ_SET_PROTOCOL:
+      hhid->KbdProtocol = (uint8_t)(req->wValue);
+      break;
+
+    case CUSTOM_HID_REQ_GET_PROTOCOL:
+      USBD_CtlSendData (pdev,
+                        (uint8_t *)&hhid->KbdProtocol,
+                        1);
+      break;
+
+    case CUSTOM_HID_REQ_SET_IDLE:
+      hhid->KbdIdleState = (uint8_t)(req->wValue >> 8);
+      break;
+
+    case CUSTOM_HID_REQ_GET_IDLE:
+      USBD_CtlSendData (pdev,
+                        (uint8_t *)&hhid->KbdIdleState,
+                        1);
+      break;
+
+    case CUSTOM_HID_REQ_GET_REPORT:
+      len = KEYBOARD_GetReport(req->wValue & 0xff, buffer);
+      if(len == 0)
+      {
+        USBD_CtlError (pdev, req);
+        return USBD_FAIL;
+      }
+      USBD_CtlSendData (pdev,
+                        buffer,
+                        MIN(len, req->wLength));
+      break;
+
+    default: /* no output or feature reports */
+      USBD_CtlError (pdev, req);
+      return USBD_FAIL;
+    }
+    break;
+
+  case USB_REQ_TYPE_STANDARD:
+    switch (req->bRequest)
+    {
+    case USB_REQ_GET_DESCRIPTOR:
+      if( req->wValue >> 8 == CUSTOM_HID_REPORT_DESC)
+      {
+        len = MIN(KEYBOARD_REPORT_DESC_SIZE , req->wLength);
+        pbuf = (uint8_t *)KEYBOARD_ReportDesc;
+      }
+      else if( req->wValue >> 8 == CUSTOM_HID_DESCRIPTOR_TYPE)
+      {
+        pbuf = USBD_KEYBOARD_Desc;
+        len = MIN(USB_CUSTOM_HID_DESC_SIZ , req->wLength);
+      }
+
+      USBD_CtlSendData (pdev,
+                        pbuf,
+                        len);
+      break;
+
+    case USB_REQ_GET_INTERFACE :
+    case USB_REQ_SET_INTERFACE :
+      /* no alternate settings */
+      if(req->bRequest == USB_REQ_GET_INTERFACE)
+      {
+        USBD_CtlSendData (pdev,
+                          (uint8_t *)&hhid->AltSetting,
+                          1);
+      }
+      break;
+    }
+  }
+  return USBD_OK;
+}
+
 /**
   * @brief  USBD_CUSTOM_HID_SendReport
-  *         Send CUSTOM_HID Report
+  *         Send CUSTOM_HID Report. The report is copied into the IN queue, so
+  *         the caller's buffer may be reused immediately. Queued reports are
+  *         transmitted one after the other from DataIn.
   * @param  pdev: device instance
   * @param  buff: pointer to report
-  * @retval status
+  * @param  len: report length, at most USBD_CUSTOMHID_INREPORT_BUF_SIZE
+  * @retval status: USBD_BUSY if the queue is full, USBD_FAIL if the device
+  *         is not configured
   */
 uint8_t USBD_CUSTOM_HID_SendReport     (USBD_HandleTypeDef  *pdev,
                                  uint8_t *report,
                                  uint16_t len)
 {
   USBD_CUSTOM_HID_HandleTypeDef     *hhid = (USBD_CUSTOM_HID_HandleTypeDef*)pdev->pClassData;
+  uint8_t ret = USBD_OK;
+  uint8_t idx;
 
-  if(pdev->dev_state == USBD_STATE_CONFIGURED)
+  if(len > USBD_CUSTOMHID_INREPORT_BUF_SIZE)
   {
-    if(hhid->state == CUSTOM_HID_IDLE)
+    return USBD_FAIL;
+  }
+
+  ATOMIC_BLOCK_CRITICAL
+  {
+    if(pdev->dev_state != USBD_STATE_CONFIGURED || hhid == NULL)
     {
-      hhid->state = CUSTOM_HID_BUSY;
-      USBD_LL_Transmit (pdev,
-                        CUSTOM_HID_EPIN_ADDR,
-                        report,
-                        len);
+      USBD_CUSTOM_HID_InStats.Drops++;
+      ret = USBD_FAIL;
+    }
+    else if(USBD_CUSTOM_HID_InQueueCount >= USBD_CUSTOMHID_INREPORT_QUEUE_SIZE)
+    {
+      USBD_CUSTOM_HID_InStats.Overflows++;
+      ret = USBD_BUSY;
+    }
+    else
+    {
+      idx = (USBD_CUSTOM_HID_InQueueHead + USBD_CUSTOM_HID_InQueueCount) % USBD_CUSTOMHID_INREPORT_QUEUE_SIZE;
+      memcpy(USBD_CUSTOM_HID_InQueue[idx], report, len);
+      USBD_CUSTOM_HID_InQueueLen[idx] = len;
+      USBD_CUSTOM_HID_InQueueCount++;
+
+      if(hhid->state == CUSTOM_HID_IDLE)
+      {
+        hhid->state = CUSTOM_HID_BUSY;
+        USBD_LL_Transmit (pdev,
+                          CUSTOM_HID_EPIN_ADDR,
+                          USBD_CUSTOM_HID_InQueue[USBD_CUSTOM_HID_InQueueHead],
+                          USBD_CUSTOM_HID_InQueueLen[USBD_CUSTOM_HID_InQueueHead]);
+      }
     }
   }
-  return USBD_OK;
+  return ret;
+}
+
+/**
+  * @brief  USBD_KEYBOARD_SendReport
+  *         Send a report of the keyboard interface. It is queued like the
+  *         reports of USBD_CUSTOM_HID_SendReport, so a key press and its
+  *         release reach the host in consecutive polls.
+  * @param  pdev: device instance
+  * @param  buff: pointer to report including the report ID
+  * @param  len: report length, at most USBD_KEYBOARD_INREPORT_BUF_SIZE
+  * @retval status: USBD_BUSY if the queue is full, USBD_FAIL if the device
+  *         is not configured
+  */
+uint8_t USBD_KEYBOARD_SendReport (USBD_HandleTypeDef *pdev,
+                                  uint8_t *report,
+                                  uint16_t len)
+{
+  USBD_CUSTOM_HID_HandleTypeDef     *hhid = (USBD_CUSTOM_HID_HandleTypeDef*)pdev->pClassData;
+  uint8_t ret = USBD_OK;
+  uint8_t idx;
+
+  if(len == 0 || len > USBD_KEYBOARD_INREPORT_BUF_SIZE)
+  {
+    return USBD_FAIL;
+  }
+
+  ATOMIC_BLOCK_CRITICAL
+  {
+    if(pdev->dev_state != USBD_STATE_CONFIGURED || hhid == NULL)
+    {
+      ret = USBD_FAIL;
+    }
+    else if(USBD_KEYBOARD_InQueueCount >= USBD_KEYBOARD_INREPORT_QUEUE_SIZE)
+    {
+      ret = USBD_BUSY;
+    }
+    else
+    {
+      idx = (USBD_KEYBOARD_InQueueHead + USBD_KEYBOARD_InQueueCount) % USBD_KEYBOARD_INREPORT_QUEUE_SIZE;
+      memcpy(USBD_KEYBOARD_InQueue[idx], report, len);
+      USBD_KEYBOARD_InQueueLen[idx] = len;
+      USBD_KEYBOARD_InQueueCount++;
+
+      if(hhid->KbdState == CUSTOM_HID_IDLE)
+      {
+        hhid->KbdState = CUSTOM_HID_BUSY;
+        USBD_LL_Transmit (pdev,
+                          KEYBOARD_EPIN_ADDR,
+                          USBD_KEYBOARD_InQueue[USBD_KEYBOARD_InQueueHead],
+                          USBD_KEYBOARD_InQueueLen[USBD_KEYBOARD_InQueueHead]);
+      }
+    }
+  }
+  return ret;
+}
+
+/**
+  * @brief  USBD_CUSTOM_HID_GetInQueueSpace
+  *         Return the number of IN reports that can be queued
+  * @param  None
+  * @retval number of free slots of the IN queue
+  */
+uint8_t USBD_CUSTOM_HID_GetInQueueSpace (void)
+{
+  return USBD_CUSTOMHID_INREPORT_QUEUE_SIZE - USBD_CUSTOM_HID_InQueueCount;
+}
+
+/**
+  * @brief  USBD_CUSTOM_HID_InSentCallback
+  *         Called from DataIn when an IN report has been sent
+  * @param  None
+  * @retval None
+  */
+__weak void USBD_CUSTOM_HID_InSentCallback (void)
+{
+}
+
+/**
+  * @brief  USBD_KEYBOARD_InSentCallback
+  *         Called from DataIn when an IN report of the keyboard interface
+  *         has been sent
+  * @param  None
+  * @retval None
+  */
+__weak void USBD_KEYBOARD_InSentCallback (void)
+{
+}
+
+/**
+  * @brief  USBD_CUSTOM_HID_GetInStats
+  *         Return the number of IN reports that were discarded
+  * @param  stats: pointer to statistics to fill
+  * @retval None
+  */
+void USBD_CUSTOM_HID_GetInStats (USBD_CUSTOM_HID_InStatsTypeDef *stats)
+{
+  ATOMIC_BLOCK_CRITICAL
+  {
+    *stats = USBD_CUSTOM_HID_InStats;
+  }
+}
+
+/**
+  * @brief  USBD_CUSTOM_HID_SetPollingInterval
+  *         Set bInterval of both interrupt endpoints. Takes effect when the
+  *         host reads the configuration descriptor, i.e. on the next
+  *         enumeration.
+  * @param  interval: polling interval in ms, 0 selects the build default
+  * @retval None
+  */
+void USBD_CUSTOM_HID_SetPollingInterval (uint8_t interval)
+{
+  if(interval == 0)
+  {
+    interval = USBD_CUSTOMHID_POLLING_INTERVAL;
+  }
+
+  USBD_CUSTOM_HID_CfgDesc[33] = interval; /* EP IN bInterval */
+  USBD_CUSTOM_HID_CfgDesc[40] = interval; /* EP OUT bInterval */
 }
 
 /**
@@ -461,14 +793,69 @@ static uint8_t  *USBD_CUSTOM_HID_GetCfgDesc (uint16_t *length)
 static uint8_t  USBD_CUSTOM_HID_DataIn (USBD_HandleTypeDef *pdev,
                               uint8_t epnum)
 {
+  USBD_CUSTOM_HID_HandleTypeDef     *hhid = (USBD_CUSTOM_HID_HandleTypeDef*)pdev->pClassData;
+
+  if(epnum == (KEYBOARD_EPIN_ADDR & 0x7F))
+  {
+    USBD_KEYBOARD_DataIn(pdev);
+    return USBD_OK;
+  }
+
+  /* The report at the queue head has been sent, start the next one */
+  if(USBD_CUSTOM_HID_InQueueCount > 0)
+  {
+    USBD_CUSTOM_HID_InQueueHead = (USBD_CUSTOM_HID_InQueueHead + 1) % USBD_CUSTOMHID_INREPORT_QUEUE_SIZE;
+    USBD_CUSTOM_HID_InQueueCount--;
+  }
 
-  /* Ensure that the FIFO is empty before a new transfer, this condition could
-  be caused by  a new transfer before the end of the previous transfer */
-  ((USBD_CUSTOM_HID_HandleTypeDef *)pdev->pClassData)->state = CUSTOM_HID_IDLE;
+  if(USBD_CUSTOM_HID_InQueueCount > 0)
+  {
+    USBD_LL_Transmit (pdev,
+                      CUSTOM_HID_EPIN_ADDR,
+                      USBD_CUSTOM_HID_InQueue[USBD_CUSTOM_HID_InQueueHead],
+                      USBD_CUSTOM_HID_InQueueLen[USBD_CUSTOM_HID_InQueueHead]);
+  }
+  else
+  {
+    hhid->state = CUSTOM_HID_IDLE;
+  }
+
+  USBD_CUSTOM_HID_InSentCallback();
 
   return USBD_OK;
 }
 
+/**
+  * @brief  USBD_KEYBOARD_DataIn
+  *         handle data IN Stage of the keyboard endpoint
+  * @param  pdev: device instance
+  * @retval None
+  */
+static void  USBD_KEYBOARD_DataIn (USBD_HandleTypeDef *pdev)
+{
+  USBD_CUSTOM_HID_HandleTypeDef     *hhid = (USBD_CUSTOM_HID_HandleTypeDef*)pdev->pClassData;
+
+  if(USBD_KEYBOARD_InQueueCount > 0)
+  {
+    USBD_KEYBOARD_InQueueHead = (USBD_KEYBOARD_InQueueHead + 1) % USBD_KEYBOARD_INREPORT_QUEUE_SIZE;
+    USBD_KEYBOARD_InQueueCount--;
+  }
+
+  if(USBD_KEYBOARD_InQueueCount > 0)
+  {
+    USBD_LL_Transmit (pdev,
+                      KEYBOARD_EPIN_ADDR,
+                      USBD_KEYBOARD_InQueue[USBD_KEYBOARD_InQueueHead],
+                      USBD_KEYBOARD_InQueueLen[USBD_KEYBOARD_InQueueHead]);
+  }
+  else
+  {
+    hhid->KbdState = CUSTOM_HID_IDLE;
+  }
+
+  USBD_KEYBOARD_InSentCallback();
+}
+
 /**
   * @brief  USBD_CUSTOM_HID_DataOut
   *         handle data OUT Stage
@@ -482,6 +869,7 @@ static uint8_t  USBD_CUSTOM_HID_DataOut (USBD_HandleTypeDef *pdev,
 
   USBD_CUSTOM_HID_HandleTypeDef     *hhid = (USBD_CUSTOM_HID_HandleTypeDef*)pdev->pClassData;
 
+  UNUSED(epnum);
   ((USBD_CUSTOM_HID_ItfTypeDef *)pdev->pUserData)->OutEvent(hhid->Report_buf[0],
                                                             &hhid->Report_buf[1]);
 
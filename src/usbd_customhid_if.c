@@ -33,9 +33,28 @@
 #include "application.h"
 #include "global_variables.h"
 #include "stm32_hal_msp.h"
+#include "configuration.h"
+#include "cm_atomic.h"
+#include "capture.h"
+#include "learn.h"
+#include "action.h"
+#include "repeat.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+/* all updates carried by REP_ID_CONFIG_BLOB of version 1 */
+#define UPDATE_CONFIG_BLOB_V1 (UPDATE_CONTROL_PC_ENABLE | UPDATE_FORWARD_IR_ENABLE | \
+                            UPDATE_POWER_ON_IR_CODE | UPDATE_POWER_OFF_IR_CODE | \
+                            UPDATE_RESET_IR_CODE | UPDATE_MINIMUM_REPEATS | \
+                            UPDATE_CLOCK_CORRECTION | UPDATE_WAKEUP_TIME_SPAN | \
+                            UPDATE_PROTOCOL_MASK | UPDATE_POLLING_INTERVAL)
+/* and of the current version */
+#define UPDATE_CONFIG_BLOB (UPDATE_CONFIG_BLOB_V1 | UPDATE_REPEAT_SHAPING)
+
+#if CONFIG_BLOB_SIZE > USBD_CUSTOMHID_FEATREPORT_BUF_SIZE-1
+#error USBD_CUSTOMHID_FEATREPORT_BUF_SIZE is too small for REP_ID_CONFIG_BLOB
+#endif
+
 /* Private macro -------------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 static int8_t CustomHID_Init        (void);
@@ -44,9 +63,12 @@ static int8_t CustomHID_OutEvent    (uint8_t event_idx, uint8_t* buffer);
 static int8_t CustomHID_SetFeature  (uint8_t event_idx, uint8_t* buffer);
 static int8_t CustomHID_GetFeature  (uint8_t event_idx, uint8_t* buffer, uint16_t* length);
 static uint16_t CustomHID_FeatureReportLength(uint8_t event_idx);
+static void CustomHID_PackConfig(const hidirt_data_t *config, uint8_t *blob);
+static void CustomHID_UnpackConfig(hidirt_data_t *config, const uint8_t *blob,
+                                   uint8_t version);
 
 /* Private variables ---------------------------------------------------------*/
-static char FirmwareVersion[USBD_CUSTOMHID_INREPORT_BUF_SIZE-1] = "v0.32";
+static char FirmwareVersion[sizeof(IRMP_DATA)] = "v0.32";
 static hidirt_data_t hidirt_data_shadow = {0};
 
 __ALIGN_BEGIN static uint8_t CustomHID_ReportDesc[USBD_CUSTOM_HID_REPORT_DESC_SIZE] __ALIGN_END =
@@ -71,6 +93,9 @@ __ALIGN_BEGIN static uint8_t CustomHID_ReportDesc[USBD_CUSTOM_HID_REPORT_DESC_SI
    0x85, REP_ID_WAKEUP_TIME_SPAN,      //   REPORT_ID (0x1A)
    0x09, 0x01,                         //   USAGE (Vendor Usage 1)
    0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
+   0x85, REP_ID_POLLING_INTERVAL,      //   REPORT_ID (0x1E)
+   0x09, 0x01,                         //   USAGE (Vendor Usage 1)
+   0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
    0x85, REP_ID_REQUEST_BOOTLOADER,    //   REPORT_ID (0x50)
    0x09, 0x01,                         //   USAGE (Vendor Usage 1)
    0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
@@ -81,6 +106,21 @@ __ALIGN_BEGIN static uint8_t CustomHID_ReportDesc[USBD_CUSTOM_HID_REPORT_DESC_SI
    0x09, 0x01,                         //   USAGE (Vendor Usage 1)
    0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
 
+   0x95, CAPTURE_CONTROL_SIZE,         //   REPORT_COUNT (2)
+   0x85, REP_ID_CAPTURE_CONTROL,       //   REPORT_ID (0x21)
+   0x09, 0x01,                         //   USAGE (Vendor Usage 1)
+   0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
+
+   0x95, ACTION_REPORT_SIZE,           //   REPORT_COUNT (9)
+   0x85, REP_ID_ACTION_ENTRY,          //   REPORT_ID (0x23)
+   0x09, 0x01,                         //   USAGE (Vendor Usage 1)
+   0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
+
+   0x95, REPEAT_REPORT_SIZE,           //   REPORT_COUNT (6)
+   0x85, REP_ID_REPEAT_SHAPING,        //   REPORT_ID (0x24)
+   0x09, 0x01,                         //   USAGE (Vendor Usage 1)
+   0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
+
    0x95, 0x04,                         //   REPORT_COUNT (4)
    0x85, REP_ID_CLOCK_CORRECTION,      //   REPORT_ID (0x18)
    0x09, 0x01,                         //   USAGE (Vendor Usage 1)
@@ -88,6 +128,28 @@ __ALIGN_BEGIN static uint8_t CustomHID_ReportDesc[USBD_CUSTOM_HID_REPORT_DESC_SI
    0x85, REP_ID_WAKEUP_TIME,           //   REPORT_ID (0x19)
    0x09, 0x01,                         //   USAGE (Vendor Usage 1)
    0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
+   0x85, REP_ID_IR_ISR_LATENCY,        //   REPORT_ID (0x20)
+   0x09, 0x01,                         //   USAGE (Vendor Usage 1)
+   0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
+   0x85, REP_ID_LEARN_CONTROL,         //   REPORT_ID (0x22)
+   0x09, 0x01,                         //   USAGE (Vendor Usage 1)
+   0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
+
+   0x95, 0x08,                         //   REPORT_COUNT (8)
+   0x85, REP_ID_PROTOCOL_MASK,         //   REPORT_ID (0x1B)
+   0x09, 0x01,                         //   USAGE (Vendor Usage 1)
+   0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
+   0x85, REP_ID_CPU_LOAD,              //   REPORT_ID (0x1C)
+   0x09, 0x01,                         //   USAGE (Vendor Usage 1)
+   0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
+   0x85, REP_ID_IN_REPORT_STATS,       //   REPORT_ID (0x1D)
+   0x09, 0x01,                         //   USAGE (Vendor Usage 1)
+   0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
+
+   0x95, CONFIG_BLOB_SIZE,             //   REPORT_COUNT (42)
+   0x85, REP_ID_CONFIG_BLOB,           //   REPORT_ID (0x1F)
+   0x09, 0x01,                         //   USAGE (Vendor Usage 1)
+   0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
 
    0x95, 0x06,                         //   REPORT_COUNT (6)
    0x85, REP_ID_IR_CODE_INTERRUPT,     //   REPORT_ID (1)
@@ -112,6 +174,11 @@ __ALIGN_BEGIN static uint8_t CustomHID_ReportDesc[USBD_CUSTOM_HID_REPORT_DESC_SI
    0x85, REP_ID_GET_FIRMWARE_VERSION,  //   REPORT_ID (0x10)
    0x09, 0x01,                         //   USAGE (Vendor Usage 1)
    0xb1, 0x02,                         //   FEATURE (Data,Var,Abs)
+
+   0x95, CAPTURE_REPORT_SIZE,          //   REPORT_COUNT (31)
+   0x85, REP_ID_CAPTURE_DATA,          //   REPORT_ID (2)
+   0x09, 0x01,                         //   USAGE (Vendor Usage 1)
+   0x81, 0x02,                         //   INPUT (Data,Var,Abs)
    0xc0                                // END_COLLECTION
 };
 
@@ -169,6 +236,7 @@ static int8_t CustomHID_OutEvent(uint8_t event_idx, uint8_t* buffer)
    case REP_ID_IR_CODE_INTERRUPT:
       // write command to FIFO from where it will be sent later
       FIFO_Write(&irsnd_fifo, (fifo_entry_t*)buffer);
+      SetEvent(EVENT_IRSND_QUEUED);
       break;
 
    default: /* Report does not exist */
@@ -195,40 +263,40 @@ static int8_t CustomHID_SetFeature(uint8_t event_idx, uint8_t* buffer)
    {
    case REP_ID_CONTROL_PC_ENABLE:
       hidirt_data_shadow.control_pc_enable = buffer[0];
-      hidirt_data_shadow.data_update_pending = REP_ID_CONTROL_PC_ENABLE;
+      hidirt_data_shadow.data_update_pending |= UPDATE_CONTROL_PC_ENABLE;
       break;
 
    case REP_ID_FORWARD_IR_ENABLE:
       hidirt_data_shadow.forward_ir_enable = buffer[0];
-      hidirt_data_shadow.data_update_pending = REP_ID_FORWARD_IR_ENABLE;
+      hidirt_data_shadow.data_update_pending |= UPDATE_FORWARD_IR_ENABLE;
       break;
 
    case REP_ID_POWER_ON_IR_CODE:
       memcpy(&hidirt_data_shadow.irmp_power_on,
              &buffer[0],
              sizeof(hidirt_data_shadow.irmp_power_on));
-      hidirt_data_shadow.data_update_pending = REP_ID_POWER_ON_IR_CODE;
+      hidirt_data_shadow.data_update_pending |= UPDATE_POWER_ON_IR_CODE;
       break;
 
    case REP_ID_POWER_OFF_IR_CODE:
       memcpy(&hidirt_data_shadow.irmp_power_off,
              &buffer[0],
              sizeof(hidirt_data_shadow.irmp_power_off));
-      hidirt_data_shadow.data_update_pending = REP_ID_POWER_OFF_IR_CODE;
+      hidirt_data_shadow.data_update_pending |= UPDATE_POWER_OFF_IR_CODE;
       break;
 
    case REP_ID_RESET_IR_CODE:
       memcpy(&hidirt_data_shadow.irmp_reset,
              &buffer[0],
              sizeof(hidirt_data_shadow.irmp_reset));
-      hidirt_data_shadow.data_update_pending = REP_ID_RESET_IR_CODE;
+      hidirt_data_shadow.data_update_pending |= UPDATE_RESET_IR_CODE;
       break;
 
    case REP_ID_MINIMUM_REPEATS:
       memcpy(&hidirt_data_shadow.min_ir_repeats,
              &buffer[0],
              sizeof(hidirt_data_shadow.min_ir_repeats));
-      hidirt_data_shadow.data_update_pending = REP_ID_MINIMUM_REPEATS;
+      hidirt_data_shadow.data_update_pending |= UPDATE_MINIMUM_REPEATS;
       break;
 
    case REP_ID_CURRENT_TIME:
@@ -243,7 +311,7 @@ static int8_t CustomHID_SetFeature(uint8_t event_idx, uint8_t* buffer)
       memcpy(&hidirt_data_shadow.clock_correction,
              &buffer[0],
              sizeof(hidirt_data_shadow.clock_correction));
-      hidirt_data_shadow.data_update_pending = REP_ID_CLOCK_CORRECTION;
+      hidirt_data_shadow.data_update_pending |= UPDATE_CLOCK_CORRECTION;
       break;
 
    case REP_ID_WAKEUP_TIME:
@@ -252,35 +320,87 @@ static int8_t CustomHID_SetFeature(uint8_t event_idx, uint8_t* buffer)
              sizeof(alarm));
       SWRTC_SetAlarmTime(0, alarm);
       HAL_RTCEx_BKUPWrite(&RtcHandle, BACKUP_REG_ALARM, alarm);
-      hidirt_data_shadow.data_update_pending = REP_ID_WAKEUP_TIME;
+      hidirt_data_shadow.data_update_pending |= UPDATE_WAKEUP_TIME;
       break;
 
    case REP_ID_WAKEUP_TIME_SPAN:
       memcpy(&hidirt_data_shadow.wakeup_time_span,
              &buffer[0],
              sizeof(hidirt_data_shadow.wakeup_time_span));
-      hidirt_data_shadow.data_update_pending = REP_ID_WAKEUP_TIME_SPAN;
+      hidirt_data_shadow.data_update_pending |= UPDATE_WAKEUP_TIME_SPAN;
+      break;
+
+   case REP_ID_PROTOCOL_MASK:
+      memcpy(&hidirt_data_shadow.protocol_mask,
+             &buffer[0],
+             sizeof(hidirt_data_shadow.protocol_mask));
+      hidirt_data_shadow.data_update_pending |= UPDATE_PROTOCOL_MASK;
+      break;
+
+   case REP_ID_POLLING_INTERVAL:
+      hidirt_data_shadow.polling_interval = buffer[0];
+      hidirt_data_shadow.data_update_pending |= UPDATE_POLLING_INTERVAL;
+      break;
+
+   case REP_ID_REPEAT_SHAPING:
+      memcpy(&hidirt_data_shadow.repeat,
+             &buffer[0],
+             sizeof(hidirt_data_shadow.repeat));
+      hidirt_data_shadow.data_update_pending |= UPDATE_REPEAT_SHAPING;
+      break;
+
+   case REP_ID_CONFIG_BLOB:
+      if(buffer[0] == CONFIG_BLOB_VERSION)
+      {
+         CustomHID_UnpackConfig(&hidirt_data_shadow, &buffer[0], CONFIG_BLOB_VERSION);
+         hidirt_data_shadow.data_update_pending |= UPDATE_CONFIG_BLOB;
+      }
+      else if(buffer[0] == 1)
+      {
+         // written by older host tools, the repeat shaping stays
+         CustomHID_UnpackConfig(&hidirt_data_shadow, &buffer[0], 1);
+         hidirt_data_shadow.data_update_pending |= UPDATE_CONFIG_BLOB_V1;
+      }
       break;
 
    case REP_ID_REQUEST_BOOTLOADER:
       if(buffer[0] == 0x5a)
-         hidirt_data_shadow.data_update_pending = REP_ID_REQUEST_BOOTLOADER;
+         hidirt_data_shadow.data_update_pending |= UPDATE_REQUEST_BOOTLOADER;
       break;
 
    case REP_ID_WATCHDOG_ENABLE:
       hidirt_data_shadow.watchdog_enable = buffer[0];
-      hidirt_data_shadow.data_update_pending = REP_ID_WATCHDOG_ENABLE;
+      hidirt_data_shadow.data_update_pending |= UPDATE_WATCHDOG_ENABLE;
       break;
 
    case REP_ID_WATCHDOG_RESET:
       hidirt_data_shadow.watchdog_reset = buffer[0];
-      hidirt_data_shadow.data_update_pending = REP_ID_WATCHDOG_RESET;
+      hidirt_data_shadow.data_update_pending |= UPDATE_WATCHDOG_RESET;
+      break;
+
+   case REP_ID_CAPTURE_CONTROL:
+      // not part of the configuration, main applies it on EVENT_CAPTURE
+      CAPTURE_Control(buffer[0], buffer[1]);
+      break;
+
+   case REP_ID_LEARN_CONTROL:
+      // not part of the configuration, main applies it on EVENT_LEARN
+      LEARN_Control(buffer[0], buffer[1]);
+      break;
+
+   case REP_ID_ACTION_ENTRY:
+      // not part of the configuration, main applies it on EVENT_ACTION
+      ACTION_SetEntry(&buffer[0]);
       break;
 
    default: /* Report does not exist */
       break;
    }
 
+   // let main apply the new value
+   if(hidirt_data_shadow.data_update_pending)
+      SetEvent(EVENT_CONFIG_UPDATE);
+
    return (USBD_OK);
 }
 
@@ -298,12 +418,19 @@ static int8_t CustomHID_GetFeature(uint8_t event_idx, uint8_t* buffer, uint16_t*
 {
    swrtc_time_t   time;
    uint32_t       alarm;
+   uint32_t       latency;
+   cpu_load_t     load;
+   USBD_CUSTOM_HID_InStatsTypeDef in_stats;
 
    // clear transmission data array
    memset(buffer, 0x00, *length);
 
-   // retrieve currently valid config
-   GetHidirtConfig(&hidirt_data_shadow);
+   // retrieve currently valid config, unless the shadow holds updates that
+   // main has not applied yet
+   if(hidirt_data_shadow.data_update_pending == 0)
+   {
+      GetHidirtConfig(&hidirt_data_shadow);
+   }
 
    switch(event_idx)
    {
@@ -375,12 +502,67 @@ static int8_t CustomHID_GetFeature(uint8_t event_idx, uint8_t* buffer, uint16_t*
              sizeof(hidirt_data_shadow.wakeup_time_span));
       break;
 
+   case REP_ID_PROTOCOL_MASK:
+      memcpy(&buffer[0],
+             &hidirt_data_shadow.protocol_mask,
+             sizeof(hidirt_data_shadow.protocol_mask));
+      break;
+
+   case REP_ID_POLLING_INTERVAL:
+      memcpy(&buffer[0],
+             &hidirt_data_shadow.polling_interval,
+             sizeof(hidirt_data_shadow.polling_interval));
+      break;
+
+   case REP_ID_REPEAT_SHAPING:
+      memcpy(&buffer[0],
+             &hidirt_data_shadow.repeat,
+             sizeof(hidirt_data_shadow.repeat));
+      break;
+
+   case REP_ID_CONFIG_BLOB:
+      CustomHID_PackConfig(&hidirt_data_shadow, &buffer[0]);
+      break;
+
+   case REP_ID_IR_ISR_LATENCY:
+      latency = IRMP_GetIsrLatency();
+      memcpy(&buffer[0],
+             &latency,
+             sizeof(latency));
+      break;
+
+   case REP_ID_CPU_LOAD:
+      GetCpuLoad(&load);
+      memcpy(&buffer[0],
+             &load,
+             sizeof(load));
+      break;
+
+   case REP_ID_IN_REPORT_STATS:
+      USBD_CUSTOM_HID_GetInStats(&in_stats);
+      memcpy(&buffer[0],
+             &in_stats,
+             sizeof(in_stats));
+      break;
+
    case REP_ID_WATCHDOG_ENABLE:
       memcpy(&buffer[0],
              &hidirt_data_shadow.watchdog_enable,
              sizeof(hidirt_data_shadow.watchdog_enable));
       break;
 
+   case REP_ID_CAPTURE_CONTROL:
+      CAPTURE_GetControl(&buffer[0]);
+      break;
+
+   case REP_ID_LEARN_CONTROL:
+      LEARN_GetControl(&buffer[0]);
+      break;
+
+   case REP_ID_ACTION_ENTRY:
+      ACTION_GetEntry(&buffer[0]);
+      break;
+
    default: /* Report does not exist */
       return (USBD_FAIL);
       break;
@@ -422,6 +604,7 @@ uint16_t CustomHID_FeatureReportLength(uint8_t event_idx)
 
    case REP_ID_MINIMUM_REPEATS:
    case REP_ID_WAKEUP_TIME_SPAN:
+   case REP_ID_POLLING_INTERVAL:
    case REP_ID_REQUEST_BOOTLOADER:
       length = sizeof(uint8_t);
       break;
@@ -432,130 +615,380 @@ uint16_t CustomHID_FeatureReportLength(uint8_t event_idx)
 
    case REP_ID_CLOCK_CORRECTION:
    case REP_ID_WAKEUP_TIME:
+   case REP_ID_IR_ISR_LATENCY:
       length = sizeof(hidirt_data_shadow.clock_correction);
       break;
 
-   default:
+   case REP_ID_PROTOCOL_MASK:
+      length = sizeof(hidirt_data_shadow.protocol_mask);
       break;
-   }
-
-   return length;
-}
 
-/**
-  * @brief  Allows main to read the last configuration parameters received via
-  *         USB and also stores them into the EEPROM.
-  * @param  *config holds the updated configuration afterwards.
-  */
-void GetHidirtShadowConfig(hidirt_data_t *config)
-{
-   uint32_t wut;
-
-   __disable_irq();
-   switch(hidirt_data_shadow.data_update_pending)    // switch data to update
-   {
-   case REP_ID_CONTROL_PC_ENABLE:
-      memcpy(&config->control_pc_enable,
-            &hidirt_data_shadow.control_pc_enable,
-            sizeof(config->control_pc_enable));
-      EEPROM_WriteBytes(ADDRESS_control_pc_enable,
-            &hidirt_data_shadow.control_pc_enable,
-            sizeof(hidirt_data_shadow.control_pc_enable));
+   case REP_ID_CPU_LOAD:
+      length = sizeof(cpu_load_t);
       break;
 
-   case REP_ID_FORWARD_IR_ENABLE:
-      memcpy(&config->forward_ir_enable,
-            &hidirt_data_shadow.forward_ir_enable,
-            sizeof(config->forward_ir_enable));
-      EEPROM_WriteBytes(ADDRESS_forward_ir_enable,
-            &hidirt_data_shadow.forward_ir_enable,
-            sizeof(hidirt_data_shadow.forward_ir_enable));
+   case REP_ID_IN_REPORT_STATS:
+      length = sizeof(USBD_CUSTOM_HID_InStatsTypeDef);
       break;
 
-   case REP_ID_POWER_ON_IR_CODE:
-      memcpy(&config->irmp_power_on,
-            &hidirt_data_shadow.irmp_power_on,
-            sizeof(config->irmp_power_on));
-      EEPROM_WriteBytes(ADDRESS_irmp_power_on,
-            &hidirt_data_shadow.irmp_power_on,
-            sizeof(hidirt_data_shadow.irmp_power_on));
+   case REP_ID_CONFIG_BLOB:
+      length = CONFIG_BLOB_SIZE;
       break;
 
-   case REP_ID_POWER_OFF_IR_CODE:
-      memcpy(&config->irmp_power_off,
-            &hidirt_data_shadow.irmp_power_off,
-            sizeof(config->irmp_power_off));
-      EEPROM_WriteBytes(ADDRESS_irmp_power_off,
-            &hidirt_data_shadow.irmp_power_off,
-            sizeof(hidirt_data_shadow.irmp_power_off));
+   case REP_ID_CAPTURE_CONTROL:
+      length = CAPTURE_CONTROL_SIZE;
       break;
 
-   case REP_ID_RESET_IR_CODE:
-      memcpy(&config->irmp_reset,
-            &hidirt_data_shadow.irmp_reset,
-            sizeof(config->irmp_reset));
-      EEPROM_WriteBytes(ADDRESS_irmp_reset,
-            &hidirt_data_shadow.irmp_reset,
-            sizeof(hidirt_data_shadow.irmp_reset));
+   case REP_ID_LEARN_CONTROL:
+      length = LEARN_CONTROL_SIZE;
       break;
 
-   case REP_ID_MINIMUM_REPEATS:
-      memcpy(&config->min_ir_repeats,
-            &hidirt_data_shadow.min_ir_repeats,
-            sizeof(config->min_ir_repeats));
-      EEPROM_WriteBytes(ADDRESS_min_ir_repeats,
-            &hidirt_data_shadow.min_ir_repeats,
-            sizeof(hidirt_data_shadow.min_ir_repeats));
+   case REP_ID_ACTION_ENTRY:
+      length = ACTION_REPORT_SIZE;
       break;
 
-   case REP_ID_CLOCK_CORRECTION:
-      memcpy(&config->clock_correction,
-            &hidirt_data_shadow.clock_correction,
-            sizeof(config->clock_correction));
-      EEPROM_WriteBytes(ADDRESS_clock_correction,
-            &hidirt_data_shadow.clock_correction,
-            sizeof(hidirt_data_shadow.clock_correction));
-      SWRTC_SetDeviation(config->clock_correction);
+   case REP_ID_REPEAT_SHAPING:
+      length = REPEAT_REPORT_SIZE;
       break;
 
-   case REP_ID_WAKEUP_TIME:
-      wut = SWRTC_GetAlarmTime(0);
-      SWRTC_SetAlarmTime(1, wut+config->wakeup_time_span*60);
+   default:
       break;
+   }
 
-   case REP_ID_WAKEUP_TIME_SPAN:
-      memcpy(&config->wakeup_time_span,
-            &hidirt_data_shadow.wakeup_time_span,
-            sizeof(config->wakeup_time_span));
-      EEPROM_WriteBytes(ADDRESS_wakeup_time_span,
-            &hidirt_data_shadow.wakeup_time_span,
-            sizeof(hidirt_data_shadow.wakeup_time_span));
-      wut = SWRTC_GetAlarmTime(0);
-      SWRTC_SetAlarmTime(1, wut+config->wakeup_time_span*60);
-      break;
+   return length;
+}
 
-   case REP_ID_REQUEST_BOOTLOADER:
-      HAL_RTCEx_BKUPWrite(&RtcHandle, BACKUP_REG_BOOTLOADER, 0xABADC0DE);
-      while(1);
-      break;
+/**
+  * @brief  Stores a value little endian.
+  * @param  *dst destination, size bytes are written.
+  * @param  value
+  * @param  size number of bytes.
+  * @return Position after the value.
+  */
+static uint8_t* PutLE(uint8_t *dst, uint64_t value, uint8_t size)
+{
+   while(size--)
+   {
+      *dst++ = value;
+      value >>= 8;
+   }
+   return dst;
+}
 
-   case REP_ID_WATCHDOG_ENABLE:
-      memcpy(&config->watchdog_enable,
-            &hidirt_data_shadow.watchdog_enable,
-            sizeof(config->watchdog_enable));
-      break;
+/**
+  * @brief  Reads a little endian value.
+  * @param  **src source, advanced by size bytes.
+  * @param  size number of bytes.
+  * @return Value read.
+  */
+static uint64_t GetLE(const uint8_t **src, uint8_t size)
+{
+   uint64_t value = 0;
+   uint8_t  idx;
 
-   case REP_ID_WATCHDOG_RESET:
-      memcpy(&config->watchdog_reset,
-            &hidirt_data_shadow.watchdog_reset,
-            sizeof(config->watchdog_reset));
-      break;
+   for(idx = 0; idx < size; idx++)
+   {
+      value |= (uint64_t)*(*src)++ << (8*idx);
+   }
+   return value;
+}
 
-   default:
-      break;
+/**
+  * @brief  Stores an IRMP_DATA little endian.
+  * @param  *dst destination, 6 bytes are written.
+  * @param  *data
+  * @return Position after the data.
+  */
+static uint8_t* PutIrmpData(uint8_t *dst, const IRMP_DATA *data)
+{
+   dst = PutLE(dst, data->protocol, 1);
+   dst = PutLE(dst, data->address, 2);
+   dst = PutLE(dst, data->command, 2);
+   return PutLE(dst, data->flags, 1);
+}
+
+/**
+  * @brief  Reads a little endian IRMP_DATA.
+  * @param  **src source, advanced by 6 bytes.
+  * @param  *data receives the data.
+  */
+static void GetIrmpData(const uint8_t **src, IRMP_DATA *data)
+{
+   data->protocol = GetLE(src, 1);
+   data->address = GetLE(src, 2);
+   data->command = GetLE(src, 2);
+   data->flags = GetLE(src, 1);
+}
+
+/**
+  * @brief  Packs the configuration into the REP_ID_CONFIG_BLOB layout. All
+  *         multi-byte values are little endian:
+  *          0  version (CONFIG_BLOB_VERSION)
+  *          1  clock_correction (int32)
+  *          5  protocol_mask (uint64)
+  *         13  min_ir_repeats
+  *         14  wakeup_time_span
+  *         15  polling_interval
+  *         16  control_pc_enable
+  *         17  forward_ir_enable
+  *         18  irmp_power_on  (protocol, address (16), command (16), flags)
+  *         24  irmp_power_off
+  *         30  irmp_reset
+  *         36  repeat delay (uint16), since version 2
+  *         38  repeat period (uint16)
+  *         40  repeat timeout (uint16)
+  *         Version 1 ends after irmp_reset.
+  * @param  *config configuration to pack.
+  * @param  *blob CONFIG_BLOB_SIZE bytes.
+  */
+static void CustomHID_PackConfig(const hidirt_data_t *config, uint8_t *blob)
+{
+   blob = PutLE(blob, CONFIG_BLOB_VERSION, 1);
+   blob = PutLE(blob, (uint32_t)config->clock_correction, 4);
+   blob = PutLE(blob, config->protocol_mask, 8);
+   blob = PutLE(blob, config->min_ir_repeats, 1);
+   blob = PutLE(blob, config->wakeup_time_span, 1);
+   blob = PutLE(blob, config->polling_interval, 1);
+   blob = PutLE(blob, config->control_pc_enable, 1);
+   blob = PutLE(blob, config->forward_ir_enable, 1);
+   blob = PutIrmpData(blob, &config->irmp_power_on);
+   blob = PutIrmpData(blob, &config->irmp_power_off);
+   blob = PutIrmpData(blob, &config->irmp_reset);
+   blob = PutLE(blob, config->repeat.delay, 2);
+   blob = PutLE(blob, config->repeat.period, 2);
+   blob = PutLE(blob, config->repeat.timeout, 2);
+}
+
+/**
+  * @brief  Unpacks a REP_ID_CONFIG_BLOB, see CustomHID_PackConfig().
+  * @param  *config receives the configuration.
+  * @param  *blob CONFIG_BLOB_SIZE bytes, the version byte is not checked.
+  * @param  version: 1 leaves the repeat shaping untouched.
+  */
+static void CustomHID_UnpackConfig(hidirt_data_t *config, const uint8_t *blob,
+                                   uint8_t version)
+{
+   blob++;  // version
+   config->clock_correction = (int32_t)GetLE(&blob, 4);
+   config->protocol_mask = GetLE(&blob, 8);
+   config->min_ir_repeats = GetLE(&blob, 1);
+   config->wakeup_time_span = GetLE(&blob, 1);
+   config->polling_interval = GetLE(&blob, 1);
+   config->control_pc_enable = GetLE(&blob, 1);
+   config->forward_ir_enable = GetLE(&blob, 1);
+   GetIrmpData(&blob, &config->irmp_power_on);
+   GetIrmpData(&blob, &config->irmp_power_off);
+   GetIrmpData(&blob, &config->irmp_reset);
+   if(version >= 2)
+   {
+      config->repeat.delay = GetLE(&blob, 2);
+      config->repeat.period = GetLE(&blob, 2);
+      config->repeat.timeout = GetLE(&blob, 2);
+   }
+}
+
+/**
+  * @brief  Allows main to read all configuration parameters received via USB
+  *         since the last call and also stores them into the EEPROM.
+  * @param  *config holds the updated configuration afterwards.
+  */
+void GetHidirtShadowConfig(hidirt_data_t *config)
+{
+   uint32_t  wut;
+   uint16_t  pending;
+   uint16_t  update;
+   uint16_t  requested;
+   uint16_t  retry = 0;
+   IRMP_DATA power_on;
+   IRMP_DATA power_off;
+   IRMP_DATA reset;
+
+   ATOMIC_BLOCK_CRITICAL
+   {
+      pending = hidirt_data_shadow.data_update_pending;
+      requested = pending;
+      while(pending)
+      {
+         update = pending & -pending;  // lowest pending update first
+         pending &= ~update;
+         switch(update)    // switch data to update
+         {
+         case UPDATE_CONTROL_PC_ENABLE:
+            memcpy(&config->control_pc_enable,
+                  &hidirt_data_shadow.control_pc_enable,
+                  sizeof(config->control_pc_enable));
+            if(EEPROM_WriteBytesDeferred(ADDRESS_control_pc_enable,
+                  &hidirt_data_shadow.control_pc_enable,
+                  sizeof(hidirt_data_shadow.control_pc_enable)) != HAL_OK)
+            {
+               retry |= update;
+            }
+            break;
+
+         case UPDATE_FORWARD_IR_ENABLE:
+            memcpy(&config->forward_ir_enable,
+                  &hidirt_data_shadow.forward_ir_enable,
+                  sizeof(config->forward_ir_enable));
+            if(EEPROM_WriteBytesDeferred(ADDRESS_forward_ir_enable,
+                  &hidirt_data_shadow.forward_ir_enable,
+                  sizeof(hidirt_data_shadow.forward_ir_enable)) != HAL_OK)
+            {
+               retry |= update;
+            }
+            break;
+
+         case UPDATE_POWER_ON_IR_CODE:
+            // applied below, the table is not changed in the atomic block
+            memcpy(&power_on, &hidirt_data_shadow.irmp_power_on, sizeof(power_on));
+            break;
+
+         case UPDATE_POWER_OFF_IR_CODE:
+            // applied below, the table is not changed in the atomic block
+            memcpy(&power_off, &hidirt_data_shadow.irmp_power_off, sizeof(power_off));
+            break;
+
+         case UPDATE_RESET_IR_CODE:
+            // applied below, the table is not changed in the atomic block
+            memcpy(&reset, &hidirt_data_shadow.irmp_reset, sizeof(reset));
+            break;
+
+         case UPDATE_MINIMUM_REPEATS:
+            memcpy(&config->min_ir_repeats,
+                  &hidirt_data_shadow.min_ir_repeats,
+                  sizeof(config->min_ir_repeats));
+            if(EEPROM_WriteBytesDeferred(ADDRESS_min_ir_repeats,
+                  &hidirt_data_shadow.min_ir_repeats,
+                  sizeof(hidirt_data_shadow.min_ir_repeats)) != HAL_OK)
+            {
+               retry |= update;
+            }
+            break;
+
+         case UPDATE_CLOCK_CORRECTION:
+            memcpy(&config->clock_correction,
+                  &hidirt_data_shadow.clock_correction,
+                  sizeof(config->clock_correction));
+            if(EEPROM_WriteBytesDeferred(ADDRESS_clock_correction,
+                  &hidirt_data_shadow.clock_correction,
+                  sizeof(hidirt_data_shadow.clock_correction)) != HAL_OK)
+            {
+               retry |= update;
+            }
+            SWRTC_SetDeviation(config->clock_correction);
+            break;
+
+         case UPDATE_WAKEUP_TIME:
+            wut = SWRTC_GetAlarmTime(0);
+            SWRTC_SetAlarmTime(1, wut+config->wakeup_time_span*60);
+            break;
+
+         case UPDATE_WAKEUP_TIME_SPAN:
+            memcpy(&config->wakeup_time_span,
+                  &hidirt_data_shadow.wakeup_time_span,
+                  sizeof(config->wakeup_time_span));
+            if(EEPROM_WriteBytesDeferred(ADDRESS_wakeup_time_span,
+                  &hidirt_data_shadow.wakeup_time_span,
+                  sizeof(hidirt_data_shadow.wakeup_time_span)) != HAL_OK)
+            {
+               retry |= update;
+            }
+            wut = SWRTC_GetAlarmTime(0);
+            SWRTC_SetAlarmTime(1, wut+config->wakeup_time_span*60);
+            break;
+
+         case UPDATE_PROTOCOL_MASK:
+            memcpy(&config->protocol_mask,
+                  &hidirt_data_shadow.protocol_mask,
+                  sizeof(config->protocol_mask));
+            if(EEPROM_WriteBytesDeferred(ADDRESS_protocol_mask,
+                  &hidirt_data_shadow.protocol_mask,
+                  sizeof(hidirt_data_shadow.protocol_mask)) != HAL_OK)
+            {
+               retry |= update;
+            }
+            irmp_set_protocol_mask(config->protocol_mask ? config->protocol_mask : IRMP_ALL_PROTOCOLS);
+            break;
+
+         case UPDATE_POLLING_INTERVAL:
+            memcpy(&config->polling_interval,
+                  &hidirt_data_shadow.polling_interval,
+                  sizeof(config->polling_interval));
+            if(EEPROM_WriteBytesDeferred(ADDRESS_polling_interval,
+                  &hidirt_data_shadow.polling_interval,
+                  sizeof(hidirt_data_shadow.polling_interval)) != HAL_OK)
+            {
+               retry |= update;
+            }
+            // used from the next enumeration on
+            USBD_CUSTOM_HID_SetPollingInterval(config->polling_interval);
+            break;
+
+         case UPDATE_REPEAT_SHAPING:
+            memcpy(&config->repeat,
+                  &hidirt_data_shadow.repeat,
+                  sizeof(config->repeat));
+            if(EEPROM_WriteBytesDeferred(ADDRESS_repeat_shaping,
+                  &hidirt_data_shadow.repeat,
+                  sizeof(hidirt_data_shadow.repeat)) != HAL_OK)
+            {
+               retry |= update;
+            }
+            break;
+
+         case UPDATE_REQUEST_BOOTLOADER:
+            // started below, after the EEPROM has been written
+            break;
+
+         case UPDATE_WATCHDOG_ENABLE:
+            memcpy(&config->watchdog_enable,
+                  &hidirt_data_shadow.watchdog_enable,
+                  sizeof(config->watchdog_enable));
+            break;
+
+         case UPDATE_WATCHDOG_RESET:
+            memcpy(&config->watchdog_reset,
+                  &hidirt_data_shadow.watchdog_reset,
+                  sizeof(config->watchdog_reset));
+            break;
+
+         default:
+            break;
+         }
+      }
+      // values the full write-back cache didn't take are stored again
+      hidirt_data_shadow.data_update_pending = retry;
+   }
+
+   if(retry)
+   {
+      SetEvent(EVENT_CONFIG_UPDATE);
+   }
+
+   // moves the action to the entry of the code
+   if(requested & UPDATE_POWER_ON_IR_CODE)
+   {
+      ACTION_Assign(&power_on, ACTION_POWER_ON);
+      ACTION_GetCode(ACTION_POWER_ON, &config->irmp_power_on);
+   }
+   if(requested & UPDATE_POWER_OFF_IR_CODE)
+   {
+      ACTION_Assign(&power_off, ACTION_POWER_OFF);
+      ACTION_GetCode(ACTION_POWER_OFF, &config->irmp_power_off);
+   }
+   if(requested & UPDATE_RESET_IR_CODE)
+   {
+      ACTION_Assign(&reset, ACTION_RESET);
+      ACTION_GetCode(ACTION_RESET, &config->irmp_reset);
+   }
+
+   if(requested & UPDATE_REQUEST_BOOTLOADER)
+   {
+      // commit pending values with interrupts enabled, the main loop won't
+      // run again
+      EEPROM_CommitAll();
+      HAL_RTCEx_BKUPWrite(&RtcHandle, BACKUP_REG_BOOTLOADER, 0xABADC0DE);
+      while(1);
    }
-   hidirt_data_shadow.data_update_pending = 0;
-   __enable_irq();
 }
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,278 @@
+/**
+ * @file       hidirt_capture.c
+ * @brief      Host tool: streams the raw IR input of HIDIRT and converts it
+ *             into the IRMP scan format ('0' per pulse tick, '1' per pause
+ *             tick, one burst per line), which irmp -a/-v can analyze.
+ *
+ * @details    Build: gcc -O2 -o hidirt_capture tools/hidirt_capture.c
+ *
+ *             hidirt_capture /dev/hidrawN > remote.txt
+ *                enables capturing, converts the stream until Ctrl-C and
+ *                disables capturing again (Linux only).
+ *             hidirt_capture -r reports.bin > remote.txt
+ *                converts recorded REP_ID_CAPTURE_DATA reports, each
+ *                including the report ID.
+ *
+ *             -f sets the tick rate of the firmware (F_INTERRUPTS, default
+ *             15000). See capture.h for the stream format.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+#endif
+
+#define REP_ID_CAPTURE_DATA      2
+#define REP_ID_CAPTURE_CONTROL   0x21
+#define CAPTURE_REPORT_SIZE      31      /* without report ID */
+#define CREDITS_LOW              16      /* grant more below, the kernel */
+#define CREDITS_GRANT            32      /* buffers 64 reports per reader */
+
+typedef struct DECODER
+{
+   unsigned    idle_ticks;    /* pause ending a burst */
+   uint32_t    value;         /* varint being decoded */
+   unsigned    shift;
+   int         sequence;      /* expected sequence, -1: unknown */
+   int         column;        /* characters in the current line */
+   unsigned long runs;
+   unsigned long lost;        /* overruns and lost reports */
+} decoder_t;
+
+static volatile sig_atomic_t stop;
+
+/**
+  * @brief  Starts a comment line.
+  */
+static void Comment(decoder_t *dec, const char *text, unsigned long n)
+{
+   if(dec->column)
+   {
+      putchar('\n');
+      dec->column = 0;
+   }
+   printf("# %s %lu\n", text, n);
+}
+
+/**
+  * @brief  Writes one run.
+  */
+static void Run(decoder_t *dec, uint32_t value)
+{
+   unsigned ticks = value >> 1;
+   int      c = (value & 1) ? '1' : '0';
+
+   dec->runs++;
+   if(value == 0)
+   {
+      dec->lost++;
+      Comment(dec, "runs lost, overrun", dec->lost);
+      return;
+   }
+
+   if(c == '1' && ticks >= dec->idle_ticks)
+   {
+      if(dec->column)
+      {
+         putchar('\n');   // a newline is a long pause for irmp
+         dec->column = 0;
+      }
+      return;
+   }
+
+   while(ticks--)
+   {
+      putchar(c);
+   }
+   dec->column = 1;
+}
+
+/**
+  * @brief  Decodes the runs of one REP_ID_CAPTURE_DATA report.
+  * @param  report: without report ID
+  */
+static void Report(decoder_t *dec, const uint8_t *report)
+{
+   uint8_t len = report[1];
+   uint8_t i;
+
+   if(dec->sequence >= 0 && report[0] != dec->sequence)
+   {
+      dec->lost++;
+      Comment(dec, "reports lost", (uint8_t)(report[0] - dec->sequence));
+      dec->value = 0;
+      dec->shift = 0;
+   }
+   dec->sequence = (uint8_t)(report[0] + 1);
+
+   if(len > CAPTURE_REPORT_SIZE - 2)
+   {
+      len = CAPTURE_REPORT_SIZE - 2;
+   }
+
+   for(i = 0; i < len; i++)
+   {
+      dec->value |= (uint32_t)(report[2+i] & 0x7F) << dec->shift;
+      dec->shift += 7;
+      if(!(report[2+i] & 0x80) || dec->shift > 21)
+      {
+         Run(dec, dec->value);
+         dec->value = 0;
+         dec->shift = 0;
+      }
+   }
+   fflush(stdout);
+}
+
+static void Stop(int sig)
+{
+   (void) sig;
+   stop = 1;
+}
+
+#if defined(__linux__)
+/**
+  * @brief  Sends REP_ID_CAPTURE_CONTROL.
+  */
+static int Control(int fd, int enable, int credits)
+{
+   uint8_t buf[3] = { REP_ID_CAPTURE_CONTROL, enable, credits };
+
+   return ioctl(fd, HIDIOCSFEATURE(sizeof(buf)), buf) < 0 ? -1 : 0;
+}
+
+static int Stream(const char *device, decoder_t *dec)
+{
+   uint8_t       buf[64];
+   struct pollfd pfd;
+   int           credits = CREDITS_GRANT;
+   int           draining = 0;
+   int           n;
+
+   if((pfd.fd = open(device, O_RDWR)) < 0 || Control(pfd.fd, 1, credits) < 0)
+   {
+      perror(device);
+      return 1;
+   }
+   pfd.events = POLLIN;
+   signal(SIGINT, Stop);
+   signal(SIGTERM, Stop);
+   printf("# hidirt_capture %s, %u ticks ending a burst\n", device, dec->idle_ticks);
+
+   while(1)
+   {
+      if(stop && !draining)
+      {
+         Control(pfd.fd, 0, 0);   // the device sends the rest
+         draining = 1;
+      }
+
+      n = poll(&pfd, 1, draining ? 200 : 500);
+      if(n == 0 && draining)
+      {
+         break;
+      }
+      if(n <= 0)
+      {
+         continue;
+      }
+
+      n = read(pfd.fd, buf, sizeof(buf));
+      if(n < 0)
+      {
+         perror(device);
+         break;
+      }
+      if(n < 1 + CAPTURE_REPORT_SIZE || buf[0] != REP_ID_CAPTURE_DATA)
+      {
+         continue;   // IR codes
+      }
+
+      Report(dec, &buf[1]);
+      if(--credits <= CREDITS_LOW && !draining)
+      {
+         credits += CREDITS_GRANT;
+         Control(pfd.fd, 1, CREDITS_GRANT);
+      }
+   }
+
+   close(pfd.fd);
+   return 0;
+}
+#endif
+
+int main(int argc, char **argv)
+{
+   decoder_t dec = { 0 };
+   uint8_t   buf[1+CAPTURE_REPORT_SIZE];
+   unsigned  f_interrupts = 15000;
+   const char *raw = NULL;
+   FILE      *fp;
+   int       opt;
+   int       rc = 0;
+
+   while((opt = getopt(argc, argv, "f:r:")) != -1)
+   {
+      switch(opt)
+      {
+      case 'f':
+         f_interrupts = atoi(optarg);
+         break;
+      case 'r':
+         raw = optarg;
+         break;
+      default:
+         fprintf(stderr, "usage: %s [-f ticks/s] /dev/hidrawN | -r reports.bin\n", argv[0]);
+         return 2;
+      }
+   }
+
+   dec.idle_ticks = (unsigned)(f_interrupts * 150.0e-3 + 0.5);   // CAPTURE_IDLE_TICKS
+   dec.sequence = -1;
+
+   if(raw)
+   {
+      if((fp = fopen(raw, "rb")) == NULL)
+      {
+         perror(raw);
+         return 1;
+      }
+      while(fread(buf, sizeof(buf), 1, fp) == 1)
+      {
+         if(buf[0] == REP_ID_CAPTURE_DATA)
+         {
+            Report(&dec, &buf[1]);
+         }
+      }
+      fclose(fp);
+   }
+   else if(optind < argc)
+   {
+#if defined(__linux__)
+      rc = Stream(argv[optind], &dec);
+#else
+      fprintf(stderr, "%s: streaming needs Linux hidraw, use -r\n", argv[0]);
+      rc = 1;
+#endif
+   }
+   else
+   {
+      fprintf(stderr, "usage: %s [-f ticks/s] /dev/hidrawN | -r reports.bin\n", argv[0]);
+      return 2;
+   }
+
+   if(dec.column)
+   {
+      putchar('\n');
+   }
+   fprintf(stderr, "%lu runs, %lu gaps\n", dec.runs, dec.lost);
+   return rc;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file       fifos.h
+ * @brief      Instance of the FIFO template for the host test (test_fifo.c).
+ *
+ * @details    The firmware uses the single FIFO of fifo.h. This file defines
+ *             the instance TEST with its own entry type and size, the way the
+ *             fifos.h of a project with several FIFOs does.
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef FIFOS_H
+#define FIFOS_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported macro ------------------------------------------------------------*/
+#define FIFOS_CONCAT(prefix, name)  prefix##_##name
+#define FIFOS(prefix, name)         FIFOS_CONCAT(prefix, name)
+
+/* Exported types ------------------------------------------------------------*/
+/**
+* @brief       The format of one entry of the TEST FIFO.
+*/
+typedef struct TEST_FIFO_ENTRY {
+   uint32_t sequence;
+   uint8_t  producer;
+} TEST_fifo_entry_t;
+
+/* Exported instances --------------------------------------------------------*/
+#define FIFO_PREFIX     TEST
+#undef FIFO_SIZE
+#define FIFO_SIZE       8
+#include "fifo.h"
+
+#endif /* FIFOS_H */
@@ -0,0 +1,69 @@
+/**
+ * @file       host.h
+ * @brief      Lets the host tests compile firmware modules with gcc on a PC.
+ *
+ * @details    A test includes this header and then the source file of the
+ *             module under test, so it reaches the static functions and
+ *             variables. The HAL headers only provide types and defines on
+ *             the host. The atomic blocks and barriers that need ARM
+ *             instructions are replaced here, the test runs single-threaded
+ *             unless it says otherwise. See run.sh for the build.
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "configuration.h"
+#include "cm_atomic.h"
+#include "application.h"
+
+#undef  ATOMIC_BLOCK_CRITICAL
+#define ATOMIC_BLOCK_CRITICAL    for(int host_once = 1; host_once; host_once = 0)
+#undef  __DMB
+#define __DMB()                  __sync_synchronize()
+
+static int host_checks;
+static int host_fails;
+
+#define CHECK(cond)              do { host_checks++; if(!(cond)) { \
+                                    if(host_fails++ < 20) printf("FAIL %s:%d %s\n", \
+                                    __FILE__, __LINE__, #cond); } } while(0)
+
+/**
+  * @brief  Prints the result, returns the exit code of the test.
+  */
+static inline int HOST_Result(void)
+{
+   printf("%d checks, %d failed\n", host_checks, host_fails);
+   return host_fails != 0;
+}
+
+/**
+  * @brief  Pseudo random numbers, the same sequence on every run.
+  */
+static inline uint32_t HOST_Random(void)
+{
+   static uint32_t seed = 12345;
+
+   seed = seed * 1103515245 + 12345;
+   return seed >> 8;
+}
+
+/**
+  * @brief  Monotonic time in ns for the benchmarks.
+  */
+static inline double HOST_Nanoseconds(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+#endif /* HOST_H */
@@ -0,0 +1,40 @@
+#!/bin/sh
+# Builds and runs the host tests and benchmarks for both devices.
+# Usage: tools/test/run.sh [test ...], from the top directory
+set -e
+
+TESTS=${*:-"test_store test_fifo test_config test_seqlock test_capture test_action test_learn test_keyboard sim_repeat sim_duplex sim_latency"}
+OUT=${OUT:-/tmp/hidirt_test}
+mkdir -p "$OUT"
+
+for device in STM32F103xB STM32L151xB; do
+   family=$( [ $device = STM32F103xB ] && echo F1 || echo L1 )
+   for test in $TESTS; do
+      # the record store keeps its own flash pages on the STM32F1xx only
+      [ $test = test_store ] && [ $family = L1 ] && continue
+      # PC builds of IRMP and IRSND (ANALYZE), the same for both devices
+      if [ $test = sim_duplex ]; then
+         [ $family = L1 ] && continue
+         echo "== $test"
+         gcc -O2 -Wall -Wextra -Iinc src/irsnd.c -o "$OUT/irsnd"
+         gcc -O2 -Wall -Wextra -Iinc tools/test/$test.c -o "$OUT/$test" -lm -lpthread
+         "$OUT/$test" "$OUT/irsnd"
+         continue
+      fi
+      # application.c needs the HAL, only the functions the test calls are linked
+      gc=""
+      [ $test = test_seqlock ] && gc="-ffunction-sections -fdata-sections -Wl,--gc-sections"
+      echo "== $test $device"
+      gcc -O2 -std=gnu99 -Wall -Wextra $gc -D$device -DUSE_HAL_DRIVER \
+          -Itools/test -Iinc -Ilib/CMSIS/Include -Ilib/Device/STM32${family}xx/Include \
+          -Ilib/STM32${family}xx_HAL_Driver/Inc -Ilib/STM32_USB_Device_Library/Core/Inc \
+          -Ilib/STM32F1xx_HAL_EEPROM/Inc \
+          tools/test/$test.c -o "$OUT/${test}_$family" -lpthread
+      # recorded input of a test, if any
+      if [ -f tools/test/$test.txt ]; then
+         "$OUT/${test}_$family" tools/test/$test.txt
+      else
+         "$OUT/${test}_$family"
+      fi
+   done
+done
@@ -0,0 +1,432 @@
+/**
+ * @file       sim_duplex.c
+ * @brief      Host simulation of the loss rate while IRSND forwards frames.
+ *
+ * @details    IRMP (the ANALYZE build of irmp.c) decodes the IR input of a
+ *             device that forwards every frame it receives with IRSND and
+ *             sees its own IR diode. Remotes press keys at random times, a
+ *             NEC remote every 1.2 s on average and a second one with RC5 or
+ *             SIRCS every 2.5 s, so frames of the remotes and of the diode
+ *             overlap. The waveforms come from the ANALYZE build of irsnd.c.
+ *             The input is the OR of all pulses, like a receiver sees it.
+ *
+ *             Four ways to run IRMP are compared:
+ *             - blind:   irmp_ISR() is not called while IRSND is busy, the
+ *                        firmware before full duplex,
+ *             - duplex:  IRMP runs all the time on the raw input,
+ *             - mask:    plus the input reads dark while the carrier is on
+ *                        and until it has been dark for IRMP_TIMEOUT_LEN
+ *                        ticks, like IRMP_HideEcho() in configuration.c,
+ *             - windows: plus frames equal to the one being sent or sent
+ *                        less than 40 ms ago are dropped, like
+ *                        IRMP_IsEcho() in application.c. The firmware.
+ *
+ *             Printed per way: frames of the remotes lost, lost among the
+ *             frames no other remote overlaps, echoes of the diode taken for
+ *             a key press and phantom frames decoded from overlaps. Fails if
+ *             the firmware loses more frames than blind reception or lets
+ *             more than 1 % of the forwarded frames through as key presses.
+ *
+ *             Build and run: tools/test/run.sh sim_duplex
+ *             (usage: sim_duplex path-of-irsnd)
+ */
+
+#define main irmp_analyze_main
+#include "../../src/irmp.c"
+#undef main
+#include <math.h>
+#include <stdbool.h>
+
+/* Private define ------------------------------------------------------------*/
+#define TICKS_PER_S        F_INTERRUPTS
+#define ECHO_TAIL          (TICKS_PER_S * 40 / 1000)  /* IRSND_ECHO_TAIL */
+#define ECHO_WINDOWS       2                          /* IRSND_ECHO_WINDOWS */
+#define WAVES_MAX          64
+#define WAVE_TICKS_MAX     8192
+#define PRESSES_MAX        8192
+#define QUEUE_SIZE         64
+#define KEYS               8
+
+#define WAY_BLIND          0
+#define WAY_DUPLEX         1
+#define WAY_MASK           2
+#define WAY_WINDOWS        3
+#define WAYS               4
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct WAVE
+{
+   IRMP_DATA   data;
+   char        *ticks;                 /* '0' while the carrier is on */
+   int         length;
+} wave_t;
+
+typedef struct PRESS
+{
+   IRMP_DATA   data;
+   long        start;
+   long        end;
+   bool        overlapped;             /* by a frame of another remote */
+   bool        received;
+} press_t;
+
+typedef struct ECHO
+{
+   IRMP_DATA   data;
+   long        end;
+   bool        open;
+   bool        sending;
+} echo_t;
+
+typedef struct RESULT
+{
+   long        presses;
+   long        lost;
+   long        clean;                  /* presses not overlapped */
+   long        clean_lost;
+   long        echoes;                 /* forwarded frames taken for presses */
+   long        phantoms;
+   long        forwarded;
+} result_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const char *irsnd_path;
+static wave_t      waves[WAVES_MAX];
+static int         wave_count;
+static press_t     presses[PRESSES_MAX];
+static int         press_count;
+static uint32_t    seed;
+static const IRMP_DATA remotes[3] =
+{
+   { IRMP_NEC_PROTOCOL,   0x1234, 0, 0 },
+   { IRMP_RC5_PROTOCOL,   0x0005, 0, 0 },
+   { IRMP_SIRCS_PROTOCOL, 0x0001, 0, 0 },
+};
+
+/* Simulation -----------------------------------------------------------------*/
+static uint32_t Random(void)
+{
+   seed = seed * 1103515245 + 12345;
+   return seed >> 8;
+}
+
+/**
+  * @brief  Exponentially distributed wait in ticks.
+  */
+static long Wait(double mean_s)
+{
+   return (long)(-mean_s * TICKS_PER_S * log((Random() % 0xFFFFFF + 1.0) / 0x1000000));
+}
+
+static bool IsEqual(const IRMP_DATA *a, const IRMP_DATA *b)
+{
+   return a->protocol == b->protocol && a->address == b->address && a->command == b->command;
+}
+
+/**
+  * @brief  Waveform of a frame sent by IRSND, the pause behind it included.
+  */
+static const wave_t *Wave(const IRMP_DATA *data)
+{
+   char    command[256];
+   wave_t *wave;
+   FILE   *fp;
+   int     i, c;
+
+   for(i = 0; i < wave_count; i++)
+   {
+      if(IsEqual(&waves[i].data, data))
+      {
+         return &waves[i];
+      }
+   }
+   // the keys of the remotes come first, phantoms share the last wave
+   wave = &waves[(wave_count < WAVES_MAX) ? wave_count++ : WAVES_MAX-1];
+   wave->data = *data;
+   wave->length = 0;
+   if(wave->ticks == NULL)
+   {
+      wave->ticks = malloc(WAVE_TICKS_MAX);
+   }
+
+   snprintf(command, sizeof(command), "%s %d 0x%x 0x%x", irsnd_path,
+            data->protocol, data->address, data->command);
+   if((fp = popen(command, "r")) == NULL)
+   {
+      perror(irsnd_path);
+      exit(2);
+   }
+   // the first of the two frames irsnd writes
+   while((c = fgetc(fp)) == '0' || c == '1')
+   {
+      if(wave->length < WAVE_TICKS_MAX)
+      {
+         wave->ticks[wave->length++] = c;
+      }
+   }
+   pclose(fp);
+   if(wave->length == 0)
+   {
+      wave->ticks[wave->length++] = '1';   // protocol IRSND can't send
+   }
+   return wave;
+}
+
+/**
+  * @brief  Press of the remote received, if it is one.
+  * @return false if the frame is none of the remotes.
+  */
+static bool Receive(const IRMP_DATA *data, long now, result_t *result)
+{
+   int i;
+
+   for(i = press_count; i-- > 0 && presses[i].start > now - 2 * TICKS_PER_S; )
+   {
+      if( !presses[i].received && IsEqual(&presses[i].data, data) &&
+          presses[i].start <= now && now <= presses[i].end + ECHO_TAIL )
+      {
+         presses[i].received = true;
+         return true;
+      }
+   }
+   for(i = 0; i < 3; i++)
+   {
+      if( data->protocol == remotes[i].protocol && data->address == remotes[i].address &&
+          data->command < KEYS )
+      {
+         result->echoes++;   // a key, but no remote pressed it now
+         return true;
+      }
+   }
+   result->phantoms++;
+   return false;
+}
+
+/**
+  * @brief  Like IRSND_UpdateEchoWindows().
+  */
+static void UpdateEchoWindows(echo_t *echo, bool busy, long now)
+{
+   int i;
+
+   for(i = 0; i < ECHO_WINDOWS; i++)
+   {
+      if(echo[i].open && echo[i].sending && !busy)
+      {
+         echo[i].sending = false;
+         echo[i].end = now + ECHO_TAIL;
+      }
+      else if(echo[i].open && !echo[i].sending && now >= echo[i].end)
+      {
+         echo[i].open = false;
+      }
+   }
+}
+
+/**
+  * @brief  Runs the remotes and the forwarding device for a while.
+  */
+static void Run(int way, int remote_count, long ticks, uint32_t run_seed, result_t *result)
+{
+   const wave_t *remote_wave[2] = { NULL, NULL };
+   const wave_t *sending = NULL;
+   long          remote_pos[2], remote_next[2], send_pos = 0;
+   double        mean_s[2] = { 1.2, 2.5 };
+   IRMP_DATA     queue[QUEUE_SIZE], data;
+   int           queue_head = 0, queue_count = 0;
+   echo_t        echo[ECHO_WINDOWS];
+   int           echo_idx = 0;
+   uint16_t      dark = IRMP_TIMEOUT_LEN;
+   irmp_state_t  state;
+   long          now;
+   int           k, i, first = press_count;
+   uint8_t       input, carrier;
+
+   seed = run_seed;
+   memset(echo, 0, sizeof(echo));
+   irmp_init_state(&state);
+   for(k = 0; k < remote_count; k++)
+   {
+      remote_next[k] = Wait(mean_s[k]);
+   }
+
+   for(now = 0; now < ticks; now++)
+   {
+      input = 1;
+
+      // the remotes
+      for(k = 0; k < remote_count; k++)
+      {
+         if(remote_wave[k] == NULL && now >= remote_next[k] && press_count < PRESSES_MAX)
+         {
+            data = remotes[(k == 0) ? 0 : 1 + Random() % 2];
+            data.command = Random() % KEYS;
+            remote_wave[k] = Wave(&data);
+            remote_pos[k] = 0;
+            presses[press_count].data = data;
+            presses[press_count].start = now;
+            presses[press_count].end = now + remote_wave[k]->length;
+            presses[press_count].received = false;
+            press_count++;
+         }
+         if(remote_wave[k] != NULL)
+         {
+            input &= (remote_wave[k]->ticks[remote_pos[k]] == '1');
+            if(++remote_pos[k] >= remote_wave[k]->length)
+            {
+               remote_wave[k] = NULL;
+               remote_next[k] = now + Wait(mean_s[k]);
+            }
+         }
+      }
+
+      // the device forwards what it has received, like IRSND_ProcessData()
+      if(sending == NULL && queue_count)
+      {
+         data = queue[queue_head];
+         queue_head = (queue_head + 1) % QUEUE_SIZE;
+         queue_count--;
+         UpdateEchoWindows(echo, false, now);
+         echo_idx = (echo_idx + 1) % ECHO_WINDOWS;
+         echo[echo_idx].data = data;
+         echo[echo_idx].sending = true;
+         echo[echo_idx].open = true;
+         sending = Wave(&data);
+         send_pos = 0;
+         result->forwarded++;
+      }
+      carrier = 0;
+      if(sending != NULL)
+      {
+         carrier = (sending->ticks[send_pos] == '0');
+         if(++send_pos >= sending->length)
+         {
+            // EVENT_IRSND_DONE, IRSND_ProcessData() starts the tail
+            sending = NULL;
+            UpdateEchoWindows(echo, false, now);
+         }
+      }
+      input &= !carrier;
+
+      if(way == WAY_BLIND && sending != NULL)
+      {
+         continue;
+      }
+      if(way >= WAY_MASK)
+      {
+         // like IRMP_HideEcho()
+         if(carrier)
+         {
+            dark = 0;
+            input = 1;
+         }
+         else if(dark < IRMP_TIMEOUT_LEN)
+         {
+            dark = input ? dark + 1 : 0;
+            input = 1;
+         }
+      }
+
+      if(irmp_ISR_ex(&state, input) && irmp_get_data_ex(&state, &data))
+      {
+         if(way == WAY_WINDOWS)
+         {
+            bool is_echo = false;
+
+            UpdateEchoWindows(echo, sending != NULL, now);
+            for(i = 0; i < ECHO_WINDOWS; i++)
+            {
+               is_echo |= echo[i].open && IsEqual(&echo[i].data, &data);
+            }
+            if(is_echo)
+            {
+               continue;
+            }
+         }
+         Receive(&data, now, result);
+         if(queue_count < QUEUE_SIZE)
+         {
+            queue[(queue_head + queue_count++) % QUEUE_SIZE] = data;
+         }
+      }
+   }
+
+   // presses of this run, overlapped if another remote sent at the same time
+   for(i = first; i < press_count; i++)
+   {
+      presses[i].overlapped = false;
+      for(k = first; k < press_count; k++)
+      {
+         presses[i].overlapped |= (k != i && presses[k].start < presses[i].end &&
+                                   presses[i].start < presses[k].end);
+      }
+      result->presses++;
+      result->lost += !presses[i].received;
+      result->clean += !presses[i].overlapped;
+      result->clean_lost += !presses[i].overlapped && !presses[i].received;
+   }
+}
+
+static void Print(const char *name, const result_t *result)
+{
+   printf("  %-8s %6.1f%%  %10.1f%%  %6ld  %7ld  %9ld\n", name,
+          100.0 * result->lost / result->presses,
+          100.0 * result->clean_lost / (result->clean ? result->clean : 1),
+          result->echoes, result->phantoms, result->forwarded);
+}
+
+int main(int argc, char **argv)
+{
+   static const char *names[WAYS] = { "blind", "duplex", "mask", "windows" };
+   result_t two[WAYS], one[WAYS];
+   IRMP_DATA data;
+   int      way, run, i;
+   int      fails = 0;
+
+   if(argc != 2)
+   {
+      fprintf(stderr, "usage: %s path-of-irsnd\n", argv[0]);
+      return 2;
+   }
+   irsnd_path = argv[1];
+   silent = TRUE;
+   irmp_init_start_bits();
+   for(i = 0; i < 3 * KEYS; i++)
+   {
+      data = remotes[i / KEYS];
+      data.command = i % KEYS;
+      Wave(&data);
+   }
+
+   memset(two, 0, sizeof(two));
+   memset(one, 0, sizeof(one));
+   for(way = 0; way < WAYS; way++)
+   {
+      for(run = 0; run < 3; run++)
+      {
+         press_count = 0;
+         Run(way, 2, 5L * 60 * TICKS_PER_S, 1 + run, &two[way]);
+      }
+      press_count = 0;
+      Run(way, 1, 15L * 60 * TICKS_PER_S, 7, &one[way]);
+   }
+
+   printf("way        lost  not overlapped  echoes  phantoms  forwarded\n");
+   printf("two remotes, 3 x 5 min:\n");
+   for(way = 0; way < WAYS; way++)
+   {
+      Print(names[way], &two[way]);
+   }
+   printf("one NEC remote, 15 min:\n");
+   for(way = 0; way < WAYS; way++)
+   {
+      Print(names[way], &one[way]);
+   }
+
+   fails += two[WAY_WINDOWS].lost > two[WAY_BLIND].lost;
+   fails += one[WAY_WINDOWS].lost > one[WAY_BLIND].lost;
+   fails += two[WAY_WINDOWS].echoes * 100 > two[WAY_WINDOWS].forwarded;
+   fails += one[WAY_WINDOWS].echoes * 100 > one[WAY_WINDOWS].forwarded;
+   printf("%d checks, %d failed\n", 4, fails);
+   return fails != 0;
+}
@@ -0,0 +1,234 @@
+/**
+ * @file       sim_latency.c
+ * @brief      Host simulation of the IR code delivery to the USB host
+ *             (usbd_customhid.c).
+ *
+ * @details    Reports go through the IN queue of usbd_customhid.c. The USB
+ *             host polls the IN endpoint every bInterval ms, as set with
+ *             USBD_CUSTOM_HID_SetPollingInterval() in the configuration
+ *             descriptor, and takes the report armed with USBD_LL_Transmit().
+ *             The transfer complete calls the DataIn handler, which arms the
+ *             next queued report. Decodes happen at random times, main sends
+ *             the report right away. For every bInterval the simulation
+ *             prints the decode-to-host delay of
+ *             - single codes: mean and worst,
+ *             - a burst of USBD_CUSTOMHID_INREPORT_QUEUE_SIZE reports queued
+ *               at once (codes, key-ups and capture data): delay of the last,
+ *             - a full queue: reports delivered per second.
+ *
+ *             Build and run: tools/test/run.sh sim_latency
+ */
+
+#include "host.h"
+#include "keyboard.h"
+#include "usbd_customhid.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SAMPLES            20000
+#define BURSTS             2000
+#define BURST_SIZE         USBD_CUSTOMHID_INREPORT_QUEUE_SIZE
+#define SATURATED_US       1000000     /* full queue for one second */
+
+/* Private variables ---------------------------------------------------------*/
+const uint8_t KEYBOARD_ReportDesc[KEYBOARD_REPORT_DESC_SIZE];
+
+static USBD_HandleTypeDef            device;
+static USBD_CUSTOM_HID_HandleTypeDef hid;
+static uint8_t  *armed;                /* report on the IN endpoint */
+static uint32_t now;                   /* us */
+static uint32_t next_poll;
+static uint32_t interval_us;
+static uint32_t sent_at[BURST_SIZE];
+static uint32_t delivered_at[BURST_SIZE];
+static long     delivered;
+
+/* Stubs of the firmware ------------------------------------------------------*/
+USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+                                    uint8_t *pbuf, uint16_t size)
+{
+   (void)pdev;
+   (void)size;
+   if(ep_addr != CUSTOM_HID_EPIN_ADDR || armed != NULL)
+   {
+      abort();
+   }
+   armed = pbuf;
+   return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_OpenEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+                                  uint8_t ep_type, uint16_t ep_mps)
+{
+   (void)pdev; (void)ep_addr; (void)ep_type; (void)ep_mps;
+   return USBD_OK;
+}
+USBD_StatusTypeDef USBD_LL_CloseEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+   (void)pdev; (void)ep_addr;
+   return USBD_OK;
+}
+USBD_StatusTypeDef USBD_LL_PrepareReceive(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+                                          uint8_t *pbuf, uint16_t size)
+{
+   (void)pdev; (void)ep_addr; (void)pbuf; (void)size;
+   return USBD_OK;
+}
+USBD_StatusTypeDef USBD_CtlSendData(USBD_HandleTypeDef *pdev, uint8_t *buf, uint16_t len)
+{
+   (void)pdev; (void)buf; (void)len;
+   return USBD_OK;
+}
+USBD_StatusTypeDef USBD_CtlPrepareRx(USBD_HandleTypeDef *pdev, uint8_t *buf, uint16_t len)
+{
+   (void)pdev; (void)buf; (void)len;
+   return USBD_OK;
+}
+void USBD_CtlError(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req) { (void)pdev; (void)req; }
+void *USBD_static_malloc(uint32_t size) { (void)size; return NULL; }
+void USBD_static_free(void *p) { (void)p; }
+uint8_t KEYBOARD_GetReport(uint8_t report_id, uint8_t *report) { (void)report_id; (void)report; return 0; }
+
+#include "../../src/usbd_customhid.c"
+
+/* Simulation ----------------------------------------------------------------*/
+/**
+  * @brief  Runs the polls of the USB host until a time.
+  */
+static void Advance(uint32_t until)
+{
+   while(next_poll <= until)
+   {
+      now = next_poll;
+      next_poll += interval_us;
+      if(armed != NULL)
+      {
+         // the IN transfer is complete
+         delivered_at[armed[1] % BURST_SIZE] = now;
+         delivered++;
+         armed = NULL;
+         USBD_CUSTOM_HID_DataIn(&device, CUSTOM_HID_EPIN_ADDR & 0x7F);
+      }
+   }
+   now = until;
+}
+
+/**
+  * @brief  Sends a report like IRMP_SendReport(), the number goes into the
+  *         report.
+  */
+static uint8_t Send(uint8_t number)
+{
+   uint8_t report[1+sizeof(IRMP_DATA)] = { 1, number };
+
+   sent_at[number % BURST_SIZE] = now;
+   return USBD_CUSTOM_HID_SendReport(&device, report, sizeof(report));
+}
+
+/**
+  * @brief  Enumerates with a polling interval, the host starts polling at a
+  *         random phase.
+  */
+static void Enumerate(uint8_t interval)
+{
+   USBD_CUSTOM_HID_SetPollingInterval(interval);
+   interval_us = USBD_CUSTOM_HID_CfgDesc[33] * 1000;
+
+   memset(&hid, 0, sizeof(hid));
+   hid.state = CUSTOM_HID_IDLE;
+   device.pClassData = &hid;
+   device.dev_state = USBD_STATE_CONFIGURED;
+   USBD_CUSTOM_HID_InQueueHead = 0;
+   USBD_CUSTOM_HID_InQueueCount = 0;
+   memset(&USBD_CUSTOM_HID_InStats, 0, sizeof(USBD_CUSTOM_HID_InStats));
+   armed = NULL;
+   now = 0;
+   next_poll = HOST_Random() % interval_us;
+   delivered = 0;
+}
+
+/**
+  * @brief  Waits until the IN queue is empty.
+  */
+static void Drain(void)
+{
+   while(USBD_CUSTOM_HID_InQueueCount > 0 || armed != NULL)
+   {
+      Advance(next_poll);
+   }
+}
+
+static void Simulate(uint8_t interval)
+{
+   double   single_sum = 0, burst_sum = 0, rate;
+   uint32_t single_max = 0, burst_max = 0, delay, start;
+   int      i, k;
+
+   Enumerate(interval);
+
+   // single codes, at least 50 ms apart like the frames of a remote
+   for(i = 0; i < SAMPLES; i++)
+   {
+      Advance(now + 50000 + HOST_Random() % 100000);
+      CHECK(Send(0) == USBD_OK);
+      Drain();
+      delay = delivered_at[0] - sent_at[0];
+      single_sum += delay;
+      single_max = (delay > single_max) ? delay : single_max;
+   }
+
+   // bursts that fill the queue
+   for(i = 0; i < BURSTS; i++)
+   {
+      Advance(now + 50000 + HOST_Random() % 100000);
+      for(k = 0; k < BURST_SIZE; k++)
+      {
+         CHECK(Send(k) == USBD_OK);
+      }
+      Drain();
+      delay = delivered_at[BURST_SIZE-1] - sent_at[BURST_SIZE-1];
+      burst_sum += delay;
+      burst_max = (delay > burst_max) ? delay : burst_max;
+   }
+   CHECK(USBD_CUSTOM_HID_InStats.Overflows == 0 && USBD_CUSTOM_HID_InStats.Drops == 0);
+
+   // throughput while main keeps the queue full
+   Advance(now + 50000);
+   delivered = 0;
+   start = now;
+   while(now - start < SATURATED_US)
+   {
+      while(Send(0) == USBD_OK)
+      {
+      }
+      Advance(next_poll);
+   }
+   rate = delivered * 1e6 / (now - start);
+
+   printf("  %6u ms  %5.2f  %6.2f  %11.2f  %6.2f  %9.0f\n", USBD_CUSTOM_HID_CfgDesc[33],
+          single_sum / SAMPLES / 1000, single_max / 1000.0,
+          burst_sum / BURSTS / 1000, burst_max / 1000.0, rate);
+
+   // a report waits at most one interval, the mean is half of it
+   CHECK(single_max <= interval_us);
+   CHECK(single_sum / SAMPLES > 0.45 * interval_us && single_sum / SAMPLES < 0.55 * interval_us);
+   CHECK(burst_max <= BURST_SIZE * interval_us);
+   CHECK(rate > 0.99e6 / interval_us && rate < 1.01e6 / interval_us);
+}
+
+int main(void)
+{
+   static const uint8_t intervals[] = { 1, 2, 4, 8, 10, 0 };
+   unsigned i;
+
+   printf("decode-to-host delay in ms, burst: last of %d reports queued at once\n", BURST_SIZE);
+   printf("  bInterval   mean   worst   burst mean   worst  reports/s\n");
+   for(i = 0; i < sizeof(intervals); i++)
+   {
+      Simulate(intervals[i]);
+   }
+   // 0 selects the build default
+   CHECK(USBD_CUSTOM_HID_CfgDesc[33] == USBD_CUSTOMHID_POLLING_INTERVAL);
+   CHECK(USBD_CUSTOM_HID_CfgDesc[40] == USBD_CUSTOMHID_POLLING_INTERVAL);
+
+   return HOST_Result();
+}
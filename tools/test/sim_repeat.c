@@ -0,0 +1,417 @@
+/**
+ * @file       sim_repeat.c
+ * @brief      Host simulation of the repetition shaping (repeat.c).
+ *
+ * @details    Runs streams of frames through REPEAT_Frame(), with a 1 ms
+ *             SysTick calling REPEAT_Tick() and main calling REPEAT_Poll()
+ *             on EVENT_REPEAT like the firmware, and prints the reports sent
+ *             before and after the shaping for a few settings. Checks:
+ *             - delay, period and timeout 0 forward the same frames as the
+ *               firmware before, for every min_ir_repeats,
+ *             - no repeat comes before the delay or faster than the period
+ *               on average,
+ *             - every key-down gets its key-up, timeout ms after the last
+ *               frame of the key or when another key goes down.
+ *
+ *             Synthetic streams model remotes repeating every 108 ms (NEC),
+ *             114 ms (RC5) and 45 ms (SIRCS) with jitter and lost frames. A
+ *             recorded stream is given as file of the frame lines of
+ *             "irmp -v", e.g. sim_repeat.txt:
+ *
+ *                irsnd 2 10 5 12 > scan.txt; irmp -v < scan.txt | grep "ms p="
+ *
+ *             The time restarts with every line of a scan file, a frame
+ *             earlier than the one before continues after it.
+ *
+ *             Build and run: tools/test/run.sh sim_repeat
+ */
+
+#include "host.h"
+#include "repeat.h"
+
+/* Private define ------------------------------------------------------------*/
+#define FRAMES             20000
+#define REPORTS            (2 * FRAMES)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct FRAME
+{
+   uint32_t    time;
+   IRMP_DATA   data;
+} frame_t;
+
+typedef struct REPORT
+{
+   uint32_t    time;
+   uint8_t     event;
+   uint16_t    command;
+} report_t;
+
+/* Private variables ---------------------------------------------------------*/
+static bool       event_repeat;
+static frame_t    frames[FRAMES];
+static int        frame_count;
+static report_t   reports[REPORTS];
+static int        report_count;
+
+/* Stubs of the firmware ------------------------------------------------------*/
+void SetEvent(uint32_t event)
+{
+   event_repeat |= (event & EVENT_REPEAT) != 0;
+}
+
+#include "../../src/repeat.c"
+
+/* Simulation -----------------------------------------------------------------*/
+static void Report(uint32_t now, uint8_t event, uint16_t command)
+{
+   if(report_count < REPORTS)
+   {
+      reports[report_count].time = now;
+      reports[report_count].event = event;
+      reports[report_count].command = command;
+      report_count++;
+   }
+}
+
+/**
+  * @brief  Runs the stream through the module, ms by ms.
+  */
+static void Run(uint8_t min_repeats, uint16_t delay, uint16_t period, uint16_t timeout)
+{
+   repeat_config_t config = { delay, period, timeout };
+   IRMP_DATA released;
+   uint32_t  now, end;
+   uint8_t   events;
+   int       i = 0;
+
+   memset(&repeat, 0, sizeof(repeat));
+   repeat_armed = false;
+   event_repeat = false;
+   report_count = 0;
+   REPEAT_SetConfig(min_repeats, &config);
+
+   end = frames[frame_count-1].time + 2000;
+   for(now = frames[0].time; now != end; now++)
+   {
+      REPEAT_Tick(now);
+      if(event_repeat)
+      {
+         event_repeat = false;
+         if(REPEAT_Poll(now, &released) & REPEAT_UP)
+         {
+            Report(now, REPEAT_UP, released.command);
+         }
+      }
+      for(; i < frame_count && frames[i].time == now; i++)
+      {
+         events = REPEAT_Frame(&frames[i].data, now, &released);
+         if(events & REPEAT_UP)
+         {
+            Report(now, REPEAT_UP, released.command);
+         }
+         if(events & (REPEAT_DOWN | REPEAT_REPEAT))
+         {
+            Report(now, events & (REPEAT_DOWN | REPEAT_REPEAT), frames[i].data.command);
+         }
+      }
+   }
+}
+
+/**
+  * @brief  Frames the firmware forwarded before the shaping.
+  * @param  *forwarded: receives 1 per forwarded frame.
+  * @return Number of forwarded frames.
+  */
+static int Legacy(uint8_t min_repeats, uint8_t *forwarded)
+{
+   uint8_t repeats = 0;
+   int     count = 0;
+   int     i;
+
+   for(i = 0; i < frame_count; i++)
+   {
+      repeats = (frames[i].data.flags & IRMP_FLAG_REPETITION) ? repeats + 1 : 0;
+      forwarded[i] = (repeats == 0 || repeats >= min_repeats);
+      if(repeats >= min_repeats)
+      {
+         repeats = min_repeats;
+      }
+      count += forwarded[i];
+   }
+   return count;
+}
+
+/**
+  * @brief  Appends the frames of a held key, IRMP flags a frame within
+  *         150 ms of the one before as repetition.
+  * @param  gap: ms between the frames of the remote.
+  * @param  jitter: ms the gap varies.
+  * @param  loss: percentage of repetition frames lost.
+  * @return Time after the last frame.
+  */
+static uint32_t Press(uint32_t time, uint8_t protocol, uint16_t command,
+                      uint32_t hold, int gap, int jitter, int loss)
+{
+   uint32_t end = time + hold;
+   uint32_t last = 0;
+   bool     first = true;
+
+   for(; time <= end; time += gap + (jitter ? (int)(HOST_Random() % (2*jitter+1)) - jitter : 0))
+   {
+      if(!first && (int)(HOST_Random() % 100) < loss)
+      {
+         continue;
+      }
+      frames[frame_count].time = time;
+      frames[frame_count].data.protocol = protocol;
+      frames[frame_count].data.address = 0x10;
+      frames[frame_count].data.command = command;
+      frames[frame_count].data.flags = (!first && time - last < 150) ? IRMP_FLAG_REPETITION : 0;
+      frame_count++;
+      last = time;
+      first = false;
+   }
+   return time;
+}
+
+static void Synthetic(int gap, int jitter, int loss, int presses, int hold_max)
+{
+   uint32_t time = 1000;
+   int      k;
+
+   frame_count = 0;
+   for(k = 0; k < presses; k++)
+   {
+      time = Press(time, 2, HOST_Random() % 4, HOST_Random() % hold_max, gap, jitter, loss);
+      time += 200 + HOST_Random() % 600;
+   }
+}
+
+/**
+  * @brief  Reads the frame lines of irmp -v.
+  * @return false if the file holds no frame.
+  */
+static bool Recorded(const char *name)
+{
+   FILE     *file = fopen(name, "r");
+   char      line[256];
+   double    ms;
+   unsigned  protocol, address, command, flags;
+   uint32_t  base = 0, time, last = 0;
+
+   frame_count = 0;
+   if(file == NULL)
+   {
+      perror(name);
+      return false;
+   }
+   while(fgets(line, sizeof(line), file) && frame_count < FRAMES)
+   {
+      if(sscanf(line, "%lfms p=%u (%*[^)]), a=0x%x, c=0x%x, f=0x%x",
+                &ms, &protocol, &address, &command, &flags) != 5)
+      {
+         continue;
+      }
+      time = base + (uint32_t)ms;
+      if(frame_count && time < last)
+      {
+         // next line of the scan file
+         base = last;
+         time = base + (uint32_t)ms;
+      }
+      frames[frame_count].time = time;
+      frames[frame_count].data.protocol = protocol;
+      frames[frame_count].data.address = address;
+      frames[frame_count].data.command = command;
+      frames[frame_count].data.flags = flags;
+      frame_count++;
+      last = time;
+   }
+   fclose(file);
+   return frame_count > 0;
+}
+
+/**
+  * @brief  Runs the stream with a setting, checks the reports and prints a
+  *         summary.
+  */
+static void Shaped(const char *name, uint16_t delay, uint16_t period, uint16_t timeout)
+{
+   uint8_t  forwarded[FRAMES];
+   uint32_t down = 0, last;
+   uint16_t command = 0;
+   bool     held = false;
+   int      downs = 0, repeats = 0, ups = 0, held_repeats = 0;
+   int      latency, latency_max = 0;
+   int      k, i;
+
+   Run(0, delay, period, timeout);
+   for(k = 0; k < report_count; k++)
+   {
+      switch(reports[k].event)
+      {
+      case REPEAT_DOWN:
+         CHECK(!held || timeout == 0);
+         held = true;
+         down = reports[k].time;
+         command = reports[k].command;
+         held_repeats = 0;
+         downs++;
+         break;
+
+      case REPEAT_REPEAT:
+         CHECK(held && reports[k].command == command);
+         CHECK(reports[k].time - down >= delay);
+         // the rate holds on average, a single interval may be shorter by
+         // the lateness of the frame before
+         held_repeats++;
+         if(period)
+         {
+            CHECK(held_repeats <= 1 + (int)((reports[k].time - down - delay) / period));
+         }
+         repeats++;
+         break;
+
+      default:
+         CHECK(held && reports[k].command == command);
+         held = false;
+         ups++;
+
+         // timeout after the last frame of the key, or another key
+         for(last = 0, i = 0; i < frame_count && (int32_t)(frames[i].time - reports[k].time) <= 0; i++)
+         {
+            if(frames[i].data.command == reports[k].command)
+            {
+               last = frames[i].time;
+            }
+         }
+         latency = reports[k].time - last;
+         latency_max = (latency > latency_max) ? latency : latency_max;
+         CHECK( latency == timeout ||
+                ( k+1 < report_count && reports[k+1].event == REPEAT_DOWN &&
+                  reports[k+1].time == reports[k].time ) );
+         break;
+      }
+   }
+   if(timeout)
+   {
+      CHECK(downs == ups);
+   }
+
+   printf("%-26s %3u/%3u/%3u  frames %5d  reports before %5d  after %5d  "
+          "down %4d  repeat %4d  up %4d  key-up after %d ms\n",
+          name, delay, period, timeout, frame_count, Legacy(0, forwarded),
+          downs + repeats + ups, downs, repeats, ups, latency_max);
+}
+
+/**
+  * @brief  Delay, period and timeout 0 forward what the firmware did before.
+  */
+static void Unshaped(void)
+{
+   uint8_t forwarded[FRAMES];
+   uint8_t min_repeats;
+   int     i, k;
+
+   for(min_repeats = 0; min_repeats < 6; min_repeats++)
+   {
+      Legacy(min_repeats, forwarded);
+      Run(min_repeats, 0, 0, 0);
+      for(i = 0, k = 0; i < frame_count; i++)
+      {
+         if(forwarded[i])
+         {
+            CHECK( k < report_count && reports[k].time == frames[i].time &&
+                   reports[k].event != REPEAT_UP );
+            k++;
+         }
+      }
+      CHECK(k == report_count);
+   }
+}
+
+static void Settings(const char *name)
+{
+   Unshaped();
+   Shaped(name, 500, 200, 150);
+   Shaped(name, 250, 100, 150);
+   Shaped(name, 0, 0, 150);
+}
+
+int main(int argc, char **argv)
+{
+   static const struct
+   {
+      const char *name;
+      int         gap, jitter, loss;
+   } remotes[] =
+   {
+      { "NEC   (108 ms)",            108, 2, 0 },
+      { "NEC   (108 ms, 10 % lost)", 108, 2, 10 },
+      { "RC5   (114 ms)",            114, 2, 0 },
+      { "SIRCS (45 ms)",              45, 1, 0 },
+      { "SIRCS (45 ms, 10 % lost)",   45, 1, 10 },
+   };
+   IRMP_DATA released;
+   int       k, n;
+
+   printf("%-26s delay/period/timeout\n", "stream");
+   for(k = 0; k < (int)(sizeof(remotes) / sizeof(remotes[0])); k++)
+   {
+      Synthetic(remotes[k].gap, remotes[k].jitter, remotes[k].loss, 200, 4000);
+      Settings(remotes[k].name);
+   }
+   for(k = 1; k < argc; k++)
+   {
+      CHECK(Recorded(argv[k]));
+      if(frame_count)
+      {
+         Settings(argv[k]);
+      }
+   }
+
+   // a lost frame within the timeout keeps the key held
+   frame_count = 0;
+   Press(1000, 2, 1, 1000, 108, 0, 0);
+   memmove(&frames[3], &frames[4], (frame_count - 4) * sizeof(frame_t));
+   frame_count--;
+   Run(0, 0, 0, 250);
+   for(n = 0, k = 0; k < report_count; k++)
+   {
+      n += (reports[k].event == REPEAT_UP);
+   }
+   CHECK(n == 1 && reports[report_count-1].event == REPEAT_UP);
+
+   // another key releases the held one first
+   frame_count = 0;
+   Press(1000, 2, 1, 500, 108, 0, 0);
+   Press(1500, 2, 2, 300, 108, 0, 0);
+   Run(0, 0, 0, 250);
+   for(k = 0; k < report_count && reports[k].event != REPEAT_UP; k++);
+   CHECK( k+1 < report_count && reports[k].command == 1 &&
+          reports[k+1].event == REPEAT_DOWN && reports[k+1].command == 2 &&
+          reports[k].time == reports[k+1].time );
+
+   // min_ir_repeats still counts before the delay
+   frame_count = 0;
+   Press(1000, 2, 1, 2000, 108, 0, 0);
+   Run(10, 100, 0, 250);
+   for(k = 0; k < report_count && reports[k].event != REPEAT_REPEAT; k++);
+   CHECK(k < report_count && reports[k].time == frames[10].time);
+
+   // SysTick wraps around
+   frame_count = 0;
+   Press(1000, 2, 1, 1000, 108, 0, 0);
+   Press(3000, 2, 2, 500, 108, 0, 0);
+   for(k = 0; k < frame_count; k++)
+   {
+      frames[k].time += 0xFFFFFF00u - 1000;
+   }
+   Shaped("wrap around", 500, 200, 150);
+
+   // the module keeps no key after the key-up
+   CHECK(REPEAT_Poll(frames[frame_count-1].time + 1000, &released) == REPEAT_NONE);
+
+   return HOST_Result();
+}
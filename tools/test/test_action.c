@@ -0,0 +1,544 @@
+/**
+ * @file       test_action.c
+ * @brief      Host test and lookup benchmark of the action table (action.c).
+ *
+ * @details    The record store and the emulated EEPROM are modelled in RAM,
+ *             a write of the store can be made to fail. The test checks the
+ *             legacy code migration, ACTION_Assign(), the REP_ID_ACTION_ENTRY
+ *             reports and the HID usages, then runs random operations against
+ *             a linear reference lookup, committing and resetting in between,
+ *             with failing writes that must be retried. The benchmark prints
+ *             the probe lengths of the hash index for typical code sets, and
+ *             the time of a lookup compared with a linear search.
+ */
+
+#include "host.h"
+#include "action.h"
+#include "learn.h"
+#include "store.h"
+
+/* Private define ------------------------------------------------------------*/
+#define OPERATIONS         200000
+#define BENCH_FRAMES       4096
+#define BENCH_ROUNDS       2000
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t  eeprom[ADDRESS_records * EEPROM_ADDRESS_SIZE];
+static uint8_t  records[ACTION_ENTRIES][ACTION_ENTRY_SIZE];
+static bool     records_used[ACTION_ENTRIES];
+static long     store_writes;
+static bool     store_fail;
+static long     pending_events;
+
+/* Stubs of the firmware ------------------------------------------------------*/
+void SetEvent(uint32_t event)
+{
+   pending_events += (event & EVENT_EEPROM_PENDING) != 0;
+}
+
+HAL_StatusTypeDef EEPROM_ReadBytes(uint32_t address, void *data, uint8_t length)
+{
+   memcpy(data, &eeprom[address * EEPROM_ADDRESS_SIZE], length);
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef EEPROM_WriteBytesDeferred(uint32_t address, void *data, uint8_t length)
+{
+   memcpy(&eeprom[address * EEPROM_ADDRESS_SIZE], data, length);
+   return HAL_OK;
+}
+
+static int RecordIndex(uint16_t address, uint8_t length)
+{
+   int idx = (address - ADDRESS_action_table) / (ACTION_ENTRY_SIZE / EEPROM_ADDRESS_SIZE);
+
+   if( address < ADDRESS_action_table || idx >= ACTION_ENTRIES ||
+       address != ADDRESS_action_table + idx * (ACTION_ENTRY_SIZE / EEPROM_ADDRESS_SIZE) ||
+       length != ACTION_ENTRY_SIZE )
+   {
+      abort();
+   }
+   return idx;
+}
+
+HAL_StatusTypeDef STORE_Read(uint16_t address, void *data, uint8_t length)
+{
+   int idx = RecordIndex(address, length);
+
+   if(!records_used[idx])
+   {
+      return HAL_ERROR;
+   }
+   memcpy(data, records[idx], length);
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef STORE_Write(uint16_t address, const void *data, uint8_t length)
+{
+   int idx = RecordIndex(address, length);
+
+   if(store_fail)
+   {
+      return HAL_ERROR;
+   }
+   memcpy(records[idx], data, length);
+   records_used[idx] = true;
+   store_writes++;
+   return HAL_OK;
+}
+
+#include "../../src/action.c"
+
+/* Test ----------------------------------------------------------------------*/
+static IRMP_DATA Code(uint8_t protocol, uint16_t address, uint16_t command)
+{
+   IRMP_DATA code = { protocol, address, command, 0 };
+
+   return code;
+}
+
+static uint8_t Lookup(IRMP_DATA code)
+{
+   uint16_t usage;
+
+   return ACTION_Lookup(&code, &usage);
+}
+
+/**
+  * @brief  Actions of the first used entry with the code, searched linearly.
+  */
+static uint8_t Reference(IRMP_DATA code)
+{
+   int idx;
+
+   for(idx = 0; idx < ACTION_ENTRIES; idx++)
+   {
+      if( ACTION_IsUsed(idx) && action_table[idx].protocol == code.protocol &&
+          action_table[idx].address == code.address &&
+          action_table[idx].command == code.command )
+      {
+         return action_table[idx].flags;
+      }
+   }
+   return 0;
+}
+
+/**
+  * @brief  Sends REP_ID_ACTION_ENTRY and lets main apply it.
+  */
+static bool Report(uint8_t idx, IRMP_DATA code, uint8_t actions, uint16_t usage)
+{
+   uint8_t report[ACTION_REPORT_SIZE] =
+      { idx, code.protocol, code.address, code.address >> 8,
+        code.command, code.command >> 8, actions, usage, usage >> 8 };
+
+   ACTION_SetEntry(report);
+   return ACTION_Process();
+}
+
+/**
+  * @brief  Writes the changed entries like the main loop does.
+  * @return Number of records written.
+  */
+static long Commit(void)
+{
+   long writes = store_writes;
+   int  passes = 0;
+
+   while(ACTION_Commit())
+   {
+      CHECK(++passes <= ACTION_ENTRIES);
+   }
+   CHECK(memcmp(action_dirty, (uint8_t[sizeof(action_dirty)]){0}, sizeof(action_dirty)) == 0);
+   return store_writes - writes;
+}
+
+/**
+  * @brief  Forgets the RAM state like a reset does and reads the store.
+  */
+static void Reset(void)
+{
+   memset(&action, 0, sizeof(action));
+   memset(action_table, 0x55, sizeof(action_table));
+   memset(action_usages, 0x55, sizeof(action_usages));
+   memset(action_dirty, 0, sizeof(action_dirty));
+   ACTION_Init();
+}
+
+/**
+  * @brief  Formats the store and the EEPROM like a new device.
+  */
+static void Format(uint8_t eeprom_value)
+{
+   memset(eeprom, eeprom_value, sizeof(eeprom));
+   memset(records_used, 0, sizeof(records_used));
+   Reset();
+}
+
+static void TestLegacy(void)
+{
+   IRMP_DATA on = Code(2, 0xFF00, 0x12), reset = Code(7, 0x1E, 0x0C), code;
+
+   // the codes of older firmware become entries, once
+   Format(0x00);
+   memcpy(&eeprom[ADDRESS_irmp_power_on * EEPROM_ADDRESS_SIZE], &on, sizeof(on));
+   memcpy(&eeprom[ADDRESS_irmp_power_off * EEPROM_ADDRESS_SIZE], &on, sizeof(on));
+   memcpy(&eeprom[ADDRESS_irmp_reset * EEPROM_ADDRESS_SIZE], &reset, sizeof(reset));
+   Reset();
+   CHECK(action.used == 2);
+   CHECK(Lookup(on) == (ACTION_POWER_ON | ACTION_POWER_OFF));
+   CHECK(Lookup(reset) == ACTION_RESET);
+   CHECK(eeprom[ADDRESS_irmp_power_on * EEPROM_ADDRESS_SIZE] == 0xFF);
+   CHECK(eeprom[ADDRESS_irmp_reset * EEPROM_ADDRESS_SIZE] == 0xFF);
+   ACTION_GetCode(ACTION_RESET, &code);
+   CHECK(code.protocol == 7 && code.address == 0x1E && code.command == 0x0C && code.flags == 0);
+   ACTION_GetCode(ACTION_WAKEUP, &code);
+   CHECK(code.protocol == 0);
+   CHECK(Commit() == 2);
+
+   // the table persists, the legacy codes are not imported again
+   Reset();
+   CHECK(action.used == 2 && Lookup(on) == (ACTION_POWER_ON | ACTION_POWER_OFF));
+   // the flags of a received code don't count
+   code = on;
+   code.flags = IRMP_FLAG_REPETITION;
+   CHECK(Lookup(code) == (ACTION_POWER_ON | ACTION_POWER_OFF));
+}
+
+static void TestAssign(void)
+{
+   IRMP_DATA on = Code(2, 0xFF00, 0x12), reset = Code(7, 0x1E, 0x0C);
+   IRMP_DATA learned = Code(LEARN_PROTOCOL, 0, 3);
+
+   // an action moves to the new code, entries left without one are freed
+   CHECK(ACTION_Assign(&learned, ACTION_RESET));
+   CHECK(Lookup(reset) == 0 && Lookup(learned) == ACTION_RESET && action.used == 2);
+   CHECK(ACTION_Assign(&learned, ACTION_POWER_OFF));
+   CHECK(Lookup(on) == ACTION_POWER_ON);
+   CHECK(Lookup(learned) == (ACTION_RESET | ACTION_POWER_OFF));
+   // protocol 0 like a cleared legacy code only removes the action
+   CHECK(ACTION_Assign(&(IRMP_DATA){ 0 }, ACTION_POWER_OFF));
+   CHECK(Lookup(learned) == ACTION_RESET);
+   Commit();
+   // unchanged, nothing to write
+   CHECK(ACTION_Assign(&learned, ACTION_RESET));
+   CHECK(Commit() == 0);
+}
+
+static void TestReports(void)
+{
+   IRMP_DATA on = Code(2, 0xFF00, 0x12), wakeup = Code(7, 0x1E, 0x0C);
+   uint8_t   report[ACTION_REPORT_SIZE];
+   int       i;
+
+   Format(0xFF);
+   CHECK(Report(5, on, ACTION_FORWARD | ACTION_SUPPRESS | ACTION_KEY | ACTION_CONSUMER, 0));
+   CHECK(Report(ACTION_INDEX_ANY, wakeup, ACTION_WAKEUP, 0));
+   // ACTION_KEY wins over ACTION_CONSUMER
+   CHECK(Lookup(on) == (ACTION_FORWARD | ACTION_SUPPRESS | ACTION_KEY));
+   CHECK(Lookup(wakeup) == ACTION_WAKEUP && action_table[0].protocol == 7);
+   ACTION_GetEntry(report);
+   CHECK(report[0] == 0 && report[1] == 7 && report[2] == 0x1E && report[4] == 0x0C);
+   CHECK(report[6] == ACTION_WAKEUP);
+
+   // the same code goes into the same entry
+   CHECK(Report(ACTION_INDEX_ANY, wakeup, ACTION_WAKEUP | ACTION_POWER_ON, 0));
+   CHECK(action.used == 2 && Lookup(wakeup) == (ACTION_WAKEUP | ACTION_POWER_ON));
+
+   // select only
+   CHECK(!Report(5, Code(ACTION_SELECT, 0, 0), 0, 0));
+   ACTION_GetEntry(report);
+   CHECK(report[0] == 5 && report[1] == 2 && report[2] == 0x00 && report[3] == 0xFF);
+   CHECK(report[4] == 0x12 && report[6] == (ACTION_FORWARD | ACTION_SUPPRESS | ACTION_KEY));
+   Report(ACTION_ENTRIES, Code(ACTION_SELECT, 0, 0), 0, 0);
+   ACTION_GetEntry(report);
+   CHECK(report[0] == ACTION_INDEX_ANY && report[1] == 0);
+
+   // no actions free the entry
+   CHECK(Report(5, on, 0, 0) && Lookup(on) == 0 && action.used == 1);
+   ACTION_GetEntry(report);
+   CHECK(report[0] == 5 && report[1] == 0 && report[6] == 0);
+
+   // reports beyond the queue are dropped
+   for(i = 0; i < ACTION_REQUESTS + 4; i++)
+   {
+      uint8_t r[ACTION_REPORT_SIZE] = { i, 3, 0, 0, i, 0, ACTION_POWER_ON, 0, 0 };
+      ACTION_SetEntry(r);
+   }
+   ACTION_Process();
+   CHECK(Lookup(Code(3, 0, ACTION_REQUESTS - 1)) != 0);
+   CHECK(Lookup(Code(3, 0, ACTION_REQUESTS)) == 0);
+
+   // a full table
+   Format(0xFF);
+   for(i = 0; i < ACTION_ENTRIES; i++)
+   {
+      Report(ACTION_INDEX_ANY, Code(1, 1, i), ACTION_FORWARD, 0);
+   }
+   CHECK(action.used == ACTION_ENTRIES);
+   Report(ACTION_INDEX_ANY, Code(1, 1, 999), ACTION_FORWARD, 0);
+   ACTION_GetEntry(report);
+   CHECK(report[0] == ACTION_INDEX_ANY);
+   CHECK(!ACTION_Assign(&(IRMP_DATA){ 1, 1, 1000, 0 }, ACTION_POWER_ON));
+   for(i = 0; i < ACTION_ENTRIES; i++)
+   {
+      CHECK(Lookup(Code(1, 1, i)) == ACTION_FORWARD);
+   }
+   CHECK(Commit() == ACTION_ENTRIES);
+   Reset();
+   CHECK(action.used == ACTION_ENTRIES);
+}
+
+static void TestUsages(void)
+{
+   IRMP_DATA key = Code(2, 0xFF00, 0x12), consumer = Code(7, 0x1E, 0x0C);
+   IRMP_DATA forward = Code(3, 1, 1);
+   uint8_t   report[ACTION_REPORT_SIZE];
+   uint16_t  usage;
+
+   Format(0xFF);
+   Report(3, key, ACTION_KEY, 0x0228);                   // Shift+Enter
+   Report(4, consumer, ACTION_CONSUMER | ACTION_SUPPRESS, 0xE9);
+   Report(5, forward, ACTION_FORWARD, 0x1234);           // no key, no usage
+   CHECK(ACTION_Lookup(&key, &usage) == ACTION_KEY && usage == 0x0228);
+   CHECK(ACTION_Lookup(&consumer, &usage) == (ACTION_CONSUMER | ACTION_SUPPRESS) && usage == 0xE9);
+   CHECK(ACTION_Lookup(&forward, &usage) == ACTION_FORWARD && usage == 0);
+   usage = 77;
+   CHECK(ACTION_Lookup(&(IRMP_DATA){ 9, 9, 9, 0 }, &usage) == 0 && usage == 0);
+
+   Report(4, Code(ACTION_SELECT, 0, 0), 0, 0);
+   ACTION_GetEntry(report);
+   CHECK(report[0] == 4 && report[1] == 7 && report[7] == 0xE9 && report[8] == 0);
+
+   // code, actions and usage are one record
+   CHECK(Commit() == 3);
+   Reset();
+   CHECK(ACTION_Lookup(&key, &usage) == ACTION_KEY && usage == 0x0228);
+   CHECK(ACTION_Lookup(&consumer, &usage) == (ACTION_CONSUMER | ACTION_SUPPRESS) && usage == 0xE9);
+   Report(3, key, ACTION_KEY, 0x0229);
+   CHECK(Commit() == 1);
+   Report(3, key, ACTION_KEY, 0x0229);
+   CHECK(Commit() == 0);
+
+   // an assignment keeps the usage, freeing clears it
+   CHECK(ACTION_Assign(&key, ACTION_POWER_ON));
+   CHECK(ACTION_Lookup(&key, &usage) == (ACTION_KEY | ACTION_POWER_ON) && usage == 0x0229);
+   Report(3, key, 0, 0x0229);
+   CHECK(ACTION_Lookup(&key, &usage) == 0 && usage == 0);
+}
+
+static void TestFailingWrites(void)
+{
+   IRMP_DATA code = Code(2, 0x10, 0x20);
+   long      events = pending_events;
+
+   Format(0xFF);
+   Report(7, code, ACTION_WAKEUP, 0);
+   CHECK(pending_events > events);
+
+   // the entry stays marked while the store fails
+   store_fail = true;
+   CHECK(ACTION_Commit());
+   CHECK(ACTION_Commit());
+   store_fail = false;
+   CHECK(!ACTION_Commit());
+   CHECK(records_used[7]);
+   Reset();
+   CHECK(Lookup(code) == ACTION_WAKEUP);
+}
+
+/**
+  * @brief  Random reports and assignments against the linear reference,
+  *         some writes fail, the table must survive a reset once all
+  *         entries are committed.
+  */
+static void TestRandom(void)
+{
+   IRMP_DATA saved[ACTION_ENTRIES];
+   uint16_t  saved_usages[ACTION_ENTRIES];
+   IRMP_DATA code;
+   int       n;
+
+   Format(0xFF);
+   for(n = 0; n < OPERATIONS; n++)
+   {
+      code = Code(1 + HOST_Random() % 3, HOST_Random() % 4, HOST_Random() % 24);
+      switch(HOST_Random() % 5)
+      {
+      case 0:
+         Report(HOST_Random() % ACTION_ENTRIES, code,
+                (HOST_Random() % 4) ? 1 << (HOST_Random() % 8) : 0, HOST_Random());
+         break;
+      case 1:
+         Report(ACTION_INDEX_ANY, code, HOST_Random() & ACTION_ALL, HOST_Random());
+         break;
+      case 2:
+         ACTION_Assign(&code, 1 << (HOST_Random() % 3));
+         break;
+      case 3:
+         // the main loop writes one entry per pass
+         store_fail = (HOST_Random() % 4 == 0);
+         ACTION_Commit();
+         store_fail = false;
+         break;
+      default:
+         CHECK(Lookup(code) == Reference(code));
+         break;
+      }
+
+      if(n % 1000 == 999)
+      {
+         memcpy(saved, action_table, sizeof(saved));
+         memcpy(saved_usages, action_usages, sizeof(saved_usages));
+         Commit();
+         Reset();
+         CHECK(memcmp(saved, action_table, sizeof(saved)) == 0);
+         CHECK(memcmp(saved_usages, action_usages, sizeof(saved_usages)) == 0);
+      }
+   }
+}
+
+/* Benchmark -----------------------------------------------------------------*/
+static IRMP_DATA linear[ACTION_ENTRIES];
+static int       linear_count;
+static volatile unsigned bench_sink;
+
+/**
+  * @brief  Linear search like IRMP_DataIsEqual() per entry.
+  */
+static uint8_t LinearLookup(const IRMP_DATA *code)
+{
+   int idx;
+
+   for(idx = 0; idx < linear_count; idx++)
+   {
+      if( linear[idx].command == code->command && linear[idx].address == code->address &&
+          linear[idx].protocol == code->protocol )
+      {
+         return linear[idx].flags;
+      }
+   }
+   return 0;
+}
+
+static IRMP_DATA CodeNec(int i)     { return Code(2, 0xFB04, i); }
+static IRMP_DATA CodeRc5(int i)     { return Code(7, i >> 6, i & 63); }
+static IRMP_DATA CodeMixed(int i)   { static const uint8_t p[4] = { 2, 7, 10, 5 };
+                                      return Code(p[i & 3], 0x1000 + (i >> 2) % 3, i >> 2); }
+static IRMP_DATA CodeLearned(int i) { return Code((i & 1) ? LEARN_PROTOCOL : 9, 0, i); }
+
+/**
+  * @brief  Prints the buckets probed for a hit and a miss.
+  */
+static void Probes(const char *name, IRMP_DATA (*generate)(int))
+{
+   IRMP_DATA code;
+   uint8_t   bucket;
+   int       hit_sum = 0, hit_max = 0, miss_sum = 0, miss_max = 0;
+   int       i, probes;
+
+   Format(0xFF);
+   for(i = 0; i < ACTION_ENTRIES; i++)
+   {
+      code = generate(i);
+      ACTION_Store(i, &code, ACTION_FORWARD, 0);
+   }
+   ACTION_Rebuild();
+
+   for(i = 0; i < ACTION_ENTRIES; i++)
+   {
+      code = generate(i);
+      for(bucket = ACTION_Hash(&code), probes = 1; action_hash[bucket] != i + 1; probes++)
+      {
+         bucket = (bucket + 1) & (ACTION_HASH_SIZE - 1);
+      }
+      hit_sum += probes;
+      hit_max = (probes > hit_max) ? probes : hit_max;
+   }
+   for(i = 0; i < BENCH_FRAMES; i++)
+   {
+      code = generate(ACTION_ENTRIES + i);
+      for(bucket = ACTION_Hash(&code), probes = 1; action_hash[bucket] != 0; probes++)
+      {
+         bucket = (bucket + 1) & (ACTION_HASH_SIZE - 1);
+      }
+      miss_sum += probes;
+      miss_max = (probes > miss_max) ? probes : miss_max;
+   }
+   printf("  %-26s hit %.2f (max %d), miss %.2f (max %d)\n", name,
+          (double)hit_sum / ACTION_ENTRIES, hit_max, (double)miss_sum / BENCH_FRAMES, miss_max);
+}
+
+static void Benchmark(void)
+{
+   static const int sizes[] = { 3, 16, 32, 64 };
+   static IRMP_DATA frames[BENCH_FRAMES];
+   unsigned  sum = 0;
+   double    start, linear_ns, hash_ns;
+   IRMP_DATA code;
+   int       s, i, round;
+
+   printf("buckets probed, %d entries in %d buckets:\n", ACTION_ENTRIES, ACTION_HASH_SIZE);
+   Probes("NEC, one address", CodeNec);
+   Probes("RC5, 64 commands/address", CodeRc5);
+   Probes("4 protocols", CodeMixed);
+   Probes("learned and one protocol", CodeLearned);
+
+   printf("ns per lookup, half hits, half misses:\n  entries  linear  hash\n");
+   for(s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])) && sizes[s] <= ACTION_ENTRIES; s++)
+   {
+      Format(0xFF);
+      for(linear_count = 0; linear_count < sizes[s]; )
+      {
+         code = Code(2, 0xFB04, HOST_Random() & 0xFF);
+         if(Reference(code) == 0)
+         {
+            ACTION_Store(linear_count, &code, ACTION_FORWARD, 0);
+            code.flags = ACTION_FORWARD;
+            linear[linear_count++] = code;
+         }
+      }
+      ACTION_Rebuild();
+      for(i = 0; i < BENCH_FRAMES; i++)
+      {
+         frames[i] = (i & 1) ? linear[HOST_Random() % linear_count] :
+                               Code(2, 0xFB04, 0x100 + (HOST_Random() & 0xFF));
+      }
+
+      start = HOST_Nanoseconds();
+      for(round = 0; round < BENCH_ROUNDS; round++)
+      {
+         for(i = 0; i < BENCH_FRAMES; i++)
+         {
+            sum += LinearLookup(&frames[i]);
+         }
+      }
+      linear_ns = (HOST_Nanoseconds() - start) / ((double)BENCH_ROUNDS * BENCH_FRAMES);
+
+      start = HOST_Nanoseconds();
+      for(round = 0; round < BENCH_ROUNDS; round++)
+      {
+         for(i = 0; i < BENCH_FRAMES; i++)
+         {
+            sum += Lookup(frames[i]);
+         }
+      }
+      hash_ns = (HOST_Nanoseconds() - start) / ((double)BENCH_ROUNDS * BENCH_FRAMES);
+
+      bench_sink = sum;
+      printf("  %7d  %6.2f  %4.2f\n", sizes[s], linear_ns, hash_ns);
+   }
+}
+
+int main(void)
+{
+   TestLegacy();
+   TestAssign();
+   TestReports();
+   TestUsages();
+   TestFailingWrites();
+   TestRandom();
+   Benchmark();
+
+   return HOST_Result();
+}
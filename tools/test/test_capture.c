@@ -0,0 +1,322 @@
+/**
+ * @file       test_capture.c
+ * @brief      Host test of the raw IR capture (capture.c).
+ *
+ * @details    The IR ISR is modelled by calling CAPTURE_Put() once per tick
+ *             with the input level of random bursts, main by calling
+ *             CAPTURE_Process() on EVENT_CAPTURE, and the host like
+ *             hidirt_capture: it polls the IN queue every millisecond and
+ *             grants one report per report received, with the enable bit set
+ *             in every REP_ID_CAPTURE_CONTROL. The reports are decoded and
+ *             compared with the runs put in. Several sessions run back to
+ *             back, each must only send its own runs. A session without
+ *             credits overruns the ring and must mark the lost runs with
+ *             0x00.
+ */
+
+#include "host.h"
+#include "capture.h"
+#include "usbd_customhid.h"
+#include "usbd_customhid_if.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SESSIONS           3
+#define BURSTS             50          /* per session */
+#define MAX_RUNS           (BURSTS * 128)   /* of one session */
+#define QUEUE_SIZE         4           /* IN queue of usbd_customhid.c */
+#define POLL_TICKS         15          /* 1 ms */
+#define HOST_CREDITS       8
+
+/* Private types -------------------------------------------------------------*/
+typedef struct RUN
+{
+   uint8_t  level;
+   uint16_t ticks;
+} run_t;
+
+/* Private variables ---------------------------------------------------------*/
+USBD_HandleTypeDef USBD_Device;
+
+static uint32_t raised;            /* events of SetEvent() */
+static uint8_t  queue[QUEUE_SIZE][1+CAPTURE_REPORT_SIZE];
+static int      queue_head;
+static int      queue_count;
+
+/* Stubs of the firmware ------------------------------------------------------*/
+void SetEvent(uint32_t event)
+{
+   raised |= event;
+}
+
+uint8_t USBD_CUSTOM_HID_GetInQueueSpace(void)
+{
+   return QUEUE_SIZE - queue_count;
+}
+
+uint8_t USBD_CUSTOM_HID_SendReport(USBD_HandleTypeDef *pdev, uint8_t *report, uint16_t len)
+{
+   (void)pdev;
+   if(queue_count >= QUEUE_SIZE || len != sizeof(queue[0]))
+   {
+      abort();
+   }
+   memcpy(queue[(queue_head + queue_count++) % QUEUE_SIZE], report, len);
+   return USBD_OK;
+}
+
+#include "../../src/capture.c"
+
+/* Test ----------------------------------------------------------------------*/
+static run_t    sent[MAX_RUNS];         /* runs put in, per session */
+static int      sent_count;
+static run_t    received[MAX_RUNS];     /* decoded, level 2 marks an overrun */
+static int      received_count;
+static uint32_t varint;                 /* of the run being decoded */
+static int      varint_shift;
+static int      reports;
+static uint8_t  next_sequence;
+static long     wrong_sequence;
+static long     wrong_report;
+
+/**
+  * @brief  Decodes one report like hidirt_capture.
+  */
+static void Decode(const uint8_t *report)
+{
+   int i;
+
+   if(report[0] != REP_ID_CAPTURE_DATA || report[2] == 0 || report[2] > CAPTURE_DATA_SIZE)
+   {
+      wrong_report++;
+      return;
+   }
+   wrong_sequence += report[1] != next_sequence;
+   next_sequence = report[1] + 1;
+   reports++;
+
+   for(i = 0; i < report[2]; i++)
+   {
+      if(received_count >= MAX_RUNS)
+      {
+         wrong_report++;
+         return;
+      }
+      if(report[3+i] == 0x00 && varint_shift == 0)
+      {
+         received[received_count].level = 2;
+         received[received_count++].ticks = 0;
+         continue;
+      }
+      varint |= (uint32_t)(report[3+i] & 0x7F) << varint_shift;
+      varint_shift += 7;
+      if((report[3+i] & 0x80) == 0)
+      {
+         received[received_count].level = varint & 1;
+         received[received_count++].ticks = varint >> 1;
+         varint = 0;
+         varint_shift = 0;
+      }
+   }
+}
+
+/**
+  * @brief  One poll of the host: takes a report from the IN queue and grants
+  *         another one.
+  */
+static void Poll(bool enable)
+{
+   if(queue_count == 0)
+   {
+      return;
+   }
+   Decode(queue[queue_head]);
+   queue_head = (queue_head + 1) % QUEUE_SIZE;
+   queue_count--;
+   USBD_CUSTOM_HID_InSentCallback();
+   CAPTURE_Control(enable, 1);
+}
+
+/**
+  * @brief  One tick of the IR ISR, main and every POLL_TICKS the host.
+  */
+static void Tick(uint8_t input, bool polling)
+{
+   static long ticks;
+
+   CAPTURE_Put(input, 1);
+   if(raised & EVENT_CAPTURE)
+   {
+      raised &= ~EVENT_CAPTURE;
+      CAPTURE_Process();
+   }
+   if(polling && ++ticks % POLL_TICKS == 0)
+   {
+      Poll(true);
+   }
+}
+
+/**
+  * @brief  Puts a level for a number of ticks and records the run.
+  */
+static void Level(uint8_t level, uint16_t ticks, bool polling)
+{
+   uint16_t i;
+
+   if(sent_count < MAX_RUNS)
+   {
+      sent[sent_count].level = level;
+      sent[sent_count++].ticks = ticks;
+   }
+   for(i = 0; i < ticks; i++)
+   {
+      Tick(level, polling);
+   }
+}
+
+/**
+  * @brief  A random burst of pulses and pauses, then the idle pause that ends
+  *         it. The idle pause is reported with CAPTURE_IDLE_TICKS.
+  */
+static void Burst(bool polling)
+{
+   int runs = 2 + HOST_Random() % 60;
+   int i;
+
+   for(i = 0; i < runs; i++)
+   {
+      Level(0, 1 + HOST_Random() % 150, polling);
+      Level(1, 1 + HOST_Random() % (CAPTURE_IDLE_TICKS - 1), polling);
+   }
+   Level(0, 1 + HOST_Random() % 150, polling);
+   Level(1, CAPTURE_IDLE_TICKS, polling);
+   for(i = HOST_Random() % 3000; i > 0; i--)
+   {
+      Tick(1, polling);
+   }
+}
+
+/**
+  * @brief  Starts a session like hidirt_capture, enable and credits in one
+  *         report.
+  */
+static void Start(void)
+{
+   sent_count = 0;
+   received_count = 0;
+   reports = 0;
+   CAPTURE_Control(true, HOST_CREDITS);
+}
+
+/**
+  * @brief  Stops the session and takes the rest of the runs.
+  */
+static void Stop(void)
+{
+   int i;
+
+   CAPTURE_Control(false, 0);
+   for(i = 0; i < 100 * POLL_TICKS; i++)
+   {
+      Tick(1, false);
+      if(i % POLL_TICKS == 0)
+      {
+         Poll(false);
+      }
+   }
+}
+
+static bool SameRun(const run_t *a, const run_t *b)
+{
+   return a->level == b->level && a->ticks == b->ticks;
+}
+
+static void TestSessions(void)
+{
+   int  session, i, idle_reports;
+   long wrong = 0;
+
+   for(session = 0; session < SESSIONS; session++)
+   {
+      Start();
+      // nothing may be sent before the first pulse
+      for(i = 0; i < 20 * POLL_TICKS; i++)
+      {
+         Tick(1, true);
+      }
+      idle_reports = reports;
+      for(i = 0; i < BURSTS; i++)
+      {
+         Burst(true);
+      }
+      Stop();
+
+      CHECK(idle_reports == 0);
+      CHECK(received_count == sent_count);
+      for(i = 0; i < received_count && i < sent_count; i++)
+      {
+         wrong += !SameRun(&received[i], &sent[i]);
+      }
+      printf("session %d: %d runs sent in %d reports, %ld wrong\n",
+             session + 1, received_count, reports, wrong);
+   }
+   CHECK(wrong == 0);
+   CHECK(wrong_sequence == 0 && wrong_report == 0);
+   CHECK(queue_count == 0 && !capture.enabled);
+}
+
+static void TestOverrun(void)
+{
+   int  i, found = 0, markers = 0;
+   long wrong = 0;
+
+   // the host grants nothing until the bursts are over, the lost runs are
+   // marked before the next run that fits
+   sent_count = 0;
+   received_count = 0;
+   reports = 0;
+   capture.credits = 0;
+   CAPTURE_Control(true, 0);
+   for(i = 0; i < POLL_TICKS; i++)
+   {
+      Tick(1, false);
+   }
+   for(i = 0; i < 10; i++)
+   {
+      Burst(false);
+   }
+   CAPTURE_Control(true, HOST_CREDITS);
+   Burst(true);
+   Stop();
+
+   // every part between two marks is a sequence of runs that were put in
+   for(i = 0; i < received_count; i++)
+   {
+      if(received[i].level == 2)
+      {
+         markers++;
+         continue;
+      }
+      while(found < sent_count && !SameRun(&received[i], &sent[found]))
+      {
+         found++;
+      }
+      wrong += found == sent_count;
+      found++;
+   }
+   CHECK(markers > 0);
+   CHECK(wrong == 0);
+   CHECK(received_count > 0 && received[received_count-1].level == 1);
+   CHECK(wrong_sequence == 0 && wrong_report == 0);
+   printf("overrun: %d runs put in, %d received with %d marks of lost runs\n",
+          sent_count, received_count - markers, markers);
+}
+
+int main(void)
+{
+   TestSessions();
+   TestOverrun();
+   // capture works again after the overrun
+   TestSessions();
+
+   return HOST_Result();
+}
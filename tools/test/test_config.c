@@ -0,0 +1,467 @@
+/**
+ * @file       test_config.c
+ * @brief      Host test of the pending configuration updates
+ *             (usbd_customhid_if.c).
+ *
+ * @details    Feature reports are sent like the USB interrupt does, main is
+ *             modelled by calling GetHidirtShadowConfig() on
+ *             EVENT_CONFIG_UPDATE. The test checks that
+ *             - a burst of every configuration report is applied and stored
+ *               in one pass of main,
+ *             - values the write-back cache refused with HAL_BUSY stay
+ *               pending, raise the event again and are stored later,
+ *             - random reports, read-backs, passes of main and a busy cache
+ *               leave the applied configuration and the EEPROM at the last
+ *               value sent of every report.
+ */
+
+#include "host.h"
+#include "usbd_customhid_if.h"
+#include "global_variables.h"
+#include "action.h"
+#include "swrtc.h"
+
+/* Private define ------------------------------------------------------------*/
+#define OPERATIONS         500000
+#define BUSY_PERCENT       25       /* of the EEPROM writes in TestRandom() */
+
+/* Private variables ---------------------------------------------------------*/
+RTC_HandleTypeDef  RtcHandle;
+fifo_t             irsnd_fifo;
+
+static hidirt_data_t config;        /* hidirt_data of main */
+static hidirt_data_t expected;      /* last values sent */
+static uint8_t   eeprom[ADDRESS_records * EEPROM_ADDRESS_SIZE];
+static uint32_t  raised;            /* events of SetEvent() */
+static int       busy_percent;
+static long      writes;
+static long      busy_writes;
+static IRMP_DATA action_codes[ACTION_RESET + 1];
+static uint32_t  alarm_time[2];
+static int32_t   deviation;
+static uint64_t  protocol_mask;
+static uint8_t   polling_interval;
+
+/* Stubs of the firmware ------------------------------------------------------*/
+void SetEvent(uint32_t event)
+{
+   raised |= event;
+}
+
+HAL_StatusTypeDef EEPROM_WriteBytesDeferred(uint32_t address, void *data, uint8_t length)
+{
+   if((address + 1) * EEPROM_ADDRESS_SIZE > sizeof(eeprom) ||
+      address * EEPROM_ADDRESS_SIZE + length > sizeof(eeprom))
+   {
+      abort();
+   }
+   if((int)(HOST_Random() % 100) < busy_percent)
+   {
+      busy_writes++;
+      return HAL_BUSY;
+   }
+   writes++;
+   memcpy(&eeprom[address * EEPROM_ADDRESS_SIZE], data, length);
+   return HAL_OK;
+}
+
+bool EEPROM_CommitAll(void)
+{
+   return true;
+}
+
+void GetHidirtConfig(hidirt_data_t* data)
+{
+   *data = config;
+}
+
+bool ACTION_Assign(const IRMP_DATA *irmp_data, uint8_t action_bit)
+{
+   action_codes[action_bit] = *irmp_data;
+   return true;
+}
+
+void ACTION_GetCode(uint8_t action_bit, IRMP_DATA *irmp_data)
+{
+   *irmp_data = action_codes[action_bit];
+}
+
+uint32_t SWRTC_GetAlarmTime(uint8_t idx)
+{
+   return alarm_time[idx];
+}
+
+bool SWRTC_SetAlarmTime(uint8_t idx, uint32_t time)
+{
+   alarm_time[idx] = time;
+   return true;
+}
+
+bool SWRTC_SetDeviation(int32_t value)
+{
+   deviation = value;
+   return true;
+}
+
+void irmp_set_protocol_mask(uint64_t mask)
+{
+   protocol_mask = mask;
+}
+
+void USBD_CUSTOM_HID_SetPollingInterval(uint8_t interval)
+{
+   polling_interval = interval;
+}
+
+swrtc_time_t SWRTC_GetTime(void) { swrtc_time_t time = { 0 }; return time; }
+void SWRTC_SetTime(swrtc_time_t time) { (void)time; }
+void HAL_RTCEx_BKUPWrite(RTC_HandleTypeDef *hrtc, uint32_t reg, uint32_t data) { (void)hrtc; (void)reg; (void)data; }
+uint32_t IRMP_GetIsrLatency(void) { return 0; }
+void GetCpuLoad(cpu_load_t* load) { memset(load, 0, sizeof(*load)); }
+void USBD_CUSTOM_HID_GetInStats(USBD_CUSTOM_HID_InStatsTypeDef *stats) { memset(stats, 0, sizeof(*stats)); }
+bool FIFO_Write(fifo_t* fifo, fifo_entry_t* entry) { (void)fifo; (void)entry; return true; }
+void CAPTURE_Control(bool enable, uint8_t credits) { (void)enable; (void)credits; }
+void CAPTURE_GetControl(uint8_t *control) { (void)control; }
+void LEARN_Control(uint8_t command, uint8_t slot) { (void)command; (void)slot; }
+void LEARN_GetControl(uint8_t *control) { (void)control; }
+void ACTION_SetEntry(const uint8_t *report) { (void)report; }
+void ACTION_GetEntry(uint8_t *report) { (void)report; }
+
+#include "../../src/usbd_customhid_if.c"
+
+/* Test ----------------------------------------------------------------------*/
+/* the configuration reports, the bootloader request never returns */
+static const uint8_t reports[] =
+{
+   REP_ID_CONTROL_PC_ENABLE, REP_ID_FORWARD_IR_ENABLE, REP_ID_POWER_ON_IR_CODE,
+   REP_ID_POWER_OFF_IR_CODE, REP_ID_RESET_IR_CODE, REP_ID_MINIMUM_REPEATS,
+   REP_ID_CLOCK_CORRECTION, REP_ID_WAKEUP_TIME, REP_ID_WAKEUP_TIME_SPAN,
+   REP_ID_PROTOCOL_MASK, REP_ID_POLLING_INTERVAL, REP_ID_REPEAT_SHAPING,
+   REP_ID_CONFIG_BLOB, REP_ID_WATCHDOG_ENABLE, REP_ID_WATCHDOG_RESET
+};
+#define REPORTS            (sizeof(reports) / sizeof(reports[0]))
+
+/* the updates stored in the EEPROM */
+#define UPDATE_EEPROM      (UPDATE_CONTROL_PC_ENABLE | UPDATE_FORWARD_IR_ENABLE | \
+                            UPDATE_MINIMUM_REPEATS | UPDATE_CLOCK_CORRECTION | \
+                            UPDATE_WAKEUP_TIME_SPAN | UPDATE_PROTOCOL_MASK | \
+                            UPDATE_POLLING_INTERVAL | UPDATE_REPEAT_SHAPING)
+
+static uint32_t  sent_alarm;
+
+static void RandomCode(IRMP_DATA *code)
+{
+   code->protocol = HOST_Random() % 50;
+   code->address = HOST_Random();
+   code->command = HOST_Random();
+   code->flags = HOST_Random() & 1;
+}
+
+/**
+  * @brief  Sends a report with random values like the USB interrupt and
+  *         records them as the expected configuration.
+  */
+static void Send(uint8_t report)
+{
+   uint8_t       buffer[USBD_CUSTOMHID_FEATREPORT_BUF_SIZE];
+   hidirt_data_t blob;
+
+   memset(buffer, 0, sizeof(buffer));
+   switch(report)
+   {
+   case REP_ID_CONTROL_PC_ENABLE:
+      buffer[0] = HOST_Random() & 1;
+      expected.control_pc_enable = buffer[0];
+      break;
+   case REP_ID_FORWARD_IR_ENABLE:
+      buffer[0] = HOST_Random() & 1;
+      expected.forward_ir_enable = buffer[0];
+      break;
+   case REP_ID_WATCHDOG_ENABLE:
+      buffer[0] = HOST_Random() & 1;
+      expected.watchdog_enable = buffer[0];
+      break;
+   case REP_ID_WATCHDOG_RESET:
+      buffer[0] = HOST_Random() & 1;
+      expected.watchdog_reset = buffer[0];
+      break;
+   case REP_ID_POWER_ON_IR_CODE:
+      RandomCode(&expected.irmp_power_on);
+      memcpy(buffer, &expected.irmp_power_on, sizeof(IRMP_DATA));
+      break;
+   case REP_ID_POWER_OFF_IR_CODE:
+      RandomCode(&expected.irmp_power_off);
+      memcpy(buffer, &expected.irmp_power_off, sizeof(IRMP_DATA));
+      break;
+   case REP_ID_RESET_IR_CODE:
+      RandomCode(&expected.irmp_reset);
+      memcpy(buffer, &expected.irmp_reset, sizeof(IRMP_DATA));
+      break;
+   case REP_ID_MINIMUM_REPEATS:
+      expected.min_ir_repeats = buffer[0] = HOST_Random();
+      break;
+   case REP_ID_WAKEUP_TIME_SPAN:
+      expected.wakeup_time_span = buffer[0] = HOST_Random();
+      break;
+   case REP_ID_POLLING_INTERVAL:
+      expected.polling_interval = buffer[0] = HOST_Random();
+      break;
+   case REP_ID_CLOCK_CORRECTION:
+      expected.clock_correction = HOST_Random() - 0x800000;
+      memcpy(buffer, &expected.clock_correction, sizeof(int32_t));
+      break;
+   case REP_ID_WAKEUP_TIME:
+      sent_alarm = HOST_Random();
+      memcpy(buffer, &sent_alarm, sizeof(uint32_t));
+      break;
+   case REP_ID_PROTOCOL_MASK:
+      expected.protocol_mask = (uint64_t)HOST_Random() << 40 | HOST_Random();
+      memcpy(buffer, &expected.protocol_mask, sizeof(uint64_t));
+      break;
+   case REP_ID_REPEAT_SHAPING:
+      expected.repeat.delay = HOST_Random();
+      expected.repeat.period = HOST_Random();
+      expected.repeat.timeout = HOST_Random();
+      memcpy(buffer, &expected.repeat, sizeof(repeat_config_t));
+      break;
+   case REP_ID_CONFIG_BLOB:
+      // a blob of version 1 leaves the repeat shaping
+      blob = expected;
+      blob.clock_correction = HOST_Random() - 0x800000;
+      blob.protocol_mask = (uint64_t)HOST_Random() << 40 | HOST_Random();
+      blob.min_ir_repeats = HOST_Random();
+      blob.wakeup_time_span = HOST_Random();
+      blob.polling_interval = HOST_Random();
+      blob.control_pc_enable = HOST_Random() & 1;
+      blob.forward_ir_enable = HOST_Random() & 1;
+      RandomCode(&blob.irmp_power_on);
+      RandomCode(&blob.irmp_power_off);
+      RandomCode(&blob.irmp_reset);
+      blob.repeat.delay = HOST_Random();
+      blob.repeat.period = HOST_Random();
+      blob.repeat.timeout = HOST_Random();
+      CustomHID_PackConfig(&blob, buffer);
+      if(HOST_Random() & 1)
+      {
+         buffer[0] = 1;
+         blob.repeat = expected.repeat;
+      }
+      expected = blob;
+      break;
+   default:
+      abort();
+   }
+   CustomHID_SetFeature(report, buffer);
+}
+
+/**
+  * @brief  One pass of main if the event is pending.
+  * @return true if main ran.
+  */
+static bool Main(void)
+{
+   if((raised & EVENT_CONFIG_UPDATE) == 0)
+   {
+      return false;
+   }
+   raised &= ~EVENT_CONFIG_UPDATE;
+   GetHidirtShadowConfig(&config);
+   return true;
+}
+
+static bool SameCode(const IRMP_DATA *a, const IRMP_DATA *b)
+{
+   return a->protocol == b->protocol && a->address == b->address &&
+          a->command == b->command && a->flags == b->flags;
+}
+
+/**
+  * @brief  Checks that main works with the last values sent.
+  */
+static bool Applied(void)
+{
+   return config.control_pc_enable == expected.control_pc_enable &&
+          config.forward_ir_enable == expected.forward_ir_enable &&
+          config.watchdog_enable == expected.watchdog_enable &&
+          config.watchdog_reset == expected.watchdog_reset &&
+          config.min_ir_repeats == expected.min_ir_repeats &&
+          config.wakeup_time_span == expected.wakeup_time_span &&
+          config.polling_interval == expected.polling_interval &&
+          config.clock_correction == expected.clock_correction &&
+          config.protocol_mask == expected.protocol_mask &&
+          !memcmp(&config.repeat, &expected.repeat, sizeof(repeat_config_t)) &&
+          SameCode(&config.irmp_power_on, &expected.irmp_power_on) &&
+          SameCode(&config.irmp_power_off, &expected.irmp_power_off) &&
+          SameCode(&config.irmp_reset, &expected.irmp_reset) &&
+          SameCode(&action_codes[ACTION_POWER_ON], &expected.irmp_power_on) &&
+          SameCode(&action_codes[ACTION_POWER_OFF], &expected.irmp_power_off) &&
+          SameCode(&action_codes[ACTION_RESET], &expected.irmp_reset) &&
+          deviation == expected.clock_correction &&
+          protocol_mask == (expected.protocol_mask ? expected.protocol_mask : IRMP_ALL_PROTOCOLS) &&
+          polling_interval == expected.polling_interval &&
+          alarm_time[0] == sent_alarm &&
+          alarm_time[1] == sent_alarm + expected.wakeup_time_span * 60;
+}
+
+/**
+  * @brief  Checks that the EEPROM holds the last values sent.
+  */
+static bool Stored(void)
+{
+#define SAME(address, field) \
+   !memcmp(&eeprom[(address) * EEPROM_ADDRESS_SIZE], &expected.field, sizeof(expected.field))
+   return SAME(ADDRESS_control_pc_enable, control_pc_enable) &&
+          SAME(ADDRESS_forward_ir_enable, forward_ir_enable) &&
+          SAME(ADDRESS_min_ir_repeats, min_ir_repeats) &&
+          SAME(ADDRESS_clock_correction, clock_correction) &&
+          SAME(ADDRESS_wakeup_time_span, wakeup_time_span) &&
+          SAME(ADDRESS_protocol_mask, protocol_mask) &&
+          SAME(ADDRESS_polling_interval, polling_interval) &&
+          SAME(ADDRESS_repeat_shaping, repeat);
+#undef SAME
+}
+
+/**
+  * @brief  Checks a read-back of a report against the last value sent.
+  */
+static bool ReadBack(uint8_t report)
+{
+   uint8_t  buffer[USBD_CUSTOMHID_FEATREPORT_BUF_SIZE];
+   uint8_t  blob[USBD_CUSTOMHID_FEATREPORT_BUF_SIZE];
+   uint16_t length = sizeof(buffer);
+
+   CustomHID_GetFeature(report, buffer, &length);
+   switch(report)
+   {
+   case REP_ID_CONTROL_PC_ENABLE: return buffer[0] == expected.control_pc_enable;
+   case REP_ID_FORWARD_IR_ENABLE: return buffer[0] == expected.forward_ir_enable;
+   case REP_ID_WATCHDOG_ENABLE:   return buffer[0] == expected.watchdog_enable;
+   case REP_ID_MINIMUM_REPEATS:   return buffer[0] == expected.min_ir_repeats;
+   case REP_ID_WAKEUP_TIME_SPAN:  return buffer[0] == expected.wakeup_time_span;
+   case REP_ID_POLLING_INTERVAL:  return buffer[0] == expected.polling_interval;
+   case REP_ID_WAKEUP_TIME:       return !memcmp(buffer, &sent_alarm, 4);
+   case REP_ID_CLOCK_CORRECTION:  return !memcmp(buffer, &expected.clock_correction, 4);
+   case REP_ID_PROTOCOL_MASK:     return !memcmp(buffer, &expected.protocol_mask, 8);
+   case REP_ID_REPEAT_SHAPING:    return !memcmp(buffer, &expected.repeat, sizeof(repeat_config_t));
+   case REP_ID_POWER_ON_IR_CODE:  return !memcmp(buffer, &expected.irmp_power_on, sizeof(IRMP_DATA));
+   case REP_ID_POWER_OFF_IR_CODE: return !memcmp(buffer, &expected.irmp_power_off, sizeof(IRMP_DATA));
+   case REP_ID_RESET_IR_CODE:     return !memcmp(buffer, &expected.irmp_reset, sizeof(IRMP_DATA));
+   case REP_ID_CONFIG_BLOB:
+      CustomHID_PackConfig(&expected, blob);
+      return !memcmp(buffer, blob, CONFIG_BLOB_SIZE);
+   default:
+      return true;
+   }
+}
+
+static void TestBurst(void)
+{
+   unsigned i;
+   int      passes = 0;
+
+   busy_percent = 0;
+   for(i = 0; i < REPORTS; i++)
+   {
+      Send(reports[i]);
+   }
+   CHECK(hidirt_data_shadow.data_update_pending == (UPDATE_CONFIG_BLOB | UPDATE_WAKEUP_TIME |
+         UPDATE_WATCHDOG_ENABLE | UPDATE_WATCHDOG_RESET));
+   while(Main())
+   {
+      passes++;
+   }
+   CHECK(passes == 1);
+   CHECK(hidirt_data_shadow.data_update_pending == 0);
+   CHECK(Applied());
+   CHECK(Stored());
+   printf("burst of %u reports applied in %d pass of main\n", (unsigned)REPORTS, passes);
+}
+
+static void TestBusy(void)
+{
+   unsigned i;
+
+   // the cache takes nothing, all values are used but stay pending
+   busy_percent = 100;
+   busy_writes = 0;
+   for(i = 0; i < REPORTS; i++)
+   {
+      Send(reports[i]);
+   }
+   CHECK(Main());
+   CHECK(Applied());
+   CHECK(hidirt_data_shadow.data_update_pending == UPDATE_EEPROM);
+   CHECK(raised & EVENT_CONFIG_UPDATE);
+   CHECK(busy_writes == 8);
+   for(i = 0; i < REPORTS; i++)
+   {
+      CHECK(ReadBack(reports[i]));
+   }
+
+   // stored on the next pass
+   busy_percent = 0;
+   CHECK(Main());
+   CHECK(!Main());
+   CHECK(hidirt_data_shadow.data_update_pending == 0);
+   CHECK(Applied());
+   CHECK(Stored());
+}
+
+static void TestRandom(void)
+{
+   long     sent = 0, passes = 0, wrong_applied = 0, wrong_read = 0, no_retry = 0;
+   long     before;
+   uint32_t op;
+   int      i;
+
+   busy_percent = BUSY_PERCENT;
+   busy_writes = writes = 0;
+   for(i = 0; i < OPERATIONS; i++)
+   {
+      op = HOST_Random() % 8;
+      if(op < 5)
+      {
+         Send(reports[HOST_Random() % REPORTS]);
+         sent++;
+      }
+      else if(op < 6)
+      {
+         wrong_read += !ReadBack(reports[HOST_Random() % REPORTS]);
+      }
+      else
+      {
+         before = busy_writes;
+         if(Main())
+         {
+            passes++;
+            wrong_applied += !Applied();
+            // a refused value must come back
+            no_retry += busy_writes != before && (!(raised & EVENT_CONFIG_UPDATE) ||
+                        (hidirt_data_shadow.data_update_pending & UPDATE_EEPROM) == 0);
+         }
+      }
+   }
+   busy_percent = 0;
+   while(Main())
+   {
+      passes++;
+   }
+
+   CHECK(wrong_applied == 0);
+   CHECK(wrong_read == 0);
+   CHECK(no_retry == 0);
+   CHECK(hidirt_data_shadow.data_update_pending == 0);
+   CHECK(Applied());
+   CHECK(Stored());
+   printf("random: %ld reports, %ld passes of main, %ld of %ld writes refused and retried\n",
+          sent, passes, busy_writes, busy_writes + writes);
+}
+
+int main(void)
+{
+   TestBurst();
+   TestBusy();
+   TestRandom();
+
+   return HOST_Result();
+}
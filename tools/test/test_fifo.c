@@ -0,0 +1,582 @@
+/**
+ * @file       test_fifo.c
+ * @brief      Host test, stress test and benchmark of the FIFO (fifo.c).
+ *
+ * @details    The functional test covers the wrap of the free-running
+ *             indices, the full capacity, the bulk and in-place accesses, the
+ *             high watermark and an instance of the template (fifos.h).
+ *
+ *             In the stress test producers write numbered entries, the single
+ *             consumer checks that every entry of every producer arrives
+ *             exactly once and in order. Three setups:
+ *             - threads: PRODUCERS threads write at the same
+ *               time while the main thread reads,
+ *             - ISR: the main thread writes like main and a timer signal
+ *               interrupts it and writes like the USB ISR does, a thread
+ *               reads. The signal handler gives up if the FIFO is full,
+ *             - mixed: the producer threads alternate FIFO_Write(),
+ *               FIFO_Reserve()/FIFO_Commit() and FIFO_WriteBulk(), the main
+ *               thread FIFO_Read(), FIFO_Peek()/FIFO_Release() and
+ *               FIFO_ReadBulk().
+ *
+ *             On the host the slots are reserved with the C11 atomics of
+ *             gcc, on the Cortex-M3 with LDREX/STREX.
+ *
+ *             The benchmark prints the operations per second of the FIFO and
+ *             of the previous one with masked indices and a wasted slot.
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/time.h>
+#include "host.h"
+#include "fifo.h"
+
+/* Private define ------------------------------------------------------------*/
+#define PRODUCERS          4
+#define WRITES             1000000     /* per producer */
+#define ISR_WRITES         1000000     /* of main in the ISR setup */
+#define ISR_PERIOD_US      10
+#define MIXED_WRITES       250000      /* per producer */
+#define WRAPS              5000
+#define BENCH_OPERATIONS   10000000
+#define BENCH_BURST        8
+
+/* Private variables ---------------------------------------------------------*/
+static fifo_t            fifo;
+static volatile uint32_t written[2];   /* by main and the ISR */
+static volatile bool     done;
+static int               producers_done;
+static volatile unsigned bench_sink;
+
+#include "../../src/fifo.c"
+
+// the instance TEST of the template, with its own FIFO_SIZE
+#pragma push_macro("FIFO_SIZE")
+#include "fifos.h"
+#include "../../src/fifo.c"
+#undef FIFO_PREFIX
+#pragma pop_macro("FIFO_SIZE")
+
+static TEST_fifo_t       test_fifo;
+
+/* Previous FIFO -------------------------------------------------------------*/
+/**
+* @brief       The FIFO before the reserve/commit rework, for the benchmark:
+*              masked indices, one slot stays unused, a single producer.
+*/
+typedef struct OLD_FIFO {
+   fifo_idx_t           read;
+   fifo_idx_t           write;
+   fifo_entry_t         entry[FIFO_SIZE];
+} old_fifo_t;
+
+static old_fifo_t        old_fifo;
+
+static bool OLD_FIFO_Read(old_fifo_t* fifo, fifo_entry_t* entry)
+{
+   if(fifo->read == fifo->write)
+   {
+      return false;
+   }
+   memcpy(entry, &fifo->entry[fifo->read], sizeof(fifo_entry_t));
+   fifo->read = (fifo->read + 1) & (FIFO_SIZE - 1);
+   return true;
+}
+
+static bool OLD_FIFO_Write(old_fifo_t* fifo, fifo_entry_t* entry)
+{
+   fifo_idx_t next;
+   next = (fifo->write + 1) & (FIFO_SIZE - 1);
+   if(fifo->read == next)
+   {
+      return false;
+   }
+   memcpy(&fifo->entry[fifo->write & (FIFO_SIZE - 1)], entry, sizeof(fifo_entry_t));
+   fifo->write = next;
+   return true;
+}
+
+/* Test ----------------------------------------------------------------------*/
+static void TestApi(void)
+{
+   fifo_entry_t entry, in[2 * FIFO_SIZE + 8], out[2 * FIFO_SIZE + 8];
+   fifo_entry_t *a, *b;
+   long         wrong = 0;
+   int          i, wrap;
+
+   memset(in, 0, sizeof(in));
+   for(i = 0; i < (int)(sizeof(in) / sizeof(in[0])); i++)
+   {
+      in[i].data.command = i;
+   }
+
+   FIFO_Clear(&fifo);
+   CHECK(FIFO_HighWatermark(&fifo) == 0);
+   for(wrap = 0; wrap < WRAPS; wrap++)
+   {
+      // all slots can be used
+      for(i = 0; i < FIFO_SIZE; i++)
+      {
+         wrong += !FIFO_Write(&fifo, &in[i]);
+      }
+      wrong += !FIFO_IsFull(&fifo) || FIFO_Count(&fifo) != FIFO_SIZE;
+      wrong += FIFO_Write(&fifo, &in[0]) || FIFO_Reserve(&fifo) != NULL;
+      for(i = 0; i < FIFO_SIZE; i++)
+      {
+         wrong += !FIFO_Read(&fifo, &entry) || entry.data.command != i;
+      }
+      wrong += !FIFO_IsEmpty(&fifo) || FIFO_Count(&fifo) != 0;
+      wrong += FIFO_Read(&fifo, &entry) || FIFO_Peek(&fifo) != NULL;
+
+      // bulk, limited by the room and by the stored entries
+      wrong += FIFO_WriteBulk(&fifo, in, 5) != 5;
+      wrong += FIFO_WriteBulk(&fifo, in + 5, 2 * FIFO_SIZE) != FIFO_SIZE - 5;
+      wrong += FIFO_WriteBulk(&fifo, in, 1) != 0;
+      wrong += FIFO_ReadBulk(&fifo, out, 3) != 3 || out[2].data.command != 2;
+      wrong += FIFO_ReadBulk(&fifo, out, 2 * FIFO_SIZE) != FIFO_SIZE - 3;
+      for(i = 0; i < FIFO_SIZE - 3; i++)
+      {
+         wrong += out[i].data.command != i + 3;
+      }
+      wrong += FIFO_ReadBulk(&fifo, out, 1) != 0;
+      wrong += FIFO_WriteBulk(&fifo, in, 2 * FIFO_SIZE) != FIFO_SIZE;
+      wrong += FIFO_ReadBulk(&fifo, out, 2 * FIFO_SIZE) != FIFO_SIZE;
+      for(i = 0; i < FIFO_SIZE; i++)
+      {
+         wrong += out[i].data.command != i;
+      }
+
+      // in place, an entry is readable once all before it are committed
+      a = FIFO_Reserve(&fifo);
+      b = FIFO_Reserve(&fifo);
+      wrong += a == NULL || b == NULL || a == b;
+      b->data.command = 2;
+      FIFO_Commit(&fifo, b);
+      wrong += FIFO_Peek(&fifo) != NULL || !FIFO_IsEmpty(&fifo);
+      a->data.command = 1;
+      FIFO_Commit(&fifo, a);
+      wrong += FIFO_Count(&fifo) != 2;
+      wrong += FIFO_Peek(&fifo) == NULL || FIFO_Peek(&fifo)->data.command != 1;
+      FIFO_Release(&fifo);
+      wrong += FIFO_Peek(&fifo) == NULL || FIFO_Peek(&fifo)->data.command != 2;
+      FIFO_Release(&fifo);
+      wrong += FIFO_Peek(&fifo) != NULL;
+
+      // shift the indices against the 16 bit wrap
+      for(i = 0; i < wrap % 7; i++)
+      {
+         FIFO_Write(&fifo, &in[0]);
+         FIFO_Read(&fifo, &entry);
+      }
+   }
+   CHECK(wrong == 0);
+   CHECK(FIFO_HighWatermark(&fifo) == FIFO_SIZE);
+   FIFO_Clear(&fifo);
+   CHECK(FIFO_IsEmpty(&fifo) && FIFO_HighWatermark(&fifo) == 0);
+}
+
+static void TestTemplate(void)
+{
+   TEST_fifo_entry_t entry = { 0, 0 }, out[2 * TEST_FIFO_ELEMENTS];
+   TEST_fifo_entry_t *slot;
+   long              wrong = 0;
+   int               i;
+
+   TEST_FIFO_Clear(&test_fifo);
+   for(i = 0; i < TEST_FIFO_ELEMENTS; i++)
+   {
+      entry.sequence = i;
+      wrong += !TEST_FIFO_Write(&test_fifo, &entry);
+   }
+   wrong += !TEST_FIFO_IsFull(&test_fifo) || TEST_FIFO_Write(&test_fifo, &entry);
+   wrong += !TEST_FIFO_Read(&test_fifo, &entry) || entry.sequence != 0;
+   slot = TEST_FIFO_Reserve(&test_fifo);
+   wrong += slot == NULL;
+   slot->sequence = TEST_FIFO_ELEMENTS;
+   TEST_FIFO_Commit(&test_fifo, slot);
+   wrong += TEST_FIFO_Count(&test_fifo) != TEST_FIFO_ELEMENTS;
+   wrong += TEST_FIFO_ReadBulk(&test_fifo, out, 2 * TEST_FIFO_ELEMENTS) != TEST_FIFO_ELEMENTS;
+   for(i = 0; i < TEST_FIFO_ELEMENTS; i++)
+   {
+      wrong += out[i].sequence != (uint32_t)i + 1;
+   }
+   CHECK(wrong == 0);
+   CHECK(TEST_FIFO_IsEmpty(&test_fifo) && TEST_FIFO_Peek(&test_fifo) == NULL);
+   CHECK(TEST_FIFO_HighWatermark(&test_fifo) == TEST_FIFO_ELEMENTS);
+   CHECK(sizeof(test_fifo.entry) == TEST_FIFO_ELEMENTS * sizeof(TEST_fifo_entry_t));
+}
+
+static void SetEntry(fifo_entry_t *entry, uint8_t producer, uint32_t sequence)
+{
+   memset(entry, 0, sizeof(*entry));
+   entry->data.protocol = producer;
+   entry->data.address = sequence & 0xFFFF;
+   entry->data.command = sequence >> 16;
+}
+
+/**
+  * @brief  Checks that an entry is the next one of its producer.
+  */
+static bool IsNext(const fifo_entry_t *entry, uint32_t *next, int producers)
+{
+   uint32_t sequence = entry->data.address | (uint32_t)entry->data.command << 16;
+
+   if(entry->data.protocol >= producers || sequence != next[entry->data.protocol])
+   {
+      return false;
+   }
+   next[entry->data.protocol]++;
+   return true;
+}
+
+static void *Producer(void *arg)
+{
+   uint8_t      producer = (uintptr_t)arg;
+   fifo_entry_t entry;
+   uint32_t     i;
+
+   for(i = 0; i < WRITES; i++)
+   {
+      SetEntry(&entry, producer, i);
+      while(!FIFO_Write(&fifo, &entry))
+      {
+         sched_yield();
+      }
+   }
+   __atomic_add_fetch(&producers_done, 1, __ATOMIC_RELEASE);
+   return NULL;
+}
+
+/**
+  * @brief  Writes the next entry of main or of the ISR if there is room.
+  */
+static void Put(uint8_t producer)
+{
+   fifo_entry_t entry;
+
+   SetEntry(&entry, producer, written[producer]);
+   if(FIFO_Write(&fifo, &entry))
+   {
+      written[producer]++;
+   }
+}
+
+static void Isr(int signal)
+{
+   (void)signal;
+   Put(1);
+   Put(1);
+}
+
+static void *Consumer(void *arg)
+{
+   long         *result = arg;   /* read, out of order */
+   uint32_t     next[2] = { 0, 0 };
+   fifo_entry_t entry;
+
+   for(;;)
+   {
+      if(FIFO_Read(&fifo, &entry))
+      {
+         result[0]++;
+         result[1] += !IsNext(&entry, next, 2);
+      }
+      else if(done && FIFO_IsEmpty(&fifo))
+      {
+         break;
+      }
+      else
+      {
+         sched_yield();
+      }
+   }
+   return NULL;
+}
+
+static void TestThreads(void)
+{
+   pthread_t    threads[PRODUCERS];
+   uint32_t     next[PRODUCERS] = { 0 };
+   fifo_entry_t entry;
+   long         read = 0, wrong = 0;
+   uintptr_t    i;
+
+   FIFO_Clear(&fifo);
+   producers_done = 0;
+   for(i = 0; i < PRODUCERS; i++)
+   {
+      pthread_create(&threads[i], NULL, Producer, (void*)i);
+   }
+   for(;;)
+   {
+      if(FIFO_Read(&fifo, &entry))
+      {
+         read++;
+         wrong += !IsNext(&entry, next, PRODUCERS);
+      }
+      else if(__atomic_load_n(&producers_done, __ATOMIC_ACQUIRE) == PRODUCERS &&
+              FIFO_IsEmpty(&fifo))
+      {
+         break;
+      }
+      else
+      {
+         sched_yield();
+      }
+   }
+   for(i = 0; i < PRODUCERS; i++)
+   {
+      pthread_join(threads[i], NULL);
+   }
+
+   CHECK(wrong == 0 && read == (long)PRODUCERS * WRITES);
+   for(i = 0; i < PRODUCERS; i++)
+   {
+      CHECK(next[i] == WRITES);
+   }
+   CHECK(FIFO_IsEmpty(&fifo) && FIFO_Count(&fifo) == 0);
+   CHECK(FIFO_HighWatermark(&fifo) == FIFO_SIZE);
+   printf("threads: %d producers wrote %ld entries, %ld out of order or lost\n",
+          PRODUCERS, read, wrong);
+}
+
+static void TestIsr(void)
+{
+   struct itimerval timer = { { 0, ISR_PERIOD_US }, { 0, ISR_PERIOD_US } };
+   struct itimerval stop = { { 0, 0 }, { 0, 0 } };
+   pthread_t        consumer;
+   sigset_t         mask;
+   long             result[2] = { 0, 0 };
+   uint32_t         before;
+
+   FIFO_Clear(&fifo);
+   written[0] = written[1] = 0;
+   done = false;
+
+   // the signal only interrupts the main thread
+   sigemptyset(&mask);
+   sigaddset(&mask, SIGALRM);
+   pthread_sigmask(SIG_BLOCK, &mask, NULL);
+   pthread_create(&consumer, NULL, Consumer, result);
+   pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+   signal(SIGALRM, Isr);
+   setitimer(ITIMER_REAL, &timer, NULL);
+
+   while(written[0] < ISR_WRITES)
+   {
+      before = written[0];
+      Put(0);
+      if(written[0] == before)
+      {
+         sched_yield();
+      }
+   }
+   setitimer(ITIMER_REAL, &stop, NULL);
+   done = true;
+   pthread_join(consumer, NULL);
+
+   CHECK(result[1] == 0);
+   CHECK(result[0] == (long)(written[0] + written[1]));
+   CHECK(written[1] > 0);
+   CHECK(FIFO_IsEmpty(&fifo) && FIFO_Count(&fifo) == 0);
+   printf("ISR: main wrote %u and the ISR %u entries, %ld out of order or lost\n",
+          written[0], written[1], result[1]);
+}
+
+/**
+  * @brief  Writes with FIFO_Write(), FIFO_Reserve()/FIFO_Commit() and
+  *         FIFO_WriteBulk() in turn.
+  */
+static void *MixedProducer(void *arg)
+{
+   uint8_t      producer = (uintptr_t)arg;
+   fifo_entry_t entries[3], *slot;
+   uint32_t     i = 0, k, n, written;
+
+   while(i < MIXED_WRITES)
+   {
+      switch(i % 3)
+      {
+         case 0:
+            SetEntry(&entries[0], producer, i);
+            written = FIFO_Write(&fifo, &entries[0]);
+            break;
+         case 1:
+            slot = FIFO_Reserve(&fifo);
+            if(slot != NULL)
+            {
+               SetEntry(slot, producer, i);
+               FIFO_Commit(&fifo, slot);
+            }
+            written = (slot != NULL);
+            break;
+         default:
+            n = (MIXED_WRITES - i < 3) ? MIXED_WRITES - i : 3;
+            for(k = 0; k < n; k++)
+            {
+               SetEntry(&entries[k], producer, i + k);
+            }
+            written = FIFO_WriteBulk(&fifo, entries, n);
+            break;
+      }
+      i += written;
+      if(written == 0)
+      {
+         sched_yield();
+      }
+   }
+   __atomic_add_fetch(&producers_done, 1, __ATOMIC_RELEASE);
+   return NULL;
+}
+
+static void TestMixed(void)
+{
+   pthread_t    threads[PRODUCERS];
+   uint32_t     next[PRODUCERS] = { 0 };
+   fifo_entry_t entries[5], *slot;
+   long         read = 0, wrong = 0;
+   unsigned     turn = 0;
+   int          k, n;
+   uintptr_t    i;
+
+   FIFO_Clear(&fifo);
+   producers_done = 0;
+   for(i = 0; i < PRODUCERS; i++)
+   {
+      pthread_create(&threads[i], NULL, MixedProducer, (void*)i);
+   }
+   for(;;)
+   {
+      n = 0;
+      switch(turn++ % 3)
+      {
+         case 0:
+            n = FIFO_Read(&fifo, &entries[0]);
+            break;
+         case 1:
+            slot = FIFO_Peek(&fifo);
+            if(slot != NULL)
+            {
+               entries[0] = *slot;
+               FIFO_Release(&fifo);
+               n = 1;
+            }
+            break;
+         default:
+            n = FIFO_ReadBulk(&fifo, entries, 5);
+            break;
+      }
+      for(k = 0; k < n; k++)
+      {
+         wrong += !IsNext(&entries[k], next, PRODUCERS);
+      }
+      read += n;
+      if(n == 0)
+      {
+         if(__atomic_load_n(&producers_done, __ATOMIC_ACQUIRE) == PRODUCERS &&
+            FIFO_IsEmpty(&fifo))
+         {
+            break;
+         }
+         sched_yield();
+      }
+   }
+   for(i = 0; i < PRODUCERS; i++)
+   {
+      pthread_join(threads[i], NULL);
+   }
+
+   CHECK(wrong == 0 && read == (long)PRODUCERS * MIXED_WRITES);
+   CHECK(FIFO_IsEmpty(&fifo) && FIFO_Count(&fifo) == 0);
+   printf("mixed: %d producers wrote %ld entries, %ld out of order or lost\n",
+          PRODUCERS, read, wrong);
+}
+
+static void Benchmark(void)
+{
+   fifo_entry_t entry, entries[BENCH_BURST], *slot;
+   unsigned     sum = 0;
+   double       start;
+   long         i;
+   int          k;
+
+   memset(&entry, 0, sizeof(entry));
+   memset(entries, 0, sizeof(entries));
+   FIFO_Clear(&fifo);
+   printf("Mops/s, bursts of %d entries written then read:\n", BENCH_BURST);
+
+   start = HOST_Nanoseconds();
+   for(i = 0; i < BENCH_OPERATIONS / BENCH_BURST; i++)
+   {
+      for(k = 0; k < BENCH_BURST; k++)
+      {
+         entry.data.command = k;
+         OLD_FIFO_Write(&old_fifo, &entry);
+      }
+      for(k = 0; k < BENCH_BURST; k++)
+      {
+         OLD_FIFO_Read(&old_fifo, &entry);
+         sum += entry.data.command;
+      }
+   }
+   printf("  previous Write/Read  %6.1f\n", BENCH_OPERATIONS * 1e3 / (HOST_Nanoseconds() - start));
+
+   start = HOST_Nanoseconds();
+   for(i = 0; i < BENCH_OPERATIONS / BENCH_BURST; i++)
+   {
+      for(k = 0; k < BENCH_BURST; k++)
+      {
+         entry.data.command = k;
+         FIFO_Write(&fifo, &entry);
+      }
+      for(k = 0; k < BENCH_BURST; k++)
+      {
+         FIFO_Read(&fifo, &entry);
+         sum += entry.data.command;
+      }
+   }
+   printf("  Write/Read           %6.1f\n", BENCH_OPERATIONS * 1e3 / (HOST_Nanoseconds() - start));
+
+   start = HOST_Nanoseconds();
+   for(i = 0; i < BENCH_OPERATIONS / BENCH_BURST; i++)
+   {
+      for(k = 0; k < BENCH_BURST; k++)
+      {
+         slot = FIFO_Reserve(&fifo);
+         slot->data.command = k;
+         FIFO_Commit(&fifo, slot);
+      }
+      for(k = 0; k < BENCH_BURST; k++)
+      {
+         sum += FIFO_Peek(&fifo)->data.command;
+         FIFO_Release(&fifo);
+      }
+   }
+   printf("  Reserve/Peek         %6.1f\n", BENCH_OPERATIONS * 1e3 / (HOST_Nanoseconds() - start));
+
+   start = HOST_Nanoseconds();
+   for(i = 0; i < BENCH_OPERATIONS / BENCH_BURST; i++)
+   {
+      FIFO_WriteBulk(&fifo, entries, BENCH_BURST);
+      FIFO_ReadBulk(&fifo, entries, BENCH_BURST);
+      sum += entries[i % BENCH_BURST].data.command;
+   }
+   printf("  WriteBulk/ReadBulk   %6.1f\n", BENCH_OPERATIONS * 1e3 / (HOST_Nanoseconds() - start));
+
+   bench_sink = sum;
+}
+
+int main(void)
+{
+   TestApi();
+   TestTemplate();
+   TestThreads();
+   TestIsr();
+   TestMixed();
+   Benchmark();
+
+   return HOST_Result();
+}
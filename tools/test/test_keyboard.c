@@ -0,0 +1,241 @@
+/**
+ * @file       test_keyboard.c
+ * @brief      Host test of the keyboard interface (keyboard.c).
+ *
+ * @details    Walks the report descriptor, checks the packed reports, and
+ *             presses and releases keys while the IN queue of the keyboard
+ *             endpoint is modelled like the one of usbd_customhid.c: 4
+ *             reports, the endpoint is polled at random. Once the queue is
+ *             empty the host must have seen the current state of every
+ *             report ID, and never a state that was not current at some
+ *             time.
+ */
+
+#include "host.h"
+#include "keyboard.h"
+#include "action.h"
+#include "usbd_customhid.h"
+
+/* Private define ------------------------------------------------------------*/
+#define PRESSES            200000
+#define HISTORY            1024     /* states per report ID kept for checks */
+
+/* Private variables ---------------------------------------------------------*/
+USBD_HandleTypeDef USBD_Device;
+
+static uint8_t  queue[USBD_KEYBOARD_INREPORT_QUEUE_SIZE][USBD_KEYBOARD_INREPORT_BUF_SIZE];
+static uint8_t  queue_head;
+static uint8_t  queue_count;
+static long     busy;
+static uint16_t host_state[3];              /* last report per ID */
+static long     host_reports;
+static uint16_t history[3][HISTORY];        /* states since the last report */
+static int      history_count[3];
+
+/* Stubs of the firmware ------------------------------------------------------*/
+uint8_t USBD_KEYBOARD_SendReport(USBD_HandleTypeDef *pdev, uint8_t *report, uint16_t len)
+{
+   (void)pdev;
+   if(len == 0 || len > USBD_KEYBOARD_INREPORT_BUF_SIZE)
+   {
+      abort();
+   }
+   if(queue_count >= USBD_KEYBOARD_INREPORT_QUEUE_SIZE)
+   {
+      busy++;
+      return USBD_BUSY;
+   }
+   memcpy(queue[(queue_head + queue_count) % USBD_KEYBOARD_INREPORT_QUEUE_SIZE], report, len);
+   queue_count++;
+   return USBD_OK;
+}
+
+#include "../../src/keyboard.c"
+
+/* Test ----------------------------------------------------------------------*/
+/**
+  * @brief  Usage of a received report.
+  */
+static uint16_t Usage(const uint8_t *report)
+{
+   return report[0] == KEYBOARD_REP_ID_KEYS ? KEYBOARD_USAGE(report[1], report[3]) :
+                                              (uint16_t)(report[1] | report[2] << 8);
+}
+
+/**
+  * @brief  Records a state change of main for the checks of Poll().
+  */
+static void Changed(void)
+{
+   int id;
+
+   for(id = 1; id <= KEYBOARD_REPORTS; id++)
+   {
+      if(history_count[id] == 0 || history[id][history_count[id]-1] != keyboard_usages[id-1])
+      {
+         CHECK(history_count[id] < HISTORY);
+         history[id][history_count[id]++] = keyboard_usages[id-1];
+      }
+   }
+}
+
+/**
+  * @brief  The host polls the endpoint and gets the report at the head,
+  *         DataIn follows.
+  */
+static void Poll(void)
+{
+   uint8_t *report;
+   int      id, k;
+
+   if(queue_count == 0)
+   {
+      return;
+   }
+   report = queue[queue_head];
+   id = report[0];
+   CHECK(id == KEYBOARD_REP_ID_KEYS || id == KEYBOARD_REP_ID_CONSUMER);
+
+   // a state main had set since the previous report of the ID, older ones
+   // are gone for good
+   for(k = 0; k < history_count[id] && history[id][k] != Usage(report); k++);
+   CHECK(k < history_count[id]);
+   if(k < history_count[id])
+   {
+      memmove(history[id], &history[id][k], (history_count[id] - k) * sizeof(uint16_t));
+      history_count[id] -= k;
+   }
+   host_state[id] = Usage(report);
+   host_reports++;
+
+   queue_head = (queue_head + 1) % USBD_KEYBOARD_INREPORT_QUEUE_SIZE;
+   queue_count--;
+   USBD_KEYBOARD_InSentCallback();
+}
+
+/**
+  * @brief  Walks the items of the report descriptor, adds up the bits of
+  *         the input items per report ID.
+  */
+static bool ParseDescriptor(int bits[3])
+{
+   int size = 0, count = 0, id = 0, depth = 0, i = 0, k, length;
+   unsigned value;
+
+   while(i < KEYBOARD_REPORT_DESC_SIZE)
+   {
+      length = KEYBOARD_ReportDesc[i] & 3;
+      length = (length == 3) ? 4 : length;
+      if(i + 1 + length > KEYBOARD_REPORT_DESC_SIZE)
+      {
+         return false;
+      }
+      for(value = 0, k = 0; k < length; k++)
+      {
+         value |= KEYBOARD_ReportDesc[i+1+k] << 8*k;
+      }
+      switch(KEYBOARD_ReportDesc[i] & 0xFC)
+      {
+      case 0x74: size = value;               break;  // REPORT_SIZE
+      case 0x94: count = value;              break;  // REPORT_COUNT
+      case 0x84: id = value;                 break;  // REPORT_ID
+      case 0x80: bits[id] += size * count;   break;  // INPUT
+      case 0xA0: depth++;                    break;  // COLLECTION
+      case 0xC0: if(--depth < 0) return false; break; // END_COLLECTION
+      }
+      i += 1 + length;
+   }
+   return depth == 0 && id < 3;
+}
+
+int main(void)
+{
+   uint8_t  report[KEYBOARD_REPORT_SIZE_MAX];
+   int      bits[3] = { 0 };
+   uint16_t usage;
+   uint8_t  actions;
+   int      n, id;
+
+   // descriptor
+   CHECK(ParseDescriptor(bits));
+   CHECK(bits[0] == 0);
+   CHECK(bits[KEYBOARD_REP_ID_KEYS] == 8*KEYBOARD_KEYS_SIZE);
+   CHECK(bits[KEYBOARD_REP_ID_CONSUMER] == 8*KEYBOARD_CONSUMER_SIZE);
+
+   // packing
+   CHECK(KEYBOARD_PackReport(KEYBOARD_REP_ID_KEYS, KEYBOARD_USAGE(0x02, 0x28), report) == 9);
+   CHECK(memcmp(report, "\x01\x02\x00\x28\x00\x00\x00\x00\x00", 9) == 0);
+   CHECK(KEYBOARD_PackReport(KEYBOARD_REP_ID_CONSUMER, 0xE9, report) == 3);
+   CHECK(memcmp(report, "\x02\xE9\x00", 3) == 0);
+   CHECK(KEYBOARD_PackReport(KEYBOARD_REP_ID_CONSUMER, 0x1234, report) == 3);
+   CHECK(memcmp(report, "\x02\x00\x00", 3) == 0);
+   CHECK(KEYBOARD_PackReport(0, 1, report) == 0);
+   CHECK(KEYBOARD_PackReport(3, 1, report) == 0);
+   CHECK(KEYBOARD_GetReport(0, report) == 0);
+   CHECK(KEYBOARD_GetReport(3, report) == 0);
+
+   // press and release, a press releases the other report first
+   Changed();
+   KEYBOARD_Press(ACTION_FORWARD, 5);
+   CHECK(queue_count == 0);
+   KEYBOARD_Press(ACTION_KEY, KEYBOARD_USAGE(0x01, 0x04));
+   CHECK(queue_count == 1);
+   CHECK(KEYBOARD_GetReport(KEYBOARD_REP_ID_KEYS, report) == 9 && report[3] == 0x04);
+   KEYBOARD_Press(ACTION_CONSUMER, 0xCD);
+   CHECK(queue_count == 3);
+   CHECK(queue[1][0] == KEYBOARD_REP_ID_KEYS && Usage(queue[1]) == 0);
+   CHECK(queue[2][0] == KEYBOARD_REP_ID_CONSUMER && Usage(queue[2]) == 0xCD);
+   KEYBOARD_Release();
+   CHECK(queue_count == 4);
+   KEYBOARD_Release();
+   CHECK(queue_count == 4);
+   memset(history_count, 0, sizeof(history_count));
+   while(queue_count)
+   {
+      queue_head = (queue_head + 1) % USBD_KEYBOARD_INREPORT_QUEUE_SIZE;
+      queue_count--;
+   }
+
+   // the queue fills up while the host polls slower than keys change
+   Changed();
+   for(n = 0; n < PRESSES; n++)
+   {
+      usage = HOST_Random() % 0x300 + 1;
+      actions = (HOST_Random() % 2) ? ACTION_KEY : ACTION_CONSUMER;
+
+      // the release of KEYBOARD_Press() is a state of its own
+      KEYBOARD_Release();
+      Changed();
+      if(HOST_Random() % 2)
+      {
+         KEYBOARD_Press(actions, usage);
+         Changed();
+      }
+      while(HOST_Random() % 3 == 0)
+      {
+         Poll();
+      }
+
+      // every ID ends in the current state once the host has read all
+      if(HOST_Random() % 64 == 0)
+      {
+         while(queue_count)
+         {
+            Poll();
+         }
+         for(id = 1; id <= KEYBOARD_REPORTS; id++)
+         {
+            CHECK(host_state[id] == keyboard_usages[id-1]);
+         }
+      }
+   }
+   while(queue_count)
+   {
+      Poll();
+   }
+   CHECK(keyboard_unsent == 0);
+   CHECK(busy > 0);
+   printf("%d presses: %ld reports, queue full %ld times\n", PRESSES, host_reports, busy);
+
+   return HOST_Result();
+}
@@ -0,0 +1,432 @@
+/**
+ * @file       test_learn.c
+ * @brief      Host test and match benchmark of the learned remotes (learn.c).
+ *
+ * @details    Frames of four synthetic remotes, pulse distance (NEC, 32 bit,
+ *             and Kaseikyo, 48 bit, longer than a template), pulse width
+ *             (SIRCS) and biphase (RC5), are fed run by run into
+ *             LEARN_Put() like the IR ISR does, with the jitter of a
+ *             receiver. 12 keys of each remote are learned through
+ *             LEARN_Control() and LEARN_Process(), filling all LEARN_SLOTS.
+ *             Checks:
+ *             - every frame of a learned key matches its slot,
+ *             - frames of other keys of the same remotes and of a remote not
+ *               learned (Samsung) match no slot,
+ *             - the banded distance with early exit picks the same slot as
+ *               the full distance over all runs.
+ *
+ *             The benchmark prints the time of LEARN_Match() for frames of
+ *             learned keys and for unknown frames, against the full distance
+ *             and against a plain sum of differences without bands.
+ */
+
+#include "host.h"
+#include "learn.h"
+#include "store.h"
+
+/* Private define ------------------------------------------------------------*/
+#define US(us)             ((int)((us) * (F_INTERRUPTS / 1.0e6) + 0.5))  /* ticks */
+#define KEYS_LEARNED       (LEARN_SLOTS / 4)
+#define KEYS               (2 * KEYS_LEARNED)  /* per remote, the rest unknown */
+#define FRAMES_PER_KEY     40
+#define FRAMES_MAX         (5 * KEYS * FRAMES_PER_KEY)
+#define RUNS_MAX           254
+#define KEY_CODE(key)      ((key) * 3 + 1)
+#define BENCH_ROUNDS       200
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct REMOTE
+{
+   const char  *name;
+   uint16_t    header_pulse;           /* us, 0: none */
+   uint16_t    header_pause;
+   uint16_t    pulse[2];               /* of a 0 and a 1 */
+   uint16_t    pause[2];
+   uint16_t    stop;                   /* pulse behind the bits, 0: none */
+   uint16_t    biphase;                /* half bit, 0: not biphase */
+   uint8_t     bits;                   /* LSB first, biphase MSB first */
+   uint64_t    address;                /* bits of the code besides the key */
+   uint8_t     shift;                  /* of the key in the code */
+   bool        inverted;               /* 8 bit key followed by its inverse */
+} remote_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const remote_t remotes[] =
+{
+   { "NEC",      9000, 4500, { 560, 560 },  { 560, 1690 }, 560, 0,   32, 0xFB04,        16, true  },
+   { "SIRCS",    2400, 600,  { 600, 1200 }, { 600, 600 },  0,   0,   12, 0x1 << 7,      0,  false },
+   { "RC5",      0,    0,    { 0, 0 },      { 0, 0 },      0,   889, 14, 0x3<<12 | 0x5<<7, 0, false },
+   { "Kaseikyo", 3456, 1728, { 432, 432 },  { 432, 1296 }, 432, 0,   48, 0x2002,        24, false },
+   { "Samsung",  4500, 4500, { 560, 560 },  { 560, 1690 }, 560, 0,   32, 0x0707,        16, true  },
+};
+#define REMOTES_LEARNED    4
+
+static volatile unsigned bench_sink;
+
+/* Stubs of the firmware ------------------------------------------------------*/
+void SetEvent(uint32_t event)
+{
+   (void)event;
+}
+
+uint32_t HAL_GetTick(void)
+{
+   return 0;
+}
+
+HAL_StatusTypeDef STORE_Read(uint16_t address, void *data, uint8_t length)
+{
+   (void)address;
+   (void)data;
+   (void)length;
+   return HAL_ERROR;
+}
+
+HAL_StatusTypeDef STORE_Write(uint16_t address, const void *data, uint8_t length)
+{
+   (void)address;
+   (void)data;
+   (void)length;
+   return HAL_OK;
+}
+
+#include "../../src/learn.c"
+
+/* Test ----------------------------------------------------------------------*/
+typedef struct FRAME  /* learn_frame_t is private to learn.c */
+{
+   learn_frame_t  frame;
+   int8_t         remote;
+   int8_t         key;                 /* learned if below KEYS_LEARNED */
+} frame_t;
+
+static frame_t  frames[FRAMES_MAX];
+static int      frame_count;
+static int      frames_learned;        /* of learned keys, first in frames[] */
+
+/**
+  * @brief  Lengths in us of the runs of a frame, a pulse first.
+  * @return Number of runs.
+  */
+static int Encode(const remote_t *remote, uint8_t key, uint16_t *runs)
+{
+   uint64_t code = remote->address | (uint64_t)key << remote->shift;
+   uint8_t  halves[2 * 64];
+   int      count = 0, i, b, n;
+
+   if(remote->inverted)
+   {
+      code |= (uint64_t)(uint8_t)~key << (remote->shift + 8);
+   }
+
+   if(remote->biphase)
+   {
+      // a 1 is a pause and a pulse, runs of equal halves are merged
+      for(i = 0; i < remote->bits; i++)
+      {
+         b = (code >> (remote->bits - 1 - i)) & 1;
+         halves[2*i] = !b;
+         halves[2*i+1] = b;
+      }
+      for(i = (halves[0] == 0) ? 1 : 0; i < 2 * remote->bits; i += n)
+      {
+         for(n = 1; i + n < 2 * remote->bits && halves[i+n] == halves[i]; n++);
+         runs[count++] = n * remote->biphase;
+      }
+      return (count % 2) ? count : count - 1;   // ends with a pulse
+   }
+
+   if(remote->header_pulse)
+   {
+      runs[count++] = remote->header_pulse;
+      runs[count++] = remote->header_pause;
+   }
+   for(i = 0; i < remote->bits; i++)
+   {
+      b = (code >> i) & 1;
+      runs[count++] = remote->pulse[b];
+      runs[count++] = remote->pause[b];
+   }
+   if(remote->stop)
+   {
+      runs[count++] = remote->stop;
+   }
+   else
+   {
+      count--;
+   }
+   return count;
+}
+
+/**
+  * @brief  Feeds a frame into the recorder like the IR ISR. The receiver
+  *         makes pulses a tick longer and pauses a tick shorter, the
+  *         sampling adds a tick of jitter.
+  */
+static void Record(const remote_t *remote, uint8_t key)
+{
+   uint16_t runs[RUNS_MAX];
+   int      count = Encode(remote, key, runs);
+   int      i, ticks;
+
+   for(i = 0; i < count; i++)
+   {
+      ticks = US(runs[i]) + ((i & 1) ? -1 : 1) + (int)(HOST_Random() % 3) - 1;
+      LEARN_Put(i & 1, ticks > 1 ? ticks : 1);
+   }
+   LEARN_Put(1, LEARN_GAP_TICKS);
+}
+
+/**
+  * @brief  Records a frame and keeps a copy for the benchmark.
+  */
+static void RecordFrame(int remote, int key)
+{
+   Record(&remotes[remote], KEY_CODE(key));
+   CHECK(learn.full[learn.read]);
+   if(frame_count < FRAMES_MAX)
+   {
+      frames[frame_count].frame = learn_frames[learn.read];
+      frames[frame_count].remote = remote;
+      frames[frame_count].key = key;
+      frame_count++;
+   }
+}
+
+/**
+  * @brief  Full distance over all runs with the same bands, no early exit.
+  */
+static uint16_t FullDistance(const learn_template_t *tmpl, const learn_frame_t *frame)
+{
+   const uint8_t *level;
+   uint16_t sum = 0;
+   bool     out = false;
+   int      runs, i, k, len, ticks, diff;
+
+   if(tmpl->runs != frame->runs)
+   {
+      return LEARN_NO_MATCH;
+   }
+   runs = (frame->runs < LEARN_RUNS_MAX) ? frame->runs : LEARN_RUNS_MAX;
+   for(i = 0; i < runs; i++)
+   {
+      level = (i & 1) ? tmpl->pause : tmpl->pulse;
+      k = (tmpl->symbols[i/4] >> (2*(i%4))) & 3;
+      len = level[k];
+      ticks = frame->ticks[i];
+      diff = abs(ticks - len);
+      out |= diff > LEARN_TOLERANCE(len);
+      out |= ticks > len && k < LEARN_LEVELS-1 && level[k+1] > len && diff > level[k+1] - ticks;
+      out |= ticks < len && k > 0 && ticks - level[k-1] < diff;
+      sum += diff;
+   }
+   return out ? LEARN_NO_MATCH : sum;
+}
+
+static uint8_t FullMatch(const learn_frame_t *frame)
+{
+   uint16_t best = LEARN_NO_MATCH, distance;
+   uint8_t  match = LEARN_SLOTS;
+   int      slot;
+
+   for(slot = 0; slot < LEARN_SLOTS; slot++)
+   {
+      distance = FullDistance(&learn_templates[slot], frame);
+      if(distance < best)
+      {
+         best = distance;
+         match = slot;
+      }
+   }
+   return match;
+}
+
+/**
+  * @brief  Sum of the differences of all runs, no bands, closest template.
+  */
+static uint8_t PlainMatch(const learn_frame_t *frame)
+{
+   const learn_template_t *tmpl;
+   uint16_t best = LEARN_NO_MATCH, sum;
+   uint8_t  match = LEARN_SLOTS;
+   int      slot, runs, i, k;
+
+   for(slot = 0; slot < LEARN_SLOTS; slot++)
+   {
+      tmpl = &learn_templates[slot];
+      if(tmpl->runs != frame->runs)
+      {
+         continue;
+      }
+      runs = (frame->runs < LEARN_RUNS_MAX) ? frame->runs : LEARN_RUNS_MAX;
+      for(sum = 0, i = 0; i < runs; i++)
+      {
+         k = (tmpl->symbols[i/4] >> (2*(i%4))) & 3;
+         sum += abs(frame->ticks[i] - ((i & 1) ? tmpl->pause[k] : tmpl->pulse[k]));
+      }
+      if(sum < best)
+      {
+         best = sum;
+         match = slot;
+      }
+   }
+   return match;
+}
+
+/**
+  * @brief  Runs LEARN_Match() compares, walked like LEARN_Distance(), and
+  *         runs the full and the plain distance compare.
+  * @return Slot found by the walk.
+  */
+static uint8_t Compared(const learn_frame_t *frame, long *banded, long *full)
+{
+   const learn_template_t *tmpl;
+   const uint8_t *level;
+   uint16_t best = LEARN_NO_MATCH, sum;
+   uint8_t  match = LEARN_SLOTS;
+   int      slot, runs, i, k, len, ticks, diff;
+   bool     out;
+
+   for(slot = 0; slot < LEARN_SLOTS; slot++)
+   {
+      tmpl = &learn_templates[slot];
+      if(tmpl->runs != frame->runs)
+      {
+         continue;
+      }
+      runs = (frame->runs < LEARN_RUNS_MAX) ? frame->runs : LEARN_RUNS_MAX;
+      *full += runs;
+      for(sum = 0, out = false, i = runs; !out && i-- > 0; )
+      {
+         level = (i & 1) ? tmpl->pause : tmpl->pulse;
+         k = (tmpl->symbols[i/4] >> (2*(i%4))) & 3;
+         len = level[k];
+         ticks = frame->ticks[i];
+         diff = abs(ticks - len);
+         sum += diff;
+         (*banded)++;
+         out = diff > LEARN_TOLERANCE(len) || sum >= best ||
+               (ticks > len && k < LEARN_LEVELS-1 && level[k+1] > len && diff > level[k+1] - ticks) ||
+               (ticks < len && k > 0 && ticks - level[k-1] < diff);
+      }
+      if(!out)
+      {
+         best = sum;
+         match = slot;
+      }
+   }
+   return match;
+}
+
+/**
+  * @brief  ns per frame of a matcher over a range of frames[].
+  */
+static double Time(uint8_t (*match)(const learn_frame_t*), int first, int last)
+{
+   unsigned sum = 0;
+   double   start = HOST_Nanoseconds();
+   int      round, i;
+
+   for(round = 0; round < BENCH_ROUNDS; round++)
+   {
+      for(i = first; i < last; i++)
+      {
+         sum += match(&frames[i].frame);
+      }
+   }
+   bench_sink = sum;
+   return (HOST_Nanoseconds() - start) / ((double)BENCH_ROUNDS * (last - first));
+}
+
+int main(void)
+{
+   IRMP_DATA irmp_data;
+   int       remote, key, slot, n, i;
+   int       matched = 0, unknown = 0;
+   uint8_t   control[LEARN_CONTROL_SIZE];
+   double    own[3], foreign[3];
+   long      banded[2] = { 0 }, full[2] = { 0 };
+
+   LEARN_Init();
+   CHECK(!learn.active);
+
+   // learn the first keys of the remotes, one slot each
+   for(remote = 0; remote < REMOTES_LEARNED; remote++)
+   {
+      for(key = 0; key < KEYS_LEARNED; key++)
+      {
+         slot = remote * KEYS_LEARNED + key;
+         LEARN_Control(LEARN_CMD_LEARN, LEARN_ALL_SLOTS);
+         LEARN_Process(&irmp_data);
+         CHECK(learn.state == LEARN_STATE_WAITING && learn.slot == slot);
+         Record(&remotes[remote], KEY_CODE(key));
+         CHECK(!LEARN_Process(&irmp_data));
+         LEARN_GetControl(control);
+         CHECK(learn.state == LEARN_STATE_DONE && learn.used == slot + 1);
+      }
+   }
+   CHECK(learn.used == LEARN_SLOTS);
+   LEARN_Control(LEARN_CMD_LEARN, LEARN_ALL_SLOTS);
+   LEARN_Process(&irmp_data);
+   CHECK(learn.state == LEARN_STATE_FAILED);
+
+   // frames of the learned keys, then of unknown keys
+   for(n = 0; n < FRAMES_PER_KEY; n++)
+   {
+      for(remote = 0; remote < REMOTES_LEARNED; remote++)
+      {
+         for(key = 0; key < KEYS_LEARNED; key++)
+         {
+            RecordFrame(remote, key);
+            CHECK(LEARN_Process(&irmp_data));
+            CHECK(irmp_data.protocol == LEARN_PROTOCOL && irmp_data.address == 0);
+            CHECK(irmp_data.command == remote * KEYS_LEARNED + key);
+            matched += (irmp_data.command == remote * KEYS_LEARNED + key);
+         }
+      }
+   }
+   frames_learned = frame_count;
+   for(n = 0; n < FRAMES_PER_KEY / 4; n++)
+   {
+      for(remote = 0; remote < (int)(sizeof(remotes) / sizeof(remotes[0])); remote++)
+      {
+         for(key = (remote < REMOTES_LEARNED) ? KEYS_LEARNED : 0; key < KEYS; key++)
+         {
+            RecordFrame(remote, key);
+            CHECK(!LEARN_Process(&irmp_data));
+            unknown++;
+         }
+      }
+   }
+
+   for(i = 0; i < frame_count; i++)
+   {
+      CHECK(LEARN_Match(&frames[i].frame) == FullMatch(&frames[i].frame));
+      CHECK(LEARN_Match(&frames[i].frame) ==
+            Compared(&frames[i].frame, &banded[i >= frames_learned], &full[i >= frames_learned]));
+   }
+   printf("%d templates of %d remotes, %d frames matched their key, %d unknown "
+          "frames\n", learn.used, REMOTES_LEARNED, matched, unknown);
+
+   // benchmark, the host vectorizes the plain sum, the Cortex-M3 can't:
+   // the runs compared tell more about the device than the times
+   own[0] = Time(LEARN_Match, 0, frames_learned);
+   own[1] = Time(FullMatch, 0, frames_learned);
+   own[2] = Time(PlainMatch, 0, frames_learned);
+   foreign[0] = Time(LEARN_Match, frames_learned, frame_count);
+   foreign[1] = Time(FullMatch, frames_learned, frame_count);
+   foreign[2] = Time(PlainMatch, frames_learned, frame_count);
+   printf("runs compared per frame, %d templates:  banded  full/plain\n", LEARN_SLOTS);
+   printf("  learned keys                           %6.1f  %6.1f\n",
+          (double)banded[0] / frames_learned, (double)full[0] / frames_learned);
+   printf("  unknown frames                         %6.1f  %6.1f\n",
+          (double)banded[1] / (frame_count - frames_learned),
+          (double)full[1] / (frame_count - frames_learned));
+   printf("ns per frame on the host:  banded    full   plain\n");
+   printf("  learned keys             %6.1f  %6.1f  %6.1f\n", own[0], own[1], own[2]);
+   printf("  unknown frames           %6.1f  %6.1f  %6.1f\n", foreign[0], foreign[1], foreign[2]);
+   printf("  frames per s, banded     %.2f M\n",
+          1e3 / ((own[0] * frames_learned + foreign[0] * (frame_count - frames_learned)) / frame_count));
+
+   return HOST_Result();
+}
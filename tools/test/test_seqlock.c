@@ -0,0 +1,172 @@
+/**
+ * @file       test_seqlock.c
+ * @brief      Host stress test of the configuration snapshots
+ *             (PublishHidirtConfig() and GetHidirtConfig() of application.c).
+ *
+ * @details    The main thread is the single writer like main: every
+ *             publication fills all bytes of hidirt_data with the low byte
+ *             of a counter and clock_correction with the counter. Readers
+ *             call GetHidirtConfig()
+ *             - in a timer signal that interrupts the writer like the USB
+ *               and RTC interrupts interrupt main,
+ *             - in READERS threads at the same time as the writer.
+ *             Every snapshot read must be one publication: no byte may
+ *             differ from the counter, and a reader may never see an older
+ *             publication after a newer one.
+ *
+ *             application.c needs the HAL, run.sh only links the functions
+ *             the test calls.
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/time.h>
+#include "host.h"
+
+/* Private define ------------------------------------------------------------*/
+#define PUBLICATIONS       500000
+#define READERS            2
+#define ISR_PERIOD_US      10
+
+/* ARM instructions of application.c, not executed by the test */
+#define __LDREXW(address)           (*(address))
+#define __STREXW(value, address)    (*(address) = (value), 0)
+#define __disable_irq()
+#define __enable_irq()
+#define __DSB()
+#define __WFI()
+
+/* Private types -------------------------------------------------------------*/
+typedef struct READER
+{
+   long     reads;
+   long     torn;
+   long     older;
+} reader_t;
+
+/* Private variables ---------------------------------------------------------*/
+static volatile bool done;
+static reader_t      isr;
+
+#include "../../src/application.c"
+
+/* Test ----------------------------------------------------------------------*/
+/**
+  * @brief  Publishes the configuration number n.
+  */
+static void Publish(int32_t n)
+{
+   memset(&hidirt_data, (uint8_t)n, sizeof(hidirt_data));
+   hidirt_data.clock_correction = n;
+   PublishHidirtConfig();
+}
+
+/**
+  * @brief  Reads a snapshot and checks it against the ones read before.
+  */
+static void Read(reader_t *reader, int32_t *last)
+{
+   hidirt_data_t config, expected;
+
+   GetHidirtConfig(&config);
+   memset(&expected, (uint8_t)config.clock_correction, sizeof(expected));
+   expected.clock_correction = config.clock_correction;
+   reader->reads++;
+   reader->torn += memcmp(&config, &expected, sizeof(config)) != 0;
+   reader->older += config.clock_correction < *last;
+   *last = config.clock_correction;
+}
+
+static void Isr(int signal)
+{
+   static int32_t last;
+
+   (void)signal;
+   Read(&isr, &last);
+}
+
+static void *Reader(void *arg)
+{
+   int32_t last = 0;
+
+   while(!done)
+   {
+      Read(arg, &last);
+   }
+   return NULL;
+}
+
+static void TestSnapshots(void)
+{
+   struct itimerval timer = { { 0, ISR_PERIOD_US }, { 0, ISR_PERIOD_US } };
+   struct itimerval stop = { { 0, 0 }, { 0, 0 } };
+   pthread_t        threads[READERS];
+   reader_t         readers[READERS];
+   sigset_t         mask;
+   int32_t          n;
+   int              i;
+
+   Publish(0);
+   memset(readers, 0, sizeof(readers));
+
+   // the signal only interrupts the writer
+   sigemptyset(&mask);
+   sigaddset(&mask, SIGALRM);
+   pthread_sigmask(SIG_BLOCK, &mask, NULL);
+   for(i = 0; i < READERS; i++)
+   {
+      pthread_create(&threads[i], NULL, Reader, &readers[i]);
+   }
+   pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+   signal(SIGALRM, Isr);
+   setitimer(ITIMER_REAL, &timer, NULL);
+
+   for(n = 1; n <= PUBLICATIONS; n++)
+   {
+      Publish(n);
+      if(n % 1024 == 0)
+      {
+         sched_yield();
+      }
+   }
+   setitimer(ITIMER_REAL, &stop, NULL);
+   done = true;
+   for(i = 0; i < READERS; i++)
+   {
+      pthread_join(threads[i], NULL);
+   }
+
+   CHECK(isr.reads > 0);
+   CHECK(isr.torn == 0 && isr.older == 0);
+   printf("ISR: %ld snapshots, %ld torn, %ld older than the one before\n",
+          isr.reads, isr.torn, isr.older);
+   for(i = 0; i < READERS; i++)
+   {
+      CHECK(readers[i].reads > 0);
+      CHECK(readers[i].torn == 0 && readers[i].older == 0);
+      printf("thread %d: %ld snapshots, %ld torn, %ld older than the one before\n",
+             i + 1, readers[i].reads, readers[i].torn, readers[i].older);
+   }
+}
+
+static void TestLatest(void)
+{
+   hidirt_data_t config;
+
+   // a reader after the writer gets the last publication
+   hidirt_data.min_ir_repeats = 3;
+   hidirt_data.control_pc_enable = true;
+   PublishHidirtConfig();
+   GetHidirtConfig(&config);
+   CHECK(memcmp(&config, &hidirt_data, sizeof(config)) == 0);
+}
+
+int main(void)
+{
+   TestSnapshots();
+   TestLatest();
+
+   return HOST_Result();
+}
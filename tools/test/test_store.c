@@ -0,0 +1,302 @@
+/**
+ * @file       test_store.c
+ * @brief      Host test of the record store of the STM32F1xx (store.c).
+ *
+ * @details    The dedicated flash pages are mapped at their real address,
+ *             the flash stubs only clear bits and refuse to program a
+ *             halfword that is neither erased nor set to 0, like the flash
+ *             of the STM32F1xx. The test checks the records against a model
+ *             while they are written over and over, counts copies and page
+ *             erases, and cuts the power at every point of a write, a copy
+ *             included, leaving a half programmed halfword or page behind.
+ *             Every record must hold its old or its new value after
+ *             STORE_Init(). Linux only.
+ */
+
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include "host.h"
+#include "store.h"
+#include "learn.h"
+#include "action.h"
+
+/* Private define ------------------------------------------------------------*/
+#define FLASH_BASE_HOST    0x0801E000u
+#define FLASH_SIZE_HOST    0x2000u
+#define RECORDS            (LEARN_SLOTS + ACTION_ENTRIES)
+/* templates first, then action entries */
+#define RECORD_ADDRESS(i)  ((i) < LEARN_SLOTS ? \
+           (unsigned)(ADDRESS_learn_templates + (i) * (LEARN_TEMPLATE_SIZE / EEPROM_ADDRESS_SIZE)) : \
+           (unsigned)(ADDRESS_action_table + ((i) - LEARN_SLOTS) * (ACTION_ENTRY_SIZE / EEPROM_ADDRESS_SIZE)))
+#define RECORD_LENGTH(i)   ((i) < LEARN_SLOTS ? LEARN_TEMPLATE_SIZE : ACTION_ENTRY_SIZE)
+#define WRITES             200000
+#define POWER_CUTS         30000
+
+/* Private variables ---------------------------------------------------------*/
+static bool     flash_locked = true;
+static long     flash_ops;
+static long     flash_cut_at = -1;      /* operation that loses power */
+static int      flash_cut;              /* 1: power lost, 2: and damage done */
+static long     flash_programs;
+static long     flash_erases[FLASH_SIZE_HOST / 0x400];
+static uint8_t  model[RECORDS][LEARN_TEMPLATE_SIZE];
+static bool     model_used[RECORDS];
+
+/* Stubs of the firmware ------------------------------------------------------*/
+void SetEvent(uint32_t event)
+{
+   (void)event;
+}
+
+HAL_StatusTypeDef EEPROM_ReadBytes(uint32_t address, void *data, uint8_t length)
+{
+   (void)address; (void)data; (void)length;
+   abort();
+}
+
+HAL_StatusTypeDef EEPROM_WriteBytes(uint32_t address, void *data, uint8_t length)
+{
+   (void)address; (void)data; (void)length;
+   abort();
+}
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+   flash_locked = false;
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+   flash_locked = true;
+   return HAL_OK;
+}
+
+static bool FlashPowered(void)
+{
+   if(flash_cut || (flash_cut_at >= 0 && flash_ops >= flash_cut_at))
+   {
+      flash_cut = flash_cut ? flash_cut : 1;
+      return false;
+   }
+   flash_ops++;
+   return true;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t type, uint32_t address, uint64_t data)
+{
+   uint16_t *halfword = (uint16_t*)(uintptr_t)address;
+
+   if( flash_locked || type != FLASH_TYPEPROGRAM_HALFWORD || (address & 1) ||
+       address < FLASH_BASE_HOST || address + 2 > FLASH_BASE_HOST + FLASH_SIZE_HOST )
+   {
+      abort();
+   }
+   if(!FlashPowered())
+   {
+      if(flash_cut == 1)
+      {
+         // some bits made it
+         *halfword &= (uint16_t)data | (uint16_t)HOST_Random();
+         flash_cut = 2;
+      }
+      return HAL_ERROR;
+   }
+   if(*halfword != 0xFFFF && data != 0)
+   {
+      return HAL_ERROR;
+   }
+   *halfword &= (uint16_t)data;
+   flash_programs++;
+   return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *erase, uint32_t *page_error)
+{
+   if( flash_locked || erase->NbPages != 1 || erase->PageAddress < FLASH_BASE_HOST ||
+       erase->PageAddress >= FLASH_BASE_HOST + FLASH_SIZE_HOST ||
+       (erase->PageAddress - FLASH_BASE_HOST) % 0x400 != 0 )
+   {
+      abort();
+   }
+   if(!FlashPowered())
+   {
+      if(flash_cut == 1)
+      {
+         // erase stopped half way
+         memset((void*)(uintptr_t)erase->PageAddress, 0xFF, HOST_Random() % 0x400);
+         flash_cut = 2;
+      }
+      return HAL_ERROR;
+   }
+   memset((void*)(uintptr_t)erase->PageAddress, 0xFF, 0x400);
+   flash_erases[(erase->PageAddress - FLASH_BASE_HOST) / 0x400]++;
+   *page_error = 0xFFFFFFFF;   // no page failed
+   return HAL_OK;
+}
+
+#include "../../src/store.c"
+
+/* Test ----------------------------------------------------------------------*/
+/**
+  * @brief  Forgets the RAM state like a reset does and reads the flash again.
+  */
+static void Reset(void)
+{
+   memset(&store, 0x55, sizeof(store));
+   STORE_Init();
+}
+
+/**
+  * @brief  Compares every record with the model.
+  * @param  pending: record that may hold new_value, -1 if none
+  */
+static void Verify(int pending, const uint8_t *new_value)
+{
+   uint8_t           data[LEARN_TEMPLATE_SIZE];
+   HAL_StatusTypeDef status;
+   int               i;
+   unsigned          k;
+
+   for(i = 0; i < RECORDS; i++)
+   {
+      memset(data, 0xA5, sizeof(data));
+      status = STORE_Read(RECORD_ADDRESS(i), data, RECORD_LENGTH(i));
+
+      if(i == pending && status == HAL_OK && memcmp(data, new_value, RECORD_LENGTH(i)) == 0)
+      {
+         memcpy(model[i], new_value, RECORD_LENGTH(i));
+         model_used[i] = true;
+      }
+      else if(model_used[i])
+      {
+         CHECK(status == HAL_OK && memcmp(data, model[i], RECORD_LENGTH(i)) == 0);
+      }
+      else
+      {
+         // never written: unchanged
+         CHECK(status == HAL_ERROR);
+         for(k = 0; k < RECORD_LENGTH(i); k++)
+         {
+            CHECK(data[k] == 0xA5);
+         }
+      }
+   }
+}
+
+static void RandomRecord(int i, uint8_t *data)
+{
+   unsigned k;
+
+   for(k = 0; k < RECORD_LENGTH(i); k++)
+   {
+      data[k] = HOST_Random();
+   }
+   if(HOST_Random() % 4 == 0)
+   {
+      memset(data, i < LEARN_SLOTS ? 0xFF : 0, 8);  // like a deleted entry
+   }
+}
+
+static void Write(int i, const uint8_t *data)
+{
+   CHECK(STORE_Write(RECORD_ADDRESS(i), data, RECORD_LENGTH(i)) == HAL_OK);
+   memcpy(model[i], data, RECORD_LENGTH(i));
+   model_used[i] = true;
+}
+
+int main(void)
+{
+   uint8_t *flash = mmap((void*)(uintptr_t)FLASH_BASE_HOST, FLASH_SIZE_HOST,
+                         PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+   uint8_t  data[LEARN_TEMPLATE_SIZE];
+   long     programs, copies = 0, cuts = 0, erases = 0;
+   uint8_t  bank;
+   int      n, i;
+
+   if(flash != (void*)(uintptr_t)FLASH_BASE_HOST)
+   {
+      perror("mmap");
+      return 2;
+   }
+   memset(flash, 0xFF, FLASH_SIZE_HOST);
+
+   // erased flash is formatted and holds no record
+   Reset();
+   CHECK(STORE_HALFWORD(0, 0) == STORE_VALID);
+   Verify(-1, NULL);
+
+   // a record takes its size, an unchanged one is not written again
+   RandomRecord(3, data);
+   Write(3, data);
+   CHECK(flash_programs == 1 + STORE_RECORD_SIZE(LEARN_TEMPLATE_SIZE) / 2);
+   programs = flash_programs;
+   Write(3, data);
+   CHECK(flash_programs == programs);
+   Reset();
+   Verify(-1, NULL);
+
+   // the index is full with RECORDS addresses
+   for(i = 0; i < RECORDS; i++)
+   {
+      RandomRecord(i, data);
+      Write(i, data);
+   }
+   CHECK(STORE_Write(ADDRESS_LENGTH, data, ACTION_ENTRY_SIZE) == HAL_ERROR);
+
+   // random writes, copies into the other bank
+   for(n = 0; n < WRITES; n++)
+   {
+      i = HOST_Random() % RECORDS;
+      bank = store.bank;
+      RandomRecord(i, data);
+      Write(i, data);
+      copies += (store.bank != bank);
+      if(n % 997 == 0)
+      {
+         Reset();
+         Verify(-1, NULL);
+      }
+   }
+   Reset();
+   Verify(-1, NULL);
+
+   for(i = 0; i < (int)(FLASH_SIZE_HOST / 0x400); i++)
+   {
+      erases = (flash_erases[i] > erases) ? flash_erases[i] : erases;
+   }
+   printf("%d writes of %d templates and %d action entries: a copy per %.1f "
+          "writes, a page erased per %.1f writes\n", WRITES, LEARN_SLOTS,
+          ACTION_ENTRIES, (double)WRITES / copies, (double)WRITES / erases);
+   CHECK((double)WRITES / copies > 36.0);
+
+   // power cut at a random flash operation of a write
+   for(n = 0; n < POWER_CUTS; n++)
+   {
+      i = HOST_Random() % RECORDS;
+      RandomRecord(i, data);
+      flash_ops = 0;
+      flash_cut = 0;
+      flash_cut_at = HOST_Random() % 400;
+
+      if(STORE_Write(RECORD_ADDRESS(i), data, RECORD_LENGTH(i)) == HAL_OK && !flash_cut)
+      {
+         memcpy(model[i], data, RECORD_LENGTH(i));
+         model_used[i] = true;
+      }
+      flash_cut_at = -1;
+      if(flash_cut)
+      {
+         cuts++;
+         flash_cut = 0;
+         Reset();
+         Verify(i, data);
+      }
+   }
+   Reset();
+   Verify(-1, NULL);
+   printf("%ld power cuts, all records old or new afterwards\n", cuts);
+
+   return HOST_Result();
+}